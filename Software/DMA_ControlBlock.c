@@ -11,6 +11,7 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Channels are allocated by the DMA channel manager now.
 2018-10-09,rage	Initial version.
 */
 
@@ -26,14 +27,13 @@ Revision History:
  * It contains the configuration for all 8 DMA channels which may be used by
  * various peripheral devices, e.g. ADC, DAC, USART, LEUART, I2C, and others.
  * The entries of this array will be set by the initialization routines of the
- * driver, which was assigned to the respective channel.  Unused entries remain
- * zero.  There is a total of 16 entries in the array.  The first 8 are used
- * for the primary DMA structures, the second 8 for alternate DMA structures
- * as used for DMA scatter-gather mode, where one buffer is still available,
- * while the other can be re-configured.  This application uses only the first
- * 8 entries.
+ * driver, which allocated the respective channel via DmaChannelAlloc().
+ * Unused entries remain zero.  There is a total of 16 entries in the array.
+ * The first 8 are used for the primary DMA structures, the second 8 for
+ * alternate DMA structures as used for ping-pong and scatter-gather mode,
+ * where one buffer is still available, while the other can be re-configured.
  *
- * @see  DMA Channel Assignment
+ * @see  DmaMgr.c
  *
  * @note This array must be aligned to 256!
  */
@@ -56,9 +56,9 @@ Revision History:
  *
  * This array contains the addresses of the DMA callback functions, which are
  * executed for a dedicated DMA channel at the end of a DMA transfer.
- * The entries of this array will be set by the initialization routines of the
- * driver, which was assigned to the respective channel.  Unused entries remain
- * zero.
+ * The callback function of each allocated channel is the dispatcher of the
+ * DMA channel manager, which calls the routine of the respective driver.
+ * Unused entries remain zero.
  */
 DMA_CB_TypeDef g_DMA_Callback[DMA_CHAN_COUNT];
 
@@ -9,6 +9,13 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added ALARM_ENERGY_RESET for the daily energy budgets.
+2026-10-19,agent Added configuration for the GNSS time source, INT_PRIO_GNSS,
+		ALARM_GNSS_WAKE_UP, EM1_MOD_GNSS, and LOG_SRC_GNSS.
+2026-10-19,agent Replaced the fixed DMA channel assignment by the DMA channel
+		manager, added EM1_MOD_DMA and LOG_SRC_DMA.
+		Added LOG_SRC_COMMAND, INT_PRIO_LEUART is used now.
+2026-10-19,agent Added enumeration LOG_SRC for per-module log accounting.
 2020-05-12,rage	Use defines XXX_POWER_ALARM instead of ENUMs.
 		Power Alarms are grouped in ON and OFF alarms now.
 2016-02-26,rage	Increased LOG_BUF_SIZE to 4KB.
@@ -83,11 +90,12 @@ Revision History:
  */
 #define INT_PRIO_ADC	0		//!< ADC has highest priority
 #define INT_PRIO_UART	2		//!<  UART interrupts for the RFID reader
-#define INT_PRIO_LEUART	2		//!<  LEUART RX interrupt (not used)
-#define INT_PRIO_DMA	2		//!<  DMA is used for LEUART
+#define INT_PRIO_LEUART	2		//!<  LEUART RX for the command interpreter
+#define INT_PRIO_DMA	2		//!<  DMA channel manager, see DmaMgr.c
 #define INT_PRIO_SMB	2		//!<  SMBus used by the battery monitor
 #define INT_PRIO_RTC	3		//!<  lower priority than others
 #define INT_PRIO_EXTI	INT_PRIO_RTC	//!<  must be the same as @ref INT_PRIO_RTC
+#define INT_PRIO_GNSS	INT_PRIO_EXTI	//!<  GNSS UART, same as the PPS EXTI
 
 /*
  * Configuration for module Keys
@@ -113,6 +121,13 @@ Revision History:
 #define DCF77_INDICATOR		1
 
 
+/*
+ * Configuration for GNSS time source module "GNSS.c"
+ */
+    /*!@brief Set 1 if a GNSS receiver is connected, see GNSS.h for the pins. */
+#define GNSS_TIME_SOURCE	0
+
+
 /*
  * Configuration for module "RFID"
  */
@@ -138,17 +153,6 @@ void    drvLEUART_puts(const char *str);
 #define LOG_ALIVE_INTERVAL	0
 
 
-/*!@name DMA Channel Assignment
- *
- * The following definitions assign the 8 DMA channels to the respective
- * devices or drivers.  These defines are used as index within the global
- * DMA_DESCRIPTOR_TypeDef structure @ref g_DMA_ControlBlock.
- */
-//@{
-#define DMA_CHAN_LEUART_RX	0	//!< LEUART Rx uses DMA channel 0
-#define DMA_CHAN_LEUART_TX	1	//!< LEUART Tx uses DMA channel 1
-//@}
-
 
 /*================================== Macros ==================================*/
 
@@ -235,6 +239,7 @@ typedef struct
 typedef enum
 {
     ALARM_DCF77_WAKE_UP,    //!< Wake up DCF77 to synchronize the system clock
+    ALARM_GNSS_WAKE_UP,     //!< Wake up GNSS to synchronize the system clock
     ALARM_BATTERY_MON_1,    //!< Time #1 for logging battery status
     ALARM_BATTERY_MON_2,    //!< Time #2 for logging battery status
  // List of programmable Alarm ON Times
@@ -269,6 +274,8 @@ typedef enum
     ALARM_BATT_OFF_TIME_3,  //!< Time #3 when to switch BATT output OFF
     ALARM_BATT_OFF_TIME_4,  //!< Time #4 when to switch BATT output OFF
     ALARM_BATT_OFF_TIME_5,  //!< Time #5 when to switch BATT output OFF
+ // Programmable Alarm Times must follow in the order of the configuration
+    ALARM_ENERGY_RESET,     //!< Time to reset the daily energy budgets
     NUM_ALARM_IDS
 } ALARM_ID;
 
@@ -305,9 +312,39 @@ typedef enum
 {
     EM1_MOD_RFID,	//!<  0: The RFID Module uses the UART
     EM1_MOD_ADC,	//!<  1: ADC is a HFPER clock device
+    EM1_MOD_DMA,	//!<  2: DMA transfer with a HFPER clock device
+    EM1_MOD_GNSS,	//!<  3: The GNSS time source uses the UART
     END_EM1_MODULES
 } EM1_MODULES;
 
+
+/*!@brief Enumeration of the Log Sources
+ *
+ * This is the list of Software Modules that generate log messages.  Every
+ * module that calls Log() or LogError() must define @ref LOG_SOURCE to its
+ * entry of this list.  It is used by the Logging module to account lost log
+ * entries per source.  When adding a new entry, also extend the list of names
+ * @ref l_LogSrcName in Logging.c.
+ */
+typedef enum
+{
+    LOG_SRC_MAIN,	//!<  0: main.c
+    LOG_SRC_LOGGING,	//!<  1: Logging facility itself
+    LOG_SRC_ALARM,	//!<  2: Alarm Clock and timers
+    LOG_SRC_BATTERY,	//!<  3: Battery Monitor
+    LOG_SRC_CONFIG,	//!<  4: Configuration file CONFIG.TXT
+    LOG_SRC_CONTROL,	//!<  5: Sequence control, power outputs, and ADC
+    LOG_SRC_DCF77,	//!<  6: DCF77 Atomic Clock Decoder
+    LOG_SRC_DISPLAY,	//!<  7: Display Manager and Menus
+    LOG_SRC_POWERFAIL,	//!<  8: Power-Fail handler
+    LOG_SRC_RFID,	//!<  9: RFID reader
+    LOG_SRC_SDCARD,	//!< 10: SD-Card interface
+    LOG_SRC_DMA,	//!< 11: DMA channel manager
+    LOG_SRC_COMMAND,	//!< 12: Serial command interpreter
+    LOG_SRC_GNSS,	//!< 13: GNSS time source
+    END_LOG_SRC
+} LOG_SRC;
+
 /*======================== External Data and Routines ========================*/
 
 extern volatile bool	 g_flgIRQ;		// Flag: Interrupt occurred
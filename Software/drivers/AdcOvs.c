@@ -0,0 +1,161 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Adaptive ADC Oversampling
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module decides how long a channel of the ADC scan is averaged.  The
+ * ADC oversamples a channel in hardware by blocks of @ref ADC_OVS_BLOCK
+ * samples, the window of a channel is a sequence of such blocks.  The running
+ * sums of the block values and of their squares give the mean and the
+ * variance of the window.  A window is complete when the mean is known to
+ * @ref ADC_OVS_CFG::Bound with a confidence of 95%, but not before it
+ * has @ref ADC_OVS_CFG::MinSamples, and at the latest when it has
+ * @ref ADC_OVS_CFG::MaxSamples.  So a stable voltage is done after a few
+ * blocks, while a noisy current is averaged longer.<br>
+ * The mean is a 16bit value with the same LSB as a single block.  The sums
+ * are exact integers, so neither a division nor a square root is required
+ * in the interrupt handler.  The module has no hardware dependencies, so the
+ * host tool OvsSim replays recorded signals with it to measure the time per
+ * update.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "AdcOvs.h"
+
+/*================================ Local Data ================================*/
+
+    /*!@brief Square of the 97.5% quantile of Student's t-distribution,
+     * multiplied by 16, for 2 to @ref ADC_OVS_MAX_BLOCKS blocks.  The
+     * variance of a few blocks is only an estimate, so the confidence
+     * interval is wider than with the normal distribution.
+     */
+static const uint16_t l_T2x16[ADC_OVS_MAX_BLOCKS - 1] =
+{
+    2584, 297, 163, 124, 106,  96,  90,  86,  82,  80,
+      78,  76,  75,  74,  73,  72,  72,  71,  71,  70,
+      70,  69,  69,  69,  68,  68,  68,  68,  67,  67,
+      67
+};
+
+/*=========================== Forward Declarations ===========================*/
+
+static uint32_t	Blocks (uint32_t samples, uint32_t min);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a new Window
+ *
+ * @param[out] pWin
+ *	Oversampling window to be cleared.
+ *
+ ******************************************************************************/
+void	 AdcOvsStart (ADC_OVS_WIN *pWin)
+{
+    pWin->Blocks = 0;
+    pWin->Sum = 0;
+    pWin->SumSq = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Block to a Window
+ *
+ * This routine adds the 16bit value of a block to the window, and checks if
+ * the window is complete.  With <i>k</i> blocks, the sum <i>S</i>, and the
+ * sum of squares <i>Q</i>, the variance of the block values is
+ * (<i>kQ - S*S</i>) / (<i>k</i>(<i>k</i>-1)), and the squared standard error
+ * of the mean is this divided by <i>k</i>.  The window is complete when the
+ * squared standard error, multiplied by the squared quantile of Student's
+ * t-distribution for <i>k</i>-1 degrees of freedom, does not exceed the
+ * square of the bound.
+ *
+ * @param[in] pCfg
+ *	Limits and confidence bound.
+ *
+ * @param[in,out] pWin
+ *	Oversampling window of the channel.
+ *
+ * @param[in] value
+ *	16bit value of the block.
+ *
+ * @return
+ *	<i>true</i> if the window is complete, use AdcOvsMean() to get its
+ *	value, and AdcOvsStart() before adding the next block.
+ *
+ ******************************************************************************/
+bool	 AdcOvsAdd (const ADC_OVS_CFG *pCfg, ADC_OVS_WIN *pWin, uint32_t value)
+{
+uint32_t minBlocks, k;
+uint64_t spread, bound;
+
+
+    pWin->Blocks++;
+    pWin->Sum += value;
+    pWin->SumSq += (uint64_t)value * value;
+
+    k = pWin->Blocks;
+    minBlocks = Blocks (pCfg->MinSamples, ADC_OVS_MIN_BLOCKS);
+
+    if (k < minBlocks)
+	return false;
+
+    if (k >= Blocks (pCfg->MaxSamples, minBlocks))
+	return true;
+
+    /* k(k-1) times the variance, and k*k(k-1) times the squared bound */
+    spread = (uint64_t)k * pWin->SumSq - (uint64_t)pWin->Sum * pWin->Sum;
+    bound  = (uint64_t)pCfg->Bound * pCfg->Bound * k * k * (k - 1);
+
+    return (l_T2x16[k - 2] * spread <= 16 * bound);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Mean Value of a Window
+ *
+ * @param[in] pWin
+ *	Oversampling window.
+ *
+ * @return
+ *	Rounded mean of the block values, 0 for an empty window.
+ *
+ ******************************************************************************/
+uint32_t AdcOvsMean (const ADC_OVS_WIN *pWin)
+{
+    if (pWin->Blocks == 0)
+	return 0;
+
+    return (pWin->Sum + pWin->Blocks / 2) / pWin->Blocks;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Number of Blocks for a Number of Samples
+ *
+ * @return
+ *	<i>samples</i> in blocks, limited to <i>min</i> and
+ *	@ref ADC_OVS_MAX_BLOCKS.
+ *
+ ******************************************************************************/
+static uint32_t	Blocks (uint32_t samples, uint32_t min)
+{
+uint32_t n = samples / ADC_OVS_BLOCK;
+
+    if (n < min)
+	n = min;
+
+    if (n > ADC_OVS_MAX_BLOCKS)
+	n = ADC_OVS_MAX_BLOCKS;
+
+    return n;
+}
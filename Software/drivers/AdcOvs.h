@@ -0,0 +1,73 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module AdcOvs.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool OvsSim.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_AdcOvs_h
+#define __INC_AdcOvs_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Number of samples the ADC averages in hardware for one block,
+     * this must match the oversampling rate of the ADC scan.  The result of
+     * a block is a 16bit value, like the result of any other rate.
+     */
+#define ADC_OVS_BLOCK		256
+
+    /*!@brief Minimum number of blocks of a window, the variance requires
+     * at least two.
+     */
+#define ADC_OVS_MIN_BLOCKS	2
+
+    /*!@brief Maximum number of blocks of a window, this keeps the sums of
+     * @ref ADC_OVS_WIN within their range.
+     */
+#define ADC_OVS_MAX_BLOCKS	32
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Limits and confidence bound of the oversampling windows. */
+typedef struct
+{
+    uint32_t	MinSamples;	//!< Minimum number of samples of a window
+    uint32_t	MaxSamples;	//!< Maximum number of samples of a window
+    uint32_t	Bound;		//!< Confidence bound of the mean in [LSB] of
+				//!< the 16bit value
+} ADC_OVS_CFG;
+
+    /*!@brief Oversampling window of one channel, see AdcOvsAdd(). */
+typedef struct
+{
+    uint32_t	Blocks;		//!< Number of blocks
+    uint32_t	Sum;		//!< Sum of the block values
+    uint64_t	SumSq;		//!< Sum of the squares of the block values
+} ADC_OVS_WIN;
+
+/*================================ Prototypes ================================*/
+
+    /* Start a new oversampling window */
+void	 AdcOvsStart (ADC_OVS_WIN *pWin);
+
+    /* Add a block to a window, returns true when the window is complete */
+bool	 AdcOvsAdd   (const ADC_OVS_CFG *pCfg, ADC_OVS_WIN *pWin,
+		      uint32_t value);
+
+    /* Mean value of a window */
+uint32_t AdcOvsMean  (const ADC_OVS_WIN *pWin);
+
+
+#endif /* __INC_AdcOvs_h */
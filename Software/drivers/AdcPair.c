@@ -0,0 +1,149 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Voltage/Current Pair Sampling
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module accumulates the voltage and current samples of a power output
+ * that have been converted back to back in the same scan of the ADC.  Besides
+ * the sums of the voltage and of the current, it sums the product of each
+ * pair, so the mean of the products is the true average power.  The product
+ * of the mean voltage and the mean current differs from it by the covariance
+ * of U and I, e.g. when the voltage drops during the current pulses of a
+ * camera, an IR illuminator, or an RFID reader.<br>
+ * The samples are single 12bit conversions, the means are returned as 16bit
+ * values, like the oversampled values of AdcOvs.c, so the calibration
+ * dividers of Control.c apply to both.  The module has no hardware
+ * dependencies, so the host tool PairSim measures its accuracy against
+ * pulsed-load profiles of a signal generator model.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "AdcPair.h"
+
+
+/***************************************************************************//**
+ *
+ * @brief	Clear an Accumulator
+ *
+ * @param[out] pAcc
+ *	Accumulator of the power output.
+ *
+ ******************************************************************************/
+void	 AdcPairStart (ADC_PAIR_ACC *pAcc)
+{
+    pAcc->Count = 0;
+    pAcc->SumU = 0;
+    pAcc->SumI = 0;
+    pAcc->SumUI = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Pair of Samples
+ *
+ * This routine is called from the DMA interrupt for every scan, it must be
+ * fast.  Pairs beyond @ref ADC_PAIR_MAX_COUNT are ignored.
+ *
+ * @param[in,out] pAcc
+ *	Accumulator of the power output.
+ *
+ * @param[in] u
+ *	12bit voltage sample.
+ *
+ * @param[in] i
+ *	12bit current sample of the same scan.
+ *
+ ******************************************************************************/
+void	 AdcPairAdd (ADC_PAIR_ACC *pAcc, uint32_t u, uint32_t i)
+{
+    if (pAcc->Count >= ADC_PAIR_MAX_COUNT)
+	return;
+
+    pAcc->Count++;
+    pAcc->SumU  += u;
+    pAcc->SumI  += i;
+    pAcc->SumUI += u * i;	// 24bit product, no overflow
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Mean Voltage, Current, and Product
+ *
+ * @return
+ *	Rounded mean in [LSB] of the 16bit value, i.e. 16 times the mean of
+ *	the 12bit samples, resp. 256 times the mean of their products.  An
+ *	empty accumulator returns 0.  The scaling is done in 64 bits, because
+ *	16 times a sum of more than 65536 full-scale samples exceeds 32 bits.
+ *
+ ******************************************************************************/
+uint32_t AdcPairMeanU (const ADC_PAIR_ACC *pAcc)
+{
+    if (pAcc->Count == 0)
+	return 0;
+
+    return (uint32_t)(((uint64_t)pAcc->SumU * 16 + pAcc->Count / 2)
+		      / pAcc->Count);
+}
+
+uint32_t AdcPairMeanI (const ADC_PAIR_ACC *pAcc)
+{
+    if (pAcc->Count == 0)
+	return 0;
+
+    return (uint32_t)(((uint64_t)pAcc->SumI * 16 + pAcc->Count / 2)
+		      / pAcc->Count);
+}
+
+uint32_t AdcPairMeanUI (const ADC_PAIR_ACC *pAcc)
+{
+    if (pAcc->Count == 0)
+	return 0;
+
+    return (uint32_t)((pAcc->SumUI * 256 + pAcc->Count / 2) / pAcc->Count);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Convert a Mean Product into Power
+ *
+ * The voltage is (<i>U</i> << 16) / <i>mV_Divider</i> in [mV], and the
+ * current (<i>I</i> << 16) / <i>mA_Divider</i> in [mA], see PowerVoltage()
+ * and PowerCurrent().  So the power in [uW] is the product shifted by 32,
+ * divided by both dividers.
+ *
+ * @param[in] meanUI
+ *	Mean product of AdcPairMeanUI().
+ *
+ * @param[in] mV_Divider
+ *	Calibration divider of the voltage.
+ *
+ * @param[in] mA_Divider
+ *	Calibration divider of the current.
+ *
+ * @return
+ *	Power in [uW], 0 if a divider is 0.
+ *
+ ******************************************************************************/
+uint32_t AdcPairPower (uint32_t meanUI, uint32_t mV_Divider,
+		       uint32_t mA_Divider)
+{
+uint64_t div = (uint64_t)mV_Divider * mA_Divider;
+uint64_t uW;
+
+
+    if (div == 0)
+	return 0;
+
+    uW = ((uint64_t)meanUI << 32) / div;
+
+    return (uW > UINT32_MAX ? UINT32_MAX : (uint32_t)uW);
+}
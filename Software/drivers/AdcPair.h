@@ -0,0 +1,62 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module AdcPair.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool PairSim.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_AdcPair_h
+#define __INC_AdcPair_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Maximum number of pairs of an accumulator, this keeps the sums
+     * of the 12bit samples in @ref ADC_PAIR_ACC within 32 bits (4095 * 2^20
+     * < 2^32).  The means are scaled by 16, so AdcPairMeanU() and
+     * AdcPairMeanI() calculate in 64 bits.
+     */
+#define ADC_PAIR_MAX_COUNT	(1UL << 20)
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Accumulator of the voltage/current pairs of one power output,
+     * see AdcPairAdd().
+     */
+typedef struct
+{
+    uint32_t	Count;		//!< Number of pairs
+    uint32_t	SumU;		//!< Sum of the 12bit voltage samples
+    uint32_t	SumI;		//!< Sum of the 12bit current samples
+    uint64_t	SumUI;		//!< Sum of the products of each pair
+} ADC_PAIR_ACC;
+
+/*================================ Prototypes ================================*/
+
+    /* Clear an accumulator */
+void	 AdcPairStart (ADC_PAIR_ACC *pAcc);
+
+    /* Add a pair of samples that have been converted back to back */
+void	 AdcPairAdd   (ADC_PAIR_ACC *pAcc, uint32_t u, uint32_t i);
+
+    /* Mean values in [LSB] of the 16bit value */
+uint32_t AdcPairMeanU  (const ADC_PAIR_ACC *pAcc);
+uint32_t AdcPairMeanI  (const ADC_PAIR_ACC *pAcc);
+uint32_t AdcPairMeanUI (const ADC_PAIR_ACC *pAcc);
+
+    /* Convert a mean product into [uW] */
+uint32_t AdcPairPower (uint32_t meanUI, uint32_t mV_Divider,
+		       uint32_t mA_Divider);
+
+
+#endif /* __INC_AdcPair_h */
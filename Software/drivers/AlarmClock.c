@@ -13,6 +13,8 @@
  *   autorepeat features for keys (push buttons).
  * - Up to @ref MAX_ALARMS alarm times with callback functionality and a
  *   granularity of one minute (repeated after 24h).
+ * - The time is kept in RAM across a reset which does not power down the
+ *   MCU, e.g. a firmware update, see ClockSave() and ClockRestore().
  *
  * @note
  * The index for specifying a dedicated alarm time (i.e. the <b>alarmNum</b>
@@ -32,6 +34,16 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent The clock record resides at a fixed address at the end of the
+		RAM.  ClockRestore() adds the measured boot time, the booter time
+		and, after a firmware update, the estimated programming time with
+		milliseconds resolution.  ClockSet() logs the error of an
+		inherited clock at the next synchronization, and measures the
+		booter time with it.  Keeping the clock requires CLOCK_INHERIT.
+2026-10-19,agent Added ClockStamp(), ClockStampFromCnt(), and ClockStampGet()
+		to time stamp an event where it occurs, and log it later.
+2026-10-19,agent Keep the clock in section .noinit across a soft reset, added
+		ClockSave() and ClockRestore().
 2020-06-20,rage	CheckAlarmTimes: Also consider to switch off power outputs.
 2020-05-12,rage	Implemented CheckAlarmTimes() to call the respective alarm
 		action if the current time matches the alarm time.
@@ -61,18 +73,31 @@ Revision History:
 /*=============================== Header Files ===============================*/
 
 #include <stdio.h>
+#include <string.h>
 #include "em_device.h"
 #include "em_assert.h"
 #include "em_bitband.h"
 #include "em_int.h"
+#include "em_rmu.h"
+#include "em_cmu.h"
 #include "AlarmClock.h"
 #include "Logging.h"
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_ALARM
+
 /*!@brief Calculate maximum value to prevent overflow of a 32bit register. */
 #define MAX_VALUE_FOR_32BIT	(0xFFFFFFFFUL / RTC_COUNTS_PER_SEC)
 
+/*!@brief Signature of a valid @ref CLOCK_KEEP record. */
+#define CLOCK_KEEP_MAGIC	0x434C4B33UL	// "CLK3"
+
+/*!@brief Reset causes which do not retain the RAM content. */
+#define RSTCAUSE_POWER_ON	(RMU_RSTCAUSE_PORST | RMU_RSTCAUSE_BODUNREGRST \
+				 | RMU_RSTCAUSE_BODREGRST)
+
 /*=========================== Typedefs and Structs ===========================*/
 
 /*!@brief Alarm entry.
@@ -98,8 +123,40 @@ typedef struct
     TIMER_FCT Function;		//!< Function to be called when timer expires
 } SEC_TIMER;
 
+/*!@brief Clock record to be kept across a reset.
+ *
+ * This record is located in section <b>.noinit</b>, which is not cleared by
+ * the startup code.  The linker script places it into the last 32 bytes of
+ * the RAM, so its address does not change with a firmware update, and the
+ * booter must not use this range.  It is written by ClockSave() and checked
+ * by ClockRestore().  The complement of all other elements is stored in
+ * <b>Check</b>, so a record with random content after power-on, or one
+ * that has been overwritten by the booter, is detected.
+ */
+typedef struct
+{
+    uint32_t	Magic;		//!< Signature @ref CLOCK_KEEP_MAGIC
+    time_t	Time;		//!< UNIX time of the last save
+    uint32_t	MilliSec;	//!< Milliseconds portion of the last save
+    uint32_t	isdst;		//!< Copy of @ref g_isdst
+    uint32_t	FwId;		//!< Identifier of the firmware that saved it
+    uint32_t	BootDelay;	//!< Measured booter time in [ms]
+    uint32_t	Check;		//!< Complement of the other elements
+} CLOCK_KEEP;
+
 /*================================ Global Data ===============================*/
 
+extern PRJ_INFO const  prj;		// Project Information
+
+/*!@brief Start of the application image, defined by the linker script. */
+extern char __image_start__[];
+
+/*!@brief End of the code and read-only data, defined by the linker script. */
+extern char __etext[];
+
+/*!@brief Start and end of the initialized data, defined by the linker script. */
+extern char __data_start__[], __data_end__[];
+
 /*!@brief Current date and time structure. */
 struct tm	 g_CurrDateTime;
 
@@ -134,6 +191,33 @@ static void  (*l_msTimerFunction) (void);
 /*!@brief Function to call for a display update. */
 static void  (*l_DisplayUpdateFct) (void);
 
+#if CLOCK_INHERIT
+/*!@brief Clock record, not initialized by the startup code. */
+static volatile CLOCK_KEEP l_ClockKeep __attribute__((section(".noinit")));
+#endif
+
+/* UNIX time of @ref g_CurrDateTime, i.e. of the last COMP0 interrupt */
+static volatile time_t l_CurrTime;
+
+/*!@brief Measured time in [ms] from main() until ClockRestore(). */
+static uint32_t	l_BootTime;
+
+/*!@brief Flag that the clock has been inherited and not synchronized yet. */
+static bool	l_flgInherited;
+
+/*!@brief Booter time in [ms], see @ref CLOCK_BOOT_DELAY. */
+static uint32_t	l_BootDelay = CLOCK_BOOT_DELAY;
+
+/*!@brief Time of ClockRestore() if the next synchronization may measure the
+ * booter time, otherwise 0. */
+static time_t	l_InheritTime;
+
+/*=========================== Forward Declarations ===========================*/
+
+#if CLOCK_INHERIT
+static uint32_t	fwIdGet (void);
+#endif
+
 
 /***************************************************************************//**
  *
@@ -238,6 +322,9 @@ int		i;			// index variable
 	 */
 	ClockUpdate (true);
 
+	/* keep the current time in case of a reset */
+	ClockSave();
+
 	/* compare all alarm times for every minute */
 	if (processed_min != g_CurrDateTime.tm_min)
 	{
@@ -947,6 +1034,7 @@ time_t	now;
     {
 	now = time (NULL);
 	g_CurrDateTime = *localtime(&now);
+	l_CurrTime = now;
     }
 
     /* Also update display, if a function has been defined for that purpose */
@@ -1041,6 +1129,9 @@ void	ClockSet (struct tm *pNewTimeDate, bool sync)
 time_t    newRtcStartTime;
 uint32_t  rtcIEN;	// save state of the RTC Interrupt Enable register
 uint32_t  rtcCNT;	// save state of the RTC Interrupt Enable register
+time_t    oldTime;	// time of the clock before it is set
+int32_t   deviation;	// error of an inherited clock in [ms]
+int32_t   delay;	// booter time resulting from the deviation in [ms]
 
 
     EFM_ASSERT (pNewTimeDate != NULL);
@@ -1066,6 +1157,35 @@ uint32_t  rtcCNT;	// save state of the RTC Interrupt Enable register
 	CheckAlarmTimes();
     }
 
+    /* Report the error of a clock inherited after a reset, see ClockRestore() */
+    if (l_flgInherited  &&  sync)
+    {
+	l_flgInherited = false;
+
+	/* read the seconds and the counter within the same second */
+	do
+	{
+	    rtcCNT  = RTC->CNT;
+	    oldTime = time (NULL);
+	} while (rtcCNT / RTC_COUNTS_PER_SEC != RTC->CNT / RTC_COUNTS_PER_SEC);
+
+	deviation = (int32_t)(oldTime - newRtcStartTime) * 1000
+		  + (int32_t)((rtcCNT % RTC_COUNTS_PER_SEC) * 1000
+			      / RTC_COUNTS_PER_SEC);
+
+	/* after a software reset without update, it is the booter time error */
+	delay = (int32_t)l_BootDelay - deviation;
+	if (l_InheritTime != 0
+	&&  newRtcStartTime - l_InheritTime < CLOCK_CALIB_MAX_AGE
+	&&  delay >= 0  &&  delay <= CLOCK_BOOT_DELAY_MAX)
+	    l_BootDelay = (uint32_t)delay;
+	l_InheritTime = 0;
+#ifdef LOGGING
+	Log ("Inherited clock deviated by %+ldms, booter time %ldms",
+	     deviation, l_BootDelay);
+#endif
+    }
+
     /* Be sure to disable RTC interrupts while manipulating registers */
     rtcIEN = RTC->IEN;
     RTC->IEN = 0;		// disable all RTC interrupts
@@ -1092,6 +1212,7 @@ uint32_t  rtcCNT;	// save state of the RTC Interrupt Enable register
     /* Set new start time and reset overflow counter */
     clockSetStartTime (newRtcStartTime);
     clockSetOverflowCounter (0);
+    l_CurrTime = newRtcStartTime;
 
     /* Start the clock */
     RTC_Enable (true);
@@ -1099,3 +1220,374 @@ uint32_t  rtcCNT;	// save state of the RTC Interrupt Enable register
     /* Finally restore the original state of the IEN register */
     RTC->IEN = rtcIEN;
 }
+
+/***************************************************************************//**
+ *
+ * @brief	Time Stamp an Event
+ *
+ * This routine captures the current time with milliseconds, like
+ * ClockGetMilliSec(), but as UNIX time, so it fits into a small @ref
+ * CLOCK_STAMP.  It may be called from interrupt routines, where an event
+ * is detected, to log the event later from the main loop with its real
+ * time, see LogMessage().
+ *
+ * @param[out] pStamp
+ *	Time stamp of the event.  Its time is 0 as long as the clock has not
+ *	been set.
+ *
+ ******************************************************************************/
+void	ClockStamp (CLOCK_STAMP *pStamp)
+{
+    ClockStampFromCnt (pStamp, RTC->CNT);
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Time Stamp an Event from an RTC Count
+ *
+ * This routine converts an RTC count that has been read when an event
+ * occurred, e.g. the <b>timeStamp</b> of an EXTI handler or the value of
+ * msDelayStart(), into a @ref CLOCK_STAMP.  Interrupt routines that run
+ * very often only need to read <b>RTC->CNT</b> this way.
+ *
+ * @param[out] pStamp
+ *	Time stamp of the event.
+ *
+ * @param[in] rtcCnt
+ *	RTC count of the event.  It must be less than 512s old, i.e. one turn
+ *	of the 24bit counter, and the clock must not have been set since.
+ *
+ ******************************************************************************/
+void	ClockStampFromCnt (CLOCK_STAMP *pStamp, uint32_t rtcCnt)
+{
+uint32_t	currSubSec;	// RTC counts since the start of the second
+uint32_t	age;		// RTC counts since the event
+uint32_t	sec;		// seconds to go back
+time_t		now;
+
+    EFM_ASSERT (pStamp != NULL);
+
+    INT_Disable();
+
+    if (g_CurrDateTime.tm_year == 0)
+    {
+	pStamp->Time = 0;		// clock has not been set
+	pStamp->MilliSec = 0;
+	INT_Enable();
+	return;
+    }
+
+    now = l_CurrTime;
+    age = (RTC->CNT - rtcCnt) & 0xFFFFFF;
+    currSubSec = (RTC->CNT - RTC->COMP0) % RTC_COUNTS_PER_SEC;
+
+    /* A pending COMP0 interrupt means the next second has already begun */
+    if (RTC->IF & RTC_IF_COMP0)
+	now++;
+
+    INT_Enable();
+
+    if (age <= currSubSec)
+    {
+	currSubSec -= age;		// in the same second
+    }
+    else
+    {
+	age -= currSubSec;
+	sec = (age + RTC_COUNTS_PER_SEC - 1) / RTC_COUNTS_PER_SEC;
+	now -= sec;
+	currSubSec = sec * RTC_COUNTS_PER_SEC - age;
+    }
+
+    pStamp->Time = now;
+    pStamp->MilliSec = currSubSec * 1000 / RTC_COUNTS_PER_SEC;
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Get the Date and Time of a Time Stamp
+ *
+ * This routine converts a @ref CLOCK_STAMP into a <i>tm</i> structure and
+ * milliseconds, like ClockGetMilliSec() delivers them.  It calculates the
+ * date itself instead of calling localtime(), because this is not reentrant
+ * and is used by the RTC interrupt routine.  The result is the same, since
+ * no time zone is set, see ClockUpdate().
+ *
+ * @param[in] pStamp
+ *	Time stamp to convert.
+ *
+ * @param[out] pTimeDateVar
+ *	Pointer to a variable where to store the date and time.  All elements
+ *	are 0 if the clock had not been set.
+ *
+ * @param[out] pMsVar
+ *	Pointer to a variable where to store the milliseconds part.
+ *
+ ******************************************************************************/
+void	ClockStampGet (const CLOCK_STAMP *pStamp, struct tm *pTimeDateVar,
+		       unsigned int *pMsVar)
+{
+int32_t	days, secs;		// days since 1970, seconds of the day
+int32_t	era, doe, yoe, doy, mp;	// see "civil_from_days()" by H. Hinnant
+
+    EFM_ASSERT (pStamp != NULL  &&  pTimeDateVar != NULL  &&  pMsVar != NULL);
+
+    memset (pTimeDateVar, 0, sizeof(*pTimeDateVar));
+    *pMsVar = pStamp->MilliSec;
+    if (pStamp->Time == 0)
+	return;
+
+    /* The time may be negative with the Year 2038 workaround */
+    days = (int32_t)(pStamp->Time / 86400);
+    secs = (int32_t)(pStamp->Time % 86400);
+    if (secs < 0)
+    {
+	secs += 86400;
+	days--;
+    }
+    pTimeDateVar->tm_hour = secs / 3600;
+    pTimeDateVar->tm_min  = (secs / 60) % 60;
+    pTimeDateVar->tm_sec  = secs % 60;
+    pTimeDateVar->tm_wday = ((days % 7) + 11) % 7;	// 1970-01-01 was Thursday
+
+    /* Years start on March 1st, so the leap day is the last one */
+    days += 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp  = (5 * doy + 2) / 153;
+
+    pTimeDateVar->tm_mday = doy - (153 * mp + 2) / 5 + 1;
+    pTimeDateVar->tm_mon  = (mp < 10 ? mp + 2 : mp - 10);
+    pTimeDateVar->tm_year = yoe + era * 400 + (mp >= 10) - 1900;
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Save System Clock for a Reset
+ *
+ * This routine stores the current time into a record in section
+ * <b>.noinit</b>, which survives a reset that does not power down the MCU.
+ * It is called every second from the RTC interrupt handler, and should be
+ * called immediately before a software reset, so the milliseconds portion
+ * is up to date, too.  As long as the clock has not been set, the record is
+ * marked invalid.  The routine does nothing unless @ref CLOCK_INHERIT is 1.
+ *
+ * @see ClockRestore().
+ *
+ ******************************************************************************/
+void	ClockSave (void)
+{
+#if CLOCK_INHERIT
+uint32_t	currSubSec;
+time_t		now;
+
+    INT_Disable();
+
+    if (g_PowerUpTime == 0)
+    {
+	l_ClockKeep.Magic = 0;		// no valid time to keep
+	INT_Enable();
+	return;
+    }
+
+    /* Like ClockGetMilliSec(), a pending COMP0 interrupt means 999ms */
+    currSubSec = (RTC->CNT - RTC->COMP0) % RTC_COUNTS_PER_SEC;
+    now = time (NULL);
+
+    l_ClockKeep.Magic	 = CLOCK_KEEP_MAGIC;
+    l_ClockKeep.Time	 = now;
+    l_ClockKeep.MilliSec = (RTC->IF & RTC_IF_COMP0 ? 999
+			    : currSubSec * 1000 / RTC_COUNTS_PER_SEC);
+    l_ClockKeep.isdst	 = g_isdst;
+    l_ClockKeep.FwId	 = fwIdGet();
+    l_ClockKeep.BootDelay = l_BootDelay;
+    l_ClockKeep.Check	 = ~(l_ClockKeep.Magic ^ (uint32_t)l_ClockKeep.Time
+			     ^ l_ClockKeep.MilliSec ^ l_ClockKeep.isdst
+			     ^ l_ClockKeep.FwId ^ l_ClockKeep.BootDelay);
+
+    INT_Enable();
+#endif
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Restore System Clock after a Reset
+ *
+ * This routine must be called once after AlarmClockInit().  It reads and
+ * clears the reset cause of the MCU.  If this was not a power-on or
+ * brown-out reset, and the record written by ClockSave() is valid, the
+ * System Clock is set to the saved time plus the elapsed time, during which
+ * the RTC did not run.  This consists of:
+ * - the milliseconds portion at the time of the save,
+ * - the booter time, measured by a previous software reset, or
+ *   @ref CLOCK_BOOT_DELAY,
+ * - if the firmware has been changed, the estimated time to read and program
+ *   the new image, see @ref CLOCK_PAGE_ERASE_TIME, @ref CLOCK_WORD_WRITE_TIME,
+ *   and @ref CLOCK_UPDATE_READ_RATE,
+ * - the measured time from main() until here, see ClockBootTimeStart().
+ *
+ * The routine waits for the remaining milliseconds up to the next full
+ * second, because the RTC restarts with the beginning of a second.
+ *
+ * The restored time is not synchronized, i.e. the time sources still
+ * perform their regular synchronization, and ClockSet() logs the error of
+ * the inherited clock then.  Because @ref g_PowerUpTime is set, the alarm
+ * times are valid immediately, and CheckAlarmTimes() switches the power
+ * outputs after the configuration has been read.
+ *
+ * After a software reset without firmware update, the record has been saved
+ * immediately before the reset, see Reboot() in main.c.  The deviation at
+ * the next synchronization is then the error of the booter time, and
+ * ClockSet() corrects it for the following resets.
+ *
+ * If @ref CLOCK_INHERIT is 0, the clock is never inherited.
+ *
+ * @return
+ *	Returns true if the clock has been inherited from before the reset.
+ *
+ ******************************************************************************/
+bool	ClockRestore (void)
+{
+#if ! CLOCK_INHERIT
+    return false;
+#else
+uint32_t	cause;
+uint32_t	elapsed;	// elapsed time in [ms]
+uint32_t	update = 0;	// time of a firmware update in [ms]
+uint32_t	wait;		// time to the next full second in [ms]
+uint32_t	size, pages;	// size of the firmware image
+time_t		t;
+struct tm	newTime;
+
+    /* boot time until now */
+    ClockBootTimeLap();
+
+    /* get reset cause, then clear the flags for the next reset */
+    cause = RMU_ResetCauseGet();
+    RMU_ResetCauseClear();
+
+    if (cause & RSTCAUSE_POWER_ON)
+    {
+	l_ClockKeep.Magic = 0;		// RAM content is random
+	return false;
+    }
+
+    if (l_ClockKeep.Magic != CLOCK_KEEP_MAGIC
+    ||  l_ClockKeep.Check != ~(l_ClockKeep.Magic ^ (uint32_t)l_ClockKeep.Time
+			       ^ l_ClockKeep.MilliSec ^ l_ClockKeep.isdst
+			       ^ l_ClockKeep.FwId ^ l_ClockKeep.BootDelay))
+    {
+#ifdef LOGGING
+	Log ("No valid clock to inherit after reset (cause 0x%02lX)", cause);
+#endif
+	return false;
+    }
+
+    /* the booter has programmed a new image, estimate the time for this */
+    if (l_ClockKeep.FwId != fwIdGet())
+    {
+	size  = (uint32_t)(__etext - __image_start__)
+	      + (uint32_t)(__data_end__ - __data_start__);
+	pages = (size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+	update = size / CLOCK_UPDATE_READ_RATE
+	       + (pages * CLOCK_PAGE_ERASE_TIME
+		  + pages * (FLASH_PAGE_SIZE / 4) * CLOCK_WORD_WRITE_TIME) / 1000;
+    }
+
+    /* booter time measured before, see ClockSet() */
+    if (l_ClockKeep.BootDelay <= CLOCK_BOOT_DELAY_MAX)
+	l_BootDelay = l_ClockKeep.BootDelay;
+
+    /* add the elapsed time */
+    elapsed = l_ClockKeep.MilliSec + l_BootDelay + update + l_BootTime;
+
+    /* wait for the next full second, the RTC starts at its beginning */
+    wait = (1000 - elapsed % 1000) % 1000;
+    msDelay (wait);
+    t = l_ClockKeep.Time + (time_t)((elapsed + wait) / 1000);
+
+    /* this is not an initial time synchronization, see ClockSet() */
+    g_PowerUpTime = t;
+    g_isdst = (l_ClockKeep.isdst != 0);
+    newTime = *localtime(&t);
+    ClockSet (&newTime, true);
+    ClockUpdate (true);
+    l_flgInherited = true;
+
+    /* the next synchronization measures the booter time, see ClockSet() */
+    l_InheritTime = ((cause & RMU_RSTCAUSE_SYSREQRST)  &&  update == 0
+		     ? t : 0);
+
+#ifdef LOGGING
+    Log ("Clock inherited after reset (cause 0x%02lX): %02d:%02d:%02d (%s),"
+	 " %ldms elapsed (%ldms measured, %ldms booter, %ldms update)", cause,
+	 g_CurrDateTime.tm_hour, g_CurrDateTime.tm_min, g_CurrDateTime.tm_sec,
+	 g_isdst ? "MESZ" : "MEZ", elapsed, l_BootTime, l_BootDelay, update);
+#endif
+
+    return true;
+#endif
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Start the Boot Time Measurement
+ *
+ * This routine must be called at the beginning of main().  The RTC is reset
+ * by every reset and starts with AlarmClockInit(), so the boot time until
+ * ClockRestore() is measured with the cycle counter of the core instead.
+ *
+ * @see ClockBootTimeLap().
+ *
+ ******************************************************************************/
+void	ClockBootTimeStart (void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    l_BootTime = 0;
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Account the Boot Time
+ *
+ * This routine adds the cycles counted since the previous call to the boot
+ * time, converted with the current core frequency.  It must be called
+ * before the core clock is switched to another oscillator, see cmuSetup(),
+ * and is called by ClockRestore().
+ *
+ ******************************************************************************/
+void	ClockBootTimeLap (void)
+{
+uint32_t	cycles = DWT->CYCCNT;
+
+    DWT->CYCCNT = 0;
+    l_BootTime += cycles / (CMU_ClockFreqGet(cmuClock_CORE) / 1000);
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Identifier of the Firmware
+ *
+ * This routine returns a hash of the build date and time of the firmware,
+ * so ClockRestore() can detect a firmware update by the booter.
+ *
+ ******************************************************************************/
+#if CLOCK_INHERIT
+static uint32_t	fwIdGet (void)
+{
+const char	*pStr;
+uint32_t	 id = 2166136261UL;	// FNV-1a offset basis
+
+    for (pStr = prj.Date;  *pStr != EOS;  pStr++)
+	id = (id ^ (uint8_t)*pStr) * 16777619UL;
+
+    for (pStr = prj.Time;  *pStr != EOS;  pStr++)
+	id = (id ^ (uint8_t)*pStr) * 16777619UL;
+
+    return id;
+}
+#endif
@@ -5,6 +5,14 @@
  * @version	2020-05-12
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added ClockBootTimeStart(), ClockBootTimeLap(), and the flash
+		timings CLOCK_PAGE_ERASE_TIME, CLOCK_WORD_WRITE_TIME, and
+		CLOCK_UPDATE_READ_RATE.  CLOCK_BOOT_DELAY covers the booter only
+		and is the initial value of the measured booter time.  Added
+		CLOCK_INHERIT, CLOCK_CALIB_MAX_AGE, and CLOCK_BOOT_DELAY_MAX.
+2026-10-19,agent Added CLOCK_STAMP, ClockStamp(), ClockStampFromCnt(), and
+		ClockStampGet().
+2026-10-19,agent Added ClockSave(), ClockRestore(), and CLOCK_BOOT_DELAY.
 2020-05-12,rage	Added prototypes for CheckAlarmTimes() and ExecuteAlarmAction().
 2018-10-09,rage	Reduced size of type TIM_HDL from 4 to 1 byte to save memory.
 2018-03-24,rage	Increased MAX_SEC_TIMERS from 10 to 16..
@@ -47,6 +55,57 @@ Revision History:
     #define RTC_COUNTS_PER_SEC	32768
 #endif
 
+#ifndef CLOCK_INHERIT
+    /*!@brief Keep the clock across a reset that does not power down the MCU,
+     * see ClockSave() and ClockRestore().  This requires a booter which does
+     * not use the last 32 bytes of the RAM, see efm32g_0x8000.ld.  The booter
+     * is not part of this project, and the released one uses the whole RAM,
+     * so the feature is incomplete and disabled by default.
+     */
+    #define CLOCK_INHERIT	0
+#endif
+
+#ifndef CLOCK_BOOT_DELAY
+    /*!@brief Initial value in [ms] of the time the booter needs from a reset
+     * until it starts the application, when there is no firmware update.
+     * The RTC is reset by every reset of the EFM32G, so the application
+     * cannot count this time.  Instead, the booter time is measured by the
+     * first synchronization after a software reset, see ClockSet(), and kept
+     * in the clock record for the following resets.
+     */
+    #define CLOCK_BOOT_DELAY	1500
+#endif
+
+#ifndef CLOCK_CALIB_MAX_AGE
+    /*!@brief Maximum time in [s] from ClockRestore() until the synchronization
+     * that measures the booter time.  The 32kHz crystal may drift by 20ppm,
+     * i.e. 18ms in 900s.
+     */
+    #define CLOCK_CALIB_MAX_AGE	900
+#endif
+
+#ifndef CLOCK_BOOT_DELAY_MAX
+    /*!@brief Plausible maximum of a measured booter time in [ms]. */
+    #define CLOCK_BOOT_DELAY_MAX	10000
+#endif
+
+#ifndef CLOCK_PAGE_ERASE_TIME
+    /*!@brief FLASH page erase time in [us] of the EFM32G, see data sheet.
+     * Used to estimate the time the booter needs for a firmware update.
+     */
+    #define CLOCK_PAGE_ERASE_TIME	20000
+#endif
+
+#ifndef CLOCK_WORD_WRITE_TIME
+    /*!@brief FLASH word write time in [us] of the EFM32G, see data sheet. */
+    #define CLOCK_WORD_WRITE_TIME	20
+#endif
+
+#ifndef CLOCK_UPDATE_READ_RATE
+    /*!@brief Rate in [KB/s] the booter reads an update image from SD-Card. */
+    #define CLOCK_UPDATE_READ_RATE	250
+#endif
+
     /*!@brief Macro to convert milliseconds to RTC tics. */
 #define MS2TICS(ms)	((ms) * RTC_COUNTS_PER_SEC / 1000)
 
@@ -101,6 +160,14 @@ typedef struct
     int8_t	Minute;		//!< Alarm time: Minute
 } ALARM_TIME;
 
+/*!@brief Time of an event, captured where the event occurs, see ClockStamp().
+ */
+typedef struct
+{
+    time_t	Time;		//!< UNIX time, 0 if the clock has not been set
+    uint16_t	MilliSec;	//!< Milliseconds portion
+} CLOCK_STAMP;
+
 /*================================ Global Data ===============================*/
 
 extern struct tm  	g_CurrDateTime;	//!< Current date and time structure
@@ -144,5 +211,17 @@ void	ClockGet (struct tm *pTimeDateVar);
 void	ClockGetMilliSec (struct tm *pTimeDateVar, unsigned int *pMsVar);
 void	ClockSet (struct tm *pNewTimeDate, bool sync);
 
+    /* Time stamps of events, see LogMessage() */
+void	ClockStamp (CLOCK_STAMP *pStamp);
+void	ClockStampFromCnt (CLOCK_STAMP *pStamp, uint32_t rtcCnt);
+void	ClockStampGet (const CLOCK_STAMP *pStamp, struct tm *pTimeDateVar,
+		       unsigned int *pMsVar);
+
+    /* Keep the System Clock across a reset */
+void	ClockBootTimeStart (void);
+void	ClockBootTimeLap (void);
+void	ClockSave (void);
+bool	ClockRestore (void);
+
 
 #endif /* __INC_AlarmClock_h */
@@ -0,0 +1,141 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Change-only Battery Logging
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module decides which dynamic values of a battery report are logged.
+ * A value is logged only when it has moved by its minimum change since it
+ * was logged the last time, see @ref BAT_LOG_CFG.  The change of the runtime
+ * to empty is relative, because it varies with the load.  Because small
+ * changes add up, the comparison is always made with the logged value, not
+ * with the previous reading.
+ *
+ * Every @ref BAT_LOG_CFG::KeyFrame hours, and after BatLogReset(), all
+ * values are logged as a key frame.  A host tool reconstructs the battery
+ * state at any time from the last key frame and the values logged since.
+ * The module has no hardware dependencies, so the host tool BatDelta replays
+ * recorded battery reports with it to compare the log volume.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stddef.h>
+#include "BatLog.h"
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	ValueMoved (const BAT_LOG_CFG *pCfg, int n, int32_t logged,
+			    int32_t value);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Request a Key Frame
+ *
+ * This routine lets the next call of BatLogSelect() log all values, e.g.
+ * after the battery pack has been changed.
+ *
+ * @param[out] pState
+ *	Values of the last log.
+ *
+ ******************************************************************************/
+void	 BatLogReset (BAT_LOG_STATE *pState)
+{
+    pState->flgValid = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Select the Values to Log
+ *
+ * This routine returns the values of a battery report that have to be
+ * logged, and records them as the last logged values.  All available values
+ * are selected for a key frame.
+ *
+ * @param[in] pCfg
+ *	Minimum changes and key frame interval.
+ *
+ * @param[in,out] pState
+ *	Values of the last log.
+ *
+ * @param[in] pValue
+ *	Array of the current values, see @ref BAT_VAL.  A value that could not
+ *	be read is @ref BAT_LOG_NO_VALUE, it is never selected.
+ *
+ * @param[in] now
+ *	Current time in [s].
+ *
+ * @return
+ *	Bit mask of the values to log, bit <i>n</i> stands for @ref BAT_VAL
+ *	<i>n</i>.
+ *
+ ******************************************************************************/
+uint32_t BatLogSelect (const BAT_LOG_CFG *pCfg, BAT_LOG_STATE *pState,
+		       const int32_t *pValue, uint32_t now)
+{
+uint32_t mask = 0;
+bool	 flgKeyFrame;
+int	 n;
+
+
+    /* Key frame if due, or the clock has been set back */
+    flgKeyFrame = (! pState->flgValid  ||  (int32_t)(now - pState->KeyTime) < 0
+		   ||  now - pState->KeyTime >= pCfg->KeyFrame * 3600);
+    if (flgKeyFrame)
+    {
+	pState->flgValid = true;
+	pState->KeyTime = now;
+    }
+
+    for (n = 0;  n < END_BAT_VAL;  n++)
+    {
+	if (pValue[n] == BAT_LOG_NO_VALUE)
+	    continue;
+
+	if (flgKeyFrame  ||  pState->Value[n] == BAT_LOG_NO_VALUE
+	||  ValueMoved (pCfg, n, pState->Value[n], pValue[n]))
+	{
+	    mask |= (1 << n);
+	    pState->Value[n] = pValue[n];
+	}
+    }
+
+    return mask;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Value has Moved
+ *
+ * @return
+ *	<i>true</i> if value <i>n</i> differs from the logged value by at
+ *	least its minimum change.
+ *
+ ******************************************************************************/
+static bool	ValueMoved (const BAT_LOG_CFG *pCfg, int n, int32_t logged,
+			    int32_t value)
+{
+uint32_t diff;
+
+
+    diff = (uint32_t)(value > logged ? value - logged : logged - value);
+
+    if (n == BAT_VAL_RUNTIME)
+    {
+	/* "> 45 days" is a state of its own */
+	if ((logged == BAT_LOG_RUNTIME_INFINITE)
+	!=  (value  == BAT_LOG_RUNTIME_INFINITE))
+	    return true;
+
+	return (diff * 100 >= pCfg->Diff[n] * (uint32_t)logged);
+    }
+
+    return (diff >= pCfg->Diff[n]);
+}
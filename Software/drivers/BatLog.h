@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module BatLog.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool BatDelta.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_BatLog_h
+#define __INC_BatLog_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Value could not be read from the battery controller. */
+#define BAT_LOG_NO_VALUE	INT32_MIN
+
+    /*!@brief Runtime to empty if the battery is not discharged, this is
+     * logged as "> 45 days".
+     */
+#define BAT_LOG_RUNTIME_INFINITE 65535
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Dynamic values of a battery report, in the order of the log. */
+typedef enum
+{
+    BAT_VAL_CAPACITY,	//!< Remaining capacity in [mAh]
+    BAT_VAL_RUNTIME,	//!< Runtime to empty in [min]
+    BAT_VAL_VOLTAGE,	//!< Actual voltage in [mV]
+    BAT_VAL_CURRENT,	//!< Actual current in [mA]
+    END_BAT_VAL
+} BAT_VAL;
+
+    /*!@brief Bit mask of all values, see BatLogSelect(). */
+#define BAT_VAL_ALL	((1 << END_BAT_VAL) - 1)
+
+    /*!@brief Minimum changes to log a value, and the key frame interval. */
+typedef struct
+{
+    uint32_t	Diff[END_BAT_VAL];	//!< [mAh], [%] of the runtime, [mV],
+					//!< [mA], 0 logs every report
+    uint32_t	KeyFrame;		//!< Key frame interval in [h]
+} BAT_LOG_CFG;
+
+    /*!@brief Values of the last log, see BatLogSelect(). */
+typedef struct
+{
+    bool	flgValid;		//!< A key frame has been logged
+    int32_t	Value[END_BAT_VAL];	//!< Last logged values
+    uint32_t	KeyTime;		//!< Time of the last key frame [s]
+} BAT_LOG_STATE;
+
+/*================================ Prototypes ================================*/
+
+    /* Let the next report be a key frame */
+void	 BatLogReset  (BAT_LOG_STATE *pState);
+
+    /* Select the values of a report that have to be logged */
+uint32_t BatLogSelect (const BAT_LOG_CFG *pCfg, BAT_LOG_STATE *pState,
+		       const int32_t *pValue, uint32_t now);
+
+
+#endif /* __INC_BatLog_h */
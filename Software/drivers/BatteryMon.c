@@ -8,6 +8,13 @@
  * via its SMBus interface.  It also provides routines to access the registers
  * of the battery controller manually.
  *
+ * The periodic battery reports are logged change-only, see BatLog.c: the
+ * identity of the battery pack (serial number, design capacity) is logged
+ * only when another pack has been detected, and the dynamic values only when
+ * they have moved by a configurable minimum change.  A key frame with all
+ * values is logged every BATTERY_LOG_KEYFRAME hours, and when a new log file
+ * has been opened.
+ *
  * @warning
  * The firmware on the battery controller (ATmega32HVB) is quite buggy!
  * When accessing a non-implemented register (e.g. 0x1D), the correct
@@ -23,6 +30,11 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent The dynamic battery values are logged with the time they
+		have been read, see LogAt().
+2026-10-19,agent Periodic reports use BAT_LOG_INFO_CHANGES: identity is logged
+		only for another battery pack, dynamic values only when they
+		have changed, see BatteryLogConfig().  Added DurationString().
 2020-06-18,rage LogBatteryInfo: Removed SBS_ManufacturerData.
 		Disabled workaround for probing prototype battery packs.
 2020-01-22,rage	Added support for battery controller TI bq40z50.
@@ -46,6 +58,7 @@ Revision History:
 /*=============================== Header Files ===============================*/
 
 #include <string.h>
+#include <time.h>
 #include "em_cmu.h"
 #include "em_i2c.h"
 #include "em_emu.h"
@@ -58,6 +71,9 @@ Revision History:
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_BATTERY
+
     /*!@name Hardware Configuration: SMBus controller and pins. */
 //@{
 #define SMB_GPIOPORT		gpioPortA	//!< Port SMBus interface
@@ -84,6 +100,15 @@ typedef struct
     const char	*name;		//!< ASCII name of the controller
 } BC_INFO;
 
+    /*!@brief Identity of a battery pack, see LogBatteryInfo(). */
+typedef struct
+{
+    bool	 flgValid;	//!< Identity has been read
+    BC_TYPE	 CtrlType;	//!< Type of the battery controller
+    uint32_t	 SerialNumber;	//!< Serial number
+    uint32_t	 DesignCapacity;//!< Design capacity in [mAh]
+} BAT_ID;
+
     /*!@brief Format identifiers.
      *
      * These enumerations specify various data formats.  They are used as an
@@ -171,12 +196,23 @@ static TIM_HDL	l_thBatMon = NONE;
     /* Battery Info structure - may hold up to two info requests */
 static BAT_INFO  l_BatInfo;
 
+    /*!@brief Identity of the battery pack that has been logged last. */
+static BAT_ID	 l_BatId;
+
+    /*!@brief Minimum changes and key frame interval of the battery log.
+     * Until BatteryLogConfig() is called, every report is a key frame. */
+static BAT_LOG_CFG   l_BatLogCfg;
+
+    /*!@brief Values of the last battery log. */
+static BAT_LOG_STATE l_BatLogState;
+
 /*=========================== Forward Declarations ===========================*/
 
 #if BAT_MON_INTERVAL > 0
 static void	BatMonTrigger(TIM_HDL hdl);
 #endif
 static void	BatMonTriggerAlarm(int alarmNum);
+static void	DurationString (char *pBuf, int minutes);
 
 
 /***************************************************************************//**
@@ -573,7 +609,7 @@ static char	 strBuf[120];	// static buffer to return string into
 uint8_t		 dataBuf[40];	// buffer for I2C data, read from the controller
 uint32_t	 value;		// unsigned data variable
 int		 data = 0;	// generic signed integer data variable
-int		 d, h, m;	// FRMT_DURATION: days, hours, minutes
+int		 d;		// FRMT_HEXDUMP: byte index
 
 
     /* Prepare check for string buffer overflow */
@@ -659,19 +695,7 @@ int		 d, h, m;	// FRMT_DURATION: days, hours, minutes
 	    break;
 
 	case FRMT_DURATION:	// Duration in [min]
-	    if (data > 65534)		// > 45d
-	    {
-		strcpy (strBuf, "> 45 days");
-	    }
-	    else
-	    {
-		d = data / 60 / 24;
-		data -= (d * 60 * 24);
-		h = data / 60;
-		data -= (h * 60);
-		m = data;
-		sprintf (strBuf, "%2dd %2dh %2dm", d, h, m);
-	    }
+	    DurationString (strBuf, data);
 	    break;
 
 	case FRMT_OC_REATIME:	// Overcurrent Reaction Time in 1/2[ms] units
@@ -732,6 +756,41 @@ int		 d, h, m;	// FRMT_DURATION: days, hours, minutes
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Format a Duration
+ *
+ * This routine converts a duration in [min] into a string of days, hours,
+ * and minutes.  Values above 65534 mean the battery is not discharged.
+ *
+ * @param[out] pBuf
+ *	Buffer of at least 13 characters to store the string into.
+ *
+ * @param[in] minutes
+ *	Duration in [min].
+ *
+ ******************************************************************************/
+static void	DurationString (char *pBuf, int minutes)
+{
+int	d, h, m;	// days, hours, minutes
+
+
+    if (minutes > 65534)		// > 45d
+    {
+	strcpy (pBuf, "> 45 days");
+    }
+    else
+    {
+	d = minutes / 60 / 24;
+	minutes -= (d * 60 * 24);
+	h = minutes / 60;
+	minutes -= (h * 60);
+	m = minutes;
+	sprintf (pBuf, "%2dd %2dh %2dm", d, h, m);
+    }
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Log Battery Information
@@ -747,6 +806,13 @@ int		 d, h, m;	// FRMT_DURATION: days, hours, minutes
  * - Actual Voltage and remaining Capacity
  * - Remaining Run Time
  *
+ * The identity of the battery pack, i.e. all static values, is logged for
+ * @ref BAT_LOG_INFO_VERBOSE, and for @ref BAT_LOG_INFO_CHANGES if the serial
+ * number, the design capacity, or the controller type differs from the pack
+ * that has been logged last.  The dynamic values are logged for
+ * @ref BAT_LOG_INFO_CHANGES only if they have changed, see BatLogSelect(),
+ * the other levels log a key frame with all values.
+ *
  * @param[in] infoLvl
  *	Enum of type @ref BAT_LOG_INFO_LVL which specifies the level of
  *	information.
@@ -756,6 +822,13 @@ void	LogBatteryInfo (BAT_LOG_INFO_LVL infoLvl)
 {
 #ifdef LOGGING
 uint32_t value;		// unsigned data variable
+int32_t	 val[END_BAT_VAL];	// dynamic values, see BatLogSelect()
+CLOCK_STAMP stamp[END_BAT_VAL];	// time when each value has been read
+uint32_t mask;		// bit mask of the dynamic values to log
+BAT_ID	 id;		// identity of the connected battery pack
+bool	 flgIdentity;	// log the identity of the battery pack
+char	 strBuf[20];	// runtime to empty as string
+int	 n;
 
     /* Check if the Battery Controller Probe routine should be called (again) */
     if (l_flgBatteryCtrlProbe)
@@ -773,8 +846,27 @@ uint32_t value;		// unsigned data variable
 	return;
     }
 
+    /* Read the identity and see if another battery pack is connected */
+    flgIdentity = (infoLvl == BAT_LOG_INFO_VERBOSE);
+    id.flgValid = false;
+    if (infoLvl == BAT_LOG_INFO_VERBOSE  ||  infoLvl == BAT_LOG_INFO_CHANGES)
+    {
+	id.CtrlType = g_BatteryCtrlType;
+	id.flgValid = (BatteryRegReadValue (SBS_SerialNumber,
+					    &id.SerialNumber) >= 0
+		    && BatteryRegReadValue (SBS_DesignCapacity,
+					    &id.DesignCapacity) >= 0);
+	if (id.flgValid
+	&&  (! l_BatId.flgValid  ||  id.CtrlType != l_BatId.CtrlType
+	     ||  id.SerialNumber != l_BatId.SerialNumber
+	     ||  id.DesignCapacity != l_BatId.DesignCapacity))
+	{
+	    flgIdentity = true;
+	}
+    }
+
     /* No get and log all the information */
-    if (infoLvl == BAT_LOG_INFO_VERBOSE)
+    if (flgIdentity)
     {
 	Log ("Battery Controller Type is \"%s\" at address 0x%02X",
 	     g_BatteryCtrlName, g_BatteryCtrlAddr);
@@ -800,35 +892,70 @@ uint32_t value;		// unsigned data variable
 
 	Log ("Battery Full Charge Capac.: %s",
 	     ItemDataString(SBS_FullChargeCapacity, FRMT_MILLIAMPH));
+
+	if (id.flgValid)
+	    l_BatId = id;
     }
 
     drvLEUART_sync();	// to prevent UART buffer overflow
 
+    /* Read the dynamic values, each with its time stamp */
+    for (n = 0;  n < END_BAT_VAL;  n++)
+	val[n] = BAT_LOG_NO_VALUE;
+
+    ClockStamp (&stamp[BAT_VAL_CAPACITY]);
     if (BatteryRegReadValue(SBS_RemainingCapacity, &value) >= 0)
     {
 	g_BattCapacity = (uint16_t)value;
-	if (infoLvl != BAT_LOG_INFO_DISPLAY_ONLY)
-	    Log ("Battery Remaining Capacity: %ldmAh", value);
+	val[BAT_VAL_CAPACITY] = (uint16_t)value;
     }
 
-    if (infoLvl != BAT_LOG_INFO_DISPLAY_ONLY)
-    {
-	Log ("Battery Runtime to empty  : %s",
-	     ItemDataString(SBS_RunTimeToEmpty, FRMT_DURATION));
-    }
+    ClockStamp (&stamp[BAT_VAL_RUNTIME]);
+    if (BatteryRegReadValue(SBS_RunTimeToEmpty, &value) >= 0)
+	val[BAT_VAL_RUNTIME] = (uint16_t)value;
 
+    ClockStamp (&stamp[BAT_VAL_VOLTAGE]);
     if (BatteryRegReadValue(SBS_Voltage, &value) >= 0)
     {
 	g_BattMilliVolt = (int16_t)value;
-	if (infoLvl != BAT_LOG_INFO_DISPLAY_ONLY)
-	    Log ("Battery Actual Voltage    : %2ld.%ldV",
-		 value / 1000, (value % 1000) / 100);
+	val[BAT_VAL_VOLTAGE] = (uint16_t)value;
     }
 
+    ClockStamp (&stamp[BAT_VAL_CURRENT]);
+    if (BatteryRegReadValue(SBS_BatteryCurrent, &value) >= 0)
+	val[BAT_VAL_CURRENT] = (int16_t)value;	// +:charging, -:discharging
+
     if (infoLvl != BAT_LOG_INFO_DISPLAY_ONLY)
     {
-	Log ("Battery Actual Current    : %s",
-	     ItemDataString(SBS_BatteryCurrent, FRMT_MILLIAMP));
+	/* A new identity or an explicit request logs a key frame */
+	if (flgIdentity  ||  infoLvl != BAT_LOG_INFO_CHANGES)
+	    BatLogReset (&l_BatLogState);
+
+	mask = BatLogSelect (&l_BatLogCfg, &l_BatLogState, val,
+			     (uint32_t)time(NULL));
+
+	if (mask & (1 << BAT_VAL_CAPACITY))
+	    LogAt (&stamp[BAT_VAL_CAPACITY],
+		   "Battery Remaining Capacity: %ldmAh",
+		   (long)val[BAT_VAL_CAPACITY]);
+
+	if (mask & (1 << BAT_VAL_RUNTIME))
+	{
+	    DurationString (strBuf, (int)val[BAT_VAL_RUNTIME]);
+	    LogAt (&stamp[BAT_VAL_RUNTIME], "Battery Runtime to empty  : %s",
+		   strBuf);
+	}
+
+	if (mask & (1 << BAT_VAL_VOLTAGE))
+	    LogAt (&stamp[BAT_VAL_VOLTAGE],
+		   "Battery Actual Voltage    : %2ld.%ldV",
+		   (long)val[BAT_VAL_VOLTAGE] / 1000,
+		   ((long)val[BAT_VAL_VOLTAGE] % 1000) / 100);
+
+	if (mask & (1 << BAT_VAL_CURRENT))
+	    LogAt (&stamp[BAT_VAL_CURRENT],
+		   "Battery Actual Current    : %ldmA",
+		   (long)val[BAT_VAL_CURRENT]);
     }
 
     drvLEUART_sync();	// to prevent UART buffer overflow
@@ -836,6 +963,24 @@ uint32_t value;		// unsigned data variable
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Configure the Battery Log
+ *
+ * This routine sets the minimum changes of the dynamic battery values to be
+ * logged, and the key frame interval.  It is called by the Control module
+ * after the configuration has been read.
+ *
+ * @param[in] pCfg
+ *	Minimum changes and key frame interval, see @ref BAT_LOG_CFG.
+ *
+ ******************************************************************************/
+void	BatteryLogConfig (const BAT_LOG_CFG *pCfg)
+{
+    l_BatLogCfg = *pCfg;
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Battery Check
@@ -848,8 +993,6 @@ uint32_t value;		// unsigned data variable
  ******************************************************************************/
 void	BatteryCheck (void)
 {
-bool	flgBatteryCtrlProbe = l_flgBatteryCtrlProbe;
-
     /* Check if the Battery Controller Probe routine should be called (again) */
     if (l_flgBatteryCtrlProbe)
     {
@@ -885,9 +1028,8 @@ bool	flgBatteryCtrlProbe = l_flgBatteryCtrlProbe;
     {
 	l_flgBatMonTrigger = false;
 
-	/* Log verbose information, if Battery Pack has changed */
-	LogBatteryInfo (flgBatteryCtrlProbe ? BAT_LOG_INFO_VERBOSE
-					    : BAT_LOG_INFO_SHORT);
+	/* Log identity if Battery Pack has changed, and changed values */
+	LogBatteryInfo (BAT_LOG_INFO_CHANGES);
     }
 }
 
@@ -5,6 +5,8 @@
  * @version	2020-01-22
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added BAT_LOG_INFO_CHANGES for change-only battery logging,
+		and prototype BatteryLogConfig().
 2020-01-22,rage	Added support for battery controller TI bq40z50.
 2018-03-25,rage	Added prototypes for BatteryInfoReq() and BatteryInfoGet().
 		New SBS_CMD enum SBS_NONE to mark "no request".
@@ -27,6 +29,7 @@ Revision History:
 #include "em_device.h"
 #include "em_gpio.h"
 #include "config.h"		// include project configuration parameters
+#include "BatLog.h"
 
 /*=============================== Definitions ================================*/
 
@@ -49,6 +52,7 @@ typedef enum
 {
     BAT_LOG_INFO_DISPLAY_ONLY,	//!< Get information for the display only
     BAT_LOG_INFO_SHORT,		//!< Log short information of battery status
+    BAT_LOG_INFO_CHANGES,	//!< Log changed identity and values only
     BAT_LOG_INFO_VERBOSE,	//!< Log verbose information of battery status
     END_BAT_LOG_INFO_LVL
 } BAT_LOG_INFO_LVL;
@@ -276,4 +280,7 @@ void	BatteryMonPowerFailHandler (void);
     /* Call this routine when Battery Pack has been changed */
 void	BatteryChangeTrigger(void);
 
+    /* Set minimum changes and key frame interval of the battery log */
+void	BatteryLogConfig (const BAT_LOG_CFG *pCfg);
+
 #endif /* __INC_BatteryMon_h */
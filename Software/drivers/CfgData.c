@@ -42,6 +42,9 @@ Revision History:
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_CONFIG
+
     /* local debug: show a list of all IDs and settings */
 #define CONFIG_DATA_SHOW	1
 
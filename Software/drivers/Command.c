@@ -0,0 +1,579 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Serial Command Interpreter
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module executes commands which are received via the LEUART.  The
+ * LEUART driver stores a line into @ref g_CmdLine by DMA, so the system
+ * remains in EM2 while the characters are received.  When a \<LF> has been
+ * received, the driver sets @ref g_flgCmdLine, and CmdCheck(), which is
+ * called from the main loop, executes the command.
+ *
+ * A command line consists of the command name and up to 3 arguments,
+ * separated by blanks.  Upper and lower case are not distinguished.
+ * All replies are logged, i.e. they are shown on the serial console and
+ * stored in the log file.  The following commands are available:
+ *
+ * - <b>HELP</b> lists all commands.
+ * - <b>STATUS</b> shows date and time, up-time, log file, power outputs,
+ *   and the short battery information.
+ * - <b>BATTERY</b> logs the verbose battery information.
+ * - <b>FLUSH</b> writes the log buffer to the SD-Card immediately.
+ * - <b>TIME</b> [[YYYY-MM-DD] hh:mm[:ss]] shows or sets the system clock.
+ *   The next DCF77 or GNSS synchronization overwrites the time again.
+ * - <b>RELOAD</b> reads CONFIG.TXT from the SD-Card again.
+ * - <b>OUTPUT</b> UA1|UA2|BATT ON|OFF switches a power output.
+ * - <b>DIAG</b> logs diagnostic counters: DMA channel statistics, lost log
+ *   entries per source, SD-Card CRC errors, the EM1 module mask, the
+ *   log authentication statistics, and the time to sync and energy per sync
+ *   of the time sources.
+ * - <b>FORMAT</b> YES formats the SD-Card, see DiskFormatRequest().
+ *   All files are lost, including CONFIG.TXT.
+ * - <b>KEY</b> [<32 hex digits>|OFF] shows the key check value of the log
+ *   authentication, stores a new key, or removes it, see LogAuth.c.
+ * - <b>READ</b> <offset> [<lines>] outputs lines of the log file, a
+ *   negative offset counts from the end, see LogFileRead().
+ *
+ * New commands are added to the table @ref l_CmdDef.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Added command READ.
+2026-10-19,agent DIAG logs the statistics of the time sources.
+2026-10-19,agent Added command KEY, DIAG logs the authentication statistics.
+		The key is cleared from the command line buffers.
+2026-10-19,agent Added command FORMAT.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "em_int.h"
+#include "Command.h"
+#include "LEUART.h"
+#include "AlarmClock.h"
+#include "BatteryMon.h"
+#include "CfgData.h"
+#include "Control.h"
+#include "DmaMgr.h"
+#include "Logging.h"
+#include "LogAuth.h"
+#include "RFID.h"
+#include "TimeSource.h"
+#include "microsd.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_COMMAND
+
+/*=========================== Forward Declarations ===========================*/
+
+static void cmdHelp (int argc, char **argv);
+static void cmdStatus (int argc, char **argv);
+static void cmdBattery (int argc, char **argv);
+static void cmdFlush (int argc, char **argv);
+static void cmdTime (int argc, char **argv);
+static void cmdReload (int argc, char **argv);
+static void cmdOutput (int argc, char **argv);
+static void cmdDiag (int argc, char **argv);
+static void cmdFormat (int argc, char **argv);
+static void cmdKey (int argc, char **argv);
+static void cmdRead (int argc, char **argv);
+static int  parseNumbers (const char *pStr, char sep, int *pVal, int maxCnt);
+
+/*================================ Local Data ================================*/
+
+    /*! Command table, the names must be in upper case */
+static const CMD_DEF l_CmdDef[] =
+{
+    { "HELP",	 0, 0, cmdHelp,	   "HELP - list all commands"			},
+    { "STATUS",	 0, 0, cmdStatus,  "STATUS - show system status"		},
+    { "BATTERY", 0, 0, cmdBattery, "BATTERY - log battery information"	},
+    { "FLUSH",	 0, 0, cmdFlush,   "FLUSH - write log buffer to SD-Card"	},
+    { "TIME",	 0, 2, cmdTime,	   "TIME [[YYYY-MM-DD] hh:mm[:ss]] - show/set clock" },
+    { "RELOAD",	 0, 0, cmdReload,  "RELOAD - read CONFIG.TXT again"	},
+    { "OUTPUT",	 2, 2, cmdOutput,  "OUTPUT UA1|UA2|BATT ON|OFF - switch output" },
+    { "DIAG",	 0, 0, cmdDiag,	   "DIAG - log diagnostic counters"	},
+    { "FORMAT",	 1, 1, cmdFormat,  "FORMAT YES - format the SD-Card"	},
+    { "KEY",	 0, 1, cmdKey,	   "KEY [<32 hex>|OFF] - show/set log key"	},
+    { "READ",	 1, 2, cmdRead,	   "READ <offset> [<lines>] - read log file"	},
+    { NULL,	 0, 0, NULL,	   NULL						}
+};
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check for a Command
+ *
+ * This routine is called from the main loop.  If a new command line has been
+ * received by the LEUART, it is split into words and the respective function
+ * of @ref l_CmdDef is executed.
+ *
+ ******************************************************************************/
+void	CmdCheck (void)
+{
+char	 line[CMD_LINE_SIZE];
+char	*argv[CMD_MAX_ARGS];
+int	 argc;
+char	*pStr;
+const CMD_DEF *pCmd;
+
+
+    if (! g_flgCmdLine)
+	return;
+
+    /* Copy line, the DMA may already receive the next one */
+    INT_Disable();
+    strncpy (line, g_CmdLine, sizeof(line) - 1);
+    line[sizeof(line) - 1] = EOS;
+    g_flgCmdLine = false;
+    INT_Enable();
+
+    /* Convert to upper case, remove control characters like <CR> */
+    for (pStr = line;  *pStr != EOS;  pStr++)
+	*pStr = iscntrl((int)*pStr) ? ' ' : toupper((int)*pStr);
+
+    /* Split line into words */
+    argc = 0;
+    for (pStr = strtok (line, " \t");  pStr != NULL;  pStr = strtok (NULL, " \t"))
+    {
+	if (argc >= CMD_MAX_ARGS)
+	{
+	    LogError ("CMD: Too many arguments");
+	    return;
+	}
+	argv[argc++] = pStr;
+    }
+
+    if (argc == 0)
+	return;			// empty line
+
+    /* Look up command */
+    for (pCmd = l_CmdDef;  pCmd->Name != NULL;  pCmd++)
+    {
+	if (strcmp (argv[0], pCmd->Name) == 0)
+	    break;
+    }
+
+    if (pCmd->Name == NULL)
+    {
+	LogError ("CMD: Unknown command %s, try HELP", argv[0]);
+	return;
+    }
+
+    if (argc - 1 < pCmd->MinArgs  ||  argc - 1 > pCmd->MaxArgs)
+    {
+	LogError ("CMD: Usage: %s", pCmd->Help);
+	return;
+    }
+
+    Log ("CMD: %s", argv[0]);
+    pCmd->Function (argc, argv);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	HELP - List all Commands
+ *
+ ******************************************************************************/
+static void cmdHelp (int argc, char **argv)
+{
+const CMD_DEF *pCmd;
+
+    (void) argc;
+    (void) argv;
+
+    for (pCmd = l_CmdDef;  pCmd->Name != NULL;  pCmd++)
+	Log ("  %s", pCmd->Help);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	STATUS - Show System Status
+ *
+ ******************************************************************************/
+static void cmdStatus (int argc, char **argv)
+{
+struct tm time;
+uint32_t  up;
+int	  i;
+
+    (void) argc;
+    (void) argv;
+
+    ClockGet (&time);
+    up = (g_PowerUpTime != 0 ? (uint32_t)(mktime (&time) - g_PowerUpTime) : 0);
+
+    Log ("Status: %04d-%02d-%02d %02d:%02d:%02d, up %ldd %02ld:%02ld,"
+	 " log file %s", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday,
+	 time.tm_hour, time.tm_min, time.tm_sec, up / 86400,
+	 (up / 3600) % 24, (up / 60) % 60,
+	 g_LogFilename[0] != EOS ? g_LogFilename : "(none)");
+
+    for (i = 0;  i < NUM_PWR_OUT;  i++)
+	Log ("Power Output %s is %s", g_enum_PowerOutput[i],
+	     IsPowerOutputOn ((PWR_OUT)i) ? "ON" : "OFF");
+
+    Log ("RFID reader is %s", IsRFID_Active() ? "active" : "inactive");
+
+    LogBatteryInfo (BAT_LOG_INFO_SHORT);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	BATTERY - Log verbose Battery Information
+ *
+ ******************************************************************************/
+static void cmdBattery (int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+
+    LogBatteryInfo (BAT_LOG_INFO_VERBOSE);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	FLUSH - Write Log Buffer to SD-Card
+ *
+ ******************************************************************************/
+static void cmdFlush (int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+
+    LogFlush (false);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	TIME - Show or set the System Clock
+ *
+ * Without arguments, the current date and time is shown.  The time can be
+ * set by specifying <b>hh:mm[:ss]</b>, optionally preceded by the date
+ * <b>YYYY-MM-DD</b>.
+ *
+ ******************************************************************************/
+static void cmdTime (int argc, char **argv)
+{
+struct tm time;
+int	  val[3];
+int	  idx = 1;
+
+    ClockGet (&time);
+
+    if (argc == 3)
+    {
+	/* Date specified */
+	if (parseNumbers (argv[idx++], '-', val, 3) != 3
+	||  val[0] < 2000  ||  val[0] > 2099  ||  val[1] < 1  ||  val[1] > 12
+	||  val[2] < 1  ||  val[2] > 31)
+	{
+	    LogError ("CMD: Invalid date, use YYYY-MM-DD");
+	    return;
+	}
+	time.tm_year = val[0] - 1900;
+	time.tm_mon  = val[1] - 1;
+	time.tm_mday = val[2];
+    }
+
+    if (argc >= 2)
+    {
+	/* Time specified */
+	val[2] = 0;
+	if (parseNumbers (argv[idx], ':', val, 3) < 2
+	||  val[0] > 23  ||  val[1] > 59  ||  val[2] > 59)
+	{
+	    LogError ("CMD: Invalid time, use hh:mm[:ss]");
+	    return;
+	}
+	time.tm_hour = val[0];
+	time.tm_min  = val[1];
+	time.tm_sec  = val[2];
+
+	/* localtime() is not reentrant, lock out the RTC interrupt */
+	INT_Disable();
+	ClockSet (&time, true);
+	ClockUpdate (true);
+	INT_Enable();
+
+	ClockGet (&time);
+    }
+
+    Log ("Time: %04d-%02d-%02d %02d:%02d:%02d", time.tm_year + 1900,
+	 time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	RELOAD - Read Configuration File again
+ *
+ * This performs the same steps as main() after a new SD-Card has been
+ * mounted.
+ *
+ ******************************************************************************/
+static void cmdReload (int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+
+    if (IsDiskRemoved()  ||  g_LogFilename[0] == EOS)
+    {
+	LogError ("CMD: No SD-Card");
+	return;
+    }
+
+    /* Clear (previous) Configuration, read and verify the new one */
+    ClearConfiguration();
+    CfgRead("CONFIG.TXT");
+    VerifyConfiguration();
+
+    /* Initialize RFID reader according to (new) configuration */
+    RFID_Init();
+
+    /* Flush log buffer and switch SD-Card power off */
+    LogFlush(false);
+
+    /* See if devices must be switched on at this time */
+    CheckAlarmTimes();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	OUTPUT - Switch a Power Output on or off
+ *
+ * The output remains in the new state until the next alarm or control
+ * action changes it.
+ *
+ ******************************************************************************/
+static void cmdOutput (int argc, char **argv)
+{
+int	i;
+
+    (void) argc;
+
+    for (i = 0;  i < NUM_PWR_OUT;  i++)
+    {
+	if (strcmp (argv[1], g_enum_PowerOutput[i]) == 0)
+	    break;
+    }
+
+    if (i >= NUM_PWR_OUT
+    ||  (strcmp (argv[2], "ON") != 0  &&  strcmp (argv[2], "OFF") != 0))
+    {
+	LogError ("CMD: Usage: OUTPUT UA1|UA2|BATT ON|OFF");
+	return;
+    }
+
+    PowerOutput ((PWR_OUT)i, strcmp (argv[2], "ON") == 0 ? PWR_ON : PWR_OFF);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	DIAG - Log diagnostic Counters
+ *
+ ******************************************************************************/
+static void cmdDiag (int argc, char **argv)
+{
+int	i;
+uint32_t cnt;
+
+    (void) argc;
+    (void) argv;
+
+    DmaLogStatistics();
+
+    Log ("Log Lost: %ld entries total", LogLostEntryCount (END_LOG_SRC));
+    for (i = 0;  i < END_LOG_SRC;  i++)
+    {
+	cnt = LogLostEntryCount ((LOG_SRC)i);
+	if (cnt > 0)
+	    Log ("Log Lost: %ld entries from %s", cnt,
+		 LogSourceName ((LOG_SRC)i));
+    }
+
+    Log ("SD-Card: %ld CRC errors", MICROSD_CrcErrorCount());
+    Log ("EM1 Module Mask: 0x%04X", g_EM1_ModuleMask);
+    LogAuthStatistics();
+    TimeSourceStatistics();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	FORMAT - Format the SD-Card
+ *
+ * The argument YES must be given to confirm that all files will be lost.
+ * The format itself is done by DiskCheck() within the main loop.
+ *
+ ******************************************************************************/
+static void cmdFormat (int argc, char **argv)
+{
+    (void) argc;
+
+    if (strcmp (argv[1], "YES") != 0)
+    {
+	LogError ("CMD: Usage: FORMAT YES");
+	return;
+    }
+
+    if (IsDiskRemoved())
+    {
+	LogError ("CMD: No SD-Card present");
+	return;
+    }
+
+    Log ("CMD: SD-Card will be formatted");
+    DiskFormatRequest();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	KEY - Show or set the Log Authentication Key
+ *
+ * Without argument, the key check value is shown.  A key is specified as
+ * 32 hexadecimal digits, OFF removes the key.  The key itself is never
+ * shown, because the log is visible to everybody, and it is cleared from the
+ * command line buffers, see drvLEUART_CmdLineClear().
+ *
+ ******************************************************************************/
+static void cmdKey (int argc, char **argv)
+{
+uint8_t	 key[LOG_AUTH_KEY_SIZE];
+const char *pErr = NULL;
+char	*pStr;
+int	 i, nibble;
+
+
+    if (argc < 2)
+    {
+	if (LogAuthIsEnabled())
+	    Log ("CMD: Log key check value %08lX", LogAuthKeyCheck());
+	else
+	    Log ("CMD: No log key");
+	return;
+    }
+
+    if (strcmp (argv[1], "OFF") == 0)
+    {
+	LogAuthSetKey (NULL);
+	return;
+    }
+
+    pStr = argv[1];
+    if (strlen (pStr) != 2 * LOG_AUTH_KEY_SIZE)
+	pErr = "Usage: KEY [<32 hex digits>|OFF]";
+
+    for (i = 0;  pErr == NULL  &&  i < 2 * LOG_AUTH_KEY_SIZE;  i++)
+    {
+	if (isdigit ((int)pStr[i]))
+	    nibble = pStr[i] - '0';
+	else if (pStr[i] >= 'A'  &&  pStr[i] <= 'F')
+	    nibble = pStr[i] - 'A' + 10;
+	else
+	{
+	    pErr = "Invalid hex digit in key";
+	    break;
+	}
+	if (i & 1)
+	    key[i / 2] = (uint8_t)((key[i / 2] << 4) | nibble);
+	else
+	    key[i / 2] = (uint8_t)nibble;
+    }
+
+    /* Remove the key from the copy of CmdCheck() and the receive buffer */
+    memset (pStr, 0, strlen (pStr));
+    drvLEUART_CmdLineClear();
+
+    if (pErr != NULL)
+	LogError ("CMD: %s", pErr);
+    else
+	LogAuthSetKey (key);
+
+    memset (key, 0, sizeof(key));
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	READ - Read back Lines of the Log File
+ *
+ * The lines are sent to the serial console only.  The log entry written by
+ * LogFileRead() tells the offset to continue with.
+ *
+ ******************************************************************************/
+static void cmdRead (int argc, char **argv)
+{
+char	*pEnd;
+long	 offset;
+long	 lines = 1;
+
+
+    offset = strtol (argv[1], &pEnd, 0);
+    if (*pEnd == EOS  &&  argc > 2)
+	lines = strtol (argv[2], &pEnd, 0);
+
+    if (*pEnd != EOS  ||  lines < 1  ||  lines > LOG_READ_MAX_LINES)
+    {
+	LogError ("CMD: Usage: READ <offset> [1..%d]", LOG_READ_MAX_LINES);
+	return;
+    }
+
+    if (IsDiskRemoved())
+    {
+	LogError ("CMD: No SD-Card present");
+	return;
+    }
+
+    LogFileRead ((int32_t)offset, (int)lines);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Parse Numbers
+ *
+ * This routine parses up to @p maxCnt decimal numbers, separated by the
+ * character @p sep, e.g. "12:30:00".
+ *
+ * @return
+ *	Number of values stored in @p pVal, or 0 if the string is invalid.
+ *
+ ******************************************************************************/
+static int  parseNumbers (const char *pStr, char sep, int *pVal, int maxCnt)
+{
+int	cnt = 0;
+
+    while (cnt < maxCnt)
+    {
+	if (! isdigit((int)*pStr))
+	    return 0;
+
+	for (pVal[cnt] = 0;  isdigit((int)*pStr);  pStr++)
+	    pVal[cnt] = pVal[cnt] * 10 + (*pStr - '0');
+	cnt++;
+
+	if (*pStr == EOS)
+	    return cnt;
+
+	if (*pStr++ != sep)
+	    return 0;
+    }
+
+    return 0;			// too many values
+}
@@ -0,0 +1,48 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module Command.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_Command_h
+#define __INC_Command_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include "config.h"		// include project configuration parameters
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Maximum number of arguments of a command, including its name. */
+#define CMD_MAX_ARGS		4
+
+/*=========================== Typedefs and Structs ===========================*/
+
+/*!@brief Command table entry.
+ *
+ * The command interpreter looks up the first word of a command line in a
+ * table of these entries.  If the number of arguments is within the range
+ * of @ref MinArgs and @ref MaxArgs, the function is called with the
+ * argument vector, where argv[0] is the command name itself.
+ */
+typedef struct
+{
+    const char	*Name;		//!< Command name in upper case
+    int		 MinArgs;	//!< Minimum number of arguments (without name)
+    int		 MaxArgs;	//!< Maximum number of arguments (without name)
+    void	(*Function)(int argc, char **argv);	//!< Command function
+    const char	*Help;		//!< Usage and short description
+} CMD_DEF;
+
+/*================================ Prototypes ================================*/
+
+    /* Check for a new command line and execute it */
+void	CmdCheck (void);
+
+
+#endif /* __INC_Command_h */
@@ -2,18 +2,90 @@
  * @file
  * @brief	Sequence Control
  * @author	Ralf Gerhauser
- * @version	2020-05-12
+ * @version	2026-10-19
  *
  * This is the automatic sequence control module.  It controls the power
  * outputs and the measurement of their voltage and current.  Calibration
  * routines and the ability to write data to an @ref EEPROM area makes it
  * possible to store board-specific factors, so, voltage and current can be
  * calculated and logged .<br>
+ * Power outputs are switched on by a sequencer, which spaces them by a
+ * settle time, so the inrush currents of several loads do not add up.<br>
+ * The energy of UA1 and UA2 is integrated from the measured voltage and
+ * current, see Energy.c.  An optional daily energy budget per output issues
+ * a warning at @ref ENERGY_WARN_LEVEL, and switches the output off for the
+ * rest of the day when it is used up.  At @ref ENERGY_RESET_TIME the counters
+ * are reset and the outputs are released again.<br>
+ * The ADC averages each channel over a window that ends as soon as its mean
+ * is known to the confidence bound SCAN_CONFIDENCE, see AdcOvs.c.  A round
+ * of all channels is started every four SCAN_DURATION, and the ADC is
+ * switched off in between.<br>
+ * Alternatively, with SCAN_PAIR_RATE, TIMER0 starts a scan of all channels
+ * at this rate through the PRS, without oversampling, so voltage and current
+ * of an output are converted within a few microseconds.  The DMA writes the
+ * scans into a ping-pong buffer, and ADC_PairDone() accumulates the product
+ * of each pair, see AdcPair.c.  So the true average power of pulsed loads,
+ * like cameras, IR illuminators, or RFID bursts, is measured next to the
+ * average voltage and current, and used for the energy integration.<br>
+ * When the battery runs low, load shedding reduces the consumption in tiers,
+ * see LoadShed.c: the duty cycle of the RFID reader is reduced, the other
+ * power outputs are switched off, the log buffer is flushed less often, and
+ * finally only logging and timekeeping remain.  The tier is determined every
+ * @ref SHED_CHECK_INTERVAL seconds from the state of charge and the runtime
+ * to empty reported by the battery controller.<br>
  * This module also defines the configuration variables for the file
  * <a href="../../CONFIG.TXT"><i>CONFIG.TXT</i></a>.
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added WriteCalibrationRequest(), the calibration data is
+		written by Control() in the main loop instead of the key
+		interrupt, so GPIO interrupts may preempt the FLASH writes.
+2026-10-19,agent The power output sequencer is a state machine executed by
+		Control(), it no longer waits in the main loop.  It samples
+		between two rounds of the ADC scan, and defers the next round
+		until the output has settled.  With pair sampling it takes the
+		current from the DMA buffers, see PowerSequencerSample().
+		PowerOutputFctInstall() installs a function to be called when
+		an output is on.
+2026-10-19,agent The ADC is restarted after the pause between two rounds by
+		Control(), the millisecond timer remains with Keys.c.
+2026-10-19,agent Voltage/current pair sampling, see AdcPair.c: with
+		SCAN_PAIR_RATE, TIMER0 starts a 12bit scan of all four channels
+		via PRS, the DMA collects the results, and the product of each
+		output's voltage and current is accumulated per scan.  The true
+		average power is integrated by EnergyAddPower(), see PowerTrue().
+2026-10-19,agent Adaptive oversampling of the ADC channels, see AdcOvs.c: each
+		channel is averaged until its confidence bound is reached.
+		Added configuration variables SCAN_SAMPLES_MIN/MAX and
+		SCAN_CONFIDENCE.  The ADC is switched off between two rounds.
+2026-10-19,agent FLASH is programmed by FlashProg.c: WriteCalibrationData() no
+		longer disables all interrupts, and logs the FLASH statistics.
+		ADC conversions are captured while the FLASH is busy, see
+		ADC_Capture().
+2026-10-19,agent The measurements of the power outputs, BATT_INP, and the
+		transponder IDs are logged with the time of their source,
+		i.e. the ADC conversion, the battery read, and the RFID frame.
+2026-10-19,agent Added configuration variables BATTERY_LOG_<value>_DIFF and
+		BATTERY_LOG_KEYFRAME for the change-only battery log.
+2026-10-19,agent Added configuration variables LOG_RATE, LOG_BURST, and
+		LOG_RATE_<source> for the log rate limit, see LogRateApply().
+		The limit is off by default, LOG_RATE does not apply to the
+		data and command sources.
+2026-10-19,agent Added load shedding: configuration variables SHED_SOC_n,
+		SHED_RUNTIME_n, SHED_SOC/RUNTIME_HYSTERESIS, SHED_RFID_DUTY, and
+		SHED_FLUSH_PAUSE, tier check in LoadShedCheck(), and actions in
+		LoadShedApply().  PowerOutput() refuses outputs that are shed.
+		LoadShedCheck() does not block during the SMBus pauses.
+2026-10-19,agent Added daily energy budgets for UA1 and UA2: configuration
+		variables UA1/UA2_ENERGY_BUDGET, ENERGY_WARN_LEVEL, and
+		ENERGY_RESET_TIME, energy integration in Control(), cut-off
+		in EnergyCheck(), and reset by EnergyResetBudgets(),
+		requested by alarm EnergyResetAlarm().
+2026-10-19,agent Added power output sequencer: PowerOutput() queues enable
+		requests, Control() switches them on one after another, spaced
+		by POWER_SETTLE_TIME and the observed inrush current, and logs
+		the minimum supply voltage during the sequence.
 2020-05-12,rage	- Use defines XXX_POWER_ALARM instead of ENUMs.
 		- Power Alarms are grouped in ON and OFF alarms now.
 		- Changed AlarmPowerControl() according to new ALARM_ID enums.
@@ -30,7 +102,10 @@ Revision History:
 #include "em_int.h"
 #include "em_gpio.h"
 #include "em_adc.h"
+#include "em_timer.h"
+#include "em_prs.h"
 #include "eeprom_emulation.h"
+#include "FlashProg.h"
 #include "ExtInt.h"
 #include "Logging.h"
 #include "AlarmClock.h"
@@ -41,9 +116,17 @@ Revision History:
 #include "DisplayMenu.h"
 #include "BatteryMon.h"
 #include "DM_PowerOutput.h"	// g_UA_Calib_mV[] and g_UA_Calib_mA[]
+#include "Energy.h"
+#include "LoadShed.h"
+#include "AdcOvs.h"
+#include "AdcPair.h"
+#include "DmaMgr.h"
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_CONTROL
+
 /*!@brief Magic ID for EEPROM (Flash) block */
 #define MAGIC_ID	0x0815
 
@@ -76,6 +159,29 @@ typedef struct
     MEASURE        Measure;	// Enum for U/I measuring
 } PWR_OUT_DEF;
 
+    /*!@brief State of the power output sequencer, see PowerSequencer(). */
+typedef struct
+{
+    bool	Active;		//!< A sequence is in progress
+    PWR_OUT	Output;		//!< Output that is settling, or PWR_OUT_NONE
+    bool	Settled;	//!< Current of Output does not change anymore
+    uint32_t	StartCnt;	//!< RTC counter at the start of the sequence
+    uint32_t	SwitchCnt;	//!< RTC counter when Output was switched on
+    uint32_t	SampleCnt;	//!< RTC counter of the previous sample
+    uint32_t	Prev_mA;	//!< Previous current of Output in [mA]
+    uint32_t	Peak_mA;	//!< Peak inrush current of the sequence in [mA]
+    uint32_t	MinVDD_mV;	//!< Minimum supply voltage of the sequence
+    int		Count;		//!< Number of outputs switched on
+} SEQ_STATE;
+
+    /*!@brief Steps of the battery read for the load shedding check. */
+typedef enum
+{
+    SHED_READ_IDLE,		//!< Waiting for the next check
+    SHED_READ_SOC,		//!< Pause, then read the state of charge
+    SHED_READ_RUNTIME		//!< Pause, then read the runtime to empty
+} SHED_READ;
+
     /*!@brief Macro to calculate a GPIO bit address for a port and pin. */
 #define GPIO_BIT_ADDR(port, pin)					\
 	IO_BIT_ADDR((&(GPIO->P[(port)].DOUT)), (pin))
@@ -89,6 +195,76 @@ typedef struct
 #define GPIO_BIT_ADDR_TO_PIN(bitAddr)					\
 	(((uint32_t)(bitAddr) >> 2) & 0x1F)
 
+    /*!@brief Range of the scan duration in [ms]. */
+#define MIN_SCAN_DURATION	  52	// minimum is   52ms
+#define MAX_SCAN_DURATION	2200	// maximum is 2200ms
+
+    /*!@brief Maximum settle time in [ms] between two power outputs. */
+#define MAX_POWER_SETTLE_TIME	2000
+
+    /*!@brief Interval in [ms] to sample VDD and inrush current. */
+#define SEQ_POLL_MS		2
+
+    /*!@brief Settle time is extended up to this factor while the current
+     * of the output still changes. */
+#define SEQ_MAX_SETTLE_FACTOR	4
+
+    /*!@brief Duration in [ms] VDD is observed if sequencing is disabled. */
+#define SEQ_MONITOR_MS		100
+
+    /*!@brief ADC clock in [Hz] for single conversions of the sequencer. */
+#define SEQ_ADC_CLOCK		1000000
+
+    /*!@brief Maximum confidence bound of the ADC channels in [LSB]. */
+#define MAX_SCAN_CONFIDENCE	1024
+
+    /*!@brief Minimum pause in [ms] to switch the ADC off between two rounds.
+     */
+#define MIN_ADC_PAUSE		2
+
+    /*!@brief Range of the scan rate of the pair sampling in [Hz]. */
+#define MIN_SCAN_PAIR_RATE	100
+#define MAX_SCAN_PAIR_RATE	2000
+
+    /*!@brief ADC clock in [Hz] of the pair sampling.  A conversion takes
+     * 16 clocks acquisition time and 13 clocks for 12 bits, i.e. 3.6us, so
+     * voltage and current of an output are 7.3us apart in the scan. */
+#define PAIR_ADC_CLOCK		8000000
+
+    /*!@brief Number of scans per half of the ping-pong buffer.  At the
+     * maximum rate one half lasts 32ms, longer than a FLASH page erase, while
+     * the DMA interrupt is held off, see FlashProg.c. */
+#define PAIR_BUF_SCANS		64
+
+    /*!@brief PRS channel that starts the scans of the pair sampling. */
+#define PAIR_PRS_CH		0
+
+    /*!@brief Maximum daily energy budget in [mWh]. */
+#define MAX_ENERGY_BUDGET	1000000	// 1kWh
+
+    /*!@brief Maximum runtime threshold of a load shedding tier in [h]. */
+#define MAX_SHED_RUNTIME	1000
+
+    /*!@brief Pause in [ms] the battery controller needs between two SMBus
+     * accesses. */
+#define SHED_SMBUS_PAUSE	100
+
+    /*!@brief Maximum pause between two log flushes in load shedding [s]. */
+#define MAX_SHED_FLUSH_PAUSE	3600
+
+    /*!@brief Maximum log rate limit of a source in messages per minute. */
+#define MAX_LOG_RATE		6000
+
+    /*!@brief Maximum number of messages a source may log at once. */
+#define MAX_LOG_BURST		1000
+
+    /*!@brief Maximum key frame interval of the battery log in [h]. */
+#define MAX_BAT_LOG_KEYFRAME	(7*24)
+
+#if ENERGY_TICKS_PER_SEC != RTC_COUNTS_PER_SEC
+    #error "ENERGY_TICKS_PER_SEC must be the RTC frequency"
+#endif
+
 /*================================ Global Data ===============================*/
 
     /*!@brief CFG_VAR_TYPE_ENUM_2: Enum names for Power Outputs. */
@@ -115,8 +291,96 @@ static const PWR_OUT_DEF  l_PwrOutDef[NUM_PWR_OUT] =
 
     /*!@brief Scan duration in [ms] for one of four channels (U1,I1,U2,I2). */
 static uint32_t     l_ScanDuration = DFLT_SCAN_DURATION;
-#define MIN_SCAN_DURATION	  52	// minimum is   52ms
-#define MAX_SCAN_DURATION	2200	// maximum is 2200ms
+
+    /*!@brief Limits and confidence bound of the adaptive oversampling. */
+static ADC_OVS_CFG  l_AdcOvsCfg =
+{ DFLT_SCAN_SAMPLES_MIN, DFLT_SCAN_SAMPLES_MAX, DFLT_SCAN_CONFIDENCE };
+
+    /*!@brief Scan rate of the voltage/current pair sampling in [Hz], 0 uses
+     * the adaptive oversampling instead. */
+static uint32_t     l_ScanPairRate = DFLT_SCAN_PAIR_RATE;
+
+    /*!@brief Settle time in [ms] between switching on two power outputs. */
+static uint32_t     l_SettleTime = DFLT_POWER_SETTLE_TIME;
+
+    /*!@brief Queue of power outputs to be switched on by the sequencer. */
+static volatile PWR_OUT	l_SeqQueue[NUM_PWR_OUT];
+
+    /*!@brief Number of entries in @ref l_SeqQueue. */
+static volatile int	l_SeqCnt;
+
+    /*!@brief State of the power output sequencer. */
+static SEQ_STATE	l_Seq = { .Output = PWR_OUT_NONE };
+
+    /*!@brief Function to call when a power output has been switched on. */
+static PWR_OUT_FCT	l_PowerOutputFct;
+
+    /*!@brief Flag to request writing the calibration data, see
+     * WriteCalibrationRequest(). */
+static volatile bool	l_flgCalibWriteReq;
+
+    /*!@brief Flag to request the reset of the energy budgets, see
+     * EnergyResetAlarm(). */
+static volatile bool	l_flgEnergyResetReq;
+
+    /*!@brief Energy counters and daily budgets of UA1 and UA2. */
+static ENERGY		l_Energy[NUM_MEASURE];
+
+    /*!@brief Current state of the energy budgets, see EnergyCheck(). */
+static volatile ENERGY_STATE l_EnergyState[NUM_MEASURE];
+
+    /*!@brief RTC counter value of the previous energy sample. */
+static uint32_t		l_EnergyCnt[NUM_MEASURE];
+
+    /*!@brief Warning level of the energy budgets in [%]. */
+static uint32_t		l_EnergyWarnLevel = DFLT_ENERGY_WARN_LEVEL;
+
+    /*!@brief Thresholds and hysteresis of the load shedding tiers. */
+static SHED_CFG		l_ShedCfg;
+
+    /*!@brief Current load shedding tier, see LoadShedApply(). */
+static volatile SHED_TIER l_ShedTier = SHED_TIER_NONE;
+
+    /*!@brief Duty cycle of the RFID reader in tier 1 in [%]. */
+static uint32_t		l_ShedRFID_Duty = DFLT_SHED_RFID_DUTY;
+
+    /*!@brief Pause between two log flushes in tier 3 and above in [s]. */
+static uint32_t		l_ShedFlushPause = DFLT_SHED_FLUSH_PAUSE;
+
+    /*!@brief Default log rate limit in messages per minute, 0=no limit. */
+static uint32_t		l_LogRate = LOG_RATE_DFLT;
+
+    /*!@brief Number of messages a log source may log at once. */
+static uint32_t		l_LogBurst = LOG_BURST_DFLT;
+
+    /*!@brief Log rate limit per source, 0 means @ref l_LogRate. */
+static uint32_t		l_LogSrcRate[END_LOG_SRC];
+
+    /*!@brief Minimum changes and key frame interval of the battery log. */
+static BAT_LOG_CFG	l_BatLogCfg;
+
+    /*!@brief Name, maximum, and default of the minimum changes of the
+     * battery log, in the order of @ref BAT_VAL. */
+static const char      *l_BatLogDiffName[END_BAT_VAL] =
+			{ "CAPACITY", "RUNTIME", "VOLTAGE", "CURRENT" };
+static const uint32_t	l_BatLogDiffMax[END_BAT_VAL] =
+			{ 10000, 100, 10000, 10000 };
+static const uint32_t	l_BatLogDiffDflt[END_BAT_VAL] =
+			{ DFLT_BAT_LOG_CAPACITY_DIFF, DFLT_BAT_LOG_RUNTIME_DIFF,
+			  DFLT_BAT_LOG_VOLTAGE_DIFF, DFLT_BAT_LOG_CURRENT_DIFF };
+
+    /*!@brief Timer handle and flag for the load shedding check. */
+static TIM_HDL		l_hdlShedCheck = NONE;
+static volatile bool	l_flgShedCheck;
+
+    /*!@brief State of the battery read for the load shedding check, see
+     * LoadShedCheck(). */
+static struct
+{
+    SHED_READ	State;		//!< Next step
+    uint32_t	DelayCnt;	//!< RTC counter of the previous step
+    int		SoC;		//!< Relative state of charge in [%]
+} l_ShedRead;
 
     /*!@brief Definitions for measurements, see @ref MEASURE. */
 static MEASURE_DEF  l_MeasureDef[NUM_MEASURE] =
@@ -152,6 +416,58 @@ static uint8_t		l_ADC_ChanIdxMap[8];	// 8 external ADC Channels
      */
 static uint32_t		l_ADC_Value[NUM_MEASURE * 2];
 
+    /*!@brief RTC count of the conversion of each value in @ref l_ADC_Value,
+     * see ClockStampFromCnt().
+     */
+static volatile uint32_t l_ADC_ValueCnt[NUM_MEASURE * 2];
+
+    /*!@brief Oversampling window of each value in @ref l_ADC_Value, and the
+     * RTC count when it has been completed.  The values are published when
+     * the windows of all channels are complete, see ADC_RoundEnd().
+     */
+static ADC_OVS_WIN	l_ADC_Win[NUM_MEASURE * 2];
+static uint32_t		l_ADC_WinCnt[NUM_MEASURE * 2];
+
+    /*!@brief Bit mask of ADC channels whose window is complete. */
+static volatile uint8_t	l_ADC_DoneChanMask;
+
+    /*!@brief Bit mask of ADC channels of the running pass of the scan. */
+static volatile uint8_t	l_ADC_PassChanMask;
+
+    /*!@brief RTC count at the start of the current round. */
+static uint32_t		l_ADC_RoundCnt;
+
+    /*!@brief DMA channel of the pair sampling, allocated on first use. */
+static int		l_ADC_DmaChan = NONE;
+
+    /*!@brief Ping-pong buffer of the DMA, each scan holds the channels of
+     * @ref l_ADC_ScanChanMask in ascending order. */
+static uint16_t		l_ADC_PairBuf[2][PAIR_BUF_SCANS * NUM_MEASURE * 2];
+
+    /*!@brief Number of channels per scan, and the position of each value of
+     * @ref l_ADC_Value within a scan. */
+static uint8_t		l_ADC_PairChanCnt;
+static uint8_t		l_ADC_PairPos[NUM_MEASURE * 2];
+
+    /*!@brief Voltage/current pairs of UA1 and UA2 of the current round, and
+     * the number of pairs per round. */
+static ADC_PAIR_ACC	l_ADC_Pair[NUM_MEASURE];
+static uint32_t		l_ADC_PairTarget;
+
+    /*!@brief Mean product of voltage and current of the last round, see
+     * PowerTrue(). */
+static volatile uint32_t l_ADC_PairUI[NUM_MEASURE];
+
+    /*!@brief Flag if the ADC runs in pair sampling mode. */
+static bool		l_flgADC_Pair;
+
+    /*!@brief Highest and last current value (12bit) of each power output
+     * since the power sequencer took them, and flag if there are new values,
+     * see PowerSequencerSample(). */
+static volatile uint16_t l_ADC_PairPeakI[NUM_MEASURE];
+static volatile uint16_t l_ADC_PairLastI[NUM_MEASURE];
+static volatile bool	 l_flgADC_PairNewI;
+
     /*!@brief Previous voltage and current values */
 static uint32_t		l_prev_value_mV[NUM_MEASURE];
 static int		l_prev_BATT_mV;
@@ -178,12 +494,27 @@ static uint32_t		l_BATT_I_MinDiff;
     /*!@brief Bit mask of ADC values that have been updated, see @ref l_ADC_Value. */
 static volatile uint8_t	l_ADC_ValueUpdateMask;
 
+    /*!@brief ADC conversion that has been captured while the FLASH was busy,
+     * see ADC_Capture().
+     */
+static volatile struct
+{
+    bool	flgValid;	//!< A conversion has been captured
+    uint32_t	Status;		//!< ADC0->STATUS of the conversion
+    uint32_t	Value;		//!< ADC0->SCANDATA
+    uint32_t	Cnt;		//!< RTC count of the conversion
+} l_ADC_Capture;
+
     /*!@brief Flag if ADC should be switched on. */
 static volatile bool	l_flgADC_On;		// is false for default
 
     /*!@brief Current state of the ADC: true means ON, false means OFF. */
 static volatile bool	l_flgADC_IsOn;		// is false for default
 
+    /*!@brief The ADC is switched off between two rounds, see ADC_RoundEnd().
+     */
+static volatile bool	l_flgADC_Paused;
+
     /*!@brief Define the non-volatile variables. */
 static EE_Variable_TypeDef  magic, ua1mV_h, ua1mV_l, ua1mA_h, ua1mA_l,
 				   ua2mV_h, ua2mV_l, ua2mA_h, ua2mA_l, chksum;
@@ -233,6 +564,7 @@ static const CFG_VAR_DEF l_CfgVarList[] =
     { "BATT_OFF_TIME_3",	CFG_VAR_TYPE_TIME,	NULL		      },
     { "BATT_OFF_TIME_4",	CFG_VAR_TYPE_TIME,	NULL		      },
     { "BATT_OFF_TIME_5",	CFG_VAR_TYPE_TIME,	NULL		      },
+    { "ENERGY_RESET_TIME",	CFG_VAR_TYPE_TIME,	NULL		      },
     // Power Cycling Intervals for UA1, UA2, and BATT
     { "UA1_INTERVAL",	 CFG_VAR_TYPE_DURATION, &g_PwrInterval[PWR_OUT_UA1]   },
     { "UA1_ON_DURATION", CFG_VAR_TYPE_DURATION, &g_On_Duration[PWR_OUT_UA1]   },
@@ -247,6 +579,11 @@ static const CFG_VAR_DEF l_CfgVarList[] =
 					&g_RFID_AbsentDetectTimeout	      },
     // Measuring configuration
     { "SCAN_DURATION", CFG_VAR_TYPE_INTEGER,  &l_ScanDuration		      },
+    { "SCAN_SAMPLES_MIN",	CFG_VAR_TYPE_INTEGER,	&l_AdcOvsCfg.MinSamples },
+    { "SCAN_SAMPLES_MAX",	CFG_VAR_TYPE_INTEGER,	&l_AdcOvsCfg.MaxSamples },
+    { "SCAN_CONFIDENCE",	CFG_VAR_TYPE_INTEGER,	&l_AdcOvsCfg.Bound    },
+    { "SCAN_PAIR_RATE",		CFG_VAR_TYPE_INTEGER,	&l_ScanPairRate       },
+    { "POWER_SETTLE_TIME", CFG_VAR_TYPE_INTEGER, &l_SettleTime		      },
     { "UA1_MEASURE_FOLLOW_UP_TIME", CFG_VAR_TYPE_INTEGER,
 					&l_MeasureDef[0].FollowUpTime	      },
     { "UA1_MEASURE_U_MIN_DIFF",	CFG_VAR_TYPE_INTEGER,
@@ -266,6 +603,50 @@ static const CFG_VAR_DEF l_CfgVarList[] =
     { "UA1_CALIBRATE_mA",	CFG_VAR_TYPE_INTEGER,	&g_UA_Calib_mA[0]     },
     { "UA2_CALIBRATE_mV",	CFG_VAR_TYPE_INTEGER,	&g_UA_Calib_mV[1]     },
     { "UA2_CALIBRATE_mA",	CFG_VAR_TYPE_INTEGER,	&g_UA_Calib_mA[1]     },
+    // Daily energy budgets
+    { "UA1_ENERGY_BUDGET",	CFG_VAR_TYPE_INTEGER,	&l_Energy[0].Budget   },
+    { "UA2_ENERGY_BUDGET",	CFG_VAR_TYPE_INTEGER,	&l_Energy[1].Budget   },
+    { "ENERGY_WARN_LEVEL",	CFG_VAR_TYPE_INTEGER,	&l_EnergyWarnLevel    },
+    // Load shedding tiers
+    { "SHED_SOC_1",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.SoC[1]     },
+    { "SHED_SOC_2",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.SoC[2]     },
+    { "SHED_SOC_3",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.SoC[3]     },
+    { "SHED_SOC_4",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.SoC[4]     },
+    { "SHED_RUNTIME_1",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.RunTime[1] },
+    { "SHED_RUNTIME_2",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.RunTime[2] },
+    { "SHED_RUNTIME_3",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.RunTime[3] },
+    { "SHED_RUNTIME_4",		CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.RunTime[4] },
+    { "SHED_SOC_HYSTERESIS",	CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.SoC_Hyst   },
+    { "SHED_RUNTIME_HYSTERESIS",CFG_VAR_TYPE_INTEGER,	&l_ShedCfg.RunTimeHyst},
+    { "SHED_RFID_DUTY",		CFG_VAR_TYPE_INTEGER,	&l_ShedRFID_Duty      },
+    { "SHED_FLUSH_PAUSE",	CFG_VAR_TYPE_INTEGER,	&l_ShedFlushPause     },
+    // Log rate limit
+    { "LOG_RATE",		CFG_VAR_TYPE_INTEGER,	&l_LogRate	      },
+    { "LOG_BURST",		CFG_VAR_TYPE_INTEGER,	&l_LogBurst	      },
+    { "LOG_RATE_MAIN",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_MAIN]     },
+    { "LOG_RATE_ALARM",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_ALARM]    },
+    { "LOG_RATE_BATTERY", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_BATTERY]},
+    { "LOG_RATE_CONFIG", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_CONFIG]  },
+    { "LOG_RATE_CONTROL", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_CONTROL]},
+    { "LOG_RATE_DCF77",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_DCF77]    },
+    { "LOG_RATE_DISPLAY", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_DISPLAY]},
+    { "LOG_RATE_POWERFAIL", CFG_VAR_TYPE_INTEGER,
+					&l_LogSrcRate[LOG_SRC_POWERFAIL]      },
+    { "LOG_RATE_RFID",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_RFID]     },
+    { "LOG_RATE_SDCARD", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_SDCARD]  },
+    { "LOG_RATE_DMA",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_DMA]      },
+    { "LOG_RATE_COMMAND", CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_COMMAND]},
+    { "LOG_RATE_GNSS",	CFG_VAR_TYPE_INTEGER, &l_LogSrcRate[LOG_SRC_GNSS]     },
+    // Change-only battery log
+    { "BATTERY_LOG_CAPACITY_DIFF", CFG_VAR_TYPE_INTEGER,
+				    &l_BatLogCfg.Diff[BAT_VAL_CAPACITY]       },
+    { "BATTERY_LOG_RUNTIME_DIFF", CFG_VAR_TYPE_INTEGER,
+				    &l_BatLogCfg.Diff[BAT_VAL_RUNTIME]        },
+    { "BATTERY_LOG_VOLTAGE_DIFF", CFG_VAR_TYPE_INTEGER,
+				    &l_BatLogCfg.Diff[BAT_VAL_VOLTAGE]        },
+    { "BATTERY_LOG_CURRENT_DIFF", CFG_VAR_TYPE_INTEGER,
+				    &l_BatLogCfg.Diff[BAT_VAL_CURRENT]        },
+    { "BATTERY_LOG_KEYFRAME",	CFG_VAR_TYPE_INTEGER,	&l_BatLogCfg.KeyFrame },
     {  NULL,			END_CFG_VAR_TYPE,	NULL		      }
 };
 
@@ -286,11 +667,38 @@ static uint32_t l_dbg_ADC_ChanCnt[4];	// count normal conversions per channel
 /*=========================== Forward Declarations ===========================*/
 
 static void	AlarmPowerControl (int alarmNum);
+static void	EnergyResetAlarm (int alarmNum);
+static void	EnergyResetBudgets (void);
+static void	EnergyCheck (int m);
+static void	ShedCheckTimer (TIM_HDL hdl);
+static void	LogRateApply (void);
+static void	LoadShedCheck (void);
+static void	LoadShedApply (SHED_TIER tier);
+static bool	IsShed (PWR_OUT output);
+static int32_t	ShedInterval (PWR_OUT output);
+static int32_t	ShedOnDuration (PWR_OUT output);
 static void	IntervalPowerControl (TIM_HDL hdl);
 static void	MeasureStop (TIM_HDL hdl);
 static void	MeasureStopBATT (TIM_HDL hdl);
 static void	ADC_ScanStart (void);
 static void	ADC_ScanStop (void);
+static void	ADC_PassStart (uint8_t chanMask);
+static void	ADC_RoundStart (void);
+static void	ADC_RoundEnd (void);
+static bool	ADC_PairStart (void);
+static void	ADC_PairStop (void);
+static void	ADC_PairDone (unsigned int chan, bool primary, void *user);
+static void	ADC_PairEnd (void);
+static void	PowerSequencer (void);
+static void	PowerSequencerSample (void);
+static void	PowerOutputSwitch (PWR_OUT output, bool enable);
+static int	SeqFind (PWR_OUT output);
+static void	ADC_SingleSetup (void);
+static uint32_t	ADC_SingleRead (ADC_SingleInput_TypeDef input,
+				ADC_Ref_TypeDef ref);
+static uint32_t	ADC_ReadVDD (void);
+static FLASH_RAMFUNC bool ADC_Capture (void);
+static void	ADC_StoreValue (uint32_t status, uint32_t value, uint32_t cnt);
 static void	ReadCalibrationData(void);
 
 
@@ -308,7 +716,7 @@ int	m;
 int	chan;
 
     /* Enables the flash controller for writing. */
-    MSC_Init();
+    FlashProgInit();
 
     /* Initialize the eeprom emulator using 3 pages. */
     if ( !EE_Init(DEFAULT_NUMBER_OF_PAGES) )
@@ -386,6 +794,17 @@ int	chan;
     for (i = FIRST_POWER_ALARM;  i <= LAST_POWER_ALARM;  i++)
 	AlarmAction (i, AlarmPowerControl);
 
+    /* Daily reset of the energy budgets */
+    AlarmAction (ALARM_ENERGY_RESET, EnergyResetAlarm);
+
+    /* Periodic check of the battery for load shedding */
+    if (l_hdlShedCheck == NONE)
+    {
+	l_hdlShedCheck = sTimerCreate (ShedCheckTimer);
+	if (l_hdlShedCheck != NONE)
+	    sTimerStart (l_hdlShedCheck, SHED_CHECK_INTERVAL);
+    }
+
     /* Initialize configuration with default values */
     ClearConfiguration();
 }
@@ -403,6 +822,7 @@ int	chan;
 void	ClearConfiguration (void)
 {
 int	i;
+int8_t	hour, minute;
 
     /* Disable all power-related alarms */
     for (i = FIRST_POWER_ALARM;  i <= LAST_POWER_ALARM;  i++)
@@ -422,6 +842,11 @@ int	i;
 
     /* Set measurements values to defaults */
     l_ScanDuration = DFLT_SCAN_DURATION;
+    l_AdcOvsCfg.MinSamples = DFLT_SCAN_SAMPLES_MIN;
+    l_AdcOvsCfg.MaxSamples = DFLT_SCAN_SAMPLES_MAX;
+    l_AdcOvsCfg.Bound = DFLT_SCAN_CONFIDENCE;
+    l_ScanPairRate = DFLT_SCAN_PAIR_RATE;
+    l_SettleTime = DFLT_POWER_SETTLE_TIME;
     for (i = 0;  i < 2;  i++)
     {
 	l_MeasureDef[i].FollowUpTime = DFLT_MEASURE_FOLLOW_UP_TIME;
@@ -436,6 +861,41 @@ int	i;
     /* Clear Calibration reference values */
     for (i = 0;  i < 2;  i++)
 	g_UA_Calib_mV[i] = g_UA_Calib_mA[i] = 0;
+
+    /* No energy budgets, the energy counters continue */
+    for (i = 0;  i < NUM_MEASURE;  i++)
+	l_Energy[i].Budget = 0;
+    l_EnergyWarnLevel = DFLT_ENERGY_WARN_LEVEL;
+
+    /* Default reset time, given in MEZ like in the configuration file */
+    AlarmSet (ALARM_ENERGY_RESET, DFLT_ENERGY_RESET_TIME);
+    if (g_isdst)
+    {
+	AlarmGet (ALARM_ENERGY_RESET, &hour, &minute);
+	AlarmSet (ALARM_ENERGY_RESET, (hour + 1) % 24, minute);
+    }
+    AlarmEnable (ALARM_ENERGY_RESET);
+
+    /* No load shedding, the current tier is kept until the next check */
+    for (i = 0;  i < END_SHED_TIER;  i++)
+	l_ShedCfg.SoC[i] = l_ShedCfg.RunTime[i] = 0;
+    l_ShedCfg.SoC_Hyst = DFLT_SHED_SOC_HYSTERESIS;
+    l_ShedCfg.RunTimeHyst = DFLT_SHED_RUNTIME_HYSTERESIS;
+    l_ShedRFID_Duty = DFLT_SHED_RFID_DUTY;
+    l_ShedFlushPause = DFLT_SHED_FLUSH_PAUSE;
+
+    /* Default log rate limit for all sources */
+    l_LogRate = LOG_RATE_DFLT;
+    l_LogBurst = LOG_BURST_DFLT;
+    for (i = 0;  i < END_LOG_SRC;  i++)
+	l_LogSrcRate[i] = 0;
+    LogRateApply();
+
+    /* Default minimum changes of the battery log */
+    for (i = 0;  i < END_BAT_VAL;  i++)
+	l_BatLogCfg.Diff[i] = l_BatLogDiffDflt[i];
+    l_BatLogCfg.KeyFrame = DFLT_BAT_LOG_KEYFRAME;
+    BatteryLogConfig (&l_BatLogCfg);
 }
 
 
@@ -455,6 +915,7 @@ void	VerifyConfiguration (void)
 int	i;
 bool	error;
 int32_t	interval, duration;
+uint32_t socPrev, runTimePrev;
 
     /* Verify Power Cycle Interval */
     for (i = 0;  i < NUM_PWR_OUT;  i++)
@@ -508,6 +969,201 @@ int32_t	interval, duration;
 		  " limiting it to %dms", l_ScanDuration, MAX_SCAN_DURATION);
 	l_ScanDuration = MAX_SCAN_DURATION;
     }
+
+    /* Verify the limits and the bound of the adaptive oversampling */
+    if (l_AdcOvsCfg.MinSamples < ADC_OVS_MIN_BLOCKS * ADC_OVS_BLOCK
+    ||  l_AdcOvsCfg.MinSamples > ADC_OVS_MAX_BLOCKS * ADC_OVS_BLOCK)
+    {
+	LogError ("Config File - SCAN_SAMPLES_MIN: Value %ld is out of range"
+		  " %d to %d, using %d", l_AdcOvsCfg.MinSamples,
+		  ADC_OVS_MIN_BLOCKS * ADC_OVS_BLOCK,
+		  ADC_OVS_MAX_BLOCKS * ADC_OVS_BLOCK, DFLT_SCAN_SAMPLES_MIN);
+	l_AdcOvsCfg.MinSamples = DFLT_SCAN_SAMPLES_MIN;
+    }
+
+    if (l_AdcOvsCfg.MaxSamples < l_AdcOvsCfg.MinSamples)
+    {
+	LogError ("Config File - SCAN_SAMPLES_MAX: Value %ld is less than"
+		  " SCAN_SAMPLES_MIN, limiting it to %ld",
+		  l_AdcOvsCfg.MaxSamples, l_AdcOvsCfg.MinSamples);
+	l_AdcOvsCfg.MaxSamples = l_AdcOvsCfg.MinSamples;
+    }
+    else if (l_AdcOvsCfg.MaxSamples > ADC_OVS_MAX_BLOCKS * ADC_OVS_BLOCK)
+    {
+	LogError ("Config File - SCAN_SAMPLES_MAX: Value %ld is too large,"
+		  " limiting it to %d", l_AdcOvsCfg.MaxSamples,
+		  ADC_OVS_MAX_BLOCKS * ADC_OVS_BLOCK);
+	l_AdcOvsCfg.MaxSamples = ADC_OVS_MAX_BLOCKS * ADC_OVS_BLOCK;
+    }
+
+    if (l_AdcOvsCfg.Bound > MAX_SCAN_CONFIDENCE)
+    {
+	LogError ("Config File - SCAN_CONFIDENCE: Value %ld is out of range"
+		  " 0 to %d, using %d", l_AdcOvsCfg.Bound, MAX_SCAN_CONFIDENCE,
+		  DFLT_SCAN_CONFIDENCE);
+	l_AdcOvsCfg.Bound = DFLT_SCAN_CONFIDENCE;
+    }
+
+    if (l_ScanPairRate != 0  &&  (l_ScanPairRate < MIN_SCAN_PAIR_RATE
+				  ||  l_ScanPairRate > MAX_SCAN_PAIR_RATE))
+    {
+	LogError ("Config File - SCAN_PAIR_RATE: Value %ld is out of range"
+		  " %d to %d, pair sampling is disabled", l_ScanPairRate,
+		  MIN_SCAN_PAIR_RATE, MAX_SCAN_PAIR_RATE);
+	l_ScanPairRate = 0;
+    }
+
+    /* Verify Power Settle Time */
+    if (l_SettleTime > MAX_POWER_SETTLE_TIME)
+    {
+	LogError ("Config File - POWER_SETTLE_TIME: Settle time of %ldms is"
+		  " too long, limiting it to %dms", l_SettleTime,
+		  MAX_POWER_SETTLE_TIME);
+	l_SettleTime = MAX_POWER_SETTLE_TIME;
+    }
+
+    /* Verify Energy Budgets */
+    for (i = 0;  i < NUM_MEASURE;  i++)
+    {
+	if (l_Energy[i].Budget > MAX_ENERGY_BUDGET)
+	{
+	    LogError ("Config File - UA%d_ENERGY_BUDGET: Budget of %ldmWh is"
+		      " too large, limiting it to %dmWh", i + 1,
+		      l_Energy[i].Budget, MAX_ENERGY_BUDGET);
+	    l_Energy[i].Budget = MAX_ENERGY_BUDGET;
+	}
+    }
+
+    if (l_EnergyWarnLevel < 1  ||  l_EnergyWarnLevel > 100)
+    {
+	LogError ("Config File - ENERGY_WARN_LEVEL: Value %ld%% is out of"
+		  " range 1 to 100, using %d%%", l_EnergyWarnLevel,
+		  DFLT_ENERGY_WARN_LEVEL);
+	l_EnergyWarnLevel = DFLT_ENERGY_WARN_LEVEL;
+    }
+
+    /* A new budget may apply immediately to the energy used today */
+    for (i = 0;  i < NUM_MEASURE;  i++)
+	EnergyCheck (i);
+
+    /* Verify Load Shedding, the thresholds must decrease with the tier */
+    socPrev = 100;
+    runTimePrev = MAX_SHED_RUNTIME;
+    for (i = SHED_TIER_NONE + 1;  i < END_SHED_TIER;  i++)
+    {
+	if (l_ShedCfg.SoC[i] > socPrev)
+	{
+	    LogError ("Config File - SHED_SOC_%d: Value %ld%% is above %ld%%,"
+		      " threshold disabled", i, l_ShedCfg.SoC[i], socPrev);
+	    l_ShedCfg.SoC[i] = 0;
+	}
+	else if (l_ShedCfg.SoC[i] > 0)
+	{
+	    socPrev = l_ShedCfg.SoC[i];
+	}
+
+	if (l_ShedCfg.RunTime[i] > runTimePrev)
+	{
+	    LogError ("Config File - SHED_RUNTIME_%d: Value %ldh is above %ldh,"
+		      " threshold disabled", i, l_ShedCfg.RunTime[i],
+		      runTimePrev);
+	    l_ShedCfg.RunTime[i] = 0;
+	}
+	else if (l_ShedCfg.RunTime[i] > 0)
+	{
+	    runTimePrev = l_ShedCfg.RunTime[i];
+	}
+    }
+
+    if (l_ShedCfg.SoC_Hyst > 50)
+    {
+	LogError ("Config File - SHED_SOC_HYSTERESIS: Value %ld%% is out of"
+		  " range 0 to 50, using %d%%", l_ShedCfg.SoC_Hyst,
+		  DFLT_SHED_SOC_HYSTERESIS);
+	l_ShedCfg.SoC_Hyst = DFLT_SHED_SOC_HYSTERESIS;
+    }
+
+    if (l_ShedCfg.RunTimeHyst > 100)
+    {
+	LogError ("Config File - SHED_RUNTIME_HYSTERESIS: Value %ld%% is out of"
+		  " range 0 to 100, using %d%%", l_ShedCfg.RunTimeHyst,
+		  DFLT_SHED_RUNTIME_HYSTERESIS);
+	l_ShedCfg.RunTimeHyst = DFLT_SHED_RUNTIME_HYSTERESIS;
+    }
+
+    if (l_ShedRFID_Duty < 1  ||  l_ShedRFID_Duty > 100)
+    {
+	LogError ("Config File - SHED_RFID_DUTY: Value %ld%% is out of range"
+		  " 1 to 100, using %d%%", l_ShedRFID_Duty,
+		  DFLT_SHED_RFID_DUTY);
+	l_ShedRFID_Duty = DFLT_SHED_RFID_DUTY;
+    }
+
+    if (l_ShedFlushPause < LOG_FLUSH_PAUSE
+    ||  l_ShedFlushPause > MAX_SHED_FLUSH_PAUSE)
+    {
+	LogError ("Config File - SHED_FLUSH_PAUSE: Value %lds is out of range"
+		  " %d to %d, using %ds", l_ShedFlushPause, LOG_FLUSH_PAUSE,
+		  MAX_SHED_FLUSH_PAUSE, DFLT_SHED_FLUSH_PAUSE);
+	l_ShedFlushPause = DFLT_SHED_FLUSH_PAUSE;
+    }
+
+    /* The new values apply to the current tier, check it soon */
+    if (l_ShedTier >= SHED_TIER_FLUSH)
+	LogFlushPauseSet (l_ShedFlushPause);
+    l_flgShedCheck = true;
+
+    /* Log rate limit */
+    if (l_LogRate > MAX_LOG_RATE)
+    {
+	LogError ("Config File - LOG_RATE: Value %ld/min is out of range"
+		  " 0 to %d, using %d/min", l_LogRate, MAX_LOG_RATE,
+		  LOG_RATE_DFLT);
+	l_LogRate = LOG_RATE_DFLT;
+    }
+
+    if (l_LogBurst < 1  ||  l_LogBurst > MAX_LOG_BURST)
+    {
+	LogError ("Config File - LOG_BURST: Value %ld is out of range"
+		  " 1 to %d, using %d", l_LogBurst, MAX_LOG_BURST,
+		  LOG_BURST_DFLT);
+	l_LogBurst = LOG_BURST_DFLT;
+    }
+
+    for (i = 0;  i < END_LOG_SRC;  i++)
+    {
+	if (l_LogSrcRate[i] > MAX_LOG_RATE)
+	{
+	    LogError ("Config File - LOG_RATE_%s: Value %ld/min is out of"
+		      " range 0 to %d, using LOG_RATE", LogSourceName(i),
+		      l_LogSrcRate[i], MAX_LOG_RATE);
+	    l_LogSrcRate[i] = 0;
+	}
+    }
+    LogRateApply();
+
+    /* Change-only battery log */
+    for (i = 0;  i < END_BAT_VAL;  i++)
+    {
+	if (l_BatLogCfg.Diff[i] > l_BatLogDiffMax[i])
+	{
+	    LogError ("Config File - BATTERY_LOG_%s_DIFF: Value %ld is out of"
+		      " range 0 to %ld, using %ld", l_BatLogDiffName[i],
+		      l_BatLogCfg.Diff[i], l_BatLogDiffMax[i],
+		      l_BatLogDiffDflt[i]);
+	    l_BatLogCfg.Diff[i] = l_BatLogDiffDflt[i];
+	}
+    }
+
+    if (l_BatLogCfg.KeyFrame < 1
+    ||  l_BatLogCfg.KeyFrame > MAX_BAT_LOG_KEYFRAME)
+    {
+	LogError ("Config File - BATTERY_LOG_KEYFRAME: Value %ldh is out of"
+		  " range 1 to %d, using %dh", l_BatLogCfg.KeyFrame,
+		  MAX_BAT_LOG_KEYFRAME, DFLT_BAT_LOG_KEYFRAME);
+	l_BatLogCfg.KeyFrame = DFLT_BAT_LOG_KEYFRAME;
+    }
+    BatteryLogConfig (&l_BatLogCfg);
 }
 
 
@@ -525,17 +1181,38 @@ int	m;
 uint32_t value_mV, diff_mV;
 uint32_t value_mA, diff_mA;
 int	 batt_mV, batt_mA;
+uint32_t cnt;
+int	 chan;
 bool	flgLogUA;
+CLOCK_STAMP stamp;	// time of the conversion or battery read
 static bool	flgLogBATT = false;
 static uint32_t	delayStart;
 #define	MEASUREMENT_INTERVAL	500 // ms
 
 
+    /* Switch on the power outputs that have been requested */
+    PowerSequencer();
+
+    /* Save new calibration data */
+    if (l_flgCalibWriteReq)
+    {
+	l_flgCalibWriteReq = false;
+	WriteCalibrationData();
+    }
+
+    /* Reset the energy budgets at ENERGY_RESET_TIME */
+    if (l_flgEnergyResetReq)
+    {
+	l_flgEnergyResetReq = false;
+	EnergyResetBudgets();
+    }
+
     /* ADC control */
     if (l_flgADC_On)
     {
-	/* ADC should be switched ON */
-	if (! l_flgADC_IsOn)
+	/* ADC should be switched ON, but not while the power sequencer
+	 * takes single conversions, see PowerSequencerSample() */
+	if (! l_flgADC_IsOn  &&  l_Seq.Output == PWR_OUT_NONE)
 	{
 #ifdef LOGGING
 	    /* Generate Log Message */
@@ -550,6 +1227,12 @@ static uint32_t	delayStart;
 	    delayStart = msDelayStart();
 	    l_BATT_MeasureInterval = 0;		// this time: NO delay
 	}
+	else if (l_flgADC_Paused  &&  l_Seq.Output == PWR_OUT_NONE
+	     &&  msDelayIsDone(l_ADC_RoundCnt, l_ScanDuration * NUM_MEASURE * 2))
+	{
+	    /* Pause between two rounds is over, restart ADC Scan */
+	    ADC_ScanStart();
+	}
     }
     else
     {
@@ -574,6 +1257,24 @@ static uint32_t	delayStart;
 	/* Check if measurement of this channel is active */
 	if (Bit(l_ADC_ActiveChanMask, l_MeasureDef[m].ChanU))
 	{
+	    /*
+	     * Integrate the energy with every new pair of values.  Voltage
+	     * and current are published together, see ADC_RoundEnd() and
+	     * ADC_PairEnd().
+	     */
+	    chan = l_ADC_ChanIdxMap[l_MeasureDef[m].ChanU];
+	    if (Bit(l_ADC_ValueUpdateMask, chan))
+	    {
+		Bit(l_ADC_ValueUpdateMask, chan) = 0;
+
+		cnt = msDelayStart();
+		EnergyAddPower (&l_Energy[m], PowerTrue(PWR_OUT_UA1 + (PWR_OUT)m),
+				(cnt - l_EnergyCnt[m]) & 0xFFFFFF);
+		l_EnergyCnt[m] = cnt;
+
+		EnergyCheck (m);
+	    }
+
 	    value_mV = PowerVoltage(PWR_OUT_UA1 + (PWR_OUT)m) + 50;  // round
 	    value_mA = PowerCurrent(PWR_OUT_UA1 + (PWR_OUT)m);
 
@@ -603,9 +1304,15 @@ static uint32_t	delayStart;
 
 	    if (flgLogUA)
 	    {
-		Log ("UA%d     : %2ld.%ldV %4ldmA", m + 1,
-		     (value_mV / 1000), (value_mV % 1000) / 100,
-		     value_mA);
+		ClockStampFromCnt (&stamp, l_ADC_ValueCnt[chan]);
+		if (l_ScanPairRate > 0)
+		    LogAt (&stamp, "UA%d     : %2ld.%ldV %4ldmA %5ldmW", m + 1,
+			 (value_mV / 1000), (value_mV % 1000) / 100,
+			 value_mA, PowerTrue(PWR_OUT_UA1 + (PWR_OUT)m) / 1000);
+		else
+		    LogAt (&stamp, "UA%d     : %2ld.%ldV %4ldmA", m + 1,
+			 (value_mV / 1000), (value_mV % 1000) / 100,
+			 value_mA);
 		flgLogBATT =  true;	// also log Battery input data
 	    }
 	}
@@ -624,6 +1331,7 @@ static uint32_t	delayStart;
 	l_BATT_MeasureInterval = MEASUREMENT_INTERVAL;
 
 	/* get data from battery controller */
+	ClockStamp (&stamp);
 	batt_mV = BatteryRegReadWord (SBS_Voltage);
 	msDelay(100);		// to prevent hang-up of battery controller
 	batt_mA = BatteryRegReadWord (SBS_BatteryCurrent);
@@ -657,15 +1365,18 @@ static uint32_t	delayStart;
 	if (flgLogBATT)
 	{
 	    if (batt_mV < 0  &&  batt_mA < 0)
-		Log ("BATT_INP: Battery Controller Read Error");
+		LogAt (&stamp, "BATT_INP: Battery Controller Read Error");
 	    else
-		Log ("BATT_INP: %2d.%dV %4dmA",
+		LogAt (&stamp, "BATT_INP: %2d.%dV %4dmA",
 		     (batt_mV / 1000), (batt_mV % 1000) / 100, batt_mA);
 	}
 
 	/* finally clear the flag for the next run */
 	flgLogBATT = false;
     }
+
+    /* Check the battery for load shedding */
+    LoadShedCheck();
 }
 
 
@@ -676,8 +1387,14 @@ static uint32_t	delayStart;
  * This routine must be called to inform the control module about a new
  * transponder ID.
  *
+ * @param[in] transponderID
+ *	Transponder ID as hex string.
+ *
+ * @param[in] pStamp
+ *	Time when the ID has been received, see ClockStamp().
+ *
  ******************************************************************************/
-void	ControlUpdateID (char *transponderID)
+void	ControlUpdateID (char *transponderID, const CLOCK_STAMP *pStamp)
 {
 char	 line[120];
 char	*pStr;
@@ -722,7 +1439,7 @@ ID_PARM	*pID;
     }
 
 #ifdef LOGGING
-    Log (line);
+    LogAt (pStamp, line);
 #endif
 }
 
@@ -754,7 +1471,14 @@ int	i;
  *
  * @brief	Switch the specified power output on or off
  *
- * This routine enables or disables the specified power output.
+ * This routine enables or disables the specified power output.  Disabling
+ * is done immediately.  Enable requests are queued and executed by
+ * PowerSequencer(), which is called from the main loop, so several loads
+ * that are switched on at the same time are spaced by the settle time.
+ * The output is therefore not on yet when this routine returns, a caller
+ * that depends on the power can install a function to be notified via
+ * PowerOutputFctInstall().
+ * This routine may be called in interrupt context.
  *
  * @param[in] output
  *	Power output to be changed.
@@ -766,7 +1490,7 @@ int	i;
  *****************************************************************************/
 void	PowerOutput (PWR_OUT output, bool enable)
 {
-int	m;
+int	i;
 
     /* No power enable if Power Fail is active */
     if (enable  &&  IsPowerFail())
@@ -786,6 +1510,72 @@ int	m;
 	return;
     }
 
+    /* No power enable if the daily energy budget is used up */
+    i = l_PwrOutDef[output].Measure;
+    if (enable  &&  i != MEASURE_NONE  &&  l_EnergyState[i] == ENERGY_CUT_OFF)
+	return;
+
+    /* No power enable if the output is shed to save the battery */
+    if (enable  &&  IsShed (output))
+	return;
+
+    INT_Disable();
+    i = SeqFind (output);
+    if (enable)
+    {
+	/* Queue request, if output is neither on nor already queued */
+	if (i < 0  &&  ! *l_PwrOutDef[output].BitBandAddr)
+	    l_SeqQueue[l_SeqCnt++] = output;
+	INT_Enable();
+
+	g_flgIRQ = true;	// keep on running
+	return;
+    }
+
+    /* Cancel a pending enable request */
+    if (i >= 0)
+    {
+	for ( ;  i < l_SeqCnt - 1;  i++)
+	    l_SeqQueue[i] = l_SeqQueue[i + 1];
+	l_SeqCnt--;
+    }
+    INT_Enable();
+
+    PowerOutputSwitch (output, PWR_OFF);
+}
+
+
+/******************************************************************************
+ *
+ * @brief	Install a function to be notified about a power output
+ *
+ * The specified function is called by PowerSequencer() in the context of the
+ * main loop, when a power output has been switched on and its inrush current
+ * has settled.  It receives the power output as parameter.  Only one function
+ * can be installed, NULL removes it.
+ *
+ * @param[in] function
+ *	Function to be called, or NULL.
+ *
+ *****************************************************************************/
+void	PowerOutputFctInstall (PWR_OUT_FCT function)
+{
+    l_PowerOutputFct = function;
+}
+
+
+/******************************************************************************
+ *
+ * @brief	Set the power output pin and measuring facility
+ *
+ * This routine does the actual switching of a power output for
+ * PowerOutput() and PowerSequencer().
+ *
+ *****************************************************************************/
+static void	PowerOutputSwitch (PWR_OUT output, bool enable)
+{
+int	m, chan;
+
     /* See if Power Output is already in the right state */
     if ((bool)*l_PwrOutDef[output].BitBandAddr == enable)
 	return;		// Yes - nothing to be done
@@ -819,6 +1609,12 @@ int	m;
 	    /* Invalidate previous voltage and current value */
 	    l_prev_value_mV[m] = l_prev_value_mA[m] = 0;
 
+	    /* The first new pair of values counts from now on */
+	    chan = l_ADC_ChanIdxMap[l_MeasureDef[m].ChanU];
+	    Bit(l_ADC_ValueUpdateMask, chan) = 0;
+	    l_EnergyCnt[m] = msDelayStart();
+	    EnergyStart (&l_Energy[m]);
+
 	    /* Set flag to set up and start ADC */
 	    l_flgADC_On = true;
 
@@ -863,7 +1659,8 @@ int	m;
  *
  * @brief	Determine if the specified power output is switched on
  *
- * This routine determines the current state of a power output.
+ * This routine determines the current state of a power output.  An output
+ * that is queued to be switched on by the sequencer is reported as on.
  *
  * @param[in] output
  *	Power output to be checked.
@@ -878,48 +1675,262 @@ bool	IsPowerOutputOn (PWR_OUT output)
     EFM_ASSERT (PWR_OUT_UA1 <= output  &&  output <= PWR_OUT_BATT);
 
     /* Determine the current state of this power output */
-    return (*l_PwrOutDef[output].BitBandAddr ? true : false);
+    return (*l_PwrOutDef[output].BitBandAddr  ||  SeqFind (output) >= 0);
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Alarm routine for Power Control
+ * @brief	Power Output Sequencer
  *
- * This routine is called when one of the power alarm times has been reached.
- * The alarm number is an enum value between @ref FIRST_POWER_ALARM and
- * @ref LAST_POWER_ALARM.<br>
- * When an RFID reader has been installed, the function decides whether to
- * call RFID_Enable(), RFID_Disable(), or PowerOutput() directly.
+ * This state machine is executed by Control() to switch on the power outputs
+ * that have been queued by PowerOutput(), one after another.  After an
+ * output has been switched on, the next one waits at least @ref l_SettleTime
+ * milliseconds.  For UA1 and UA2 the current of the new load is sampled, and
+ * the waiting time is extended while the inrush current still changes by
+ * more than the I_MIN_DIFF of this output, up to @ref SEQ_MAX_SETTLE_FACTOR
+ * times the settle time.  When an output has settled, the function installed
+ * by PowerOutputFctInstall() is called.
+ *
+ * The routine never waits.  While an output settles, it keeps the main loop
+ * running, so it is called again, and the other tasks are not delayed.  The
+ * ADC is shared with the scan: samples are only taken between two rounds,
+ * and Control() defers the next round until the output has settled.
+ *
+ * During the sequence, the supply voltage VDD is sampled as well, and its
+ * minimum is logged together with the peak inrush current.  A settle time
+ * of 0 switches all pending outputs back to back and only observes VDD for
+ * @ref SEQ_MONITOR_MS, so the voltage drop can be compared with and without
+ * sequencing.
  *
  ******************************************************************************/
-static void	AlarmPowerControl (int alarmNum)
+static void	PowerSequencer (void)
 {
-PWR_OUT	 pwrOut;
-int	 pwrState;
-
-    /* Parameter check */
-    EFM_ASSERT (FIRST_POWER_ALARM <= alarmNum && alarmNum <= LAST_POWER_ALARM);
+PWR_OUT	 output;
+uint32_t settleMs;
+int	 i;
 
-    /* Determine switching state */
-    pwrState = (alarmNum >= ALARM_UA1_OFF_TIME_1 ? PWR_OFF : PWR_ON);
 
-    /* Determine Power Output */
-    if (alarmNum >= ALARM_BATT_OFF_TIME_1)
-    {
-	pwrOut = PWR_OUT_BATT;
-    }
-    else if (alarmNum >= ALARM_UA2_OFF_TIME_1)
+    if (! l_Seq.Active)
     {
-	pwrOut = PWR_OUT_UA2;
+	if (l_SeqCnt == 0)
+	    return;			// no outputs to be switched on
+
+	/* Start a new sequence */
+	l_Seq.Active	= true;
+	l_Seq.Output	= PWR_OUT_NONE;
+	l_Seq.StartCnt	= msDelayStart();
+	l_Seq.Peak_mA	= 0;
+	l_Seq.MinVDD_mV	= 0;		// no sample yet
+	l_Seq.Count	= 0;
     }
-    else if (alarmNum >= ALARM_UA1_OFF_TIME_1)
+
+    /* Wait until the inrush current of the current output is over */
+    output = l_Seq.Output;
+    if (output != PWR_OUT_NONE)
     {
-	pwrOut = PWR_OUT_UA1;
+	if (*l_PwrOutDef[output].BitBandAddr  &&  ! IsPowerFail())
+	{
+	    if (msDelayIsDone (l_Seq.SampleCnt, SEQ_POLL_MS))
+		PowerSequencerSample();
+
+	    settleMs = (l_SettleTime > 0 ? l_SettleTime : SEQ_MONITOR_MS);
+	    if (! msDelayIsDone (l_Seq.SwitchCnt, settleMs)
+	    ||  (! l_Seq.Settled
+		 &&  ! msDelayIsDone (l_Seq.SwitchCnt,
+				      settleMs * SEQ_MAX_SETTLE_FACTOR)))
+	    {
+		g_flgIRQ = true;	// keep on running
+		return;
+	    }
+
+	    /* Output is on and has settled */
+	    l_Seq.Output = PWR_OUT_NONE;
+	    if (l_PowerOutputFct)
+		l_PowerOutputFct (output);
+	}
+	else
+	{
+	    l_Seq.Output = PWR_OUT_NONE;	// has been switched off again
+	}
     }
-    else if (alarmNum >= ALARM_BATT_ON_TIME_1)
+
+    /* Switch on the next output */
+    while (l_SeqCnt > 0)
     {
-	pwrOut = PWR_OUT_BATT;
+	/* Take the next output from the queue */
+	INT_Disable();
+	output = l_SeqQueue[0];
+	for (i = 0;  i < l_SeqCnt - 1;  i++)
+	    l_SeqQueue[i] = l_SeqQueue[i + 1];
+	l_SeqCnt--;
+	INT_Enable();
+
+	if (IsPowerFail())
+	    continue;		// discard request
+
+	PowerOutputSwitch (output, PWR_ON);
+	l_Seq.Count++;
+
+	/* Without sequencing, switch the next output immediately */
+	if (l_SettleTime == 0  &&  l_SeqCnt > 0)
+	{
+	    if (l_PowerOutputFct)
+		l_PowerOutputFct (output);
+	    continue;
+	}
+
+	/* Observe this output, see above */
+	l_Seq.Output	= output;
+	l_Seq.Settled	= true;		// until a sample shows a change
+	l_Seq.Prev_mA	= 0;
+	l_Seq.SwitchCnt	= msDelayStart();
+	l_Seq.SampleCnt	= l_Seq.SwitchCnt;
+
+	/* Discard values of the pair sampling from before the switch */
+	INT_Disable();
+	for (i = 0;  i < NUM_MEASURE;  i++)
+	    l_ADC_PairPeakI[i] = 0;
+	l_flgADC_PairNewI = false;
+	INT_Enable();
+
+	PowerSequencerSample();
+
+	g_flgIRQ = true;	// keep on running
+	return;
+    }
+
+    /* All outputs have been switched on, the sequence is complete */
+    l_Seq.Active = false;
+
+#ifdef LOGGING
+    settleMs = (msDelayStart() - l_Seq.StartCnt) & 0xFFFFFF;
+    if (l_Seq.MinVDD_mV > 0)
+	Log ("Power Sequencing: %d output(s) in %ldms, settle %ldms,"
+	     " inrush %ldmA, min. VDD %ldmV", l_Seq.Count,
+	     settleMs * 1000 / RTC_COUNTS_PER_SEC, l_SettleTime,
+	     l_Seq.Peak_mA, l_Seq.MinVDD_mV);
+    else	// pair sampling, VDD is not measured
+	Log ("Power Sequencing: %d output(s) in %ldms, settle %ldms,"
+	     " inrush %ldmA, VDD not measured", l_Seq.Count,
+	     settleMs * 1000 / RTC_COUNTS_PER_SEC, l_SettleTime,
+	     l_Seq.Peak_mA);
+#endif
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Sample VDD and the Inrush Current for the Power Sequencer
+ *
+ * This routine takes single conversions of VDD and of the current of the
+ * output that is currently settling, see PowerSequencer().  The adaptive
+ * oversampling has priority, i.e. while a round is in progress no sample is
+ * taken.
+ *
+ * The pair sampling is never paused.  While it runs, the current is taken
+ * from its DMA buffers instead, see ADC_PairDone(): the highest value as
+ * inrush current, and the last one to check if the output has settled.  A
+ * new sample is available with every half of the ping-pong buffer, i.e. every
+ * @ref PAIR_BUF_SCANS / SCAN_PAIR_RATE seconds.  VDD is not part of the scan,
+ * so the minimum VDD is not measured then.
+ *
+ ******************************************************************************/
+static void	PowerSequencerSample (void)
+{
+uint32_t value, peak, curr_mA;
+int	 m;
+
+
+    m = l_PwrOutDef[l_Seq.Output].Measure;
+
+    if (l_flgADC_IsOn  &&  ! l_flgADC_Paused)
+    {
+	/* The ADC is in use by the adaptive oversampling */
+	if (! l_flgADC_Pair  ||  m == MEASURE_NONE  ||  ! l_flgADC_PairNewI)
+	    return;
+
+	/* Take the values of the pair sampling */
+	l_Seq.SampleCnt = msDelayStart();
+	INT_Disable();
+	peak  = l_ADC_PairPeakI[m];
+	value = l_ADC_PairLastI[m];
+	l_ADC_PairPeakI[m] = 0;
+	l_flgADC_PairNewI = false;
+	INT_Enable();
+    }
+    else
+    {
+	l_Seq.SampleCnt = msDelayStart();
+	ADC_SingleSetup();
+
+	value = ADC_ReadVDD();
+	if (l_Seq.MinVDD_mV == 0  ||  value < l_Seq.MinVDD_mV)
+	    l_Seq.MinVDD_mV = value;
+
+	/* 12bit single conversion */
+	if (m != MEASURE_NONE)
+	    value = peak = ADC_SingleRead (l_MeasureDef[m].ChanI, adcRef2V5);
+
+	/* Switch the ADC off again */
+	ADC_Reset(ADC0);
+	CMU_ClockEnable(cmuClock_ADC0, false);
+    }
+
+    if (m != MEASURE_NONE)
+    {
+	/* Scale 12bit values to 16bit oversampling */
+	curr_mA = (peak << 20) / l_mA_Divider[m];
+	if (curr_mA > l_Seq.Peak_mA)
+	    l_Seq.Peak_mA = curr_mA;
+
+	curr_mA = (value << 20) / l_mA_Divider[m];
+	value = (curr_mA > l_Seq.Prev_mA ? curr_mA - l_Seq.Prev_mA
+					 : l_Seq.Prev_mA - curr_mA);
+	l_Seq.Settled = (value < l_MeasureDef[m].I_MinDiff);
+	l_Seq.Prev_mA = curr_mA;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Alarm routine for Power Control
+ *
+ * This routine is called when one of the power alarm times has been reached.
+ * The alarm number is an enum value between @ref FIRST_POWER_ALARM and
+ * @ref LAST_POWER_ALARM.<br>
+ * When an RFID reader has been installed, the function decides whether to
+ * call RFID_Enable(), RFID_Disable(), or PowerOutput() directly.
+ *
+ ******************************************************************************/
+static void	AlarmPowerControl (int alarmNum)
+{
+PWR_OUT	 pwrOut;
+int	 pwrState;
+
+    /* Parameter check */
+    EFM_ASSERT (FIRST_POWER_ALARM <= alarmNum && alarmNum <= LAST_POWER_ALARM);
+
+    /* Determine switching state */
+    pwrState = (alarmNum >= ALARM_UA1_OFF_TIME_1 ? PWR_OFF : PWR_ON);
+
+    /* Determine Power Output */
+    if (alarmNum >= ALARM_BATT_OFF_TIME_1)
+    {
+	pwrOut = PWR_OUT_BATT;
+    }
+    else if (alarmNum >= ALARM_UA2_OFF_TIME_1)
+    {
+	pwrOut = PWR_OUT_UA2;
+    }
+    else if (alarmNum >= ALARM_UA1_OFF_TIME_1)
+    {
+	pwrOut = PWR_OUT_UA1;
+    }
+    else if (alarmNum >= ALARM_BATT_ON_TIME_1)
+    {
+	pwrOut = PWR_OUT_BATT;
     }
     else if (alarmNum >= ALARM_UA2_ON_TIME_1)
     {
@@ -937,8 +1948,11 @@ int	 pwrState;
     }
     else
     {   // start new power interval
-	if (g_On_Duration[pwrOut] >= MIN_VAL_ON_DURATION)
-	    sTimerStart(l_hdlPwrInterval[pwrOut], g_On_Duration[pwrOut]);
+	if (IsShed (pwrOut))
+	    return;			// output is shed to save the battery
+
+	if (ShedOnDuration(pwrOut) >= MIN_VAL_ON_DURATION)
+	    sTimerStart(l_hdlPwrInterval[pwrOut], ShedOnDuration(pwrOut));
     }
 
     /* See if this Power Output is used by the RFID reader */
@@ -998,7 +2012,7 @@ int	 pwrState;
     }
 
     /* Check of Power Cycling is active for this Output */
-    if (g_PwrInterval[pwrOut] < MIN_VAL_INTERVAL)
+    if (ShedInterval(pwrOut) < MIN_VAL_INTERVAL  ||  IsShed (pwrOut))
 	return;		// No - immediately return
 
     /* Determine switching state and change phase */
@@ -1007,13 +2021,13 @@ int	 pwrState;
 	// Power is currently ON - switch it OFF for a while
 	pwrState = PWR_OFF;
 	sTimerStart(l_hdlPwrInterval[pwrOut],
-		    g_PwrInterval[pwrOut] - g_On_Duration[pwrOut]);
+		    ShedInterval(pwrOut) - ShedOnDuration(pwrOut));
     }
     else
     {
 	// Power is currently OFF - switch it ON for a while
 	pwrState = PWR_ON;
-	sTimerStart(l_hdlPwrInterval[pwrOut], g_On_Duration[pwrOut]);
+	sTimerStart(l_hdlPwrInterval[pwrOut], ShedOnDuration(pwrOut));
     }
 
     /* See if this Power Output is used by the RFID reader */
@@ -1025,181 +2039,1015 @@ int	 pwrState;
 	else
 	    RFID_Disable();
     }
-    else
+    else
+    {
+	/* Standard Power Output - call PowerOutput() directly */
+	PowerOutput (pwrOut, pwrState);
+    }
+
+    g_flgIRQ = true;	// keep on running
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Stop measuring of UA1 or UA2 power output
+ *
+ * This routine is called after @ref FollowUpTime seconds are over to disable
+ * further measuring of a dedicated power output.
+ *
+ * @warning
+ * 	This function is called in interrupt context!
+ *
+ ******************************************************************************/
+static void	MeasureStop (TIM_HDL hdl)
+{
+int	m;
+
+    /* Find the right measuring facility */
+    for (m = 0;  m < NUM_MEASURE;  m++)
+	if (l_MeasureDef[m].hdlFollowUpTime == hdl)
+	    break;
+
+    if (m >= NUM_MEASURE)
+	return;		// timer handle not found - ignore
+
+    /* Remove associated channels from bit mask */
+    Bit(l_ADC_ActiveChanMask, l_MeasureDef[m].ChanU) = 0;
+    Bit(l_ADC_ActiveChanMask, l_MeasureDef[m].ChanI) = 0;
+
+    /* Stop ADC if there are no more channels to read */
+    if (l_ADC_ActiveChanMask == 0)
+    {
+	/* Clear flag to stop ADC */
+	l_flgADC_On = false;
+
+	g_flgIRQ = true;	// keep on running
+    }
+
+    /* Disable measuring facility */
+    *l_MeasureDef[m].BitBandAddr = 0;
+
+    /* Do not integrate the energy until measuring is started again */
+    EnergyPause (&l_Energy[m]);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Stop measuring of a dedicated power output
+ *
+ * This routine is called after @ref l_BATT_FollowUpTime seconds are over to
+ * disable further measuring of BATT_INP (via battery controller).
+ *
+ * @warning
+ * 	This function is called in interrupt context!
+ *
+ ******************************************************************************/
+static void	MeasureStopBATT (TIM_HDL hdl)
+{
+    (void) hdl;		// suppress compiler warning "unused parameter"
+
+    /* Reset flag */
+    l_flgLogBATT = false;
+
+#ifdef LOGGING
+    Log ("BATT_INP: Measuring stopped");
+#endif
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check the Energy Budget of UA1 or UA2
+ *
+ * This routine compares the energy used by a power output with its daily
+ * budget, and logs when the state changes.  When the budget is used up, the
+ * output is switched off, and PowerOutput() refuses to switch it on again
+ * until the energy counters are reset by EnergyResetBudgets(), or a new
+ * configuration raises the budget.
+ *
+ * @param[in] m
+ *	Index of the measuring facility, see @ref MEASURE.
+ *
+ ******************************************************************************/
+static void	EnergyCheck (int m)
+{
+ENERGY_STATE state, prevState;
+PWR_OUT	 pwrOut;
+int8_t	 hour, minute;
+
+
+    state = EnergyState (&l_Energy[m], l_EnergyWarnLevel);
+    prevState = l_EnergyState[m];
+    if (state == prevState)
+	return;
+
+    l_EnergyState[m] = state;
+
+    /* Find the power output of this measuring facility */
+    for (pwrOut = PWR_OUT_UA1;  pwrOut < NUM_PWR_OUT;  pwrOut++)
+	if (l_PwrOutDef[pwrOut].Measure == (MEASURE)m)
+	    break;
+
+    if (state == ENERGY_CUT_OFF)
+    {
+	AlarmGet (ALARM_ENERGY_RESET, &hour, &minute);
+	LogError ("%s: Daily energy budget of %ldmWh is used up, output is"
+		  " disabled until %02d:%02d", g_enum_PowerOutput[pwrOut],
+		  l_Energy[m].Budget, hour, minute);
+
+	/* Switch output off, in the same way as AlarmPowerControl() */
+	sTimerCancel (l_hdlPwrInterval[pwrOut]);
+	if (pwrOut == g_RFID_Power)
+	    RFID_Disable();
+	else
+	    PowerOutput (pwrOut, PWR_OFF);
+    }
+    else if (prevState == ENERGY_CUT_OFF)
+    {
+#ifdef LOGGING
+	Log ("%s: Energy budget is available again, %ldmWh of %ldmWh used",
+	     g_enum_PowerOutput[pwrOut], EnergyUsed(&l_Energy[m]),
+	     l_Energy[m].Budget);
+#endif
+    }
+    else if (state == ENERGY_WARN)
+    {
+#ifdef LOGGING
+	Log ("%s: WARNING - %ldmWh of the daily energy budget of %ldmWh used",
+	     g_enum_PowerOutput[pwrOut], EnergyUsed(&l_Energy[m]),
+	     l_Energy[m].Budget);
+#endif
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Alarm routine to reset the Energy Budgets
+ *
+ * This routine is called at @ref ENERGY_RESET_TIME.  It sets a flag for
+ * EnergyResetBudgets(), because the counters are integrated, and the power
+ * outputs are switched, by Control() in the main loop.
+ *
+ * @warning
+ * 	This function is called in interrupt context!
+ *
+ ******************************************************************************/
+static void	EnergyResetAlarm (int alarmNum)
+{
+    (void) alarmNum;	// suppress compiler warning "unused parameter"
+
+    l_flgEnergyResetReq = true;
+    g_flgIRQ = true;	// Control() should process the request
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Reset the Energy Budgets
+ *
+ * This routine is called by Control() after EnergyResetAlarm().  It logs the
+ * energy used by UA1 and UA2 since the last reset, and clears the counters.
+ * If an output has been cut off, CheckAlarmTimes() switches it on again if
+ * this is within its on-times.
+ *
+ ******************************************************************************/
+static void	EnergyResetBudgets (void)
+{
+bool	flgCutOff = false;
+int	m;
+
+
+    for (m = 0;  m < NUM_MEASURE;  m++)
+    {
+#ifdef LOGGING
+	if (l_Energy[m].Used > 0  ||  l_Energy[m].Budget > 0)
+	    Log ("UA%d: %ldmWh used since last reset, budget %ldmWh", m + 1,
+		 EnergyUsed(&l_Energy[m]), l_Energy[m].Budget);
+#endif
+	if (l_EnergyState[m] == ENERGY_CUT_OFF)
+	    flgCutOff = true;
+
+	EnergyReset (&l_Energy[m]);
+	l_EnergyState[m] = ENERGY_OK;
+    }
+
+    /* Release outputs that have been cut off */
+    if (flgCutOff)
+	CheckAlarmTimes();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Timer routine for the Load Shedding Check
+ *
+ * This routine is called every @ref SHED_CHECK_INTERVAL seconds.  It sets a
+ * flag for LoadShedCheck(), because the battery controller must not be read
+ * in interrupt context.
+ *
+ ******************************************************************************/
+static void	ShedCheckTimer (TIM_HDL hdl)
+{
+    (void) hdl;		// suppress compiler warning "unused parameter"
+
+    /* Restart the timer */
+    if (l_hdlShedCheck != NONE)
+	sTimerStart (l_hdlShedCheck, SHED_CHECK_INTERVAL);
+
+    l_flgShedCheck = true;
+
+    g_flgIRQ = true;	// keep on running
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Apply the Log Rate Limit
+ *
+ * This routine passes the rate limit of every log source to LogRateSet().
+ * A source without its own LOG_RATE_\<source\> uses @ref l_LogRate, except
+ * the sources of the measured data and of the commands: RFID, BATTERY,
+ * CONTROL, and COMMAND.  Their messages are the purpose of the logger, so
+ * they are only limited if LOG_RATE_\<source\> is set for them.  All
+ * sources share the burst size @ref l_LogBurst.
+ *
+ ******************************************************************************/
+static void	LogRateApply (void)
+{
+uint32_t rate;
+int	 i;
+
+
+    for (i = 0;  i < END_LOG_SRC;  i++)
+    {
+	if (l_LogSrcRate[i] > 0)
+	    rate = l_LogSrcRate[i];
+	else if (i == LOG_SRC_RFID  ||  i == LOG_SRC_BATTERY
+	     ||  i == LOG_SRC_CONTROL  ||  i == LOG_SRC_COMMAND)
+	    rate = 0;			// data and commands: opt-in only
+	else
+	    rate = l_LogRate;
+
+	LogRateSet ((LOG_SRC)i, rate, l_LogBurst);
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check the Battery for Load Shedding
+ *
+ * This routine is called by Control().  When the check is due, it reads the
+ * relative state of charge and the runtime to empty from the battery
+ * controller, and lets LoadShedTier() determine the tier.  The battery
+ * controller is not read if no thresholds are configured.
+ *
+ * The battery controller needs a pause of @ref SHED_SMBUS_PAUSE before each
+ * read.  The routine is a state machine, see @ref l_ShedRead, so the main
+ * loop is not blocked during the pauses.
+ *
+ ******************************************************************************/
+static void	LoadShedCheck (void)
+{
+SHED_TIER tier;
+int	 soc, runTime, i;
+
+
+    switch (l_ShedRead.State)
+    {
+	case SHED_READ_IDLE:
+	default:
+	    if (! l_flgShedCheck)
+		return;
+
+	    l_flgShedCheck = false;
+
+	    if (IsPowerFail())
+		return;
+
+	    /* Nothing to do if load shedding is not configured */
+	    if (l_ShedTier == SHED_TIER_NONE)
+	    {
+		for (i = SHED_TIER_NONE + 1;  i < END_SHED_TIER;  i++)
+		    if (l_ShedCfg.SoC[i] > 0  ||  l_ShedCfg.RunTime[i] > 0)
+			break;
+
+		if (i >= END_SHED_TIER)
+		    return;
+	    }
+
+	    l_ShedRead.State = SHED_READ_SOC;
+	    l_ShedRead.DelayCnt = msDelayStart();
+	    g_flgIRQ = true;	// keep on running
+	    return;
+
+	case SHED_READ_SOC:
+	    if (! msDelayIsDone (l_ShedRead.DelayCnt, SHED_SMBUS_PAUSE))
+	    {
+		g_flgIRQ = true;	// keep on running
+		return;
+	    }
+	    l_ShedRead.SoC = BatteryRegReadWord (SBS_RelativeStateOfCharge);
+	    l_ShedRead.State = SHED_READ_RUNTIME;
+	    l_ShedRead.DelayCnt = msDelayStart();
+	    g_flgIRQ = true;	// keep on running
+	    return;
+
+	case SHED_READ_RUNTIME:
+	    if (! msDelayIsDone (l_ShedRead.DelayCnt, SHED_SMBUS_PAUSE))
+	    {
+		g_flgIRQ = true;	// keep on running
+		return;
+	    }
+	    l_ShedRead.State = SHED_READ_IDLE;
+	    break;
+    }
+
+    if (IsPowerFail())
+	return;
+
+    soc = l_ShedRead.SoC;
+    runTime = BatteryRegReadWord (SBS_RunTimeToEmpty);
+
+    if (soc < 0  ||  runTime < 0)
+    {
+#ifdef LOGGING
+	Log ("Load Shedding: Battery Controller Read Error");
+#endif
+	return;			// keep the current tier
+    }
+
+    tier = LoadShedTier (&l_ShedCfg, l_ShedTier, soc, runTime);
+    if (tier == l_ShedTier)
+	return;
+
+#ifdef LOGGING
+    if (runTime == SHED_RUNTIME_INFINITE)
+	Log ("Load Shedding: Tier %d (%s) -> %d (%s), SoC %d%%, not"
+	     " discharging", l_ShedTier, LoadShedName(l_ShedTier), tier,
+	     LoadShedName(tier), soc);
+    else
+	Log ("Load Shedding: Tier %d (%s) -> %d (%s), SoC %d%%, runtime"
+	     " %dh%02dm", l_ShedTier, LoadShedName(l_ShedTier), tier,
+	     LoadShedName(tier), soc, runTime / 60, runTime % 60);
+#endif
+
+    LoadShedApply (tier);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Apply a Load Shedding Tier
+ *
+ * This routine carries out the actions of a new tier:
+ * - Tier 1 and above: ShedOnDuration() reduces the on-duration of the RFID
+ *   reader to @ref l_ShedRFID_Duty.  If the reader is on, its power cycle is
+ *   started now.
+ * - Tier 2 and above: All other power outputs are switched off, and
+ *   PowerOutput() refuses to switch them on, see IsShed().
+ * - Tier 3 and above: The pause between two log flushes is extended to
+ *   @ref l_ShedFlushPause.
+ * - Tier 4: The RFID reader is switched off, too.
+ *
+ * When the tier decreases, CheckAlarmTimes() switches the outputs that are
+ * released again according to their on-times.
+ *
+ * @param[in] tier
+ *	New tier.
+ *
+ ******************************************************************************/
+static void	LoadShedApply (SHED_TIER tier)
+{
+SHED_TIER prevTier = l_ShedTier;
+PWR_OUT	 pwrOut;
+
+
+    l_ShedTier = tier;
+
+    LogFlushPauseSet (tier >= SHED_TIER_FLUSH ? l_ShedFlushPause : 0);
+
+    if (tier < prevTier)
+    {
+	/* Release outputs, the RFID power cycle restarts with the on-time */
+	CheckAlarmTimes();
+	return;
+    }
+
+    /* Switch off outputs, in the same way as AlarmPowerControl() */
+    for (pwrOut = PWR_OUT_UA1;  pwrOut < NUM_PWR_OUT;  pwrOut++)
+    {
+	if (! IsShed (pwrOut))
+	    continue;
+
+	sTimerCancel (l_hdlPwrInterval[pwrOut]);
+	if (pwrOut == g_RFID_Power)
+	    RFID_Disable();
+	else
+	    PowerOutput (pwrOut, PWR_OFF);
+    }
+
+    /* Start the power cycle of the RFID reader with the reduced duty */
+    if (prevTier < SHED_TIER_RFID  &&  g_RFID_Power != PWR_OUT_NONE
+    &&  ! IsShed (g_RFID_Power)  &&  IsRFID_Enabled())
+	sTimerStart (l_hdlPwrInterval[g_RFID_Power],
+		     ShedOnDuration(g_RFID_Power));
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Power Output is Shed
+ *
+ * @param[in] output
+ *	Power output to be checked.
+ *
+ * @return
+ *	<i>true</i> if the output must be off in the current load shedding
+ *	tier.  From tier 2 on, these are all outputs except the one of the RFID
+ *	reader, in tier 4 also the RFID reader.
+ *
+ ******************************************************************************/
+static bool	IsShed (PWR_OUT output)
+{
+    if (output == PWR_OUT_NONE)
+	return false;
+
+    if (l_ShedTier >= SHED_TIER_MINIMAL)
+	return true;
+
+    return (l_ShedTier >= SHED_TIER_CAMERA  &&  output != g_RFID_Power);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Power Cycle Interval of an Output
+ *
+ * @param[in] output
+ *	Power output.
+ *
+ * @return
+ *	The configured power cycle interval in [s].  In load shedding tier 1
+ *	and above, the RFID reader is cycled with @ref SHED_RFID_CYCLE if no
+ *	interval has been configured for it.
+ *
+ ******************************************************************************/
+static int32_t	ShedInterval (PWR_OUT output)
+{
+    if (output != g_RFID_Power  ||  l_ShedTier < SHED_TIER_RFID)
+	return g_PwrInterval[output];
+
+    if (g_PwrInterval[output] < MIN_VAL_INTERVAL)
+	return SHED_RFID_CYCLE;
+
+    return g_PwrInterval[output];
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Power Cycle On-Duration of an Output
+ *
+ * @param[in] output
+ *	Power output.
+ *
+ * @return
+ *	The configured on-duration in [s].  In load shedding tier 1 and above,
+ *	the on-duration of the RFID reader is reduced to @ref l_ShedRFID_Duty
+ *	percent, and limited so that the minimum on- and off-durations of
+ *	VerifyConfiguration() are kept.
+ *
+ ******************************************************************************/
+static int32_t	ShedOnDuration (PWR_OUT output)
+{
+int32_t	interval, duration;
+
+
+    if (output != g_RFID_Power  ||  l_ShedTier < SHED_TIER_RFID)
+	return g_On_Duration[output];
+
+    interval = ShedInterval (output);
+    if (g_PwrInterval[output] < MIN_VAL_INTERVAL)
+	duration = interval;		// reader has been on all the time
+    else
+	duration = g_On_Duration[output];
+
+    duration = duration * (int32_t)l_ShedRFID_Duty / 100;
+    if (duration > interval - MIN_VAL_OFF_DURATION)
+	duration = interval - MIN_VAL_OFF_DURATION;
+    if (duration < MIN_VAL_ON_DURATION)
+	duration = MIN_VAL_ON_DURATION;
+
+    return duration;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Set up and start ADC for measuring
+ *
+ * This routine initializes the ADC for scan mode and starts a round.  While
+ * the ADC is running, all per @ref l_ADC_ScanChanMask selected channels
+ * will be read, but bit mask @ref l_ADC_ActiveChanMask determines, which of
+ * them will be used by Control().  If SCAN_PAIR_RATE is set, the ADC is set
+ * up for pair sampling instead, see ADC_PairStart().
+ *
+ ******************************************************************************/
+static void	ADC_ScanStart (void)
+{
+ADC_Init_TypeDef	init;
+ADC_InitScan_TypeDef	scan;
+
+    l_flgADC_Paused = false;
+
+    /* Voltage/current pair sampling, if configured */
+    if (l_ScanPairRate > 0  &&  ADC_PairStart())
+	return;
+
+    /* ADC requires EM1, set bit in bit mask */
+    Bit(g_EM1_ModuleMask, EM1_MOD_ADC) = 1;
+
+    /* Enable clock for ADC */
+    CMU_ClockEnable(cmuClock_ADC0, true);
+
+    /*
+     * We use scan mode with the following parameters:
+     *
+     * -> TA  = 256 clock cycles acquisition time
+     * -> RES = 12bit
+     * -> N  = OVS (Oversampling)
+     * -> OSR = OverSampling Ratio is 256 samples per block, see AdcOvs.c
+     * -> Number of channels is 4
+     *
+     * SCAN_DURATION is the time of 2048 samples, i.e. of 8 blocks, this
+     * results in ((256+12) * 2048) = 548864 clocks per duration.
+     * I/O clock (HFPERCLK) is equal HFCLK per default, i.e. exactly 32MHz.
+     * The ADC clock is HFPERCLK / (prescale + 1), e.g. using an ADC clock
+     * of 1MHz leads to 0.55s per duration.  The prescaler value is
+     * 7bit wide which allows 0 (/1) up to 127 (/128), but ADC clock shall
+     * be 13MHz~32kHz, so the clock divider must be /3~/128 which allows
+     * scan durations between 52ms up to 2200ms per channel.
+     *
+     * This divider can be calculated:
+     *		(SCAN_DURATION[ms] * 1000) / 17152L
+     */
+#define ADC_CLK_CONVERSION	17152L
+
+    init.ovsRateSel = adcOvsRateSel256;	// one block is 256 samples
+    init.lpfMode    = adcLPFilterRC;	// use R/C-filter
+    init.warmUpMode = adcWarmupKeepADCWarm;	// keep on while ADC runs
+    init.timebase   = ADC_TimebaseCalc(0);	// get current freq.
+    init.prescale   = (l_ScanDuration * 1000L / ADC_CLK_CONVERSION) - 1;
+    init.tailgate   = false;
+
+    ADC_Init(ADC0, &init);
+
+    /* Set up single scan mode, use 2.5V bandgap reference voltage. */
+    scan.prsSel  = adcPRSSELCh0;	// Peripheral Reflex System not used
+    scan.acqTime = adcAcqTime256;	// TA=256, see above
+    scan.reference  = adcRef2V5;	// 2.5V bandgap reference voltage
+    scan.resolution = adcResOVS;	// enable oversampling, see above
+    scan.input = l_ADC_ScanChanMask << 8; // bit mask of selected ADC channels
+    scan.diff  = false;			// single ended input mode
+    scan.prsEnable  = false;		// Peripheral Reflex System not used
+    scan.leftAdjust = false;		// leave data right adjusted
+    scan.rep = false;			// every pass is started by software
+
+    ADC_InitScan(ADC0, &scan);
+
+    /* Be sure to clear any pending interrupts */
+    ADC0->IFC = _ADC_IEN_MASK;
+
+    /* Enable interrupt for Scan Mode in ADC and NVIC */
+    NVIC_SetPriority(ADC0_IRQn, INT_PRIO_ADC);
+    FlashProgCapture(ADC0_IRQn, ADC_Capture);
+    ADC0->IEN = ADC_IEN_SCAN;
+    NVIC_EnableIRQ(ADC0_IRQn);
+
+    /* Start ADC */
+    ADC_RoundStart();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Stop measuring of a dedicated power output
+ *
+ * This routine is called after @ref FollowUpTime seconds are over to disable
+ * further measuring of a dedicated power output.
+ *
+ ******************************************************************************/
+static void	ADC_ScanStop (void)
+{
+    /* Disable interrupt in ADC and NVIC */
+    ADC0->IEN = 0;
+    NVIC_DisableIRQ(ADC0_IRQn);
+
+    /* Stop the timer and the DMA of the pair sampling */
+    if (l_flgADC_Pair)
+	ADC_PairStop();
+
+    /* Reset ADC */
+    ADC_Reset(ADC0);
+
+    /* Disable clock for ADC */
+    CMU_ClockEnable(cmuClock_ADC0, false);
+
+    /* ADC is no longer active, clear bit in bit mask */
+    Bit(g_EM1_ModuleMask, EM1_MOD_ADC) = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a Round of the ADC Scan
+ *
+ * A round measures all channels of @ref l_ADC_ScanChanMask.  It consists of
+ * passes, each pass converts one block of every channel whose window is not
+ * complete yet.
+ *
+ ******************************************************************************/
+static void	ADC_RoundStart (void)
+{
+int	idx;
+
+    for (idx = 0;  idx < NUM_MEASURE * 2;  idx++)
+	AdcOvsStart (&l_ADC_Win[idx]);
+
+    l_ADC_DoneChanMask = 0;
+    l_ADC_RoundCnt = RTC->CNT;
+
+    ADC_PassStart (l_ADC_ScanChanMask);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a Pass of the ADC Scan
+ *
+ * @param[in] chanMask
+ *	Bit mask of the ADC channels to be converted.
+ *
+ ******************************************************************************/
+static void	ADC_PassStart (uint8_t chanMask)
+{
+    l_ADC_PassChanMask = chanMask;
+
+    ADC0->SCANCTRL = (ADC0->SCANCTRL & ~_ADC_SCANCTRL_INPUTMASK_MASK)
+		   | ((uint32_t)chanMask << _ADC_SCANCTRL_INPUTMASK_SHIFT);
+    ADC0->CMD = ADC_CMD_SCANSTART;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	End a Round of the ADC Scan
+ *
+ * This routine publishes the values of all channels at once, so voltage and
+ * current of a power output are always from the same round.  The next round
+ * starts four SCAN_DURATION after the previous one, like the update rate of
+ * fixed windows.  Until then the ADC is switched off and the MCU may enter
+ * EM2, Control() restarts it with the next pass of the main loop after the
+ * pause, i.e. at the latest with the next second interrupt of the RTC.  If
+ * the round took longer, the next one starts immediately.
+ *
+ ******************************************************************************/
+static void	ADC_RoundEnd (void)
+{
+uint32_t elapsed, period, ms;
+int	 chan, idx;
+
+    for (chan = 0;  chan < 8;  chan++)
+    {
+	if (Bit(l_ADC_ScanChanMask, chan))
+	{
+	    idx = l_ADC_ChanIdxMap[chan];
+	    l_ADC_Value[idx] = AdcOvsMean (&l_ADC_Win[idx]);
+	    l_ADC_ValueCnt[idx] = l_ADC_WinCnt[idx];
+	    Bit(l_ADC_ValueUpdateMask, idx) = 1;
+	}
+    }
+
+    elapsed = (RTC->CNT - l_ADC_RoundCnt) & 0xFFFFFF;
+    period  = MS2TICS(l_ScanDuration * NUM_MEASURE * 2);
+    ms = elapsed < period ? (period - elapsed) * 1000 / RTC_COUNTS_PER_SEC : 0;
+
+    if (ms < MIN_ADC_PAUSE)
     {
-	/* Standard Power Output - call PowerOutput() directly */
-	PowerOutput (pwrOut, pwrState);
+	ADC_RoundStart();
+	return;
     }
 
-    g_flgIRQ = true;	// keep on running
+    ADC_ScanStop();
+    l_flgADC_Paused = true;
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Stop measuring of UA1 or UA2 power output
+ * @brief	Set up and start the Pair Sampling
  *
- * This routine is called after @ref FollowUpTime seconds are over to disable
- * further measuring of a dedicated power output.
+ * This routine sets up the ADC for a 12bit scan of all channels of
+ * @ref l_ADC_ScanChanMask, that is started by the overflow of TIMER0 via
+ * PRS channel @ref PAIR_PRS_CH at a rate of SCAN_PAIR_RATE.  The DMA writes
+ * the results into the ping-pong buffer @ref l_ADC_PairBuf, no interrupt is
+ * required per conversion.  The DMA channel is allocated on first use.
  *
- * @warning
- * 	This function is called in interrupt context!
+ * @return
+ *	<i>false</i> if no DMA channel is available, the adaptive oversampling
+ *	is used then.
  *
  ******************************************************************************/
-static void	MeasureStop (TIM_HDL hdl)
+static bool	ADC_PairStart (void)
 {
-int	m;
+ADC_Init_TypeDef	init = ADC_INIT_DEFAULT;
+ADC_InitScan_TypeDef	scan = ADC_INITSCAN_DEFAULT;
+TIMER_Init_TypeDef	timer = TIMER_INIT_DEFAULT;
+DMA_CfgDescr_TypeDef	descrCfg;
+unsigned int		nMinus1;
+int	chan, m;
 
-    /* Find the right measuring facility */
+
+    /* Allocate the DMA channel once, the descriptors remain configured */
+    if (l_ADC_DmaChan == NONE)
+    {
+	l_ADC_DmaChan = DmaChannelAlloc("ADC_SCAN", DMAREQ_ADC0_SCAN, true,
+					DMA_EM1, ADC_PairDone, NULL);
+	if (l_ADC_DmaChan == NONE)
+	{
+	    l_ScanPairRate = 0;		// use adaptive oversampling
+	    return false;
+	}
+
+	descrCfg.dstInc  = dmaDataInc2;	// halfword buffer
+	descrCfg.srcInc  = dmaDataIncNone;	// ADC0->SCANDATA
+	descrCfg.size    = dmaDataSize2;
+	descrCfg.arbRate = dmaArbitrate1;	// one value per request
+	descrCfg.hprot   = 0;
+	DMA_CfgDescr(l_ADC_DmaChan, true, &descrCfg);
+	DMA_CfgDescr(l_ADC_DmaChan, false, &descrCfg);
+    }
+
+    /* Position of the voltage and current values within a scan */
+    l_ADC_PairChanCnt = 0;
+    for (chan = 0;  chan < 8;  chan++)
+	if (Bit(l_ADC_ScanChanMask, chan))
+	    l_ADC_PairPos[l_ADC_ChanIdxMap[chan]] = l_ADC_PairChanCnt++;
+
+    /* A round lasts four SCAN_DURATION, like the adaptive oversampling */
+    l_ADC_PairTarget = l_ScanPairRate * l_ScanDuration * NUM_MEASURE * 2
+		       / 1000;
     for (m = 0;  m < NUM_MEASURE;  m++)
-	if (l_MeasureDef[m].hdlFollowUpTime == hdl)
-	    break;
+	AdcPairStart (&l_ADC_Pair[m]);
 
-    if (m >= NUM_MEASURE)
-	return;		// timer handle not found - ignore
+    /* ADC, TIMER0, and PRS require EM1 */
+    Bit(g_EM1_ModuleMask, EM1_MOD_ADC) = 1;
+    CMU_ClockEnable(cmuClock_ADC0, true);
+    CMU_ClockEnable(cmuClock_TIMER0, true);
+    CMU_ClockEnable(cmuClock_PRS, true);
 
-    /* Remove associated channels from bit mask */
-    Bit(l_ADC_ActiveChanMask, l_MeasureDef[m].ChanU) = 0;
-    Bit(l_ADC_ActiveChanMask, l_MeasureDef[m].ChanI) = 0;
+    /* Short conversions, so the values of a scan are taken together */
+    init.warmUpMode = adcWarmupKeepADCWarm;	// keep on while ADC runs
+    init.timebase   = ADC_TimebaseCalc(0);	// get current freq.
+    init.prescale   = ADC_PrescaleCalc(PAIR_ADC_CLOCK, 0);
+    ADC_Init(ADC0, &init);
 
-    /* Stop ADC if there are no more channels to read */
-    if (l_ADC_ActiveChanMask == 0)
+    scan.prsSel  = (ADC_PRSSEL_TypeDef)PAIR_PRS_CH; // TIMER0 starts a scan
+    scan.acqTime = adcAcqTime16;	// TA=16, see PAIR_ADC_CLOCK
+    scan.reference  = adcRef2V5;	// 2.5V bandgap reference voltage
+    scan.resolution = adcRes12Bit;	// single conversions
+    scan.input = l_ADC_ScanChanMask << 8; // bit mask of selected ADC channels
+    scan.prsEnable  = true;
+    ADC_InitScan(ADC0, &scan);
+    ADC0->IFC = _ADC_IEN_MASK;
+
+    /* Start the DMA before the first scan */
+    nMinus1 = PAIR_BUF_SCANS * l_ADC_PairChanCnt - 1;
+    DmaStartPingPong(l_ADC_DmaChan, false,
+		     l_ADC_PairBuf[0], (void *)&ADC0->SCANDATA, nMinus1,
+		     l_ADC_PairBuf[1], (void *)&ADC0->SCANDATA, nMinus1);
+
+    /* TIMER0 overflows at SCAN_PAIR_RATE, every overflow starts a scan */
+    PRS_SourceSignalSet(PAIR_PRS_CH, PRS_CH_CTRL_SOURCESEL_TIMER0,
+			PRS_CH_CTRL_SIGSEL_TIMER0OF, prsEdgeOff);
+    timer.enable   = false;
+    timer.prescale = timerPrescale16;
+    TIMER_Init(TIMER0, &timer);
+    TIMER_TopSet(TIMER0, CMU_ClockFreqGet(cmuClock_TIMER0) / 16
+			 / l_ScanPairRate - 1);
+    TIMER_Enable(TIMER0, true);
+
+    l_ADC_RoundCnt = RTC->CNT;
+    l_flgADC_Pair = true;
+
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Stop the Pair Sampling
+ *
+ * This routine stops TIMER0 and the DMA, and switches their clocks off.  It
+ * is called by ADC_ScanStop(), which resets the ADC.
+ *
+ ******************************************************************************/
+static void	ADC_PairStop (void)
+{
+    TIMER_Reset(TIMER0);
+    PRS_SourceSignalSet(PAIR_PRS_CH, 0, 0, prsEdgeOff);
+    DmaStop(l_ADC_DmaChan);
+
+    CMU_ClockEnable(cmuClock_TIMER0, false);
+    CMU_ClockEnable(cmuClock_PRS, false);
+
+    l_flgADC_Pair = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	DMA Callback of the Pair Sampling
+ *
+ * This routine is called by the DMA channel manager when one half of the
+ * ping-pong buffer is full.  It adds the voltage and current of every scan
+ * to the accumulator of the power output, see AdcPairAdd(), and hands the
+ * buffer back to the DMA.  The highest and the last current are kept for
+ * PowerSequencerSample().  The round ends after @ref l_ADC_PairTarget
+ * scans, see ADC_PairEnd().
+ *
+ * @param[in] chan
+ *	DMA channel.
+ *
+ * @param[in] primary
+ *	<i>true</i> if the primary descriptor, i.e. l_ADC_PairBuf[0], is done.
+ *
+ * @param[in] user
+ *	User pointer, not used.
+ *
+ ******************************************************************************/
+static void	ADC_PairDone (unsigned int chan, bool primary, void *user)
+{
+const uint16_t *pScan = l_ADC_PairBuf[primary ? 0 : 1];
+uint16_t i;
+int	n, m;
+
+    (void) user;
+
+    for (n = 0;  n < PAIR_BUF_SCANS;  n++, pScan += l_ADC_PairChanCnt)
     {
-	/* Clear flag to stop ADC */
-	l_flgADC_On = false;
+	for (m = 0;  m < NUM_MEASURE;  m++)
+	{
+	    i = pScan[l_ADC_PairPos[m * 2 + 1]];
+	    AdcPairAdd (&l_ADC_Pair[m], pScan[l_ADC_PairPos[m * 2]], i);
 
-	g_flgIRQ = true;	// keep on running
+	    /* Inrush current for the power sequencer */
+	    if (i > l_ADC_PairPeakI[m])
+		l_ADC_PairPeakI[m] = i;
+	    l_ADC_PairLastI[m] = i;
+	}
     }
+    l_flgADC_PairNewI = true;
 
-    /* Disable measuring facility */
-    *l_MeasureDef[m].BitBandAddr = 0;
+    /* Count overflows (debugging), a scan has been lost */
+    if (ADC0->IF & ADC_IF_SCANOF)
+    {
+	ADC0->IFC = ADC_IFC_SCANOF;
+	l_dbg_ADC_ErrCnt++;
+    }
+
+    DmaRefreshPingPong(chan, primary, false, NULL, NULL,
+		       PAIR_BUF_SCANS * l_ADC_PairChanCnt - 1, false);
+
+    if (l_ADC_Pair[0].Count >= l_ADC_PairTarget)
+	ADC_PairEnd();
+
+    g_flgIRQ = true;	// keep on running
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Stop measuring of a dedicated power output
- *
- * This routine is called after @ref l_BATT_FollowUpTime seconds are over to
- * disable further measuring of BATT_INP (via battery controller).
+ * @brief	End a Round of the Pair Sampling
  *
- * @warning
- * 	This function is called in interrupt context!
+ * This routine publishes the mean voltage, current, and product of both
+ * power outputs at once, and starts the next round.  The ADC is not
+ * switched off, so no pulse of the load is missed.
  *
  ******************************************************************************/
-static void	MeasureStopBATT (TIM_HDL hdl)
+static void	ADC_PairEnd (void)
 {
-    (void) hdl;		// suppress compiler warning "unused parameter"
+uint32_t cnt = RTC->CNT;
+int	 m;
 
-    /* Reset flag */
-    l_flgLogBATT = false;
+    for (m = 0;  m < NUM_MEASURE;  m++)
+    {
+	l_ADC_Value[m * 2]     = AdcPairMeanU (&l_ADC_Pair[m]);
+	l_ADC_Value[m * 2 + 1] = AdcPairMeanI (&l_ADC_Pair[m]);
+	l_ADC_PairUI[m] = AdcPairMeanUI (&l_ADC_Pair[m]);
+	l_ADC_ValueCnt[m * 2] = l_ADC_ValueCnt[m * 2 + 1] = cnt;
+	Bit(l_ADC_ValueUpdateMask, m * 2) = 1;
+	Bit(l_ADC_ValueUpdateMask, m * 2 + 1) = 1;
+	AdcPairStart (&l_ADC_Pair[m]);
+    }
 
-#ifdef LOGGING
-    Log ("BATT_INP: Measuring stopped");
-#endif
+    l_ADC_RoundCnt = cnt;
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Set up and start ADC for measuring
+ * @brief	Set up the ADC for single conversions
  *
- * This routine initializes and starts the ADC in repetitive scan mode.
- * While the ADC is running, all per @ref l_ADC_ScanChanMask selected channels
- * will be read, but bit mask @ref l_ADC_ActiveChanMask determines, which of
- * them will be stored in data array @ref l_ADC_Value.
+ * This routine initializes the ADC for single conversions with a clock of
+ * @ref SEQ_ADC_CLOCK, as used by PowerSequencer().  The ADC interrupt is not
+ * enabled, conversions are polled by ADC_SingleRead().  The ADC must be
+ * reset and its clock disabled again afterwards.
  *
  ******************************************************************************/
-static void	ADC_ScanStart (void)
+static void	ADC_SingleSetup (void)
 {
-ADC_Init_TypeDef	init;
-ADC_InitScan_TypeDef	scan;
+ADC_Init_TypeDef	init = ADC_INIT_DEFAULT;
 
-    /* ADC requires EM1, set bit in bit mask */
-    Bit(g_EM1_ModuleMask, EM1_MOD_ADC) = 1;
 
     /* Enable clock for ADC */
     CMU_ClockEnable(cmuClock_ADC0, true);
 
-    /*
-     * We use repetitive scan mode with the following parameters:
-     *
-     * -> TA  = 256 clock cycles acquisition time
-     * -> RES = 12bit
-     * -> N  = OVS (Oversampling)
-     * -> OSR = OverSampling Ratio is 2048 samples per measurement
-     * -> Number of channels is 4
-     *
-     * This results in ((256+12) * 2048 * 4) = 2195456 clocks per scan.
-     * I/O clock (HFPERCLK) is equal HFCLK per default, i.e. exactly 32MHz.
-     * The ADC clock is HFPERCLK / (prescale + 1), e.g. using an ADC clock
-     * of 1MHz leads to 0.91 updates per second.  The prescaler value is
-     * 7bit wide which allows 0 (/1) up to 127 (/128), but ADC clock shall
-     * be 13MHz~32kHz, so the clock divider must be /3~/128 which allows
-     * scan durations between 52ms up to 2200ms per channel.
-     *
-     * This divider can be calculated:
-     *		(SCAN_DURATION[ms] * 1000) / 17152L
-     */
-#define ADC_CLK_CONVERSION	17152L
-
-    init.ovsRateSel = adcOvsRateSel2048;// read channel 1024x per measuring
-    init.lpfMode    = adcLPFilterRC;	// use R/C-filter
-    init.warmUpMode = adcWarmupKeepADCWarm;	// keep on while ADC runs
+    init.warmUpMode = adcWarmupKeepADCWarm;	// keep on for the sequence
     init.timebase   = ADC_TimebaseCalc(0);	// get current freq.
-    init.prescale   = (l_ScanDuration * 1000L / ADC_CLK_CONVERSION) - 1;
-    init.tailgate   = false;
+    init.prescale   = ADC_PrescaleCalc(SEQ_ADC_CLOCK, 0);
 
     ADC_Init(ADC0, &init);
+}
 
-    /* Set up repetitive scan mode, use 2.5V bandgap reference voltage. */
-    scan.prsSel  = adcPRSSELCh0;	// Peripheral Reflex System not used
-    scan.acqTime = adcAcqTime256;	// TA=256, see above
-    scan.reference  = adcRef2V5;	// 2.5V bandgap reference voltage
-    scan.resolution = adcResOVS;	// enable oversampling, see above
-    scan.input = l_ADC_ScanChanMask << 8; // bit mask of selected ADC channels
-    scan.diff  = false;			// single ended input mode
-    scan.prsEnable  = false;		// Peripheral Reflex System not used
-    scan.leftAdjust = false;		// leave data right adjusted
-    scan.rep = true;			// use repetitive scan mode
 
-    ADC_InitScan(ADC0, &scan);
+/***************************************************************************//**
+ *
+ * @brief	Read an ADC channel by a single conversion
+ *
+ * @param[in] input
+ *	ADC input channel to be converted.
+ *
+ * @param[in] ref
+ *	Reference voltage for this conversion.
+ *
+ * @return
+ *	12bit raw value of the ADC.
+ *
+ ******************************************************************************/
+static uint32_t	ADC_SingleRead (ADC_SingleInput_TypeDef input,
+				ADC_Ref_TypeDef ref)
+{
+ADC_InitSingle_TypeDef	single = ADC_INITSINGLE_DEFAULT;
 
-    /* Be sure to clear any pending interrupts */
-    ADC0->IFC = _ADC_IEN_MASK;
 
-    /* Enable interrupt for Scan Mode in ADC and NVIC */
-    NVIC_SetPriority(ADC0_IRQn, INT_PRIO_ADC);
-    ADC0->IEN = ADC_IEN_SCAN;
-    NVIC_EnableIRQ(ADC0_IRQn);
+    single.acqTime   = adcAcqTime16;
+    single.reference = ref;
+    single.input     = input;
+    ADC_InitSingle(ADC0, &single);
 
-    /* Start ADC */
-    ADC_Start(ADC0, adcStartScan);
+    ADC_Start(ADC0, adcStartSingle);
+    while (ADC0->STATUS & ADC_STATUS_SINGLEACT)
+	;
+
+    return ADC_DataSingleGet(ADC0);
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Stop measuring of a dedicated power output
+ * @brief	Read the supply voltage VDD in [mV]
  *
- * This routine is called after @ref FollowUpTime seconds are over to disable
- * further measuring of a dedicated power output.
+ * VDD is measured as VDD/3 against the internal 1.25V reference.
  *
  ******************************************************************************/
-static void	ADC_ScanStop (void)
+static uint32_t	ADC_ReadVDD (void)
 {
-    /* Disable interrupt in ADC and NVIC */
-    ADC0->IEN = 0;
-    NVIC_DisableIRQ(ADC0_IRQn);
+    return ADC_SingleRead (adcSingleInpVDDDiv3, adcRef1V25) * 3750 / 4096;
+}
 
-    /* Reset ADC */
-    ADC_Reset(ADC0);
 
-    /* Disable clock for ADC */
-    CMU_ClockEnable(cmuClock_ADC0, false);
+/***************************************************************************//**
+ *
+ * @brief	Find a power output in the sequencer queue
+ *
+ * @return
+ *	Index in @ref l_SeqQueue, or -1 if the output is not queued.
+ *
+ ******************************************************************************/
+static int	SeqFind (PWR_OUT output)
+{
+int	i;
 
-    /* ADC is no longer active, clear bit in bit mask */
-    Bit(g_EM1_ModuleMask, EM1_MOD_ADC) = 0;
+    for (i = 0;  i < l_SeqCnt;  i++)
+	if (l_SeqQueue[i] == output)
+	    return i;
+
+    return (-1);
 }
 
 
@@ -1207,20 +3055,30 @@ static void	ADC_ScanStop (void)
  *
  * @brief	Interrupt Handler for ADC0
  *
- * This is the interrupt handler for ADC0.  It stores the raw values of up to
- * four channels into array @ref l_ADC_Value.  The ADC is configured in scan
- * mode and runs continuously until it is stopped.
+ * This is the interrupt handler for ADC0.  It averages the raw values of up
+ * to four channels into array @ref l_ADC_Value, see ADC_StoreValue().  The
+ * ADC is configured in scan mode and runs in rounds until it is stopped.  A
+ * conversion that has been captured while the FLASH was busy is stored
+ * first.
  *
  ******************************************************************************/
 void ADC0_IRQHandler(void)
 {
 uint32_t	IntFlags;
 uint32_t	status;
-uint32_t	value;
-int		chan;
+bool		flgCaptured = false;
 
     DEBUG_TRACE(0x03);
 
+    /* Store a conversion that has been captured during FLASH programming */
+    if (l_ADC_Capture.flgValid)
+    {
+	ADC_StoreValue (l_ADC_Capture.Status, l_ADC_Capture.Value,
+			l_ADC_Capture.Cnt);
+	l_ADC_Capture.flgValid = false;
+	flgCaptured = true;
+    }
+
     /* Check cause of this interrupt */
     IntFlags = ADC0->IF;
     if (IntFlags & (ADC_IF_SCANOF | ADC_IF_SINGLEOF | ADC_IF_SINGLE))
@@ -1237,7 +3095,8 @@ int		chan;
     /* Check for regular scan conversion complete */
     if ((IntFlags & ADC_IF_SCAN) == 0)
     {
-	l_dbg_ADC_NotReadyCnt++;
+	if (! flgCaptured)
+	    l_dbg_ADC_NotReadyCnt++;
 	g_flgIRQ = true;	// keep on running
 	DEBUG_TRACE(0x83);
 	return;			// nothing to be done
@@ -1251,31 +3110,96 @@ int		chan;
     if ((status & ADC_STATUS_SCANDV) == 0)
 	l_dbg_ADC_ErrCnt++;		// increase error count
 
+    /* Count overflows (debugging) */
+    if (IntFlags & ADC_IF_SCANOF)
+	l_dbg_ADC_OvflErrCnt[l_ADC_ChanIdxMap[(status >> 24) & 0x7]]++;
+
+    /* Store current value and the time of its conversion */
+    ADC_StoreValue (status, ADC0->SCANDATA, RTC->CNT);
+
+    g_flgIRQ = true;	// keep on running
+
+    DEBUG_TRACE(0x83);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Store an ADC Value
+ *
+ * This routine adds a converted block to the window of its channel, see
+ * AdcOvsAdd().  After the last channel of a pass, the next pass is started
+ * with the channels whose window is not complete yet.  When all windows are
+ * complete, the round ends with ADC_RoundEnd().
+ *
+ * @param[in] status
+ *	Value of register ADC0->STATUS, it contains the converted channel.
+ *
+ * @param[in] value
+ *	Converted value.
+ *
+ * @param[in] cnt
+ *	RTC count of the conversion.
+ *
+ ******************************************************************************/
+static void	ADC_StoreValue (uint32_t status, uint32_t value, uint32_t cnt)
+{
+int	chan, idx;
+uint8_t	chanMask;
+
     /* See which channel has been converted this time */
     chan = (status >> 24) & 0x7;
 
     /* Translate channel number into index to store current value */
-    chan = l_ADC_ChanIdxMap[chan];
-
-    /* Count overflows (debugging) */
-    if (IntFlags & ADC_IF_SCANOF)
-	l_dbg_ADC_OvflErrCnt[chan]++;
+    idx = l_ADC_ChanIdxMap[chan];
 
     /* Count number of conversions for each channel (debugging) */
-    l_dbg_ADC_ChanCnt[chan]++;
+    l_dbg_ADC_ChanCnt[idx]++;
 
-    /* Read current value */
-    value = ADC0->SCANDATA;
+    /* Add the block, and record the time when the window is complete */
+    if (AdcOvsAdd (&l_AdcOvsCfg, &l_ADC_Win[idx], value))
+    {
+	Bit(l_ADC_DoneChanMask, chan) = 1;
+	l_ADC_WinCnt[idx] = cnt;
+    }
 
-    /* Store new value */
-    l_ADC_Value[chan] = value;
+    /* The pass ends with its highest channel */
+    if ((l_ADC_PassChanMask >> chan) != 1)
+	return;
 
-    /* Mark update of this channel */
-    Bit(l_ADC_ValueUpdateMask, chan) = 1;
+    chanMask = l_ADC_ScanChanMask & ~l_ADC_DoneChanMask;
+    if (chanMask)
+	ADC_PassStart (chanMask);
+    else
+	ADC_RoundEnd();
+}
 
-    g_flgIRQ = true;	// keep on running
 
-    DEBUG_TRACE(0x83);
+/***************************************************************************//**
+ *
+ * @brief	Capture an ADC Conversion while the FLASH is busy
+ *
+ * This routine is executed from RAM instead of ADC0_IRQHandler() during
+ * FLASH programming, see FlashProgCapture().  It saves a regular conversion
+ * in @ref l_ADC_Capture.  Error conditions, and a second conversion, are
+ * left to ADC0_IRQHandler() after the FLASH operation.
+ *
+ * @return
+ *	<i>true</i> if the conversion has been captured.
+ *
+ ******************************************************************************/
+static FLASH_RAMFUNC bool ADC_Capture (void)
+{
+    if (ADC0->IF != ADC_IF_SCAN  ||  l_ADC_Capture.flgValid)
+	return false;
+
+    ADC0->IFC = ADC_IFC_SCAN;
+    l_ADC_Capture.Status = ADC0->STATUS;
+    l_ADC_Capture.Value  = ADC0->SCANDATA;
+    l_ADC_Capture.Cnt    = RTC->CNT;
+    l_ADC_Capture.flgValid = true;
+
+    return true;
 }
 
 
@@ -1337,6 +3261,35 @@ int	idx;
 }
 
 
+/******************************************************************************
+ *
+ * @brief	Get the average Power of a Power Output in [uW]
+ *
+ * This routine returns the true average power of the specified power output
+ * in [uW], i.e. the mean of the products of voltage and current, if pair
+ * sampling is enabled by SCAN_PAIR_RATE.  Otherwise voltage and current have
+ * been averaged separately, and their product is returned.
+ *
+ * @param[in] output
+ *	Power output to return the power for.
+ *
+ * @return
+ *	Value in [uW].
+ *
+ *****************************************************************************/
+uint32_t PowerTrue (PWR_OUT output)
+{
+    /* Parameter check */
+    EFM_ASSERT (PWR_OUT_UA1 <= output  &&  output <= PWR_OUT_UA2);
+
+    if (l_ScanPairRate > 0)
+	return AdcPairPower (l_ADC_PairUI[output], l_mV_Divider[output],
+			     l_mA_Divider[output]);
+
+    return PowerVoltage(output) * PowerCurrent(output);
+}
+
+
 /******************************************************************************
  *
  * @brief	Get ADC raw value for a given voltage in [mV]
@@ -1509,19 +3462,43 @@ uint16_t	data_h, data_l, sum=0;
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Request to Write the Calibration Data
+ *
+ * This routine may be called in interrupt context, e.g. by a menu handler.
+ * It only sets a flag, the calibration data is written by Control() in the
+ * main loop then, see WriteCalibrationData().  This way the key interrupt
+ * does not block all other interrupts of the same priority, especially the
+ * GPIO interrupts of the DCF77 decoder, while the FLASH is written.
+ *
+ ******************************************************************************/
+void	WriteCalibrationRequest(void)
+{
+    l_flgCalibWriteReq = true;
+    g_flgIRQ = true;		// Control() should process the request
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Write Calibration Data to EEPROM
  *
  * This routine writes the calibration data to @ref EEPROM (FLASH).  To protect
- * the data, a magic word and a checksum are stored additionally.
+ * the data, a magic word and a checksum are stored additionally.  Interrupts
+ * stay enabled, FlashProg.c only holds off those that are not captured, and
+ * only while the FLASH is busy.  The number of FLASH operations and their
+ * maximum lockout and busy times are logged.
  *
  ******************************************************************************/
 void	WriteCalibrationData(void)
 {
 uint16_t	data, sum;
+#ifdef LOGGING
+FLASH_PROG_STAT	stat;
+#endif
 
-    INT_Disable();	// disable IRQs during FLASH programming
+    FlashProgStatClear();
 
     /* store adjustments into non-volatile memory */
     sum = data = MAGIC_ID;
@@ -1557,9 +3534,11 @@ uint16_t	data, sum;
 
     EE_Write(&chksum, sum);
 
-    INT_Enable();
-
 #ifdef LOGGING
+    FlashProgStatGet (&stat);
     Log ("Calibration Values have been saved to Flash");
+    Log ("Flash: %ld writes, %ld erases, busy %ldus (max %ldus),"
+	 " IRQ lockout max %ldus", (long)stat.Writes, (long)stat.Erases,
+	 (long)stat.BusySum, (long)stat.BusyMax, (long)stat.LockoutMax);
 #endif
 }
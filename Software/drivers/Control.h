@@ -2,9 +2,18 @@
  * @file
  * @brief	Header file of module Control.c
  * @author	Ralf Gerhauser
- * @version	2018-10-10
+ * @version	2026-10-19
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added WriteCalibrationRequest().
+2026-10-19,agent Added PWR_OUT_FCT and PowerOutputFctInstall().
+2026-10-19,agent Added DFLT_SCAN_PAIR_RATE and PowerTrue().
+2026-10-19,agent Added defaults for the adaptive oversampling of the ADC.
+2026-10-19,agent ControlUpdateID() has a time stamp parameter.
+2026-10-19,agent Added defaults for the change-only battery logging.
+2026-10-19,agent Added defaults for the load shedding tiers.
+2026-10-19,agent Added defaults for the daily energy budgets.
+2026-10-19,agent Added DFLT_POWER_SETTLE_TIME for the power output sequencer.
 2018-10-10,rage	Added prototype VerifyConfiguration(), removed unused prototypes.
 		Added timing variables for Power Cycling.
 2018-03-26,rage	Initial version, based on MAPRDL.
@@ -16,6 +25,7 @@ Revision History:
 /*=============================== Header Files ===============================*/
 
 #include "config.h"		// include project configuration parameters
+#include "AlarmClock.h"		// CLOCK_STAMP
 
 /*=============================== Definitions ================================*/
 
@@ -27,6 +37,28 @@ Revision History:
     #define DFLT_SCAN_DURATION		1000	// 1000ms
 #endif
 
+#ifndef DFLT_SCAN_SAMPLES_MIN
+    /*!@brief Default minimum number of samples to average a channel. */
+    #define DFLT_SCAN_SAMPLES_MIN	512
+#endif
+
+#ifndef DFLT_SCAN_SAMPLES_MAX
+    /*!@brief Default maximum number of samples to average a channel. */
+    #define DFLT_SCAN_SAMPLES_MAX	4096
+#endif
+
+#ifndef DFLT_SCAN_CONFIDENCE
+    /*!@brief Default confidence bound of an averaged channel in [LSB] of the
+     * 16bit ADC value, i.e. 1/16 LSB of the 12bit converter. */
+    #define DFLT_SCAN_CONFIDENCE	1
+#endif
+
+#ifndef DFLT_SCAN_PAIR_RATE
+    /*!@brief Default scan rate in [Hz] of the voltage/current pair sampling,
+     * 0 disables it, so the channels are oversampled one after the other. */
+    #define DFLT_SCAN_PAIR_RATE		0
+#endif
+
 #ifndef DFLT_MEASURE_U_MIN_DIFF
     /*!@brief Default minimum difference for a new U-value (in mV). */
     #define DFLT_MEASURE_U_MIN_DIFF	100	// 100mV
@@ -42,6 +74,86 @@ Revision History:
     #define DFLT_MEASURE_FOLLOW_UP_TIME	(1*60)	// 1min
 #endif
 
+#ifndef DFLT_POWER_SETTLE_TIME
+    /*!@brief Default settle time between switching on two power outputs
+     * (in ms).  A value of 0 switches all pending outputs back to back. */
+    #define DFLT_POWER_SETTLE_TIME	200	// 200ms
+#endif
+
+#ifndef DFLT_ENERGY_WARN_LEVEL
+    /*!@brief Default warning level of the daily energy budgets in [%]. */
+    #define DFLT_ENERGY_WARN_LEVEL	80	// 80%
+#endif
+
+#ifndef DFLT_ENERGY_RESET_TIME
+    /*!@brief Default time (hour, minute) in MEZ when the energy counters are
+     * reset and outputs that have been cut off are released again. */
+    #define DFLT_ENERGY_RESET_TIME	0, 0	// 00:00
+#endif
+
+#ifndef SHED_CHECK_INTERVAL
+    /*!@brief Interval in [s] to read the state of charge and the runtime to
+     * empty from the battery controller for load shedding. */
+    #define SHED_CHECK_INTERVAL		(10*60)	// 10min
+#endif
+
+#ifndef SHED_RFID_CYCLE
+    /*!@brief Power cycle interval in [s] of the RFID reader in load shedding
+     * tier 1, if no RFID interval has been configured. */
+    #define SHED_RFID_CYCLE		60	// 1min
+#endif
+
+#ifndef DFLT_SHED_SOC_HYSTERESIS
+    /*!@brief Default hysteresis of the state of charge thresholds of the
+     * load shedding tiers in percentage points. */
+    #define DFLT_SHED_SOC_HYSTERESIS	5	// 5%
+#endif
+
+#ifndef DFLT_SHED_RUNTIME_HYSTERESIS
+    /*!@brief Default hysteresis of the runtime thresholds of the load
+     * shedding tiers in [%] of the threshold. */
+    #define DFLT_SHED_RUNTIME_HYSTERESIS 25	// 25%
+#endif
+
+#ifndef DFLT_SHED_RFID_DUTY
+    /*!@brief Default duty cycle of the RFID reader in load shedding tier 1
+     * in [%] of its configured on-duration. */
+    #define DFLT_SHED_RFID_DUTY		50	// 50%
+#endif
+
+#ifndef DFLT_SHED_FLUSH_PAUSE
+    /*!@brief Default pause between two log flushes in [s] in load shedding
+     * tier 3 and above. */
+    #define DFLT_SHED_FLUSH_PAUSE	(5*60)	// 5min
+#endif
+
+#ifndef DFLT_BAT_LOG_CAPACITY_DIFF
+    /*!@brief Default minimum change of the remaining capacity of the battery
+     * in [mAh] to be logged. */
+    #define DFLT_BAT_LOG_CAPACITY_DIFF	100	// 100mAh
+#endif
+
+#ifndef DFLT_BAT_LOG_RUNTIME_DIFF
+    /*!@brief Default minimum change of the runtime to empty in [%] of the
+     * logged value. */
+    #define DFLT_BAT_LOG_RUNTIME_DIFF	10	// 10%
+#endif
+
+#ifndef DFLT_BAT_LOG_VOLTAGE_DIFF
+    /*!@brief Default minimum change of the battery voltage in [mV]. */
+    #define DFLT_BAT_LOG_VOLTAGE_DIFF	100	// 100mV
+#endif
+
+#ifndef DFLT_BAT_LOG_CURRENT_DIFF
+    /*!@brief Default minimum change of the battery current in [mA]. */
+    #define DFLT_BAT_LOG_CURRENT_DIFF	50	// 50mA
+#endif
+
+#ifndef DFLT_BAT_LOG_KEYFRAME
+    /*!@brief Default interval in [h] to log all battery values. */
+    #define DFLT_BAT_LOG_KEYFRAME	24	// 24h
+#endif
+
     /*!@brief Power output selection. */
 typedef enum
 {
@@ -58,6 +170,10 @@ typedef enum
 #define PWR_ON		true	//!< Switch power output on  (enable power)
 //@}
 
+    /*!@brief Function to be called when a power output has been switched on
+     * and its inrush current has settled, see PowerOutputFctInstall(). */
+typedef void	(*PWR_OUT_FCT)(PWR_OUT output);
+
 /*================================ Global Data ===============================*/
 
 extern const char *g_enum_PowerOutput[];
@@ -79,11 +195,12 @@ void	VerifyConfiguration (void);
 void	Control (void);
 
     /* Inform the control module about a new transponder ID */
-void	ControlUpdateID (char *transponderID);
+void	ControlUpdateID (char *transponderID, const CLOCK_STAMP *pStamp);
 
     /* Switch power output on or off */
 void	PowerOutput	(PWR_OUT output, bool enable);
 bool	IsPowerOutputOn (PWR_OUT output);
+void	PowerOutputFctInstall (PWR_OUT_FCT function);
 
     /* Power Fail Handler of the control module */
 void	ControlPowerFailHandler (void);
@@ -92,6 +209,9 @@ void	ControlPowerFailHandler (void);
 uint32_t PowerVoltage (PWR_OUT output);
 uint32_t PowerCurrent (PWR_OUT output);
 
+    /* Get the average power of a power output in [uW] */
+uint32_t PowerTrue (PWR_OUT output);
+
     /* Get ADC raw value for a given voltage in [mV] or current in [mA] */
 uint32_t Voltage_To_ADC_Value (PWR_OUT output, uint32_t value_mV);
 uint32_t Current_To_ADC_Value (PWR_OUT output, uint32_t value_mA);
@@ -100,6 +220,7 @@ uint32_t Current_To_ADC_Value (PWR_OUT output, uint32_t value_mA);
 void	CalibrateVoltage (PWR_OUT output, uint32_t referenceValue_mV);
 void	CalibrateCurrent (PWR_OUT output, uint32_t referenceValue_mA);
 void	WriteCalibrationData(void);
+void	WriteCalibrationRequest(void);
 
 
 #endif /* __INC_Control_h */
@@ -57,6 +57,8 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Moved the time zone handling of TimeSynchronize() into
+		TimeSourceSync(), which also records the time to sync.
 2020-05-12,rage	TimeSynchronize: Call ClockSet() after converting alarm times
 		from/to MESZ to provide correct alarms to CheckAlarmTimes().
 2016-04-06,rage	Made local variables of type "volatile".
@@ -86,12 +88,16 @@ Revision History:
 #include "DCF77.h"
 #include "ExtInt.h"
 #include "AlarmClock.h"
+#include "TimeSource.h"
 #if DCF77_DISPLAY_PROGRESS
   #include "SegmentLCD.h"
 #endif
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_DCF77
+
     // Module Debugging
 #define MOD_DEBUG	0	// set 1 to enable debugging of this module
 #if ! MOD_DEBUG
@@ -150,7 +156,6 @@ static volatile uint8_t	 l_FrameSeqCnt = 1;
 
 /*=========================== Forward Declarations ===========================*/
 
-static void	TimeSynchronize (struct tm *pTime);
 static void	SignalSuperVisor (TIM_HDL hdl);
 static void	StateChange (DCF_STATE newState);
 
@@ -232,6 +237,9 @@ void	DCF77Enable (void)
 
     /* Change DCF state */
     StateChange (STATE_NO_SIGNAL);
+
+    /* Start measuring the time to sync */
+    TimeSourceStart (TIME_SRC_DCF77);
 }
 
 /***************************************************************************//**
@@ -265,6 +273,9 @@ void	DCF77Disable (void)
     /* Change DCF state */
     StateChange (STATE_OFF);
 
+    /* Account the on-time */
+    TimeSourceStop (TIME_SRC_DCF77);
+
 #ifdef LOGGING
     Log ("DCF77: Disabled");
 #endif
@@ -448,7 +459,7 @@ bool		bit;		// current data bit
 		    l_FrameSeqCnt = 250;	// prevent counter from overflow
 
 		/* set local time, show time on display */
-		TimeSynchronize (&dcf77);
+		TimeSourceSync (TIME_SRC_DCF77, &dcf77);
 
 		/* RTC is 0, correct timeStamp and tsRising values */
 		tsRising -= timeStamp;
@@ -771,79 +782,6 @@ bool		bit;		// current data bit
     bitNum = NONE;
 }
 
-/***************************************************************************//**
- *
- * @brief	Time Synchronization
- *
- * This function is called from the DCF77 interrupt handler after a sequence
- * of consecutive valid frames has been received, so we can be sure the time
- * information is valid.  It sets the system clock via ClockSet() and updates
- * the display with the new time.
- * It also checks for a change of MEZ to MESZ and vice versa.  If this happens,
- * all configured alarm times will be adjusted accordingly.
- *
- * @note
- * Be aware, this function is called in interrupt context!
- *
- * @param[in] pTime
- *	Pointer to a <b>tm</b> structure that holds the current time.
- *
- ******************************************************************************/
-static void	TimeSynchronize (struct tm *pTime)
-{
-    /* flag to detect whether MEZ<=>MESZ change occurred */
-    bool changeOccurred = (g_isdst != (bool)pTime->tm_isdst);
-
-    /* set system clock to DCF77 time in "tm" format */
-    g_CurrDateTime = *pTime;
-    g_isdst = pTime->tm_isdst;		// flag for daylight saving time
-
-#if DCF77_ONCE_PER_DAY  &&  defined(LOGGING)
-    /* log current DCF77 time */
-    Log("DCF77: Time Synchronization %02d:%02d:%02d (%s)",
-	pTime->tm_hour, pTime->tm_min, pTime->tm_sec, g_isdst ? "MESZ" : "MEZ");
-#endif
-
-    /*
-     * DCF77 may be activated once per day only.  To detect a change
-     * between MEZ and MESZ properly, the DCF77 will be switched-on at
-     * the right time.  When such a change is detected, all alarm times
-     * must be corrected to still occur at the same effective time.
-     * This includes the ALARM_DCF77_WAKE_UP, which is switched between
-     * 01:55 (MEZ) and 02:55 (MESZ) properly.
-     */
-    if (changeOccurred)
-    {
-    int	    alarm;
-    int8_t  hour, minute;
-
-	if (g_isdst)
-	    Log ("DCF77: Changing time zone from MEZ to MESZ");
-	else
-	    Log ("DCF77: Changing time zone from MESZ to MEZ");
-
-	/* MEZ <-> MESZ change detected */
-	for (alarm = 0;  alarm < MAX_ALARMS;  alarm++)
-	{
-	    AlarmGet (alarm, &hour, &minute);
-
-	    hour += (g_isdst ? +1 : -1);
-	    if (hour < 0)
-		hour = 23;
-	    else if (hour > 23)
-		hour = 0;
-
-	    AlarmSet (alarm, hour, minute);
-	}
-    }
-
-    /* Set System Clock also in UNIX time and check initially alarm times */
-    ClockSet (&g_CurrDateTime, true);	// set milliseconds of RTC to zero
-
-    /* Show time on display (if applicable) */
-    ClockUpdate (false);	// g_CurrDateTime is already up to date
-}
-
 /***************************************************************************//**
  *
  * @brief	Signal Supervision
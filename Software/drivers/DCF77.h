@@ -5,6 +5,7 @@
  * @version	2014-11-21
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added DCF77_SUPPLY_CURRENT.
 2016-04-13,rage	Removed DCF_TRIG_MASK (no more required by EXTI module).
 2016-04-05,rage	Reverted DCF77_ENABLE_PIN to 1 and DCF77_SIGNAL_PIN to 2.
 2015-07-28,rage	Changed DCF77_ENABLE_PIN to 2 and DCF77_SIGNAL_PIN to 1.
@@ -52,6 +53,13 @@ Revision History:
     #define DCF77_INDICATOR		0
 #endif
 
+#ifndef DCF77_SUPPLY_CURRENT
+    /*!@brief Supply current in [uA] of the DCF77 receiver while it is on.
+     * It is used to estimate the energy per sync, see TimeSourceStatistics().
+     */
+    #define DCF77_SUPPLY_CURRENT	100
+#endif
+
 /*!@brief Here follows the definition of GPIO ports and pins used to connect
  * to the external DCF77 hardware module.
  */
@@ -32,6 +32,8 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent MenuCalibration() only requests to save the calibration data,
+		it is written by Control() in the main loop.
 2018-03-14,rage	Initial version.
 */
 
@@ -289,8 +291,8 @@ uint32_t value_mA;
  *
  * This menu handler leads the user to the calibration menu for UA1 and UA2
  * measurement.  If one or more calibration procedures have been done, this
- * handler saves the calibration data to flash, when returning from these
- * menus.
+ * handler requests to save the calibration data to flash, when returning
+ * from these menus, see WriteCalibrationRequest().
  *
  * @param[in] keycode
  *	Translated key code, sent by the menu key handler to this module.
@@ -320,7 +322,7 @@ static KEYCODE MenuCalibration (KEYCODE keycode, uint32_t arg)
     {
 	case KEYCODE_MENU_ENTER:	/*---------- Enter this menu ---------*/
 	    if (l_flgCalibration !=  0)	// calibration was performed,
-		WriteCalibrationData();	// save data to flash
+		WriteCalibrationRequest(); // save data to flash
 	    break;
 
 	case KEYCODE_MENU_EXIT:		/*---------- Leave this menu ---------*/
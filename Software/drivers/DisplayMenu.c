@@ -43,6 +43,9 @@ Revision History:
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_DISPLAY
+
     /*!@brief Maximum number of menu levels on the stack. */
 #define MAX_MENU_LEVEL		5
 
@@ -0,0 +1,474 @@
+/***************************************************************************//**
+ * @file
+ * @brief	DMA Channel Manager
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module manages the 8 channels of the DMA controller for all drivers.
+ * It contains the following parts:
+ * - Initialization of the DMA controller with the global control block
+ *   @ref g_DMA_ControlBlock, see DmaInit().
+ * - Dynamic allocation of DMA channels, see DmaChannelAlloc() and
+ *   DmaChannelFree().  A driver no longer needs a fixed channel number.
+ * - Dispatching of the DMA completion interrupt to the callback function of
+ *   the driver that owns the channel.
+ * - Start routines for basic, ping-pong, and scatter-gather transfers.
+ * - Energy Mode handling: while a transfer is active on a channel which has
+ *   been allocated with @ref DMA_EM1, the bit @ref EM1_MOD_DMA is set in
+ *   @ref g_EM1_ModuleMask, so the system does not enter EM2.
+ * - Utilization counters per channel, see DmaChannelStatistics() and
+ *   DmaLogStatistics().
+ *
+ * A typical driver allocates its channel once during initialization, sets up
+ * the descriptors with the emlib routines DMA_CfgDescr() resp.
+ * DMA_CfgDescrScatterGather(), and then starts each transfer by calling one
+ * of the DmaStart...() routines of this module.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_int.h"
+#include "DmaMgr.h"
+#include "AlarmClock.h"
+#include "Logging.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_DMA
+
+/*=========================== Typedefs and Structs ===========================*/
+
+/*!@brief Management data of one DMA channel */
+typedef struct
+{
+    const char	       *Name;		//!< Name of the owner, NULL if free
+    DMA_EM_LEVEL	EmLevel;	//!< Required energy mode
+    DMA_FuncPtr_TypeDef	CbFunc;		//!< Callback function of the driver
+    void	       *UserPtr;	//!< User pointer for the callback
+    bool		Active;		//!< A transfer is active
+    bool		PingPong;	//!< Ping-pong mode, remains active
+    uint32_t		StartCnt;	//!< RTC counter when transfer started
+    DMA_STAT		Stat;		//!< Utilization counters
+} DMA_CHAN;
+
+/*======================== External Data and Routines ========================*/
+
+extern DMA_DESCRIPTOR_TypeDef g_DMA_ControlBlock[];
+extern DMA_CB_TypeDef g_DMA_Callback[];
+
+/*================================ Local Data ================================*/
+
+    /*! Flag if the DMA controller has already been initialized */
+static bool	l_flgDmaInit;
+
+    /*! Management data for all DMA channels */
+static volatile DMA_CHAN l_Chan[DMA_CHAN_COUNT];
+
+    /*! Number of active transfers which require EM1 */
+static volatile int	l_EM1_ActiveCnt;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void dmaDone(unsigned int channel, bool primary, void *user);
+static void dmaBegin(int chan, uint32_t items, bool pingPong);
+static void dmaEnd(int chan);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Initialize the DMA Controller
+ *
+ * This routine enables the clock of the DMA controller, initializes it with
+ * the global control block, and enables the DMA interrupt.  It may be called
+ * more than once, only the first call has an effect.  It must be called
+ * before any driver allocates a DMA channel.
+ *
+ ******************************************************************************/
+void	DmaInit (void)
+{
+DMA_Init_TypeDef dmaInit;
+
+
+    if (l_flgDmaInit)
+	return;
+
+    CMU_ClockEnable(cmuClock_DMA, true);	// Enable DMA clock
+
+    dmaInit.hprot        = 0;			// No descriptor protection
+    dmaInit.controlBlock = g_DMA_ControlBlock;	// aligned to 256
+    DMA_Init(&dmaInit);
+
+    NVIC_SetPriority(DMA_IRQn, INT_PRIO_DMA);
+    NVIC_EnableIRQ(DMA_IRQn);
+
+    l_flgDmaInit = true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Allocate a DMA Channel
+ *
+ * This routine looks for a free DMA channel and configures it for the
+ * specified DMA request.  The completion interrupt is always enabled, so
+ * the manager knows when a transfer has finished.
+ *
+ * @param[in] name
+ *	Name of the owner, used for statistics.  The string must be static.
+ *
+ * @param[in] select
+ *	DMA request, e.g. DMAREQ_LEUART0_TXBL, or 0 for memory transfers.
+ *
+ * @param[in] highPri
+ *	If <i>true</i>, the channel gets high priority.
+ *
+ * @param[in] emLevel
+ *	Energy Mode required while a transfer is active, see @ref DMA_EM_LEVEL.
+ *
+ * @param[in] cbFunc
+ *	Function to be called when a transfer has been completed, may be NULL.
+ *	It is called in interrupt context.
+ *
+ * @param[in] userPtr
+ *	User pointer which is passed to @p cbFunc.
+ *
+ * @return
+ *	Number of the allocated channel, or NONE if all channels are in use.
+ *
+ ******************************************************************************/
+int	DmaChannelAlloc (const char *name, unsigned int select, bool highPri,
+			 DMA_EM_LEVEL emLevel, DMA_FuncPtr_TypeDef cbFunc,
+			 void *userPtr)
+{
+DMA_CfgChannel_TypeDef chnlCfg;
+int	 chan;
+
+
+    EFM_ASSERT(l_flgDmaInit);
+
+    INT_Disable();
+    for (chan = 0;  chan < DMA_CHAN_COUNT;  chan++)
+    {
+	if (l_Chan[chan].Name == NULL)
+	{
+	    l_Chan[chan].Name = name;	// mark as allocated
+	    break;
+	}
+    }
+    INT_Enable();
+
+    if (chan >= DMA_CHAN_COUNT)
+    {
+	LogError ("DmaChannelAlloc(%s): No more DMA channels", name);
+	return NONE;
+    }
+
+    l_Chan[chan].EmLevel = emLevel;
+    l_Chan[chan].CbFunc  = cbFunc;
+    l_Chan[chan].UserPtr = userPtr;
+    l_Chan[chan].Active  = false;
+    l_Chan[chan].PingPong = false;
+    l_Chan[chan].Stat.Transfers = l_Chan[chan].Stat.Done = 0;
+    l_Chan[chan].Stat.Items = l_Chan[chan].Stat.BusyMs = 0;
+
+    /* The manager's dispatcher is always called first */
+    g_DMA_Callback[chan].cbFunc  = dmaDone;
+    g_DMA_Callback[chan].userPtr = NULL;
+
+    chnlCfg.highPri   = highPri;
+    chnlCfg.enableInt = true;
+    chnlCfg.select    = select;
+    chnlCfg.cb        = &g_DMA_Callback[chan];
+    DMA_CfgChannel(chan, &chnlCfg);
+
+    return chan;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Free a DMA Channel
+ *
+ * This routine stops a transfer that may still be active on the specified
+ * channel, and returns the channel to the pool of free channels.
+ *
+ ******************************************************************************/
+void	DmaChannelFree (int chan)
+{
+    if (chan < 0  ||  chan >= DMA_CHAN_COUNT)
+	return;
+
+    DmaStop (chan);
+
+    INT_Disable();
+    DMA->IEN &= ~(DMA_IEN_CH0DONE << chan);
+    g_DMA_Callback[chan].cbFunc = NULL;
+    l_Chan[chan].Name = NULL;
+    INT_Enable();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a Basic Transfer
+ *
+ * This is a wrapper for DMA_ActivateBasic(), see there for the parameters.
+ * The descriptor must have been configured by DMA_CfgDescr() before.
+ *
+ ******************************************************************************/
+void	DmaStartBasic (int chan, bool primary, bool useBurst, void *dst,
+		       void *src, unsigned int nMinus1)
+{
+    dmaBegin (chan, nMinus1 + 1, false);
+    DMA_ActivateBasic(chan, primary, useBurst, dst, src, nMinus1);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a Ping-Pong Transfer
+ *
+ * This is a wrapper for DMA_ActivatePingPong(), see there for the parameters.
+ * The channel remains active until the driver passes <i>last</i> = true to
+ * DmaRefreshPingPong(), or calls DmaStop().
+ *
+ ******************************************************************************/
+void	DmaStartPingPong (int chan, bool useBurst,
+			  void *primDst, void *primSrc, unsigned int primNMinus1,
+			  void *altDst, void *altSrc, unsigned int altNMinus1)
+{
+    dmaBegin (chan, primNMinus1 + 1, true);
+    DMA_ActivatePingPong(chan, useBurst, primDst, primSrc, primNMinus1,
+			 altDst, altSrc, altNMinus1);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Refresh a Ping-Pong Descriptor
+ *
+ * This is a wrapper for DMA_RefreshPingPong(), see there for the parameters.
+ * It is usually called from the callback function of the driver for the
+ * descriptor that has just been completed.
+ *
+ ******************************************************************************/
+void	DmaRefreshPingPong (int chan, bool primary, bool useBurst, void *dst,
+			    void *src, unsigned int nMinus1, bool last)
+{
+    l_Chan[chan].Stat.Items += nMinus1 + 1;
+    if (last)
+	l_Chan[chan].PingPong = false;	// ends with the next completion
+
+    DMA_RefreshPingPong(chan, primary, useBurst, dst, src, nMinus1, last);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a Scatter-Gather Transfer
+ *
+ * This is a wrapper for DMA_ActivateScatterGather(), see there for the
+ * parameters.  The alternate descriptors must have been configured by
+ * DMA_CfgDescrScatterGather() before.  Since the number of items per task is
+ * not known here, the number of tasks is counted as items.
+ *
+ ******************************************************************************/
+void	DmaStartScatterGather (int chan, bool useBurst,
+			       DMA_DESCRIPTOR_TypeDef *altDescr,
+			       unsigned int count)
+{
+    dmaBegin (chan, count, false);
+    DMA_ActivateScatterGather(chan, useBurst, altDescr, count);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Stop a Transfer
+ *
+ * This routine disables the specified channel and marks it as inactive.
+ *
+ ******************************************************************************/
+void	DmaStop (int chan)
+{
+    if (chan < 0  ||  chan >= DMA_CHAN_COUNT)
+	return;
+
+    DMA->CHENC = (1 << chan);		// disable channel
+
+    INT_Disable();
+    dmaEnd (chan);
+    INT_Enable();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Transfer is active
+ *
+ ******************************************************************************/
+bool	DmaIsActive (int chan)
+{
+    if (chan < 0  ||  chan >= DMA_CHAN_COUNT)
+	return false;
+
+    return l_Chan[chan].Active;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get Channel Statistics
+ *
+ * This routine returns a copy of the utilization counters of the specified
+ * channel.  The busy time of an active transfer is included.
+ *
+ ******************************************************************************/
+void	DmaChannelStatistics (int chan, DMA_STAT *pStat)
+{
+uint32_t ticks;
+
+
+    if (chan < 0  ||  chan >= DMA_CHAN_COUNT)
+	return;
+
+    INT_Disable();
+    *pStat = l_Chan[chan].Stat;
+    if (l_Chan[chan].Active)
+    {
+	ticks = (msDelayStart() - l_Chan[chan].StartCnt) & 0xFFFFFF;
+	pStat->BusyMs += ticks * 1000 / RTC_COUNTS_PER_SEC;
+    }
+    INT_Enable();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log Statistics of all Channels
+ *
+ * This routine logs the utilization counters of all allocated channels.
+ * Example:
+ *
+ * DMA 1 LEUART_TX: 1520 transfers, 1520 done, 96340 items, busy 100354ms
+ *
+ ******************************************************************************/
+void	DmaLogStatistics (void)
+{
+DMA_STAT stat;
+int	 chan;
+
+
+    for (chan = 0;  chan < DMA_CHAN_COUNT;  chan++)
+    {
+	if (l_Chan[chan].Name == NULL)
+	    continue;
+
+	DmaChannelStatistics (chan, &stat);
+	Log ("DMA %d %s: %ld transfers, %ld done, %ld items, busy %ldms",
+	     chan, l_Chan[chan].Name, stat.Transfers, stat.Done, stat.Items,
+	     stat.BusyMs);
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Begin of a Transfer
+ *
+ * This routine marks the channel as active, updates the counters, and sets
+ * the EM1 requirement if necessary.
+ *
+ ******************************************************************************/
+static void dmaBegin(int chan, uint32_t items, bool pingPong)
+{
+    EFM_ASSERT(0 <= chan  &&  chan < DMA_CHAN_COUNT
+	       &&  l_Chan[chan].Name != NULL);
+
+    INT_Disable();
+    l_Chan[chan].Stat.Transfers++;
+    l_Chan[chan].Stat.Items += items;
+    l_Chan[chan].PingPong = pingPong;
+
+    if (! l_Chan[chan].Active)
+    {
+	l_Chan[chan].Active = true;
+	l_Chan[chan].StartCnt = msDelayStart();
+
+	if (l_Chan[chan].EmLevel == DMA_EM1  &&  l_EM1_ActiveCnt++ == 0)
+	    Bit(g_EM1_ModuleMask, EM1_MOD_DMA) = 1;
+    }
+    INT_Enable();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	End of a Transfer
+ *
+ * This routine marks the channel as inactive, accumulates the busy time, and
+ * clears the EM1 requirement if no other transfer needs it.  It must be
+ * called with interrupts disabled.
+ *
+ ******************************************************************************/
+static void dmaEnd(int chan)
+{
+uint32_t ticks;
+
+
+    if (! l_Chan[chan].Active)
+	return;
+
+    l_Chan[chan].Active = false;
+    ticks = (msDelayStart() - l_Chan[chan].StartCnt) & 0xFFFFFF;
+    l_Chan[chan].Stat.BusyMs += ticks * 1000 / RTC_COUNTS_PER_SEC;
+
+    if (l_Chan[chan].EmLevel == DMA_EM1  &&  --l_EM1_ActiveCnt == 0)
+	Bit(g_EM1_ModuleMask, EM1_MOD_DMA) = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	DMA Completion Dispatcher
+ *
+ * This routine is called by the DMA interrupt handler of the emlib when a
+ * transfer has been completed.  For basic and scatter-gather transfers the
+ * channel is marked inactive before the callback of the driver is executed,
+ * so the driver may immediately start the next transfer.  Ping-pong channels
+ * remain active until their last descriptor has been completed.
+ *
+ ******************************************************************************/
+static void dmaDone(unsigned int channel, bool primary, void *user)
+{
+volatile DMA_CHAN *pChan = &l_Chan[channel];
+uint32_t now;
+
+
+    (void) user;
+
+    pChan->Stat.Done++;
+
+    if (pChan->PingPong)
+    {
+	/* account the busy time so far, the channel keeps running */
+	now = msDelayStart();
+	pChan->Stat.BusyMs += ((now - pChan->StartCnt) & 0xFFFFFF)
+			      * 1000 / RTC_COUNTS_PER_SEC;
+	pChan->StartCnt = now;
+    }
+    else
+    {
+	dmaEnd (channel);
+    }
+
+    if (pChan->CbFunc != NULL)
+	pChan->CbFunc (channel, primary, pChan->UserPtr);
+}
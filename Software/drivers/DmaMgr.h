@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module DmaMgr.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_DmaMgr_h
+#define __INC_DmaMgr_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_dma.h"
+#include "config.h"		// include project configuration parameters
+
+/*=============================== Definitions ================================*/
+
+/*!@brief Energy Mode a DMA channel requires while a transfer is active.
+ *
+ * Peripherals of the low energy domain (LEUART, LETIMER) are able to wake
+ * up the DMA from EM2.  All others, e.g. USART, ADC, or memory transfers,
+ * need the high frequency clocks, i.e. EM1.
+ */
+typedef enum
+{
+    DMA_EM1,			//!< Transfer requires EM1
+    DMA_EM2			//!< Transfer also works in EM2
+} DMA_EM_LEVEL;
+
+/*!@brief Statistics of one DMA channel, see DmaChannelStatistics(). */
+typedef struct
+{
+    uint32_t	Transfers;	//!< Number of activated transfers
+    uint32_t	Done;		//!< Number of completed transfers (callbacks)
+    uint32_t	Items;		//!< Number of transferred items
+    uint32_t	BusyMs;		//!< Time in [ms] the channel has been active
+} DMA_STAT;
+
+/*================================ Prototypes ================================*/
+
+    /* Initialize the DMA controller and the channel manager */
+void	DmaInit (void);
+
+    /* Allocate and free a DMA channel */
+int	DmaChannelAlloc (const char *name, unsigned int select, bool highPri,
+			 DMA_EM_LEVEL emLevel, DMA_FuncPtr_TypeDef cbFunc,
+			 void *userPtr);
+void	DmaChannelFree (int chan);
+
+    /* Start transfers in the different DMA modes */
+void	DmaStartBasic (int chan, bool primary, bool useBurst, void *dst,
+		       void *src, unsigned int nMinus1);
+void	DmaStartPingPong (int chan, bool useBurst,
+			  void *primDst, void *primSrc, unsigned int primNMinus1,
+			  void *altDst, void *altSrc, unsigned int altNMinus1);
+void	DmaRefreshPingPong (int chan, bool primary, bool useBurst, void *dst,
+			    void *src, unsigned int nMinus1, bool last);
+void	DmaStartScatterGather (int chan, bool useBurst,
+			       DMA_DESCRIPTOR_TypeDef *altDescr,
+			       unsigned int count);
+void	DmaStop (int chan);
+bool	DmaIsActive (int chan);
+
+    /* Utilization counters */
+void	DmaChannelStatistics (int chan, DMA_STAT *pStat);
+void	DmaLogStatistics (void);
+
+
+#endif /* __INC_DmaMgr_h */
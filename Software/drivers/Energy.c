@@ -0,0 +1,221 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Energy Integration for the Power Outputs
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module integrates the energy of a power output from samples of its
+ * voltage and current.  The samples are the averages of the ADC scan, see
+ * Control.c, and are not equidistant, so EnergyAdd() gets the time since
+ * the previous sample in RTC ticks and integrates by the trapezoidal rule.
+ * EnergyStart() marks the time an output has been switched on, the first
+ * sample then counts back to this time.  The first sample after EnergyReset()
+ * or EnergyPause() only sets the start value.  Power is calculated in [uW],
+ * the energy is kept in [mWs] with the remainder in [uWs], so rounding
+ * errors do not add up over a day.
+ * EnergyAddPower() takes the power of a sample directly, e.g. the mean of
+ * the products of voltage and current, which is the true average power of
+ * a pulsed load.
+ *
+ * EnergyState() compares the used energy with the daily budget in [mWh].
+ * The module has no hardware dependencies, so the same code is validated
+ * on the host by the tool EnergySim against simulated load profiles.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Added EnergyAddPower() for the true average power of the
+		pair sampling of Control.c.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "Energy.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Milliwatt seconds per milliwatt hour. */
+#define mWs_PER_mWh	3600
+
+
+/***************************************************************************//**
+ *
+ * @brief	Reset Energy Counter
+ *
+ * This routine clears the used energy, e.g. at the daily reset time.  The
+ * budget is not changed.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ ******************************************************************************/
+void	EnergyReset (ENERGY *pEnergy)
+{
+    pEnergy->Used = 0;
+    pEnergy->Rest = 0;
+    pEnergy->flgPower = false;
+    pEnergy->flgStart = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start the Integration
+ *
+ * This routine must be called when the output has been switched on.  The
+ * first sample is integrated back to this time, so the energy until the first
+ * measurement is not lost.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ ******************************************************************************/
+void	EnergyStart (ENERGY *pEnergy)
+{
+    pEnergy->flgStart = true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Sample
+ *
+ * This routine adds the energy since the previous sample.  The power is
+ * assumed to change linearly between two samples.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ * @param[in] mV
+ *	Voltage of the sample in [mV].
+ *
+ * @param[in] mA
+ *	Current of the sample in [mA].
+ *
+ * @param[in] ticks
+ *	Time since the previous sample in 1/@ref ENERGY_TICKS_PER_SEC seconds.
+ *	Gaps longer than @ref ENERGY_MAX_GAP seconds are not integrated.
+ *
+ ******************************************************************************/
+void	EnergyAdd (ENERGY *pEnergy, uint32_t mV, uint32_t mA, uint32_t ticks)
+{
+    EnergyAddPower (pEnergy, mV * mA, ticks);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Power Sample
+ *
+ * This routine is the same as EnergyAdd(), but takes the power of the
+ * sample instead of voltage and current.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ * @param[in] power
+ *	Power of the sample in [uW].
+ *
+ * @param[in] ticks
+ *	Time since the previous sample in 1/@ref ENERGY_TICKS_PER_SEC seconds.
+ *
+ ******************************************************************************/
+void	EnergyAddPower (ENERGY *pEnergy, uint32_t power, uint32_t ticks)
+{
+uint64_t uWs;
+
+
+    if (pEnergy->flgStart)
+    {
+	/* first sample after switch-on, assume constant power since then */
+	pEnergy->Power = power;
+	pEnergy->flgPower = true;
+	pEnergy->flgStart = false;
+    }
+
+    if (pEnergy->flgPower  &&  ticks <= ENERGY_MAX_GAP * ENERGY_TICKS_PER_SEC)
+    {
+	/* trapezoid: average power of both samples times duration */
+	uWs = ((uint64_t)pEnergy->Power + power) * ticks
+	      / (2 * ENERGY_TICKS_PER_SEC);
+
+	uWs += pEnergy->Rest;
+	pEnergy->Used += (uint32_t)(uWs / 1000);
+	pEnergy->Rest  = (uint32_t)(uWs % 1000);
+    }
+
+    pEnergy->Power = power;
+    pEnergy->flgPower = true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Pause the Integration
+ *
+ * This routine must be called when the measuring has been stopped, so the
+ * time until it is started again is not integrated.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ ******************************************************************************/
+void	EnergyPause (ENERGY *pEnergy)
+{
+    pEnergy->flgPower = false;
+    pEnergy->flgStart = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Used Energy
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ * @return
+ *	Energy since the last reset in [mWh].
+ *
+ ******************************************************************************/
+uint32_t EnergyUsed (const ENERGY *pEnergy)
+{
+    return pEnergy->Used / mWs_PER_mWh;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	State of the Budget
+ *
+ * This routine compares the used energy with the daily budget.
+ *
+ * @param[in] pEnergy
+ *	Energy counter of the power output.
+ *
+ * @param[in] warnLevel
+ *	Warning level in percent of the budget.
+ *
+ * @return
+ *	@ref ENERGY_OK if there is no budget, or the used energy is below the
+ *	warning level, @ref ENERGY_WARN if the warning level has been reached,
+ *	and @ref ENERGY_CUT_OFF if the budget is used up.
+ *
+ ******************************************************************************/
+ENERGY_STATE EnergyState (const ENERGY *pEnergy, uint32_t warnLevel)
+{
+uint64_t budget;	// [mWs]
+
+
+    if (pEnergy->Budget == 0)
+	return ENERGY_OK;
+
+    budget = (uint64_t)pEnergy->Budget * mWs_PER_mWh;
+    if (pEnergy->Used >= budget)
+	return ENERGY_CUT_OFF;
+
+    if ((uint64_t)pEnergy->Used * 100 >= budget * warnLevel)
+	return ENERGY_WARN;
+
+    return ENERGY_OK;
+}
@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module Energy.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool EnergySim.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_Energy_h
+#define __INC_Energy_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Time base of EnergyAdd(), this is the RTC frequency in [Hz]. */
+#define ENERGY_TICKS_PER_SEC	32768
+
+    /*!@brief Maximum time between two samples in [s], the RTC counter has
+     * 24 bits and wraps around after 512s.  A longer gap is not integrated.
+     */
+#define ENERGY_MAX_GAP		500
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief State of the daily energy budget, see EnergyState(). */
+typedef enum
+{
+    ENERGY_OK,		//!< No budget, or below the warning level
+    ENERGY_WARN,	//!< Warning level of the budget reached
+    ENERGY_CUT_OFF,	//!< Budget used up, output must be switched off
+} ENERGY_STATE;
+
+    /*!@brief Energy counter of a power output. */
+typedef struct
+{
+    uint32_t	Budget;		//!< Daily budget in [mWh], 0 for none
+    uint32_t	Used;		//!< Energy since the last reset in [mWs]
+    uint32_t	Rest;		//!< Remainder of Used in [uWs]
+    uint32_t	Power;		//!< Power of the previous sample in [uW]
+    bool	flgPower;	//!< Power holds a valid sample
+    bool	flgStart;	//!< Next sample is the first after EnergyStart()
+} ENERGY;
+
+/*================================ Prototypes ================================*/
+
+    /* Clear the energy counter, the budget remains */
+void	EnergyReset (ENERGY *pEnergy);
+
+    /* Add a sample of voltage and current */
+void	EnergyAdd (ENERGY *pEnergy, uint32_t mV, uint32_t mA, uint32_t ticks);
+void	EnergyAddPower (ENERGY *pEnergy, uint32_t power, uint32_t ticks);
+
+    /* Start and end of a measuring period */
+void	EnergyStart (ENERGY *pEnergy);
+void	EnergyPause (ENERGY *pEnergy);
+
+    /* Used energy in [mWh] */
+uint32_t EnergyUsed (const ENERGY *pEnergy);
+
+    /* Compare the used energy with the budget */
+ENERGY_STATE EnergyState (const ENERGY *pEnergy, uint32_t warnLevel);
+
+
+#endif /* __INC_Energy_h */
@@ -19,6 +19,9 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent EXTIs that occur while the FLASH is busy are captured with
+		their time stamp and level by EXTI_Capture(), and dispatched
+		by EXTI_Handler() afterwards.
 2018-03-14,rage	Set interrupt priority for GPIO_EVEN_IRQn and GPIO_ODD_IRQn.
 2017-05-12,rage	Implemented ExtIntReplay().
 2017-05-02,rage	ExtIntEnableAll: Manually set all configured EXTI interrupts to
@@ -43,14 +46,26 @@ Revision History:
 #include "em_device.h"
 #include "em_assert.h"
 #include "em_bitband.h"
+#include "FlashProg.h"
 #include "config.h"		// include project configuration parameters
 
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Number of EXTI events that can be captured while the FLASH is
+     * busy, see EXTI_Capture().
+     */
+#define EXTI_CAPTURE_SIZE	8
 
 /*=========================== Typedefs and Structs ===========================*/
 
+    /*!@brief EXTI event that has been captured while the FLASH was busy. */
+typedef struct
+{
+    uint32_t	TimeStamp;	//!< RTC value of the event
+    uint16_t	Status;		//!< Bit mask of the asserted EXTIs
+    uint16_t	Level;		//!< Level of these EXTIs
+} EXTI_CAPTURE;
 
 /*======================== External Data and Routines ========================*/
 
@@ -69,9 +84,17 @@ static volatile uint32_t l_extiBitMask;
     /*! Flag is set during the "replay" of external interrupts */
 static volatile bool	 l_flgExtiReplay;
 
+    /*! EXTI events captured while the FLASH was busy */
+static volatile EXTI_CAPTURE l_ExtiCapture[EXTI_CAPTURE_SIZE];
+static volatile int	 l_ExtiCaptureCnt;
+
 /*=========================== Forward Declarations ===========================*/
 
 void	EXTI_Handler (void);
+static void	extiDispatch (uint32_t status, uint32_t level,
+			      uint32_t timeStamp);
+static FLASH_RAMFUNC uint32_t extiLevel (uint32_t status);
+static FLASH_RAMFUNC bool     EXTI_Capture (void);
 
 
 /***************************************************************************//**
@@ -126,6 +149,10 @@ void	ExtIntInit (const EXTI_INIT *pInitStruct)
     GPIO->EXTIRISE = l_extiBitMask;
     GPIO->EXTIFALL = l_extiBitMask;
 
+    /* Capture EXTIs while the FLASH is busy */
+    FlashProgCapture (GPIO_EVEN_IRQn, EXTI_Capture);
+    FlashProgCapture (GPIO_ODD_IRQn, EXTI_Capture);
+
     /* Clear and enable NVIC interrupts */
     NVIC_SetPriority(GPIO_EVEN_IRQn, INT_PRIO_EXTI);
     NVIC_ClearPendingIRQ (GPIO_EVEN_IRQn);
@@ -274,8 +301,11 @@ void	GPIO_ODD_IRQHandler (void)
  * This is the handler for the EXTernal Interrupts (EXTI).  It is triggered for
  * all configured and enabled EXTIs, either for a rising, or a falling edge.
  * The sequence of operations in detail:
+ * -# Dispatch the EXTIs that have been captured while the FLASH was busy,
+ *    see EXTI_Capture().
  * -# Receive EXTI on rising or falling edge.
  * -# Read current RTC value for time stamp.
+ * -# Determine the current level of all asserted EXTIs.
  * -# For each interrupt perform the following actions:
  *    - Determine and call the corresponding handler.
  *    - Change the trigger type, i.e. rising to falling edge, and vice versa.
@@ -292,12 +322,18 @@ void	EXTI_Handler (void)
 {
 uint32_t  timeStamp;		// current time value from RTC
 uint32_t  status;		// interrupt status flags
-uint32_t  irqMask;		// bit mask of active external interrupts
-int	  extiNum;		// EXTI number
-uint32_t  extiBitMask;		// bit mask for EXTI number <extiNum>
-int	  portNum;		// GPIO port number of an EXTI
-bool	  extiLvl;		// current level of EXTI
-const EXTI_INIT *pExtIntCfg;	// pointer to EXTI configuration data
+int	  i;
+
+    /* first dispatch the EXTIs captured during FLASH programming */
+    if (l_ExtiCaptureCnt > 0)
+    {
+	for (i = 0;  i < l_ExtiCaptureCnt;  i++)
+	    extiDispatch (l_ExtiCapture[i].Status, l_ExtiCapture[i].Level,
+			  l_ExtiCapture[i].TimeStamp);
+	l_ExtiCaptureCnt = 0;
+
+	g_flgIRQ = true;	// keep on running
+    }
 
     /* get time stamp from RTC, or set 0 for "replay" */
     timeStamp = l_flgExtiReplay ? 0 : RTC->CNT;
@@ -310,6 +346,40 @@ const EXTI_INIT *pExtIntCfg;	// pointer to EXTI configuration data
     if (status == 0)
 	return;
 
+    /* process all asserted EXTIs */
+    extiDispatch (status, extiLevel (status), timeStamp);
+
+    /* clear interrupt status bits */
+    GPIO->IFC = status;
+
+    g_flgIRQ = true;	// keep on running
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Dispatch EXTIs
+ *
+ * This routine calls the handlers of all asserted EXTIs in use.
+ *
+ * @param[in] status
+ *	Bit mask of the asserted EXTIs.
+ *
+ * @param[in] level
+ *	Level of the EXTI inputs, bit <i>n</i> stands for EXTI <i>n</i>.
+ *
+ * @param[in] timeStamp
+ *	RTC value of the interrupt, 0 for a "replay".
+ *
+ ******************************************************************************/
+static void	extiDispatch (uint32_t status, uint32_t level,
+			      uint32_t timeStamp)
+{
+uint32_t  irqMask;		// bit mask of active external interrupts
+int	  extiNum;		// EXTI number
+uint32_t  extiBitMask;		// bit mask for EXTI number <extiNum>
+bool	  extiLvl;		// current level of EXTI
+const EXTI_INIT *pExtIntCfg;	// pointer to EXTI configuration data
+
     /* get all EXTIs in use (rising and falling edge) */
     irqMask = status & l_extiBitMask;
 
@@ -323,14 +393,8 @@ const EXTI_INIT *pExtIntCfg;	// pointer to EXTI configuration data
 	/* remove this interrupt from the bit mask */
 	irqMask &= ~extiBitMask;
 
-	/* get associated port number */
-	if (extiNum < 8)
-	    portNum = (GPIO->EXTIPSELL >> (extiNum * 4)) & 0x7;
-	else
-	    portNum = (GPIO->EXTIPSELH >> ((extiNum-8) * 4)) & 0x7;
-
 	/* determine whether rising or falling edge */
-	extiLvl = GPIO->P[portNum].DIN & extiBitMask ? true : false;
+	extiLvl = level & extiBitMask ? true : false;
 
 	/* see which functions to be called for this EXTI */
 	for (pExtIntCfg = l_pExtIntCfg;
@@ -343,9 +407,83 @@ const EXTI_INIT *pExtIntCfg;	// pointer to EXTI configuration data
 	    }
 	}
     }
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Determine the Level of EXTIs
+ *
+ * This routine reads the current level of the GPIO inputs that are connected
+ * to the specified EXTIs.  It is executed from RAM, because it is also used
+ * by EXTI_Capture().
+ *
+ * @param[in] status
+ *	Bit mask of the EXTIs.
+ *
+ * @return
+ *	Level of the EXTI inputs, bit <i>n</i> stands for EXTI <i>n</i>.
+ *
+ ******************************************************************************/
+static FLASH_RAMFUNC uint32_t extiLevel (uint32_t status)
+{
+uint32_t  level = 0;		// level of the EXTIs
+int	  extiNum;		// EXTI number
+int	  portNum;		// GPIO port number of an EXTI
+
+    for (extiNum = 0;  extiNum < 16;  extiNum++)
+    {
+	if ((status & (0x1 << extiNum)) == 0)
+	    continue;
+
+	/* get associated port number */
+	if (extiNum < 8)
+	    portNum = (GPIO->EXTIPSELL >> (extiNum * 4)) & 0x7;
+	else
+	    portNum = (GPIO->EXTIPSELH >> ((extiNum-8) * 4)) & 0x7;
+
+	if (GPIO->P[portNum].DIN & (0x1 << extiNum))
+	    level |= (0x1 << extiNum);
+    }
+
+    return level;
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Capture EXTIs while the FLASH is busy
+ *
+ * This routine is executed from RAM instead of the EXTI interrupt handlers
+ * during FLASH programming, see FlashProgCapture().  It saves the time stamp
+ * and the level of the asserted EXTIs, so EXTI_Handler() dispatches them
+ * afterwards as if they had been handled in time.
+ *
+ * @return
+ *	<i>false</i> if there is no space left to capture the EXTIs.
+ *
+ ******************************************************************************/
+static FLASH_RAMFUNC bool EXTI_Capture (void)
+{
+volatile EXTI_CAPTURE *pCapture;
+uint32_t  status;		// interrupt status flags
+
+    /* get EXTI status and mask out all disabled interrupts */
+    status  = GPIO->IF;
+    status &= GPIO->IEN;
+
+    if (status == 0)
+	return true;
+
+    if (l_ExtiCaptureCnt >= EXTI_CAPTURE_SIZE)
+	return false;		// hold off until the FLASH is ready
+
+    pCapture = &l_ExtiCapture[l_ExtiCaptureCnt];
+    pCapture->TimeStamp = l_flgExtiReplay ? 0 : RTC->CNT;
+    pCapture->Status = (uint16_t)status;
+    pCapture->Level  = (uint16_t)extiLevel (status);
+    l_ExtiCaptureCnt++;
 
     /* clear interrupt status bits */
     GPIO->IFC = status;
 
-    g_flgIRQ = true;	// keep on running
+    return true;
 }
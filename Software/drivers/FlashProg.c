@@ -0,0 +1,396 @@
+/***************************************************************************//**
+ * @file
+ * @brief	FLASH Programming without Interrupt Blackout
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module writes words to, and erases pages of the FLASH, e.g. for the
+ * EEPROM emulation.  While the FLASH is busy, it cannot be read, so neither
+ * code nor interrupt vectors can be fetched from it.  A page erase takes
+ * about 20ms, during which the RTC tick, the DCF77 edges, the bytes of the
+ * RFID reader, and the ADC conversions would have to wait.
+ *
+ * Therefore the routines that start a FLASH operation and wait for its end
+ * are executed from RAM, see @ref FLASH_RAMFUNC.  During the operation, the
+ * vector table is switched to a copy in RAM.  The interrupts that have been
+ * registered via FlashProgCapture() stay enabled, their capture function is
+ * called instead of the interrupt handler.  It saves the data of the
+ * peripheral, e.g. a received byte, and the interrupt handler is triggered
+ * afterwards to process it.  All other interrupts are held off until the
+ * operation has finished.  The RTC interrupt need not be captured, because
+ * the time is kept by the RTC counter itself, and the next compare value is
+ * always derived from the previous one.  Like any interrupt, a captured one
+ * must have a higher priority than the calling context to be served, e.g.
+ * the calibration data is saved from the key handler at @ref INT_PRIO_EXTI,
+ * so EXTIs are dispatched when this handler returns.
+ *
+ * All interrupts are disabled only while the vector table and the interrupt
+ * enable bits are switched, i.e. a few microseconds.  These lockout times
+ * and the busy times of the FLASH are measured with the cycle counter of the
+ * DWT, see FlashProgStatGet().
+ *
+ * Each word write and page erase is a separate operation, so interrupts are
+ * served normally between them, e.g. during a page transfer of the EEPROM
+ * emulation.  The FLASH controller of the EFM32G cannot suspend a page
+ * erase, so this is the longest step.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "FlashProg.h"
+#include "em_assert.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Number of entries of the vector table: the 16 system exceptions
+     * and the 32 interrupts of register NVIC->ISER[0], the EFM32G uses 30.
+     */
+#define NUM_VECTORS	(16 + 32)
+
+/*================================ Local Data ================================*/
+
+    /*!@brief   Vector table in RAM, it is active while the FLASH is busy.
+     * @details The Cortex-M3 requires the table to be aligned to its size,
+     * rounded up to a power of two.  GCC places section <b>vtable</b> at the
+     * start of the RAM, see efm32g_0x8000.ld, so no space is lost.
+     */
+#if defined(__ICCARM__)
+#pragma data_alignment=256
+static void (* l_RamVectors[NUM_VECTORS])(void);
+#else
+static void (* l_RamVectors[NUM_VECTORS])(void)
+			__attribute__ ((section("vtable"), aligned(256)));
+#endif
+
+    /*! Flag if the vector table has been copied, see FlashProgInit() */
+static bool	 l_flgInit;
+
+    /*! Capture functions of the interrupts, see FlashProgCapture() */
+static FLASH_CAPTURE_FCT volatile l_CaptureFct[32];
+
+    /*! Bit mask of the interrupts that have a capture function */
+static volatile uint32_t l_CaptureMask;
+
+    /*! Bit mask of the interrupts that have been captured */
+static volatile uint32_t l_CaptureFired;
+
+    /*! Cycles of the last operation with all IRQs disabled, and FLASH busy */
+static uint32_t	 l_OpLockout, l_OpBusy;
+
+    /*! Statistics of the FLASH operations */
+static FLASH_PROG_STAT l_Stat;
+
+/*=========================== Forward Declarations ===========================*/
+
+static FLASH_RAMFUNC void captureDispatch (void);
+static FLASH_RAMFUNC msc_Return_TypeDef flashExec (uint32_t *pAddr,
+						  uint32_t cmd, uint32_t data);
+static void	statUpdate (void);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Initialize FLASH Programming
+ *
+ * This routine unlocks the FLASH controller, copies the current vector table
+ * to RAM, and starts the cycle counter.  It must be called before any other
+ * routine of this module except FlashProgCapture().
+ *
+ ******************************************************************************/
+void	FlashProgInit (void)
+{
+const uint32_t *pVectors = (const uint32_t *)(uintptr_t)SCB->VTOR;
+int	i;
+
+    /* Enables the flash controller for writing */
+    MSC_Init();
+
+    /* Copy the vector table, keep the captured interrupts */
+    for (i = 0;  i < NUM_VECTORS;  i++)
+    {
+	if (i >= 16  &&  (l_CaptureMask & (1 << (i - 16))))
+	    l_RamVectors[i] = captureDispatch;
+	else
+	    l_RamVectors[i] = (void (*)(void))(uintptr_t)pVectors[i];
+    }
+    l_flgInit = true;
+
+    /* The cycle counter measures the lockout and busy times */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Capture an Interrupt while the FLASH is busy
+ *
+ * This routine registers a capture function for an interrupt.  It is called
+ * instead of the interrupt handler while the FLASH is busy.  The interrupt
+ * handler is triggered when the FLASH operation is finished, it must first
+ * process the data that has been saved by the capture function.
+ *
+ * @param[in] irq
+ *	Interrupt number.
+ *
+ * @param[in] pFct
+ *	Capture function, see @ref FLASH_CAPTURE_FCT.
+ *
+ ******************************************************************************/
+void	FlashProgCapture (IRQn_Type irq, FLASH_CAPTURE_FCT pFct)
+{
+    /* Parameter check */
+    EFM_ASSERT(0 <= irq  &&  irq < 32  &&  pFct != NULL);
+
+    l_CaptureFct[irq] = pFct;
+    l_CaptureMask |= (1 << irq);
+    l_RamVectors[16 + irq] = captureDispatch;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Write a Word to FLASH
+ *
+ * @param[in] pAddr
+ *	Address of the word, it must have been erased before.
+ *
+ * @param[in] data
+ *	Data to write.
+ *
+ * @return
+ *	Status of the operation, see @ref msc_Return_TypeDef.
+ *
+ ******************************************************************************/
+msc_Return_TypeDef FlashProgWrite (uint32_t *pAddr, uint32_t data)
+{
+msc_Return_TypeDef rc;
+
+    /* Parameter check */
+    EFM_ASSERT(l_flgInit  &&  ((uintptr_t)pAddr & 0x3) == 0);
+
+    rc = flashExec (pAddr, MSC_WRITECMD_WRITEONCE, data);
+    l_Stat.Writes++;
+    statUpdate();
+
+    return rc;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Erase a FLASH Page
+ *
+ * @param[in] pPage
+ *	Start address of the page.
+ *
+ * @return
+ *	Status of the operation, see @ref msc_Return_TypeDef.
+ *
+ ******************************************************************************/
+msc_Return_TypeDef FlashProgErase (uint32_t *pPage)
+{
+msc_Return_TypeDef rc;
+
+    /* Parameter check */
+    EFM_ASSERT(l_flgInit  &&  ((uintptr_t)pPage & (FLASH_PAGE_SIZE - 1)) == 0);
+
+    rc = flashExec (pPage, MSC_WRITECMD_ERASEPAGE, 0);
+    l_Stat.Erases++;
+    statUpdate();
+
+    return rc;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get the Statistics of the FLASH Operations
+ *
+ * This routine returns the number of operations, and the longest times all
+ * interrupts have been disabled, or the FLASH has been busy, since the last
+ * call of FlashProgStatClear().
+ *
+ * @param[out] pStat
+ *	Statistics, see @ref FLASH_PROG_STAT.
+ *
+ ******************************************************************************/
+void	FlashProgStatGet (FLASH_PROG_STAT *pStat)
+{
+    *pStat = l_Stat;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Clear the Statistics of the FLASH Operations
+ *
+ ******************************************************************************/
+void	FlashProgStatClear (void)
+{
+    l_Stat.Writes = l_Stat.Erases = 0;
+    l_Stat.LockoutMax = l_Stat.BusyMax = l_Stat.BusySum = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Dispatch a captured Interrupt
+ *
+ * This routine is entered via the RAM vector table for all interrupts that
+ * have a capture function.  If the capture function could not save the data,
+ * the interrupt is disabled until the FLASH operation has been finished.
+ *
+ ******************************************************************************/
+static FLASH_RAMFUNC void captureDispatch (void)
+{
+uint32_t irq = (__get_IPSR() & 0x1FF) - 16;
+
+    if (! l_CaptureFct[irq]())
+	NVIC->ICER[0] = (1 << irq);	// hold off until the FLASH is ready
+
+    l_CaptureFired |= (1 << irq);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Execute a FLASH Operation
+ *
+ * This routine starts a FLASH operation and waits until it has finished.  It
+ * is executed from RAM, see the module description for the handling of the
+ * interrupts.  The times all interrupts have been disabled, and the FLASH
+ * has been busy, are stored in @ref l_OpLockout and @ref l_OpBusy.
+ *
+ * @param[in] pAddr
+ *	Address of the word to write, or the page to erase.
+ *
+ * @param[in] cmd
+ *	MSC_WRITECMD_WRITEONCE or MSC_WRITECMD_ERASEPAGE.
+ *
+ * @param[in] data
+ *	Data to write.
+ *
+ * @return
+ *	Status of the operation, see @ref msc_Return_TypeDef.
+ *
+ ******************************************************************************/
+static FLASH_RAMFUNC msc_Return_TypeDef flashExec (uint32_t *pAddr,
+						  uint32_t cmd, uint32_t data)
+{
+msc_Return_TypeDef rc = mscReturnOk;
+uint32_t primask, vtor, iser, status;
+uint32_t opStart, start, lockout;
+uint32_t timeOut;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    opStart = start = DWT->CYCCNT;
+
+    /* Only the captured interrupts may occur while the FLASH is busy */
+    vtor = SCB->VTOR;
+    iser = NVIC->ISER[0];
+    NVIC->ICER[0] = iser & ~l_CaptureMask;
+    l_CaptureFired = 0;
+    SCB->VTOR = (uint32_t)(uintptr_t)l_RamVectors;
+    __DSB();
+
+    /* Load address */
+    MSC->WRITECTRL |= MSC_WRITECTRL_WREN;
+    MSC->ADDRB    = (uint32_t)(uintptr_t)pAddr;
+    MSC->WRITECMD = MSC_WRITECMD_LADDRIM;
+
+    status = MSC->STATUS;
+    if (status & MSC_STATUS_INVADDR)
+	rc = mscReturnInvalidAddr;
+    else if (status & MSC_STATUS_LOCKED)
+	rc = mscReturnLocked;
+    else if (cmd == MSC_WRITECMD_WRITEONCE)
+    {
+	for (timeOut = MSC_PROGRAM_TIMEOUT;
+	     (MSC->STATUS & MSC_STATUS_WDATAREADY) == 0;  timeOut--)
+	{
+	    if (timeOut == 0)
+	    {
+		rc = mscReturnTimeOut;
+		break;
+	    }
+	}
+	if (rc == mscReturnOk)
+	    MSC->WDATA = data;
+    }
+
+    if (rc == mscReturnOk)
+    {
+	/* Start the operation and let the captured interrupts in */
+	MSC->WRITECMD = cmd;
+	lockout = DWT->CYCCNT - start;
+	__set_PRIMASK(primask);
+
+	for (timeOut = MSC_PROGRAM_TIMEOUT;
+	     MSC->STATUS & MSC_STATUS_BUSY;  timeOut--)
+	{
+	    if (timeOut == 0)
+	    {
+		rc = mscReturnTimeOut;
+		break;
+	    }
+	}
+
+	__disable_irq();
+	start = DWT->CYCCNT;
+    }
+    else
+    {
+	lockout = 0;
+    }
+    l_OpBusy = DWT->CYCCNT - opStart;
+
+    MSC->WRITECTRL &= ~MSC_WRITECTRL_WREN;
+
+    /* Restore the vector table and the interrupts, process captured ones */
+    SCB->VTOR = vtor;
+    __DSB();
+    NVIC->ISER[0] = iser;
+    NVIC->ISPR[0] = l_CaptureFired;
+
+    if (primask)
+	lockout = DWT->CYCCNT - opStart;	// caller disabled all IRQs
+    else if (DWT->CYCCNT - start > lockout)
+	lockout = DWT->CYCCNT - start;
+    l_OpLockout = lockout;
+
+    __set_PRIMASK(primask);
+
+    return rc;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Update the Statistics
+ *
+ * This routine adds the times of the last FLASH operation to the statistics.
+ *
+ ******************************************************************************/
+static void	statUpdate (void)
+{
+uint32_t mhz = SystemCoreClockGet() / 1000000;
+uint32_t lockout, busy;
+
+    if (mhz == 0)
+	mhz = 1;
+
+    lockout = (l_OpLockout + mhz - 1) / mhz;
+    busy    = (l_OpBusy + mhz - 1) / mhz;
+
+    if (l_Stat.LockoutMax < lockout)
+	l_Stat.LockoutMax = lockout;
+    if (l_Stat.BusyMax < busy)
+	l_Stat.BusyMax = busy;
+    l_Stat.BusySum += busy;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module FlashProg.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_FlashProg_h
+#define __INC_FlashProg_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_msc.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief   Attribute to execute a function from RAM.
+     * @details Such a function must only access RAM and peripherals, i.e. it
+     * must not call any function, or read any constant, that is located in
+     * FLASH.  CMSIS intrinsics like __get_PRIMASK() are inlined and may be
+     * used.  GCC places the code into the <b>.ram</b> section, which is
+     * copied to RAM by the start-up code, see efm32g_0x8000.ld.
+     */
+#if defined(__ICCARM__)
+    #define FLASH_RAMFUNC	__ramfunc
+#elif defined(__GNUC__)
+    #define FLASH_RAMFUNC	__attribute__ ((section(".ram"), noinline))
+#else
+    #define FLASH_RAMFUNC
+#endif
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief   Capture function of an interrupt, see FlashProgCapture().
+     * @details It is called from RAM instead of the interrupt handler while
+     * the FLASH is busy.  It must be declared with @ref FLASH_RAMFUNC, save
+     * the data of the peripheral, and clear its interrupt flag.  If there is
+     * no more space to save the data, it returns <i>false</i> without
+     * clearing the flag, the interrupt is then held off until the FLASH is
+     * ready again.
+     */
+typedef bool (* FLASH_CAPTURE_FCT)(void);
+
+    /*!@brief Statistics of the FLASH operations, see FlashProgStatGet(). */
+typedef struct
+{
+    uint32_t	Writes;		//!< Number of words written
+    uint32_t	Erases;		//!< Number of pages erased
+    uint32_t	LockoutMax;	//!< Longest time all IRQs were disabled [us]
+    uint32_t	BusyMax;	//!< Longest FLASH operation [us], other IRQs
+				//!< than the captured ones are held off
+    uint32_t	BusySum;	//!< Total time the FLASH was busy [us]
+} FLASH_PROG_STAT;
+
+/*================================ Prototypes ================================*/
+
+    /* Initialize FLASH programming, see MSC_Init() */
+void	FlashProgInit (void);
+
+    /* Let an interrupt be served by a capture function during FLASH busy */
+void	FlashProgCapture (IRQn_Type irq, FLASH_CAPTURE_FCT pFct);
+
+    /* FLASH operations executed from RAM */
+msc_Return_TypeDef FlashProgWrite (uint32_t *pAddr, uint32_t data);
+msc_Return_TypeDef FlashProgErase (uint32_t *pPage);
+
+    /* Statistics of the FLASH operations */
+void	FlashProgStatGet   (FLASH_PROG_STAT *pStat);
+void	FlashProgStatClear (void);
+
+
+#endif /* __INC_FlashProg_h */
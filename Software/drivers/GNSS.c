@@ -0,0 +1,387 @@
+/***************************************************************************//**
+ * @file
+ * @brief	GNSS Time Source
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module synchronizes the system clock with a GNSS receiver, for boxes
+ * that cannot receive the DCF77 signal.  The receiver is connected to a UART
+ * for its NMEA sentences, and to an EXTI for its pulse-per-second (PPS)
+ * output, see the definitions in GNSS.h.
+ *
+ * In detail, it includes:
+ * - Switching the receiver on once per day at @ref GNSS_WAKE_UP_TIME, and
+ *   after power-up.  The daily wake-up is skipped, if another time source
+ *   has already synchronized the clock, see @ref GNSS_SKIP_AGE.
+ * - Receiving the RMC and ZDA sentences in the UART interrupt, see Nmea.c.
+ *   The time of a sentence refers to the previous PPS pulse, so the next PPS
+ *   pulse marks the start of the following second.
+ * - Setting the system clock on the rising edge of the PPS pulse, after
+ *   @ref GNSS_FIX_SEQ_CNT consecutive seconds have been received.  The clock
+ *   is set within the EXTI handler, so it is aligned to the PPS pulse within
+ *   the interrupt latency, i.e. far below one millisecond.  UTC is converted
+ *   to MEZ or MESZ, and alarm times are adjusted by TimeSourceSync().
+ * - Switching the receiver off after the first synchronization, or after
+ *   @ref GNSS_TIMEOUT seconds without a valid time.
+ *
+ * While the receiver is on, the UART requires EM1, see @ref EM1_MOD_GNSS.
+ * Time to sync and energy per sync are logged by TimeSourceStatistics(), to
+ * compare them with the DCF77 decoder.  The host tool <b>NmeaGen</b>
+ * generates NMEA streams for tests.
+ *
+ * @note
+ * To make the daily wake-up work, an enum @ref ALARM_GNSS_WAKE_UP of type
+ * @ref ALARM_ID must be defined in <i>config.h</i>.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_usart.h"
+#include "GNSS.h"
+#include "Nmea.h"
+#include "TimeSource.h"
+#include "ExtInt.h"
+#include "AlarmClock.h"
+#include "Logging.h"
+
+#if GNSS_TIME_SOURCE
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_GNSS
+
+/*================================ Local Data ================================*/
+
+    /*!@brief Flag if the receiver is switched on. */
+static volatile bool	 l_flgOn;
+
+    /*!@brief sTimer handle for the timeout. */
+static volatile TIM_HDL	 l_TimHdl = NONE;
+
+    /*!@brief NMEA parser, used by the UART interrupt. */
+static NMEA_PARSER	 l_Nmea;
+
+    /*!@brief UTC time of the last valid sentence (seconds since 2000). */
+static volatile uint32_t l_FixTime;
+
+    /*!@brief Number of consecutive seconds received. */
+static volatile uint8_t	 l_FixSeqCnt;
+
+    /*!@brief Flag is set when a valid sentence was received after the last
+     * PPS pulse.
+     */
+static volatile bool	 l_flgFixNew;
+
+    /*!@brief Number of PPS pulses while switched on. */
+static volatile uint32_t l_PpsCnt;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void	WakeUp (int alarmNum);
+static void	Timeout (TIM_HDL hdl);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Initialize GNSS hardware
+ *
+ * This routine initializes the GPIO pins which are connected to the external
+ * GNSS receiver, and the daily wake-up alarm.  The receiver remains off.
+ * Call GNSSEnable() after module ExtInt has been initialized.
+ *
+ ******************************************************************************/
+void	GNSSInit (void)
+{
+    /* Be sure to enable clock to GPIO (should already be done) */
+    CMU_ClockEnable (cmuClock_GPIO, true);
+
+    /* Supply of the receiver is off */
+    GPIO_PinModeSet (GNSS_ENABLE_PORT, GNSS_ENABLE_PIN, gpioModePushPull, 0);
+
+    /* RX pin is enabled together with the UART */
+    GPIO_PinModeSet (GNSS_RX_PORT, GNSS_RX_PIN, gpioModeDisabled, 0);
+
+    /*
+     * Configure the PPS input with pull-down, it floats while the receiver is
+     * off, and connect it to the external interrupt (EXTI) facility.  The
+     * interrupt is enabled by GNSSEnable().
+     */
+    GPIO_PinModeSet (GNSS_PPS_PORT, GNSS_PPS_PIN, gpioModeInputPull, 0);
+    GPIO_IntConfig  (GNSS_PPS_PORT, GNSS_PPS_PIN, false, false, false);
+
+    /* When called for the first time, allocate timer handle */
+    if (l_TimHdl == NONE)
+	l_TimHdl = sTimerCreate (Timeout);
+
+    /* Daily wake-up time */
+    AlarmAction (ALARM_GNSS_WAKE_UP, WakeUp);
+    AlarmSet (ALARM_GNSS_WAKE_UP, GNSS_WAKE_UP_TIME);
+    AlarmEnable (ALARM_GNSS_WAKE_UP);
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Switch the GNSS receiver on
+ *
+ * This routine switches the supply of the receiver on, sets up the UART to
+ * receive its NMEA sentences, and enables the PPS interrupt.  The receiver
+ * is switched off again by GNSSDisable(), after the clock has been set, or
+ * after @ref GNSS_TIMEOUT.
+ *
+ ******************************************************************************/
+void	GNSSEnable (void)
+{
+USART_InitAsync_TypeDef uartInit = USART_INITASYNC_DEFAULT;
+
+
+    if (l_flgOn)
+	return;			// already on
+
+#ifdef LOGGING
+    Log ("GNSS: Enabled");
+#endif
+
+    /* Reset the parser and the fix sequence */
+    NmeaInit (&l_Nmea);
+    l_FixSeqCnt = 0;
+    l_flgFixNew = false;
+    l_PpsCnt = 0;
+
+    /* Supply on */
+    GPIO->P[GNSS_ENABLE_PORT].DOUTSET = (1 << GNSS_ENABLE_PIN);
+
+    /* The UART requires EM1 */
+    Bit(g_EM1_ModuleMask, EM1_MOD_GNSS) = 1;
+
+    /* Enable clock for USART module, configure GPIO Rx pin */
+    CMU_ClockEnable (GNSS_UART_CLOCK, true);
+    GPIO_PinModeSet (GNSS_RX_PORT, GNSS_RX_PIN, gpioModeInput, 0);
+
+    /* Initialize UART in asynchronous mode, 8N1 */
+    uartInit.enable   = usartDisable;
+    uartInit.baudrate = GNSS_BAUDRATE;
+    USART_InitAsync (GNSS_UART, &uartInit);
+
+    /* Prepare UART Rx interrupts */
+    USART_IntClear (GNSS_UART, _USART_IF_MASK);
+    USART_IntEnable (GNSS_UART, USART_IF_RXDATAV);
+    NVIC_SetPriority (GNSS_UART_RX_IRQn, INT_PRIO_GNSS);
+    NVIC_ClearPendingIRQ (GNSS_UART_RX_IRQn);
+    NVIC_EnableIRQ (GNSS_UART_RX_IRQn);
+
+    /* Enable I/O pin and the receiver only */
+    GNSS_UART->ROUTE = USART_ROUTE_RXPEN | GNSS_UART_ROUTE;
+    USART_Enable (GNSS_UART, usartEnableRx);
+
+    /* PPS interrupt enable */
+    ExtIntEnable (GNSS_PPS_PIN);
+
+    /* Supervise the time to sync */
+    if (l_TimHdl != NONE)
+	sTimerStart (l_TimHdl, GNSS_TIMEOUT);
+
+    l_flgOn = true;
+    TimeSourceStart (TIME_SRC_GNSS);
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Switch the GNSS receiver off
+ *
+ * This routine disables the PPS interrupt and the UART, and switches the
+ * supply of the receiver off.
+ *
+ ******************************************************************************/
+void	GNSSDisable (void)
+{
+    if (! l_flgOn)
+	return;			// already off
+
+    l_flgOn = false;
+
+    /* Cancel timeout, PPS interrupt disable */
+    if (l_TimHdl != NONE)
+	sTimerCancel (l_TimHdl);
+    ExtIntDisable (GNSS_PPS_PIN);
+
+    /* Switch the UART off */
+    NVIC_DisableIRQ (GNSS_UART_RX_IRQn);
+    USART_Reset (GNSS_UART);
+    GPIO_PinModeSet (GNSS_RX_PORT, GNSS_RX_PIN, gpioModeDisabled, 0);
+    CMU_ClockEnable (GNSS_UART_CLOCK, false);
+    Bit(g_EM1_ModuleMask, EM1_MOD_GNSS) = 0;
+
+    /* Supply off */
+    GPIO->P[GNSS_ENABLE_PORT].DOUTCLR = (1 << GNSS_ENABLE_PIN);
+
+    TimeSourceStop (TIME_SRC_GNSS);
+
+#ifdef LOGGING
+    Log ("GNSS: Disabled, %ld sentences, %ld errors, %ld PPS",
+	 l_Nmea.Sentences, l_Nmea.Errors, l_PpsCnt);
+#endif
+}
+
+/***************************************************************************//**
+ *
+ * @brief	PPS handler
+ *
+ * This handler is called by the EXTI interrupt service routine whenever the
+ * logical level of the PPS signal changes.  The rising edge marks the start
+ * of a second.  If a valid sentence has been received during the previous
+ * second, and the sequence of consecutive seconds is long enough, the system
+ * clock is set to the time of this sentence plus one second.
+ *
+ * @param[in] extiNum
+ *	EXTernal Interrupt number of the PPS signal.  This is identical
+ *	with the pin number, i.e. @ref GNSS_PPS_PIN.
+ *
+ * @param[in] extiLvl
+ *	EXTernal Interrupt level: 0 means falling edge, 1 means rising edge.
+ *
+ * @param[in] timeStamp
+ *	Time stamp (24bit) when the signal has changed its level, 0 if the
+ *	interrupt has been "replayed".
+ *
+ ******************************************************************************/
+void	GNSSPpsHandler (int extiNum, bool extiLvl, uint32_t timeStamp)
+{
+struct tm  localTime;
+
+
+    (void) extiNum;	// suppress compiler warning "unused parameter"
+
+    /* If interrupt has just been "replayed", we have to ignore it */
+    if (timeStamp == 0  ||  ! extiLvl)
+	return;
+
+    /* Check if the receiver is on */
+    if (! l_flgOn)
+    {
+	ExtIntDisable (GNSS_PPS_PIN);
+	return;
+    }
+
+    l_PpsCnt++;
+
+    if (l_flgFixNew  &&  l_FixSeqCnt >= GNSS_FIX_SEQ_CNT)
+    {
+	/* This pulse is the start of the second after the last sentence */
+	NmeaLocalTime (l_FixTime + 1, &localTime);
+	TimeSourceSync (TIME_SRC_GNSS, &localTime);
+
+	/* Clock is up to date, switch off to save power */
+	GNSSDisable();
+	return;
+    }
+
+    /* A new sentence is required during the following second */
+    l_flgFixNew = false;
+}
+
+/***************************************************************************//**
+ *
+ * @brief	UART RX IRQ Handler
+ *
+ * This interrupt service routine is called whenever a byte has been received
+ * from the GNSS receiver.  It feeds the NMEA parser, and counts consecutive
+ * seconds of valid sentences.  Its priority @ref INT_PRIO_GNSS is the same as
+ * for the EXTI, so it cannot interrupt GNSSPpsHandler().
+ *
+ ******************************************************************************/
+void USART0_RX_IRQHandler(void)
+{
+uint32_t  fixTime;
+
+
+    DEBUG_TRACE(0x08);
+
+    /* Check for RX data valid interrupt */
+    while (GNSS_UART->STATUS & USART_STATUS_RXDATAV)
+    {
+	/* Decode data */
+	if (NmeaParse (&l_Nmea, GNSS_UART->RXDATA) == NMEA_NONE)
+	    continue;
+
+	/* RMC and ZDA of the same second count once */
+	fixTime = NmeaSeconds (&l_Nmea);
+	if (fixTime == l_FixTime  &&  l_FixSeqCnt > 0)
+	    continue;
+
+	if (fixTime == l_FixTime + 1  &&  l_FixSeqCnt < 255)
+	    l_FixSeqCnt++;
+	else
+	    l_FixSeqCnt = 1;
+
+	l_FixTime = fixTime;
+	l_flgFixNew = true;
+    }
+
+    /* Clear RXDATAV interrupt */
+    USART_IntClear (GNSS_UART, USART_IF_RXDATAV);
+
+    DEBUG_TRACE(0x88);
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Daily Wake-Up
+ *
+ * This alarm function switches the receiver on, except if the clock has
+ * already been synchronized by another time source.
+ *
+ * @param[in] alarmNum
+ *	Alarm number (not used here).
+ *
+ ******************************************************************************/
+static void	WakeUp (int alarmNum)
+{
+long	age = TimeSourceSyncAge();
+
+
+    (void) alarmNum;
+
+    if (0 <= age  &&  age < GNSS_SKIP_AGE)
+    {
+#ifdef LOGGING
+	Log ("GNSS: Skipped, clock has been synchronized %lds ago", age);
+#endif
+	return;
+    }
+
+    GNSSEnable();
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Timeout
+ *
+ * This function is called if no valid time could be received within @ref
+ * GNSS_TIMEOUT seconds.  It switches the receiver off until the next day.
+ *
+ * @note
+ * Be aware, this function is called in interrupt context!
+ *
+ * @param[in] hdl
+ *	Timer handle (not used here).
+ *
+ ******************************************************************************/
+static void	Timeout (TIM_HDL hdl)
+{
+    (void) hdl;
+
+#ifdef LOGGING
+    LogError ("GNSS: No valid time within %ds", GNSS_TIMEOUT);
+#endif
+    GNSSDisable();
+}
+
+#endif /* GNSS_TIME_SOURCE */
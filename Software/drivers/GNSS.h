@@ -0,0 +1,102 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module GNSS.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_GNSS_h
+#define __INC_GNSS_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include "em_device.h"
+#include "em_gpio.h"
+#include "config.h"		// include project configuration parameters
+
+/*=============================== Definitions ================================*/
+
+#ifndef GNSS_TIME_SOURCE
+    /*!@brief Set 1 if a GNSS receiver is connected as time source. */
+    #define GNSS_TIME_SOURCE	0
+#endif
+
+#ifndef GNSS_BAUDRATE
+    /*!@brief Baudrate of the NMEA output of the GNSS receiver. */
+    #define GNSS_BAUDRATE	9600
+#endif
+
+#ifndef GNSS_WAKE_UP_TIME
+    /*!@brief Daily wake-up time of the receiver (hour, minute) in MEZ.
+     * It is after the MEZ/MESZ change in both directions, so this change
+     * is applied by the next synchronization.
+     */
+    #define GNSS_WAKE_UP_TIME	3, 5
+#endif
+
+#ifndef GNSS_TIMEOUT
+    /*!@brief Maximum on-time in [s] to get a valid time. */
+    #define GNSS_TIMEOUT	600
+#endif
+
+#ifndef GNSS_SKIP_AGE
+    /*!@brief The daily wake-up is skipped if the clock has been synchronized
+     * by another time source within this number of seconds.
+     */
+    #define GNSS_SKIP_AGE	(12 * 3600)
+#endif
+
+#ifndef GNSS_FIX_SEQ_CNT
+    /*!@brief Number of consecutive valid fixes before the clock is set. */
+    #define GNSS_FIX_SEQ_CNT	2
+#endif
+
+#ifndef GNSS_SUPPLY_CURRENT
+    /*!@brief Supply current in [uA] while the receiver is on, i.e. a low-power
+     * receiver during acquisition, and the MCU in EM1 for the UART.  It is
+     * used to estimate the energy per sync, see TimeSourceStatistics().
+     */
+    #define GNSS_SUPPLY_CURRENT	12000
+#endif
+
+/*!@brief Here follows the definition of the UART, GPIO ports and pins used
+ * to connect the GNSS receiver.  The NMEA output is received by USART0 at
+ * location #1 (RX on PE6), the pulse-per-second output (PPS) is connected to
+ * an EXTI, and a high-active pin switches the supply of the receiver.
+ */
+#define GNSS_UART		USART0
+#define GNSS_UART_CLOCK		cmuClock_USART0
+#define GNSS_UART_RX_IRQn	USART0_RX_IRQn
+#define GNSS_UART_ROUTE		USART_ROUTE_LOCATION_LOC1
+#define GNSS_RX_PORT		gpioPortE
+#define GNSS_RX_PIN		6
+
+#define GNSS_ENABLE_PORT	gpioPortD
+#define GNSS_ENABLE_PIN		6
+
+#define GNSS_PPS_PORT		gpioPortD
+#define GNSS_PPS_PIN		3
+
+/*!@brief Bit mask of the affected external interrupt (EXTI). */
+#define GNSS_EXTI_MASK		(1 << GNSS_PPS_PIN)
+
+/*================================ Prototypes ================================*/
+
+/* Initialize GNSS hardware */
+void	GNSSInit (void);
+
+/* Switch the GNSS receiver on */
+void	GNSSEnable (void);
+
+/* Switch the GNSS receiver off */
+void	GNSSDisable (void);
+
+/* PPS handler, called from interrupt service routine */
+void	GNSSPpsHandler (int extiNum, bool extiLvl, uint32_t timeStamp);
+
+
+#endif /* __INC_GNSS_h */
@@ -7,10 +7,12 @@
  *
  * This is the driver for the Low Energy UART.  It is used to write log and
  * debug information to a connected host system.  The LEUART device to use
- * can be set via the @ref LEUART define, for an assignment of the DMA channel,
- * see @ref DMA_CHAN_LEUART_RX and @ref DMA_CHAN_LEUART_TX.
+ * can be set via the @ref LEUART define.  The DMA channels are allocated from
+ * the DMA channel manager, see DmaMgr.c.
  *
- * @note This driver only supports data transmission.
+ * If @ref ENABLE_LEUART_RECEIVER is set, received characters are stored into
+ * @ref g_CmdLine via DMA, which also works in EM2.  A \<LF> character
+ * terminates the line and sets @ref g_flgCmdLine, see Command.c.
  *
  ******************************************************************************
  * @section License
@@ -42,6 +44,16 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added drvLEUART_CmdLineClear() to remove a command line that
+		contained a key from the receive buffer.
+2026-10-19,agent drvLEUART_puts() copies runs of characters with MemCopy()
+		and updates the FIFO index once per run.  Each run is written
+		with interrupts disabled, so the routine stays reentrant.
+2026-10-19,agent Allocate DMA channels via the DMA channel manager instead of
+		using fixed channel numbers.  DMA initialization, interrupt
+		enable, and NVIC setup have been moved to DmaInit().
+		Receiver: restart the Rx DMA if a line exceeds the buffer,
+		set g_flgIRQ when a command line has been received.
 2018-03-19,rage	Increased TX_FIFO_SIZE from 1024 to 1500.
 		Changed dmaTransferStart() to limit transfers to 1024 bytes.
 		Set interrupt priority for DMA_IRQn.
@@ -59,6 +71,8 @@ Revision History:
 #include "em_emu.h"
 #include "em_int.h"
 #include "em_leuart.h"
+#include "DmaMgr.h"
+#include "MemUtil.h"
 #include "LEUART.h"
 
 /*=============================== Definitions ================================*/
@@ -79,15 +93,9 @@ Revision History:
     /*! Size of the transmit FIFO in bytes */
 #define TX_FIFO_SIZE		1500
 
-#if ENABLE_LEUART_RECEIVER
-    /*! Size of the command line buffer in bytes */
-#define CMD_LINE_SIZE		40
-#endif
-
 /*======================== External Data and Routines ========================*/
 
 extern DMA_DESCRIPTOR_TypeDef g_DMA_ControlBlock[];
-extern DMA_CB_TypeDef g_DMA_Callback[];
 
 /*========================= Global Data and Routines =========================*/
 
@@ -119,21 +127,11 @@ static LEUART_Init_TypeDef leuartInit =
   .stopbits = leuartStopbits2,	// Number of stop bits in a frame
 };
 
-/* DMA init structure */
-static DMA_Init_TypeDef dmaInit =
-{
-    .hprot        = 0,			// No descriptor protection
-    .controlBlock = g_DMA_ControlBlock,	// DMA control block alligned to 256
-};
-
-/* Setting up DMA channel for Tx */
-static DMA_CfgChannel_TypeDef chnlCfgTx =
-{
-    .highPri   = false,			// Normal priority
-    .enableInt = false,			// No interrupt for callback function
-    .select    = DMAREQ_LEUART_TXBL,	// DMA Req. is LEUARTx TX buffer empty
-    .cb = &(g_DMA_Callback[DMA_CHAN_LEUART_TX]), // Callback for DMA TX done
-};
+/* DMA channels allocated from the DMA channel manager */
+static int	l_ChanTx = NONE;
+#if ENABLE_LEUART_RECEIVER
+static int	l_ChanRx = NONE;
+#endif
 
 /* Setting up channel descriptor for Tx  */
 DMA_CfgDescr_TypeDef descrCfgTx =
@@ -146,15 +144,6 @@ DMA_CfgDescr_TypeDef descrCfgTx =
 };
 
 #if ENABLE_LEUART_RECEIVER
-/* Setting up DMA channel */
-static DMA_CfgChannel_TypeDef chnlCfgRx =
-{
-    .highPri   = false,			// Normal priority
-    .enableInt = false,			// No interrupt for callback function
-    .select    = DMAREQ_LEUART_RXDATAV,	// DMA Req. is LEUARTx RX data available
-    .cb        = NULL,			// No callback function
-};
-
 /* Setting up channel descriptor */
 DMA_CfgDescr_TypeDef descrCfgRx =
 {
@@ -229,18 +218,18 @@ int16_t		cnt;		// number of bytes to send
 	txIdxGetNext -= sizeof(txFIFO);
 
     /* Set new DMA source end address directly in the DMA descriptor */
-    g_DMA_ControlBlock[DMA_CHAN_LEUART_TX].SRCEND = &txFIFO[idxPut-1];
+    g_DMA_ControlBlock[l_ChanTx].SRCEND = &txFIFO[idxPut-1];
 
     /* Enable DMA wake-up from LEUART TX */
     IO_Bit(LEUART->CTRL, _LEUART_CTRL_TXDMAWU_SHIFT) = 1;
 
     /* (Re)starting the transfer. Using Basic Mode */
-    DMA_ActivateBasic(DMA_CHAN_LEUART_TX, // Activate channel selected
-		      true,		// Use primary descriptor
-		      false,		// No DMA burst
-		      NULL,		// Keep destination address
-		      NULL,		// Keep source address
-		      cnt - 1);		// Size of buffer - 1
+    DmaStartBasic(l_ChanTx,		// Activate channel selected
+		  true,			// Use primary descriptor
+		  false,		// No DMA burst
+		  NULL,			// Keep destination address
+		  NULL,			// Keep source address
+		  cnt - 1);		// Size of buffer - 1
 }
 
 
@@ -271,49 +260,68 @@ void dmaTransferDone(unsigned int channel, bool primary, void *user)
 }
 
 
+#if ENABLE_LEUART_RECEIVER
+/**************************************************************************//**
+ * @brief  DMA Callback function for Rx
+ *
+ * This routine is called when the command line buffer is full, but no
+ * \<LF> has been received.  The line is discarded and the DMA restarted.
+ *
+ ******************************************************************************/
+static void dmaRxBufferFull(unsigned int channel, bool primary, void *user)
+{
+    (void) channel;
+    (void) primary;
+    (void) user;
+
+    /* Re-start DMA at the beginning of the buffer */
+    DmaStartBasic(l_ChanRx,		// Activate channel selected
+		  true,			// Use primary descriptor
+		  false,		// No DMA burst
+		  NULL,			// keep destination address
+		  NULL,			// keep source address
+		  CMD_LINE_SIZE - 1);	// Size of buffer - 1
+}
+#endif
+
+
 /**************************************************************************//**
  * @brief  Setup Low Energy UART with DMA operation
  *
- * The LEUART/DMA interaction is defined, and the DMA, channel and descriptor
- * is initialized. The destination for all the DMA transfers through this
- * channel is set to be the LEUART TXDATA register, and transfer complete
- * interrupt is enabled.
+ * The DMA channels for the LEUART are allocated from the DMA channel manager
+ * and their descriptors are initialized.  The destination for all the DMA
+ * transfers through the Tx channel is set to be the LEUART TXDATA register.
+ * The LEUART can wake up the DMA from EM2, so the channels are registered
+ * with @ref DMA_EM2.
  *
  *****************************************************************************/
 static void setupLeuartDma(void)
 {
-    /* Setting call-back function */
-    g_DMA_Callback[DMA_CHAN_LEUART_TX].cbFunc  = dmaTransferDone;
-    g_DMA_Callback[DMA_CHAN_LEUART_TX].userPtr = NULL;
+    /* Allocate DMA channel for Tx, dmaTransferDone() is the callback */
+    l_ChanTx = DmaChannelAlloc("LEUART_TX", DMAREQ_LEUART_TXBL, false,
+			       DMA_EM2, dmaTransferDone, NULL);
+    EFM_ASSERT(l_ChanTx != NONE);
 
-    /* Initializing DMA, channel and descriptor for Tx */
-    DMA_Init(&dmaInit);
-    NVIC_DisableIRQ(DMA_IRQn);
-    DMA_CfgChannel(DMA_CHAN_LEUART_TX, &chnlCfgTx);
-    DMA_CfgDescr(DMA_CHAN_LEUART_TX, true, &descrCfgTx);
+    DMA_CfgDescr(l_ChanTx, true, &descrCfgTx);
 
     /* Set new DMA destination end address directly in the DMA descriptor */
-    g_DMA_ControlBlock[DMA_CHAN_LEUART_TX].DSTEND = &LEUART->TXDATA;
-
-    /* Enable DMA Transfer Complete Interrupt */
-    DMA->IEN = (DMA_IEN_CH0DONE << DMA_CHAN_LEUART_TX);
-
-    /* Enable DMA interrupt vector */
-    NVIC_SetPriority(DMA_IRQn, INT_PRIO_DMA);
-    NVIC_EnableIRQ(DMA_IRQn);
+    g_DMA_ControlBlock[l_ChanTx].DSTEND = &LEUART->TXDATA;
 
 #if ENABLE_LEUART_RECEIVER
-    /* Initializing DMA, channel and descriptor */
-    DMA_CfgChannel(DMA_CHAN_LEUART_RX, &chnlCfgRx);
-    DMA_CfgDescr(DMA_CHAN_LEUART_RX, true, &descrCfgRx);
+    /* Allocate DMA channel for Rx, callback if the buffer is full */
+    l_ChanRx = DmaChannelAlloc("LEUART_RX", DMAREQ_LEUART_RXDATAV, false,
+			       DMA_EM2, dmaRxBufferFull, NULL);
+    EFM_ASSERT(l_ChanRx != NONE);
+
+    DMA_CfgDescr(l_ChanRx, true, &descrCfgRx);
 
     /* Starting the transfer. Using Basic Mode */
-    DMA_ActivateBasic(DMA_CHAN_LEUART_RX, // Activate channel selected
-		      true,		// Use primary descriptor
-		      false,		// No DMA burst
-		      (void *) g_CmdLine,	// Destination address
-		      (void *) &LEUART->RXDATA,	// Source address is register
-		      CMD_LINE_SIZE - 1);	// Size of buffer - 1
+    DmaStartBasic(l_ChanRx,		// Activate channel selected
+		  true,			// Use primary descriptor
+		  false,		// No DMA burst
+		  (void *) g_CmdLine,	// Destination address
+		  (void *) &LEUART->RXDATA, // Source address is register
+		  CMD_LINE_SIZE - 1);	// Size of buffer - 1
 
     /* Set LEUART signal frame to <NL> (or <CR>) */
     LEUART->SIGFRAME = '\n';
@@ -345,7 +353,6 @@ static void setupLeuartDma(void)
 void	drvLEUART_Init (uint32_t baud)
 {
     /* Enabling clocks, all other remain disabled */
-    CMU_ClockEnable(cmuClock_DMA, true);	// Enable DMA clock
     CMU_ClockEnable(cmuClock_GPIO, true);	// Enable GPIO clock
     CMU_ClockEnable(cmuClock_LEUART, true);	// Enable LEUART clock
 
@@ -402,22 +409,45 @@ uint32_t leuartif, len;
     {
 	/* Zero-terminate RX command line buffer */
 	len = CMD_LINE_SIZE - 2
-	    - ((g_DMA_ControlBlock[DMA_CHAN_LEUART_RX].CTRL >> 4) & 0x3FF);
+	    - ((g_DMA_ControlBlock[l_ChanRx].CTRL >> 4) & 0x3FF);
 
 	g_CmdLine[len] = EOS;
 
 	/* set flag to notify new command is available */
 	g_flgCmdLine = true;
+	g_flgIRQ = true;	// keep on running
 
 	/* Re-start DMA */
-	DMA_ActivateBasic(DMA_CHAN_LEUART_RX, // Activate channel selected
-			  true,		// Use primary descriptor
-			  false,	// No DMA burst
-			  NULL,		// keep destination address
-			  NULL,		// keep source address
-			  CMD_LINE_SIZE - 1);	// Size of buffer - 1
+	DmaStartBasic(l_ChanRx,		// Activate channel selected
+		      true,		// Use primary descriptor
+		      false,		// No DMA burst
+		      NULL,		// keep destination address
+		      NULL,		// keep source address
+		      CMD_LINE_SIZE - 1);	// Size of buffer - 1
     }
 }
+
+
+/***************************************************************************//**
+ *
+ * @brief  Clear the Command Line Buffer
+ *
+ * This routine overwrites the previous command line in @ref g_CmdLine, e.g.
+ * when it contained a key.  The characters of the next line, which the DMA
+ * may already have stored at the beginning of the buffer, are kept.
+ *
+ ******************************************************************************/
+void	 drvLEUART_CmdLineClear (void)
+{
+uint32_t len;		// number of characters of the next line
+
+
+    INT_Disable();
+    len = CMD_LINE_SIZE - 2
+	- ((g_DMA_ControlBlock[l_ChanRx].CTRL >> 4) & 0x3FF);
+    MemFill (g_CmdLine + len, 0, CMD_LINE_SIZE - len);
+    INT_Enable();
+}
 #endif
 
 
@@ -429,44 +459,71 @@ uint32_t leuartif, len;
  * is transferred to the LEUART via DMA.  If there is no more space in the
  * FIFO, characters will be discarded.
  *
+ * @note Log() may call this routine from interrupt service routines, so it
+ * must be reentrant.  Each run of characters is reserved, copied and committed
+ * to the FIFO with interrupts disabled, a preempting call therefore can never
+ * overwrite the text or move @ref txIdxPut backwards.
+ *
  * @param[in] pStr
  *	Address pointer of the string to write into the FIFO.
  *
  ******************************************************************************/
 void	 drvLEUART_puts (const char *pStr)
 {
-int16_t	cnt;			// free buffer space in number of bytes
+int16_t	space;			// free buffer space in number of bytes
+int16_t	cnt;			// number of bytes to write
+uint16_t idxPut;		// FIFO put index
 bool	sendCR = false;		// set true to write <CR> to buffer
 
 
     while (*pStr != EOS)
     {
-	/* Non-blocking: discard string if FIFO is full */
-	cnt  = txIdxPut;
-	cnt -= txIdxGet;
-	if (cnt < 0)
-	    cnt += sizeof(txFIFO);
+	/* Reserve, fill, and commit FIFO space as one atomic operation */
+	INT_Disable();
 
-	if (cnt > (int16_t)(sizeof(txFIFO) - 2))
+	/* Non-blocking: discard string if FIFO is full (one byte stays free) */
+	idxPut = txIdxPut;
+	space = txIdxGet;
+	space -= idxPut + 1;
+	if (space < 0)
+	    space += sizeof(txFIFO);
+
+	if (space <= 0)
+	{
+	    INT_Enable();
 	    break;
+	}
 
 	/* Check if to translate <LF> to <CR><LF> */
 	if (g_flgLEUART_LF2CRLF  &&  (*pStr == '\n')  &&  ! sendCR)
 	{
 	    /* Write <CR> to FIFO */
-	    txFIFO[txIdxPut] = '\r';
+	    txFIFO[idxPut] = '\r';
 	    sendCR = true;	// special character <CR>, set flag
+	    cnt = 1;
 	}
 	else
 	{
-	    /* Write Byte to FIFO */
-	    txFIFO[txIdxPut] = *pStr++;
-	    sendCR = false;	// regular character, be sure to clear flag
+	    /* Copy a run of characters up to the next <LF> to translate,
+	     * limited by the free space and the end of the FIFO */
+	    for (cnt = 1;  cnt < space  &&  idxPut + cnt < (int)sizeof(txFIFO)
+			   &&  pStr[cnt] != EOS;  cnt++)
+	    {
+		if (g_flgLEUART_LF2CRLF  &&  pStr[cnt] == '\n')
+		    break;
+	    }
+	    MemCopy (txFIFO + idxPut, pStr, cnt);
+	    pStr += cnt;
+	    sendCR = false;	// regular characters, be sure to clear flag
 	}
 
 	/* Increment FIFO index */
-	if (++txIdxPut >= sizeof(txFIFO))
-	    txIdxPut = 0;	// wrap around
+	idxPut += cnt;
+	if (idxPut >= sizeof(txFIFO))
+	    idxPut = 0;		// wrap around
+	txIdxPut = idxPut;
+
+	INT_Enable();
     }
 
     /* Be sure to enable DMA for data transfer */
@@ -5,6 +5,10 @@
  * @version	2018-03-19
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added prototype for drvLEUART_CmdLineClear().
+2026-10-19,agent Enabled the receiver for the command interpreter, see
+		Command.c.  g_CmdLine[] is of type char now, moved
+		CMD_LINE_SIZE here.
 2018-03-19,rage	Added prototype for drvLEUART_sync().
 2015-02-03,rage	Initial version.
 */
@@ -24,13 +28,16 @@ Revision History:
 /*=============================== Definitions ================================*/
 
     /*! Switch to enable the receive part of the driver */
-#define ENABLE_LEUART_RECEIVER	0
+#define ENABLE_LEUART_RECEIVER	1
+
+    /*! Size of the command line buffer in bytes */
+#define CMD_LINE_SIZE		40
 
 /*================================ Global Data ===============================*/
 
 extern volatile bool	g_flgLEUART_LF2CRLF;
 extern volatile bool	g_flgCmdLine;
-extern uint8_t		g_CmdLine[];
+extern char		g_CmdLine[];
 
 /*================================ Prototypes ================================*/
 
@@ -46,5 +53,10 @@ void	 drvLEUART_putc (char c);
 /* Wait until transmit FIFO is empty */
 void	 drvLEUART_sync(void);
 
+#if ENABLE_LEUART_RECEIVER
+/* Overwrite the previous command line */
+void	 drvLEUART_CmdLineClear (void);
+#endif
+
 
 #endif /* __INC_LEUART_h */
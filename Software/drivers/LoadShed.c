@@ -0,0 +1,158 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Load Shedding Policy
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module decides how much load the logger sheds when the battery runs
+ * low, so it keeps logging as long as possible instead of running its full
+ * schedule until the battery controller cuts off.  The decision is based on
+ * the relative state of charge and the runtime to empty, as reported by the
+ * battery controller, see @ref SHED_TIER for the tiers.
+ *
+ * A tier is entered as soon as one of its thresholds is reached.  It is left
+ * only when all of its thresholds are exceeded by the hysteresis, so a tier
+ * does not toggle with the noise of the gauge, or with the runtime which
+ * follows the current load.  The actions of the tiers are carried out by
+ * Control.c.  The module has no hardware dependencies, so the same policy is
+ * replayed on the host by the tool ShedSim against recorded battery curves.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stddef.h>
+#include "LoadShed.h"
+
+/*================================ Local Data ================================*/
+
+    /*!@brief Names of the tiers, see @ref SHED_TIER. */
+static const char * const l_TierName[END_SHED_TIER] =
+{
+    "normal", "reduced RFID", "no cameras", "slow log flush", "minimal"
+};
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	TierEnter (const SHED_CFG *pCfg, int n,
+			   uint32_t soc, uint32_t runTime);
+static bool	TierStay  (const SHED_CFG *pCfg, int n,
+			   uint32_t soc, uint32_t runTime);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Determine the Tier
+ *
+ * This routine returns the tier for the current battery readings.  It is
+ * the highest tier whose thresholds have been reached.  If this is below the
+ * current tier, the current tier is left step by step, but only as long as
+ * the readings are above its thresholds plus the hysteresis.
+ *
+ * @param[in] pCfg
+ *	Thresholds and hysteresis of the tiers.
+ *
+ * @param[in] tier
+ *	Current tier.
+ *
+ * @param[in] soc
+ *	Relative state of charge in [%].
+ *
+ * @param[in] runTime
+ *	Runtime to empty in [min], @ref SHED_RUNTIME_INFINITE if the battery is
+ *	not discharged.
+ *
+ * @return
+ *	New tier.
+ *
+ ******************************************************************************/
+SHED_TIER LoadShedTier (const SHED_CFG *pCfg, SHED_TIER tier,
+			uint32_t soc, uint32_t runTime)
+{
+int	n, newTier;
+
+
+    newTier = SHED_TIER_NONE;
+    for (n = SHED_TIER_NONE + 1;  n < END_SHED_TIER;  n++)
+	if (TierEnter (pCfg, n, soc, runTime))
+	    newTier = n;
+
+    if (newTier >= (int)tier)
+	return (SHED_TIER)newTier;
+
+    /* Leave the current tier only if the hysteresis is exceeded */
+    for (n = tier;  n > newTier;  n--)
+	if (TierStay (pCfg, n, soc, runTime))
+	    return (SHED_TIER)n;
+
+    return (SHED_TIER)newTier;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Name of a Tier
+ *
+ * @param[in] tier
+ *	Tier, see @ref SHED_TIER.
+ *
+ * @return
+ *	Name of the tier for the log messages.
+ *
+ ******************************************************************************/
+const char *LoadShedName (SHED_TIER tier)
+{
+    if (tier >= END_SHED_TIER)
+	return "?";
+
+    return l_TierName[tier];
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Tier has to be entered
+ *
+ * @return
+ *	<i>true</i> if the state of charge or the runtime to empty has reached
+ *	the threshold of tier <i>n</i>.
+ *
+ ******************************************************************************/
+static bool	TierEnter (const SHED_CFG *pCfg, int n,
+			   uint32_t soc, uint32_t runTime)
+{
+    if (pCfg->SoC[n] > 0  &&  soc <= pCfg->SoC[n])
+	return true;
+
+    if (pCfg->RunTime[n] > 0  &&  runTime != SHED_RUNTIME_INFINITE
+    &&  runTime <= pCfg->RunTime[n] * 60)
+	return true;
+
+    return false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Tier has to be kept
+ *
+ * @return
+ *	<i>true</i> if the state of charge or the runtime to empty is still
+ *	below the threshold of tier <i>n</i> plus the hysteresis.
+ *
+ ******************************************************************************/
+static bool	TierStay (const SHED_CFG *pCfg, int n,
+			  uint32_t soc, uint32_t runTime)
+{
+    if (pCfg->SoC[n] > 0  &&  soc < pCfg->SoC[n] + pCfg->SoC_Hyst)
+	return true;
+
+    if (pCfg->RunTime[n] > 0  &&  runTime != SHED_RUNTIME_INFINITE
+    &&  runTime < pCfg->RunTime[n] * 60 * (100 + pCfg->RunTimeHyst) / 100)
+	return true;
+
+    return false;
+}
@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module LoadShed.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool ShedSim.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_LoadShed_h
+#define __INC_LoadShed_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Value of SBS RunTimeToEmpty if the battery is not discharged. */
+#define SHED_RUNTIME_INFINITE	65535
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Load shedding tiers, every tier includes the actions of the
+     * tiers below. */
+typedef enum
+{
+    SHED_TIER_NONE,	//!< 0: Normal operation
+    SHED_TIER_RFID,	//!< 1: Reduced duty cycle of the RFID reader
+    SHED_TIER_CAMERA,	//!< 2: All power outputs except RFID switched off
+    SHED_TIER_FLUSH,	//!< 3: Longer pause between log flushes
+    SHED_TIER_MINIMAL,	//!< 4: Only logging and timekeeping
+    END_SHED_TIER
+} SHED_TIER;
+
+    /*!@brief Thresholds of the tiers.  A tier is entered when the state of
+     * charge or the runtime to empty falls to its threshold, 0 disables a
+     * threshold.  Index 0 (@ref SHED_TIER_NONE) is not used.
+     */
+typedef struct
+{
+    uint32_t	SoC[END_SHED_TIER];	//!< Relative state of charge in [%]
+    uint32_t	RunTime[END_SHED_TIER];	//!< Runtime to empty in [h]
+    uint32_t	SoC_Hyst;	//!< Hysteresis of SoC in percentage points
+    uint32_t	RunTimeHyst;	//!< Hysteresis of RunTime in [%] of the value
+} SHED_CFG;
+
+/*================================ Prototypes ================================*/
+
+    /* Determine the new tier from SoC [%] and runtime to empty [min] */
+SHED_TIER LoadShedTier (const SHED_CFG *pCfg, SHED_TIER tier,
+			uint32_t soc, uint32_t runTime);
+
+    /* Name of a tier for the log messages */
+const char *LoadShedName (SHED_TIER tier);
+
+
+#endif /* __INC_LoadShed_h */
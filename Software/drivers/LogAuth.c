@@ -0,0 +1,776 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Authentication of the Log File
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module computes an AES-CMAC (RFC 4493) for every block of log data
+ * that LogFlush() writes to the SD-Card.  The MAC is calculated by the AES
+ * peripheral with a 128 bit key per box, which is stored in the EEPROM
+ * emulation area of the flash, see LogAuthSetKey().  After each block, a
+ * trailer line is written to the log file:
+ * @code
+ * #MAC 000042 1873 8F0A11C2...(32 hex digits)
+ * @endcode
+ * It contains the block number and the length of the block in bytes, i.e.
+ * the data directly in front of the trailer line.  The message of block
+ * <i>n</i> is the MAC of block <i>n-1</i>, followed by the block data, so
+ * blocks cannot be edited, removed, or reordered without breaking the chain.
+ *
+ * A chain starts with block 0 after reset, when a log file is opened, and
+ * after a write error.  Instead of a previous MAC, block 0 is chained with
+ * the chain ID: the 64 bit unique number of the MCU (HW-ID), a boot counter
+ * that is incremented in the flash at every start-up, and the number of the
+ * chain since start-up.  The trailer of block 0 contains the chain ID:
+ * @code
+ * #MAC 000000 1873 8F0A11C2...(32 hex digits) 0123456789ABCDEF 17 3
+ * @endcode
+ * A chain therefore cannot be moved to another box, and a chain that was
+ * removed, copied, or moved to another place shows up as a gap or duplicate
+ * in the chain numbers of a boot.
+ *
+ * The host tool <b>LogMac</b> verifies the log files of a whole season.
+ *
+ * The AES peripheral processes one 16 byte block in 54 clock cycles, while
+ * the CPU copies the next block.  Its clock is only enabled during a flush.
+ * The cycles spent are counted and logged by LogAuthStatistics().  Set @ref
+ * LOG_AUTH_BENCH to 1 to compare the hardware with a software AES at
+ * start-up.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "eeprom_emulation.h"
+#include "LogAuth.h"
+#include "Logging.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_LOGGING
+
+    /*!@brief Magic number of a valid key in the flash. */
+#define LOG_AUTH_MAGIC		0x4B59
+
+    /*!@brief A new chain is started after this number of blocks. */
+#define LOG_AUTH_CHAIN_WRAP	1000000UL
+
+    /*!@brief Current consumption in EM0 per MHz and supply voltage, used to
+     * estimate the energy from the number of CPU cycles.
+     */
+#define EM0_UA_PER_MHZ		180
+#define VDD_MV			3300
+
+/*================================ Local Data ================================*/
+
+    /* Key, subkeys K1/K2, and key check value */
+static bool	l_flgKey;
+static uint32_t	l_Key[4], l_K1[4], l_K2[4];
+static uint32_t	l_Kcv;
+
+    /* Non-volatile variables: magic, key as 8 words, checksum, boot count */
+static EE_Variable_TypeDef  l_eeMagic, l_eeKey[8], l_eeSum, l_eeBoot[2];
+
+    /* Boot counter and number of the current chain since start-up */
+static uint32_t	l_BootCnt;
+static uint32_t	l_ChainSeq;
+
+    /* MAC of the previous block and block number within the chain */
+static uint32_t	l_Mac[4];
+static uint32_t	l_ChainNum;
+
+    /* Current block: partial 16 byte block, its byte count, and length */
+static bool	l_flgOpen;
+static uint32_t	l_Blk[4];
+static unsigned int l_BlkCnt;
+static uint32_t	l_BlkLen;
+
+    /* Statistics */
+static uint32_t	l_StatBlocks, l_StatBytes, l_StatCycles;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void	keyLoad (const uint8_t *pKey);
+static void	aesStart (void);
+static void	aesXor (const uint32_t *pBlk);
+static void	aesRead (uint32_t *pOut);
+static void	cmacDouble (uint8_t *pOut, const uint8_t *pIn);
+#if LOG_AUTH_BENCH
+static void	logAuthBench (void);
+#endif
+
+
+/***************************************************************************//**
+ *
+ * @brief	Initialize the Log Authentication
+ *
+ * This routine declares the non-volatile variables, reads the key, and
+ * increments the boot counter.  It must be called after ControlInit(), which
+ * initializes the EEPROM emulation, because the virtual addresses are
+ * assigned in the order of declaration.
+ *
+ ******************************************************************************/
+void	 LogAuthInit (void)
+{
+uint8_t	 key[LOG_AUTH_KEY_SIZE];
+uint16_t data, sum, word, hi, lo;
+int	 i;
+
+
+    /* Enable the cycle counter for the statistics */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Declare variables (virtual addresses) */
+    EE_DeclareVariable (&l_eeMagic);
+    for (i = 0;  i < 8;  i++)
+	EE_DeclareVariable (&l_eeKey[i]);
+    EE_DeclareVariable (&l_eeSum);
+    EE_DeclareVariable (&l_eeBoot[0]);
+    EE_DeclareVariable (&l_eeBoot[1]);
+
+    /* Read key from flash and verify the checksum */
+    if (EE_Read (&l_eeMagic, &data)  &&  data == LOG_AUTH_MAGIC)
+    {
+	sum = data;
+	for (i = 0;  i < 8;  i++)
+	{
+	    EE_Read (&l_eeKey[i], &word);
+	    sum += word;
+	    key[2*i]   = (uint8_t)(word >> 8);
+	    key[2*i+1] = (uint8_t)word;
+	}
+	if (EE_Read (&l_eeSum, &data)  &&  data == sum)
+	    keyLoad (key);
+    }
+    memset (key, 0, sizeof(key));
+
+    /* Boot counter, also without key, so a chain ID is never used twice */
+    if (! EE_Read (&l_eeBoot[0], &hi)  ||  ! EE_Read (&l_eeBoot[1], &lo))
+	hi = lo = 0;
+    l_BootCnt = (((uint32_t)hi << 16) | lo) + 1;
+    EE_Write (&l_eeBoot[0], (uint16_t)(l_BootCnt >> 16));
+    EE_Write (&l_eeBoot[1], (uint16_t)l_BootCnt);
+    l_ChainSeq = 0;
+
+    if (l_flgKey)
+	Log ("Log Authentication: key check value %08lX, boot %ld", l_Kcv,
+	     l_BootCnt);
+    else
+	Log ("Log Authentication: no key");
+
+#if LOG_AUTH_BENCH
+    logAuthBench();
+#endif
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Set Key
+ *
+ * This routine stores a new key in the flash and starts a new chain.
+ *
+ * @param[in] pKey
+ *	Pointer to the key of @ref LOG_AUTH_KEY_SIZE bytes, or NULL to remove
+ *	the key and disable the authentication.
+ *
+ ******************************************************************************/
+void	 LogAuthSetKey (const uint8_t *pKey)
+{
+uint16_t data, sum;
+int	 i;
+
+
+    /* FlashProg.c keeps the interrupts enabled while the FLASH is written */
+    if (pKey == NULL)
+    {
+	EE_Write (&l_eeMagic, 0);
+    }
+    else
+    {
+	sum = LOG_AUTH_MAGIC;
+	EE_Write (&l_eeMagic, LOG_AUTH_MAGIC);
+	for (i = 0;  i < 8;  i++)
+	{
+	    data = (uint16_t)((pKey[2*i] << 8) | pKey[2*i+1]);
+	    sum += data;
+	    EE_Write (&l_eeKey[i], data);
+	}
+	EE_Write (&l_eeSum, sum);
+    }
+
+    LogAuthAbort();
+    if (pKey == NULL)
+    {
+	l_flgKey = false;
+	memset (l_Key, 0, sizeof(l_Key));
+	Log ("Log Authentication: key removed");
+    }
+    else
+    {
+	keyLoad (pKey);
+	Log ("Log Authentication: new key, key check value %08lX", l_Kcv);
+    }
+    LogAuthRestart();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Authentication State
+ *
+ * @return
+ *	<b>true</b> if a key is available, i.e. trailers are written.
+ *
+ ******************************************************************************/
+bool	 LogAuthIsEnabled (void)
+{
+    return l_flgKey;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Key Check Value
+ *
+ * This routine returns the first 4 bytes of the AES encryption of a block
+ * of all ones.  It identifies the key without disclosing it.  The zero block
+ * is not used, because its encryption L is the source of the CMAC subkeys.
+ *
+ ******************************************************************************/
+uint32_t LogAuthKeyCheck (void)
+{
+    return l_Kcv;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Update the MAC with Log Data
+ *
+ * This routine is called by LogFlush() for every piece of data written to
+ * the log file.  The first call of a block switches on the AES clock and
+ * processes the MAC of the previous block, or the chain ID for block 0.  The
+ * last 16 bytes are always kept in @ref l_Blk, because CMAC treats the final
+ * block differently.
+ *
+ ******************************************************************************/
+void	 LogAuthUpdate (const void *pData, unsigned int len)
+{
+const uint8_t *pSrc = pData;
+unsigned int cnt;
+uint32_t start;
+
+
+    if (! l_flgKey  ||  len == 0)
+	return;
+
+    start = DWT->CYCCNT;
+
+    if (! l_flgOpen)
+    {
+	l_flgOpen = true;
+	l_BlkLen = 0;
+	if (l_ChainNum == 0)
+	{
+	    /* New chain: big-endian HW-ID, boot counter, and chain number */
+	    l_Mac[0] = __REV(DEVINFO->UNIQUEH);
+	    l_Mac[1] = __REV(DEVINFO->UNIQUEL);
+	    l_Mac[2] = __REV(l_BootCnt);
+	    l_Mac[3] = __REV(l_ChainSeq);
+	}
+	aesStart();
+	memcpy (l_Blk, l_Mac, sizeof(l_Blk));	// chain with previous MAC
+	l_BlkCnt = sizeof(l_Blk);
+    }
+
+    l_BlkLen += len;
+    while (len > 0)
+    {
+	if (l_BlkCnt == sizeof(l_Blk))
+	{
+	    aesXor (l_Blk);		// runs while the next block is copied
+	    l_BlkCnt = 0;
+	}
+	cnt = sizeof(l_Blk) - l_BlkCnt;
+	if (cnt > len)
+	    cnt = len;
+	memcpy ((uint8_t *)l_Blk + l_BlkCnt, pSrc, cnt);
+	l_BlkCnt += cnt;
+	pSrc += cnt;
+	len  -= cnt;
+    }
+
+    l_StatCycles += DWT->CYCCNT - start;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Finish the MAC and build the Trailer Line
+ *
+ * This routine completes the MAC of the current block and writes the trailer
+ * line into the specified buffer.  The trailer of block 0 also contains the
+ * chain ID.
+ *
+ * @param[out] pBuf
+ *	Buffer of at least @ref LOG_AUTH_TRAILER_SIZE bytes.
+ *
+ * @return
+ *	Length of the trailer line, or 0 if there is no block to finish.
+ *
+ ******************************************************************************/
+int	 LogAuthTrailer (char *pBuf)
+{
+static const char hex[] = "0123456789ABCDEF";
+const uint8_t *pMac = (const uint8_t *)l_Mac;
+uint32_t start;
+int	 i, len;
+
+
+    if (! l_flgOpen)
+	return 0;
+
+    start = DWT->CYCCNT;
+
+    /* Final block: complete with K1, padded with K2 */
+    if (l_BlkCnt == sizeof(l_Blk))
+    {
+	for (i = 0;  i < 4;  i++)
+	    l_Blk[i] ^= l_K1[i];
+    }
+    else
+    {
+	memset ((uint8_t *)l_Blk + l_BlkCnt, 0, sizeof(l_Blk) - l_BlkCnt);
+	((uint8_t *)l_Blk)[l_BlkCnt] = 0x80;
+	for (i = 0;  i < 4;  i++)
+	    l_Blk[i] ^= l_K2[i];
+    }
+    aesXor (l_Blk);
+    aesRead (l_Mac);
+    CMU_ClockEnable (cmuClock_AES, false);
+    l_flgOpen = false;
+
+    len = sprintf (pBuf, "#MAC %06lu %lu ", (unsigned long)l_ChainNum,
+		   (unsigned long)l_BlkLen);
+    for (i = 0;  i < 16;  i++)
+    {
+	pBuf[len++] = hex[pMac[i] >> 4];
+	pBuf[len++] = hex[pMac[i] & 0xF];
+    }
+    if (l_ChainNum == 0)
+    {
+	len += sprintf (pBuf + len, " %08lX%08lX %lu %lu",
+		       (unsigned long)DEVINFO->UNIQUEH,
+		       (unsigned long)DEVINFO->UNIQUEL, (unsigned long)l_BootCnt,
+		       (unsigned long)l_ChainSeq);
+	l_ChainSeq++;
+    }
+    strcpy (pBuf + len, "\r\n");
+    len += 2;
+
+    l_StatBlocks++;
+    l_StatBytes += l_BlkLen;
+    l_StatCycles += DWT->CYCCNT - start;
+
+    if (++l_ChainNum >= LOG_AUTH_CHAIN_WRAP)
+	LogAuthRestart();
+
+    return len;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Abort the current Block
+ *
+ * This routine must be called if the data of a block could not be written
+ * completely.  A new chain is started, so the following blocks can still be
+ * verified.  If block 0 is aborted, its chain number is used again, because
+ * no trailer with this number exists.
+ *
+ ******************************************************************************/
+void	 LogAuthAbort (void)
+{
+    if (! l_flgOpen)
+	return;
+
+    aesRead (l_Blk);		// wait until the AES is idle
+    CMU_ClockEnable (cmuClock_AES, false);
+    l_flgOpen = false;
+    LogAuthRestart();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Restart the Chain
+ *
+ * The next block gets number 0 and is chained with the chain ID, see
+ * LogAuthUpdate().  This is done when a log file is opened.  The chain number
+ * is incremented by the trailer of block 0, so restarts without data do not
+ * leave gaps.
+ *
+ ******************************************************************************/
+void	 LogAuthRestart (void)
+{
+    LogAuthAbort();
+    l_ChainNum = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log the Statistics
+ *
+ * This routine logs the number of authenticated blocks and bytes, and the
+ * CPU cycles and estimated energy per KB.
+ *
+ ******************************************************************************/
+void	 LogAuthStatistics (void)
+{
+uint32_t cyclesKB = 0;
+
+
+    if (l_StatBytes > 0)
+	cyclesKB = (uint32_t)((uint64_t)l_StatCycles * 1024 / l_StatBytes);
+
+    Log ("Log Authentication: %s, %ld blocks, %ld bytes, %ld cycles/KB,"
+	 " %ldnJ/KB", l_flgKey ? "on" : "off", l_StatBlocks, l_StatBytes,
+	 cyclesKB, cyclesKB * (EM0_UA_PER_MHZ * VDD_MV / 1000) / 1000);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Load Key
+ *
+ * This routine stores the key and calculates the CMAC subkeys K1 and K2,
+ * and the key check value.
+ *
+ ******************************************************************************/
+static void	keyLoad (const uint8_t *pKey)
+{
+uint32_t L[4];
+
+
+    memcpy (l_Key, pKey, sizeof(l_Key));
+    l_flgKey = true;
+
+    /* L = AES(K, 0) */
+    aesStart();
+    memset (L, 0, sizeof(L));
+    aesXor (L);
+    aesRead (L);
+    CMU_ClockEnable (cmuClock_AES, false);
+
+    cmacDouble ((uint8_t *)l_K1, (uint8_t *)L);
+    cmacDouble ((uint8_t *)l_K2, (uint8_t *)l_K1);
+
+    /* Key check value from AES(K, 1^128) */
+    aesStart();
+    memset (L, 0xFF, sizeof(L));
+    aesXor (L);
+    aesRead (L);
+    CMU_ClockEnable (cmuClock_AES, false);
+
+    l_Kcv = __REV(L[0]);
+    memset (L, 0, sizeof(L));
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start the AES Peripheral
+ *
+ * This routine enables the AES clock, loads the key into the key buffer and
+ * clears the data register, i.e. the CBC state.  Each write of 4 words to
+ * XORDATA then encrypts DATA XOR the new block, see aesXor().
+ *
+ ******************************************************************************/
+static void	aesStart (void)
+{
+int	i;
+
+
+    CMU_ClockEnable (cmuClock_AES, true);
+
+    for (i = 3;  i >= 0;  i--)
+	AES->KEYHA = __REV(l_Key[i]);
+
+    AES->CTRL = AES_CTRL_KEYBUFEN | AES_CTRL_XORSTART;
+
+    for (i = 3;  i >= 0;  i--)
+	AES->DATA = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Encrypt the next CBC Block
+ *
+ * This routine waits until the previous encryption is done, and starts the
+ * encryption of the CBC state XOR @p pBlk.  It does not wait for the end,
+ * so the CPU can prepare the next block meanwhile.
+ *
+ ******************************************************************************/
+static void	aesXor (const uint32_t *pBlk)
+{
+int	i;
+
+
+    while (AES->STATUS & AES_STATUS_RUNNING)
+	;
+
+    for (i = 3;  i >= 0;  i--)
+	AES->XORDATA = __REV(pBlk[i]);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read the CBC State
+ *
+ ******************************************************************************/
+static void	aesRead (uint32_t *pOut)
+{
+int	i;
+
+
+    while (AES->STATUS & AES_STATUS_RUNNING)
+	;
+
+    for (i = 3;  i >= 0;  i--)
+	pOut[i] = __REV(AES->DATA);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	CMAC Subkey Generation
+ *
+ * This routine shifts the 128 bit value @p pIn one bit to the left and adds
+ * the constant R_128 (0x87) if the most significant bit was set.
+ *
+ ******************************************************************************/
+static void	cmacDouble (uint8_t *pOut, const uint8_t *pIn)
+{
+uint8_t	msb = pIn[0] & 0x80;
+int	i;
+
+
+    for (i = 0;  i < 15;  i++)
+	pOut[i] = (uint8_t)((pIn[i] << 1) | (pIn[i+1] >> 7));
+
+    pOut[15] = (uint8_t)((pIn[15] << 1) ^ (msb ? 0x87 : 0));
+}
+
+
+#if LOG_AUTH_BENCH
+//==============================================================================
+//
+//		S O F T W A R E   A E S   F O R   C O M P A R I S O N
+//
+//==============================================================================
+
+    /* AES S-Box */
+static const uint8_t l_SBox[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+    0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+    0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+    0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+    0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+    0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+    0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+    0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+    0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+    0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+    0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+    0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+    /*!@brief Multiply by x in GF(2^8). */
+#define XTIME(x)	((uint8_t)(((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0)))
+
+/******************************************************************************
+ * @brief  Expand a 128 bit key into 11 round keys
+ *****************************************************************************/
+static void	swAesKeyExpand (const uint8_t *pKey, uint8_t *pRk)
+{
+uint8_t	 t[4], u, rcon = 1;
+int	 i, j;
+
+
+    memcpy (pRk, pKey, 16);
+    for (i = 16;  i < 176;  i += 4)
+    {
+	memcpy (t, pRk + i - 4, 4);
+	if (i % 16 == 0)
+	{
+	    u = t[0];
+	    t[0] = l_SBox[t[1]] ^ rcon;
+	    t[1] = l_SBox[t[2]];
+	    t[2] = l_SBox[t[3]];
+	    t[3] = l_SBox[u];
+	    rcon = XTIME(rcon);
+	}
+	for (j = 0;  j < 4;  j++)
+	    pRk[i + j] = pRk[i - 16 + j] ^ t[j];
+    }
+}
+
+/******************************************************************************
+ * @brief  Encrypt one block in place
+ *****************************************************************************/
+static void	swAesEncrypt (const uint8_t *pRk, uint8_t *s)
+{
+uint8_t	 t[16], a, b, c, d, e;
+int	 r, i;
+
+
+    for (i = 0;  i < 16;  i++)
+	s[i] ^= pRk[i];
+
+    for (r = 1;  r <= 10;  r++)
+    {
+	/* SubBytes and ShiftRows */
+	for (i = 0;  i < 16;  i++)
+	    t[i] = l_SBox[s[(i + 4 * (i % 4)) % 16]];
+
+	/* MixColumns, except for the last round */
+	for (i = 0;  i < 16;  i += 4)
+	{
+	    a = t[i];  b = t[i+1];  c = t[i+2];  d = t[i+3];
+	    if (r < 10)
+	    {
+		e = a ^ b ^ c ^ d;
+		a ^= e ^ XTIME(t[i]   ^ t[i+1]);
+		b ^= e ^ XTIME(t[i+1] ^ t[i+2]);
+		c ^= e ^ XTIME(t[i+2] ^ t[i+3]);
+		d ^= e ^ XTIME(t[i+3] ^ t[i]);
+	    }
+	    s[i]   = a ^ pRk[16*r + i];
+	    s[i+1] = b ^ pRk[16*r + i + 1];
+	    s[i+2] = c ^ pRk[16*r + i + 2];
+	    s[i+3] = d ^ pRk[16*r + i + 3];
+	}
+    }
+}
+
+/***************************************************************************//**
+ *
+ * @brief	Benchmark Hardware and Software AES
+ *
+ * This routine calculates the MAC of a 1KB block, i.e. the message of block
+ * 0 of a chain, once with the AES peripheral and once in software, and logs
+ * the CPU cycles and the estimated energy per KB.  If no key is set, the key
+ * of RFC 4493 is used temporarily.
+ *
+ ******************************************************************************/
+static void	logAuthBench (void)
+{
+static const uint8_t testKey[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+    0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+uint8_t	 data[64], rk[176], x[16], k1[16];
+char	 trailer[LOG_AUTH_TRAILER_SIZE];
+uint32_t saveKey[4], chainId[4], hwCycles, swCycles;
+uint32_t saveSeq = l_ChainSeq;
+bool	 saveFlg = l_flgKey;
+int	 i, j, n;
+
+
+    for (i = 0;  i < (int)sizeof(data);  i++)
+	data[i] = (uint8_t)('0' + i % 64);
+
+    memcpy (saveKey, l_Key, sizeof(saveKey));
+    if (! l_flgKey)
+	keyLoad (testKey);
+    LogAuthRestart();
+
+    /* Hardware: 16 updates of 64 bytes */
+    DWT->CYCCNT = 0;
+    for (i = 0;  i < 16;  i++)
+	LogAuthUpdate (data, sizeof(data));
+    LogAuthTrailer (trailer);
+    hwCycles = DWT->CYCCNT;
+    chainId[0] = __REV(DEVINFO->UNIQUEH);
+    chainId[1] = __REV(DEVINFO->UNIQUEL);
+    chainId[2] = __REV(l_BootCnt);
+    chainId[3] = __REV(saveSeq);
+
+    /* Software: same message, chain ID followed by 1KB of data */
+    DWT->CYCCNT = 0;
+    swAesKeyExpand ((const uint8_t *)l_Key, rk);
+    memset (x, 0, sizeof(x));
+    swAesEncrypt (rk, x);			// L = AES(K, 0)
+    for (i = 0;  i < 15;  i++)
+	k1[i] = (uint8_t)((x[i] << 1) | (x[i+1] >> 7));
+    k1[15] = (uint8_t)((x[15] << 1) ^ ((x[0] & 0x80) ? 0x87 : 0));
+    memcpy (x, chainId, sizeof(x));
+    swAesEncrypt (rk, x);			// chain ID instead of previous MAC
+    for (n = 0;  n < 16;  n++)
+    {
+	for (i = 0;  i < (int)sizeof(data);  i += 16)
+	{
+	    for (j = 0;  j < 16;  j++)
+		x[j] ^= data[i + j];
+	    if (n == 15  &&  i == sizeof(data) - 16)
+	    {
+		for (j = 0;  j < 16;  j++)
+		    x[j] ^= k1[j];		// last block is complete
+	    }
+	    swAesEncrypt (rk, x);
+	}
+    }
+    swCycles = DWT->CYCCNT;
+
+    Log ("Log Authentication Bench: HW %ld cycles/KB (%ldnJ), SW %ld cycles/KB"
+	 " (%ldnJ), MAC %s", hwCycles,
+	 hwCycles * (EM0_UA_PER_MHZ * VDD_MV / 1000) / 1000, swCycles,
+	 swCycles * (EM0_UA_PER_MHZ * VDD_MV / 1000) / 1000,
+	 memcmp (x, l_Mac, sizeof(x)) == 0 ? "ok" : "MISMATCH");
+
+    /* Restore the key */
+    if (saveFlg)
+	keyLoad ((const uint8_t *)saveKey);
+    else
+	l_flgKey = false;
+    memset (saveKey, 0, sizeof(saveKey));
+    LogAuthRestart();
+    l_ChainSeq = saveSeq;			// the bench chain is not logged
+    l_StatBlocks = l_StatBytes = l_StatCycles = 0;
+}
+#endif
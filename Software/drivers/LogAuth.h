@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module LogAuth.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_LogAuth_h
+#define __INC_LogAuth_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"		// include project configuration parameters
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief   Authenticate the log file.
+     * @details If set to 1, LogFlush() writes a MAC trailer line after each
+     * block of log data, see LogAuth.c.  Without a key in the flash, no
+     * trailers are written.
+     */
+#ifndef LOG_AUTH
+    #define LOG_AUTH		1
+#endif
+
+    /*!@brief Set 1 to log CPU time and energy per KB for hardware and
+     * software AES at start-up.
+     */
+#ifndef LOG_AUTH_BENCH
+    #define LOG_AUTH_BENCH	0
+#endif
+
+    /*!@brief Size of the key in bytes (AES-128). */
+#define LOG_AUTH_KEY_SIZE	16
+
+    /*!@brief Buffer size for a trailer line, see LogAuthTrailer(). */
+#define LOG_AUTH_TRAILER_SIZE	100
+
+/*================================ Prototypes ================================*/
+
+    /* Initialize the module, read the key from flash */
+void	 LogAuthInit (void);
+
+    /* Store a new key in flash, NULL disables the authentication */
+void	 LogAuthSetKey (const uint8_t *pKey);
+
+    /* Key state and key check value */
+bool	 LogAuthIsEnabled (void);
+uint32_t LogAuthKeyCheck (void);
+
+    /* Build the MAC of one block of log data */
+void	 LogAuthUpdate (const void *pData, unsigned int len);
+int	 LogAuthTrailer (char *pBuf);
+void	 LogAuthAbort (void);
+void	 LogAuthRestart (void);
+
+    /* Log the statistics */
+void	 LogAuthStatistics (void);
+
+
+#endif /* __INC_LogAuth_h */
@@ -0,0 +1,175 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Log Rate Limiter
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module limits the number of log messages per source module with a
+ * token bucket, so a flapping input, a transponder that stays on the antenna,
+ * or a noisy ADC channel cannot fill the log buffer faster than LogFlush()
+ * writes it to the SD-Card, and crowd out the rare messages of other modules.
+ *
+ * Every source has a bucket that holds up to @ref LOG_RATE_CFG::Burst
+ * messages, and is refilled with @ref LOG_RATE_CFG::Rate messages per minute.
+ * A message that finds the bucket empty is suppressed and only counted,
+ * together with the time of the first and the last suppressed message.
+ * LogMessage() checks the bucket before the message is formatted, so a
+ * suppressed message costs almost no CPU time.  The summary of a suppression
+ * is logged by Logging.c.  The module has no hardware dependencies, so the
+ * host tool LogStorm measures it under a synthetic log storm.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stddef.h>
+#include "LogRate.h"
+
+/*=========================== Forward Declarations ===========================*/
+
+static void	refill (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+			uint32_t now);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Reset a Bucket
+ *
+ * This routine fills the bucket.  It must be called once for every bucket,
+ * and after its configuration has been changed.  The suppression counter is
+ * kept, so a pending suppression is still reported.
+ *
+ * @param[in] pCfg
+ *	Rate limit of the source.
+ *
+ * @param[in,out] pBucket
+ *	Token bucket of the source.
+ *
+ * @param[in] now
+ *	Current time in [s].
+ *
+ ******************************************************************************/
+void	LogRateReset (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		      uint32_t now)
+{
+    pBucket->Credit = (pCfg->Burst > 0 ? pCfg->Burst : 1) * LOG_RATE_UNIT;
+    pBucket->Last   = now;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Take the Credit for one Message
+ *
+ * This routine refills the bucket for the time since the last call, and takes
+ * the credit for one message out of it.  If there is not enough credit, the
+ * message is counted as suppressed.
+ *
+ * @param[in] pCfg
+ *	Rate limit of the source.
+ *
+ * @param[in,out] pBucket
+ *	Token bucket of the source.
+ *
+ * @param[in] now
+ *	Current time in [s].
+ *
+ * @return
+ *	<i>true</i> if the message may be logged, <i>false</i> if it has to be
+ *	suppressed.
+ *
+ ******************************************************************************/
+bool	LogRateTake (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		     uint32_t now)
+{
+    if (pCfg->Rate == 0)
+	return true;			// no limit for this source
+
+    refill (pCfg, pBucket, now);
+
+    if (pBucket->Credit >= LOG_RATE_UNIT)
+    {
+	pBucket->Credit -= LOG_RATE_UNIT;
+	return true;
+    }
+
+    if (pBucket->Dropped++ == 0)
+	pBucket->FirstDrop = now;
+    pBucket->LastDrop = now;
+
+    return false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check if a Suppression is over
+ *
+ * This routine refills the bucket like LogRateTake(), without taking any
+ * credit out of it.  A suppression is over when the bucket is full again,
+ * i.e. the source has stayed below its rate long enough to log a complete
+ * burst.  While a storm goes on, single messages still pass at the rate, but
+ * the suppression is reported only once, when the storm is over.
+ *
+ * @param[in] pCfg
+ *	Rate limit of the source.
+ *
+ * @param[in,out] pBucket
+ *	Token bucket of the source.
+ *
+ * @param[in] now
+ *	Current time in [s].
+ *
+ * @return
+ *	<i>true</i> if messages have been suppressed, and the bucket is full
+ *	again.
+ *
+ ******************************************************************************/
+bool	LogRateEnded (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		      uint32_t now)
+{
+    if (pBucket->Dropped == 0)
+	return false;
+
+    if (pCfg->Rate == 0)
+	return true;			// limit has been removed
+
+    refill (pCfg, pBucket, now);
+
+    return (pBucket->Credit
+	    >= (pCfg->Burst > 0 ? pCfg->Burst : 1) * LOG_RATE_UNIT);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Refill a Bucket
+ *
+ * This routine adds the credit for the time since the last refill, up to the
+ * burst size.  When the clock has been set back, the time of the last refill
+ * is only moved to the new time.
+ *
+ ******************************************************************************/
+static void	refill (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+			uint32_t now)
+{
+uint32_t max, dt;
+
+
+    max = (pCfg->Burst > 0 ? pCfg->Burst : 1) * LOG_RATE_UNIT;
+
+    if ((int32_t)(now - pBucket->Last) > 0)
+    {
+	/* compare the time first, so the product cannot overflow */
+	dt = now - pBucket->Last;
+	if (pBucket->Credit >= max
+	||  dt >= (max - pBucket->Credit + pCfg->Rate - 1) / pCfg->Rate)
+	    pBucket->Credit = max;
+	else
+	    pBucket->Credit += dt * pCfg->Rate;
+    }
+    pBucket->Last = now;
+}
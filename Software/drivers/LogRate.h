@@ -0,0 +1,64 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module LogRate.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool LogStorm.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_LogRate_h
+#define __INC_LogRate_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Credit of one message.  The rate is given per minute and the
+     * credit is added per second, so one message costs 60 credits.
+     */
+#define LOG_RATE_UNIT		60
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Rate limit of a log source. */
+typedef struct
+{
+    uint32_t	Rate;		//!< Messages per minute, 0 means no limit
+    uint32_t	Burst;		//!< Messages that may be logged at once
+} LOG_RATE_CFG;
+
+    /*!@brief Token bucket of a log source, see LogRateTake(). */
+typedef struct
+{
+    uint32_t	Credit;		//!< Credit in 1/LOG_RATE_UNIT messages
+    uint32_t	Last;		//!< Time of the last refill in [s]
+    uint32_t	Dropped;	//!< Number of suppressed messages
+    uint32_t	FirstDrop;	//!< Time of the first suppressed message [s]
+    uint32_t	LastDrop;	//!< Time of the last suppressed message [s]
+} LOG_RATE_BUCKET;
+
+/*================================ Prototypes ================================*/
+
+    /* Fill the bucket, e.g. after the configuration has been changed */
+void	LogRateReset (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		      uint32_t now);
+
+    /* Take the credit for one message, or count it as suppressed */
+bool	LogRateTake  (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		      uint32_t now);
+
+    /* Check if the suppression of a source is over */
+bool	LogRateEnded (const LOG_RATE_CFG *pCfg, LOG_RATE_BUCKET *pBucket,
+		      uint32_t now);
+
+
+#endif /* __INC_LogRate_h */
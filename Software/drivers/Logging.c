@@ -9,6 +9,27 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent LogMessage() takes an optional time stamp of the event, see
+		LogAt().  The delay between event and log entry, and the
+		longest log flush, are reported with the alive message.
+2026-10-19,agent Rate limit per source module, see LogRate.c and LogRateSet().
+		Suppressed messages are summarized when the source has become
+		quiet again.
+2026-10-19,agent Added LogFlushPauseSet() to lengthen the pause between two
+		log flushes, e.g. when the battery runs low.
+2026-10-19,agent Copy log messages into the buffer with MemCopy(), this
+		shortens the time with interrupts disabled.
+2026-10-19,agent LogFlush() writes a MAC trailer after each block of log
+		data if LOG_AUTH is set, see LogAuth.c.
+2026-10-19,agent Added LogSourceName().
+2026-10-19,agent Added LogFileRead() to read back lines of the log file.  It
+		seeks via a cluster link map (LOG_FILE_FASTSEEK).
+		LogFileOpen() logs the open and seek time.
+2026-10-19,agent Every log entry gets a sequence number, see LOG_SEQ_NUM.
+		Lost log entries are counted per source module.  A loss burst
+		is reported with its sequence numbers and time window as soon
+		as there is space in the log buffer again.
+		Log() and LogError() are macros now, see LogMessage().
 2018-03-16,rage	Disable interrupts for a minimum of time to prevent data loss
 		of the ADC interrupt handler.
 		The Log Flush LED is no more flashing (just lights), because
@@ -37,13 +58,28 @@ Revision History:
 #include "ff.h"		// FS_FAT12/16/32
 #include "diskio.h"	// DSTATUS
 #include "microsd.h"
+#include "LogAuth.h"
+#include "MemUtil.h"
+#include "LogRate.h"
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_LOGGING
+
 #if LOG_MONITOR_FUNCTION == NONE
     #undef LOG_MONITOR_FUNCTION
 #endif
 
+    /*!@brief Length of the timestamp "20151231-235900.000" */
+#define LOG_TIMESTAMP_LEN	19
+
+    /*!@brief Sequence numbers wrap around at 10^LOG_SEQ_DIGITS. */
+#define LOG_SEQ_WRAP		1000000UL
+#if LOG_SEQ_DIGITS != 6
+    #error "LOG_SEQ_WRAP must be adapted to LOG_SEQ_DIGITS"
+#endif
+
 
     /*!@name Hardware Configuration: Log Flush LED. */
 //@{
@@ -75,8 +111,55 @@ char	g_LogFilename[14];
 static char	l_LogBuf[LOG_BUF_SIZE];
 static int	idxLogPut, idxLogGet;
 
-    /* Counter for lost log entries */
-static uint32_t	l_LostEntryCnt;
+    /* Names of the log sources, must match enum LOG_SRC in config.h */
+static const char * const l_LogSrcName[END_LOG_SRC] =
+{
+    "MAIN", "LOGGING", "ALARM", "BATTERY", "CONFIG", "CONTROL",
+    "DCF77", "DISPLAY", "POWERFAIL", "RFID", "SDCARD", "DMA",
+    "COMMAND", "GNSS"
+};
+
+    /* Sequence number of the next log entry */
+static uint32_t	l_SeqNum;
+
+    /* Counters for lost log entries per source */
+static uint32_t	l_LostEntryCnt[END_LOG_SRC];
+
+/*!
+ * Loss Burst: While the log buffer is full, lost entries are collected here.
+ * As soon as an entry fits into the buffer again, the burst is reported by
+ * logLossReport() and this structure is cleared.
+ */
+static struct
+{
+    uint32_t	Cnt;			//!< Number of lost entries
+    uint16_t	SrcCnt[END_LOG_SRC];	//!< Lost entries per source
+    uint32_t	FirstSeq, LastSeq;	//!< First and last sequence number
+    char	FirstTime[LOG_TIMESTAMP_LEN+1];	//!< Time of first lost entry
+    char	LastTime[LOG_TIMESTAMP_LEN+1];	//!< Time of last lost entry
+} l_LossBurst;
+
+    /* Flag is set while a loss burst is reported */
+static volatile bool l_flgLossReport;
+
+    /* Rate limits and token buckets of the sources, see LogRateSet() */
+static LOG_RATE_CFG	l_RateCfg[END_LOG_SRC];
+static LOG_RATE_BUCKET	l_RateBucket[END_LOG_SRC];
+
+    /* Flag is set when a message has been suppressed by the rate limit */
+static volatile bool l_flgSuppressed;
+
+/*!
+ * Delay between the time stamp of an event and its log entry, see LogAt().
+ * The statistics are reported and cleared by logAliveMsg().
+ */
+static struct
+{
+    uint32_t	Cnt;			//!< Number of time stamped entries
+    uint32_t	Sum;			//!< Sum of the delays in [ms]
+    uint32_t	Max;			//!< Longest delay in [ms]
+    uint32_t	FlushMax;		//!< Longest LogFlush() in [ms]
+} l_StampStat;
 
     /* Counter how many error messages may still be generated */
 static int	l_ErrMsgCnt;
@@ -90,9 +173,20 @@ static volatile bool l_flgLogFlushInhibit;
     /* File handle for log file */
 static FIL	l_fh;
 
+#if LOG_FILE_FASTSEEK
+    /* Cluster link map of the log file, see LogFileRead() */
+static DWORD	l_LinkMap[LINKMAP_SIZE(LOG_LINKMAP_FRAGMENTS)];
+
+    /* File size covered by the link map, 0 if there is no map */
+static DWORD	l_LinkMapSize;
+#endif
+
     /* Timer handle for the log buffer flushing control */
 static TIM_HDL	l_thLogFlushCtrl = NONE;
 
+    /* Pause between two log flushes in [s], see LogFlushPauseSet() */
+static uint32_t	l_LogFlushPause = LOG_FLUSH_PAUSE;
+
 #if KEY_AUTOREPEAT	// ms-Timer is already in use
     /* Timer handle for switching off the Flush LED after some time */
 static TIM_HDL	l_thLogFlushLED = NONE;
@@ -109,7 +203,14 @@ static TIM_HDL	l_thLogAliveIntvl = NONE;
 
 /*=========================== Forward Declarations ===========================*/
 
-static void	logMsg(const char *prefix, const char *frmt, va_list args);
+static void	logMsg(LOG_SRC src, const CLOCK_STAMP *pStamp,
+		       const char *prefix, const char *frmt, va_list args);
+static void	logLossReport(void);
+static bool	logSuppressTake(LOG_SRC src, uint32_t now, uint32_t *pCnt,
+				uint32_t *pFirst, uint32_t *pLast);
+static void	logSuppressCheck(void);
+static void	logSuppressReport(LOG_SRC src, uint32_t cnt, uint32_t first,
+				  uint32_t last);
 static void	logFlushLED(void);
 static void	logFlushCtrl(TIM_HDL hdl);
 #if LOG_ALIVE_INTERVAL > 0
@@ -157,7 +258,13 @@ void	 LogInit (void)
  *
  * @brief	Open Log File
  *
- * This routine (re-)opens the log file for writing.
+ * This routine (re-)opens the log file for writing.  The time required for
+ * opening and seeking to the end of the file is logged.
+ *
+ * @note
+ * The seek follows the FAT chain of the file once.  A cluster link map does
+ * not help here, it is built by the same walk, and FatFs cannot append to a
+ * file in fast seek mode.  The map is used by LogFileRead() instead.
  *
  * @param[in] filepattern
  *	Filename to compare all file entries in the root directory of the disk
@@ -175,6 +282,7 @@ void	 LogFileOpen (char *filepattern, char *filename)
 {
 FRESULT	 res;		// FatFs function common result code
 char	*pStr;		// string pointer
+uint32_t start, tOpen, tSeek;	// RTC counts for time measurement
 
 
     /* Parameter Check */
@@ -196,12 +304,24 @@ char	*pStr;		// string pointer
 
     strcpy (g_LogFilename, filename);
 
+#if LOG_FILE_FASTSEEK
+    l_LinkMapSize = 0;		// the link map belongs to the old file
+#endif
+
+#if LOG_AUTH
+    /* Start a new MAC chain for this file */
+    LogAuthRestart();
+#endif
+
     /* Discard old file handle, open new file */
+    start = msDelayStart();
     res = f_open (&l_fh, filename,  FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    tOpen = msDelayStart();
     if (res == FR_OK)
     {
 	res = f_lseek (&l_fh, f_size(&l_fh));
     }
+    tSeek = msDelayStart();
 
     if (res != FR_OK)
     {
@@ -211,6 +331,172 @@ char	*pStr;		// string pointer
     else
     {
 	l_ErrMsgCnt = 2;
+
+	tSeek = ((tSeek - tOpen) & 0xFFFFFF) * 1000 / RTC_COUNTS_PER_SEC;
+	tOpen = ((tOpen - start) & 0xFFFFFF) * 1000 / RTC_COUNTS_PER_SEC;
+	Log ("LogFileOpen: %ld bytes, open %ldms, seek %ldms",
+	     f_size(&l_fh), tOpen, tSeek);
+    }
+
+    /* Power off the SD-Card Interface */
+    MICROSD_PowerOff();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read back Log File
+ *
+ * This routine reads lines of the log file and sends them to the monitor
+ * output, see LOG_MONITOR_FUNCTION.  The log buffer is flushed before, so
+ * the file is up to date.  The lines are read via the file handle of the log
+ * file, which is set to the end of the file again afterwards.
+ *
+ * If LOG_FILE_FASTSEEK is 1, the first read builds a cluster link map of the
+ * log file.  Later reads within the part of the file covered by the map seek
+ * without reading the FAT.  For an offset behind it, the map is built again.
+ * Returning to the end of the file uses the map up to its last cluster and
+ * follows the FAT only for the clusters appended since.
+ *
+ * The offset, number of lines, time for seeking, and the offset of the next
+ * line are logged, so a host can read the whole file in pieces.
+ *
+ * @param[in] offset
+ *	Byte offset in the log file.  A negative value counts from the end of
+ *	the file.  If the offset is not 0, output starts with the next line.
+ *
+ * @param[in] lines
+ *	Number of lines to output, 1 to LOG_READ_MAX_LINES.
+ *
+ ******************************************************************************/
+void	 LogFileRead (int32_t offset, int lines)
+{
+FRESULT	 res;		// FatFs function common result code
+DWORD	 size, pos;	// file size and read position
+UINT	 cnt;		// number of bytes read
+int	 i, n;		// line and character counter
+char	 c;		// character read
+char	 line[LOG_ENTRY_MAX_SIZE];	// line buffer
+uint32_t start, tSeek;	// RTC counts for time measurement
+const char *pMode = "off";	// how the link map was used
+
+
+    /* Parameter check */
+    if (lines < 1)
+	lines = 1;
+    if (lines > LOG_READ_MAX_LINES)
+	lines = LOG_READ_MAX_LINES;
+
+    /* See if Log File is open */
+    if (IsFileHandleValid(&l_fh) == false)
+    {
+	LogError ("LogFileRead: No Log File");
+	return;
+    }
+
+    /* Write pending messages and leave the SD-Card on */
+    LogFlush (true);
+    if (IsPowerFail())
+	return;
+
+    /* Calculate the read position */
+    size = f_size(&l_fh);
+    if (offset < 0)
+	pos = ((DWORD)-offset < size ? size + offset : 0);
+    else
+	pos = ((DWORD)offset < size ? (DWORD)offset : size);
+
+    start = msDelayStart();
+#if LOG_FILE_FASTSEEK
+    /* (Re-)build the link map if the position is behind it */
+    if (pos > l_LinkMapSize  ||  l_LinkMapSize == 0)
+    {
+	l_LinkMapSize = 0;
+	if (FileLinkMapCreate (&l_fh, l_LinkMap, sizeof(l_LinkMap)
+					/ sizeof(l_LinkMap[0])) >= 0)
+	{
+	    l_LinkMapSize = size;
+	    pMode = "built";
+	}
+    }
+    else
+    {
+	pMode = "used";
+    }
+
+    if (pos <= l_LinkMapSize  &&  l_LinkMapSize > 0)
+    {
+	l_fh.cltbl = l_LinkMap;
+	res = f_lseek (&l_fh, pos);
+	l_fh.cltbl = NULL;	// read and append in normal mode
+    }
+    else
+#endif
+    {
+	l_fh.cltbl = NULL;
+	res = f_lseek (&l_fh, pos);
+    }
+    tSeek = msDelayStart();
+
+    /* Skip the rest of a line */
+    c = '\n';
+    if (res == FR_OK  &&  pos > 0)
+    {
+	do
+	{
+	    res = f_read (&l_fh, &c, 1, &cnt);
+	} while (res == FR_OK  &&  cnt == 1  &&  c != '\n');
+    }
+
+    /* Output lines */
+    for (i = 0;  i < lines  &&  res == FR_OK  &&  c == '\n';  i++)
+    {
+	n = 0;
+	c = EOS;
+	while (n < LOG_ENTRY_MAX_SIZE - 2)
+	{
+	    res = f_read (&l_fh, &c, 1, &cnt);
+	    if (res != FR_OK  ||  cnt == 0)
+		break;
+	    if (c == '\r')
+		continue;
+	    line[n++] = c;
+	    if (c == '\n')
+		break;
+	}
+	if (n == 0)
+	    break;			// end of file
+
+	if (c != '\n')
+	    line[n++] = '\n';	// line too long, skip its rest next time
+	line[n] = EOS;
+#ifdef LOG_MONITOR_FUNCTION
+	LOG_MONITOR_FUNCTION (line);
+#endif
+    }
+    pos = f_tell(&l_fh);
+
+    /* Return to the end of the file for appending */
+#if LOG_FILE_FASTSEEK
+    if (l_LinkMapSize > 0  &&  f_tell(&l_fh) < l_LinkMapSize)
+    {
+	l_fh.cltbl = l_LinkMap;
+	f_lseek (&l_fh, l_LinkMapSize);
+	l_fh.cltbl = NULL;
+    }
+#endif
+    if (f_lseek (&l_fh, f_size(&l_fh)) != FR_OK  &&  res == FR_OK)
+	res = FR_DISK_ERR;
+
+    if (res != FR_OK)
+    {
+	LogError ("LogFileRead: Error Code %d", res);
+    }
+    else
+    {
+	tSeek = ((tSeek - start) & 0xFFFFFF) * 1000 / RTC_COUNTS_PER_SEC;
+	Log ("LogFileRead: %d lines, next %ld of %ld bytes, link map %s,"
+	     " seek %ldms", i, pos, f_size(&l_fh), pMode, tSeek);
     }
 
     /* Power off the SD-Card Interface */
@@ -223,44 +509,108 @@ char	*pStr;		// string pointer
  * @brief	Log a Message
  *
  * This routine writes a log message into the buffer.  It may be called from
- * interrupt context.
+ * interrupt context.  Usually it is not called directly, but via the macros
+ * Log() and LogError() which pass the @ref LOG_SOURCE of the calling module.
  *
  * The format of a log message is:
- * 20151231-235900 \<message\>
+ * 20151231-235900.000 #000123 \<message\>
+ *
+ * The format of an error log message is:
+ * 20151231-235900.000 #000123 ERROR \<message\>
+ *
+ * If the source has exceeded its rate limit, see LogRateSet(), the message
+ * is suppressed before it is formatted.  When the source has become quiet
+ * again, the number of suppressed messages is logged by logSuppressReport().
+ *
+ * An event that is detected in an interrupt routine, but logged later from
+ * the main loop, should be time stamped by ClockStamp() where it occurs.
+ * Otherwise the entry gets the time when the main loop reached it, which can
+ * be much later while LogFlush() is writing to the SD-Card.  Use the macros
+ * LogAt() and LogErrorAt() for this.
+ *
+ * @param[in] src
+ *	Source module of the message, see @ref LOG_SRC.
+ *
+ * @param[in] flgError
+ *	If <i>true</i>, the message is marked as error.
+ *
+ * @param[in] pStamp
+ *	Time stamp of the event, or NULL to use the current time.
+ *
+ * @param[in] frmt
+ *	Format string and arguments as for printf().
  *
  ******************************************************************************/
-void	 Log (const char *frmt, ...)
+void	 LogMessage (LOG_SRC src, bool flgError, const CLOCK_STAMP *pStamp,
+		     const char *frmt, ...)
 {
 va_list	 args;
+uint32_t cnt, first, last;
+
 
+    /* Parameter check */
+    if ((unsigned int)src >= END_LOG_SRC)
+	src = LOG_SRC_MAIN;
+
+    /* Check the rate limit first, a suppressed message costs no formatting */
+    if (l_RateCfg[src].Rate > 0)
+    {
+	if (! logSuppressTake (src, (uint32_t)time(NULL), &cnt, &first, &last))
+	    return;
+
+	if (cnt > 0)
+	    logSuppressReport (src, cnt, first, last);
+    }
 
     /* build variable argument list and call logMsg() */
     va_start(args, frmt);
-    logMsg (NULL, frmt, args);
+    logMsg (src, pStamp, flgError ? "ERROR " : NULL, frmt, args);
     va_end(args);
 }
 
 
 /***************************************************************************//**
  *
- * @brief	Log an Error Message
+ * @brief	Get Number of Lost Log Entries
  *
- * This routine writes an error log message into the buffer.  It may be called
- * from interrupt context.
+ * This routine returns the number of log entries that have been lost since
+ * power-up, because the log buffer was full.
  *
- * The format of an error log message is:
- * 20151231-235900 ERROR \<message\>
+ * @param[in] src
+ *	Source module, see @ref LOG_SRC.  Use END_LOG_SRC to get the total
+ *	number of lost entries of all modules.
  *
  ******************************************************************************/
-void	 LogError (const char *frmt, ...)
+uint32_t LogLostEntryCount (LOG_SRC src)
 {
-va_list	 args;
+uint32_t cnt;
+int	 i;
 
 
-    /* build variable argument list and call logMsg() */
-    va_start(args, frmt);
-    logMsg ("ERROR ", frmt, args);
-    va_end(args);
+    if ((unsigned int)src < END_LOG_SRC)
+	return l_LostEntryCnt[src];
+
+    for (cnt = 0, i = 0;  i < END_LOG_SRC;  i++)
+	cnt += l_LostEntryCnt[i];
+
+    return cnt;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Name of a Log Source
+ *
+ * This routine returns the name of the specified @ref LOG_SRC as used in
+ * the loss reports, e.g. "RFID".
+ *
+ ******************************************************************************/
+const char *LogSourceName (LOG_SRC src)
+{
+    if ((unsigned int)src >= END_LOG_SRC)
+	return "?";
+
+    return l_LogSrcName[src];
 }
 
 
@@ -282,6 +632,10 @@ void	 LogFlush (bool flgKeepPowerOn)
 FRESULT	 res = FR_DISK_ERR;	// FatFs function common result code
 int	 cnt;
 UINT	 bytesWr;
+uint32_t start;			// RTC count at the start of the flush
+#if LOG_AUTH
+char	 trailer[LOG_AUTH_TRAILER_SIZE];
+#endif
 
 
     /* Check for power-fail */
@@ -293,6 +647,7 @@ UINT	 bytesWr;
 	return;			// no file open or invalid file handle
 
     /* Switch the SD-Card Interface on */
+    start = msDelayStart();
     MICROSD_PowerOn();
 
     /* Re-Initialize disk (mount is still the same!) */
@@ -343,15 +698,42 @@ UINT	 bytesWr;
 		break;
 	    }
 
+#if LOG_AUTH
+	    LogAuthUpdate (l_LogBuf + idxLogGet + 1, cnt);
+#endif
 	    /* update index, consider <len> byte and EOS */
 	    idxLogGet += (cnt + 2);
 	}   // while (idxLogGet != idxLogPut)
 
+#if LOG_AUTH
+	/* Complete the block with its MAC, or start a new chain on error */
+	if (res == FR_OK)
+	{
+	    cnt = LogAuthTrailer (trailer);
+	    if (cnt > 0)
+	    {
+		res = f_write (&l_fh, trailer, cnt, &bytesWr);
+		if (res == FR_OK  &&  bytesWr < cnt)
+		    res = FR_DISK_ERR;
+		if (res != FR_OK)
+		    LogAuthRestart();
+	    }
+	}
+	else
+	{
+	    LogAuthAbort();
+	}
+#endif
 	/* Synchronize file system */
 	if (res == FR_OK)
 	    f_sync (&l_fh);
     }
 
+    /* Keep the longest flush, it delays the time stamped entries */
+    start = ((msDelayStart() - start) & 0xFFFFFF) * 1000 / RTC_COUNTS_PER_SEC;
+    if (l_StampStat.FlushMax < start)
+	l_StampStat.FlushMax = start;
+
     /* Check if SD-Card power should be left on */
     if (flgKeepPowerOn  &&  ! IsPowerFail())
 	return;
@@ -377,7 +759,7 @@ UINT	 bytesWr;
 
     /* Start timer to handle log flushing pause */
     if (l_thLogFlushCtrl != NONE)
-	sTimerStart (l_thLogFlushCtrl, LOG_FLUSH_PAUSE);
+	sTimerStart (l_thLogFlushCtrl, l_LogFlushPause);
 
     /* Inhibit flushing the log buffer for that time */
     l_flgLogFlushInhibit = true;
@@ -400,6 +782,68 @@ void	 LogFlushTrigger (void)
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Set the Pause between two Log Flushes
+ *
+ * This routine changes the minimum pause between flushing the log buffer.
+ * A longer pause collects more log messages per flush and so saves the
+ * energy of powering up the SD-Card.  The log buffer is still flushed when
+ * @ref LOG_SAMPLE_MAX_SIZE is reached, so no log messages are lost.
+ *
+ * @param[in] seconds
+ *	Pause in seconds, 0 restores the default of @ref LOG_FLUSH_PAUSE.
+ *
+ ******************************************************************************/
+void	 LogFlushPauseSet (uint32_t seconds)
+{
+    l_LogFlushPause = (seconds > 0 ? seconds : LOG_FLUSH_PAUSE);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Set the Rate Limit of a Log Source
+ *
+ * This routine sets the rate limit of a source module, see LogRate.c.  The
+ * token bucket of the source is filled.  The messages of the logging facility
+ * itself (@ref LOG_SRC_LOGGING) are never limited, because they report the
+ * suppressed and lost messages.
+ *
+ * @note
+ * The rate limit uses time(), so it must not be set before the Alarm Clock
+ * module has been initialized.  Until then, no source is limited.
+ *
+ * @param[in] src
+ *	Source module, see @ref LOG_SRC.
+ *
+ * @param[in] rate
+ *	Number of messages per minute, 0 means no limit.
+ *
+ * @param[in] burst
+ *	Number of messages the source may log at once.
+ *
+ ******************************************************************************/
+void	 LogRateSet (LOG_SRC src, uint32_t rate, uint32_t burst)
+{
+uint32_t now;
+
+
+    if ((unsigned int)src >= END_LOG_SRC  ||  src == LOG_SRC_LOGGING)
+	return;
+
+    now = (uint32_t)time(NULL);
+
+    INT_Disable();
+    l_RateCfg[src].Rate  = rate;
+    l_RateCfg[src].Burst = burst;
+    LogRateReset (&l_RateCfg[src], &l_RateBucket[src], now);
+    if (l_RateBucket[src].Dropped > 0)
+	l_flgSuppressed = true;		// report it with the next check
+    INT_Enable();
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Check if Log Buffer should be Flushed
@@ -407,6 +851,7 @@ void	 LogFlushTrigger (void)
  * This routine is periodically called from the main loop to check if the log
  * buffer should be flushed, i.e. l_flgLogFlushTrigger is set, or more than
  * @ref LOG_SAMPLE_MAX_SIZE bytes have been stored in the log buffer.
+ * Before, suppressions of sources that have become quiet are reported.
  *
  ******************************************************************************/
 void	 LogFlushCheck (void)
@@ -414,6 +859,9 @@ void	 LogFlushCheck (void)
 int	 cnt;			// allocated space in the log buffer
 
 
+    if (l_flgSuppressed)
+	logSuppressCheck();
+
     cnt = idxLogPut - idxLogGet;	// calculate allocated space
     if (cnt < 0)
 	cnt += LOG_BUF_SIZE;		// wrap around
@@ -432,20 +880,30 @@ int	 cnt;			// allocated space in the log buffer
  *
  * @brief	Log Message
  *
- * This routine writes the current time stamp, an optional prefix, and the
- * specified log message into the buffer.
+ * This routine writes the current time stamp, the sequence number, an optional
+ * prefix, and the specified log message into the buffer.  The sequence number
+ * is assigned while interrupts are disabled, so the numbers are in the same
+ * order as the entries in the log buffer.
  *
  * The format of a log message is:
- * 20151231-235900 \<prefix\> \<message\>
+ * 20151231-235900.000 #000123 \<prefix\> \<message\>
  *
  ******************************************************************************/
-static void	logMsg(const char *prefix, const char *frmt, va_list args)
+static void	logMsg(LOG_SRC src, const CLOCK_STAMP *pStamp,
+		       const char *prefix, const char *frmt, va_list args)
 {
 char	 tmpBuffer[LOG_ENTRY_MAX_SIZE];	// use this if the log buffer is full
 char	*pBuf;				// pointer to the buffer to use
 int	 len, cnt, num;			// message length, available space
 struct tm    time;			// current time (hh:mm:ss)
 unsigned int ms;			// current [ms]
+bool	 flgLost;			// entry could not be stored
+CLOCK_STAMP now;			// current time for the delay
+int32_t	 delay;				// delay since the time stamp [ms]
+#if LOG_SEQ_NUM
+int	 seqPos, i;			// position of the sequence number
+uint32_t seqNum;
+#endif
 
 
     /* Start timer to handle sample timeout */
@@ -462,8 +920,29 @@ unsigned int ms;			// current [ms]
     /* Reserve one byte for string length information */
     len = 1;
 
-    /* Store timestamp */
-    ClockGetMilliSec (&time, &ms);
+    /* Store timestamp, the one of the event if there is one */
+    if (pStamp == NULL)
+    {
+	ClockGetMilliSec (&time, &ms);
+    }
+    else
+    {
+	ClockStampGet (pStamp, &time, &ms);
+
+	/* Update the statistics of the delay */
+	ClockStamp (&now);
+	delay = (int32_t)(now.Time - pStamp->Time) * 1000
+		+ now.MilliSec - pStamp->MilliSec;
+	if (pStamp->Time != 0  &&  now.Time != 0  &&  delay >= 0)
+	{
+	    INT_Disable();
+	    l_StampStat.Cnt++;
+	    l_StampStat.Sum += delay;
+	    if (l_StampStat.Max < (uint32_t)delay)
+		l_StampStat.Max = delay;
+	    INT_Enable();
+	}
+    }
 
     if (time.tm_year != 0)
     {
@@ -483,6 +962,12 @@ unsigned int ms;			// current [ms]
 	len += 20;
     }
 
+#if LOG_SEQ_NUM
+    /* Reserve space for the sequence number, it is assigned later */
+    seqPos = len + 1;
+    len += sprintf (pBuf + len, "#%0*d ", LOG_SEQ_DIGITS, 0);
+#endif
+
     /* Store optional prefix */
     if (prefix != NULL)
     {
@@ -514,10 +999,32 @@ unsigned int ms;			// current [ms]
 
     cnt = LOG_BUF_SIZE - cnt - 1;	// calculate free space
 
-    if (cnt < len)
+#if LOG_SEQ_NUM
+    /* Assign the sequence number - lost entries also consume a number */
+    seqNum = l_SeqNum;
+    for (i = LOG_SEQ_DIGITS - 1;  i >= 0;  i--)
+    {
+	tmpBuffer[seqPos + i] = '0' + (seqNum % 10);
+	seqNum /= 10;
+    }
+#endif
+    l_SeqNum = (l_SeqNum + 1) % LOG_SEQ_WRAP;
+
+    flgLost = (cnt < len);
+    if (flgLost)
     {
 	/* Not enough space in buffer - skip entry and count as "lost" */
-	l_LostEntryCnt++;
+	l_LostEntryCnt[src]++;
+
+	/* Record sequence number and time window of this loss burst */
+	if (l_LossBurst.Cnt++ == 0)
+	{
+	    l_LossBurst.FirstSeq = (l_SeqNum + LOG_SEQ_WRAP - 1) % LOG_SEQ_WRAP;
+	    memcpy (l_LossBurst.FirstTime, tmpBuffer + 1, LOG_TIMESTAMP_LEN);
+	}
+	l_LossBurst.LastSeq = (l_SeqNum + LOG_SEQ_WRAP - 1) % LOG_SEQ_WRAP;
+	memcpy (l_LossBurst.LastTime, tmpBuffer + 1, LOG_TIMESTAMP_LEN);
+	l_LossBurst.SrcCnt[src]++;
 
 	/* enable interrupts again */
 	INT_Enable();
@@ -528,7 +1035,7 @@ unsigned int ms;			// current [ms]
 
 	/* then generate and output error message */
 	sprintf (tmpBuffer + 1, "ERROR: Log Buffer Out of Memory"
-				" - lost %ld Messages\n", l_LostEntryCnt);
+				" - lost %ld Messages\n", (long)l_LossBurst.Cnt);
 #endif
     }
     else
@@ -549,7 +1056,7 @@ unsigned int ms;			// current [ms]
 	idxLogPut += len;
 
 	/* copy message from temporary buffer into log buffer */
-	memcpy (pBuf, tmpBuffer, len);
+	MemCopy (pBuf, tmpBuffer, len);
 
 	/* enable interrupts again */
 	INT_Enable();
@@ -559,6 +1066,211 @@ unsigned int ms;			// current [ms]
 #ifdef LOG_MONITOR_FUNCTION
     LOG_MONITOR_FUNCTION (tmpBuffer + 1);
 #endif
+
+    /* Report a previous loss burst now that there is space again */
+    if (! flgLost  &&  l_LossBurst.Cnt > 0)
+	logLossReport();
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Report a Loss Burst
+ *
+ * This routine is called by logMsg() when an entry could be stored again
+ * after one or more entries have been lost.  It logs the number of lost
+ * entries, the range of their sequence numbers, the time window, and the
+ * number of lost entries per source module:
+ *
+ * 20151231-235900.000 #000130 ERROR Log Lost: 12 entries #000100-#000111
+ * 20151231-235858.310 - 20151231-235859.990
+ * 20151231-235900.000 #000131 ERROR Log Lost by Source: CONTROL 7, RFID 5
+ *
+ * If these entries get lost again, they become part of the next burst.
+ *
+ ******************************************************************************/
+static void	logLossReport(void)
+{
+uint32_t cnt, firstSeq, lastSeq;
+uint16_t srcCnt[END_LOG_SRC];
+char	 firstTime[LOG_TIMESTAMP_LEN+1], lastTime[LOG_TIMESTAMP_LEN+1];
+char	 srcList[LOG_ENTRY_MAX_SIZE / 2];
+int	 i, len;
+
+
+    /* Take over and clear the burst data, prevent recursion */
+    INT_Disable();
+    if (l_flgLossReport  ||  l_LossBurst.Cnt == 0)
+    {
+	INT_Enable();
+	return;
+    }
+    l_flgLossReport = true;
+
+    cnt = l_LossBurst.Cnt;
+    firstSeq = l_LossBurst.FirstSeq;
+    lastSeq  = l_LossBurst.LastSeq;
+    memcpy (firstTime, l_LossBurst.FirstTime, LOG_TIMESTAMP_LEN);
+    memcpy (lastTime,  l_LossBurst.LastTime,  LOG_TIMESTAMP_LEN);
+    memcpy (srcCnt, l_LossBurst.SrcCnt, sizeof(srcCnt));
+    memset (&l_LossBurst, 0, sizeof(l_LossBurst));
+    INT_Enable();
+
+    firstTime[LOG_TIMESTAMP_LEN] = lastTime[LOG_TIMESTAMP_LEN] = EOS;
+
+    LogError ("Log Lost: %lu entries #%0*lu-#%0*lu %s - %s", cnt,
+	      LOG_SEQ_DIGITS, firstSeq, LOG_SEQ_DIGITS, lastSeq,
+	      firstTime, lastTime);
+
+    /* Build list of sources, skip the rest if it gets too long */
+    for (len = 0, i = 0;  i < END_LOG_SRC;  i++)
+    {
+	if (srcCnt[i] == 0)
+	    continue;
+
+	if (len + strlen(l_LogSrcName[i]) + 9 >= sizeof(srcList))
+	    break;
+
+	len += sprintf (srcList + len, "%s%s %d", len ? ", " : "",
+			l_LogSrcName[i], srcCnt[i]);
+    }
+    srcList[len] = EOS;
+
+    LogError ("Log Lost by Source: %s", srcList);
+
+    l_flgLossReport = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Take a Message through the Rate Limit
+ *
+ * This routine checks the token bucket of the source.  If the message may be
+ * logged, and a previous suppression is over, the data of the suppression is
+ * returned and cleared.
+ *
+ * @param[in] src
+ *	Source module of the message.
+ *
+ * @param[in] now
+ *	Current time in [s].
+ *
+ * @param[out] pCnt
+ *	Number of suppressed messages to report, or 0.
+ *
+ * @param[out] pFirst, pLast
+ *	Time of the first and the last suppressed message.
+ *
+ * @return
+ *	<i>true</i> if the message may be logged.
+ *
+ ******************************************************************************/
+static bool	logSuppressTake(LOG_SRC src, uint32_t now, uint32_t *pCnt,
+				uint32_t *pFirst, uint32_t *pLast)
+{
+LOG_RATE_BUCKET *pBucket = &l_RateBucket[src];
+bool	 flgPass;
+
+
+    *pCnt = 0;
+
+    INT_Disable();
+    if (LogRateEnded (&l_RateCfg[src], pBucket, now))
+    {
+	*pCnt   = pBucket->Dropped;
+	*pFirst = pBucket->FirstDrop;
+	*pLast  = pBucket->LastDrop;
+	pBucket->Dropped = 0;
+    }
+
+    flgPass = LogRateTake (&l_RateCfg[src], pBucket, now);
+    if (! flgPass)
+	l_flgSuppressed = true;
+    INT_Enable();
+
+    return flgPass;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check for the End of Suppressions
+ *
+ * This routine is called by LogFlushCheck() while a source is suppressed.
+ * It reports the suppressions of all sources that have become quiet.
+ *
+ ******************************************************************************/
+static void	logSuppressCheck(void)
+{
+LOG_RATE_BUCKET *pBucket;
+uint32_t now, cnt, first, last;
+int	 i;
+
+
+    now = (uint32_t)time(NULL);
+    l_flgSuppressed = false;
+
+    for (i = 0;  i < END_LOG_SRC;  i++)
+    {
+	pBucket = &l_RateBucket[i];
+	cnt = 0;
+
+	INT_Disable();
+	if (LogRateEnded (&l_RateCfg[i], pBucket, now))
+	{
+	    cnt   = pBucket->Dropped;
+	    first = pBucket->FirstDrop;
+	    last  = pBucket->LastDrop;
+	    pBucket->Dropped = 0;
+	}
+	else if (pBucket->Dropped > 0)
+	{
+	    l_flgSuppressed = true;	// still suppressed, check again
+	}
+	INT_Enable();
+
+	if (cnt > 0)
+	    logSuppressReport ((LOG_SRC)i, cnt, first, last);
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Report a Suppression
+ *
+ * This routine logs the number of messages of a source that have been
+ * suppressed by the rate limit, and the time of the first and the last one:
+ *
+ * 20151231-235930.000 #000140 Log Suppressed: RFID 153 messages
+ * 20151231-235812 - 20151231-235902
+ *
+ * Suppressed messages do not consume sequence numbers, so they are not
+ * reported as lost by a host tool.
+ *
+ ******************************************************************************/
+static void	logSuppressReport(LOG_SRC src, uint32_t cnt, uint32_t first,
+				  uint32_t last)
+{
+struct tm tmFirst, tmLast;
+time_t	 t;
+
+
+    /* localtime() is not reentrant, lock out the RTC interrupt */
+    INT_Disable();
+    t = (time_t)first;
+    tmFirst = *localtime (&t);
+    t = (time_t)last;
+    tmLast = *localtime (&t);
+    INT_Enable();
+
+    Log ("Log Suppressed: %s %lu messages %04d%02d%02d-%02d%02d%02d"
+	 " - %04d%02d%02d-%02d%02d%02d", l_LogSrcName[src], cnt,
+	 tmFirst.tm_year + 1900, tmFirst.tm_mon + 1, tmFirst.tm_mday,
+	 tmFirst.tm_hour, tmFirst.tm_min, tmFirst.tm_sec,
+	 tmLast.tm_year + 1900, tmLast.tm_mon + 1, tmLast.tm_mday,
+	 tmLast.tm_hour, tmLast.tm_min, tmLast.tm_sec);
 }
 
 
@@ -609,6 +1321,18 @@ static void	logAliveMsg(TIM_HDL hdl)
 
     /* Write Alive Message */
     Log ("Alive");
+
+    /* Report the delay of time stamped entries since the last one */
+    if (l_StampStat.Cnt > 0)
+    {
+	Log ("Time Stamps: %ld entries, delay mean %ldms, max %ldms,"
+	     " longest flush %ldms", l_StampStat.Cnt,
+	     l_StampStat.Sum / l_StampStat.Cnt, l_StampStat.Max,
+	     l_StampStat.FlushMax);
+	INT_Disable();
+	memset (&l_StampStat, 0, sizeof(l_StampStat));
+	INT_Enable();
+    }
 }
 #endif
 
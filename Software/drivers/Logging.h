@@ -5,6 +5,15 @@
  * @version	2018-03-16
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added LogAt() and LogErrorAt() to log an event with the time
+		stamp of its source, LogMessage() has a parameter for it.
+2026-10-19,agent Added LOG_RATE_DFLT, LOG_BURST_DFLT, and LogRateSet().
+2026-10-19,agent Added prototype for LogFlushPauseSet().
+2026-10-19,agent Added prototype for LogSourceName().
+2026-10-19,agent Added LOG_FILE_FASTSEEK, LOG_LINKMAP_FRAGMENTS,
+		LOG_READ_MAX_LINES, and prototype for LogFileRead().
+2026-10-19,agent Log() and LogError() are macros now which pass LOG_SOURCE.
+		Added LOG_SEQ_NUM, increased LOG_ENTRY_MAX_SIZE to 128.
 2019-02-10,rage	Increased LOG_SAMPLE_MAX_SIZE from 100 to 120 characters.
 2018-03-16,rage Added prototype for LogFlushTrigger().
 2015-04-02,rage	Initial version.
@@ -16,6 +25,7 @@ Revision History:
 /*=============================== Header Files ===============================*/
 
 #include "config.h"		// include project configuration parameters
+#include "AlarmClock.h"		// CLOCK_STAMP
 
 /*=============================== Definitions ================================*/
 
@@ -58,7 +68,46 @@ Revision History:
      * of the buffer is less than this value.
      */
 #ifndef LOG_ENTRY_MAX_SIZE
-    #define LOG_ENTRY_MAX_SIZE	120
+    #define LOG_ENTRY_MAX_SIZE	128
+#endif
+
+    /*!@brief   Sequence number for log entries.
+     * @details If set to 1, each log entry gets a sequence number of @ref
+     * LOG_SEQ_DIGITS digits after the timestamp, e.g.
+     * <b>20151231-235900.000 #000123 \<message\></b>.  The number is
+     * assigned when the entry is stored into the log buffer.  Lost entries
+     * also consume a number, so a host tool can detect gaps, duplicates, and
+     * ordering faults.  The counter starts with 0 after each reset and wraps
+     * around after 10^LOG_SEQ_DIGITS entries.
+     */
+#ifndef LOG_SEQ_NUM
+    #define LOG_SEQ_NUM		1
+#endif
+
+    /*!@brief Number of decimal digits of the sequence number. */
+#define LOG_SEQ_DIGITS		6
+
+    /*!@brief   Use a cluster link map to read back the log file.
+     * @details If set to 1, LogFileRead() seeks via a cluster link map table
+     * of the log file, see FileLinkMapCreate(), instead of following the FAT
+     * chain.  The map is built by the first read and used again as long as
+     * the offset lies within the part of the file it covers.  The seek time
+     * is logged, so both modes can be compared.
+     */
+#ifndef LOG_FILE_FASTSEEK
+    #define LOG_FILE_FASTSEEK	1
+#endif
+
+    /*!@brief Maximum number of fragments of the log file in the link map. */
+#ifndef LOG_LINKMAP_FRAGMENTS
+    #define LOG_LINKMAP_FRAGMENTS	15
+#endif
+
+    /*!@brief Maximum number of lines LogFileRead() outputs at once, they
+     * must fit into the transmit FIFO of the LEUART.
+     */
+#ifndef LOG_READ_MAX_LINES
+    #define LOG_READ_MAX_LINES	8
 #endif
 
     /*!@brief Use this define to specify a function to be called for monitoring
@@ -70,6 +119,41 @@ Revision History:
     #define LOG_MONITOR_FUNCTION	NONE
 #endif
 
+    /*!@brief Default rate limit of a log source in messages per minute,
+     * see LogRateSet().  0 disables the limit, it must be enabled by the
+     * configuration variables LOG_RATE or LOG_RATE_\<source\>.
+     */
+#ifndef LOG_RATE_DFLT
+    #define LOG_RATE_DFLT	0
+#endif
+
+    /*!@brief Default number of messages a log source may log at once. */
+#ifndef LOG_BURST_DFLT
+    #define LOG_BURST_DFLT	30
+#endif
+
+/*================================== Macros ==================================*/
+
+/*!@brief Log a message or an error.
+ *
+ * These macros pass the source module of the calling C file to LogMessage().
+ * Therefore each module must define @ref LOG_SOURCE to one of the entries of
+ * @ref LOG_SRC, for example:
+ * @code
+ * #define LOG_SOURCE	LOG_SRC_RFID
+ * @endcode
+ * LogAt() and LogErrorAt() log an event that has been time stamped where it
+ * occurred, see ClockStamp(), instead of with the current time.
+ */
+//@{
+#define Log(...)	LogMessage (LOG_SOURCE, false, NULL, __VA_ARGS__)
+#define LogError(...)	LogMessage (LOG_SOURCE, true, NULL, __VA_ARGS__)
+#define LogAt(pStamp, ...)	\
+		LogMessage (LOG_SOURCE, false, pStamp, __VA_ARGS__)
+#define LogErrorAt(pStamp, ...)	\
+		LogMessage (LOG_SOURCE, true, pStamp, __VA_ARGS__)
+//@}
+
 /*================================ Global Data ===============================*/
 
     /* Filename of the current Log File on the SD-Card */
@@ -79,11 +163,16 @@ extern char	g_LogFilename[14];
 
 void	 LogInit (void);		// Initialize the logging facility
 void	 LogFileOpen (char *filepattern, char *filename); // Open Log File
-void	 Log (const char *frmt, ...);		// Log a message
-void	 LogError (const char *frmt, ...);	// Log an error
+void	 LogFileRead (int32_t offset, int lines);	// Read back log lines
+void	 LogMessage (LOG_SRC src, bool flgError, const CLOCK_STAMP *pStamp,
+		     const char *frmt, ...);
+uint32_t LogLostEntryCount (LOG_SRC src);	// Number of lost log entries
+const char *LogSourceName (LOG_SRC src);	// Name of a log source
 void	 LogFlush (bool flgKeepPowerOn);	// Flush the log buffer
 void	 LogFlushTrigger (void);	// Trigger a Log Flush
 void	 LogFlushCheck (void);		// Check if to flush the log buffer
+void	 LogFlushPauseSet (uint32_t seconds);	// Pause between flushes
+void	 LogRateSet (LOG_SRC src, uint32_t rate, uint32_t burst); // Rate limit
 
 
 #endif /* __INC_Logging_h */
@@ -0,0 +1,298 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Memory Functions with Word Access
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module provides copy, fill, and compare functions for FatFs and the
+ * drivers.  The C library of the firmware is built for size, so its memcpy()
+ * and memset() work byte by byte.  The routines here align the destination
+ * first, and then transfer 16 bytes per LDM/STM burst if the source is
+ * aligned, too.  Otherwise they use single word loads, which are allowed at
+ * unaligned addresses on the Cortex-M3, see @ref MEM_UNALIGNED_ACCESS.
+ * On other CPUs, i.e. host builds, portable C code is used.
+ *
+ * Set @ref MEM_UTIL_BENCH to 1 to log the cycle counts for a sector copy,
+ * a directory scan, and a FAT walk in comparison to byte access.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include "MemUtil.h"
+#if MEM_UTIL_BENCH
+    #include "em_device.h"
+    #include "Logging.h"
+#endif
+
+/*=============================== Definitions ================================*/
+
+#if MEM_UTIL_BENCH
+    /*!@brief Source module of the log messages of this file. */
+    #define LOG_SOURCE	LOG_SRC_MAIN
+#endif
+
+    /*!@brief Word type that may alias any other type. */
+#if defined(__GNUC__)
+typedef uint32_t __attribute__((may_alias)) MEM_WORD;
+#else
+typedef uint32_t MEM_WORD;
+#endif
+
+    /*!@brief Copy 16 bytes between aligned addresses and advance pointers. */
+#if defined(__GNUC__)  &&  defined(__ARM_ARCH_7M__)
+#define COPY_BURST(d, s)						\
+	__asm volatile ("ldmia %1!, {r2-r5}\n\tstmia %0!, {r2-r5}"	\
+			: "+r" (d), "+r" (s) : : "r2", "r3", "r4", "r5", "memory")
+#else
+#define COPY_BURST(d, s)						\
+	do { (d)[0] = (s)[0];  (d)[1] = (s)[1];				\
+	     (d)[2] = (s)[2];  (d)[3] = (s)[3];				\
+	     (d) += 4;  (s) += 4; } while (0)
+#endif
+
+    /*!@brief Below this size, byte access is faster than aligning. */
+#define MEM_WORD_MIN	8
+
+
+/***************************************************************************//**
+ *
+ * @brief	Copy Memory
+ *
+ * This routine copies @p cnt bytes.  The areas must not overlap.
+ *
+ ******************************************************************************/
+void	MemCopy (void *pDst, const void *pSrc, size_t cnt)
+{
+uint8_t	*d = pDst;
+const uint8_t *s = pSrc;
+MEM_WORD *dw;
+const MEM_WORD *sw;
+
+
+    if (cnt >= MEM_WORD_MIN)
+    {
+	/* Align the destination */
+	while ((uintptr_t)d & 3)
+	{
+	    *d++ = *s++;
+	    cnt--;
+	}
+
+	if (((uintptr_t)s & 3) == 0)
+	{
+	    /* Both aligned: 16 byte bursts, then single words */
+	    dw = (MEM_WORD *)d;
+	    sw = (const MEM_WORD *)s;
+	    for ( ;  cnt >= 16;  cnt -= 16)
+		COPY_BURST(dw, sw);
+	    for ( ;  cnt >= 4;  cnt -= 4)
+		*dw++ = *sw++;
+	    d = (uint8_t *)dw;
+	    s = (const uint8_t *)sw;
+	}
+#if MEM_UNALIGNED_ACCESS
+	else
+	{
+	    /* Unaligned source: single word loads */
+	    dw = (MEM_WORD *)d;
+	    for ( ;  cnt >= 4;  cnt -= 4, s += 4)
+		*dw++ = MEM_LD32(s);
+	    d = (uint8_t *)dw;
+	}
+#endif
+    }
+
+    while (cnt--)
+	*d++ = *s++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Fill Memory
+ *
+ * This routine sets @p cnt bytes to the lower 8 bits of @p val.
+ *
+ ******************************************************************************/
+void	MemFill (void *pDst, int val, size_t cnt)
+{
+uint8_t	*d = pDst;
+MEM_WORD *dw, w;
+
+
+    if (cnt >= MEM_WORD_MIN)
+    {
+	/* Align the destination */
+	while ((uintptr_t)d & 3)
+	{
+	    *d++ = (uint8_t)val;
+	    cnt--;
+	}
+
+	w  = (uint8_t)val;
+	w |= w << 8;
+	w |= w << 16;
+	dw = (MEM_WORD *)d;
+	for ( ;  cnt >= 16;  cnt -= 16, dw += 4)
+	{
+	    dw[0] = w;  dw[1] = w;  dw[2] = w;  dw[3] = w;	// STM burst
+	}
+	for ( ;  cnt >= 4;  cnt -= 4)
+	    *dw++ = w;
+	d = (uint8_t *)dw;
+    }
+
+    while (cnt--)
+	*d++ = (uint8_t)val;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Compare Memory
+ *
+ * This routine compares @p cnt bytes.  Equal words are skipped, the first
+ * different byte determines the result.
+ *
+ * @return
+ *	0 if both areas are equal, otherwise the difference of the first
+ *	different bytes, like memcmp().
+ *
+ ******************************************************************************/
+int	MemCompare (const void *pBuf1, const void *pBuf2, size_t cnt)
+{
+const uint8_t *a = pBuf1, *b = pBuf2;
+int	r = 0;
+
+
+#if MEM_UNALIGNED_ACCESS
+    while (cnt >= 4  &&  MEM_LD32(a) == MEM_LD32(b))
+    {
+	a += 4;
+	b += 4;
+	cnt -= 4;
+    }
+#else
+    if ((((uintptr_t)a | (uintptr_t)b) & 3) == 0)
+    {
+	while (cnt >= 4  &&  *(const MEM_WORD *)a == *(const MEM_WORD *)b)
+	{
+	    a += 4;
+	    b += 4;
+	    cnt -= 4;
+	}
+    }
+#endif
+
+    while (cnt--  &&  (r = *a++ - *b++) == 0)
+	;
+
+    return r;
+}
+
+
+#if MEM_UTIL_BENCH
+/***************************************************************************//**
+ *
+ * @brief	Benchmark the Memory Functions
+ *
+ * This routine measures the cycles for typical FatFs operations, once with
+ * byte access, as done by FatFs with _WORD_ACCESS 0, and once with the
+ * functions and macros of this module:
+ * - <b>sector copy</b>: 512 bytes from an aligned and an unaligned source,
+ *   as in f_read() and f_write() for partial sectors.
+ * - <b>directory scan</b>: 16 entries of a directory sector, compare the
+ *   name and read the start cluster and the file size, like dir_find().
+ * - <b>FAT walk</b>: read all 128 entries of a FAT32 sector, like get_fat().
+ *
+ ******************************************************************************/
+void	MemUtilBench (void)
+{
+static uint32_t	src[129], dst[128];	// 512 bytes, +4 for unaligned
+static const char name[12] = "BOX0999 TXT";
+volatile uint32_t sink = 0;
+const uint8_t *p, *q;
+uint32_t cyc[8], start, sum;
+int	i, j;
+
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (i = 0;  i < (int)(sizeof(src) / 4);  i++)
+	src[i] = (uint32_t)i * 0x01010101UL;
+
+    /* Sector copy, aligned and unaligned source */
+    start = DWT->CYCCNT;
+    p = (const uint8_t *)src;
+    for (i = 0;  i < 512;  i++)
+	((uint8_t *)dst)[i] = p[i];
+    cyc[0] = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    MemCopy (dst, src, 512);
+    cyc[1] = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    p = (const uint8_t *)src + 1;
+    for (i = 0;  i < 512;  i++)
+	((uint8_t *)dst)[i] = p[i];
+    cyc[2] = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    MemCopy (dst, (const uint8_t *)src + 1, 512);
+    cyc[3] = DWT->CYCCNT - start;
+
+    /* Directory scan: name (no match), cluster, size */
+    start = DWT->CYCCNT;
+    for (sum = 0, p = (const uint8_t *)src;  p < (const uint8_t *)src + 512;
+	 p += 32)
+    {
+	for (j = 0, q = (const uint8_t *)name;  j < 11  &&  p[j] == q[j];  j++)
+	    ;
+	sum += (j == 11);
+	sum += (uint32_t)p[26] | (uint32_t)p[27] << 8
+	     | (uint32_t)p[20] << 16 | (uint32_t)p[21] << 24;
+	sum += (uint32_t)p[28] | (uint32_t)p[29] << 8
+	     | (uint32_t)p[30] << 16 | (uint32_t)p[31] << 24;
+    }
+    sink = sum;
+    cyc[4] = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    for (sum = 0, p = (const uint8_t *)src;  p < (const uint8_t *)src + 512;
+	 p += 32)
+    {
+	sum += (MemCompare (p, name, 11) == 0);
+	sum += MEM_LD16(p + 26) | (uint32_t)MEM_LD16(p + 20) << 16;
+	sum += MEM_LD32(p + 28);
+    }
+    sink = sum;
+    cyc[5] = DWT->CYCCNT - start;
+
+    /* FAT walk: 128 FAT32 entries */
+    start = DWT->CYCCNT;
+    for (sum = 0, p = (const uint8_t *)src;  p < (const uint8_t *)src + 512;
+	 p += 4)
+	sum += ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16
+		| (uint32_t)p[3] << 24) & 0x0FFFFFFF;
+    sink = sum;
+    cyc[6] = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    for (sum = 0, p = (const uint8_t *)src;  p < (const uint8_t *)src + 512;
+	 p += 4)
+	sum += MEM_LD32(p) & 0x0FFFFFFF;
+    sink = sum;
+    cyc[7] = DWT->CYCCNT - start;
+
+    (void) sink;
+    Log ("MemUtil Bench [cycles byte/word]: sector copy %ld/%ld,"
+	 " unaligned %ld/%ld, dir scan %ld/%ld, FAT walk %ld/%ld",
+	 cyc[0], cyc[1], cyc[2], cyc[3], cyc[4], cyc[5], cyc[6], cyc[7]);
+}
+#endif
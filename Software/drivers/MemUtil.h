@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module MemUtil.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * Besides the memory functions of MemUtil.c, this header provides macros to
+ * read and write little-endian 16 and 32 bit fields at any address, e.g.
+ * in directory entries or FAT sectors.  With GCC they compile to a single
+ * LDRH/LDR/STRH/STR on CPUs with unaligned access (Cortex-M3, x86), and to
+ * byte accesses on all other CPUs.  This header must not include config.h,
+ * because it is also used by the host tools.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_MemUtil_h
+#define __INC_MemUtil_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief   CPU supports word access at unaligned addresses.
+     * @details This is true for the Cortex-M3 (as long as UNALIGN_TRP in the
+     * SCB->CCR register is not set), and for x86 hosts.  LDM/STM and LDRD/
+     * STRD always require aligned addresses, MemCopy() takes care of this.
+     */
+#ifndef MEM_UNALIGNED_ACCESS
+    #if defined(__ARM_FEATURE_UNALIGNED) || defined(__ARM_ARCH_7M__) \
+     || defined(__i386__) || defined(__x86_64__)
+	#define MEM_UNALIGNED_ACCESS	1
+    #else
+	#define MEM_UNALIGNED_ACCESS	0
+    #endif
+#endif
+
+    /*!@brief Set 1 to log the cycle counts of the memory primitives in
+     * comparison to byte access at start-up, see MemUtilBench().
+     */
+#ifndef MEM_UTIL_BENCH
+    #define MEM_UTIL_BENCH	0
+#endif
+
+    /* Field access, little-endian, at any address */
+#if defined(__GNUC__)  &&  defined(__BYTE_ORDER__) \
+ &&  __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+typedef struct { uint16_t Val; } __attribute__((packed, may_alias)) MEM_U16;
+typedef struct { uint32_t Val; } __attribute__((packed, may_alias)) MEM_U32;
+
+#define MEM_LD16(ptr)	(((const MEM_U16 *)(const void *)(ptr))->Val)
+#define MEM_LD32(ptr)	(((const MEM_U32 *)(const void *)(ptr))->Val)
+#define MEM_ST16(ptr,val) (((MEM_U16 *)(void *)(ptr))->Val = (uint16_t)(val))
+#define MEM_ST32(ptr,val) (((MEM_U32 *)(void *)(ptr))->Val = (uint32_t)(val))
+#else
+#define MEM_LD16(ptr)	((uint16_t)(((const uint8_t *)(ptr))[0]		\
+				 | ((const uint8_t *)(ptr))[1] << 8))
+#define MEM_LD32(ptr)	((uint32_t)(((const uint8_t *)(ptr))[0]		\
+		   | (uint32_t)((const uint8_t *)(ptr))[1] << 8			\
+		   | (uint32_t)((const uint8_t *)(ptr))[2] << 16		\
+		   | (uint32_t)((const uint8_t *)(ptr))[3] << 24))
+#define MEM_ST16(ptr,val) do { uint8_t *p_ = (uint8_t *)(ptr);		\
+		uint16_t v_ = (uint16_t)(val);					\
+		p_[0] = (uint8_t)v_;  p_[1] = (uint8_t)(v_ >> 8); } while (0)
+#define MEM_ST32(ptr,val) do { uint8_t *p_ = (uint8_t *)(ptr);		\
+		uint32_t v_ = (uint32_t)(val);					\
+		p_[0] = (uint8_t)v_;  p_[1] = (uint8_t)(v_ >> 8);		\
+		p_[2] = (uint8_t)(v_ >> 16);  p_[3] = (uint8_t)(v_ >> 24); } while (0)
+#endif
+
+/*================================ Prototypes ================================*/
+
+    /* Memory functions with word access */
+void	MemCopy (void *pDst, const void *pSrc, size_t cnt);
+void	MemFill (void *pDst, int val, size_t cnt);
+int	MemCompare (const void *pBuf1, const void *pBuf2, size_t cnt);
+
+#if MEM_UTIL_BENCH
+    /* Log the cycle counts in comparison to byte access */
+void	MemUtilBench (void);
+#endif
+
+
+#endif /* __INC_MemUtil_h */
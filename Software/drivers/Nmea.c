@@ -0,0 +1,489 @@
+/***************************************************************************//**
+ * @file
+ * @brief	NMEA 0183 Time Sentence Parser
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module decodes the time and date of a GNSS receiver from its NMEA
+ * sentences, one character at a time, so it can be called directly from the
+ * UART interrupt service routine.  The parser is a small state machine:
+ * - <b>IDLE</b>: wait for '$', the start of a sentence.
+ * - <b>DATA</b>: collect the fields, separated by ',', and build the XOR
+ *   checksum.  Field 0 is the address, e.g. "GPRMC" or "GNZDA".  Sentences
+ *   other than RMC and ZDA are skipped right there.
+ * - <b>SUM1</b>, <b>SUM2</b>: compare the two hex digits after '*' with
+ *   the checksum.
+ *
+ * Only two sentences are decoded:
+ * @code
+ * $GPRMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,ddmmyy,x.x,a*hh
+ * $GPZDA,hhmmss.ss,dd,mm,yyyy,xx,xx*hh
+ * @endcode
+ * An RMC sentence is valid if its status field is 'A'.  A ZDA sentence has
+ * no status field, it is only accepted while the last RMC status was 'A',
+ * because receivers output the time of their backup RTC before the first
+ * fix.  The time always refers to the PPS pulse <b>before</b> the sentence.
+ *
+ * NMEA time is UTC.  NmeaLocalTime() converts it to MEZ or MESZ by the EU rule
+ * (last Sunday of March and October, 01:00 UTC).  All calculations are done in
+ * seconds since 2000-01-01 without the C library, so the code works on the
+ * host, too.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <string.h>
+#include "Nmea.h"
+
+/*=============================== Definitions ================================*/
+
+    /* Parser states */
+#define ST_IDLE		0	//!< Wait for '$'
+#define ST_DATA		1	//!< Collect fields
+#define ST_SUM1		2	//!< First hex digit of the checksum
+#define ST_SUM2		3	//!< Second hex digit of the checksum
+
+    /* Bits of NMEA_PARSER.Have */
+#define HAVE_TIME	0x01	//!< Time field decoded
+#define HAVE_DATE	0x02	//!< Date field(s) decoded
+#define HAVE_FIX	0x04	//!< Status field is 'A'
+#define HAVE_DAY	0x08	//!< ZDA day field decoded
+#define HAVE_MON	0x10	//!< ZDA month field decoded
+
+    /*!@brief Seconds per day. */
+#define SECS_PER_DAY	86400UL
+
+    /*!@brief Days of a leap year and the three following years. */
+#define DAYS_PER_4Y	(4 * 365 + 1)
+
+/*================================ Local Data ================================*/
+
+    /* Days in front of each month in a common year */
+static const uint16_t l_DaysBefore[12] =
+{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	fieldDone (NMEA_PARSER *pNmea);
+static int	decNum (const char *pStr, int len);
+static int	hexDigit (int ch);
+static uint32_t	dayNumber (int year, int mon, int day);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Initialize the Parser
+ *
+ * This routine resets the parser and its counters.  The first sentence
+ * will start with the next '$'.
+ *
+ ******************************************************************************/
+void	NmeaInit (NMEA_PARSER *pNmea)
+{
+    memset (pNmea, 0, sizeof(*pNmea));
+    pNmea->State = ST_IDLE;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Parse one Character
+ *
+ * This routine feeds one received character into the state machine.
+ *
+ * @return
+ *	@ref NMEA_RMC or @ref NMEA_ZDA when a valid sentence is complete, i.e.
+ *	the checksum matches and the time and date are within range.  The
+ *	time is then available in <b>pNmea</b>, see NmeaSeconds().  In all
+ *	other cases @ref NMEA_NONE is returned.
+ *
+ ******************************************************************************/
+NMEA_TYPE NmeaParse (NMEA_PARSER *pNmea, int ch)
+{
+int	sum;
+
+
+    /* A '$' always starts a new sentence */
+    if (ch == '$')
+    {
+	if (pNmea->State != ST_IDLE)
+	    pNmea->Errors++;		// previous sentence was truncated
+	pNmea->State = ST_DATA;
+	pNmea->Field = 0;
+	pNmea->Len   = 0;
+	pNmea->Cnt   = 1;
+	pNmea->Sum   = 0;
+	pNmea->Have  = 0;
+	pNmea->Type  = NMEA_NONE;
+	return NMEA_NONE;
+    }
+
+    if (pNmea->State == ST_IDLE)
+	return NMEA_NONE;
+
+    /* Sentences are printable ASCII and limited in length */
+    if (ch < ' '  ||  ch > '~'  ||  ++pNmea->Cnt > NMEA_SENTENCE_SIZE)
+    {
+	pNmea->Errors++;
+	pNmea->State = ST_IDLE;
+	return NMEA_NONE;
+    }
+
+    switch (pNmea->State)
+    {
+	case ST_DATA:
+	    if (ch == ','  ||  ch == '*')
+	    {
+		pNmea->Buf[pNmea->Len] = '\0';
+		if (! fieldDone (pNmea))
+		{
+		    pNmea->State = ST_IDLE;	// not of interest, or invalid
+		    break;
+		}
+		pNmea->Field++;
+		pNmea->Len = 0;
+		if (ch == '*')
+		{
+		    pNmea->State = ST_SUM1;
+		    break;
+		}
+	    }
+	    else if (pNmea->Len < NMEA_FIELD_SIZE)
+	    {
+		pNmea->Buf[pNmea->Len++] = (char)ch;
+	    }
+	    else
+	    {
+		pNmea->Errors++;		// field too long
+		pNmea->State = ST_IDLE;
+		break;
+	    }
+	    pNmea->Sum ^= (uint8_t)ch;
+	    break;
+
+	case ST_SUM1:
+	    sum = hexDigit (ch);
+	    if (sum < 0  ||  sum != (pNmea->Sum >> 4))
+	    {
+		pNmea->Errors++;
+		pNmea->State = ST_IDLE;
+		break;
+	    }
+	    pNmea->State = ST_SUM2;
+	    break;
+
+	case ST_SUM2:
+	    pNmea->State = ST_IDLE;
+	    sum = hexDigit (ch);
+	    if (sum < 0  ||  sum != (pNmea->Sum & 0x0F))
+	    {
+		pNmea->Errors++;
+		break;
+	    }
+
+	    /* Valid sentence, see if it carries a valid time */
+	    if (pNmea->Type == NMEA_RMC)
+	    {
+		pNmea->flgFix = (pNmea->Have & HAVE_FIX) != 0;
+		if (pNmea->Have == (HAVE_TIME | HAVE_DATE | HAVE_FIX))
+		{
+		    pNmea->Sentences++;
+		    return NMEA_RMC;
+		}
+	    }
+	    else if (pNmea->Type == NMEA_ZDA)
+	    {
+		if ((pNmea->Have & (HAVE_TIME | HAVE_DATE))
+				== (HAVE_TIME | HAVE_DATE)  &&  pNmea->flgFix)
+		{
+		    pNmea->Sentences++;
+		    return NMEA_ZDA;
+		}
+	    }
+	    break;
+
+	default:
+	    pNmea->State = ST_IDLE;
+	    break;
+    }
+
+    return NMEA_NONE;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	UTC Time of the last Sentence
+ *
+ * @return
+ *	Seconds since 2000-01-01 00:00:00 UTC.
+ *
+ ******************************************************************************/
+uint32_t NmeaSeconds (const NMEA_PARSER *pNmea)
+{
+    return dayNumber (pNmea->Year, pNmea->Mon, pNmea->Day) * SECS_PER_DAY
+	   + pNmea->Hour * 3600UL + pNmea->Min * 60UL + pNmea->Sec;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check for Daylight Saving Time
+ *
+ * MESZ starts at 01:00 UTC on the last Sunday in March, and ends at 01:00 UTC
+ * on the last Sunday in October.
+ *
+ * @param[in] utc
+ *	Seconds since 2000-01-01 00:00:00 UTC.
+ *
+ * @return
+ *	<b>true</b> for MESZ, <b>false</b> for MEZ.
+ *
+ ******************************************************************************/
+bool	NmeaIsDST (uint32_t utc)
+{
+uint32_t days = utc / SECS_PER_DAY;
+int	 year = 2000 + (int)(days / DAYS_PER_4Y) * 4;
+uint32_t start, end;
+
+
+    /* Find the year, 2000 is a leap year and a Saturday (day 0) */
+    days %= DAYS_PER_4Y;
+    if (days >= 366)
+	year += 1 + (int)((days - 366) / 365);
+
+    start = dayNumber (year, 3, 31);
+    start = (start - (start + 6) % 7) * SECS_PER_DAY + 3600;
+    end   = dayNumber (year, 10, 31);
+    end   = (end - (end + 6) % 7) * SECS_PER_DAY + 3600;
+
+    return (start <= utc  &&  utc < end);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Convert UTC to local Time
+ *
+ * This routine converts UTC seconds to MEZ or MESZ, see NmeaIsDST().
+ *
+ * @param[in] utc
+ *	Seconds since 2000-01-01 00:00:00 UTC.
+ *
+ * @param[out] pTime
+ *	Local time.  Like the DCF77 decoder, element <b>tm_year</b> is the year
+ *	modulo 100, see @ref Y2K38_WORKAROUND.  <b>tm_isdst</b> is set to 1
+ *	for MESZ.
+ *
+ ******************************************************************************/
+void	NmeaLocalTime (uint32_t utc, struct tm *pTime)
+{
+uint32_t days, secs;
+int	 year, mon, leap;
+
+
+    memset (pTime, 0, sizeof(*pTime));
+    pTime->tm_isdst = NmeaIsDST (utc);
+    utc += (pTime->tm_isdst ? 7200 : 3600);
+
+    days = utc / SECS_PER_DAY;
+    secs = utc % SECS_PER_DAY;
+    pTime->tm_wday = (int)((days + 6) % 7);
+
+    /* Year within a 4 year period starting with a leap year */
+    year = 2000 + (int)(days / DAYS_PER_4Y) * 4;
+    days %= DAYS_PER_4Y;
+    if (days >= 366)
+    {
+	days -= 366;
+	year += 1 + (int)(days / 365);
+	days %= 365;
+    }
+    pTime->tm_yday = (int)days;
+    leap = (year % 4 == 0);
+
+    for (mon = 11;  days < l_DaysBefore[mon] + (uint32_t)(mon >= 2 && leap);
+	 mon--)
+	;
+    days -= l_DaysBefore[mon] + (uint32_t)(mon >= 2 && leap);
+
+    pTime->tm_year = year % 100;
+    pTime->tm_mon  = mon;
+    pTime->tm_mday = (int)days + 1;
+    pTime->tm_hour = (int)(secs / 3600);
+    pTime->tm_min  = (int)(secs / 60 % 60);
+    pTime->tm_sec  = (int)(secs % 60);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Field complete
+ *
+ * This routine is called for each field when the separator has been
+ * received.  It decodes the fields of interest.
+ *
+ * @return
+ *	<b>false</b> if the sentence is not of interest, or a field is
+ *	invalid, <b>true</b> otherwise.
+ *
+ ******************************************************************************/
+static bool	fieldDone (NMEA_PARSER *pNmea)
+{
+const char *pBuf = pNmea->Buf;
+int	len = pNmea->Len;
+int	val;
+bool	ok = true;
+
+
+    if (pNmea->Field == 0)
+    {
+	/* Address field: 2 character talker ID and the sentence formatter */
+	if (len == 5  &&  strcmp (pBuf + 2, "RMC") == 0)
+	    pNmea->Type = NMEA_RMC;
+	else if (len == 5  &&  strcmp (pBuf + 2, "ZDA") == 0)
+	    pNmea->Type = NMEA_ZDA;
+	else
+	    return false;		// skip the rest of this sentence
+    }
+    else if (pNmea->Field == 1)
+    {
+	/* Time of both sentences: hhmmss with optional fraction */
+	if (len > 0)
+	{
+	    pNmea->Hour = (int8_t)decNum (pBuf, 2);
+	    pNmea->Min  = (int8_t)decNum (pBuf + 2, 2);
+	    pNmea->Sec  = (int8_t)decNum (pBuf + 4, 2);
+
+	    /* Leap seconds (60) are rejected, too */
+	    ok = (len == 6  ||  (len > 6  &&  pBuf[6] == '.'))
+		 &&  pNmea->Hour <= 23  &&  pNmea->Min <= 59
+		 &&  pNmea->Sec <= 59;
+	    if (ok)
+		pNmea->Have |= HAVE_TIME;
+	}
+    }
+    else if (pNmea->Type == NMEA_RMC)
+    {
+	if (pNmea->Field == 2)
+	{
+	    /* Status: A=valid, V=invalid */
+	    if (len == 1  &&  pBuf[0] == 'A')
+		pNmea->Have |= HAVE_FIX;
+	}
+	else if (pNmea->Field == 9  &&  len > 0)
+	{
+	    /* Date: ddmmyy */
+	    pNmea->Day  = (int8_t)decNum (pBuf, 2);
+	    pNmea->Mon  = (int8_t)decNum (pBuf + 2, 2);
+	    val = decNum (pBuf + 4, 2);
+	    ok = len == 6  &&  pNmea->Day >= 1  &&  pNmea->Day <= 31
+		 &&  pNmea->Mon >= 1  &&  pNmea->Mon <= 12  &&  val <= 99;
+	    if (ok)
+	    {
+		pNmea->Year = (int16_t)(2000 + val);
+		pNmea->Have |= HAVE_DATE;
+	    }
+	}
+    }
+    else if (pNmea->Field <= 4  &&  len > 0)
+    {
+	/* ZDA: day, month, and 4 digit year in separate fields */
+	val = decNum (pBuf, len);
+	switch (pNmea->Field)
+	{
+	    case 2:
+		ok = (len == 2  &&  val >= 1  &&  val <= 31);
+		pNmea->Day = (int8_t)val;
+		pNmea->Have |= HAVE_DAY;
+		break;
+
+	    case 3:
+		ok = (len == 2  &&  val >= 1  &&  val <= 12);
+		pNmea->Mon = (int8_t)val;
+		pNmea->Have |= HAVE_MON;
+		break;
+
+	    default:	// 4
+		ok = (len == 4  &&  val >= 2000  &&  val <= 2099);
+		pNmea->Year = (int16_t)val;
+		if (pNmea->Have & HAVE_DAY  &&  pNmea->Have & HAVE_MON)
+		    pNmea->Have |= HAVE_DATE;
+		break;
+	}
+    }
+
+    if (! ok)
+	pNmea->Errors++;
+
+    return ok;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Decode a decimal Number
+ *
+ * @return
+ *	Value of the <b>len</b> digits at <b>pStr</b>, or a large value if a
+ *	character is not a digit, so range checks will fail.
+ *
+ ******************************************************************************/
+static int	decNum (const char *pStr, int len)
+{
+int	val = 0;
+
+
+    while (len-- > 0)
+    {
+	if (*pStr < '0'  ||  *pStr > '9')
+	    return 9999;
+	val = val * 10 + (*pStr++ - '0');
+    }
+    return val;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Decode a Hex Digit
+ *
+ * @return
+ *	Value 0..15, or -1 if the character is not a hex digit.
+ *
+ ******************************************************************************/
+static int	hexDigit (int ch)
+{
+    if (ch >= '0'  &&  ch <= '9')
+	return ch - '0';
+    if (ch >= 'A'  &&  ch <= 'F')
+	return ch - 'A' + 10;
+    if (ch >= 'a'  &&  ch <= 'f')
+	return ch - 'a' + 10;
+    return -1;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Day Number
+ *
+ * @return
+ *	Number of days since 2000-01-01, valid until 2099.
+ *
+ ******************************************************************************/
+static uint32_t	dayNumber (int year, int mon, int day)
+{
+uint32_t days;
+
+
+    year -= 2000;
+    days  = (uint32_t)year * 365 + (uint32_t)(year + 3) / 4;
+    days += l_DaysBefore[mon - 1] + (mon > 2  &&  year % 4 == 0) + day - 1;
+
+    return days;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module Nmea.c
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This header must not include config.h, because it is also used by the
+ * host tool NmeaGen.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_Nmea_h
+#define __INC_Nmea_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Maximum length of a field, longer fields are invalid. */
+#define NMEA_FIELD_SIZE		11
+
+    /*!@brief Maximum length of a sentence, including '$' and checksum. */
+#define NMEA_SENTENCE_SIZE	82
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Sentence types returned by NmeaParse(). */
+typedef enum
+{
+    NMEA_NONE,		//!< No complete sentence yet, or not of interest
+    NMEA_RMC,		//!< Recommended Minimum data with status A (valid)
+    NMEA_ZDA,		//!< Time and Date, while the last RMC status was A
+} NMEA_TYPE;
+
+    /*!@brief State of the parser, and the UTC time of the last sentence. */
+typedef struct
+{
+    uint8_t	State;		//!< Receive state, see Nmea.c
+    uint8_t	Field;		//!< Current field number, 0 is the address
+    uint8_t	Len;		//!< Length of the current field
+    uint8_t	Cnt;		//!< Number of characters of the sentence
+    uint8_t	Sum;		//!< XOR checksum of the sentence
+    uint8_t	Have;		//!< Bit mask of the decoded fields
+    NMEA_TYPE	Type;		//!< Sentence type from the address field
+    char	Buf[NMEA_FIELD_SIZE + 1];	//!< Current field
+    int8_t	Hour, Min, Sec;	//!< UTC time of the last sentence
+    int8_t	Day, Mon;	//!< UTC date of the last sentence, month 1..12
+    int16_t	Year;		//!< Year of the last sentence, 2000..2099
+    bool	flgFix;		//!< Status of the last RMC sentence was A
+    uint32_t	Sentences;	//!< Number of decoded RMC and ZDA sentences
+    uint32_t	Errors;		//!< Number of checksum and format errors
+} NMEA_PARSER;
+
+/*================================ Prototypes ================================*/
+
+    /* Reset the parser */
+void	  NmeaInit (NMEA_PARSER *pNmea);
+
+    /* Parse one received character */
+NMEA_TYPE NmeaParse (NMEA_PARSER *pNmea, int ch);
+
+    /* UTC time of the last sentence in seconds since 2000-01-01 */
+uint32_t  NmeaSeconds (const NMEA_PARSER *pNmea);
+
+    /* Conversion of UTC seconds to MEZ/MESZ */
+bool	  NmeaIsDST (uint32_t utc);
+void	  NmeaLocalTime (uint32_t utc, struct tm *pTime);
+
+
+#endif /* __INC_Nmea_h */
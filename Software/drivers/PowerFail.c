@@ -23,6 +23,11 @@ Revision History:
 #include "AlarmClock.h"		// import CheckAlarmTimes()
 #include "Logging.h"
 
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_POWERFAIL
+
 /*================================ Local Data ================================*/
 
     /*! Local pointer to list of power-fail handlers */
@@ -13,6 +13,8 @@
  * - Decoders to handle the received data for Short and Long Range readers
  * - When the "Absence Detection" is configured, disabling the RFID reader
  *   is deferred as long as a transponder is still present.
+ * - Read-quality statistics for each session, i.e. from power-on to
+ *   power-off of the reader, see @ref RFID_STATISTICS.
  *
  ****************************************************************************//*
  *
@@ -45,6 +47,18 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent - RFID_PowerReady() is called when the power output of the
+		  reader has been switched on by the power sequencer, the
+		  detection timeout and the session statistics start then.
+2026-10-19,agent - Bytes that are received while the FLASH is busy are captured
+		  by RFID_RxCapture() and decoded afterwards.
+2026-10-19,agent - A new transponder ID is time stamped when it has been
+		  decoded, and passed to ControlUpdateID() with this stamp.
+2026-10-19,agent - Keep read-quality statistics per RFID session (power-on to
+		  power-off) and log them at the end of the session, see
+		  RFID_STATISTICS.
+		- RFID_Decode: Discard a partial frame if the gap between two
+		  bytes exceeds RFID_FRAME_TIMEOUT.
 2020-06-03,rage	- BugFix: Corrected decoding of SR transponder ID.
 2019-02-10,rage	- BugFix: Absent detection didn't work if transponder ID has
 		  been read just once before disappearing again.
@@ -84,14 +98,24 @@ Revision History:
 #include "em_cmu.h"
 #include "em_gpio.h"
 #include "em_usart.h"
+#include "em_int.h"
 #include "AlarmClock.h"
 #include "DisplayMenu.h"
 #include "RFID.h"
 #include "Logging.h"
 #include "Control.h"
+#include "FlashProg.h"
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_RFID
+
+    /*!@brief Number of bytes that can be received while the FLASH is busy.
+     * A page erase takes about 20ms, i.e. 18 bytes at 9600 baud.
+     */
+#define RX_CAPTURE_SIZE	32
+
     // Module Debugging
 #define MOD_DEBUG	0	// set 1 to enable debugging of this module
 #if ! MOD_DEBUG
@@ -114,6 +138,29 @@ typedef struct
     uint32_t		const	UART_Route;	//!< Route location
 } USART_Parms;
 
+/*!@brief Read-quality statistics of one RFID session.
+ *
+ * The counters are updated by RFID_Decode() in interrupt context and logged
+ * by RFID_PowerOff() at the end of the session.  They allow to compare the
+ * detection time and error rates of different antenna placements and power
+ * settings.
+ */
+typedef struct
+{
+    bool	Active;		//!< Session is running
+    uint32_t	StartMs;	//!< Time of power-on in [ms] of the day
+    int32_t	FirstIdMs;	//!< Power-on to first valid ID in [ms], or -1
+    uint32_t	LastByteCnt;	//!< RTC counter value of the last byte
+    uint16_t	Bytes;		//!< Number of received bytes
+    uint16_t	Skipped;	//!< Bytes outside of a frame, e.g. leading 0
+    uint16_t	Frames;		//!< Complete frames, valid or not
+    uint16_t	IDs;		//!< Frames with valid checksum
+    uint16_t	ChkErr;		//!< Frames with XOR (SR) or CRC (LR) error
+    uint16_t	PrefixErr;	//!< Frames aborted due to a wrong prefix
+    uint16_t	Timeouts;	//!< Frames aborted by @ref RFID_FRAME_TIMEOUT
+    uint16_t	UartErr;	//!< Framing and parity errors
+} RFID_STAT;
+
 /*!@brief Structure to hold RFID reader type specific parameters. */
 typedef struct
 {
@@ -207,9 +254,21 @@ static volatile bool	l_flgNewRun;
     /*! Flag to notify a new transponder ID */
 static volatile bool	l_flgNewID;
 
+    /*! Time stamp of the new transponder ID */
+static volatile CLOCK_STAMP l_NewIDStamp;
+
+    /*! Bytes received while the FLASH was busy, see RFID_RxCapture() */
+static volatile uint8_t	l_RxCapture[RX_CAPTURE_SIZE];
+static volatile uint8_t	l_RxCaptureCnt;
+
     /*! State (index) variables for RFID_Decode. */
 static volatile uint8_t	l_State;
 
+#if RFID_STATISTICS
+    /*! Read-quality statistics of the current RFID session. */
+static volatile RFID_STAT l_Stat;
+#endif
+
 /*=========================== Forward Declarations ===========================*/
 
 static void TransponderAbsent(TIM_HDL hdl);
@@ -219,6 +278,12 @@ static void SwitchRFID_Off(TIM_HDL hdl);
 static void RFID_DetectTimeout(TIM_HDL hdl);
 #endif
 static void uartSetup(void);
+static void RFID_PowerReady(PWR_OUT output);
+static FLASH_RAMFUNC bool RFID_RxCapture(void);
+#if RFID_STATISTICS
+static uint32_t	getMsOfDay(void);
+static void	LogStatistics(void);
+#endif
 
 
 /***************************************************************************//**
@@ -247,6 +312,9 @@ void	RFID_Init (void)
     l_pRFID_Cfg.RFID_Type   = g_RFID_Type;
     l_pRFID_Cfg.RFID_PwrOut = g_RFID_Power;
 
+    /* Get notified when the power sequencer has switched the reader on */
+    PowerOutputFctInstall (RFID_PowerReady);
+
     /* RFID reader should be activated */
     l_flgRFID_Activate = true;
 
@@ -443,6 +511,8 @@ void RFID_TimedDisable (void)
  * @brief	Power RFID reader On
  *
  * This routine powers the RFID reader on and initializes the related hardware.
+ * The power output is switched on by the power sequencer after this routine
+ * returned, see RFID_PowerReady().
  *
  ******************************************************************************/
 void RFID_PowerOn (void)
@@ -457,6 +527,14 @@ void RFID_PowerOn (void)
 	/* Module RFID requires EM1, set bit in bit mask */
 	Bit(g_EM1_ModuleMask, EM1_MOD_RFID) = 1;
 
+#if RFID_STATISTICS
+	/* Start a new session */
+	memset ((void *)&l_Stat, 0, sizeof(l_Stat));
+	l_Stat.FirstIdMs = -1;
+	l_Stat.StartMs = getMsOfDay();
+	l_Stat.Active = true;
+#endif
+
 	/* Prepare UART to receive Transponder ID */
 	uartSetup();
 
@@ -469,6 +547,38 @@ void RFID_PowerOn (void)
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	RFID reader is powered
+ *
+ * This routine is called by the power sequencer when a power output has been
+ * switched on and its inrush current has settled, see PowerOutputFctInstall().
+ * For the power output of the RFID reader, the ID detection timeout and the
+ * statistics of the session are (re-)started now, because the reader could
+ * not read any transponder before.
+ *
+ * @param[in] output
+ *	Power output that has been switched on.
+ *
+ ******************************************************************************/
+static void RFID_PowerReady (PWR_OUT output)
+{
+    if (output != l_pRFID_Cfg.RFID_PwrOut  ||  ! l_flgRFID_IsOn)
+	return;		// not the RFID reader, or already off again
+
+#if RFID_STATISTICS
+    /* The read latency is measured from here */
+    l_Stat.StartMs = getMsOfDay();
+#endif
+
+#if RFID_TRIGGERED_BY_LIGHT_BARRIER	// only required for light barriers
+    /* Restart the timeout, the reader is able to detect an ID from now on */
+    if (l_flgObjectPresent  &&  l_hdlRFID_DetectTimeout != NONE)
+	sTimerStart (l_hdlRFID_DetectTimeout, g_RFID_DetectTimeout);
+#endif
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Power RFID reader Off
@@ -498,7 +608,79 @@ void RFID_PowerOff (void)
     /* Generate Log Message */
     Log ("RFID is powered off");
 #endif
+
+#if RFID_STATISTICS
+    /* End of session - log statistics */
+    if (l_Stat.Active)
+    {
+	l_Stat.Active = false;
+	LogStatistics();
+    }
+#endif
+}
+
+
+#if RFID_STATISTICS
+/***************************************************************************//**
+ *
+ * @brief	Log RFID Statistics
+ *
+ * This routine logs the read-quality statistics of the session that has
+ * just ended.  It is called by RFID_PowerOff().  Example:
+ *
+ * RFID Statistics: 12.5s, 95 frames, 91 IDs (7.2/s), first ID after 340ms
+ * RFID Errors: 3 XOR, 1 prefix, 0 timeout, 0 UART, 12 bytes skipped
+ *
+ * If no ID has been read, "no ID" is logged instead of the latency.
+ *
+ ******************************************************************************/
+static void	LogStatistics(void)
+{
+uint32_t durMs, rate;
+
+
+    /* Duration of the session, handle midnight */
+    durMs = getMsOfDay();
+    if (durMs < l_Stat.StartMs)
+	durMs += 24 * 3600 * 1000;
+    durMs -= l_Stat.StartMs;
+
+    /* Valid reads per second, one decimal place */
+    rate = (durMs > 0 ? (l_Stat.IDs * 10000UL) / durMs : 0);
+
+#ifdef LOGGING
+    if (l_Stat.FirstIdMs >= 0)
+	Log ("RFID Statistics: %ld.%lds, %d frames, %d IDs (%ld.%ld/s),"
+	     " first ID after %ldms", durMs / 1000, (durMs / 100) % 10,
+	     l_Stat.Frames, l_Stat.IDs, rate / 10, rate % 10, l_Stat.FirstIdMs);
+    else
+	Log ("RFID Statistics: %ld.%lds, %d frames, no ID",
+	     durMs / 1000, (durMs / 100) % 10, l_Stat.Frames);
+
+    Log ("RFID Errors: %d %s, %d prefix, %d timeout, %d UART,"
+	 " %d bytes skipped", l_Stat.ChkErr,
+	 l_pRFID_Cfg.RFID_Type == RFID_TYPE_SR ? "XOR" : "CRC",
+	 l_Stat.PrefixErr, l_Stat.Timeouts, l_Stat.UartErr, l_Stat.Skipped);
+#else
+    (void) rate;
+#endif
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get Time of Day in [ms]
+ *
+ ******************************************************************************/
+static uint32_t	getMsOfDay(void)
+{
+struct tm    time;
+unsigned int ms;
+
+    ClockGetMilliSec (&time, &ms);
+    return ((time.tm_hour * 60 + time.tm_min) * 60 + time.tm_sec) * 1000 + ms;
 }
+#endif	// RFID_STATISTICS
 
 
 /***************************************************************************//**
@@ -515,6 +697,8 @@ void RFID_PowerOff (void)
  ******************************************************************************/
 void	RFID_Check (void)
 {
+CLOCK_STAMP stamp;
+
     if (l_flgRFID_On)
     {
 	/* RFID reader should be powered ON */
@@ -548,10 +732,13 @@ void	RFID_Check (void)
 
     if (l_flgNewID)
     {
+	INT_Disable();
 	l_flgNewID = false;
+	stamp = l_NewIDStamp;
+	INT_Enable();
 
 	/* New transponder ID has been set - inform control module */
-	ControlUpdateID(g_Transponder);
+	ControlUpdateID(g_Transponder, &stamp);
 
 	/* Also update the LC-Display */
 	DisplayUpdate (UPD_TRANSPONDER);
@@ -659,6 +846,7 @@ static void RFID_DetectTimeout(TIM_HDL hdl)
 	Log ("Transponder: %s", g_Transponder);
 #endif
 	/* Set flag to notify new transponder ID */
+	ClockStamp ((CLOCK_STAMP *)&l_NewIDStamp);
 	l_flgNewID = true;
     }
 }
@@ -700,6 +888,9 @@ bool	 flgRecvdID = false;
 char	 newTransponder[50]; // also used to store data in case of error message
 int	 offs = 0;	// byte offset within the received transponder message
 int	 i, pos;
+#if RFID_STATISTICS
+uint32_t rtcCnt;	// RTC counter value when this byte has been received
+#endif
 
 
     /* count communication errors for debugging purposes */
@@ -709,6 +900,23 @@ int	 i, pos;
     if (byte & USART_RXDATAX_PERR)
 	g_PERR_Cnt++;
 
+#if RFID_STATISTICS
+    if (byte & (USART_RXDATAX_FERR | USART_RXDATAX_PERR))
+	l_Stat.UartErr++;
+
+    l_Stat.Bytes++;
+
+    /* discard a partial frame if the gap to the previous byte is too long */
+    rtcCnt = msDelayStart();
+    if (l_State != 0
+    &&  ((rtcCnt - l_Stat.LastByteCnt) & 0xFFFFFF) > MS2TICS(RFID_FRAME_TIMEOUT))
+    {
+	l_Stat.Timeouts++;
+	l_State = 0;		// restart state machine
+    }
+    l_Stat.LastByteCnt = rtcCnt;
+#endif
+
     /* store current byte into receive buffer */
     byte &= 0xFF;		// only bit 7~0 contains the data
     DBG_PUTC('[');DBG_PUTC(HexChar[(byte >> 4) & 0xF]);
@@ -734,6 +942,12 @@ int	 i, pos;
 		// Verify prefix
 		if (byte != v[l_State])
 		{
+#if RFID_STATISTICS
+		    if (l_State > 0)
+			l_Stat.PrefixErr++;
+		    else
+			l_Stat.Skipped++;
+#endif
 		    l_State = 0;	// restart state machine
 		    break;		// break!
 		}
@@ -751,8 +965,14 @@ int	 i, pos;
 		break;			// break!
 
 	    case 13:
+#if RFID_STATISTICS
+		l_Stat.Frames++;
+#endif
 		if (w[13] != xorsum)	// handle ERROR case
 		{
+#if RFID_STATISTICS
+		    l_Stat.ChkErr++;
+#endif
 		    /* Print Hex Codes of the wrong message */
 		    pos = 0;
 		    for (i=0; i <= 13; i++)
@@ -784,6 +1004,9 @@ int	 i, pos;
 	    case 0:	// expect prefix 0x54 ('T')
 		if (byte != 0x54)
 		{		// (there may be leading zeros)
+#if RFID_STATISTICS
+		    l_Stat.Skipped++;
+#endif
 		    l_State = 0; // restart state machine
 		    break;		// break!
 		}
@@ -813,9 +1036,15 @@ int	 i, pos;
 		break;			// break!
 
 	    case 10:	// received complete frame
+#if RFID_STATISTICS
+		l_Stat.Frames++;
+#endif
 		val = (w[10] << 8) | w[9];
 		if (val != crc)		// handle ERROR case
 		{
+#if RFID_STATISTICS
+		    l_Stat.ChkErr++;
+#endif
 		    /* Print Hex Codes of the wrong message */
 		    pos = 0;
 		    for (i=0; i <= 10; i++)
@@ -851,6 +1080,18 @@ int	 i, pos;
     {
 	l_State = 0;		// restart state machine
 
+#if RFID_STATISTICS
+	/* count valid IDs, measure the time to the first one */
+	l_Stat.IDs++;
+	if (l_Stat.FirstIdMs < 0)
+	{
+	    l_Stat.FirstIdMs = getMsOfDay();
+	    if ((uint32_t)l_Stat.FirstIdMs < l_Stat.StartMs)
+		l_Stat.FirstIdMs += 24 * 3600 * 1000;
+	    l_Stat.FirstIdMs -= l_Stat.StartMs;
+	}
+#endif
+
 	for (i=0; i < 8; i++)	// copy w and convert to ASCII HEX
 	{
 	    newTransponder[2*i]	  = HexChar[(w[offs-i]>>4) & 0x0F];
@@ -877,6 +1118,7 @@ int	 i, pos;
 	    Log ("Transponder: %s", g_Transponder);
 #endif
 	    /* Set flag to notify new transponder ID */
+	    ClockStamp ((CLOCK_STAMP *)&l_NewIDStamp);
 	    l_flgNewID = true;
 	}
 
@@ -932,6 +1174,7 @@ int	type = l_pRFID_Cfg.RFID_Type;
   USART_IntClear(l_USART_Parms.UART, _USART_IF_MASK);
   USART_IntEnable(l_USART_Parms.UART, USART_IF_RXDATAV);
   NVIC_SetPriority(l_USART_Parms.UART_Rx_IRQn, INT_PRIO_UART);
+  FlashProgCapture(l_USART_Parms.UART_Rx_IRQn, RFID_RxCapture);
   NVIC_ClearPendingIRQ(l_USART_Parms.UART_Rx_IRQn);
   NVIC_EnableIRQ(l_USART_Parms.UART_Rx_IRQn);
 
@@ -949,7 +1192,8 @@ int	type = l_pRFID_Cfg.RFID_Type;
  *
  * This interrupt service routine is called whenever a byte has been received
  * from the RFID reader associated with UART 1.  It calls RFID_Decode() to
- * extract a valid ID from the data stream.
+ * extract a valid ID from the data stream.  Bytes that have been captured
+ * while the FLASH was busy are decoded first.
  *
  * NOTE:
  * Since both UARTs use the same interrupt priority, no interference is
@@ -958,8 +1202,15 @@ int	type = l_pRFID_Cfg.RFID_Type;
  *****************************************************************************/
 void USART1_RX_IRQHandler(void)
 {
+int	i;
+
     DEBUG_TRACE(0x07);
 
+    /* Decode the bytes that have been captured during FLASH programming */
+    for (i = 0;  i < l_RxCaptureCnt;  i++)
+	RFID_Decode (l_RxCapture[i]);
+    l_RxCaptureCnt = 0;
+
     /* Check for RX data valid interrupt */
     if (USART1->STATUS & USART_STATUS_RXDATAV)
     {
@@ -972,3 +1223,30 @@ void USART1_RX_IRQHandler(void)
 
     DEBUG_TRACE(0x87);
 }
+
+
+/**************************************************************************//**
+ *
+ * @brief Capture a received Byte while the FLASH is busy
+ *
+ * This routine is executed from RAM instead of USART1_RX_IRQHandler() during
+ * FLASH programming, see FlashProgCapture().  It saves the received byte in
+ * @ref l_RxCapture.
+ *
+ * @return
+ *	<i>false</i> if the buffer is full.
+ *
+ *****************************************************************************/
+static FLASH_RAMFUNC bool RFID_RxCapture(void)
+{
+    if (USART1->STATUS & USART_STATUS_RXDATAV)
+    {
+	if (l_RxCaptureCnt >= RX_CAPTURE_SIZE)
+	    return false;
+
+	l_RxCapture[l_RxCaptureCnt++] = (uint8_t)USART1->RXDATA;
+	USART1->IFC = USART_IF_RXDATAV;
+    }
+
+    return true;
+}
@@ -5,6 +5,7 @@
  * @version	2018-03-26
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Added RFID_STATISTICS and RFID_FRAME_TIMEOUT.
 2018-03-26,rage - Defined switch RFID_DISPLAY_UPDATE_WHEN_ABSENT.
 		- RFID_TRIGGERED_BY_LIGHT_BARRIER lets you select whether the
 		  RFID reader is controlled by light-barriers or alarm times.
@@ -54,6 +55,20 @@ Revision History:
     #define DFLT_RFID_DETECT_TIMEOUT		10
 #endif
 
+    /*!@brief Flag, if read-quality statistics are logged at the end of each
+     * RFID session, i.e. when the reader is powered off.
+     */
+#ifndef RFID_STATISTICS
+    #define RFID_STATISTICS			1
+#endif
+
+    /*!@brief Maximum gap in [ms] between two bytes of a frame.  If it is
+     * exceeded, the partially received frame is discarded as timeout.
+     */
+#ifndef RFID_FRAME_TIMEOUT
+    #define RFID_FRAME_TIMEOUT			50
+#endif
+
 
     /*!@brief RFID types. */
 typedef enum
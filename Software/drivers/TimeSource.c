@@ -0,0 +1,319 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Time Sources to synchronize the System Clock
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module is the common part of all time sources, i.e. the DCF77 decoder
+ * and the GNSS receiver.  A source calls TimeSourceStart() when it has been
+ * switched on, TimeSourceSync() with the received time, and TimeSourceStop()
+ * when it has been switched off again.
+ *
+ * TimeSourceSync() sets the system clock.  When the time zone changes
+ * between MEZ and MESZ, all alarm times are shifted by one hour, so they
+ * still occur at the same local time.  The first synchronization after a
+ * source has been switched on ends its search: the time to sync is recorded,
+ * and all other sources which are still searching are switched off, because
+ * the clock is up to date now.  This only applies to sources that are woken
+ * up once per day, a DCF77 decoder with @ref DCF77_ONCE_PER_DAY set to 0
+ * keeps on receiving.  Sources check TimeSourceSyncAge() to skip a daily
+ * synchronization that has already been done by another source.
+ *
+ * For every source, the on-time, the number of synchronizations, and the time
+ * to sync are counted.  TimeSourceStatistics() logs them together with the
+ * energy per sync, which is estimated from the on-time and the supply current
+ * of the receiver, see @ref DCF77_SUPPLY_CURRENT and @ref GNSS_SUPPLY_CURRENT.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version, the time zone handling has been moved here
+		from DCF77.c.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <string.h>
+#include "em_device.h"
+#include "TimeSource.h"
+#include "AlarmClock.h"
+#include "DCF77.h"
+#include "GNSS.h"
+#include "Logging.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_ALARM
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Properties of a time source. */
+typedef struct
+{
+    const char	*Name;		//!< Name for the log messages
+    uint32_t	 Current;	//!< Supply current in [uA] while switched on
+    void	(*Disable)(void); //!< Function to switch a searching source
+				  //!< off, NULL if it is not switched on again
+} TIME_SRC_DEF;
+
+    /*!@brief State and statistics of a time source. */
+typedef struct
+{
+    bool	flgActive;	//!< Source is switched on
+    bool	flgSearch;	//!< No synchronization since switched on
+    time_t	OnSince;	//!< Time when switched on
+    uint32_t	Starts;		//!< Number of times switched on
+    uint32_t	Syncs;		//!< Number of first synchronizations
+    uint32_t	OnTime;		//!< Total on-time in [s]
+    uint32_t	SyncTime;	//!< Sum of the times to sync in [s]
+    uint32_t	SyncTimeMax;	//!< Maximum time to sync in [s]
+} TIME_SRC_STAT;
+
+/*================================ Local Data ================================*/
+
+    /*!@brief Properties of the time sources, see @ref TIME_SRC. */
+static const TIME_SRC_DEF l_TimeSrc[END_TIME_SRC] =
+{
+#if DCF77_ONCE_PER_DAY
+    {	"DCF77",	DCF77_SUPPLY_CURRENT,	DCF77Disable	},
+#else
+    {	"DCF77",	DCF77_SUPPLY_CURRENT,	NULL		},
+#endif
+#if GNSS_TIME_SOURCE
+    {	"GNSS",		GNSS_SUPPLY_CURRENT,	GNSSDisable	},
+#else
+    {	"GNSS",		0,			NULL		},
+#endif
+};
+
+    /*!@brief State and statistics of the time sources. */
+static TIME_SRC_STAT	l_Stat[END_TIME_SRC];
+
+    /*!@brief Time of the last synchronization, see @ref l_flgSynced. */
+static time_t		l_LastSync;
+static bool		l_flgSynced;
+
+
+/***************************************************************************//**
+ *
+ * @brief	Time Source switched on
+ *
+ * This routine must be called by a time source when it has been switched on.
+ *
+ * @param[in] src
+ *	Time source, see @ref TIME_SRC.
+ *
+ ******************************************************************************/
+void	TimeSourceStart (TIME_SRC src)
+{
+TIME_SRC_STAT *pStat = &l_Stat[src];
+
+
+    if (pStat->flgActive)
+	return;			// already on
+
+    pStat->flgActive = true;
+    pStat->flgSearch = true;
+    pStat->OnSince = time(NULL);
+    pStat->Starts++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Time Source switched off
+ *
+ * This routine must be called by a time source when it has been switched off.
+ * It adds the on-time to the statistics.
+ *
+ * @param[in] src
+ *	Time source, see @ref TIME_SRC.
+ *
+ ******************************************************************************/
+void	TimeSourceStop (TIME_SRC src)
+{
+TIME_SRC_STAT *pStat = &l_Stat[src];
+
+
+    if (! pStat->flgActive)
+	return;			// already off
+
+    pStat->OnTime += (uint32_t)(time(NULL) - pStat->OnSince);
+    pStat->flgActive = false;
+    pStat->flgSearch = false;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Time Synchronization
+ *
+ * This function is called by a time source when it has received a valid
+ * time.  It sets the system clock via ClockSet() and updates the display
+ * with the new time.
+ * It also checks for a change of MEZ to MESZ and vice versa.  If this happens,
+ * all configured alarm times will be adjusted accordingly.
+ *
+ * @note
+ * Be aware, this function is called in interrupt context!
+ *
+ * @param[in] src
+ *	Time source, see @ref TIME_SRC.
+ *
+ * @param[in] pTime
+ *	Pointer to a <b>tm</b> structure that holds the current time.  Element
+ *	<b>tm_isdst</b> must be 1 for MESZ.
+ *
+ ******************************************************************************/
+void	TimeSourceSync (TIME_SRC src, struct tm *pTime)
+{
+TIME_SRC_STAT *pStat = &l_Stat[src];
+bool	 flgFirst = pStat->flgSearch;
+uint32_t syncTime = 0;
+time_t	 before, offset;
+int	 i;
+
+
+    /* flag to detect whether MEZ<=>MESZ change occurred */
+    bool changeOccurred = (g_isdst != (bool)pTime->tm_isdst);
+
+    /* time to sync, measured with the old clock */
+    before = time(NULL);
+    if (flgFirst)
+    {
+	syncTime = (uint32_t)(before - pStat->OnSince);
+	pStat->flgSearch = false;
+	pStat->Syncs++;
+	pStat->SyncTime += syncTime;
+	if (pStat->SyncTimeMax < syncTime)
+	    pStat->SyncTimeMax = syncTime;
+    }
+
+    /* set system clock to the new time in "tm" format */
+    g_CurrDateTime = *pTime;
+    g_isdst = pTime->tm_isdst;		// flag for daylight saving time
+
+    /*
+     * A time source may be activated once per day only.  When a change
+     * between MEZ and MESZ is detected, all alarm times must be corrected
+     * to still occur at the same effective time.  This includes the
+     * ALARM_DCF77_WAKE_UP, which is switched between 01:55 (MEZ) and
+     * 02:55 (MESZ) properly.
+     */
+    if (changeOccurred)
+    {
+    int	    alarm;
+    int8_t  hour, minute;
+
+	if (g_isdst)
+	    Log ("%s: Changing time zone from MEZ to MESZ", l_TimeSrc[src].Name);
+	else
+	    Log ("%s: Changing time zone from MESZ to MEZ", l_TimeSrc[src].Name);
+
+	/* MEZ <-> MESZ change detected */
+	for (alarm = 0;  alarm < MAX_ALARMS;  alarm++)
+	{
+	    AlarmGet (alarm, &hour, &minute);
+
+	    hour += (g_isdst ? +1 : -1);
+	    if (hour < 0)
+		hour = 23;
+	    else if (hour > 23)
+		hour = 0;
+
+	    AlarmSet (alarm, hour, minute);
+	}
+    }
+
+    /* Set System Clock also in UNIX time and check initially alarm times */
+    ClockSet (&g_CurrDateTime, true);	// set milliseconds of RTC to zero
+
+    /* the clock has jumped, keep the on-times of active sources correct */
+    l_LastSync = time(NULL);
+    l_flgSynced = true;
+    offset = l_LastSync - before;
+    for (i = 0;  i < END_TIME_SRC;  i++)
+	if (l_Stat[i].flgActive)
+	    l_Stat[i].OnSince += offset;
+
+    if (flgFirst)
+    {
+#ifdef LOGGING
+	/* log new time and the time to sync */
+	Log ("%s: Time Synchronization %02d:%02d:%02d (%s) after %lds",
+	     l_TimeSrc[src].Name, pTime->tm_hour, pTime->tm_min, pTime->tm_sec,
+	     g_isdst ? "MESZ" : "MEZ", syncTime);
+#endif
+	/* the clock is up to date, stop sources that are still searching,
+	 * unless they would not be woken up again */
+	for (i = 0;  i < END_TIME_SRC;  i++)
+	{
+	    if (i != (int)src  &&  l_Stat[i].flgSearch
+	    &&  l_TimeSrc[i].Disable != NULL)
+		l_TimeSrc[i].Disable();
+	}
+    }
+
+    /* Show time on display (if applicable) */
+    ClockUpdate (false);	// g_CurrDateTime is already up to date
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Age of the last Synchronization
+ *
+ * @return
+ *	Seconds since the last synchronization by any time source, or -1 if
+ *	the clock has not been synchronized yet.
+ *
+ ******************************************************************************/
+long	TimeSourceSyncAge (void)
+{
+    if (! l_flgSynced)
+	return -1;
+
+    return (long)(time(NULL) - l_LastSync);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log the Statistics
+ *
+ * This routine logs for every time source that has been used: the number of
+ * starts and synchronizations, the average and maximum time to sync, the
+ * total on-time, and the estimated energy per synchronization in [mAs].
+ *
+ ******************************************************************************/
+void	TimeSourceStatistics (void)
+{
+TIME_SRC_STAT *pStat;
+uint32_t onTime, avg, energy;
+int	 i;
+
+
+    for (i = 0;  i < END_TIME_SRC;  i++)
+    {
+	pStat = &l_Stat[i];
+	if (pStat->Starts == 0)
+	    continue;
+
+	onTime = pStat->OnTime;
+	if (pStat->flgActive)
+	    onTime += (uint32_t)(time(NULL) - pStat->OnSince);
+
+	avg = energy = 0;
+	if (pStat->Syncs > 0)
+	{
+	    avg = pStat->SyncTime / pStat->Syncs;
+	    energy = (uint32_t)((uint64_t)onTime * l_TimeSrc[i].Current
+				/ 1000 / pStat->Syncs);
+	}
+
+	Log ("Time Source %s: %ld starts, %ld syncs, sync after %lds avg"
+	     " %lds max, on %lds, %ldmAs/sync", l_TimeSrc[i].Name,
+	     pStat->Starts, pStat->Syncs, avg, pStat->SyncTimeMax, onTime,
+	     energy);
+    }
+}
@@ -0,0 +1,46 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module TimeSource.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_TimeSource_h
+#define __INC_TimeSource_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdbool.h>
+#include <time.h>
+#include "config.h"		// include project configuration parameters
+
+/*=========================== Typedefs and Structs ===========================*/
+
+    /*!@brief Sources to synchronize the system clock. */
+typedef enum
+{
+    TIME_SRC_DCF77,	//!< DCF77 Atomic Clock Decoder, see DCF77.c
+    TIME_SRC_GNSS,	//!< GNSS receiver, see GNSS.c
+    END_TIME_SRC
+} TIME_SRC;
+
+/*================================ Prototypes ================================*/
+
+    /* A time source has been switched on or off */
+void	TimeSourceStart (TIME_SRC src);
+void	TimeSourceStop  (TIME_SRC src);
+
+    /* Set the system clock, called from interrupt context */
+void	TimeSourceSync  (TIME_SRC src, struct tm *pTime);
+
+    /* Seconds since the last synchronization by any source */
+long	TimeSourceSyncAge (void);
+
+    /* Log time to sync and energy per sync of all sources */
+void	TimeSourceStatistics (void);
+
+
+#endif /* __INC_TimeSource_h */
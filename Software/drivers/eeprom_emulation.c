@@ -3,6 +3,11 @@
  * @brief EEPROM Emulation Demo Application functions
  * @author Energy Micro AS
  * @version 1.08
+ *
+ * @note
+ *   Altered for the TAMDL firmware: the FLASH is written and erased via
+ *   FlashProgWrite() and FlashProgErase(), which keep the time critical
+ *   interrupts enabled while the FLASH is busy.
  ******************************************************************************
  * @section License
  * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
@@ -34,6 +39,7 @@
  *****************************************************************************/
 #include <stdlib.h>
 #include "em_msc.h"
+#include "FlashProg.h"
 #include "em_assert.h"
 #include "eeprom_emulation.h"
 
@@ -127,7 +133,7 @@ static bool EE_WriteToPage(EE_Page_TypeDef *page, uint16_t virtualAddress, uint1
       virtualAddressAndData = ((uint32_t)(virtualAddress << 16) & 0xFFFF0000) | (uint32_t)(writeData);
 
       /* Make sure that the write to flash is a success. */
-      if (MSC_WriteWord(address, &virtualAddressAndData, SIZE_OF_VARIABLE) != mscReturnOk)
+      if (FlashProgWrite(address, virtualAddressAndData) != mscReturnOk)
       {
         /* Write failed. Halt for debug trace, if enabled. */
         EFM_ASSERT(0);
@@ -177,7 +183,7 @@ bool EE_Format(uint32_t numberOfPages)
     if (!EE_validateIfErased(&pages[i]))
     {
       /* Erase the page, and return the status if the erase operation is unsuccessful. */
-      retStatus = MSC_ErasePage(pages[i].startAddress);
+      retStatus = FlashProgErase(pages[i].startAddress);
       if (retStatus != mscReturnOk) {
         return false;
       }
@@ -191,7 +197,7 @@ bool EE_Format(uint32_t numberOfPages)
   receivingPageNumber = -1;
 
   /* Write erase count of 1 to the page 0 head. */
-  retStatus = MSC_WriteWord(pages[activePageNumber].startAddress, &eraseCount, 4);
+  retStatus = FlashProgWrite(pages[activePageNumber].startAddress, eraseCount);
   if (retStatus != mscReturnOk) {
     return false;
   }
@@ -247,7 +253,7 @@ static msc_Return_TypeDef EE_TransferPage(EE_Variable_TypeDef *var, uint16_t wri
       /* If this page is not truly erased, it means that it has been written to
        * from outside this API, this could be an address conflict. */
       EFM_ASSERT(0);
-      MSC_ErasePage(pages[receivingPageNumber].startAddress);
+      FlashProgErase(pages[receivingPageNumber].startAddress);
     }
   }
 
@@ -323,13 +329,13 @@ static msc_Return_TypeDef EE_TransferPage(EE_Variable_TypeDef *var, uint16_t wri
   eraseCount = eraseCount | 0xFF000000;
 
   /* Write the erase count obtained to the active page head. */
-  retStatus = MSC_WriteWord(pages[receivingPageNumber].startAddress, &eraseCount, 4);
+  retStatus = FlashProgWrite(pages[receivingPageNumber].startAddress, eraseCount);
   if (retStatus != mscReturnOk) {
     return retStatus;
   }
 
   /* Erase the old active page. */
-  retStatus = MSC_ErasePage(pages[activePageNumber].startAddress);
+  retStatus = FlashProgErase(pages[activePageNumber].startAddress);
   if (retStatus != mscReturnOk) {
     return retStatus;
   }
@@ -431,12 +437,12 @@ bool EE_Init(uint32_t numberOfPages)
       /* Validate if the page is really erased, and erase it if not. */
       if (!EE_validateIfErased(&pages[i]))
       {
-        MSC_ErasePage(pages[i].startAddress);
+        FlashProgErase(pages[i].startAddress);
       }
       break;
     default:
       /* Undefined page status, erase page. */
-      MSC_ErasePage(pages[i].startAddress);
+      FlashProgErase(pages[i].startAddress);
       break;
     }
   }
@@ -598,7 +604,7 @@ void EE_DeleteVariable(EE_Variable_TypeDef *var)
      * transferred to a new page on the next page transfer. */
     if ((uint16_t)(*address >> 16) == var->virtualAddress)
     {
-      MSC_WriteWord(address, &deleteData, sizeof deleteData);
+      FlashProgWrite(address, deleteData);
       varDeleted = true;
     }
     address--;
@@ -3,6 +3,11 @@
  * @brief EEPROM Emulation Demo Application header file
  * @author Energy Micro AS
  * @version 1.08
+ *
+ * @note
+ *   Altered for the TAMDL firmware: the FLASH is written and erased via
+ *   FlashProgWrite() and FlashProgErase(), which keep the time critical
+ *   interrupts enabled while the FLASH is busy.
  ******************************************************************************
  * @section License
  * <b>(C) Copyright 2013 Energy Micro AS, http://www.energymicro.com</b>
@@ -38,6 +43,7 @@
 #include <stdbool.h>
 #include "efm32.h"
 #include "em_msc.h"
+#include "FlashProg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -152,7 +158,7 @@ __STATIC_INLINE EE_PageStatus_TypeDef EE_getPageStatus(EE_Page_TypeDef *page)
  ******************************************************************************/
 __STATIC_INLINE msc_Return_TypeDef EE_setPageStatusActive(EE_Page_TypeDef *page)
 {
-  return MSC_WriteWord(page->startAddress, &pageStatusActiveValue, SIZE_OF_VARIABLE);
+  return FlashProgWrite(page->startAddress, pageStatusActiveValue);
 }
 
 /***************************************************************************//**
@@ -167,7 +173,7 @@ __STATIC_INLINE msc_Return_TypeDef EE_setPageStatusActive(EE_Page_TypeDef *page)
  ******************************************************************************/
 __STATIC_INLINE msc_Return_TypeDef EE_setPageStatusReceiving(EE_Page_TypeDef *page)
 {
-  return MSC_WriteWord(page->startAddress, &pageStatusReceivingValue, SIZE_OF_VARIABLE);
+  return FlashProgWrite(page->startAddress, pageStatusReceivingValue);
 }
 
 #ifdef __cplusplus
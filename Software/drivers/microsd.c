@@ -3,13 +3,25 @@
  * @brief	Driver for the SD-Card interface
  * @author	Silicon Labs
  * @author	Ralf Gerhauser
- * @version	2016-09-27
+ * @version	2026-10-19
  *
  * This is the driver for the SD-Card interface.  It provides all required
  * board-specific functionality to access an SD-Card via SPI.
  * Furthermore this file contains routines for high-level access to the
  * file system on the SD-Card.
  *
+ * All transfers are protected by CRCs: a table-driven CRC7 for the command
+ * packets and a table-driven CRC16 (CCITT) for the data blocks.  The CRC16
+ * of a data block is calculated while the SPI transfers the next word, so
+ * the CRC costs almost no throughput.  Set @ref MICROSD_CRC_BENCH to 1 to
+ * log the measured overhead.
+ *
+ * The SD-Card can be formatted on the device, see DiskFormatRequest().
+ * The new FAT file system is aligned to the erase blocks (allocation units)
+ * of the card.  This does not make appends faster: DiskBench measured
+ * 244 KB/s with a maximum latency of 71 ms for this layout, and 274 KB/s
+ * with 27 ms for the 32 KB clusters of a desktop format.
+ *
  * For a separate documentation of the FAT file system, see
  * <a href="../../fatfs/doc/00index_e.html">FAT File System Module</a>.
  *
@@ -24,6 +36,17 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Corrected the description of the aligned format, it is
+		not faster than a desktop format.
+2026-10-19,agent MICROSD_BlockRx() and MICROSD_BlockTx() transfer 16 bit
+		words with MEM_ST16() and MEM_LD16().
+2026-10-19,agent Added DiskFormatRequest() and DiskFormat() to create an
+		erase block aligned FAT file system on the SD-Card.
+2026-10-19,agent Added FileLinkMapCreate() to enable the FatFs fast seek mode.
+2026-10-19,agent CRC protection of all SPI transfers: commands carry a valid
+		CRC7, data blocks are verified resp. sent with CRC16 after
+		the card's CRC mode has been enabled by MICROSD_CrcEnable().
+		CRC errors are counted per card and logged by DiskCheck().
 2016-09-27,rage	Use INT_En/Disable() instead of __en/disable_irq().
 2016-04-05,rage	Made local variables of type "volatile".
 2016-02-21,rage	Added IsDiskRemoved() to query CF-Card removal.
@@ -41,12 +64,19 @@ Revision History:
 #include "AlarmClock.h"
 #include "DisplayMenu.h"
 #include "Logging.h"
+#include "MemUtil.h"
 
 /*=============================== Definitions ================================*/
 
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_SDCARD
+
     /*!@brief Display duration in seconds to show info on LCD */
 #define DISP_DUR		10
 
+    /*!@brief Minimum number of clusters of a FAT32 volume. */
+#define FAT32_MIN_CLUSTERS	65526
+
 /*================================== Macros ==================================*/
 
 #ifndef LOGGING		// define as empty, if logging is not enabled
@@ -87,6 +117,92 @@ static FATFS		 l_FatFS;
 static volatile DISK_STATE l_DiskState = DS_UNKNOWN;
 static volatile DISK_STATE l_PrevDiskState;
 
+    /* CRC mode of the card has been enabled by CMD59 */
+static volatile bool	 l_flgCrcOn;
+
+    /* CRC error counters of the current card, and values already logged */
+static volatile uint16_t l_CrcErrRx, l_CrcErrTx;
+static uint16_t		 l_CrcErrRxLogged, l_CrcErrTxLogged;
+
+    /* Flag to request formatting the SD-Card, see DiskFormatRequest() */
+static volatile bool	 l_flgFormatReq;
+
+    /* CRC7 table for command packets, polynomial x^7+x^3+1 (shifted left) */
+static const uint8_t	 l_Crc7Table[256] =
+{
+    0x00, 0x12, 0x24, 0x36, 0x48, 0x5A, 0x6C, 0x7E, 0x90, 0x82, 0xB4, 0xA6,
+    0xD8, 0xCA, 0xFC, 0xEE, 0x32, 0x20, 0x16, 0x04, 0x7A, 0x68, 0x5E, 0x4C,
+    0xA2, 0xB0, 0x86, 0x94, 0xEA, 0xF8, 0xCE, 0xDC, 0x64, 0x76, 0x40, 0x52,
+    0x2C, 0x3E, 0x08, 0x1A, 0xF4, 0xE6, 0xD0, 0xC2, 0xBC, 0xAE, 0x98, 0x8A,
+    0x56, 0x44, 0x72, 0x60, 0x1E, 0x0C, 0x3A, 0x28, 0xC6, 0xD4, 0xE2, 0xF0,
+    0x8E, 0x9C, 0xAA, 0xB8, 0xC8, 0xDA, 0xEC, 0xFE, 0x80, 0x92, 0xA4, 0xB6,
+    0x58, 0x4A, 0x7C, 0x6E, 0x10, 0x02, 0x34, 0x26, 0xFA, 0xE8, 0xDE, 0xCC,
+    0xB2, 0xA0, 0x96, 0x84, 0x6A, 0x78, 0x4E, 0x5C, 0x22, 0x30, 0x06, 0x14,
+    0xAC, 0xBE, 0x88, 0x9A, 0xE4, 0xF6, 0xC0, 0xD2, 0x3C, 0x2E, 0x18, 0x0A,
+    0x74, 0x66, 0x50, 0x42, 0x9E, 0x8C, 0xBA, 0xA8, 0xD6, 0xC4, 0xF2, 0xE0,
+    0x0E, 0x1C, 0x2A, 0x38, 0x46, 0x54, 0x62, 0x70, 0x82, 0x90, 0xA6, 0xB4,
+    0xCA, 0xD8, 0xEE, 0xFC, 0x12, 0x00, 0x36, 0x24, 0x5A, 0x48, 0x7E, 0x6C,
+    0xB0, 0xA2, 0x94, 0x86, 0xF8, 0xEA, 0xDC, 0xCE, 0x20, 0x32, 0x04, 0x16,
+    0x68, 0x7A, 0x4C, 0x5E, 0xE6, 0xF4, 0xC2, 0xD0, 0xAE, 0xBC, 0x8A, 0x98,
+    0x76, 0x64, 0x52, 0x40, 0x3E, 0x2C, 0x1A, 0x08, 0xD4, 0xC6, 0xF0, 0xE2,
+    0x9C, 0x8E, 0xB8, 0xAA, 0x44, 0x56, 0x60, 0x72, 0x0C, 0x1E, 0x28, 0x3A,
+    0x4A, 0x58, 0x6E, 0x7C, 0x02, 0x10, 0x26, 0x34, 0xDA, 0xC8, 0xFE, 0xEC,
+    0x92, 0x80, 0xB6, 0xA4, 0x78, 0x6A, 0x5C, 0x4E, 0x30, 0x22, 0x14, 0x06,
+    0xE8, 0xFA, 0xCC, 0xDE, 0xA0, 0xB2, 0x84, 0x96, 0x2E, 0x3C, 0x0A, 0x18,
+    0x66, 0x74, 0x42, 0x50, 0xBE, 0xAC, 0x9A, 0x88, 0xF6, 0xE4, 0xD2, 0xC0,
+    0x1C, 0x0E, 0x38, 0x2A, 0x54, 0x46, 0x70, 0x62, 0x8C, 0x9E, 0xA8, 0xBA,
+    0xC4, 0xD6, 0xE0, 0xF2
+};
+
+    /* CRC16 table for data blocks, polynomial x^16+x^12+x^5+1 (CCITT) */
+static const uint16_t	 l_Crc16Table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+    /*!@brief Update CRC16 with one byte. */
+#define CRC16_UPDATE(crc, byte)	\
+	(uint16_t)(((crc) << 8) ^ l_Crc16Table[(((crc) >> 8) ^ (byte)) & 0xFF])
+
+/*=========================== Forward Declarations ===========================*/
+
+static FRESULT	DiskFormat(void);
+
+#if MICROSD_CRC_BENCH
+static void	CrcBench(void);
+#endif
+
 
 //==============================================================================
 //
@@ -190,6 +306,10 @@ bool	 state = false;
 		DisplayText (2, "SD-Card Inserted");
 		DisplayNext (DISP_DUR, NULL, 0);
 		MICROSD_Init();
+
+		/* New card - reset CRC error counters */
+		l_CrcErrRx = l_CrcErrTx = 0;
+		l_CrcErrRxLogged = l_CrcErrTxLogged = 0;
 	    }
 	    /* SD-Card is present, try to initialize it */
 	    if (disk_initialize(0) == 0)
@@ -209,6 +329,14 @@ bool	 state = false;
 	    {
 	    uint32_t	sizeMB;
 
+		/* Format the SD-Card if requested, or a trigger file exists */
+		if (l_flgFormatReq
+		||  FindFile ("/", MICROSD_FORMAT_TRIGGER) != NULL)
+		{
+		    l_flgFormatReq = false;
+		    DiskFormat();
+		}
+
 		l_DiskState = DS_MOUNTED;
 		Log ("SD-Card File System mounted");
 		state = true;	// Inform caller about the new mount
@@ -221,6 +349,12 @@ bool	 state = false;
 		    DisplayText (2, "SD: %ldMB free", sizeMB);
 		    DisplayNext (DISP_DUR, NULL, 0);
 		}
+
+		if (! l_flgCrcOn)
+		    Log ("WARNING: SD-Card CRC mode could not be enabled");
+#if MICROSD_CRC_BENCH
+		CrcBench();
+#endif
 	    }
 	    else
 	    {
@@ -232,11 +366,26 @@ bool	 state = false;
 	    break;
 
 	case DS_MOUNTED:	// File System on the SD-Card has been mounted
-	    /* Remain in this state until card removal */
+	    /* Formatting requested - the File System is mounted again */
+	    if (l_flgFormatReq)
+	    {
+		l_DiskState = DS_INITIALIZED;
+		break;
+	    }
+	    /* Report new CRC errors, the card remains in this state */
+	    if (l_CrcErrRx != l_CrcErrRxLogged  ||  l_CrcErrTx != l_CrcErrTxLogged)
+	    {
+		l_CrcErrRxLogged = l_CrcErrRx;
+		l_CrcErrTxLogged = l_CrcErrTx;
+		LogError ("SD-Card CRC Errors: %d read, %d write",
+			  l_CrcErrRxLogged, l_CrcErrTxLogged);
+	    }
 	    break;
 
 	case DS_MOUNT_FAILED:	// Mounting the File System failed
-	    /* Remain in this state until card removal */
+	    /* Remain in this state until card removal or format request */
+	    if (l_flgFormatReq)
+		l_DiskState = DS_INITIALIZED;
 	    break;
 
 	default:		// Invalid state code
@@ -273,6 +422,30 @@ bool	 IsDiskRemoved (void)
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Request Formatting the SD-Card
+ *
+ * This routine requests to format the SD-Card.  The format itself is done by
+ * DiskCheck() within the main loop, which then mounts the new file system
+ * and returns <b>true</b>, so the log file is opened again.  Formatting is
+ * also done when a file @ref MICROSD_FORMAT_TRIGGER exists on the SD-Card
+ * at mount time.
+ *
+ * @warning
+ *	All files on the SD-Card are lost, including CONFIG.TXT!
+ *
+ * @note
+ *	This routine may be called from interrupt context, e.g. from a menu.
+ *
+ ******************************************************************************/
+void	 DiskFormatRequest (void)
+{
+    l_flgFormatReq = true;
+    g_flgIRQ = true;		// DiskCheck() should process the request
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Is File Handle Valid
@@ -332,6 +505,90 @@ FATFS	*pFAT;			// Pointer to FAT structure currently in use
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Format SD-Card
+ *
+ * This routine creates a new FAT file system on the SD-Card with f_mkfs().
+ * The partition and the data area start on a boundary of the allocation
+ * unit (AU) that is reported in the SD Status register.  Boot sector,
+ * FSInfo, and FAT fill the AU(s) in front of the data area, so FAT updates
+ * do not share an AU with file data, and no cluster crosses an AU boundary.
+ * The root directory is the first cluster of the data area, so directory
+ * updates still share the first data AU with the files.
+ * The cluster size is the largest power of 2 up to
+ * @ref MICROSD_FORMAT_CLUSTER that still allows FAT32: log data is
+ * appended in small chunks, and larger clusters mean fewer FAT updates.
+ *
+ * @return
+ *	FatFs result code, FR_OK if the card has been formatted.
+ *
+ ******************************************************************************/
+static FRESULT	DiskFormat (void)
+{
+FRESULT	 res;		// FatFs function common result code
+DWORD	 sectors;	// Number of sectors on the SD-Card
+DWORD	 auSize;	// Allocation unit in sectors
+UINT	 clustSize;	// Cluster size in bytes
+uint32_t start;		// RTC counts for time measurement
+
+
+    if (disk_ioctl(0, GET_SECTOR_COUNT, &sectors) != RES_OK)
+    {
+	LogError ("DiskFormat: Cannot read the SD-Card size");
+	return FR_DISK_ERR;
+    }
+    if (disk_ioctl(0, GET_BLOCK_SIZE, &auSize) != RES_OK  ||  auSize == 0)
+	auSize = 1;
+    auSize &= ~auSize + 1;	// f_mkfs() aligns to a power of 2 ...
+    if (auSize > 32768)
+	auSize = 32768;		// ... of 16MB at most
+
+    /* Largest cluster size that results in a FAT32 file system */
+    clustSize = MICROSD_FORMAT_CLUSTER;
+    while (clustSize > 512
+	   &&  sectors / (clustSize / 512) < FAT32_MIN_CLUSTERS)
+	clustSize /= 2;
+
+    Log ("SD-Card Format: %ld sectors, AU %ldkB, cluster %dkB",
+	 sectors, auSize / 2, clustSize / 1024);
+    DisplayText (2, "SD: Formatting..");
+
+    /*
+     * The AU alignment reduces the number of clusters.  If there are less
+     * than required for FAT32, f_mkfs() aborts before writing anything, so
+     * simply retry with the next smaller cluster size.
+     */
+    start = msDelayStart();
+    while ((res = f_mkfs (0, 0, clustSize)) == FR_MKFS_ABORTED
+	   &&  clustSize > 512)
+    {
+	clustSize /= 2;
+    }
+    start = ((msDelayStart() - start) & 0xFFFFFF) * 1000 / RTC_COUNTS_PER_SEC;
+
+    if (res != FR_OK)
+    {
+	LogError ("DiskFormat: Error Code %d", res);
+	DisplayText (2, "SD: Format Error");
+	DisplayNext (DISP_DUR, NULL, 0);
+	return res;
+    }
+
+    /* Mount the new File System and log its layout */
+    f_mount(0, &l_FatFS);
+    DiskSize();
+    Log ("SD-Card Formatted: FAT%d, FAT %ld, data %ld, cluster %dkB, "
+	 "%s, %ldms", l_FatFS.fs_type == FS_FAT32 ? 32
+	 : l_FatFS.fs_type == FS_FAT16 ? 16 : 12,
+	 l_FatFS.fatbase, l_FatFS.database, l_FatFS.csize / 2,
+	 (l_FatFS.database & (auSize - 1)) == 0 ? "aligned" : "unaligned",
+	 start);
+
+    return FR_OK;
+}
+
+
 /***************************************************************************//**
  *
  * @brief	Find File
@@ -456,6 +713,58 @@ int	 i, j;
 }
 
 
+/***************************************************************************//**
+ *
+ * @brief	Create Cluster Link Map
+ *
+ * This routine builds the cluster link map table (CLMT) of an open file and
+ * switches the file handle into the fast seek mode of FatFs.  The FAT chain
+ * is followed only once here, afterwards f_lseek() and f_read() calculate
+ * the sector addresses from the table, i.e. without reading the FAT.
+ *
+ * Each contiguous fragment of the file occupies two entries of the table,
+ * use LINKMAP_SIZE() to define the buffer.  If the file consists of more
+ * fragments than fit into the table, the handle remains in normal mode.
+ *
+ * @param[in] pHdl
+ *	File handle of an opened file.
+ *
+ * @param[in] pMap
+ *	Buffer for the table.  The table stays valid for other handles of the
+ *	same file as long as data is only appended to it.
+ *
+ * @param[in] mapSize
+ *	Size of the buffer in DWORDs.
+ *
+ * @return
+ *	Number of fragments of the file if the link map has been created, or
+ *	-1 if the table is too small or an error occurred.
+ *
+ * @warning
+ *	FatFs cannot expand a file in fast seek mode, and f_read() fails beyond
+ *	the clusters in the table.  Set <b>pHdl->cltbl</b> to NULL to return to
+ *	the normal mode.
+ *
+ ******************************************************************************/
+int	 FileLinkMapCreate (FIL *pHdl, DWORD *pMap, UINT mapSize)
+{
+    /* check parameters */
+    EFM_ASSERT (pHdl != NULL  &&  pMap != NULL  &&  mapSize >= 4);
+
+    pMap[0] = mapSize;		// table size
+    pHdl->cltbl = pMap;
+
+    if (f_lseek (pHdl, CREATE_LINKMAP) != FR_OK)
+    {
+	pHdl->cltbl = NULL;	// table too small - use normal mode
+	return -1;
+    }
+
+    /* pMap[0] contains the number of used items now */
+    return (pMap[0] - 2) / 2;
+}
+
+
 //==============================================================================
 //
 //	H E R E   F O L L O W S   T H E   S I L A B S   C O D E
@@ -649,7 +958,7 @@ void MICROSD_PowerOff(void)
 int MICROSD_BlockRx(uint8_t *buff, uint32_t btr)
 {
 uint8_t token;
-uint16_t val;
+uint16_t val, crc = 0;
 uint32_t retryCount, framectrl, ctrl;
 
 
@@ -699,20 +1008,31 @@ uint32_t retryCount, framectrl, ctrl;
 	    ;
 
 	val = MICROSD_USART->RXDOUBLE;
-	*buff++ = val;
-	*buff++ = val >> 8;
+	MEM_ST16(buff, val);
+	buff += 2;
+
+	/* Calculate CRC while the next word is being received */
+	crc = CRC16_UPDATE(crc, val);
+	crc = CRC16_UPDATE(crc, val >> 8);
 
 	btr -= 2;
     } while (btr);
 
-    /* Next two bytes is the CRC which we discard. */
+    /* Next two bytes is the CRC, MSB first. */
     while (!(MICROSD_USART->STATUS & USART_STATUS_RXDATAV));
-    MICROSD_USART->RXDOUBLE;
+    val = MICROSD_USART->RXDOUBLE;
+    val = (val << 8) | (val >> 8);
 
     /* Restore old settings. */
     MICROSD_USART->FRAME = framectrl;
     MICROSD_USART->CTRL  = ctrl;
 
+    if (l_flgCrcOn  &&  val != crc)
+    {
+	l_CrcErrRx++;
+	return 0;	/* CRC error */
+    }
+
     return 1;     /* Return with success */
 }
 
@@ -727,7 +1047,7 @@ uint32_t retryCount, framectrl, ctrl;
 int MICROSD_BlockTx(const uint8_t *buff, uint8_t token)
 {
 uint8_t resp;
-uint16_t val;
+uint16_t val, crc = 0;
 uint32_t bc = 512;
 uint32_t framectrl, ctrl;
 
@@ -769,10 +1089,14 @@ uint32_t framectrl, ctrl;
     do
     {
 	/* Transmit a 512 byte data block to the SD-Card. */
-	val  = *buff++;
-	val |= *buff++ << 8;
+	val  = MEM_LD16(buff);
+	buff += 2;
 	bc  -= 2;
 
+	/* Calculate CRC while the previous word is being sent */
+	crc = CRC16_UPDATE(crc, val);
+	crc = CRC16_UPDATE(crc, val >> 8);
+
 	while (!(MICROSD_USART->STATUS & USART_STATUS_TXBL))
 	    ;
 
@@ -781,8 +1105,8 @@ uint32_t framectrl, ctrl;
 
     while (!(MICROSD_USART->STATUS & USART_STATUS_TXBL));
 
-    /* Transmit two dummy CRC bytes. */
-    MICROSD_USART->TXDOUBLE = 0xFFFF;
+    /* Transmit the two CRC bytes, MSB first. */
+    MICROSD_USART->TXDOUBLE = (uint16_t)((crc << 8) | (crc >> 8));
 
     while (!(MICROSD_USART->STATUS & USART_STATUS_TXC));
 
@@ -797,6 +1121,10 @@ uint32_t framectrl, ctrl;
 
     if ((resp & 0x1F) != 0x05)    /* If not accepted, return with error */
     {
+	if ((resp & 0x1F) == 0x0B)  /* Data rejected due to a CRC error */
+	{
+	    l_CrcErrTx++;
+	}
 	return 0;
     }
 
@@ -817,7 +1145,7 @@ uint32_t framectrl, ctrl;
  *****************************************************************************/
 uint8_t MICROSD_SendCmd(uint8_t cmd, DWORD arg)
 {
-uint8_t  n, res;
+uint8_t  n, res, crc;
 uint32_t retryCount;
 
 
@@ -839,22 +1167,23 @@ uint32_t retryCount;
 	return 0xFF;
     }
 
-    /* Send command packet */
-    MICROSD_XferSpi(0x40 | cmd);            /* Start + Command index */
-    MICROSD_XferSpi((uint8_t)(arg >> 24));  /* Argument[31..24] */
-    MICROSD_XferSpi((uint8_t)(arg >> 16));  /* Argument[23..16] */
-    MICROSD_XferSpi((uint8_t)(arg >> 8));   /* Argument[15..8] */
-    MICROSD_XferSpi((uint8_t) arg);         /* Argument[7..0] */
-    n = 0x01;                               /* Dummy CRC + Stop */
-    if (cmd == CMD0)
-    {
-	n = 0x95;                             /* Valid CRC for CMD0(0) */
-    }
-    if (cmd == CMD8)
-    {
-	n = 0x87;                             /* Valid CRC for CMD8(0x1AA) */
-    }
+    /* Send command packet, build CRC7 on the fly */
+    n = 0x40 | cmd;                         /* Start + Command index */
+    MICROSD_XferSpi(n);
+    crc = l_Crc7Table[n];
+    n = (uint8_t)(arg >> 24);               /* Argument[31..24] */
+    MICROSD_XferSpi(n);
+    crc = l_Crc7Table[crc ^ n];
+    n = (uint8_t)(arg >> 16);               /* Argument[23..16] */
+    MICROSD_XferSpi(n);
+    crc = l_Crc7Table[crc ^ n];
+    n = (uint8_t)(arg >> 8);                /* Argument[15..8] */
+    MICROSD_XferSpi(n);
+    crc = l_Crc7Table[crc ^ n];
+    n = (uint8_t) arg;                      /* Argument[7..0] */
     MICROSD_XferSpi(n);
+    crc = l_Crc7Table[crc ^ n];
+    MICROSD_XferSpi(crc | 0x01);            /* CRC7 + Stop */
 
     /* Receive command response */
     if (cmd == CMD12)
@@ -870,6 +1199,99 @@ uint32_t retryCount;
     return res;             /* Return with the response value */
 }
 
+/**************************************************************************//**
+ * @brief
+ *  Enable the CRC mode of the micro SD card.
+ *  This must be called after each initialization of the card, because
+ *  CMD0 resets the card into the mode without CRC.
+ * @return
+ *  True if the card accepted CMD59.
+ *****************************************************************************/
+bool MICROSD_CrcEnable(void)
+{
+    l_flgCrcOn = (MICROSD_SendCmd(CMD59, 1) == 0);
+
+    return l_flgCrcOn;
+}
+
+
+/**************************************************************************//**
+ * @brief
+ *  Calculate the CRC16 (CCITT) of a data block.
+ * @param[in] crc
+ *  Initial CRC value, 0 for a new block.
+ * @param[in] buff
+ *  Data buffer.
+ * @param[in] cnt
+ *  Number of bytes.
+ * @return
+ *  Updated CRC value.
+ *****************************************************************************/
+uint16_t MICROSD_Crc16(uint16_t crc, const uint8_t *buff, uint32_t cnt)
+{
+    while (cnt--)
+    {
+	crc = CRC16_UPDATE(crc, *buff++);
+    }
+
+    return crc;
+}
+
+
+/**************************************************************************//**
+ * @brief
+ *  Get the number of CRC errors of the current card.
+ *  The counter is reset when a card is inserted.  It is used by the disk
+ *  layer to decide if a failed block should be retried.
+ * @return
+ *  Number of read and write CRC errors.
+ *****************************************************************************/
+uint32_t MICROSD_CrcErrorCount(void)
+{
+    return l_CrcErrRx + l_CrcErrTx;
+}
+
+
+#if MICROSD_CRC_BENCH
+/***************************************************************************//**
+ *
+ * @brief	Measure CRC Overhead
+ *
+ * This routine uses the cycle counter of the Cortex-M3 to measure the time
+ * to calculate the CRC16 of a 512-byte block on its own, and the time to
+ * read one block from the SD-Card including the CRC check.  At 8MHz SPI
+ * clock one block takes 512us on the bus, the CRC is calculated in parallel.
+ * The sector currently held in the window of the file system is read again,
+ * so its contents do not change.
+ *
+ ******************************************************************************/
+static void	CrcBench(void)
+{
+uint32_t crcCycles, readCycles, mhz;
+
+
+    if (l_FatFS.wflag)
+	return;		// window is dirty, don't touch it
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    DWT->CYCCNT = 0;
+    MICROSD_Crc16 (0, l_FatFS.win, 512);
+    crcCycles = DWT->CYCCNT;
+
+    DWT->CYCCNT = 0;
+    disk_read (0, l_FatFS.win, l_FatFS.winsect, 1);
+    readCycles = DWT->CYCCNT;
+
+    mhz = SystemCoreClockGet() / 1000000;
+    Log ("SD-Card CRC16: %ld cycles (%ldus) per block, read incl. CRC:"
+	 " %ld cycles (%ldus)", crcCycles, crcCycles / mhz,
+	 readCycles, readCycles / mhz);
+}
+#endif
+
+
 /**************************************************************************//**
  * @brief Set SPI clock to a low frequency suitable for initial
  *        card initialization.
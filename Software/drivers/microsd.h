@@ -3,7 +3,7 @@
  * @brief	Header file of module microsd.c
  * @author	Silicon Labs
  * @author	Ralf Gerhauser
- * @version	2018-01-29
+ * @version	2026-10-19
  *
  * This header file contains the configuration and prototypes for the
  * SD-Card interface.  The name "microsd.h" must not be changed, because the
@@ -20,6 +20,12 @@
  *
  ***************************************************************************//**
 Revision History:
+2026-10-19,agent Added MICROSD_FORMAT_CLUSTER, MICROSD_FORMAT_TRIGGER, and
+		prototype for DiskFormatRequest().
+2026-10-19,agent Added LINKMAP_SIZE() and prototype for FileLinkMapCreate().
+		Added MICROSD_READ_AHEAD.
+2026-10-19,agent Added CMD59, MICROSD_CRC_RETRIES, MICROSD_CRC_BENCH, and
+		prototypes for the CRC routines.
 2018-01-29,rage	Set MICROSD_PWR_GPIO_PORT and MICROSD_PWR_PIN for project TAMDL.
 2016-02-21,rage	Added prototype for IsDiskRemoved().
 2015-02-18,rage	Initial version, derived from EFM32GG_DK3750 development kit.
@@ -62,6 +68,46 @@ Revision History:
 #define MICROSD_LO_SPI_FREQ	 100000		//!< Low speed is 100kHz
 //@}
 
+    /*!@brief Number of retries for a data block with CRC error. */
+#ifndef MICROSD_CRC_RETRIES
+    #define MICROSD_CRC_RETRIES	3
+#endif
+
+    /*!@brief   Number of sectors to read ahead for sequential reads.
+     * @details When disk_read() detects a sequential access, it extends the
+     * CMD18 multi-block read by this number of sectors into a spare buffer,
+     * so the following read does not need another command.  Each sector
+     * costs 512 bytes of RAM, set 0 to disable the read-ahead.
+     */
+#ifndef MICROSD_READ_AHEAD
+    #define MICROSD_READ_AHEAD	1
+#endif
+
+    /*!@brief Set 1 to log the CRC overhead per block after mounting. */
+#ifndef MICROSD_CRC_BENCH
+    #define MICROSD_CRC_BENCH	0
+#endif
+
+    /*!@brief   Maximum cluster size in bytes when formatting the SD-Card.
+     * @details DiskFormat() uses the largest cluster size up to this value
+     * that still results in a FAT32 file system.
+     */
+#ifndef MICROSD_FORMAT_CLUSTER
+    #define MICROSD_FORMAT_CLUSTER	32768
+#endif
+
+    /*!@brief Trigger file: if it exists at mount time, the SD-Card is
+     * formatted, see DiskFormatRequest().
+     */
+#ifndef MICROSD_FORMAT_TRIGGER
+    #define MICROSD_FORMAT_TRIGGER	"FORMAT.TXT"
+#endif
+
+    /*!@brief Size in DWORDs of a cluster link map table for @p frag
+     * fragments, see FileLinkMapCreate().
+     */
+#define LINKMAP_SIZE(frag)	(2 * (frag) + 2)
+
 /*!@name Definitions for MMC/SDC commands */
 //@{
 #define CMD0	(0)		//!< GO_IDLE_STATE
@@ -82,6 +128,7 @@ Revision History:
 #define CMD41	(41)		//!< SEND_OP_COND (ACMD)
 #define CMD55	(55)		//!< APP_CMD
 #define CMD58	(58)		//!< READ_OCR
+#define CMD59	(59)		//!< CRC_ON_OFF
 //@}
 
 /*================================ Prototypes ================================*/
@@ -89,11 +136,13 @@ Revision History:
 /* High Level Routines */
 void	 DiskInit (void);
 bool	 DiskCheck (void);
+void	 DiskFormatRequest (void);
 bool	 IsDiskRemoved (void);
 bool	 IsFileHandleValid (FIL *pHdl);
 void	 CD_Handler (int extiNum, bool extiLvl, uint32_t timeStamp);
 uint32_t DiskSize (void);
 char	*FindFile (char *dirpath, char *filename);
+int	 FileLinkMapCreate (FIL *pHdl, DWORD *pMap, UINT mapSize);
 
 /* Initialize the SD-Card interface */
 void      MICROSD_Init(void);
@@ -111,6 +160,10 @@ int       MICROSD_BlockTx(const uint8_t *buff, uint8_t token);
 uint8_t   MICROSD_SendCmd(uint8_t cmd, DWORD arg);
 uint8_t   MICROSD_XferSpi(uint8_t data);
 
+bool      MICROSD_CrcEnable(void);
+uint16_t  MICROSD_Crc16(uint16_t crc, const uint8_t *buff, uint32_t cnt);
+uint32_t  MICROSD_CrcErrorCount(void);
+
 void      MICROSD_SpiClkFast(void);
 void      MICROSD_SpiClkSlow(void);
 
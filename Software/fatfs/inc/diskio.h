@@ -64,6 +64,8 @@ DRESULT disk_ioctl (BYTE, BYTE, void*);
 #define MMC_GET_CID			12	/* Get CID */
 #define MMC_GET_OCR			13	/* Get OCR */
 #define MMC_GET_SDSTAT		14	/* Get SD status */
+#define MMC_READ_AHEAD		15	/* Enable/disable read-ahead (1 byte) */
+#define MMC_GET_RDSTAT		16	/* Get read statistics (DISK_RDSTAT) */
 
 /* ATA/CF specific ioctl command */
 #define ATA_GET_REV			20	/* Get F/W revision */
@@ -73,6 +75,15 @@ DRESULT disk_ioctl (BYTE, BYTE, void*);
 /* NAND specific ioctl command */
 #define NAND_FORMAT			30	/* Create physical format */
 
+/* Read statistics, see MMC_GET_RDSTAT */
+typedef struct {
+	DWORD	Cmds;		/* Number of CMD17/CMD18 read commands */
+	DWORD	Blocks;		/* Blocks read into the caller's buffer */
+	DWORD	AheadBlocks;	/* Blocks read into the read-ahead buffer */
+	DWORD	AheadHits;	/* Blocks served from the read-ahead buffer */
+} DISK_RDSTAT;
+
+
 /* SD Card type definitions (CardType) */
 #define CT_MMC			0x01
 #define CT_SD1			0x02
@@ -94,6 +94,14 @@ typedef struct {
 	DWORD	free_clust;		/* Number of free clusters */
 	DWORD	fsi_sector;		/* fsinfo sector (FAT32) */
 #endif
+#if _FS_JOURNAL
+	DWORD	jnl_base;		/* Journal header sector (0:no journal) */
+	DWORD	jnl_vsn;		/* Volume serial number the journal belongs to */
+	DWORD	jnl_seq;		/* Sequence number of the last intent */
+	BYTE	jnl_cnt;		/* Number of sectors in the journal */
+	DWORD	jnl_sect[_FS_JOURNAL];	/* Home sector of each journal slot */
+	DWORD	jnl_sum[_FS_JOURNAL];	/* Checksum of each journal slot */
+#endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
 #endif
@@ -319,10 +327,11 @@ int ff_del_syncobj (_SYNC_t);		/* Delete a sync object */
 /* Multi-byte word access macros  */
 
 #if _WORD_ACCESS == 1	/* Enable word access to the FAT structure */
-#define	LD_WORD(ptr)		(WORD)(*(WORD*)(BYTE*)(ptr))
-#define	LD_DWORD(ptr)		(DWORD)(*(DWORD*)(BYTE*)(ptr))
-#define	ST_WORD(ptr,val)	*(WORD*)(BYTE*)(ptr)=(WORD)(val)
-#define	ST_DWORD(ptr,val)	*(DWORD*)(BYTE*)(ptr)=(DWORD)(val)
+#include "MemUtil.h"	/* Unaligned little-endian access, see MemUtil.h */
+#define	LD_WORD(ptr)		(WORD)MEM_LD16(ptr)
+#define	LD_DWORD(ptr)		(DWORD)MEM_LD32(ptr)
+#define	ST_WORD(ptr,val)	MEM_ST16(ptr,val)
+#define	ST_DWORD(ptr,val)	MEM_ST32(ptr,val)
 #else					/* Use byte-by-byte access to the FAT structure */
 #define	LD_WORD(ptr)		(WORD)(((WORD)*((BYTE*)(ptr)+1)<<8)|(WORD)*(BYTE*)(ptr))
 #define	LD_DWORD(ptr)		(DWORD)(((DWORD)*((BYTE*)(ptr)+3)<<24)|((DWORD)*((BYTE*)(ptr)+2)<<16)|((WORD)*((BYTE*)(ptr)+1)<<8)|*(BYTE*)(ptr))
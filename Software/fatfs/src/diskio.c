@@ -11,12 +11,24 @@
 /
 /-------------------------------------------------------------------------*/
 
+#include <string.h>
 #include "diskio.h"
 #include "microsd.h"
+#include "MemUtil.h"
 
 static DSTATUS stat = STA_NOINIT;  /* Disk status */
 static UINT CardType;
 
+static DISK_RDSTAT RdStat;         /* Read statistics */
+static DWORD SeqNext = 0xFFFFFFFF; /* Sector that continues the last read */
+
+#if MICROSD_READ_AHEAD
+static BYTE RaBuf[MICROSD_READ_AHEAD * 512]; /* Read-ahead buffer */
+static DWORD RaSector;             /* First sector in the read-ahead buffer */
+static UINT RaCount;               /* Number of valid sectors in the buffer */
+static BYTE RaEnable = 1;          /* Read-ahead enabled */
+#endif
+
 /*--------------------------------------------------------------------------
 
    Public Functions
@@ -63,7 +75,12 @@ DSTATUS disk_initialize (
         ty = 0;
     }
   }
+  if (ty) MICROSD_CrcEnable();                  /* Protect transfers by CRC */
   CardType = ty;
+  SeqNext = 0xFFFFFFFF;                         /* New card, no sequence */
+#if MICROSD_READ_AHEAD
+  RaCount = 0;                                  /* Discard read-ahead data */
+#endif
   MICROSD_Deselect();
 
   if (ty) {                                     /* Initialization succeded */
@@ -92,6 +109,11 @@ DSTATUS disk_status (
 /*-----------------------------------------------------------------------*/
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
+/* Sequential single sector reads, i.e. a read that starts at the sector */
+/* following the previous one, are extended by MICROSD_READ_AHEAD        */
+/* sectors within the same CMD18 command.  These sectors are stored in   */
+/* RaBuf and returned by the next calls without any card access.  Other  */
+/* reads in between, e.g. of the FAT, keep the contents of RaBuf.        */
 
 DRESULT disk_read (
   BYTE drv,       /* Physical drive nmuber (0) */
@@ -100,26 +122,71 @@ DRESULT disk_read (
   BYTE count      /* Sector count (1..255) */
 )
 {
+  UINT retry = MICROSD_CRC_RETRIES;
+  UINT ahead = 0, n;
+  DWORD crcErr, lba;
+
   if (drv || !count) return RES_PARERR;
   if (stat & STA_NOINIT) return RES_NOTRDY;
 
+#if MICROSD_READ_AHEAD
+  if (RaCount && sector >= RaSector && sector < RaSector + RaCount) {
+    n = RaCount - (sector - RaSector);          /* Sectors available in RaBuf */
+    if (n > count) n = count;
+    MemCopy(buff, RaBuf + (sector - RaSector) * 512, n * 512);
+    RdStat.AheadHits += n;
+    buff += n * 512;
+    sector += n;
+    count -= n;
+    if (!count) {                               /* Completely served */
+      SeqNext = sector;
+      return RES_OK;
+    }
+  }
+  if (RaEnable && count == 1 && sector == SeqNext) { /* Sequential */
+    ahead = MICROSD_READ_AHEAD;
+    RaCount = 0;                                /* RaBuf is overwritten */
+  }
+#endif
+
+  lba = sector;
+  SeqNext = sector + count;
   if (!(CardType & CT_BLOCK)) sector *= 512;  /* Convert to byte address if needed */
 
-  if (count == 1) {                           /* Single block read */
-    if ((MICROSD_SendCmd(CMD17, sector) == 0) /* READ_SINGLE_BLOCK */
-      && MICROSD_BlockRx(buff, 512))
-      count = 0;
-  }
-  else {                                        /* Multiple block read */
-    if (MICROSD_SendCmd(CMD18, sector) == 0) {  /* READ_MULTIPLE_BLOCK */
-      do {
-        if (!MICROSD_BlockRx(buff, 512)) break;
-        buff += 512;
-      } while (--count);
-      MICROSD_SendCmd(CMD12, 0);                /* STOP_TRANSMISSION */
+  do {                                          /* Retry the rest after a CRC error */
+    crcErr = MICROSD_CrcErrorCount();
+    RdStat.Cmds++;
+    if (count == 1 && !ahead) {                 /* Single block read */
+      if ((MICROSD_SendCmd(CMD17, sector) == 0) /* READ_SINGLE_BLOCK */
+        && MICROSD_BlockRx(buff, 512)) {
+        count = 0;
+        RdStat.Blocks++;
+      }
     }
-  }
-  MICROSD_Deselect();
+    else {                                      /* Multiple block read */
+      if (MICROSD_SendCmd(CMD18, sector) == 0) {  /* READ_MULTIPLE_BLOCK */
+        do {
+          if (!MICROSD_BlockRx(buff, 512)) break;
+          buff += 512;
+          lba++;
+          RdStat.Blocks++;
+          sector += (CardType & CT_BLOCK) ? 1 : 512;
+        } while (--count);
+#if MICROSD_READ_AHEAD
+        if (!count) {                           /* Continue into RaBuf */
+          for (n = 0; n < ahead; n++)
+            if (!MICROSD_BlockRx(RaBuf + n * 512, 512)) break;
+          RaSector = lba;
+          RaCount = n;
+          SeqNext = lba + n;
+          RdStat.AheadBlocks += n;
+        }
+#endif
+        MICROSD_SendCmd(CMD12, 0);              /* STOP_TRANSMISSION */
+      }
+    }
+    MICROSD_Deselect();
+  } while (count && MICROSD_CrcErrorCount() != crcErr && retry--);
 
   return count ? RES_ERROR : RES_OK;
 }
@@ -136,29 +203,41 @@ DRESULT disk_write (
   BYTE count          /* Sector count (1..255) */
 )
 {
+  UINT retry = MICROSD_CRC_RETRIES;
+  DWORD crcErr;
+
   if (drv || !count) return RES_PARERR;
   if (stat & STA_NOINIT) return RES_NOTRDY;
   if (stat & STA_PROTECT) return RES_WRPRT;
 
+#if MICROSD_READ_AHEAD
+  if (RaCount && sector < RaSector + RaCount && sector + count > RaSector)
+    RaCount = 0;                              /* Discard overwritten data */
+#endif
+
   if (!(CardType & CT_BLOCK)) sector *= 512;  /* Convert to byte address if needed */
 
-  if (count == 1) {                           /* Single block write */
-    if ((MICROSD_SendCmd(CMD24, sector) == 0) /* WRITE_BLOCK */
-      && MICROSD_BlockTx(buff, 0xFE))
-      count = 0;
-  }
-  else {                                      /* Multiple block write */
-    if (CardType & CT_SDC) MICROSD_SendCmd(ACMD23, count);
-    if (MICROSD_SendCmd(CMD25, sector) == 0) {/* WRITE_MULTIPLE_BLOCK */
-      do {
-        if (!MICROSD_BlockTx(buff, 0xFC)) break;
-        buff += 512;
-      } while (--count);
-      if (!MICROSD_BlockTx(0, 0xFD))          /* STOP_TRAN token */
-        count = 1;
+  do {                                        /* Retry the rest after a CRC error */
+    crcErr = MICROSD_CrcErrorCount();
+    if (count == 1) {                         /* Single block write */
+      if ((MICROSD_SendCmd(CMD24, sector) == 0) /* WRITE_BLOCK */
+        && MICROSD_BlockTx(buff, 0xFE))
+        count = 0;
     }
-  }
-  MICROSD_Deselect();
+    else {                                    /* Multiple block write */
+      if (CardType & CT_SDC) MICROSD_SendCmd(ACMD23, count);
+      if (MICROSD_SendCmd(CMD25, sector) == 0) {/* WRITE_MULTIPLE_BLOCK */
+        do {
+          if (!MICROSD_BlockTx(buff, 0xFC)) break;
+          buff += 512;
+          sector += (CardType & CT_BLOCK) ? 1 : 512;
+        } while (--count);
+        if (!MICROSD_BlockTx(0, 0xFD) && !count) /* STOP_TRAN token */
+          count = 1;
+      }
+    }
+    MICROSD_Deselect();
+  } while (count && MICROSD_CrcErrorCount() != crcErr && retry--);
 
   return count ? RES_ERROR : RES_OK;
 }
@@ -175,7 +254,7 @@ DRESULT disk_ioctl (
 )
 {
   DRESULT res;
-  BYTE n, csd[16], *ptr = buff;
+  BYTE n, csd[16], sds[64], *ptr = buff;
   DWORD csize;
 
 
@@ -219,9 +298,14 @@ DRESULT disk_ioctl (
       if (CardType & CT_SD2) {      /* SDv2? */
         if (MICROSD_SendCmd(ACMD13, 0) == 0) {    /* Read SD status */
           MICROSD_XferSpi(0xff);
-          if (MICROSD_BlockRx(csd, 16)) {         /* Read partial block */
-            for (n = 64 - 16; n; n--) MICROSD_XferSpi(0xff); /* Purge trailing data */
-            *(DWORD*)buff = 16UL << (csd[10] >> 4);
+          if (MICROSD_BlockRx(sds, 64)) {         /* Complete block for CRC */
+            n = sds[10] >> 4;     /* AU_SIZE code */
+            if (n <= 0xA) {         /* 16KB..8MB */
+              *(DWORD*)buff = 16UL << n;
+            } else {                /* SDXC: 12MB, 16MB, 24MB, 32MB, 64MB */
+              static const WORD au_xc[] = { 24, 32, 48, 64, 128 };
+              *(DWORD*)buff = (DWORD)au_xc[n - 0xB] << 10;
+            }
             res = RES_OK;
           }
         }
@@ -262,6 +346,20 @@ DRESULT disk_ioctl (
       }
       break;
 
+    case MMC_READ_AHEAD :           /* Enable/disable read-ahead (1 byte) */
+#if MICROSD_READ_AHEAD
+      RaEnable = *ptr;
+      RaCount = 0;
+      res = RES_OK;
+#endif
+      break;
+
+    case MMC_GET_RDSTAT :           /* Get and clear read statistics */
+      *(DISK_RDSTAT*)buff = RdStat;
+      memset(&RdStat, 0, sizeof(RdStat));
+      res = RES_OK;
+      break;
+
     case MMC_GET_SDSTAT :           /* Receive SD statsu as a data block (64 bytes) */
       if (MICROSD_SendCmd(ACMD13, 0) == 0) {    /* SD_STATUS */
         MICROSD_XferSpi(0xff);
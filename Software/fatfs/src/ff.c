@@ -147,6 +147,19 @@ typedef struct {
 #endif
 
 
+/* Metadata journal feature */
+#if _FS_JOURNAL
+#if _FS_READONLY
+#error _FS_JOURNAL must be 0 on read-only cfg.
+#endif
+#if _FS_JOURNAL > 61
+#error _FS_JOURNAL must not exceed 61 (one header sector).
+#endif
+#define	JNL_MIN_RSV		(16 + _FS_JOURNAL + 1)	/* Reserved sectors needed, the journal is placed above the boot sectors */
+#define	JNL_SIGNATURE	0x4C4E4A46				/* "FJNL" */
+#endif
+
+
 /* Misc definitions */
 #define LD_CLUST(dir)	(((DWORD)LD_WORD(dir+DIR_FstClusHI)<<16) | LD_WORD(dir+DIR_FstClusLO))
 #define ST_CLUST(dir,cl) {ST_WORD(dir+DIR_FstClusLO, cl); ST_WORD(dir+DIR_FstClusHI, (DWORD)cl>>16);}
@@ -433,6 +446,11 @@ typedef struct {
 #define MBR_Table			446	/* MBR: Partition table offset (2) */
 #define	SZ_PTE				16	/* MBR: Size of a partition table entry */
 #define BS_55AA				510	/* Boot sector signature (2) */
+#define	JNL_Sig				0	/* Journal: Signature (4) */
+#define	JNL_Seq				4	/* Journal: Sequence number of the intent (4) */
+#define	JNL_VolID			8	/* Journal: Volume serial number (4) */
+#define	JNL_Cnt				12	/* Journal: Number of sectors, 0:intent done (4) */
+#define	JNL_Ent				16	/* Journal: Home sector and checksum of each slot (8 each) */
 
 #define	DIR_Name			0	/* Short file name (11) */
 #define	DIR_Attr			11	/* Attribute (1) */
@@ -524,19 +542,18 @@ static WCHAR LfnBuf[_MAX_LFN+1];
 /* String functions                                                      */
 /*-----------------------------------------------------------------------*/
 
+#if _WORD_ACCESS == 1
+/* Word access memory functions, see MemUtil.c */
+#define mem_cpy(dst,src,cnt)	MemCopy(dst,src,cnt)
+#define mem_set(dst,val,cnt)	MemFill(dst,val,cnt)
+#define mem_cmp(dst,src,cnt)	MemCompare(dst,src,cnt)
+#else
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, UINT cnt) {
 	BYTE *d = (BYTE*)dst;
 	const BYTE *s = (const BYTE*)src;
 
-#if _WORD_ACCESS == 1
-	while (cnt >= sizeof(int)) {
-		*(int*)d = *(int*)s;
-		d += sizeof(int); s += sizeof(int);
-		cnt -= sizeof(int);
-	}
-#endif
 	while (cnt--)
 		*d++ = *s++;
 }
@@ -559,6 +576,7 @@ int mem_cmp (const void* dst, const void* src, UINT cnt) {
 	while (cnt-- && (r = *d++ - *s++) == 0) ;
 	return r;
 }
+#endif
 
 /* Check if chr is contained in the string */
 static
@@ -711,6 +729,222 @@ void clear_lock (	/* Clear lock entries of the volume */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Write back the window                                                 */
+/*-----------------------------------------------------------------------*/
+#if !_FS_READONLY
+static
+FRESULT write_home (	/* Write the window to a sector and its FAT copies */
+	FATFS *fs,		/* File system object */
+	DWORD sect		/* Home sector of the window contents */
+)
+{
+	BYTE nf;
+
+
+	if (disk_write(fs->drv, fs->win, sect, 1) != RES_OK)
+		return FR_DISK_ERR;
+	if (sect >= fs->fatbase && sect < fs->fatbase + fs->fsize) {	/* In FAT area */
+		for (nf = fs->n_fats; nf > 1; nf--) {	/* Reflect the change to all FAT copies */
+			sect += fs->fsize;
+			disk_write(fs->drv, fs->win, sect, 1);
+		}
+	}
+
+	return FR_OK;
+}
+
+
+#if _FS_JOURNAL
+/* The FAT, directory and FSInfo sectors that an operation changes are not
+/  written to their home location while the operation runs, but into the
+/  slots of a journal in the reserved area in front of the FAT.  sync()
+/  commits them as one intent: It writes the journal header with the home
+/  sectors (the commit point), copies the slots home and marks the intent
+/  done.  chk_mounted() replays an intent whose copy has been interrupted,
+/  an intent without header is discarded.  An operation that changes more
+/  than _FS_JOURNAL sectors is committed in parts. */
+
+static
+DWORD jnl_chksum (	/* Checksum of a journal sector */
+	const BYTE *buf,	/* Sector data */
+	UINT cnt			/* Number of bytes (multiple of 4) */
+)
+{
+	DWORD sum = 0;
+
+
+	for ( ; cnt; cnt -= 4, buf += 4)
+		sum = ((sum << 1) | (sum >> 31)) + LD_DWORD(buf);
+
+	return sum;
+}
+
+
+static
+FRESULT jnl_header (	/* Write the journal header from the window */
+	FATFS *fs,		/* File system object */
+	UINT cnt		/* Number of sectors of the intent, 0:intent done */
+)
+{
+	UINT i;
+
+
+	mem_set(fs->win, 0, SS(fs));
+	ST_DWORD(fs->win+JNL_Sig, JNL_SIGNATURE);
+	if (cnt) fs->jnl_seq++;
+	ST_DWORD(fs->win+JNL_Seq, fs->jnl_seq);
+	ST_DWORD(fs->win+JNL_VolID, fs->jnl_vsn);
+	ST_DWORD(fs->win+JNL_Cnt, cnt);
+	for (i = 0; i < cnt; i++) {
+		ST_DWORD(fs->win+JNL_Ent+i*8, fs->jnl_sect[i]);
+		ST_DWORD(fs->win+JNL_Ent+i*8+4, fs->jnl_sum[i]);
+	}
+	ST_DWORD(fs->win+SS(fs)-4, jnl_chksum(fs->win, SS(fs)-4));
+
+	return disk_write(fs->drv, fs->win, fs->jnl_base, 1) == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+
+
+static
+FRESULT jnl_copy (	/* Copy the committed intent home and mark it done */
+	FATFS *fs		/* File system object */
+)
+{
+	UINT i;
+
+
+	fs->winsect = 0;	/* The window is used as buffer */
+	for (i = 0; i < fs->jnl_cnt; i++) {
+		if (disk_read(fs->drv, fs->win, fs->jnl_base + 1 + i, 1) != RES_OK)
+			return FR_DISK_ERR;
+		if (write_home(fs, fs->jnl_sect[i]) != FR_OK)
+			return FR_DISK_ERR;
+	}
+	if (jnl_header(fs, 0) != FR_OK)
+		return FR_DISK_ERR;
+	fs->jnl_cnt = 0;
+
+	return FR_OK;
+}
+
+
+static
+FRESULT jnl_commit (	/* Commit the journal as one intent */
+	FATFS *fs		/* File system object */
+)
+{
+	if (!fs->jnl_cnt) return FR_OK;
+	fs->winsect = 0;
+	if (jnl_header(fs, fs->jnl_cnt) != FR_OK)	/* Commit point */
+		return FR_DISK_ERR;
+
+	return jnl_copy(fs);
+}
+
+
+static
+FRESULT jnl_put (	/* Write the window into the journal */
+	FATFS *fs		/* File system object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < fs->jnl_cnt && fs->jnl_sect[i] != fs->winsect; i++) ;	/* Slot of the sector, or a new one */
+	if (i == _FS_JOURNAL) return FR_DISK_ERR;	/* (A commit has failed) */
+	if (disk_write(fs->drv, fs->win, fs->jnl_base + 1 + i, 1) != RES_OK)
+		return FR_DISK_ERR;
+	fs->jnl_sect[i] = fs->winsect;
+	fs->jnl_sum[i] = jnl_chksum(fs->win, SS(fs));
+	if (i == fs->jnl_cnt && ++fs->jnl_cnt == _FS_JOURNAL)	/* Journal full: commit the intent so far */
+		return jnl_commit(fs);
+
+	return FR_OK;
+}
+
+
+static
+DWORD jnl_where (	/* Sector that holds the current contents of a sector */
+	FATFS *fs,		/* File system object */
+	DWORD sect		/* Home sector */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < fs->jnl_cnt; i++) {
+		if (fs->jnl_sect[i] == sect) return fs->jnl_base + 1 + i;
+	}
+
+	return sect;
+}
+
+
+static
+FRESULT jnl_mount (	/* Locate the journal and replay an interrupted intent */
+	FATFS *fs,		/* File system object, the window holds the boot sector */
+	DWORD nrsv		/* Number of reserved sectors */
+)
+{
+	UINT i, cnt;
+	DWORD sect, vend;
+
+
+	fs->jnl_vsn = LD_DWORD(fs->win+BS_VolID32);
+	if (nrsv < JNL_MIN_RSV) return FR_OK;		/* No space for the journal */
+	fs->jnl_base = fs->fatbase - (_FS_JOURNAL + 1);
+
+	if (disk_read(fs->drv, fs->win, fs->jnl_base, 1) != RES_OK)
+		return FR_DISK_ERR;
+	if (LD_DWORD(fs->win+JNL_Sig) != JNL_SIGNATURE
+		|| LD_DWORD(fs->win+SS(fs)-4) != jnl_chksum(fs->win, SS(fs)-4)
+		|| LD_DWORD(fs->win+JNL_VolID) != fs->jnl_vsn)
+		return FR_OK;							/* No header of this volume */
+	fs->jnl_seq = LD_DWORD(fs->win+JNL_Seq);
+	cnt = LD_DWORD(fs->win+JNL_Cnt);
+	if (cnt > _FS_JOURNAL) return jnl_header(fs, 0);
+	vend = fs->database + (fs->n_fatent - 2) * fs->csize;
+	for (i = 0; i < cnt; i++) {
+		sect = LD_DWORD(fs->win+JNL_Ent+i*8);
+		if (sect != fs->fsi_sector && (sect < fs->fatbase || sect >= vend))
+			return jnl_header(fs, 0);			/* (Not a metadata sector) */
+		fs->jnl_sect[i] = sect;
+		fs->jnl_sum[i] = LD_DWORD(fs->win+JNL_Ent+i*8+4);
+	}
+
+	for (i = 0; i < cnt; i++) {				/* Check all slots before the first one is copied */
+		if (disk_read(fs->drv, fs->win, fs->jnl_base + 1 + i, 1) != RES_OK)
+			return FR_DISK_ERR;
+		if (jnl_chksum(fs->win, SS(fs)) != fs->jnl_sum[i])
+			return jnl_header(fs, 0);			/* Discard the intent */
+	}
+	fs->jnl_cnt = (BYTE)cnt;
+
+	return cnt ? jnl_copy(fs) : FR_OK;		/* Replay the intent */
+}
+#endif
+
+
+static
+FRESULT write_window (	/* Write back the window */
+	FATFS *fs		/* File system object */
+)
+{
+#if _FS_JOURNAL
+	if (fs->jnl_base) return jnl_put(fs);
+#endif
+	return write_home(fs, fs->winsect);
+}
+#endif
+
+#if !_FS_JOURNAL
+#define	jnl_where(fs, sect)	(sect)
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Change window offset                                                  */
 /*-----------------------------------------------------------------------*/
@@ -728,20 +962,13 @@ FRESULT move_window (
 	if (wsect != sector) {	/* Changed current window */
 #if !_FS_READONLY
 		if (fs->wflag) {	/* Write back dirty window if needed */
-			if (disk_write(fs->drv, fs->win, wsect, 1) != RES_OK)
+			if (write_window(fs) != FR_OK)
 				return FR_DISK_ERR;
 			fs->wflag = 0;
-			if (wsect < (fs->fatbase + fs->fsize)) {	/* In FAT area */
-				BYTE nf;
-				for (nf = fs->n_fats; nf > 1; nf--) {	/* Reflect the change to all FAT copies */
-					wsect += fs->fsize;
-					disk_write(fs->drv, fs->win, wsect, 1);
-				}
-			}
 		}
 #endif
 		if (sector) {
-			if (disk_read(fs->drv, fs->win, sector, 1) != RES_OK)
+			if (disk_read(fs->drv, fs->win, jnl_where(fs, sector), 1) != RES_OK)
 				return FR_DISK_ERR;
 			fs->winsect = sector;
 		}
@@ -765,11 +992,19 @@ FRESULT sync (	/* FR_OK: successful, FR_DISK_ERR: failed */
 	FRESULT res;
 
 
+#if _FS_JOURNAL
+	if (fs->wflag && !fs->jnl_cnt && !fs->fsi_flag && fs->winsect >= fs->fatbase + fs->fsize) {
+		/* A single directory sector does not need the journal */
+		if (write_home(fs, fs->winsect) != FR_OK)
+			return FR_DISK_ERR;
+		fs->wflag = 0;
+	}
+#endif
 	res = move_window(fs, 0);
 	if (res == FR_OK) {
 		/* Update FSInfo sector if needed */
 		if (fs->fs_type == FS_FAT32 && fs->fsi_flag) {
-			fs->winsect = 0;
+			fs->winsect = fs->fsi_sector;
 			/* Create FSInfo structure */
 			mem_set(fs->win, 0, 512);
 			ST_WORD(fs->win+BS_55AA, 0xAA55);
@@ -778,9 +1013,15 @@ FRESULT sync (	/* FR_OK: successful, FR_DISK_ERR: failed */
 			ST_DWORD(fs->win+FSI_Free_Count, fs->free_clust);
 			ST_DWORD(fs->win+FSI_Nxt_Free, fs->last_clust);
 			/* Write it into the FSInfo sector */
-			disk_write(fs->drv, fs->win, fs->fsi_sector, 1);
+			write_window(fs);
+			fs->winsect = 0;
 			fs->fsi_flag = 0;
 		}
+#if _FS_JOURNAL
+		/* Commit the journal */
+		if (jnl_commit(fs) != FR_OK)
+			res = FR_DISK_ERR;
+#endif
 		/* Make sure that no pending write process in the physical drive */
 		if (disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK)
 			res = FR_DISK_ERR;
@@ -1148,9 +1389,9 @@ FRESULT dir_next (	/* FR_OK:Succeeded, FR_NO_FILE:End of table, FR_DENIED:EOT an
 					if (move_window(dj->fs, 0)) return FR_DISK_ERR;	/* Flush active window */
 					mem_set(dj->fs->win, 0, SS(dj->fs));			/* Clear window buffer */
 					dj->fs->winsect = clust2sect(dj->fs, clst);	/* Cluster start sector */
-					for (c = 0; c < dj->fs->csize; c++) {		/* Fill the new cluster with 0 */
-						dj->fs->wflag = 1;
-						if (move_window(dj->fs, 0)) return FR_DISK_ERR;
+					for (c = 0; c < dj->fs->csize; c++) {		/* Fill the new cluster with 0 (directly, it is still free on the disk) */
+						if (disk_write(dj->fs->drv, dj->fs->win, dj->fs->winsect, 1) != RES_OK)
+							return FR_DISK_ERR;
 						dj->fs->winsect++;
 					}
 					dj->fs->winsect -= c;						/* Rewind window address */
@@ -2052,6 +2293,11 @@ FRESULT chk_mounted (	/* FR_OK(0): successful, !=0: any error occurred */
 	/* Following code attempts to mount the volume. (analyze BPB and initialize the fs object) */
 
 	fs->fs_type = 0;					/* Clear the file system object */
+#if _FS_JOURNAL
+	fs->jnl_base = 0;					/* No journal, discard an uncommitted intent */
+	fs->jnl_seq = 0;
+	fs->jnl_cnt = 0;
+#endif
 	fs->drv = LD2PD(vol);				/* Bind the logical drive and a physical drive */
 	stat = disk_initialize(fs->drv);	/* Initialize low level disk I/O layer */
 	if (stat & STA_NOINIT)				/* Check if the initialization succeeded */
@@ -2138,6 +2384,10 @@ FRESULT chk_mounted (	/* FR_OK(0): successful, !=0: any error occurred */
 	if (fmt == FS_FAT32) {
 	 	fs->fsi_flag = 0;
 		fs->fsi_sector = bsect + LD_WORD(fs->win+BPB_FSInfo);
+#if _FS_JOURNAL
+		if (jnl_mount(fs, nrsv) != FR_OK)	/* Replay an interrupted intent */
+			return FR_DISK_ERR;
+#endif
 		if (disk_read(fs->drv, fs->win, fs->fsi_sector, 1) == RES_OK &&
 			LD_WORD(fs->win+BS_55AA) == 0xAA55 &&
 			LD_DWORD(fs->win+FSI_LeadSig) == 0x41615252 &&
@@ -3299,11 +3549,12 @@ FRESULT f_mkdir (
 				if (dj.fs->fs_type == FS_FAT32 && pcl == dj.fs->dirbase)
 					pcl = 0;
 				ST_CLUST(dir+SZ_DIR, pcl);
-				for (n = dj.fs->csize; n; n--) {	/* Write dot entries and clear following sectors */
-					dj.fs->winsect = dsc++;
-					dj.fs->wflag = 1;
-					res = move_window(dj.fs, 0);
-					if (res != FR_OK) break;
+				for (n = dj.fs->csize; n; n--) {	/* Write dot entries and clear following sectors (directly, the cluster is not linked yet) */
+					dj.fs->winsect = dsc;
+					if (disk_write(dj.fs->drv, dir, dsc++, 1) != RES_OK) {
+						res = FR_DISK_ERR;
+						break;
+					}
 					mem_set(dir, 0, SS(dj.fs));
 				}
 			}
@@ -3566,7 +3817,7 @@ FRESULT f_mkfs (
 	static const WORD vst[] = { 1024,   512,  256,  128,   64,    32,   16,    8,    4,    2,   0};
 	static const WORD cst[] = {32768, 16384, 8192, 4096, 2048, 16384, 8192, 4096, 2048, 1024, 512};
 	BYTE fmt, md, sys, *tbl, pdrv, part;
-	DWORD n_clst, vs, n, wsect;
+	DWORD n_clst, vs, n, wsect, sz_blk;
 	UINT i;
 	DWORD b_vol, b_fat, b_dir, b_data;	/* LBA */
 	DWORD n_vol, n_rsv, n_fat, n_dir;	/* Size */
@@ -3592,6 +3843,10 @@ FRESULT f_mkfs (
 	if (disk_ioctl(pdrv, GET_SECTOR_SIZE, &SS(fs)) != RES_OK || SS(fs) > _MAX_SS)
 		return FR_DISK_ERR;
 #endif
+	/* Get erase block size, reduced to a power of 2 (1 if unknown) */
+	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &sz_blk) != RES_OK || !sz_blk) sz_blk = 1;
+	sz_blk &= ~sz_blk + 1;						/* Largest power of 2 that divides the erase block */
+	if (sz_blk > 32768) sz_blk = 32768;
 	if (_MULTI_PARTITION && part) {
 		/* Get partition information from partition table in the MBR */
 		if (disk_read(pdrv, fs->win, 0, 1) != RES_OK) return FR_DISK_ERR;
@@ -3604,7 +3859,7 @@ FRESULT f_mkfs (
 		/* Create a partition in this function */
 		if (disk_ioctl(pdrv, GET_SECTOR_COUNT, &n_vol) != RES_OK || n_vol < 128)
 			return FR_DISK_ERR;
-		b_vol = (sfd) ? 0 : 63;		/* Volume start sector */
+		b_vol = (sfd) ? 0 : (sz_blk > 63) ? sz_blk : 63;	/* Volume start sector (on erase block boundary) */
 		n_vol -= b_vol;				/* Volume size */
 	}
 
@@ -3640,8 +3895,7 @@ FRESULT f_mkfs (
 	if (n_vol < b_data + au - b_vol) return FR_MKFS_ABORTED;	/* Too small volume */
 
 	/* Align data start sector to erase block boundary (for flash memory media) */
-	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &n) != RES_OK || !n || n > 32768) n = 1;
-	n = (b_data + n - 1) & ~(n - 1);	/* Next nearest erase block from current data start */
+	n = (b_data + sz_blk - 1) & ~(sz_blk - 1);	/* Next nearest erase block from current data start */
 	n = (n - b_data) / N_FATS;
 	if (fmt == FS_FAT32) {		/* FAT32: Move FAT offset */
 		n_rsv += n;
@@ -3674,15 +3928,18 @@ FRESULT f_mkfs (
 		} else {	/* Create partition table (FDISK) */
 			mem_set(fs->win, 0, SS(fs));
 			tbl = fs->win+MBR_Table;	/* Create partiton table for single partition in the drive */
-			tbl[1] = 1;						/* Partition start head */
-			tbl[2] = 1;						/* Partition start sector */
-			tbl[3] = 0;						/* Partition start cylinder */
+			n = b_vol / 63 / 255;
+			if (n > 1023) n = 1023;
+			tbl[1] = (BYTE)(b_vol / 63 % 255);	/* Partition start head */
+			tbl[2] = (BYTE)(((n >> 2) & 0xC0) | (b_vol % 63 + 1));	/* Partition start sector */
+			tbl[3] = (BYTE)n;				/* Partition start cylinder */
 			tbl[4] = sys;					/* System type */
 			tbl[5] = 254;					/* Partition end head */
 			n = (b_vol + n_vol) / 63 / 255;
-			tbl[6] = (BYTE)((n >> 2) | 63);	/* Partiiton end sector */
+			if (n > 1023) n = 1023;
+			tbl[6] = (BYTE)(((n >> 2) & 0xC0) | 63);	/* Partiiton end sector */
 			tbl[7] = (BYTE)n;				/* End cylinder */
-			ST_DWORD(tbl+8, 63);			/* Partition start in LBA */
+			ST_DWORD(tbl+8, b_vol);			/* Partition start in LBA */
 			ST_DWORD(tbl+12, n_vol);		/* Partition size in LBA */
 			ST_WORD(fs->win+BS_55AA, 0xAA55);	/* MBR signature */
 			if (disk_write(pdrv, fs->win, 0, 1) != RES_OK)	/* Write it to the MBR sector */
@@ -3782,6 +4039,12 @@ FRESULT f_mkfs (
 		ST_WORD(tbl+BS_55AA, 0xAA55);
 		disk_write(pdrv, tbl, b_vol + 1, 1);	/* Write original (VBR+1) */
 		disk_write(pdrv, tbl, b_vol + 7, 1);	/* Write backup (VBR+7) */
+#if _FS_JOURNAL
+		if (n_rsv >= JNL_MIN_RSV) {				/* Clear the journal header */
+			mem_set(tbl, 0, SS(fs));
+			disk_write(pdrv, tbl, b_fat - (_FS_JOURNAL + 1), 1);
+		}
+#endif
 	}
 
 	return (disk_ioctl(pdrv, CTRL_SYNC, 0) == RES_OK) ? FR_OK : FR_DISK_ERR;
@@ -7,6 +7,15 @@
 /
 /----------------------------------------------------------------------------*
 Revision History:
+2026-10-19,agent Added _FS_JOURNAL, a write-ahead journal of 8 sectors in
+		the reserved area makes FAT updates power-cut safe.
+2026-10-19,agent Set _WORD_ACCESS to 1, the field access macros of MemUtil.h
+		are safe for unaligned addresses and fall back to byte access
+		on CPUs without unaligned word access.
+2026-10-19,agent Set _USE_MKFS to 1 again, the SD-Card can now be formatted
+		on the device, see DiskFormat() in microsd.c.
+2026-10-19,agent Set _USE_FASTSEEK to 1 to allow cluster link map tables,
+		see FileLinkMapCreate() in microsd.c and LogFileRead().
 2015-03-08,rage	Set _USE_MKFS to 0 as we do not require to format an SD-Card,
 		set _CODE_PAGE to 1250 for "Central Europe".
 */
@@ -44,7 +53,7 @@ Revision History:
 /* To enable string functions, set _USE_STRFUNC to 1 or 2. */
 
 
-#define	_USE_MKFS	0	/* 0:Disable or 1:Enable */
+#define	_USE_MKFS	1	/* 0:Disable or 1:Enable */
 /* To enable f_mkfs function, set _USE_MKFS to 1 and set _FS_READONLY to 0 */
 
 
@@ -52,7 +61,7 @@ Revision History:
 /* To enable f_forward function, set _USE_FORWARD to 1 and set _FS_TINY to 1. */
 
 
-#define	_USE_FASTSEEK	0	/* 0:Disable or 1:Enable */
+#define	_USE_FASTSEEK	1	/* 0:Disable or 1:Enable */
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
@@ -152,12 +161,23 @@ Revision History:
 /  should be added to the disk_ioctl functio. */
 
 
+#ifndef _FS_JOURNAL
+#define	_FS_JOURNAL	8	/* 0:Disable or >=1:Number of journal slots */
+#endif
+/* When _FS_JOURNAL is not 0, the metadata sectors that are changed by one
+/  operation are written to a journal in the reserved area of a FAT32 volume,
+/  and copied to their home location after the journal header has been
+/  written.  An interrupted copy is replayed at mount time.  The value is the
+/  number of sectors one intent can hold, the journal needs _FS_JOURNAL + 1
+/  reserved sectors in front of the FAT.  It requires _FS_READONLY 0. */
+
+
 
 /*---------------------------------------------------------------------------/
 / System Configurations
 /----------------------------------------------------------------------------*/
 
-#define _WORD_ACCESS	0	/* 0 or 1 */
+#define _WORD_ACCESS	1	/* 0 or 1 */
 /* Set 0 first and it is always compatible with all platforms. The _WORD_ACCESS
 /  option defines which access method is used to the word data on the FAT volume.
 /
@@ -7,12 +7,17 @@
  * This application consists of the following modules:
  * - main.c - Initialization code and main execution loop.
  * - DMA_ControlBlock.c - Control structures for the DMA channels.
+ * - DmaMgr.c - DMA channel manager, allocates channels for all drivers.
+ * - Command.c - Serial command interpreter for commands via the LEUART.
  * - Control.c - Sequence Control module.
  * - CfgData.c - Handling of configuration data.
  * - ExtInt.c - External interrupt handler.
  * - Keys.c - Key interrupt handling and translation.
  * - AlarmClock.c - Alarm clock and timers facility.
  * - DCF77.c - DCF77 Atomic Clock Decoder
+ * - GNSS.c - GNSS receiver as time source, together with the NMEA parser
+ *   "Nmea.c", for boxes out of DCF77 reach.
+ * - TimeSource.c - Common part of the time sources, sets the system clock.
  * - clock.c - An implementation of the POSIX time() function.
  * - LCD_DOGM162.c - Driver for the DOGM162 LC-Display.
  * - DisplayMenu.c - Display manager for Menus and LCD.
@@ -29,6 +34,8 @@
  *   provides an implementation of a FAT file system on the @ref SD_Card.
  * - Logging.c - Logging facility to send messages to the LEUART and store
  *   them into a file on the SD-Card.
+ * - MemUtil.c - Memory functions with word access for FatFs and the drivers.
+ * - LogAuth.c - Authentication of the log file with an AES-CMAC per block.
  * - eeprom_emulation.c - Routines to store data in Flash, taken from AN0019.
  * - PowerFail.c - Handler to switch off all loads in case of Power Fail.
  *
@@ -66,6 +73,24 @@
  *
  ****************************************************************************//*
 Revision History:
+2026-10-19,agent Measure the boot time for ClockRestore(), documented the clock
+		record at the end of the SRAM in the memory map, and that it
+		requires CLOCK_INHERIT and a booter that keeps this range.
+2026-10-19,agent Documented the configuration variables of the battery log.
+2026-10-19,agent Documented the configuration variables of the log rate limit.
+2026-10-19,agent Documented the configuration variables of the load shedding.
+2026-10-19,agent Documented the configuration variables of the energy budgets.
+2026-10-19,agent Restore the clock after a soft reset via ClockRestore(), and
+		save it in Reboot() immediately before the reset.
+2026-10-19,agent Initialize and enable the GNSS time source if GNSS_TIME_SOURCE
+		is set.
+2026-10-19,agent Call MemUtilBench() if MEM_UTIL_BENCH is set.
+2026-10-19,agent Initialize the log authentication after the control module.
+2026-10-19,agent Documented the trigger file FORMAT.TXT.
+2026-10-19,agent Call CmdCheck() from the main loop to execute commands
+		received via the LEUART.
+2026-10-19,agent Initialize the DMA channel manager before the LEUART, log
+		DMA channel statistics when a new SD-Card has been mounted.
 2020-05-12,rage	Call CheckAlarmTimes() after CONFIG.TXT has been read.
 2018-10-09,rage	Moved DMA related variables to module "DMA_ControlBlock.c".
 		Calling VerifyConfiguration() ensures data is valid.
@@ -92,6 +117,7 @@ Revision History:
  * <tr><td>0x10000000</td> <td>Start of SRAM when accessed as Code</td></tr>
  * <tr><td>0x10003FFF</td> <td>End of 16KB SRAM when accessed as Code</td></tr>
  * <tr><td>0x20000000</td> <td>Start of SRAM when accessed as Data</td></tr>
+ * <tr><td>0x20003FE0</td> <td>Clock record kept across a reset (32 bytes)</td></tr>
  * <tr><td>0x20003FFF</td> <td>End of 16KB SRAM when accessed as Data</td></tr>
  * </table></center>
  *
@@ -121,6 +147,26 @@ Revision History:
  * If the define is 0, the receiver remains switched on, but the LED will only
  * get active again when the time signal gets out-of-sync.<br>
  *
+ * @subsection GNSS_Time_Source GNSS Time Source
+ * Boxes that cannot receive the DCF77 signal can use a GNSS receiver instead,
+ * see define @ref GNSS_TIME_SOURCE.  It is switched on after power-up and once
+ * per day at 03:05, and switched off as soon as the system clock has been set
+ * on its PPS pulse.  Whichever time source synchronizes first switches the
+ * other one off.  Command <b>DIAG</b> logs the time to sync and the energy per
+ * sync of both sources.
+ *
+ * @subsection Clock_Keep Clock across Reset
+ * If the define @ref CLOCK_INHERIT is 1, the current time is kept in a RAM
+ * section which is not initialized by the startup code.  After a reset that
+ * did not power down the MCU, e.g. a firmware update, the watchdog, or a
+ * fault, the system clock is restored immediately and the log shows "Clock
+ * inherited after reset".  The time sources still synchronize the clock as
+ * after power-up, and the first synchronization after a software reset
+ * measures the time of the booter.<br>
+ * This requires a booter that does not use the clock record at the end of
+ * the SRAM.  The booter is not part of this project, so the define is 0 by
+ * default.
+ *
  * @subsection RFID_Reader RFID Reader
  * The RFID reader is used to receive the transponder number of the bird.
  * The module can be configured as Short Range (SR) or Long Range (LR) reader
@@ -186,6 +232,12 @@ Revision History:
  * which contains the configuration for the feeder.  Have a look at the example
  * configuration file for a description of all possible variables defined in
  * @ref l_CfgVarList.
+ * If the SD-Card contains a file <b>FORMAT.TXT</b>, the card is formatted
+ * when it is mounted, see DiskFormatRequest().  All files are erased, so
+ * CONFIG.TXT must be copied to the SD-Card again afterwards.
+ * If a key has been set with the command KEY, every block of log data is
+ * followed by a line <b>#MAC</b> with its AES-CMAC, see LogAuth.c.  The
+ * host tool LogMac verifies the log files with the key of the box.
  * - Removing an SD-Card
  *   -# Generate a log message by some action, e.g. with a transponder, or by
  *      asserting the <i>Set-Key</i> to force a LogFlush().
@@ -263,6 +315,7 @@ Revision History:
  * -# The logging facility is initialized and the firmware version is logged
  * -# Further hardware initialization (Keys, DCF77, RFID reader,
  *    SD-Card interface, Interrupts, Alarm Clock)
+ * -# After a soft reset the system clock is restored, see @ref Clock_Keep
  * -# The LC-Display is activated and the firmware version is shown
  * -# LEDs are switched off after 4 seconds
  * -# The Battery Monitor is initialized
@@ -360,6 +413,68 @@ Revision History:
  * @subsection CALIBRATE_mA UA1/UA2_CALIBRATE_mA
  * Calibration reference current for @ref Power_Outputs UA1 and UA2, specified
  * in [mA].
+ *
+ * @subsection ENERGY_BUDGET UA1/UA2_ENERGY_BUDGET
+ * Optional daily energy budget for @ref Power_Outputs UA1 and UA2 in [mWh].
+ * The energy is integrated from the measured voltage and current.  When the
+ * budget is used up, the output is switched off until @ref ENERGY_RESET_TIME,
+ * and an error is logged.  A value of 0 (default) disables the budget.
+ *
+ * @subsection ENERGY_WARN_LEVEL ENERGY_WARN_LEVEL
+ * A warning is logged when this percentage of a daily energy budget has been
+ * used.  Default is 80%.
+ *
+ * @subsection ENERGY_RESET_TIME ENERGY_RESET_TIME
+ * Time in MEZ when the energy used by UA1 and UA2 is logged, the counters
+ * are reset, and outputs that have been cut off are switched on again if
+ * this is within their on-times.  Default is 00:00.
+ *
+ * @subsection SHED_TIERS SHED_SOC_n, SHED_RUNTIME_n
+ * Thresholds of the load shedding tiers 1 to 4 for the relative state of
+ * charge in [%] and the runtime to empty in [h], as reported by the battery
+ * controller.  A tier is entered when one of its thresholds is reached:
+ * tier 1 reduces the duty cycle of the RFID reader, tier 2 switches off all
+ * other @ref Power_Outputs, tier 3 flushes the log less often, and tier 4
+ * also switches off the RFID reader.  A value of 0 (default) disables a
+ * threshold.
+ *
+ * @subsection SHED_HYSTERESIS SHED_SOC_HYSTERESIS, SHED_RUNTIME_HYSTERESIS
+ * A tier is left when the state of charge exceeds its threshold by this
+ * number of percentage points (default 5), and the runtime exceeds its
+ * threshold by this percentage (default 25%).
+ *
+ * @subsection SHED_RFID_DUTY SHED_RFID_DUTY
+ * On-duration of the RFID reader in load shedding tier 1 and above, in [%]
+ * of its configured on-duration.  Default is 50%.
+ *
+ * @subsection SHED_FLUSH_PAUSE SHED_FLUSH_PAUSE
+ * Minimum pause in [s] between two log flushes in load shedding tier 3 and
+ * above.  Default is 300s.
+ *
+ * @subsection LOG_RATE LOG_RATE, LOG_BURST
+ * Rate limit of the log messages of the source modules, see LogRate.c.
+ * A module may log LOG_BURST messages at once (default 30), and LOG_RATE
+ * messages per minute in the long run.  Further messages are suppressed and
+ * summarized with their date and time when the module has become quiet
+ * again.  Default is LOG_RATE = 0, i.e. no limit.  LOG_RATE does not apply
+ * to the data and command sources RFID, BATTERY, CONTROL, and COMMAND.
+ *
+ * @subsection LOG_RATE_SRC LOG_RATE_\<source\>
+ * Rate limit of a single source module in messages per minute, e.g.
+ * LOG_RATE_RFID.  Default is 0, i.e. LOG_RATE is used, or no limit for
+ * the data and command sources.
+ *
+ * @subsection BATTERY_LOG_DIFF BATTERY_LOG_\<value\>_DIFF
+ * Minimum change of a battery value before the periodic battery report logs
+ * it again, see BatLog.c: BATTERY_LOG_CAPACITY_DIFF in [mAh] (default 100),
+ * BATTERY_LOG_RUNTIME_DIFF in [%] of the logged runtime (default 10),
+ * BATTERY_LOG_VOLTAGE_DIFF in [mV] (default 100), and
+ * BATTERY_LOG_CURRENT_DIFF in [mA] (default 50).  A value of 0 logs the
+ * value with every report.
+ *
+ * @subsection BATTERY_LOG_KEYFRAME BATTERY_LOG_KEYFRAME
+ * Interval in [h] to log all battery values regardless of their change
+ * (default 24h).
  */
 /*=============================== Header Files ===============================*/
 
@@ -371,6 +486,7 @@ Revision History:
 #include "config.h"		// include project configuration parameters
 #include "ExtInt.h"
 #include "DCF77.h"
+#include "GNSS.h"
 #include "Keys.h"
 #include "RFID.h"
 #include "AlarmClock.h"
@@ -381,8 +497,12 @@ Revision History:
 #include "DM_PowerTimes.h"
 #include "LCD_DOGM162.h"
 #include "LEUART.h"
+#include "DmaMgr.h"
+#include "Command.h"
 #include "BatteryMon.h"
 #include "Logging.h"
+#include "LogAuth.h"
+#include "MemUtil.h"
 #include "CfgData.h"
 #include "Control.h"
 #include "PowerFail.h"
@@ -391,6 +511,11 @@ Revision History:
 #include "diskio.h"	// DSTATUS
 #include "microsd.h"
 
+/*=============================== Definitions ================================*/
+
+    /*!@brief Source module of the log messages of this file. */
+#define LOG_SOURCE	LOG_SRC_MAIN
+
 /*================================ Global Data ===============================*/
 
 extern PRJ_INFO const  prj;		// Project Information
@@ -437,6 +562,9 @@ static const EXTI_INIT  l_ExtIntCfg[] =
 {   //	IntBitMask,	IntFct
     {	KEY_EXTI_MASK,	KeyHandler		},	// Keys
     {	DCF_EXTI_MASK,	DCF77Handler		},	// DCF77
+#if GNSS_TIME_SOURCE
+    {	GNSS_EXTI_MASK,	GNSSPpsHandler		},	// GNSS PPS
+#endif
     {	PF_EXTI_MASK,	PowerFailHandler	},	// Power Fail
     {	0,		NULL			}
 };
@@ -496,12 +624,18 @@ int main( void )
     /* Initialize chip - handle erratas */
     CHIP_Init();
 
+    /* Measure the time until ClockRestore(), the RTC is not running yet */
+    ClockBootTimeStart();
+
     /* EFM32 NVIC implementation provides 8 interrupt levels (0~7) */
     NVIC_SetPriorityGrouping (4);	// 8 priority levels, NO sub-priority
 
     /* Set up clocks */
     cmuSetup();
 
+    /* Initialize DMA controller, channels are allocated by the drivers */
+    DmaInit();
+
     /* Init Low Energy UART with 9600bd (this is the maximum) */
     drvLEUART_Init (9600);
 
@@ -536,12 +670,21 @@ int main( void )
 	 CMU_Select_String[CMU_ClockSelectGet(cmuClock_HF)],
 	 freq / 1000000L, (freq % 1000000L) / 1000L);
 
+#if MEM_UTIL_BENCH
+    MemUtilBench();
+#endif
+
     /* Initialize key hardware */
     KeyInit (&l_KeyInit);
 
     /* Initialize DCF77 hardware */
     DCF77Init();
 
+#if GNSS_TIME_SOURCE
+    /* Initialize GNSS hardware */
+    GNSSInit();
+#endif
+
     /* Initialize SD-Card Interface */
     DiskInit();
 
@@ -554,9 +697,15 @@ int main( void )
     /* Initialize the Alarm Clock module */
     AlarmClockInit();
 
+    /* Inherit the time from before the reset, unless it was a power-on */
+    ClockRestore();
+
     /* Initialize control module */
     ControlInit();
 
+    /* Initialize log authentication, uses the EEPROM emulation, too */
+    LogAuthInit();
+
     /* Initialize display - show firmware version */
     MenuInit (l_MainMenus);
     LCD_Printf (1, ">>>> TAMDL <<<<");
@@ -573,6 +722,11 @@ int main( void )
     /* Enable the DCF77 Atomic Clock Decoder */
     DCF77Enable();
 
+#if GNSS_TIME_SOURCE
+    /* Switch the GNSS receiver on, too - the first time source wins */
+    GNSSEnable();
+#endif
+
     /* Enable all other External Interrupts */
     ExtIntEnableAll();
 
@@ -621,6 +775,7 @@ int main( void )
 		Log ("MCU: %s HW-ID: 0x%08lX%08lX",
 		     PART_NUMBER, uniquHi, DEVINFO->UNIQUEL);
 		LogBatteryInfo (BAT_LOG_INFO_VERBOSE);
+		DmaLogStatistics();
 
 		/* Clear (previous) Configuration */
 		ClearConfiguration();
@@ -647,6 +802,9 @@ int main( void )
 	    /* Call sequence control module */
 	    Control();
 
+	    /* Execute a command received via the LEUART */
+	    CmdCheck();
+
 	    /* Check if to flush the log buffer */
 	    LogFlushCheck();
 	}
@@ -704,6 +862,9 @@ static void cmuSetup(void)
     /* Start HFXO and wait until it is stable */
     CMU_OscillatorEnable(cmuOsc_HFXO, true, true);
 
+    /* Account the boot time with the HFRCO frequency before switching */
+    ClockBootTimeLap();
+
     /* Select HFXO as clock source for HFCLK */
     CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
 
@@ -754,6 +915,9 @@ int	n, i;
     BatteryMonDeinit();
     RFID_PowerOff();
     DCF77Disable();
+#if GNSS_TIME_SOURCE
+    GNSSDisable();
+#endif
 
     drvLEUART_puts ("Shutting down system for reboot\n");
 
@@ -785,6 +949,9 @@ int	n, i;
 	    DelayTick();
     }
 
+    /* Keep the current time, see ClockRestore() */
+    ClockSave();
+
     /* Perform RESET */
     NVIC_SystemReset();
 }
@@ -0,0 +1,320 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Battery Log Volume Comparison
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool compares the log volume of the battery module before and
+ * after the change-only battery logging, by replaying the battery reports of
+ * a log file that has been recorded in the field.  The values are selected by
+ * the firmware's own policy, see BatLog.c.
+ *
+ * Usage:
+ * @code
+ * BatDelta [-c <mAh>] [-r <runtime%>] [-u <mV>] [-i <mA>] [-k <h>] [-v]
+ *	    <BOXnnnn.TXT>
+ * @endcode
+ *
+ * A battery report is a sequence of log entries that start with "Battery ".
+ * Before, every line of a report has been logged.  After, the identity lines
+ * of a report are only kept when it follows a new log file ("MCU: ..."), or
+ * the serial number differs from the one that has been logged last.  The
+ * four dynamic values go through BatLogSelect(), a report with identity
+ * lines is a key frame.  The options set the minimum changes of the
+ * remaining capacity, the runtime to empty, the voltage, the current, and
+ * the key frame interval, they default to the defaults of the firmware.
+ * Option <b>-v</b> prints the selected values of every report.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LogParse.h"
+#include "BatLog.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Maximum number of lines of one battery report. */
+#define MAX_REPORT_LINES	16
+
+/*!@brief One battery report, see addLine() */
+typedef struct
+{
+    int		Lines;		//!< Number of lines
+    int		Len[MAX_REPORT_LINES];	//!< Length of every line
+    int		Val[MAX_REPORT_LINES];	//!< BAT_VAL of the line, or -1
+    int32_t	Value[END_BAT_VAL];	//!< Dynamic values of the report
+    uint32_t	Serial;		//!< Serial number, 0 if not reported
+    uint32_t	Sec;		//!< Time of the report in [s]
+    bool	flgMount;	//!< Report follows a new log file
+} REPORT;
+
+/*!@brief Log volume of the battery module */
+typedef struct
+{
+    uint32_t	Lines;		//!< Number of lines
+    uint32_t	Bytes;		//!< Number of bytes
+} VOLUME;
+
+/*================================ Local Data ================================*/
+
+    /* Minimum changes and key frame interval, see Control.h */
+static BAT_LOG_CFG l_Cfg =
+{
+    { 100, 10, 100, 50 },	// Diff [mAh], [%], [mV], [mA]
+    24				// KeyFrame [h]
+};
+
+    /* Values of the last log */
+static BAT_LOG_STATE l_State;
+
+    /* Serial number that has been logged last */
+static uint32_t	l_Serial;
+
+    /* Log volume before and after */
+static VOLUME	l_Old, l_New;
+static uint32_t	l_Reports, l_KeyFrames;
+
+    /* Verbose output */
+static bool	l_flgVerbose;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void	addLine (REPORT *pRep, const char *line, const LP_ENTRY *pEntry);
+static void	replay (REPORT *pRep);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+char	 line[LOG_LINE_MAX_SIZE];
+const char *pMsg;
+int64_t	 firstDay = -1, lastDay = 0;
+double	 days;
+bool	 flgMount = false;
+REPORT	 rep;
+LP_ENTRY entry;
+FILE	*fp;
+int	 i;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (i + 1 >= argc)
+	    usage();
+	else if (strcmp (argv[i], "-c") == 0)
+	    l_Cfg.Diff[BAT_VAL_CAPACITY] = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-r") == 0)
+	    l_Cfg.Diff[BAT_VAL_RUNTIME] = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-u") == 0)
+	    l_Cfg.Diff[BAT_VAL_VOLTAGE] = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-i") == 0)
+	    l_Cfg.Diff[BAT_VAL_CURRENT] = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-k") == 0)
+	    l_Cfg.KeyFrame = atoi (argv[++i]);
+	else
+	    usage();
+    }
+
+    if (i != argc - 1  ||  l_Cfg.KeyFrame < 1)
+	usage();
+
+    fp = fopen (argv[i], "r");
+    if (fp == NULL)
+    {
+	perror (argv[i]);
+	return 1;
+    }
+
+    BatLogReset (&l_State);
+    memset (&rep, 0, sizeof(rep));
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	if (! LogParseLine (line, &entry)  ||  entry.Date == 0)
+	    continue;
+
+	if (firstDay < 0)
+	    firstDay = LogParseDayNumber (entry.Date);
+	lastDay = LogParseDayNumber (entry.Date);
+
+	pMsg = line + 20;
+	if (entry.Seq >= 0)
+	    pMsg += LOG_SEQ_DIGITS + 2;
+
+	if (strncmp (pMsg, "Battery ", 8) == 0)
+	{
+	    if (rep.Lines == 0)
+	    {
+		rep.flgMount = flgMount;
+		rep.Sec = (uint32_t)(LogParseDayNumber (entry.Date) * 86400
+				     + entry.MilliSec / 1000);
+	    }
+	    addLine (&rep, line, &entry);
+	    flgMount = false;
+	    continue;
+	}
+
+	/* Any other entry ends a report */
+	if (rep.Lines > 0)
+	    replay (&rep);
+
+	if (strncmp (pMsg, "MCU: ", 5) == 0)
+	    flgMount = true;
+    }
+
+    if (rep.Lines > 0)
+	replay (&rep);
+
+    fclose (fp);
+
+    if (l_Reports == 0)
+    {
+	fprintf (stderr, "%s: No battery reports found\n", argv[i]);
+	return 1;
+    }
+
+    days = (double)(lastDay - firstDay + 1);
+    printf ("Battery reports: %u in %.0f days, %u key frames\n", l_Reports,
+	    days, l_KeyFrames);
+    printf ("Minimum changes: %u mAh, %u%% runtime, %u mV, %u mA,"
+	    " key frame every %u h\n\n", l_Cfg.Diff[BAT_VAL_CAPACITY],
+	    l_Cfg.Diff[BAT_VAL_RUNTIME], l_Cfg.Diff[BAT_VAL_VOLTAGE],
+	    l_Cfg.Diff[BAT_VAL_CURRENT], l_Cfg.KeyFrame);
+    printf ("                 lines/day   bytes/day\n");
+    printf ("Every report   %10.1f  %10.1f\n", l_Old.Lines / days,
+	    l_Old.Bytes / days);
+    printf ("Change-only    %10.1f  %10.1f\n", l_New.Lines / days,
+	    l_New.Bytes / days);
+    printf ("Reduction      %9.1f%%  %9.1f%%\n",
+	    100.0 - 100.0 * l_New.Lines / l_Old.Lines,
+	    100.0 - 100.0 * l_New.Bytes / l_Old.Bytes);
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Line to a Battery Report
+ *
+ * Records the length of the line, and its value if it is one of the four
+ * dynamic values.  The serial number is taken from the identity lines.
+ *
+ ******************************************************************************/
+static void	addLine (REPORT *pRep, const char *line, const LP_ENTRY *pEntry)
+{
+const char *pSerial;
+int	 n;
+
+
+    if (pRep->Lines >= MAX_REPORT_LINES)
+    {
+	replay (pRep);			// split an overlong report
+	pRep->flgMount = false;
+    }
+
+    if (pRep->Lines == 0)
+    {
+	for (n = 0;  n < END_BAT_VAL;  n++)
+	    pRep->Value[n] = BAT_LOG_NO_VALUE;
+	pRep->Serial = 0;
+    }
+
+    switch (pEntry->Kind)
+    {
+	case LP_BAT_CAPACITY:	n = BAT_VAL_CAPACITY;	break;
+	case LP_BAT_RUNTIME:	n = BAT_VAL_RUNTIME;	break;
+	case LP_BAT_VOLTAGE:	n = BAT_VAL_VOLTAGE;	break;
+	case LP_BAT_CURRENT:	n = BAT_VAL_CURRENT;	break;
+	default:		n = -1;			break;
+    }
+
+    if (n >= 0)
+	pRep->Value[n] = pEntry->B;
+
+    pSerial = strstr (line, "Battery Serial Number     : ");
+    if (pSerial != NULL)
+	pRep->Serial = (uint32_t)strtoul (pSerial + 28, NULL, 0);
+
+    pRep->Len[pRep->Lines] = (int)strlen (line);
+    pRep->Val[pRep->Lines] = n;
+    pRep->Lines++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Replay a Battery Report
+ *
+ * Adds the report to the volume before, and the selected lines to the volume
+ * after the change-only logging.  The report is cleared afterwards.
+ *
+ ******************************************************************************/
+static void	replay (REPORT *pRep)
+{
+uint32_t mask, keyTime;
+bool	 flgIdentity, flgValid;
+int	 i;
+
+
+    flgIdentity = (pRep->flgMount
+		   ||  (pRep->Serial != 0  &&  pRep->Serial != l_Serial));
+    if (pRep->Serial != 0)
+	l_Serial = pRep->Serial;
+
+    if (flgIdentity)
+	BatLogReset (&l_State);
+
+    flgValid = l_State.flgValid;
+    keyTime = l_State.KeyTime;
+    mask = BatLogSelect (&l_Cfg, &l_State, pRep->Value, pRep->Sec);
+    if (! flgValid  ||  l_State.KeyTime != keyTime)
+	l_KeyFrames++;
+
+    for (i = 0;  i < pRep->Lines;  i++)
+    {
+	l_Old.Lines++;
+	l_Old.Bytes += pRep->Len[i];
+
+	if (pRep->Val[i] < 0 ? flgIdentity : (mask & (1 << pRep->Val[i])) != 0)
+	{
+	    l_New.Lines++;
+	    l_New.Bytes += pRep->Len[i];
+	}
+    }
+
+    if (l_flgVerbose)
+	printf ("%10u %s%s%s%s%s\n", pRep->Sec, flgIdentity ? " ID" : "",
+		mask & (1 << BAT_VAL_CAPACITY) ? " capacity" : "",
+		mask & (1 << BAT_VAL_RUNTIME)  ? " runtime"  : "",
+		mask & (1 << BAT_VAL_VOLTAGE)  ? " voltage"  : "",
+		mask & (1 << BAT_VAL_CURRENT)  ? " current"  : "");
+
+    l_Reports++;
+    pRep->Lines = 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Show Usage
+ *
+ ******************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: BatDelta [-c <mAh>] [-r <runtime%%>] [-u <mV>]"
+	     " [-i <mA>] [-k <h>] [-v]\n"
+	     "\t<BOXnnnn.TXT>\n");
+    exit (1);
+}
@@ -0,0 +1,817 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Battery Swap Planner
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool predicts for every box of a season when its battery will
+ * be empty, and lists the boxes in the order their batteries have to be
+ * swapped.
+ *
+ * Usage:
+ * @code
+ * BatPlan [-j <threads>] [-m <min_mAh>] [-d <YYYYMMDD>] [-v] <BOXnnnn.TXT>...
+ * @endcode
+ *
+ * The log files are parsed in parallel by <i>threads</i> workers (default:
+ * number of CPUs).  From each file the tool extracts the battery reports
+ * ("Battery Remaining Capacity", "Runtime to empty") and the power output
+ * switching events, and fits a consumption model per box:
+ *
+ * @code
+ * consumed_mAh = Base * hours + Out[UA1] * onHours[UA1]
+ *			       + Out[UA2] * onHours[UA2] + Out[BATT] * ...
+ * @endcode
+ *
+ * The model is fitted by least squares over the intervals between battery
+ * reports.  Since the gauge updates its capacity in steps, consecutive
+ * reports are merged until an interval spans at least @ref MIN_SPAN_H hours.
+ * A battery swap is recognized by a capacity increase of more than
+ * @ref SWAP_STEP_MAH, intervals never cross a swap.
+ *
+ * The daily consumption is predicted from the output schedule of the last
+ * @ref SCHED_DAYS days, i.e. the on-hours the outputs actually had, so a
+ * changed configuration file is taken into account as soon as it is in
+ * effect.  The battery is regarded as empty when it reaches <i>min_mAh</i>
+ * (default @ref DEF_MIN_MAH).  The 95% confidence interval combines the
+ * uncertainty of the fitted coefficients with the scatter of the daily
+ * consumption.
+ *
+ * The output is the swap route: all boxes ordered by the lower bound of the
+ * interval, with the predicted date and the number of days from the plan
+ * date <i>YYYYMMDD</i> (default: the latest battery report of all files).
+ *
+ * Validation: for every battery that was swapped within the log, the model
+ * is fitted with the data available halfway through the life of this
+ * battery, and the predicted date is compared with the date of the swap.
+ * The mean and mean absolute error, and the fraction of swaps that fell
+ * into the confidence interval are printed at the end.  Option <b>-v</b>
+ * lists every validated swap.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Minimum span of a fit interval in [h]. */
+#define MIN_SPAN_H	20.0
+
+    /*!@brief Capacity increase in [mAh] that indicates a battery swap. */
+#define SWAP_STEP_MAH	1000
+
+    /*!@brief Default capacity in [mAh] at which a battery is regarded empty. */
+#define DEF_MIN_MAH	500
+
+    /*!@brief Number of days to derive the output schedule from. */
+#define SCHED_DAYS	7
+
+    /*!@brief Minimum number of intervals for a fit. */
+#define MIN_INTERVALS	3
+
+    /*!@brief Maximum number of worker threads. */
+#define MAX_THREADS	64
+
+    /*!@brief Quantile of the normal distribution for 95% confidence. */
+#define Z_95		1.96
+
+    /*!@brief Number of model coefficients: base load and one per output. */
+#define NUM_COEF	(1 + LP_NUM_OUT)
+
+/*!@brief One battery report */
+typedef struct
+{
+    double	Hours;		//!< Time in [h] since day 0
+    int32_t	Capacity;	//!< Remaining capacity in [mAh]
+    double	OnHours[LP_NUM_OUT]; //!< Cumulative on-hours of the outputs
+} SAMPLE;
+
+/*!@brief Fitted consumption model */
+typedef struct
+{
+    bool	Valid;		//!< Model could be fitted
+    int		Intervals;	//!< Number of intervals used
+    double	Coef[NUM_COEF];	//!< Base [mA] and output currents [mA]
+    double	Cov[NUM_COEF][NUM_COEF]; //!< Covariance of the coefficients
+    double	DaySigma;	//!< Scatter of the daily consumption in [mAh]
+    double	SpanDays;	//!< Average length of an interval in [d]
+} MODEL;
+
+/*!@brief Prediction for one battery */
+typedef struct
+{
+    double	PerDay;		//!< Predicted consumption in [mAh/day]
+    double	Days;		//!< Days until empty
+    double	DaysLo;		//!< Lower bound of the confidence interval
+    double	DaysHi;		//!< Upper bound of the confidence interval
+} PREDICT;
+
+/*!@brief Validation result of one swap */
+typedef struct
+{
+    double	Error;		//!< Predicted minus actual swap time in [d]
+    bool	Covered;	//!< Actual swap within the confidence interval
+} CHECK;
+
+/*!@brief Data and result of one box */
+typedef struct
+{
+    const char *Path;		//!< Log file
+    int		BoxNum;		//!< Box number, -1 if unknown
+    bool	Failed;		//!< File could not be read
+    SAMPLE     *pSample;	//!< Battery reports
+    int		NumSample;	//!< Number of battery reports
+    int		MaxSample;	//!< Allocated number of reports
+    int32_t	GaugeMin;	//!< Last runtime to empty of the gauge [min]
+    MODEL	Model;		//!< Model fitted over all data
+    PREDICT	Pred;		//!< Prediction for the current battery
+    CHECK      *pCheck;		//!< Validation of swapped batteries
+    int		NumCheck;	//!< Number of validated swaps
+} BOX;
+
+/*================================ Local Data ================================*/
+
+    /* Verbose output */
+static bool	l_flgVerbose;
+
+    /* Capacity in [mAh] at which a battery is regarded empty */
+static int32_t	l_MinCapacity = DEF_MIN_MAH;
+
+    /* All boxes and index of the next box to be processed by a worker */
+static BOX     *l_pBox;
+static int	l_NumBox;
+static int	l_NextBox;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void    *worker (void *arg);
+static void	readBox (BOX *pBox);
+static void	addSample (BOX *pBox, double hours, int32_t capacity,
+			   const double *pOnHours);
+static int	batteryStart (const BOX *pBox, int end);
+static bool	fitModel (const SAMPLE *pSample, int end, MODEL *pModel);
+static bool	predict (const MODEL *pModel, const SAMPLE *pSample, int last,
+			 PREDICT *pPred);
+static void	validate (BOX *pBox);
+static bool	solve (double a[NUM_COEF][NUM_COEF], const bool *pUse,
+		       double inv[NUM_COEF][NUM_COEF]);
+static int	cmpRoute (const void *p1, const void *p2);
+static uint32_t	hoursToDate (double hours);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+pthread_t thread[MAX_THREADS];
+int	 numThreads = (int)sysconf (_SC_NPROCESSORS_ONLN);
+uint32_t planDate = 0;
+double	 planHours = 0.0, sumErr = 0.0, sumAbsErr = 0.0;
+struct timespec start, end;
+BOX	**ppRoute;
+BOX	*pBox;
+int	 i, n, numChecks = 0, numCovered = 0, result = 0;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (strcmp (argv[i], "-j") == 0  &&  i + 1 < argc)
+	    numThreads = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-m") == 0  &&  i + 1 < argc)
+	    l_MinCapacity = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-d") == 0  &&  i + 1 < argc)
+	    planDate = (uint32_t)strtoul (argv[++i], NULL, 10);
+	else
+	    usage();
+    }
+
+    if (i >= argc)
+	usage();
+
+    if (numThreads < 1)
+	numThreads = 1;
+    if (numThreads > MAX_THREADS)
+	numThreads = MAX_THREADS;
+
+    l_NumBox = argc - i;
+    l_pBox = calloc (l_NumBox, sizeof(BOX));
+    ppRoute = calloc (l_NumBox, sizeof(BOX *));
+    if (l_pBox == NULL  ||  ppRoute == NULL)
+    {
+	fprintf (stderr, "Out of memory\n");
+	return 1;
+    }
+    for (n = 0;  n < l_NumBox;  n++)
+	l_pBox[n].Path = argv[i + n];
+
+    /* Parse the files and fit the models in parallel */
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    if (numThreads > l_NumBox)
+	numThreads = l_NumBox;
+    for (n = 0;  n < numThreads;  n++)
+    {
+	if (pthread_create (&thread[n], NULL, worker, NULL) != 0)
+	{
+	    fprintf (stderr, "Can't create worker thread\n");
+	    return 1;
+	}
+    }
+    for (n = 0;  n < numThreads;  n++)
+	pthread_join (thread[n], NULL);
+    clock_gettime (CLOCK_MONOTONIC, &end);
+
+    /* Plan date defaults to the latest battery report */
+    if (planDate != 0)
+    {
+	planHours = LogParseDayNumber (planDate) * 24.0;
+    }
+    else
+    {
+	for (n = 0;  n < l_NumBox;  n++)
+	{
+	    pBox = &l_pBox[n];
+	    if (pBox->NumSample > 0
+	    &&  pBox->pSample[pBox->NumSample - 1].Hours > planHours)
+		planHours = pBox->pSample[pBox->NumSample - 1].Hours;
+	}
+	planDate = hoursToDate (planHours);
+    }
+
+    /* Swap route, ordered by the earliest date a battery may be empty */
+    for (n = 0;  n < l_NumBox;  n++)
+	ppRoute[n] = &l_pBox[n];
+    qsort (ppRoute, l_NumBox, sizeof(BOX *), cmpRoute);
+
+    printf ("Swap route, planned %08u, empty at %d mAh\n\n", planDate,
+	    (int)l_MinCapacity);
+    printf ("%4s %-12s %8s %8s %8s  %-8s  %-18s %6s %6s\n", "Rank", "Box",
+	    "Capacity", "mAh/day", "Reports", "Empty", "95% Interval",
+	    "Days", "Gauge");
+
+    for (n = 0;  n < l_NumBox;  n++)
+    {
+	const SAMPLE *pLast;
+	const char *pName;
+	double	 now;
+
+	pBox = ppRoute[n];
+	if (pBox->Failed)
+	{
+	    result = 1;
+	    continue;
+	}
+	if (pBox->NumSample == 0  ||  pBox->Pred.PerDay <= 0.0)
+	{
+	    printf ("%4d %-12s insufficient data\n", n + 1, pBox->Path);
+	    continue;
+	}
+	pLast = &pBox->pSample[pBox->NumSample - 1];
+	pName = strrchr (pBox->Path, '/');
+	pName = (pName == NULL ? pBox->Path : pName + 1);
+	now = pLast->Hours;
+
+	printf ("%4d %-12s %8d %8.1f %8d  %08u  %08u..%08u %6.1f",
+		n + 1, pName, (int)pLast->Capacity, pBox->Pred.PerDay,
+		pBox->NumSample, hoursToDate (now + pBox->Pred.Days * 24.0),
+		hoursToDate (now + pBox->Pred.DaysLo * 24.0),
+		hoursToDate (now + pBox->Pred.DaysHi * 24.0),
+		(now - planHours) / 24.0 + pBox->Pred.Days);
+	if (pBox->GaugeMin >= 0)
+	    printf (" %6.1f", pBox->GaugeMin / 1440.0);
+	printf ("\n");
+    }
+
+    /* Validation against the swaps found in the logs */
+    for (n = 0;  n < l_NumBox;  n++)
+    {
+	pBox = &l_pBox[n];
+	for (i = 0;  i < pBox->NumCheck;  i++)
+	{
+	    sumErr += pBox->pCheck[i].Error;
+	    sumAbsErr += fabs (pBox->pCheck[i].Error);
+	    if (pBox->pCheck[i].Covered)
+		numCovered++;
+	    numChecks++;
+	}
+    }
+
+    printf ("\nValidation: %d swaps", numChecks);
+    if (numChecks > 0)
+	printf (", mean error %+.2f d, mean abs error %.2f d,"
+		" %.1f%% within interval", sumErr / numChecks,
+		sumAbsErr / numChecks, 100.0 * numCovered / numChecks);
+    printf ("\n%d boxes with %d threads in %.3f s\n", l_NumBox, numThreads,
+	    (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+    return result;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Worker Thread
+ *
+ * Each worker takes the next unprocessed box, reads its log file, fits the
+ * model, and validates it against the swaps of this box.  Boxes are
+ * independent, so no further synchronization is required.
+ *
+ ******************************************************************************/
+static void    *worker (void *arg)
+{
+BOX	*pBox;
+int	 n;
+
+
+    (void) arg;
+
+    while ((n = __sync_fetch_and_add (&l_NextBox, 1)) < l_NumBox)
+    {
+	pBox = &l_pBox[n];
+	readBox (pBox);
+	if (pBox->Failed  ||  pBox->NumSample == 0)
+	    continue;
+
+	if (fitModel (pBox->pSample, pBox->NumSample, &pBox->Model))
+	    predict (&pBox->Model, pBox->pSample, pBox->NumSample - 1,
+		     &pBox->Pred);
+	validate (pBox);
+    }
+
+    return NULL;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read the Battery Reports of a Box
+ *
+ * Extracts the battery reports from the log file and records the
+ * cumulative on-hours of every power output at the time of each report.
+ *
+ ******************************************************************************/
+static void	readBox (BOX *pBox)
+{
+char	 line[LOG_LINE_MAX_SIZE];
+double	 onHours[LP_NUM_OUT], onSince[LP_NUM_OUT], hours;
+LP_ENTRY entry;
+FILE	*fp;
+int	 out;
+
+
+    pBox->BoxNum = LogParseBoxNumber (pBox->Path);
+    pBox->GaugeMin = -1;
+
+    fp = fopen (pBox->Path, "r");
+    if (fp == NULL)
+    {
+	perror (pBox->Path);
+	pBox->Failed = true;
+	return;
+    }
+
+    for (out = 0;  out < LP_NUM_OUT;  out++)
+    {
+	onHours[out] = 0.0;
+	onSince[out] = -1.0;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	if (! LogParseLine (line, &entry)  ||  entry.Date == 0)
+	    continue;
+
+	hours = LogParseDayNumber (entry.Date) * 24.0
+		+ entry.MilliSec / 3600000.0;
+
+	switch (entry.Kind)
+	{
+	    case LP_OUT_ON:
+		if (onSince[entry.A] < 0.0)
+		    onSince[entry.A] = hours;
+		break;
+
+	    case LP_OUT_OFF:
+	    case LP_ALL_OFF:
+		for (out = 0;  out < LP_NUM_OUT;  out++)
+		{
+		    if ((entry.Kind == LP_ALL_OFF  ||  (int)entry.A == out)
+		    &&  onSince[out] >= 0.0)
+		    {
+			onHours[out] += hours - onSince[out];
+			onSince[out] = -1.0;
+		    }
+		}
+		break;
+
+	    case LP_BAT_CAPACITY:
+		for (out = 0;  out < LP_NUM_OUT;  out++)
+		{
+		    if (onSince[out] >= 0.0)	// output is currently on
+		    {
+			onHours[out] += hours - onSince[out];
+			onSince[out] = hours;
+		    }
+		}
+		addSample (pBox, hours, entry.B, onHours);
+		break;
+
+	    case LP_BAT_RUNTIME:
+		pBox->GaugeMin = entry.B;
+		break;
+
+	    default:
+		break;
+	}
+    }
+
+    fclose (fp);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Fit the Consumption Model
+ *
+ * Fits the model over the battery reports [0, end) by least squares.
+ * Output coefficients that cannot be determined, e.g. because an output has
+ * never been switched on, are dropped from the model.
+ *
+ * @return
+ *	<i>true</i> if the model could be fitted.
+ *
+ ******************************************************************************/
+static bool	fitModel (const SAMPLE *pSample, int end, MODEL *pModel)
+{
+double	 ata[NUM_COEF][NUM_COEF], inv[NUM_COEF][NUM_COEF], x[NUM_COEF];
+double	 aty[NUM_COEF], y, res, sumRes2 = 0.0, sumSpan = 0.0;
+bool	 use[NUM_COEF];
+int	 i, j, k, from, num = 0;
+
+
+    memset (pModel, 0, sizeof(*pModel));
+    memset (ata, 0, sizeof(ata));
+    memset (aty, 0, sizeof(aty));
+
+    /* Accumulate the normal equations over all intervals */
+    for (from = 0, i = 1;  i < end;  i++)
+    {
+	if (pSample[i].Capacity > pSample[i - 1].Capacity + SWAP_STEP_MAH)
+	{
+	    from = i;			// battery has been swapped
+	    continue;
+	}
+	if (pSample[i].Hours - pSample[from].Hours < MIN_SPAN_H)
+	    continue;
+
+	x[0] = pSample[i].Hours - pSample[from].Hours;
+	for (k = 0;  k < LP_NUM_OUT;  k++)
+	    x[1 + k] = pSample[i].OnHours[k] - pSample[from].OnHours[k];
+	y = pSample[from].Capacity - pSample[i].Capacity;
+
+	for (j = 0;  j < NUM_COEF;  j++)
+	{
+	    aty[j] += x[j] * y;
+	    for (k = 0;  k < NUM_COEF;  k++)
+		ata[j][k] += x[j] * x[k];
+	}
+	sumSpan += x[0];
+	num++;
+	from = i;
+    }
+
+    if (num < MIN_INTERVALS)
+	return false;
+
+    /* Drop outputs that were never on, then solve */
+    for (j = 0;  j < NUM_COEF;  j++)
+	use[j] = (ata[j][j] > 0.0);
+
+    while (! solve (ata, use, inv))
+    {
+	/* Singular: drop the output with the smallest on-time */
+	for (k = -1, j = 1;  j < NUM_COEF;  j++)
+	    if (use[j]  &&  (k < 0  ||  ata[j][j] < ata[k][k]))
+		k = j;
+	if (k < 0)
+	    return false;
+	use[k] = false;
+    }
+
+    for (j = 0;  j < NUM_COEF;  j++)
+	for (k = 0;  k < NUM_COEF;  k++)
+	    pModel->Coef[j] += inv[j][k] * aty[k];
+
+    /* Residuals, for the scatter and the coefficient covariance */
+    for (from = 0, i = 1;  i < end;  i++)
+    {
+	if (pSample[i].Capacity > pSample[i - 1].Capacity + SWAP_STEP_MAH)
+	{
+	    from = i;
+	    continue;
+	}
+	if (pSample[i].Hours - pSample[from].Hours < MIN_SPAN_H)
+	    continue;
+
+	res = pSample[from].Capacity - pSample[i].Capacity
+	      - pModel->Coef[0] * (pSample[i].Hours - pSample[from].Hours);
+	for (k = 0;  k < LP_NUM_OUT;  k++)
+	    res -= pModel->Coef[1 + k]
+		   * (pSample[i].OnHours[k] - pSample[from].OnHours[k]);
+	sumRes2 += res * res;
+	from = i;
+    }
+
+    for (j = k = 0;  j < NUM_COEF;  j++)
+	if (use[j])
+	    k++;
+    res = (num > k ? sumRes2 / (num - k) : sumRes2);
+
+    for (j = 0;  j < NUM_COEF;  j++)
+	for (k = 0;  k < NUM_COEF;  k++)
+	    pModel->Cov[j][k] = res * inv[j][k];
+
+    /* Scatter of one interval, scaled to one day */
+    pModel->DaySigma = sqrt (res * 24.0 / (sumSpan / num));
+    pModel->SpanDays = sumSpan / num / 24.0;
+    pModel->Intervals = num;
+    pModel->Valid = true;
+
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Predict when a Battery is Empty
+ *
+ * The daily consumption is calculated from the model and the average
+ * on-hours per day of the outputs over the last @ref SCHED_DAYS days of
+ * the battery reports up to <i>last</i>.  The number of days is counted from
+ * report <i>last</i>.
+ *
+ * @return
+ *	<i>true</i> if a prediction could be made.
+ *
+ ******************************************************************************/
+static bool	predict (const MODEL *pModel, const SAMPLE *pSample, int last,
+			 PREDICT *pPred)
+{
+double	 x[NUM_COEF], var = 0.0, span, remain, sigma;
+int	 i, j, k;
+
+
+    memset (pPred, 0, sizeof(*pPred));
+    if (! pModel->Valid)
+	return false;
+
+    /* Output schedule of the last days */
+    for (i = last;  i > 0  &&  pSample[last].Hours - pSample[i - 1].Hours
+		    <= SCHED_DAYS * 24.0;  i--)
+	;
+    span = pSample[last].Hours - pSample[i].Hours;
+    if (span < MIN_SPAN_H)
+	return false;
+
+    x[0] = 24.0;
+    for (k = 0;  k < LP_NUM_OUT;  k++)
+	x[1 + k] = (pSample[last].OnHours[k] - pSample[i].OnHours[k])
+		   * 24.0 / span;
+
+    for (j = 0;  j < NUM_COEF;  j++)
+    {
+	pPred->PerDay += pModel->Coef[j] * x[j];
+	for (k = 0;  k < NUM_COEF;  k++)
+	    var += x[j] * pModel->Cov[j][k] * x[k];
+    }
+    if (pPred->PerDay <= 0.0)
+	return false;
+
+    /*
+     * Over n days, the error of the coefficients adds up linearly, the
+     * scatter of the daily consumption with the square root of n.  As the
+     * capacity is only known at the fit intervals, the time of reaching the
+     * limit has an additional, uniformly distributed error of one interval.
+     */
+    remain = pSample[last].Capacity - l_MinCapacity;
+    if (remain < 0.0)
+	remain = 0.0;
+    pPred->Days = remain / pPred->PerDay;
+    sigma = sqrt ((pPred->Days * pPred->Days * var
+		   + pPred->Days * pModel->DaySigma * pModel->DaySigma)
+		  / (pPred->PerDay * pPred->PerDay)
+		  + pModel->SpanDays * pModel->SpanDays / 12.0);
+    pPred->DaysLo = pPred->Days - Z_95 * sigma;
+    pPred->DaysHi = pPred->Days + Z_95 * sigma;
+    if (pPred->DaysLo < 0.0)
+	pPred->DaysLo = 0.0;
+
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Validate the Model against the Swaps in the Log
+ *
+ * For every battery that has been swapped, the model is fitted with the
+ * reports up to halfway through the life of the battery.  The prediction
+ * from there is compared with the time of the swap, i.e. the middle
+ * between the last report of the old and the first of the new battery.
+ *
+ ******************************************************************************/
+static void	validate (BOX *pBox)
+{
+const SAMPLE *pS = pBox->pSample;
+MODEL	 model;
+PREDICT	 pred;
+double	 swapHours, predHours;
+int	 first, mid, i;
+
+
+    for (i = 1;  i < pBox->NumSample;  i++)
+    {
+	if (pS[i].Capacity <= pS[i - 1].Capacity + SWAP_STEP_MAH)
+	    continue;
+
+	first = batteryStart (pBox, i);
+	swapHours = (pS[i - 1].Hours + pS[i].Hours) / 2.0;
+	for (mid = first;  mid < i - 1
+	     &&  pS[mid].Hours < (pS[first].Hours + pS[i - 1].Hours) / 2.0;
+	     mid++)
+	    ;
+
+	if (! fitModel (pS, mid + 1, &model)
+	||  ! predict (&model, pS, mid, &pred))
+	    continue;
+
+	pBox->pCheck = realloc (pBox->pCheck,
+				(pBox->NumCheck + 1) * sizeof(CHECK));
+	if (pBox->pCheck == NULL)
+	{
+	    fprintf (stderr, "Out of memory\n");
+	    exit (1);
+	}
+
+	predHours = pS[mid].Hours + pred.Days * 24.0;
+	pBox->pCheck[pBox->NumCheck].Error = (predHours - swapHours) / 24.0;
+	pBox->pCheck[pBox->NumCheck].Covered =
+		(swapHours >= pS[mid].Hours + pred.DaysLo * 24.0 - 12.0
+		 &&  swapHours <= pS[mid].Hours + pred.DaysHi * 24.0 + 12.0);
+
+	if (l_flgVerbose)
+	    printf ("%s: swapped %08u, predicted %08u (%+.1f d) on %08u\n",
+		    pBox->Path, hoursToDate (swapHours),
+		    hoursToDate (predHours),
+		    pBox->pCheck[pBox->NumCheck].Error,
+		    hoursToDate (pS[mid].Hours));
+	pBox->NumCheck++;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static void	addSample (BOX *pBox, double hours, int32_t capacity,
+			   const double *pOnHours)
+{
+SAMPLE	*pSample;
+
+
+    if (pBox->NumSample >= pBox->MaxSample)
+    {
+	pBox->MaxSample = (pBox->MaxSample == 0 ? 256 : 2 * pBox->MaxSample);
+	pBox->pSample = realloc (pBox->pSample,
+				 pBox->MaxSample * sizeof(SAMPLE));
+	if (pBox->pSample == NULL)
+	{
+	    fprintf (stderr, "Out of memory\n");
+	    exit (1);
+	}
+    }
+
+    pSample = &pBox->pSample[pBox->NumSample++];
+    pSample->Hours = hours;
+    pSample->Capacity = capacity;
+    memcpy (pSample->OnHours, pOnHours, sizeof(pSample->OnHours));
+}
+
+    /* Index of the first report of the battery that is in use at <end>-1 */
+static int	batteryStart (const BOX *pBox, int end)
+{
+int	 i;
+
+
+    for (i = end - 1;  i > 0;  i--)
+	if (pBox->pSample[i].Capacity
+	    > pBox->pSample[i - 1].Capacity + SWAP_STEP_MAH)
+	    break;
+
+    return (i < 0 ? 0 : i);
+}
+
+    /* Invert the sub-matrix of the used coefficients, Gauss-Jordan */
+static bool	solve (double a[NUM_COEF][NUM_COEF], const bool *pUse,
+		       double inv[NUM_COEF][NUM_COEF])
+{
+double	 m[NUM_COEF][2 * NUM_COEF], f, scale = 0.0;
+int	 idx[NUM_COEF], n, i, j, k, p;
+
+
+    for (n = i = 0;  i < NUM_COEF;  i++)
+	if (pUse[i])
+	    idx[n++] = i;
+    if (n == 0)
+	return false;
+
+    for (i = 0;  i < n;  i++)
+    {
+	for (j = 0;  j < n;  j++)
+	{
+	    m[i][j] = a[idx[i]][idx[j]];
+	    m[i][n + j] = (i == j ? 1.0 : 0.0);
+	}
+	if (m[i][i] > scale)
+	    scale = m[i][i];
+    }
+
+    for (i = 0;  i < n;  i++)
+    {
+	for (p = i, j = i + 1;  j < n;  j++)	// partial pivoting
+	    if (fabs (m[j][i]) > fabs (m[p][i]))
+		p = j;
+	if (fabs (m[p][i]) < scale * 1e-12)
+	    return false;
+	for (j = 0;  j < 2 * n;  j++)
+	{
+	    f = m[i][j];
+	    m[i][j] = m[p][j];
+	    m[p][j] = f;
+	}
+	for (f = m[i][i], j = 0;  j < 2 * n;  j++)
+	    m[i][j] /= f;
+	for (k = 0;  k < n;  k++)
+	{
+	    if (k == i)
+		continue;
+	    for (f = m[k][i], j = 0;  j < 2 * n;  j++)
+		m[k][j] -= f * m[i][j];
+	}
+    }
+
+    memset (inv, 0, sizeof(double) * NUM_COEF * NUM_COEF);
+    for (i = 0;  i < n;  i++)
+	for (j = 0;  j < n;  j++)
+	    inv[idx[i]][idx[j]] = m[i][n + j];
+
+    return true;
+}
+
+    /* Route order: boxes without prediction at the end */
+static int	cmpRoute (const void *p1, const void *p2)
+{
+const BOX *pA = *(const BOX * const *)p1;
+const BOX *pB = *(const BOX * const *)p2;
+double	 a, b;
+
+
+    if ((pA->Pred.PerDay > 0.0) != (pB->Pred.PerDay > 0.0))
+	return (pA->Pred.PerDay > 0.0 ? -1 : 1);
+    if (pA->Pred.PerDay <= 0.0)
+	return pA->BoxNum - pB->BoxNum;
+
+    a = pA->pSample[pA->NumSample - 1].Hours + pA->Pred.DaysLo * 24.0;
+    b = pB->pSample[pB->NumSample - 1].Hours + pB->Pred.DaysLo * 24.0;
+    if (a != b)
+	return (a < b ? -1 : 1);
+    return pA->BoxNum - pB->BoxNum;
+}
+
+static uint32_t	hoursToDate (double hours)
+{
+    return LogParseDayToDate ((int64_t)floor (hours / 24.0));
+}
+
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: BatPlan [-j <threads>] [-m <min_mAh>]"
+	     " [-d <YYYYMMDD>] [-v] <BOXnnnn.TXT>...\n");
+    exit (1);
+}
@@ -0,0 +1,774 @@
+/***************************************************************************//**
+ * @file
+ * @brief	SD-Card Read and Append Benchmark
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool runs the firmware's FatFs and disk I/O layer (ff.c and
+ * diskio.c) against an SD-Card image file.  The routines of microsd.c are
+ * replaced by a simulated card which counts the SPI bytes and commands and
+ * models the access times of the card, so the read path can be compared
+ * with and without read-ahead, see MICROSD_READ_AHEAD, and the append path
+ * can be compared for different file system layouts.
+ *
+ * Usage:
+ * @code
+ * DiskBench [-a <access_us>] [-m <multi_us>] [-c <chunk>]
+ *	     [-u <au_kb>] [-o <open_aus>] [-F <cluster_kb> | -O <cluster_kb>]
+ *	     [-w <record> [-n <records>] | -s <seeks>] <image> <file>
+ * @endcode
+ *
+ * The file is read completely with f_read() for several chunk sizes (or
+ * only with <i>chunk</i> if specified), once without and once with
+ * read-ahead.  For each run, the number of read commands and blocks, the
+ * simulated wall time at 8MHz SPI clock, and the resulting throughput are
+ * printed.  Option <b>-a</b> sets the access time of the card for the first
+ * block of a read command (default 400us), <b>-m</b> the gap between the
+ * blocks of a CMD18 multi-block read (default 30us).
+ *
+ * A full-size firmware update image is 128KB, i.e. the size of the flash.
+ * The image file can be a dump of a real SD-Card, e.g. created by
+ * "dd if=/dev/sdX of=sd.img".
+ *
+ * With option <b>-w</b>, the file is appended instead: <i>records</i>
+ * (default 1000) times <i>record</i> bytes, each followed by f_sync(), like
+ * the log file is written by the firmware.  The mean and maximum latency of
+ * one append are printed besides the totals.  The card is simulated as
+ * flash with allocation units (AU) of <i>au_kb</i> (option <b>-u</b>,
+ * default 4096KB) and pages of 16KB:
+ * - The first block of a command in a new page costs CARD_WRITE_US to
+ *   program the page.
+ * - Writing a page below the highest written page of its AU again costs
+ *   CARD_RMW_US, the card has to copy the page (read-modify-write).
+ * - The card keeps <i>open_aus</i> AUs open (option <b>-o</b>, default 2).
+ *   Writing into another AU costs CARD_SWITCH_US to close the least
+ *   recently used one.
+ *
+ * Option <b>-F</b> formats the image first like DiskFormat() of the
+ * firmware: partition, FAT, and data area aligned to the AU.  Option
+ * <b>-O</b> formats it like a desktop OS without knowing the AU: partition
+ * at sector 63, FAT and data area unaligned.  The image must be a multiple
+ * of 512KB, e.g. created by "truncate -s 1G sd.img".
+ *
+ * With option <b>-s</b>, the file is read back like LogFileRead() of the
+ * firmware does: <i>seeks</i> times a seek to a random offset, a read of
+ * LOG_READ_BYTES, and a seek back to the end of the file, once following
+ * the FAT chain and once via a cluster link map (FatFs fast seek).  The
+ * time to build the map is printed separately.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Added option -s to measure seeks with a cluster link map.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "ff.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Time in [us] to transfer one byte via SPI at 8MHz. */
+#define SPI_BYTE_US	1.0
+
+    /*!@brief Busy time in [us] after CMD12 or after programming a page. */
+#define CARD_BUSY_US	20.0
+#define CARD_WRITE_US	500.0
+
+    /*!@brief Time in [us] to copy a page, and to close an open AU. */
+#define CARD_RMW_US	3000.0
+#define CARD_SWITCH_US	20000.0
+
+    /*!@brief Maximum number of AUs the card keeps open, page size in sectors. */
+#define CARD_OPEN_AUS	8
+#define CARD_PAGE_SEC	32
+
+    /*!@brief Largest chunk size for f_read(). */
+#define MAX_CHUNK	32768
+
+    /*!@brief Bytes read per seek, about one page of log lines. */
+#define LOG_READ_BYTES	1024
+
+    /*!@brief Size of the cluster link map, LINKMAP_SIZE() of 15 fragments. */
+#define LINKMAP_SIZE	32
+
+/*
+ * Stand-in for microsd.h: the definitions diskio.c needs.  Defining the
+ * include guard prevents the firmware header, which requires the EFM32
+ * device headers, from being included.
+ */
+#define __INC_microsd_h
+
+#define CMD0	(0)		//!< GO_IDLE_STATE
+#define CMD1	(1)		//!< SEND_OP_COND
+#define ACMD41	(41 | 0x80)	//!< SEND_OP_COND (SDC)
+#define CMD8	(8)		//!< SEND_IF_COND
+#define CMD9	(9)		//!< SEND_CSD
+#define CMD10	(10)		//!< SEND_CID
+#define CMD12	(12)		//!< STOP_TRANSMISSION
+#define ACMD13	(13 | 0x80)	//!< SD_STATUS (SDC)
+#define CMD16	(16)		//!< SET_BLOCKLEN
+#define CMD17	(17)		//!< READ_SINGLE_BLOCK
+#define CMD18	(18)		//!< READ_MULTIPLE_BLOCK
+#define CMD23	(23)		//!< SET_BLOCK_COUNT
+#define ACMD23	(23 | 0x80)	//!< SET_WR_BLK_ERASE_COUNT (SDC)
+#define CMD24	(24)		//!< WRITE_BLOCK
+#define CMD25	(25)		//!< WRITE_MULTIPLE_BLOCK
+#define CMD58	(58)		//!< READ_OCR
+
+#define MICROSD_CRC_RETRIES	3
+
+#ifndef MICROSD_READ_AHEAD
+    #define MICROSD_READ_AHEAD	1
+#endif
+
+void	 MICROSD_PowerOn (void);
+void	 MICROSD_PowerOff (void);
+void	 MICROSD_Deselect (void);
+int	 MICROSD_Select (void);
+int	 MICROSD_BlockRx (uint8_t *buff, uint32_t btr);
+int	 MICROSD_BlockTx (const uint8_t *buff, uint8_t token);
+uint8_t	 MICROSD_SendCmd (uint8_t cmd, DWORD arg);
+uint8_t	 MICROSD_XferSpi (uint8_t data);
+bool	 MICROSD_CrcEnable (void);
+uint32_t MICROSD_CrcErrorCount (void);
+void	 MICROSD_SpiClkFast (void);
+void	 MICROSD_SpiClkSlow (void);
+bool	 MICROSD_TimeOutElapsed (void);
+void	 MICROSD_TimeOutSet (uint32_t msec);
+
+    /* The disk I/O layer of the firmware, unchanged */
+#include "diskio.c"
+
+/*================================ Local Data ================================*/
+
+    /* SD-Card image */
+static FILE    *l_Img;
+static DWORD	l_ImgSectors;
+
+    /* State of the simulated card */
+static DWORD	l_Addr;		// next sector for BlockRx/BlockTx
+static uint8_t	l_Cmd;		// last command
+static bool	l_FirstBlock;	// next block is the first of a command
+static uint8_t	l_Resp[4];	// trailing response bytes
+static int	l_RespCnt, l_RespIdx;
+
+    /* Timing parameters and simulated time in [us] */
+static double	l_AccessUs = 400.0;
+static double	l_MultiUs = 30.0;
+static double	l_TimeUs;
+
+    /* Flash model of the card, see cardPage() */
+static DWORD	l_AuSec = 8192;	// AU size in sectors
+static int	l_OpenAus = 2;	// number of open AUs
+static DWORD	l_Page;		// page of the previous block of a command
+static bool	l_NoAu;		// ACMD13 fails, the AU is unknown
+static struct
+{
+    DWORD	Au;		// AU number
+    DWORD	Page;		// highest page written in this AU
+    DWORD	Use;		// time of last use for LRU
+    bool	Valid;
+} l_OpenAu[CARD_OPEN_AUS];
+static DWORD	l_UseCnt;
+
+    /* Write statistics */
+static DWORD	l_WrCmds, l_WrBlocks, l_WrPages, l_WrRmw, l_WrSwitch;
+
+    /* Buffer for f_read() */
+static BYTE	l_Buf[MAX_CHUNK];
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	benchRun (const char *file, UINT chunk, BYTE readAhead);
+static int	appendRun (const char *file, UINT record, UINT count);
+static int	seekRun (const char *file, UINT seeks);
+static int	formatImage (UINT clustKB, bool desktop);
+static void	cardPage (DWORD page);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+static const UINT chunks[] = { 16, 128, 512, 4096, MAX_CHUNK };
+FATFS	 fs;
+UINT	 chunk = 0;
+UINT	 record = 0, count = 1000;
+UINT	 seeks = 0;
+UINT	 fmtKB = 0;
+bool	 desktop = false;
+int	 i, c, ra;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (i + 1 >= argc)
+	    usage();
+
+	if (strcmp (argv[i], "-a") == 0)
+	    l_AccessUs = atof (argv[++i]);
+	else if (strcmp (argv[i], "-m") == 0)
+	    l_MultiUs = atof (argv[++i]);
+	else if (strcmp (argv[i], "-c") == 0)
+	    chunk = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-u") == 0)
+	    l_AuSec = atoi (argv[++i]) * 2;
+	else if (strcmp (argv[i], "-o") == 0)
+	    l_OpenAus = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-F") == 0)
+	    fmtKB = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-O") == 0)
+	    fmtKB = atoi (argv[++i]), desktop = true;
+	else if (strcmp (argv[i], "-w") == 0)
+	    record = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-n") == 0)
+	    count = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-s") == 0)
+	    seeks = atoi (argv[++i]);
+	else
+	    usage();
+    }
+
+    /* AU must be 16KB * 2^n, see AU_SIZE in the SD Status register */
+    if (i + 2 != argc  ||  chunk > MAX_CHUNK  ||  record > MAX_CHUNK
+    ||  l_AuSec < 32  ||  l_AuSec > 16384  ||  (l_AuSec & (l_AuSec - 1))
+    ||  l_OpenAus < 1  ||  l_OpenAus > CARD_OPEN_AUS)
+	usage();
+
+    l_Img = fopen (argv[i], "r+b");
+    if (l_Img == NULL)
+    {
+	perror (argv[i]);
+	return 1;
+    }
+    fseek (l_Img, 0, SEEK_END);
+    l_ImgSectors = ftell (l_Img) / 512;
+
+    if (disk_initialize (0) & STA_NOINIT)
+    {
+	fprintf (stderr, "disk_initialize() failed\n");
+	return 1;
+    }
+    f_mount (0, &fs);
+
+    if (fmtKB != 0  &&  formatImage (fmtKB, desktop) != 0)
+	return 1;
+
+    if (seeks != 0)
+    {
+	c = seekRun (argv[i+1], seeks);
+	fclose (l_Img);
+	return c != 0;
+    }
+
+    if (record != 0)
+    {
+	c = appendRun (argv[i+1], record, count);
+	fclose (l_Img);
+	return c != 0;
+    }
+
+    printf ("%-8s %-4s %7s %7s %7s %7s %10s %8s\n", "Chunk", "RA",
+	    "Cmds", "Blocks", "Ahead", "Hits", "Time[ms]", "KB/s");
+
+    for (c = 0;  c < (int)(sizeof(chunks) / sizeof(chunks[0]));  c++)
+    {
+	for (ra = 0;  ra <= 1;  ra++)
+	{
+	    if (benchRun (argv[i+1], chunk != 0 ? chunk : chunks[c], ra) != 0)
+		return 1;
+	}
+	if (chunk != 0)
+	    break;			// only the specified chunk size
+    }
+
+    fclose (l_Img);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read a File once
+ *
+ * This routine reads the specified file with f_read() in pieces of @p chunk
+ * bytes and prints the statistics of the disk I/O layer.
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	benchRun (const char *file, UINT chunk, BYTE readAhead)
+{
+FIL	 fh;
+FRESULT	 res;
+DISK_RDSTAT st;
+DWORD	 total = 0;
+UINT	 br;
+
+
+    disk_ioctl (0, MMC_READ_AHEAD, &readAhead);
+    disk_ioctl (0, MMC_GET_RDSTAT, &st);	// clear statistics
+    l_TimeUs = 0.0;
+
+    res = f_open (&fh, file, FA_READ | FA_OPEN_EXISTING);
+    if (res != FR_OK)
+    {
+	fprintf (stderr, "%s: f_open() error %d\n", file, res);
+	return -1;
+    }
+
+    do
+    {
+	res = f_read (&fh, l_Buf, chunk, &br);
+	if (res != FR_OK)
+	{
+	    fprintf (stderr, "%s: f_read() error %d\n", file, res);
+	    return -1;
+	}
+	total += br;
+    } while (br == chunk);
+
+    f_close (&fh);
+    disk_ioctl (0, MMC_GET_RDSTAT, &st);
+
+    printf ("%-8u %-4s %7u %7u %7u %7u %10.1f %8.1f\n", chunk,
+	    readAhead && MICROSD_READ_AHEAD ? "on" : "off", st.Cmds,
+	    st.Blocks, st.AheadBlocks, st.AheadHits, l_TimeUs / 1000.0,
+	    l_TimeUs > 0.0 ? total / 1.024 / l_TimeUs * 1000.0 : 0.0);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Format the Image
+ *
+ * This routine creates a new file system on the image with f_mkfs(), the
+ * same way as DiskFormat() in microsd.c.  If @p desktop is true, the SD
+ * Status register cannot be read, so f_mkfs() does not know the AU.
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	formatImage (UINT clustKB, bool desktop)
+{
+FRESULT	 res;
+FATFS	*pFs;
+DWORD	 nclst;
+
+
+    l_NoAu = desktop;
+    res = f_mkfs (0, 0, clustKB * 1024);
+    l_NoAu = false;
+    if (res == FR_OK)
+	res = f_getfree ("/", &nclst, &pFs);
+    if (res != FR_OK)
+    {
+	fprintf (stderr, "f_mkfs() error %d\n", res);
+	return -1;
+    }
+
+    printf ("Format: %s, FAT%d, %uKB clusters, FAT at %lu, data at %lu%s\n",
+	    desktop ? "desktop" : "AU aligned",
+	    pFs->fs_type == FS_FAT32 ? 32 : pFs->fs_type == FS_FAT16 ? 16 : 12,
+	    pFs->csize / 2, (unsigned long)pFs->fatbase,
+	    (unsigned long)pFs->database,
+	    pFs->database % l_AuSec ? " (unaligned)" : "");
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Append to a File
+ *
+ * This routine appends @p count records of @p record bytes to the specified
+ * file, each followed by f_sync(), and prints the write statistics and the
+ * latency of one append.
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	appendRun (const char *file, UINT record, UINT count)
+{
+FIL	 fh;
+FRESULT	 res;
+UINT	 n, bw;
+double	 start, lat, latMax = 0.0;
+
+
+    memset (l_Buf, 'L', record);
+    l_WrCmds = l_WrBlocks = l_WrPages = l_WrRmw = l_WrSwitch = 0;
+    l_TimeUs = 0.0;
+
+    res = f_open (&fh, file, FA_WRITE | FA_OPEN_ALWAYS);
+    if (res == FR_OK)
+	res = f_lseek (&fh, f_size(&fh));
+
+    for (n = 0;  n < count  &&  res == FR_OK;  n++)
+    {
+	start = l_TimeUs;
+	res = f_write (&fh, l_Buf, record, &bw);
+	if (res == FR_OK  &&  bw != record)
+	    res = FR_DENIED;		// disk full
+	if (res == FR_OK)
+	    res = f_sync (&fh);
+	lat = l_TimeUs - start;
+	if (lat > latMax)
+	    latMax = lat;
+    }
+
+    if (res != FR_OK)
+    {
+	fprintf (stderr, "%s: append error %d\n", file, res);
+	return -1;
+    }
+    f_close (&fh);
+
+    printf ("%-7s %7s %7s %7s %7s %6s %6s %10s %8s %8s %8s\n", "Record",
+	    "Appends", "Cmds", "Blocks", "Pages", "RMW", "Switch",
+	    "Time[ms]", "KB/s", "Mean[ms]", "Max[ms]");
+    printf ("%-7u %7u %7lu %7lu %7lu %6lu %6lu %10.1f %8.1f %8.2f %8.2f\n",
+	    record, count, (unsigned long)l_WrCmds, (unsigned long)l_WrBlocks,
+	    (unsigned long)l_WrPages, (unsigned long)l_WrRmw,
+	    (unsigned long)l_WrSwitch, l_TimeUs / 1000.0,
+	    (double)record * count / 1.024 / l_TimeUs * 1000.0,
+	    l_TimeUs / count / 1000.0, latMax / 1000.0);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Seek in a File
+ *
+ * This routine reads @p seeks pieces at random offsets of the specified
+ * file and returns to the end of the file after each, once in normal mode
+ * and once via a cluster link map.  The statistics of the disk I/O layer
+ * are printed per mode.
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	seekRun (const char *file, UINT seeks)
+{
+static DWORD map[LINKMAP_SIZE];
+FIL	 fh;
+FRESULT	 res;
+DISK_RDSTAT st;
+BYTE	 readAhead = 0;
+DWORD	 size, pos;
+UINT	 n, br;
+int	 mode;
+double	 tBuild = 0.0;
+
+
+    disk_ioctl (0, MMC_READ_AHEAD, &readAhead);
+
+    res = f_open (&fh, file, FA_READ | FA_OPEN_EXISTING);
+    if (res != FR_OK)
+    {
+	fprintf (stderr, "%s: f_open() error %d\n", file, res);
+	return -1;
+    }
+    size = f_size(&fh);
+
+    printf ("%-6s %7s %7s %7s %10s %10s %10s\n", "Map", "Seeks",
+	    "Cmds", "Blocks", "Time[ms]", "Seek[ms]", "Build[ms]");
+
+    for (mode = 0;  mode <= 1;  mode++)
+    {
+	srand (1);			// same offsets for both modes
+	disk_ioctl (0, MMC_GET_RDSTAT, &st);	// clear statistics
+	l_TimeUs = 0.0;
+
+	if (mode == 1)
+	{
+	    /* Build the map once, like FileLinkMapCreate() */
+	    map[0] = LINKMAP_SIZE;
+	    fh.cltbl = map;
+	    res = f_lseek (&fh, CREATE_LINKMAP);
+	    if (res != FR_OK)
+	    {
+		fprintf (stderr, "%s: link map error %d, %lu fragments\n",
+			 file, res, (unsigned long)(map[0] - 2) / 2);
+		return -1;
+	    }
+	    fh.cltbl = NULL;
+	    tBuild = l_TimeUs;
+	    disk_ioctl (0, MMC_GET_RDSTAT, &st);
+	    l_TimeUs = 0.0;
+	}
+	res = f_lseek (&fh, size);
+
+	for (n = 0;  n < seeks  &&  res == FR_OK;  n++)
+	{
+	    pos = (DWORD)((double)rand() / RAND_MAX * size);
+
+	    fh.cltbl = (mode == 1 ? map : NULL);
+	    res = f_lseek (&fh, pos);
+	    fh.cltbl = NULL;
+	    if (res == FR_OK)
+		res = f_read (&fh, l_Buf, LOG_READ_BYTES, &br);
+
+	    fh.cltbl = (mode == 1 ? map : NULL);
+	    if (res == FR_OK)
+		res = f_lseek (&fh, size);
+	    fh.cltbl = NULL;
+	}
+
+	if (res != FR_OK)
+	{
+	    fprintf (stderr, "%s: seek error %d\n", file, res);
+	    return -1;
+	}
+	disk_ioctl (0, MMC_GET_RDSTAT, &st);
+
+	printf ("%-6s %7u %7u %7u %10.1f %10.2f %10.1f\n",
+		mode == 1 ? "on" : "off", seeks, st.Cmds, st.Blocks,
+		l_TimeUs / 1000.0, l_TimeUs / seeks / 1000.0,
+		tBuild / 1000.0);
+    }
+
+    printf ("File: %lu bytes, %lu fragments\n", (unsigned long)size,
+	    (unsigned long)(map[0] - 2) / 2);
+    f_close (&fh);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Print Usage and exit
+ *
+ ******************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: DiskBench [-a <access_us>] [-m <multi_us>]"
+		     " [-c <chunk>]\n"
+		     "\t\t [-u <au_kb>] [-o <open_aus>]"
+		     " [-F <cluster_kb> | -O <cluster_kb>]\n"
+		     "\t\t [-w <record> [-n <records>] | -s <seeks>]"
+		     " <image> <file>\n");
+    exit (1);
+}
+
+
+//==============================================================================
+//
+//	S I M U L A T E D   S D - C A R D
+//
+//==============================================================================
+
+/******************************************************************************
+ * @brief  Send a command to the card, returns the R1 response
+ *****************************************************************************/
+uint8_t	MICROSD_SendCmd (uint8_t cmd, DWORD arg)
+{
+    l_TimeUs += (1 + 6 + 1) * SPI_BYTE_US;	// wait ready, command, Ncr
+    l_Cmd = cmd;
+    l_RespCnt = l_RespIdx = 0;
+
+    switch (cmd)
+    {
+	case CMD0:
+	    return 1;				// idle state
+
+	case CMD8:
+	    l_Resp[0] = 0x00;  l_Resp[1] = 0x00;	// R7: voltage accepted,
+	    l_Resp[2] = 0x01;  l_Resp[3] = 0xAA;	// check pattern
+	    l_RespCnt = 4;
+	    return 1;
+
+	case CMD58:
+	    l_Resp[0] = 0xC0;  l_Resp[1] = 0xFF;	// OCR: ready, CCS=1
+	    l_Resp[2] = 0x80;  l_Resp[3] = 0x00;
+	    l_RespCnt = 4;
+	    return 0;
+
+	case CMD17:
+	case CMD18:
+	case CMD24:
+	case CMD25:
+	    if (arg >= l_ImgSectors)
+		return 0x40;			// parameter error
+	    if (cmd == CMD24  ||  cmd == CMD25)
+		l_WrCmds++;
+	    l_Addr = arg;
+	    l_FirstBlock = true;
+	    return 0;
+
+	case CMD12:
+	    l_TimeUs += CARD_BUSY_US;
+	    return 0;
+
+	case ACMD13:
+	    return l_NoAu ? 0x04 : 0;		// illegal command
+
+	default:
+	    return 0;
+    }
+}
+
+/******************************************************************************
+ * @brief  Receive a data block from the card
+ *****************************************************************************/
+int	MICROSD_BlockRx (uint8_t *buff, uint32_t btr)
+{
+    if (l_Cmd != CMD17  &&  l_Cmd != CMD18)
+    {
+	memset (buff, 0, btr);			// CSD, CID, SD status
+	l_TimeUs += (btr + 3) * SPI_BYTE_US;
+	if (l_Cmd == CMD9)
+	{
+	    /* CSD Version 2.0, C_SIZE = size / 512KB - 1 */
+	    buff[0] = 0x40;
+	    buff[8] = (uint8_t)((l_ImgSectors / 1024 - 1) >> 8);
+	    buff[9] = (uint8_t)(l_ImgSectors / 1024 - 1);
+	}
+	else if (l_Cmd == ACMD13)
+	{
+	    /* AU_SIZE: 16KB << code */
+	    for (btr = 0;  (32UL << btr) < l_AuSec;  btr++)
+		;
+	    buff[10] = (uint8_t)((btr + 1) << 4);
+	}
+	return 1;
+    }
+
+    if (l_Addr >= l_ImgSectors)
+	return 0;				// out of range
+
+    l_TimeUs += l_FirstBlock ? l_AccessUs : l_MultiUs;
+    l_TimeUs += (1 + btr + 2) * SPI_BYTE_US;	// token, data, CRC16
+    l_FirstBlock = false;
+
+    fseek (l_Img, (long)l_Addr++ * 512, SEEK_SET);
+    if (fread (buff, 1, btr, l_Img) != btr)
+	return 0;
+
+    return 1;
+}
+
+/******************************************************************************
+ * @brief  Send a data block to the card
+ *****************************************************************************/
+int	MICROSD_BlockTx (const uint8_t *buff, uint8_t token)
+{
+    if (token == 0xFD)				// STOP_TRAN token
+    {
+	l_TimeUs += CARD_BUSY_US;
+	return 1;
+    }
+
+    if (l_Addr >= l_ImgSectors)
+	return 0;
+
+    /* Costs of the flash for the first block in a page */
+    if (l_FirstBlock  ||  l_Addr / CARD_PAGE_SEC != l_Page)
+    {
+	l_Page = l_Addr / CARD_PAGE_SEC;
+	cardPage (l_Page);
+    }
+    l_FirstBlock = false;
+    l_WrBlocks++;
+
+    l_TimeUs += (1 + 512 + 2 + 1) * SPI_BYTE_US;
+
+    fseek (l_Img, (long)l_Addr++ * 512, SEEK_SET);
+    if (fwrite (buff, 1, 512, l_Img) != 512)
+	return 0;
+
+    return 1;
+}
+
+/******************************************************************************
+ * @brief  Program a page of the flash, see the file description
+ *****************************************************************************/
+static void	cardPage (DWORD page)
+{
+DWORD	 au = page * CARD_PAGE_SEC / l_AuSec;
+int	 i, lru = 0;
+
+
+    l_WrPages++;
+    for (i = 0;  i < l_OpenAus;  i++)
+    {
+	if (l_OpenAu[i].Valid  &&  l_OpenAu[i].Au == au)
+	    break;
+	if (! l_OpenAu[i].Valid  ||  l_OpenAu[i].Use < l_OpenAu[lru].Use)
+	    lru = i;
+    }
+
+    if (i >= l_OpenAus)
+    {
+	/* Close the least recently used AU, open this one */
+	if (l_OpenAu[lru].Valid)
+	{
+	    l_WrSwitch++;
+	    l_TimeUs += CARD_SWITCH_US;
+	}
+	i = lru;
+	l_OpenAu[i].Valid = true;
+	l_OpenAu[i].Au = au;
+	l_OpenAu[i].Page = page;
+    }
+    else if (page < l_OpenAu[i].Page)
+    {
+	l_WrRmw++;
+	l_TimeUs += CARD_RMW_US;
+    }
+    else
+    {
+	l_OpenAu[i].Page = page;
+    }
+
+    l_OpenAu[i].Use = ++l_UseCnt;
+    l_TimeUs += CARD_WRITE_US;
+}
+
+/******************************************************************************
+ * @brief  Transfer one byte via SPI
+ *****************************************************************************/
+uint8_t	MICROSD_XferSpi (uint8_t data)
+{
+    (void) data;
+
+    l_TimeUs += SPI_BYTE_US;
+    if (l_RespIdx < l_RespCnt)
+	return l_Resp[l_RespIdx++];
+
+    return 0xFF;
+}
+
+    /* Routines without effect on the simulated card */
+void	 MICROSD_PowerOn (void)		{ }
+void	 MICROSD_PowerOff (void)	{ }
+void	 MICROSD_SpiClkFast (void)	{ }
+void	 MICROSD_SpiClkSlow (void)	{ }
+void	 MICROSD_TimeOutSet (uint32_t msec)	{ (void) msec; }
+bool	 MICROSD_TimeOutElapsed (void)	{ return false; }
+bool	 MICROSD_CrcEnable (void)	{ return true; }
+uint32_t MICROSD_CrcErrorCount (void)	{ return 0; }
+int	 MICROSD_Select (void)		{ return 1; }
+void	 MICROSD_Deselect (void)	{ l_TimeUs += SPI_BYTE_US; }
+
+/******************************************************************************
+ * @brief  Timestamp for FatFs, not used for reading
+ *****************************************************************************/
+DWORD	get_fattime (void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
@@ -0,0 +1,375 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Energy Budget Simulator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool validates the energy integration of the firmware, see
+ * Energy.c, against simulated load profiles of a power output.
+ *
+ * Usage:
+ * @code
+ * EnergySim [-p <profile>] [-d <days>] [-s <scan_ms>] [-b <budget_mWh>]
+ *	     [-w <warn_level>] [-r <seed>] [-v]
+ * @endcode
+ *
+ * The load is simulated in steps of 1ms.  The true energy is the sum of
+ * voltage times current of all steps.  The firmware side is modeled like
+ * Control.c: while the output is on, and @ref FOLLOW_UP_TIME seconds after
+ * it has been switched off, the ADC scans the four channels I1, I2, U1, U2,
+ * each for <i>scan_ms</i> milliseconds (default 1000).  A channel value is
+ * the average over its scan window, rounded to [mV] and [mA].  After every
+ * conversion of U1, EnergyAdd() is called with the time since the previous
+ * call in RTC ticks.
+ *
+ * Profiles:
+ * - <b>camera</b> (default): on from 05:00 to 15:00 in a cycle of 600s with
+ *   300s on, 2A inrush for 300ms, 450mA idle, and video recordings of 1.2A
+ *   for 5 to 60 seconds at random times.
+ * - <b>const</b>: on all day with 500mA.
+ * - <b>pulse</b>: on all day, 100ms pulses of 1.5A every 1.7s over 80mA.
+ * - <b>faulty</b>: like camera, but the camera hangs in recording mode.
+ *
+ * The voltage of the output drops by 0.4V per Ampere from 12V.  For every
+ * day the true and the integrated energy and the error are printed.  With a
+ * budget given by <b>-b</b>, the output is cut off like EnergyCheck() does,
+ * and the time of the warning and the cut-off are compared with the times
+ * the true energy reached the same levels.  Because the load is cut off by
+ * the firmware, the true energy reaches the budget only if the firmware is
+ * late, so the true energy at the cut-off is printed, too.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Energy.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Same value as DFLT_MEASURE_FOLLOW_UP_TIME of the firmware. */
+#define FOLLOW_UP_TIME	60
+
+    /*!@brief Milliseconds per day. */
+#define MS_PER_DAY	(86400L * 1000)
+
+    /*!@brief Number of scanned ADC channels: I1, I2, U1, U2. */
+#define SCAN_CHANNELS	4
+
+    /*!@brief Load profiles. */
+typedef enum
+{
+    PROFILE_CAMERA,
+    PROFILE_CONST,
+    PROFILE_PULSE,
+    PROFILE_FAULTY,
+    NUM_PROFILES
+} PROFILE;
+
+/*================================ Local Data ================================*/
+
+static const char *l_ProfileName[NUM_PROFILES] =
+{ "camera", "const", "pulse", "faulty" };
+
+    /* Options */
+static PROFILE	l_Profile = PROFILE_CAMERA;
+static long	l_ScanMs = 1000;
+static bool	l_flgVerbose;
+
+    /* Random number generator state */
+static uint64_t	l_Rand = 88172645463325252ULL;
+
+    /* State of the camera profile */
+static long	l_RecEnd;		// end of the current recording [ms]
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	outputScheduled (long ms);
+static uint32_t	loadCurrent (long ms, long onSince);
+static double	randUniform (void);
+static void	printTime (const char *pText, long ms);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+ENERGY	 energy;
+ENERGY_STATE state, prevState;
+long	 days = 7, budget = 0, warnLevel = 80;
+long	 day, ms, onSince = -1, measureEnd = -1, scanStart = -1;
+long	 warnTrue, cutTrue, warnFw, cutFw;
+uint32_t ticks, prevTicks = 0, mA, mV, valI = 0;
+double	 trueUWs, cutPct = 0.0, sumU, sumI, err, maxErr = 0.0, sumTrue = 0.0, sumFw = 0.0;
+int	 i, chan;
+bool	 flgOn, flgCutOff, flgMeasure;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (strcmp (argv[i], "-p") == 0  &&  i + 1 < argc)
+	{
+	    i++;
+	    for (l_Profile = 0;  l_Profile < NUM_PROFILES;  l_Profile++)
+		if (strcmp (argv[i], l_ProfileName[l_Profile]) == 0)
+		    break;
+	    if (l_Profile >= NUM_PROFILES)
+		usage();
+	}
+	else if (strcmp (argv[i], "-d") == 0  &&  i + 1 < argc)
+	    days = atol (argv[++i]);
+	else if (strcmp (argv[i], "-s") == 0  &&  i + 1 < argc)
+	    l_ScanMs = atol (argv[++i]);
+	else if (strcmp (argv[i], "-b") == 0  &&  i + 1 < argc)
+	    budget = atol (argv[++i]);
+	else if (strcmp (argv[i], "-w") == 0  &&  i + 1 < argc)
+	    warnLevel = atol (argv[++i]);
+	else if (strcmp (argv[i], "-r") == 0  &&  i + 1 < argc)
+	    l_Rand ^= strtoull (argv[++i], NULL, 10) * 2654435761ULL;
+	else
+	    usage();
+    }
+    if (i < argc  ||  days < 1  ||  l_ScanMs < 52  ||  l_ScanMs > 2200
+    ||  budget < 0  ||  warnLevel < 1  ||  warnLevel > 100)
+	usage();
+
+    printf ("Profile %s, scan %ldms per channel, budget %ldmWh, warning at"
+	    " %ld%%\n", l_ProfileName[l_Profile], l_ScanMs, budget, warnLevel);
+    printf ("Day  True[mWh]  Firmware[mWh]  Error\n");
+
+    memset (&energy, 0, sizeof(energy));
+    energy.Budget = (uint32_t)budget;
+
+    for (day = 0;  day < days;  day++)
+    {
+	/* the reset time is 00:00, see EnergyResetBudgets() */
+	EnergyReset (&energy);
+	flgCutOff = false;
+	prevState = ENERGY_OK;
+	trueUWs = 0.0;
+	warnTrue = cutTrue = warnFw = cutFw = -1;
+	sumU = sumI = 0.0;
+
+	for (ms = 0;  ms < MS_PER_DAY;  ms++)
+	{
+	    /* switch the output according to the schedule */
+	    flgOn = outputScheduled (ms)  &&  ! flgCutOff;
+	    if (flgOn  &&  onSince < 0)
+	    {
+		onSince = ms;
+		if (measureEnd < 0)
+		    scanStart = ms;		// ADC_ScanStart()
+		measureEnd = -1;
+		prevTicks = (uint32_t)((day * MS_PER_DAY + ms) * 32768 / 1000);
+		EnergyStart (&energy);
+	    }
+	    else if (! flgOn  &&  onSince >= 0)
+	    {
+		onSince = -1;
+		measureEnd = ms + FOLLOW_UP_TIME * 1000L;
+	    }
+	    flgMeasure = (onSince >= 0  ||  measureEnd > ms);
+	    if (! flgMeasure  &&  measureEnd >= 0)
+	    {
+		/* follow-up time is over: MeasureStop() */
+		measureEnd = -1;
+		scanStart = -1;
+		EnergyPause (&energy);
+	    }
+
+	    /* true load */
+	    mA = (onSince >= 0 ? loadCurrent (ms, onSince) : 0);
+	    mV = (onSince >= 0 ? 12000 - mA * 400 / 1000 : 0);
+	    trueUWs += (double)mV * mA / 1000.0;
+
+	    if (budget > 0)
+	    {
+		if (warnTrue < 0  &&  trueUWs >= budget * 3600.0 * warnLevel
+						   * 10.0)
+		    warnTrue = ms;
+		if (cutTrue < 0  &&  trueUWs >= budget * 3600.0 * 1000.0)
+		    cutTrue = ms;
+	    }
+
+	    if (! flgMeasure)
+		continue;
+
+	    /* ADC scan: average each channel over its window */
+	    chan = (int)(((ms - scanStart) / l_ScanMs) % SCAN_CHANNELS);
+	    if (chan == 0)
+		sumI += mA;
+	    else if (chan == 2)
+		sumU += mV;
+
+	    if ((ms - scanStart + 1) % l_ScanMs != 0)
+		continue;			// window not complete
+
+	    if (chan == 0)
+	    {
+		/* conversion of I1 completed */
+		valI = (uint32_t)(sumI / l_ScanMs + 0.5);
+		sumI = 0.0;
+	    }
+	    else if (chan == 2)
+	    {
+		/* conversion of U1 completed: Control() */
+		mV = (uint32_t)(sumU / l_ScanMs + 0.5);
+		sumU = 0.0;
+		ticks = (uint32_t)((day * MS_PER_DAY + ms) * 32768 / 1000);
+		EnergyAdd (&energy, mV, valI, (ticks - prevTicks) & 0xFFFFFF);
+		prevTicks = ticks;
+
+		state = EnergyState (&energy, (uint32_t)warnLevel);
+		if (state != prevState)
+		{
+		    if (state == ENERGY_WARN)
+			warnFw = ms;
+		    else if (state == ENERGY_CUT_OFF)
+		    {
+			cutFw = ms;
+			cutPct = trueUWs / (budget * 36000.0);
+			flgCutOff = true;
+		    }
+		    prevState = state;
+		}
+	    }
+	}
+
+	err = (trueUWs > 0.0 ? (energy.Used + energy.Rest / 1000.0
+				- trueUWs / 1000.0) * 100.0
+			       / (trueUWs / 1000.0) : 0.0);
+	if (err < 0.0 ? -err > maxErr : err > maxErr)
+	    maxErr = (err < 0.0 ? -err : err);
+	sumTrue += trueUWs / 1000.0;
+	sumFw += energy.Used + energy.Rest / 1000.0;
+
+	printf ("%3ld %10.1f %14.1f  %+.3f%%\n", day + 1, trueUWs / 3.6e6,
+		(energy.Used + energy.Rest / 1000.0) / 3600.0, err);
+
+	if (budget > 0  &&  (l_flgVerbose  ||  cutFw >= 0))
+	{
+	    printTime ("    warning:  true ", warnTrue);
+	    printTime (", firmware ", warnFw);
+	    printTime ("\n    cut-off:  true ", cutTrue);
+	    printTime (", firmware ", cutFw);
+	    if (cutFw >= 0)
+		printf (" at %.1f%% of the budget", cutPct);
+	    printf ("\n");
+	}
+    }
+
+    printf ("Total %.1fmWh true, %.1fmWh firmware, error %+.3f%%, maximum"
+	    " daily error %.3f%%\n", sumTrue / 3600.0, sumFw / 3600.0,
+	    (sumFw - sumTrue) * 100.0 / sumTrue, maxErr);
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * @brief  Output is scheduled to be on at this time of the day
+ *****************************************************************************/
+static bool	outputScheduled (long ms)
+{
+long	sec = ms / 1000;
+
+    switch (l_Profile)
+    {
+	case PROFILE_CAMERA:
+	case PROFILE_FAULTY:
+	    /* 05:00 to 15:00, interval 600s, on duration 300s */
+	    if (sec < 5 * 3600  ||  sec >= 15 * 3600)
+		return false;
+	    return ((sec - 5 * 3600) % 600 < 300);
+
+	default:
+	    return true;
+    }
+}
+
+
+/******************************************************************************
+ * @brief  Current of the load in [mA]
+ *****************************************************************************/
+static uint32_t	loadCurrent (long ms, long onSince)
+{
+    switch (l_Profile)
+    {
+	case PROFILE_CONST:
+	    return 500;
+
+	case PROFILE_PULSE:
+	    return (ms % 1700 < 100 ? 1500 : 80);
+
+	case PROFILE_FAULTY:
+	    if (ms - onSince < 300)
+		return 2000;		// inrush
+	    return 1200;		// hangs in recording mode
+
+	default:
+	    if (ms - onSince < 300)
+		return 2000;		// inrush
+	    if (ms < l_RecEnd)
+		return 1200;		// recording
+	    /* start a recording on average every 40s */
+	    if (randUniform() < 1.0 / 40000.0)
+		l_RecEnd = ms + 5000 + (long)(randUniform() * 55000.0);
+	    return 450;
+    }
+}
+
+
+/******************************************************************************
+ * @brief  Uniform random number in [0, 1)
+ *****************************************************************************/
+static double	randUniform (void)
+{
+    /* xorshift64 */
+    l_Rand ^= l_Rand << 13;
+    l_Rand ^= l_Rand >> 7;
+    l_Rand ^= l_Rand << 17;
+    return (double)(l_Rand >> 11) / (double)(1ULL << 53);
+}
+
+
+/******************************************************************************
+ * @brief  Print a time of the day, or "never"
+ *****************************************************************************/
+static void	printTime (const char *pText, long ms)
+{
+    if (ms < 0)
+	printf ("%snever", pText);
+    else
+	printf ("%s%02ld:%02ld:%02ld", pText, ms / 3600000, ms / 60000 % 60,
+		ms / 1000 % 60);
+}
+
+
+/******************************************************************************
+ * @brief  Show usage and exit
+ *****************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr,
+	"Usage: EnergySim [-p <profile>] [-d <days>] [-s <scan_ms>]\n"
+	"                 [-b <budget_mWh>] [-w <warn_level>] [-r <seed>] [-v]\n"
+	"  -p  load profile: camera (default), const, pulse, faulty\n"
+	"  -d  number of days to simulate (default 7)\n"
+	"  -s  ADC scan duration per channel, 52 to 2200ms (default 1000)\n"
+	"  -b  daily energy budget in [mWh] (default none)\n"
+	"  -w  warning level in percent of the budget (default 80)\n"
+	"  -r  seed for the random recordings of the camera profile\n"
+	"  -v  show warning and cut-off times of every day\n");
+    exit (1);
+}
@@ -0,0 +1,837 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Power-Cut Injection Test of the FAT Metadata Journal
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool runs the firmware's FatFs (ff.c) on a RAM disk, cuts the
+ * power at every single sector write of a workload, and checks the file
+ * system after the next mount.  It proves that the metadata journal, see
+ * _FS_JOURNAL in ffconf.h, keeps the FAT consistent, and measures what the
+ * journal costs.
+ *
+ * Usage:
+ * @code
+ * FatCrash [-v]
+ * @endcode
+ *
+ * The RAM disk is formatted with f_mkfs() as FAT32 with 1KB clusters, a
+ * filler file of 120KB and a log file are created.  The workload then does
+ * what the firmware does with a file system:
+ * - LOG_RECORDS appends of LOG_RECORD bytes to the log file, each followed
+ *   by f_sync(), the log file grows into the second FAT sector;
+ * - a new file is written and closed;
+ * - f_mkdir() creates a directory, f_rename() moves the new file into it;
+ * - f_unlink() removes the filler file.
+ *
+ * The workload is run once without a cut to count its sector writes.  Then
+ * for every write <i>k</i>, the image is restored, the workload is run again
+ * and write <i>k</i> is either dropped, or torn (only the first 256 bytes
+ * reach the disk).  The disk fails all further accesses, like a card without
+ * power.  The file system is mounted again, which replays an interrupted
+ * intent, and checked:
+ * - every cluster belongs to at most one chain (cross-links),
+ * - every allocated cluster belongs to a file or directory (lost clusters),
+ * - every chain ends properly and fits the file size,
+ * - both FAT copies are equal, the free count of the FSInfo sector is right,
+ * - every directory starts with correct "." and ".." entries,
+ * - the contents of every file match their pattern (dropped writes only,
+ *   a torn data sector is not a metadata error).
+ * If the mount has replayed an intent, the power is also cut at every write
+ * of the replay, to show that the replay can be interrupted itself.
+ *
+ * Everything is done twice, without and with the journal.  Without, the
+ * journal is switched off after each mount, which gives the same sector
+ * writes as a firmware built with _FS_JOURNAL 0.  Option <b>-v</b> lists
+ * the errors of every failed trial.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "ff.h"
+#include "diskio.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Size of the RAM disk in sectors (80MB), and of a cluster. */
+#define IMG_SECTORS	(80UL * 2048)
+#define CLUSTER_SIZE	1024
+
+    /*!@brief Files of the workload, see the file description. */
+#define FILLER_SIZE	(120 * 1024)
+#define LOG_START	100
+#define LOG_RECORD	700
+#define LOG_RECORDS	40
+#define NEW_SIZE	3000
+
+    /*!@brief Maximum number of sector writes of one trial. */
+#define MAX_UNDO	8192
+
+    /*!@brief Kind of power cut. */
+typedef enum
+{
+    CUT_NONE,		//!< No power cut
+    CUT_DROP,		//!< The write is lost
+    CUT_TORN,		//!< Only the first half of the sector is written
+    END_CUT
+} CUT;
+
+    /*!@brief Inconsistencies found by fsck(), every entry is a counter. */
+typedef struct
+{
+    uint32_t	Mount;		//!< Mount failed
+    uint32_t	CrossLink;	//!< Cluster in more than one chain
+    uint32_t	Lost;		//!< Allocated cluster in no chain
+    uint32_t	BadChain;	//!< Chain with invalid link
+    uint32_t	ChainSize;	//!< Chain length does not fit the file size
+    uint32_t	FatCopy;	//!< FAT copies differ
+    uint32_t	FsInfo;		//!< Wrong free count in FSInfo
+    uint32_t	BadDir;		//!< Wrong "." or ".." entry
+    uint32_t	Data;		//!< File contents do not match
+} FSCK;
+
+#define FSCK_ITEMS	(sizeof(FSCK) / sizeof(uint32_t))
+
+    /*!@brief Statistics of one mode, without or with the journal. */
+typedef struct
+{
+    uint32_t	Writes;		//!< Sector writes of the workload
+    uint32_t	Reads;		//!< Sector reads of the workload
+    uint32_t	SyncCnt[2];	//!< f_sync() calls, same / new cluster
+    uint32_t	SyncWr[2];	//!< Sector writes of these calls
+    uint32_t	MountRd, MountWr;	//!< I/O of a clean mount
+    uint32_t	ReplayCnt;	//!< Mounts that replayed an intent
+    uint32_t	ReplayRd, ReplayWr;	//!< Maximum I/O of such a mount
+    uint32_t	Trials[END_CUT];	//!< Power cuts
+    uint32_t	Failed[END_CUT];	//!< ... with inconsistencies
+    FSCK	Errors[END_CUT];	//!< ... per kind of inconsistency
+    uint32_t	ReplayTrials;	//!< Power cuts during a replay
+    uint32_t	ReplayFailed;	//!< ... with inconsistencies
+} STATS;
+
+/*================================ Local Data ================================*/
+
+static const char *l_FsckName[FSCK_ITEMS] =
+{
+    "mount failed", "cross-linked clusters", "lost clusters",
+    "invalid chain links", "chain length vs. size", "FAT copies differ",
+    "FSInfo free count", "bad . or .. entry", "file contents",
+};
+
+    /* RAM disk and undo log of all writes */
+static BYTE    *l_Img;
+static struct
+{
+    DWORD	Sect;
+    BYTE	Data[512];
+} l_Undo[MAX_UNDO];
+static int	l_UndoCnt;
+
+    /* I/O counters and power cut */
+static uint32_t	l_Reads, l_Writes;
+static uint32_t	l_CutAt;	// number of the write to cut
+static CUT	l_Cut;
+static bool	l_flgDead;	// the disk has no power
+
+    /* File system, and mode of the test */
+static FATFS	l_Fs;
+static bool	l_flgNoJournal;
+static bool	l_flgVerbose;
+
+    /* Layout of the volume for fsck() */
+static DWORD	l_FatSect, l_FatSize, l_DataSect, l_Clusters, l_RootClust;
+static DWORD	l_FsiSect;
+static BYTE	l_Used[IMG_SECTORS];	// cluster is in a chain
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	runMode (bool noJournal, STATS *pStats);
+static FRESULT	makeBaseline (void);
+static FRESULT	workload (STATS *pStats);
+static FRESULT	mount (void);
+static void	rollback (int mark);
+static bool	fsck (FSCK *pErr, bool checkData);
+static DWORD	walkChain (DWORD clst, FSCK *pErr);
+static void	checkDir (DWORD clst, DWORD parent, FSCK *pErr, bool checkData);
+static bool	checkFile (const BYTE *pEnt, DWORD size);
+static BYTE	pattern (char name, DWORD offset);
+static void	printStats (const STATS *pStats);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+static STATS stats[2];
+int	 i;
+
+
+    for (i = 1;  i < argc;  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else
+	{
+	    fprintf (stderr, "Usage: FatCrash [-v]\n");
+	    return 1;
+	}
+    }
+
+    l_Img = calloc (IMG_SECTORS, 512);
+    if (l_Img == NULL)
+    {
+	perror ("FatCrash");
+	return 1;
+    }
+
+    if (runMode (true, &stats[0]) != 0  ||  runMode (false, &stats[1]) != 0)
+	return 1;
+
+    printStats (stats);
+
+    return (stats[1].Failed[CUT_DROP] + stats[1].Failed[CUT_TORN]
+	    + stats[1].ReplayFailed) != 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Run the Test in one Mode
+ *
+ * This routine formats the RAM disk, creates the baseline, and runs the
+ * workload once without and then with a power cut at every write.
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	runMode (bool noJournal, STATS *pStats)
+{
+FSCK	 err;
+FRESULT	 res;
+uint32_t total, k, w, j, rd;
+int	 mark, cut;
+
+
+    l_flgNoJournal = noJournal;
+    memset (l_Img, 0, IMG_SECTORS * 512);
+    l_UndoCnt = -1;				// no undo log
+    l_Cut = CUT_NONE;
+    l_flgDead = false;
+
+    f_mount (0, &l_Fs);
+    res = f_mkfs (0, 0, CLUSTER_SIZE);
+    if (res == FR_OK)
+	res = makeBaseline();
+    if (res != FR_OK)
+    {
+	fprintf (stderr, "Baseline: FatFs error %d\n", res);
+	return -1;
+    }
+
+    /* Reference run */
+    l_UndoCnt = 0;
+    res = mount();
+    l_Reads = l_Writes = 0;
+    if (res == FR_OK)
+	res = workload (pStats);
+    if (res != FR_OK  ||  ! fsck (&err, true))
+    {
+	fprintf (stderr, "Reference run failed, FatFs error %d\n", res);
+	return -1;
+    }
+    total = pStats->Writes = l_Writes;
+    pStats->Reads = l_Reads;
+
+    l_Reads = l_Writes = 0;
+    mount();
+    pStats->MountRd = l_Reads;
+    pStats->MountWr = l_Writes;
+
+    /* A power cut at every write */
+    for (cut = CUT_DROP;  cut < END_CUT;  cut++)
+    {
+	for (k = 0;  k < total;  k++)
+	{
+	    rollback (0);
+	    mount();
+
+	    l_Writes = 0;
+	    l_CutAt = k;
+	    l_Cut = (CUT)cut;
+	    workload (NULL);
+
+	    /* Power on again */
+	    l_Cut = CUT_NONE;
+	    l_flgDead = false;
+	    mark = l_UndoCnt;
+	    l_Reads = l_Writes = 0;
+	    res = mount();
+	    rd = l_Reads;
+	    w = l_Writes;
+
+	    pStats->Trials[cut]++;
+	    if (res != FR_OK  ||  ! fsck (&err, cut == CUT_DROP))
+	    {
+		if (res != FR_OK)
+		    pStats->Errors[cut].Mount++;
+		pStats->Failed[cut]++;
+		if (l_flgVerbose)
+		    printf ("%s journal, %s write %u: FatFs %d\n",
+			    noJournal ? "without" : "with",
+			    cut == CUT_DROP ? "dropped" : "torn", k, res);
+	    }
+	    for (j = 0;  j < FSCK_ITEMS;  j++)
+		((uint32_t *)&pStats->Errors[cut])[j] += (((uint32_t *)&err)[j] != 0);
+
+	    if (w == 0)
+		continue;
+
+	    /* The mount has replayed an intent */
+	    pStats->ReplayCnt++;
+	    if (rd > pStats->ReplayRd)
+		pStats->ReplayRd = rd;
+	    if (w > pStats->ReplayWr)
+		pStats->ReplayWr = w;
+
+	    for (j = 0;  j < w;  j++)
+	    {
+		rollback (mark);
+		l_Writes = 0;
+		l_CutAt = j;
+		l_Cut = (CUT)cut;
+		mount();
+
+		l_Cut = CUT_NONE;
+		l_flgDead = false;
+		res = mount();
+		pStats->ReplayTrials++;
+		if (res != FR_OK  ||  ! fsck (&err, cut == CUT_DROP))
+		{
+		    pStats->ReplayFailed++;
+		    if (l_flgVerbose)
+			printf ("%s journal, %s write %u, replay write %u:"
+				" FatFs %d\n", noJournal ? "without" : "with",
+				cut == CUT_DROP ? "dropped" : "torn", k, j, res);
+		}
+	    }
+	}
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Create the Baseline
+ *
+ * This routine creates the filler file and the log file on the freshly
+ * formatted RAM disk.
+ *
+ ******************************************************************************/
+static FRESULT	makeBaseline (void)
+{
+static const struct { const char *Name; DWORD Size; } files[] =
+{
+    { "FILLER.BIN", FILLER_SIZE }, { "LOG.TXT", LOG_START }
+};
+BYTE	 buf[512];
+FRESULT	 res;
+FIL	 fh;
+DWORD	 off;
+UINT	 n, bw, i;
+
+
+    res = mount();
+    for (i = 0;  res == FR_OK  &&  i < 2;  i++)
+    {
+	res = f_open (&fh, files[i].Name, FA_CREATE_ALWAYS | FA_WRITE);
+	for (off = 0;  res == FR_OK  &&  off < files[i].Size;  off += n)
+	{
+	    n = files[i].Size - off < sizeof(buf)
+		? files[i].Size - off : sizeof(buf);
+	    for (bw = 0;  bw < n;  bw++)
+		buf[bw] = pattern (files[i].Name[0], off + bw);
+	    res = f_write (&fh, buf, n, &bw);
+	}
+	if (res == FR_OK)
+	    res = f_close (&fh);
+    }
+
+    return res;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Run the Workload
+ *
+ * This routine runs the workload of the file description.  It stops at the
+ * first error, i.e. at the power cut.  If @p pStats is not NULL, the sector
+ * writes of every f_sync() of the log file are counted.
+ *
+ ******************************************************************************/
+static FRESULT	workload (STATS *pStats)
+{
+BYTE	 buf[LOG_RECORD > NEW_SIZE ? LOG_RECORD : NEW_SIZE];
+FRESULT	 res;
+FIL	 fh;
+DWORD	 size;
+uint32_t w;
+UINT	 bw, i, r, newClust;
+
+
+    res = f_open (&fh, "LOG.TXT", FA_OPEN_EXISTING | FA_WRITE);
+    if (res == FR_OK)
+	res = f_lseek (&fh, fh.fsize);
+
+    for (r = 0;  res == FR_OK  &&  r < LOG_RECORDS;  r++)
+    {
+	size = fh.fsize;
+	for (i = 0;  i < LOG_RECORD;  i++)
+	    buf[i] = pattern ('L', size + i);
+	res = f_write (&fh, buf, LOG_RECORD, &bw);
+	if (res != FR_OK)
+	    break;
+
+	newClust = ((size + LOG_RECORD - 1) / CLUSTER_SIZE
+		    != (size - 1) / CLUSTER_SIZE);
+	w = l_Writes;
+	res = f_sync (&fh);
+	if (pStats != NULL)
+	{
+	    pStats->SyncCnt[newClust]++;
+	    pStats->SyncWr[newClust] += l_Writes - w;
+	}
+    }
+    if (res == FR_OK)
+	res = f_close (&fh);
+
+    if (res == FR_OK)
+	res = f_open (&fh, "NEW.TXT", FA_CREATE_NEW | FA_WRITE);
+    if (res == FR_OK)
+    {
+	for (i = 0;  i < NEW_SIZE;  i++)
+	    buf[i] = pattern ('N', i);
+	res = f_write (&fh, buf, NEW_SIZE, &bw);
+	if (res == FR_OK)
+	    res = f_close (&fh);
+    }
+
+    if (res == FR_OK)
+	res = f_mkdir ("ARCHIVE");
+    if (res == FR_OK)
+	res = f_rename ("NEW.TXT", "ARCHIVE/NEW.TXT");
+    if (res == FR_OK)
+	res = f_unlink ("FILLER.BIN");
+
+    return res;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Mount the File System
+ *
+ * This routine mounts the file system again, like the firmware does after
+ * a power-up, and switches the journal off if requested.
+ *
+ ******************************************************************************/
+static FRESULT	mount (void)
+{
+DIR	 dir;
+FRESULT	 res;
+
+
+    f_mount (0, &l_Fs);
+    res = f_opendir (&dir, "/");		// mounts the volume
+#if _FS_JOURNAL
+    if (res == FR_OK  &&  l_flgNoJournal)
+	l_Fs.jnl_base = 0;
+#endif
+    return res;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Undo all Writes after a Mark of the Undo Log
+ *
+ ******************************************************************************/
+static void	rollback (int mark)
+{
+    while (l_UndoCnt > mark)
+    {
+	l_UndoCnt--;
+	memcpy (l_Img + l_Undo[l_UndoCnt].Sect * 512,
+		l_Undo[l_UndoCnt].Data, 512);
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check the File System
+ *
+ * This routine checks the FAT32 volume on the RAM disk with its own code,
+ * not with FatFs, see the file description.
+ *
+ * @param[out] pErr
+ *	Number of inconsistencies of each kind.
+ *
+ * @param[in] checkData
+ *	Check the contents of the files.
+ *
+ * @return
+ *	<i>true</i> if the file system is consistent.
+ *
+ ******************************************************************************/
+static bool	fsck (FSCK *pErr, bool checkData)
+{
+const BYTE *pVbr;
+DWORD	 vbr, c, freeCnt = 0, fsiFree;
+uint32_t j;
+bool	 flgOk = true;
+
+
+    memset (pErr, 0, sizeof(FSCK));
+
+    vbr = LD_DWORD(l_Img + 446 + 8);		// first partition
+    pVbr = l_Img + vbr * 512;
+    l_FatSect  = vbr + LD_WORD(pVbr + 14);
+    l_FatSize  = LD_DWORD(pVbr + 36);
+    l_DataSect = l_FatSect + pVbr[16] * l_FatSize;
+    l_Clusters = (LD_DWORD(pVbr + 32) - (l_DataSect - vbr)) / pVbr[13];
+    l_RootClust = LD_DWORD(pVbr + 44);
+    l_FsiSect  = vbr + LD_WORD(pVbr + 48);
+
+    if (pVbr[16] > 1  &&  memcmp (l_Img + l_FatSect * 512,
+				  l_Img + (l_FatSect + l_FatSize) * 512,
+				  l_FatSize * 512) != 0)
+	pErr->FatCopy++;
+
+    memset (l_Used, 0, l_Clusters + 2);
+    walkChain (l_RootClust, pErr);
+    checkDir (l_RootClust, 0, pErr, checkData);
+
+    for (c = 2;  c < l_Clusters + 2;  c++)
+    {
+	if ((LD_DWORD(l_Img + l_FatSect * 512 + c * 4) & 0x0FFFFFFF) == 0)
+	    freeCnt++;
+	else if (! l_Used[c])
+	    pErr->Lost++;
+    }
+
+    fsiFree = LD_DWORD(l_Img + l_FsiSect * 512 + 488);
+    if (fsiFree != 0xFFFFFFFF  &&  fsiFree != freeCnt)
+	pErr->FsInfo++;
+
+    for (j = 0;  j < FSCK_ITEMS;  j++)
+    {
+	if (((uint32_t *)pErr)[j] != 0)
+	{
+	    flgOk = false;
+	    if (l_flgVerbose)
+		printf ("  %s: %u\n", l_FsckName[j], ((uint32_t *)pErr)[j]);
+	}
+    }
+
+    return flgOk;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Follow a Cluster Chain
+ *
+ * This routine marks all clusters of a chain as used.
+ *
+ * @return
+ *	Number of clusters of the chain.
+ *
+ ******************************************************************************/
+static DWORD	walkChain (DWORD clst, FSCK *pErr)
+{
+DWORD	 n = 0;
+
+
+    while (clst >= 2  &&  clst < l_Clusters + 2)
+    {
+	if (l_Used[clst])
+	{
+	    pErr->CrossLink++;
+	    return n;
+	}
+	l_Used[clst] = 1;
+	n++;
+
+	clst = LD_DWORD(l_Img + l_FatSect * 512 + clst * 4) & 0x0FFFFFFF;
+	if (clst >= 0x0FFFFFF8)
+	    return n;
+    }
+
+    pErr->BadChain++;
+    return n;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check a Directory and its Sub-Directories
+ *
+ * The chain of the directory has already been followed by walkChain().
+ *
+ ******************************************************************************/
+static void	checkDir (DWORD clst, DWORD parent, FSCK *pErr, bool checkData)
+{
+const BYTE *pEnt;
+DWORD	 start, size, n;
+UINT	 i;
+
+
+    for (n = 0;  clst >= 2  &&  clst < l_Clusters + 2;  n++)
+    {
+	pEnt = l_Img + (l_DataSect + (clst - 2) * (CLUSTER_SIZE / 512)) * 512;
+	for (i = 0;  i < CLUSTER_SIZE / 32;  i++, pEnt += 32)
+	{
+	    if (pEnt[0] == 0x00)
+		return;				// end of directory
+	    if (parent != 0  &&  n == 0  &&  i < 2)
+	    {
+		/* "." and ".." of a sub-directory */
+		start = ((DWORD)LD_WORD(pEnt + 20) << 16) | LD_WORD(pEnt + 26);
+		if (memcmp (pEnt, i == 0 ? ".          " : "..         ", 11)
+		||  start != (i == 0 ? clst
+			      : parent == l_RootClust ? 0 : parent))
+		    pErr->BadDir++;
+		continue;
+	    }
+	    if (pEnt[0] == 0xE5  ||  (pEnt[11] & 0x08))
+		continue;			// deleted, LFN, or volume label
+
+	    start = ((DWORD)LD_WORD(pEnt + 20) << 16) | LD_WORD(pEnt + 26);
+	    size = LD_DWORD(pEnt + 28);
+	    if (pEnt[11] & 0x10)
+	    {
+		if (walkChain (start, pErr) == 0)
+		    pErr->BadDir++;
+		else
+		    checkDir (start, clst, pErr, checkData);
+	    }
+	    else
+	    {
+		if (start == 0 ? size != 0
+		    : walkChain (start, pErr)
+		      != (size + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+		    pErr->ChainSize++;
+		else if (checkData  &&  size != 0  &&  ! checkFile (pEnt, size))
+		    pErr->Data++;
+	    }
+	}
+	clst = LD_DWORD(l_Img + l_FatSect * 512 + clst * 4) & 0x0FFFFFFF;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check the Contents of a File
+ *
+ * @return
+ *	<i>true</i> if all bytes match the pattern of the file.
+ *
+ ******************************************************************************/
+static bool	checkFile (const BYTE *pEnt, DWORD size)
+{
+const BYTE *pData;
+DWORD	 clst, off;
+
+
+    clst = ((DWORD)LD_WORD(pEnt + 20) << 16) | LD_WORD(pEnt + 26);
+    for (off = 0;  off < size;  off++)
+    {
+	if (off > 0  &&  off % CLUSTER_SIZE == 0)
+	    clst = LD_DWORD(l_Img + l_FatSect * 512 + clst * 4) & 0x0FFFFFFF;
+	pData = l_Img + (l_DataSect + (clst - 2) * (CLUSTER_SIZE / 512)) * 512;
+	if (pData[off % CLUSTER_SIZE] != pattern (pEnt[0], off))
+	    return false;
+    }
+
+    return true;
+}
+
+
+/******************************************************************************
+ * @brief  Contents of a file at an offset
+ *****************************************************************************/
+static BYTE	pattern (char name, DWORD offset)
+{
+    return (BYTE)(offset * 31 + (offset >> 8) + name);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Print the Results of both Modes
+ *
+ ******************************************************************************/
+static void	printStats (const STATS *pStats)
+{
+static const char *cutName[END_CUT] = { NULL, "dropped", "torn" };
+const STATS *p;
+int	 m, cut;
+uint32_t j;
+
+
+    printf ("FatCrash: 80MB FAT32 RAM disk, 1KB clusters, journal of %d"
+	    " sectors\n\n", _FS_JOURNAL);
+    printf ("%-34s %15s %15s\n", "", "without journal", "with journal");
+    printf ("%-34s", "Workload sector writes / reads");
+    for (m = 0;  m < 2;  m++)
+	printf ("       %4u / %3u", pStats[m].Writes, pStats[m].Reads);
+    printf ("\n%-34s", "f_sync(), same cluster: writes");
+    for (m = 0;  m < 2;  m++)
+	printf (" %15.2f", pStats[m].SyncCnt[0] ? (double)pStats[m].SyncWr[0]
+		/ pStats[m].SyncCnt[0] : 0.0);
+    printf ("\n%-34s", "f_sync(), new cluster: writes");
+    for (m = 0;  m < 2;  m++)
+	printf (" %15.2f", pStats[m].SyncCnt[1] ? (double)pStats[m].SyncWr[1]
+		/ pStats[m].SyncCnt[1] : 0.0);
+    printf ("\n%-34s", "Mount: reads / writes");
+    for (m = 0;  m < 2;  m++)
+	printf ("         %2u / %2u", pStats[m].MountRd, pStats[m].MountWr);
+    printf ("\n%-34s", "Mount with replay: max. rd / wr");
+    for (m = 0;  m < 2;  m++)
+	printf ("         %2u / %2u", pStats[m].ReplayRd, pStats[m].ReplayWr);
+    printf ("\n%-34s", "Mounts with replay");
+    for (m = 0;  m < 2;  m++)
+	printf (" %15u", pStats[m].ReplayCnt);
+    printf ("\n");
+
+    for (cut = CUT_DROP;  cut < END_CUT;  cut++)
+    {
+	printf ("\nPower cut, %s write:\n", cutName[cut]);
+	printf ("%-34s", "  inconsistent / trials");
+	for (m = 0;  m < 2;  m++)
+	    printf ("      %4u / %4u", pStats[m].Failed[cut],
+		    pStats[m].Trials[cut]);
+	printf ("\n");
+	for (j = 0;  j < FSCK_ITEMS;  j++)
+	{
+	    if (cut == CUT_TORN  &&  j == FSCK_ITEMS - 1)
+		break;			// file contents are not checked
+	    printf ("    %-30s", l_FsckName[j]);
+	    for (m = 0;  m < 2;  m++)
+	    {
+		p = &pStats[m];
+		printf (" %15u", ((const uint32_t *)&p->Errors[cut])[j]);
+	    }
+	    printf ("\n");
+	}
+    }
+
+    printf ("\n%-34s", "Power cut during replay: failed");
+    for (m = 0;  m < 2;  m++)
+	printf ("      %4u / %4u", pStats[m].ReplayFailed,
+		pStats[m].ReplayTrials);
+    printf ("\n");
+}
+
+
+/*============================ Disk I/O Functions ============================*/
+
+DSTATUS	disk_initialize (BYTE drv)
+{
+    return (drv != 0  ||  l_flgDead) ? STA_NOINIT : 0;
+}
+
+DSTATUS	disk_status (BYTE drv)
+{
+    return (drv != 0  ||  l_flgDead) ? STA_NOINIT : 0;
+}
+
+DRESULT	disk_read (BYTE drv, BYTE *buff, DWORD sector, BYTE count)
+{
+    if (drv != 0  ||  l_flgDead  ||  sector + count > IMG_SECTORS)
+	return RES_ERROR;
+
+    memcpy (buff, l_Img + sector * 512, count * 512);
+    l_Reads += count;
+    return RES_OK;
+}
+
+DRESULT	disk_write (BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
+{
+    if (drv != 0  ||  l_flgDead  ||  sector + count > IMG_SECTORS)
+	return RES_ERROR;
+
+    for ( ;  count > 0;  count--, sector++, buff += 512)
+    {
+	if (l_UndoCnt >= MAX_UNDO)
+	{
+	    fprintf (stderr, "Undo log overflow\n");
+	    exit (1);
+	}
+	if (l_UndoCnt >= 0)
+	{
+	    l_Undo[l_UndoCnt].Sect = sector;
+	    memcpy (l_Undo[l_UndoCnt++].Data, l_Img + sector * 512, 512);
+	}
+
+	if (l_Cut != CUT_NONE  &&  l_Writes == l_CutAt)
+	{
+	    if (l_Cut == CUT_TORN)
+		memcpy (l_Img + sector * 512, buff, 256);
+	    l_flgDead = true;
+	    return RES_ERROR;
+	}
+	memcpy (l_Img + sector * 512, buff, 512);
+	l_Writes++;
+    }
+
+    return RES_OK;
+}
+
+DRESULT	disk_ioctl (BYTE drv, BYTE ctrl, void *buff)
+{
+    if (drv != 0  ||  l_flgDead)
+	return RES_ERROR;
+
+    switch (ctrl)
+    {
+	case GET_SECTOR_COUNT:
+	    *(DWORD *)buff = IMG_SECTORS;
+	    break;
+
+	case GET_SECTOR_SIZE:
+	    *(WORD *)buff = 512;
+	    break;
+
+	case GET_BLOCK_SIZE:
+	    *(DWORD *)buff = 1;		// erase block unknown
+	    break;
+
+	default:
+	    break;
+    }
+    return RES_OK;
+}
+
+/******************************************************************************
+ * @brief  Timestamp for FatFs
+ *****************************************************************************/
+DWORD	get_fattime (void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
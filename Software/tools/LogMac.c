@@ -0,0 +1,940 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Log Authentication Verifier
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool verifies the MAC trailers of TAMDL log files, see
+ * LogAuth.c of the firmware.
+ *
+ * Usage:
+ * @code
+ * LogMac -k <keyfile> [-u] [-v] <BOXnnnn.TXT>...
+ * @endcode
+ *
+ * The key file contains one line per box with the box number, its key as
+ * 32 hexadecimal digits, and optionally the HW-ID of the box as 16
+ * hexadecimal digits, see the start-up message "MCU: ... HW-ID: 0x...".  A
+ * line with "*" instead of the box number is used for all boxes without a
+ * dedicated key.  Empty lines and lines starting with '#' are ignored:
+ * @code
+ * # box  key                               HW-ID
+ * 12     2B7E151628AED2A6ABF7158809CF4F3C  0123456789ABCDEF
+ * *      000102030405060708090A0B0C0D0E0F
+ * @endcode
+ *
+ * The box number is taken from the filename, so all files of a season can
+ * be verified at once.  Every trailer line <tt>#MAC nnnnnn len mac</tt>
+ * authenticates the <i>len</i> bytes in front of it, chained with the MAC
+ * of the previous trailer.  Block 0 starts a new chain, this happens after a
+ * reset, a media change, or a write error.  Its trailer contains the chain
+ * ID <tt>hwid boot chain</tt>, which is used instead of a previous MAC.  The
+ * tool reports per file:
+ * - <b>blocks</b>: number of trailers.
+ * - <b>bad</b>: blocks with a wrong MAC, i.e. modified data, and blocks 0
+ *   without chain ID or with the HW-ID of another box.
+ * - <b>breaks</b>: block numbers that do not continue the chain, i.e.
+ *   removed or reordered blocks, and chains that are not in ascending order
+ *   of their chain ID.
+ * - <b>unauth</b>: bytes that are not covered by a trailer, e.g. written
+ *   before the key was set, or during a failed flush.
+ *
+ * After all files, the chains of each box are checked for continuity:
+ * - <b>missing</b>: chain numbers that are missing within a boot, i.e. a
+ *   removed chain.  The chains of a boot are numbered from 0 without gaps.
+ *   A boot without any chain is not counted, because the box may have run
+ *   without SD-Card.
+ * - <b>duplicate</b>: chain IDs that occur more than once, i.e. copied data.
+ * - <b>foreign</b>: chains with another HW-ID than the first chain of the
+ *   box, i.e. data from another box with the same key.
+ *
+ * The exit code is 0 if all data is authenticated, 2 if there are bad
+ * blocks, chain breaks, unauthenticated bytes, or continuity errors.  With
+ * option <b>-u</b>, unauthenticated bytes are only reported.  Option
+ * <b>-v</b> lists every problem with its line number.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Maximum number of keys in the key file. */
+#define MAX_KEYS	1024
+
+    /*!@brief Number of chain IDs to allocate at once. */
+#define CHAIN_ALLOC	1024
+
+    /*!@brief Multiply by x in GF(2^8). */
+#define XTIME(x)	((uint8_t)(((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0)))
+
+/*!@brief Key of one box, prepared for CMAC */
+typedef struct
+{
+    int		Box;		//!< Box number, -1 for the default key
+    bool	flgHwId;	//!< HW-ID of the box is known
+    uint64_t	HwId;		//!< HW-ID of the box
+    uint8_t	Rk[176];	//!< AES round keys
+    uint8_t	K1[16];		//!< CMAC subkey for a complete last block
+    uint8_t	K2[16];		//!< CMAC subkey for a padded last block
+} KEY;
+
+/*!@brief Statistics of one file */
+typedef struct
+{
+    uint32_t	Blocks;		//!< Number of trailers
+    uint32_t	Bad;		//!< Blocks with wrong MAC
+    uint32_t	Breaks;		//!< Chain breaks
+    uint32_t	Restarts;	//!< Chain restarts (block 0)
+    uint64_t	AuthBytes;	//!< Authenticated bytes
+    uint64_t	UnauthBytes;	//!< Bytes not covered by a trailer
+} STATS;
+
+/*!@brief ID of one verified chain */
+typedef struct
+{
+    int		Box;		//!< Box number from the filename
+    uint64_t	HwId;		//!< HW-ID of the MCU
+    uint32_t	Boot;		//!< Boot counter
+    uint32_t	Chain;		//!< Chain number within the boot
+    const char	*pFile;		//!< File name
+    uint32_t	Line;		//!< Line number of the trailer of block 0
+} CHAIN_ID;
+
+/*================================ Local Data ================================*/
+
+    /* Command line options */
+static bool	l_flgVerbose;
+static bool	l_flgUnauthOk;
+
+    /* Keys */
+static KEY	l_Key[MAX_KEYS];
+static int	l_KeyCnt;
+
+    /* Chain IDs of all files */
+static CHAIN_ID	*l_pChain;
+static size_t	l_ChainCnt, l_ChainMax;
+
+    /* AES S-Box */
+static const uint8_t l_SBox[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+    0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+    0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+    0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+    0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+    0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+    0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+    0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+    0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+    0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+    0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+    0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	selfTest (void);
+static int	readKeys (const char *path);
+static const KEY *findKey (int box);
+static int	verifyFile (const char *path, STATS *pStat);
+static bool	addChain (const CHAIN_ID *pId);
+static int	chainCompare (const void *p1, const void *p2);
+static uint32_t	checkChains (void);
+static bool	parseHex (const char *pStr, uint8_t *pOut, int cnt);
+static void	keyPrepare (KEY *pKey, const uint8_t *pKeyData);
+static void	cmac (const KEY *pKey, const uint8_t *pPrev,
+		      const uint8_t *pData, size_t len, uint8_t *pMac);
+static void	aesKeyExpand (const uint8_t *pKey, uint8_t *pRk);
+static void	aesEncrypt (const uint8_t *pRk, uint8_t *s);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+const char *keyFile = NULL;
+STATS	 stat, total;
+uint32_t errors;
+int	 i, result = 0;
+
+
+    memset (&total, 0, sizeof(total));
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (strcmp (argv[i], "-u") == 0)
+	    l_flgUnauthOk = true;
+	else if (strcmp (argv[i], "-k") == 0  &&  i + 1 < argc)
+	    keyFile = argv[++i];
+	else
+	    usage();
+    }
+
+    if (i >= argc  ||  keyFile == NULL)
+	usage();
+
+    if (! selfTest())
+    {
+	fprintf (stderr, "AES-CMAC self test failed\n");
+	return 1;
+    }
+
+    if (readKeys (keyFile) != 0)
+	return 1;
+
+    printf ("%-32s %6s %8s %6s %6s %8s %10s %10s\n", "File", "Box",
+	    "Blocks", "Bad", "Breaks", "Restarts", "AuthBytes", "Unauth");
+
+    for ( ;  i < argc;  i++)
+    {
+	if (verifyFile (argv[i], &stat) != 0)
+	{
+	    result = 1;
+	    continue;
+	}
+
+	printf ("%-32s %6d %8u %6u %6u %8u %10llu %10llu\n", argv[i],
+		LogParseBoxNumber (argv[i]), stat.Blocks, stat.Bad,
+		stat.Breaks, stat.Restarts,
+		(unsigned long long)stat.AuthBytes,
+		(unsigned long long)stat.UnauthBytes);
+
+	total.Blocks      += stat.Blocks;
+	total.Bad         += stat.Bad;
+	total.Breaks      += stat.Breaks;
+	total.Restarts    += stat.Restarts;
+	total.AuthBytes   += stat.AuthBytes;
+	total.UnauthBytes += stat.UnauthBytes;
+    }
+
+    printf ("%-32s %6s %8u %6u %6u %8u %10llu %10llu\n", "TOTAL", "",
+	    total.Blocks, total.Bad, total.Breaks, total.Restarts,
+	    (unsigned long long)total.AuthBytes,
+	    (unsigned long long)total.UnauthBytes);
+
+    errors = checkChains();
+
+    if (result == 0  &&  (total.Bad > 0  ||  total.Breaks > 0  ||  errors > 0
+			 ||  (! l_flgUnauthOk  &&  total.UnauthBytes > 0)))
+	result = 2;
+
+    free (l_pChain);
+
+    return result;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Self Test
+ *
+ * This routine checks the CMAC implementation with the test vectors of
+ * RFC 4493, example 1 (empty message) and 2 (16 bytes).  The previous MAC
+ * of the chain is used as the first 16 bytes of the message here.
+ *
+ ******************************************************************************/
+static bool	selfTest (void)
+{
+static const uint8_t key[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+    0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+static const uint8_t msg[16] =
+{
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96,
+    0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A
+};
+static const uint8_t mac[16] =
+{
+    0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44,
+    0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C
+};
+static const uint8_t macEmpty[16] =
+{
+    0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28,
+    0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46
+};
+KEY	 k;
+uint8_t	 res[16];
+
+
+    keyPrepare (&k, key);
+
+    cmac (&k, NULL, NULL, 0, res);
+    if (memcmp (res, macEmpty, 16) != 0)
+	return false;
+
+    cmac (&k, msg, NULL, 0, res);
+    if (memcmp (res, mac, 16) != 0)
+	return false;
+
+    cmac (&k, NULL, msg, 16, res);
+    return memcmp (res, mac, 16) == 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read the Key File
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	readKeys (const char *path)
+{
+FILE	*fp;
+char	 line[LOG_LINE_MAX_SIZE], boxStr[16], hexStr[40], idStr[24];
+uint8_t	 key[16], id[8];
+uint32_t lineNum = 0;
+int	 cnt, i;
+
+
+    fp = fopen (path, "r");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	lineNum++;
+	cnt = sscanf (line, "%15s %39s %23s", boxStr, hexStr, idStr);
+	if (cnt < 1  ||  boxStr[0] == '#')
+	    continue;
+
+	if (l_KeyCnt >= MAX_KEYS)
+	{
+	    fprintf (stderr, "%s:%u: too many keys\n", path, lineNum);
+	    break;
+	}
+
+	if ((strcmp (boxStr, "*") != 0  &&  ! isdigit ((int)boxStr[0]))
+	||  cnt < 2  ||  strlen (hexStr) != 32  ||  ! parseHex (hexStr, key, 16)
+	||  (cnt > 2  &&  (strlen (idStr) != 16  ||  ! parseHex (idStr, id, 8))))
+	{
+	    fprintf (stderr, "%s:%u: invalid key line\n", path, lineNum);
+	    fclose (fp);
+	    return -1;
+	}
+
+	l_Key[l_KeyCnt].Box = (boxStr[0] == '*' ? -1 : atoi (boxStr));
+	keyPrepare (&l_Key[l_KeyCnt], key);
+	l_Key[l_KeyCnt].flgHwId = (cnt > 2);
+	l_Key[l_KeyCnt].HwId = 0;
+	for (i = 0;  cnt > 2  &&  i < 8;  i++)
+	    l_Key[l_KeyCnt].HwId = l_Key[l_KeyCnt].HwId << 8 | id[i];
+	l_KeyCnt++;
+    }
+
+    fclose (fp);
+
+    if (l_KeyCnt == 0)
+    {
+	fprintf (stderr, "%s: no keys\n", path);
+	return -1;
+    }
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Find the Key of a Box
+ *
+ * @return
+ *	Dedicated key of the box, the default key, or NULL.
+ *
+ ******************************************************************************/
+static const KEY *findKey (int box)
+{
+const KEY *pDefault = NULL;
+int	 i;
+
+
+    for (i = 0;  i < l_KeyCnt;  i++)
+    {
+	if (l_Key[i].Box == box  &&  box >= 0)
+	    return &l_Key[i];
+	if (l_Key[i].Box < 0)
+	    pDefault = &l_Key[i];
+    }
+    return pDefault;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Verify one Log File
+ *
+ * This routine reads the whole file and verifies each trailer line with the
+ * data in front of it.  The MAC of the previous trailer is used as chain
+ * value, even if it was wrong itself, so a modified block is only counted
+ * once.  Block 0 uses the chain ID of its trailer instead, which is stored
+ * for checkChains() if the MAC is valid.
+ *
+ * @return
+ *	0 if the file could be read, -1 otherwise.
+ *
+ ******************************************************************************/
+static int	verifyFile (const char *path, STATS *pStat)
+{
+FILE	*fp;
+const KEY *pKey;
+uint8_t	*pBuf, prevMac[16], mac[16], res[16], id[8];
+long	 size;
+size_t	 pos, end, start, authEnd = 0;
+unsigned long n, len, prevNum = 0, boot, chain;
+uint32_t lineNum = 1;
+char	 hexStr[40], idStr[24];
+bool	 flgPrev = false, flgId = false;
+int	 cnt, i;
+CHAIN_ID chainId, prevId;
+
+
+    memset (pStat, 0, sizeof(*pStat));
+    memset (&prevId, 0, sizeof(prevId));
+
+    pKey = findKey (LogParseBoxNumber (path));
+    if (pKey == NULL)
+    {
+	fprintf (stderr, "%s: no key for box %d\n", path,
+		 LogParseBoxNumber (path));
+	return -1;
+    }
+
+    fp = fopen (path, "rb");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+
+    fseek (fp, 0, SEEK_END);
+    size = ftell (fp);
+    fseek (fp, 0, SEEK_SET);
+    pBuf = malloc (size + 1);
+    if (pBuf == NULL  ||  fread (pBuf, 1, size, fp) != (size_t)size)
+    {
+	fprintf (stderr, "%s: read error\n", path);
+	free (pBuf);
+	fclose (fp);
+	return -1;
+    }
+    fclose (fp);
+    pBuf[size] = EOS;
+
+    for (pos = 0;  pos < (size_t)size;  pos = end, lineNum++)
+    {
+	/* Find end of this line */
+	for (end = pos;  end < (size_t)size  &&  pBuf[end] != '\n';  end++)
+	    ;
+	if (end < (size_t)size)
+	    end++;
+
+	if (strncmp ((char *)pBuf + pos, "#MAC ", 5) != 0)
+	    continue;
+	cnt = sscanf ((char *)pBuf + pos + 5, "%lu %lu %39s %23s %lu %lu",
+		      &n, &len, hexStr, idStr, &boot, &chain);
+	if (cnt < 3  ||  strlen (hexStr) != 32  ||  ! parseHex (hexStr, mac, 16))
+	    continue;
+
+	pStat->Blocks++;
+
+	/* The block must not overlap the previous trailer */
+	if (len > pos - authEnd)
+	{
+	    pStat->Bad++;
+	    if (l_flgVerbose)
+		printf ("%s:%u: block #%06lu: invalid length %lu\n",
+			path, lineNum, n, len);
+	    start = authEnd;
+	}
+	else
+	{
+	    start = pos - len;
+	    if (start > authEnd)
+	    {
+		pStat->UnauthBytes += start - authEnd;
+		if (l_flgVerbose)
+		    printf ("%s:%u: %lu unauthenticated bytes before block"
+			    " #%06lu\n", path, lineNum,
+			    (unsigned long)(start - authEnd), n);
+	    }
+
+	    /* Check the chain, block 0 is chained with the chain ID */
+	    if (n == 0)
+	    {
+		pStat->Restarts++;
+		memset (&chainId, 0, sizeof(chainId));
+		if (cnt == 6  &&  strlen (idStr) == 16  &&  parseHex (idStr, id, 8))
+		{
+		    for (i = 0;  i < 8;  i++)
+			chainId.HwId = chainId.HwId << 8 | id[i];
+		    chainId.Box   = LogParseBoxNumber (path);
+		    chainId.Boot  = (uint32_t)boot;
+		    chainId.Chain = (uint32_t)chain;
+		    chainId.pFile = path;
+		    chainId.Line  = lineNum;
+		}
+		else
+		{
+		    cnt = 0;		// chain ID missing or invalid
+		    memset (id, 0, sizeof(id));
+		}
+		memcpy (prevMac, id, 8);
+		for (i = 0;  i < 4;  i++)
+		{
+		    prevMac[8 + i]  = (uint8_t)(chainId.Boot  >> (24 - 8 * i));
+		    prevMac[12 + i] = (uint8_t)(chainId.Chain >> (24 - 8 * i));
+		}
+	    }
+	    else if (! flgPrev  ||  n != prevNum + 1)
+	    {
+		pStat->Breaks++;
+		if (l_flgVerbose)
+		    printf ("%s:%u: chain break: block #%06lu after %s%06lu\n",
+			    path, lineNum, n, flgPrev ? "#" : "start, ",
+			    flgPrev ? prevNum : 0);
+		if (! flgPrev)
+		    memset (prevMac, 0, sizeof(prevMac));
+	    }
+
+	    cmac (pKey, prevMac, pBuf + start, len, res);
+	    if (n == 0  &&  cnt != 6)
+	    {
+		pStat->Bad++;
+		if (l_flgVerbose)
+		    printf ("%s:%u: block #%06lu: no chain ID\n",
+			    path, lineNum, n);
+	    }
+	    else if (memcmp (res, mac, 16) != 0)
+	    {
+		pStat->Bad++;
+		if (l_flgVerbose)
+		    printf ("%s:%u: block #%06lu: bad MAC\n", path, lineNum, n);
+	    }
+	    else if (n == 0  &&  pKey->flgHwId  &&  chainId.HwId != pKey->HwId)
+	    {
+		pStat->Bad++;
+		if (l_flgVerbose)
+		    printf ("%s:%u: block #%06lu: HW-ID %016llX is not box %d\n",
+			    path, lineNum, n, (unsigned long long)chainId.HwId,
+			    chainId.Box);
+	    }
+	    else
+	    {
+		pStat->AuthBytes += len;
+		if (n == 0)
+		{
+		    /* Chains must be in ascending order within the file */
+		    if (flgId  &&  chainCompare (&prevId, &chainId) >= 0)
+		    {
+			pStat->Breaks++;
+			if (l_flgVerbose)
+			    printf ("%s:%u: chain %lu.%lu after %lu.%lu\n",
+				    path, lineNum, (unsigned long)chainId.Boot,
+				    (unsigned long)chainId.Chain,
+				    (unsigned long)prevId.Boot,
+				    (unsigned long)prevId.Chain);
+		    }
+		    prevId = chainId;
+		    flgId = true;
+		    if (! addChain (&chainId))
+		    {
+			free (pBuf);
+			return -1;
+		    }
+		}
+	    }
+	}
+
+	memcpy (prevMac, mac, sizeof(prevMac));
+	prevNum = n;
+	flgPrev = true;
+	authEnd = end;
+    }
+
+    /* Data after the last trailer */
+    if ((size_t)size > authEnd)
+    {
+	pStat->UnauthBytes += size - authEnd;
+	if (l_flgVerbose)
+	    printf ("%s: %lu unauthenticated bytes at the end\n", path,
+		    (unsigned long)(size - authEnd));
+    }
+
+    free (pBuf);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Store a Chain ID
+ *
+ * @return
+ *	<b>false</b> if out of memory.
+ *
+ ******************************************************************************/
+static bool	addChain (const CHAIN_ID *pId)
+{
+CHAIN_ID *pNew;
+
+
+    if (l_ChainCnt >= l_ChainMax)
+    {
+	pNew = realloc (l_pChain, (l_ChainMax + CHAIN_ALLOC) * sizeof(*pNew));
+	if (pNew == NULL)
+	{
+	    fprintf (stderr, "%s: out of memory\n", pId->pFile);
+	    return false;
+	}
+	l_pChain = pNew;
+	l_ChainMax += CHAIN_ALLOC;
+    }
+    l_pChain[l_ChainCnt++] = *pId;
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Compare two Chain IDs by Box, Boot Counter, and Chain Number
+ *
+ ******************************************************************************/
+static int	chainCompare (const void *p1, const void *p2)
+{
+const CHAIN_ID *pA = p1, *pB = p2;
+
+
+    if (pA->Box != pB->Box)
+	return pA->Box < pB->Box ? -1 : 1;
+    if (pA->Boot != pB->Boot)
+	return pA->Boot < pB->Boot ? -1 : 1;
+    if (pA->Chain != pB->Chain)
+	return pA->Chain < pB->Chain ? -1 : 1;
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Check the Continuity of the Chains
+ *
+ * This routine sorts the chain IDs of all files and prints one line per box
+ * with the number of chains and boots, and the missing, duplicate, and
+ * foreign chains.
+ *
+ * @return
+ *	Total number of continuity errors.
+ *
+ ******************************************************************************/
+static uint32_t	checkChains (void)
+{
+const CHAIN_ID *pId, *pFirst = NULL, *pPrev = NULL;
+uint32_t boots = 0, chains = 0, missing = 0, dup = 0, foreign = 0, errors = 0;
+size_t	 i;
+
+
+    qsort (l_pChain, l_ChainCnt, sizeof(*l_pChain), chainCompare);
+
+    printf ("\n%-6s %-16s %8s %6s %8s %9s %7s\n", "Box", "HW-ID", "Chains",
+	    "Boots", "Missing", "Duplicate", "Foreign");
+
+    for (i = 0;  i <= l_ChainCnt;  i++)
+    {
+	pId = (i < l_ChainCnt ? &l_pChain[i] : NULL);
+
+	if (pFirst != NULL  &&  (pId == NULL  ||  pId->Box != pFirst->Box))
+	{
+	    /* End of a box */
+	    printf ("%-6d %016llX %8u %6u %8u %9u %7u\n", pFirst->Box,
+		    (unsigned long long)pFirst->HwId, chains, boots,
+		    missing, dup, foreign);
+	    errors += missing + dup + foreign;
+	    pFirst = pPrev = NULL;
+	    boots = chains = missing = dup = foreign = 0;
+	}
+	if (pId == NULL)
+	    break;
+
+	if (pFirst == NULL)
+	    pFirst = pId;
+	chains++;
+
+	if (pId->HwId != pFirst->HwId)
+	{
+	    foreign++;
+	    if (l_flgVerbose)
+		printf ("%s:%u: chain %lu.%lu: HW-ID %016llX, box %d has"
+			" %016llX\n", pId->pFile, pId->Line,
+			(unsigned long)pId->Boot, (unsigned long)pId->Chain,
+			(unsigned long long)pId->HwId, pId->Box,
+			(unsigned long long)pFirst->HwId);
+	}
+
+	if (pPrev == NULL  ||  pId->Boot != pPrev->Boot)
+	{
+	    /* First chain of a boot must have number 0 */
+	    boots++;
+	    if (pId->Chain > 0)
+	    {
+		missing += pId->Chain;
+		if (l_flgVerbose)
+		    printf ("%s:%u: chain %lu.%lu: %lu chains missing before\n",
+			    pId->pFile, pId->Line, (unsigned long)pId->Boot,
+			    (unsigned long)pId->Chain,
+			    (unsigned long)pId->Chain);
+	    }
+	}
+	else if (pId->Chain == pPrev->Chain)
+	{
+	    dup++;
+	    if (l_flgVerbose)
+		printf ("%s:%u: chain %lu.%lu: duplicate of %s:%u\n",
+			pId->pFile, pId->Line, (unsigned long)pId->Boot,
+			(unsigned long)pId->Chain, pPrev->pFile, pPrev->Line);
+	}
+	else if (pId->Chain != pPrev->Chain + 1)
+	{
+	    missing += pId->Chain - pPrev->Chain - 1;
+	    if (l_flgVerbose)
+		printf ("%s:%u: chain %lu.%lu: %lu chains missing before\n",
+			pId->pFile, pId->Line, (unsigned long)pId->Boot,
+			(unsigned long)pId->Chain,
+			(unsigned long)(pId->Chain - pPrev->Chain - 1));
+	}
+	pPrev = pId;
+    }
+
+    return errors;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Parse Hex Digits
+ *
+ ******************************************************************************/
+static bool	parseHex (const char *pStr, uint8_t *pOut, int cnt)
+{
+int	 i, hi, lo;
+
+
+    for (i = 0;  i < cnt;  i++)
+    {
+	if (! isxdigit ((int)pStr[2*i])  ||  ! isxdigit ((int)pStr[2*i+1]))
+	    return false;
+	hi = isdigit ((int)pStr[2*i])   ? pStr[2*i] - '0'
+				       : toupper ((int)pStr[2*i]) - 'A' + 10;
+	lo = isdigit ((int)pStr[2*i+1]) ? pStr[2*i+1] - '0'
+				       : toupper ((int)pStr[2*i+1]) - 'A' + 10;
+	pOut[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Prepare a Key
+ *
+ * This routine expands the AES key and derives the CMAC subkeys.
+ *
+ ******************************************************************************/
+static void	keyPrepare (KEY *pKey, const uint8_t *pKeyData)
+{
+uint8_t	 L[16];
+int	 i;
+
+
+    aesKeyExpand (pKeyData, pKey->Rk);
+    memset (L, 0, sizeof(L));
+    aesEncrypt (pKey->Rk, L);
+
+    for (i = 0;  i < 15;  i++)
+	pKey->K1[i] = (uint8_t)((L[i] << 1) | (L[i+1] >> 7));
+    pKey->K1[15] = (uint8_t)((L[15] << 1) ^ ((L[0] & 0x80) ? 0x87 : 0));
+
+    for (i = 0;  i < 15;  i++)
+	pKey->K2[i] = (uint8_t)((pKey->K1[i] << 1) | (pKey->K1[i+1] >> 7));
+    pKey->K2[15] = (uint8_t)((pKey->K1[15] << 1)
+			     ^ ((pKey->K1[0] & 0x80) ? 0x87 : 0));
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	AES-CMAC of a chained Block
+ *
+ * The message is the previous MAC (16 bytes, omitted if @p pPrev is NULL),
+ * followed by @p len bytes of data.
+ *
+ ******************************************************************************/
+static void	cmac (const KEY *pKey, const uint8_t *pPrev,
+		      const uint8_t *pData, size_t len, uint8_t *pMac)
+{
+uint8_t	 x[16], blk[16];
+size_t	 total, pos, i;
+
+
+    total = (pPrev != NULL ? 16 : 0) + len;
+    memset (x, 0, sizeof(x));
+
+    for (pos = 0;  ;  pos += 16)
+    {
+	/* Get the next block of the message */
+	for (i = 0;  i < 16  &&  pos + i < total;  i++)
+	{
+	    if (pPrev != NULL)
+		blk[i] = (pos + i < 16 ? pPrev[pos + i] : pData[pos + i - 16]);
+	    else
+		blk[i] = pData[pos + i];
+	}
+
+	if (pos + 16 >= total)
+	{
+	    /* Last block: complete with K1, padded with K2 */
+	    if (i == 16)
+	    {
+		for (i = 0;  i < 16;  i++)
+		    x[i] ^= blk[i] ^ pKey->K1[i];
+	    }
+	    else
+	    {
+		blk[i] = 0x80;
+		while (++i < 16)
+		    blk[i] = 0;
+		for (i = 0;  i < 16;  i++)
+		    x[i] ^= blk[i] ^ pKey->K2[i];
+	    }
+	    aesEncrypt (pKey->Rk, x);
+	    break;
+	}
+
+	for (i = 0;  i < 16;  i++)
+	    x[i] ^= blk[i];
+	aesEncrypt (pKey->Rk, x);
+    }
+
+    memcpy (pMac, x, 16);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Expand a 128 bit AES Key into 11 Round Keys
+ *
+ ******************************************************************************/
+static void	aesKeyExpand (const uint8_t *pKey, uint8_t *pRk)
+{
+uint8_t	 t[4], u, rcon = 1;
+int	 i, j;
+
+
+    memcpy (pRk, pKey, 16);
+    for (i = 16;  i < 176;  i += 4)
+    {
+	memcpy (t, pRk + i - 4, 4);
+	if (i % 16 == 0)
+	{
+	    u = t[0];
+	    t[0] = l_SBox[t[1]] ^ rcon;
+	    t[1] = l_SBox[t[2]];
+	    t[2] = l_SBox[t[3]];
+	    t[3] = l_SBox[u];
+	    rcon = XTIME(rcon);
+	}
+	for (j = 0;  j < 4;  j++)
+	    pRk[i + j] = pRk[i - 16 + j] ^ t[j];
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	AES-128 Encryption of one Block in place
+ *
+ ******************************************************************************/
+static void	aesEncrypt (const uint8_t *pRk, uint8_t *s)
+{
+uint8_t	 t[16], a, b, c, d, e;
+int	 r, i;
+
+
+    for (i = 0;  i < 16;  i++)
+	s[i] ^= pRk[i];
+
+    for (r = 1;  r <= 10;  r++)
+    {
+	/* SubBytes and ShiftRows */
+	for (i = 0;  i < 16;  i++)
+	    t[i] = l_SBox[s[(i + 4 * (i % 4)) % 16]];
+
+	/* MixColumns, except for the last round */
+	for (i = 0;  i < 16;  i += 4)
+	{
+	    a = t[i];  b = t[i+1];  c = t[i+2];  d = t[i+3];
+	    if (r < 10)
+	    {
+		e = a ^ b ^ c ^ d;
+		a ^= e ^ XTIME(t[i]   ^ t[i+1]);
+		b ^= e ^ XTIME(t[i+1] ^ t[i+2]);
+		c ^= e ^ XTIME(t[i+2] ^ t[i+3]);
+		d ^= e ^ XTIME(t[i+3] ^ t[i]);
+	    }
+	    s[i]   = a ^ pRk[16*r + i];
+	    s[i+1] = b ^ pRk[16*r + i + 1];
+	    s[i+2] = c ^ pRk[16*r + i + 2];
+	    s[i+3] = d ^ pRk[16*r + i + 3];
+	}
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Print Usage and exit
+ *
+ ******************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: LogMac -k <keyfile> [-u] [-v] <BOXnnnn.TXT>...\n");
+    exit (1);
+}
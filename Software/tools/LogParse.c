@@ -0,0 +1,421 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Log File Parser
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This module is shared by the host tools.  It decodes the lines of a TAMDL
+ * log file (BOX*.TXT) into a compact, typed record @ref LP_ENTRY.  Only the
+ * entries that are of interest for an analysis are decoded, all others are
+ * returned as @ref LP_OTHER so they can still be counted.
+ *
+ * The format of a log line is generated by logMsg() in Logging.c:
+ * 20151231-235900.000 \<message\>
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "LogParse.h"
+
+/*================================ Local Data ================================*/
+
+    /* Names of the power outputs, indexed by LP_OUTPUT */
+static const char *l_OutputName[LP_NUM_OUT] = { "UA1", "UA2", "BATT" };
+
+    /* Names of the entry kinds, indexed by LP_KIND */
+static const char *l_KindName[LP_NUM_KINDS] =
+{
+    "OTHER", "ERROR", "TAG", "TAG_ABSENT", "OUT_ON", "OUT_OFF", "ALL_OFF",
+    "MEASURE", "BAT_CAPACITY", "BAT_RUNTIME", "BAT_VOLTAGE", "BAT_CURRENT",
+    "DCF77_SYNC", "POWER_FAIL", "LOG_LOST"
+};
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	parseDigits (const char *str, int cnt, uint32_t *pValue);
+static bool	parseFixed (const char **ppStr, int32_t *pMilli);
+static int	parseOutput (const char *str);
+static bool	startsWith (const char *str, const char *prefix,
+			    const char **ppRest);
+
+
+/***************************************************************************//**
+ *
+ * @brief	Parse a Log Line
+ *
+ * This routine decodes a single line of a log file.
+ *
+ * @param[in] line
+ *	Log line, may be terminated by <CR><LF>.
+ *
+ * @param[out] pEntry
+ *	Address of the structure to store the decoded entry.
+ *
+ * @return
+ *	<i>true</i> if the line contains a valid timestamp, <i>false</i> if it
+ *	is corrupted.  Entries without a valid clock, i.e. timestamp
+ *	"00000000-000000.000", return <i>true</i> with a Date of 0.
+ *
+ ******************************************************************************/
+bool	 LogParseLine (const char *line, LP_ENTRY *pEntry)
+{
+uint32_t hms, ms;
+const char *pMsg, *pRest;
+int32_t	 value;
+int	 d, h, m, out;
+
+
+    memset (pEntry, 0, sizeof(*pEntry));
+
+    /* Timestamp: YYYYMMDD-HHMMSS.mmm<SP> */
+    if (! parseDigits (line, 8, &pEntry->Date)  ||  line[8] != '-'
+    ||  ! parseDigits (line + 9, 6, &hms)  ||  line[15] != '.'
+    ||  ! parseDigits (line + 16, 3, &ms)  ||  line[19] != ' ')
+	return false;
+
+    pEntry->MilliSec = ((hms / 10000) * 3600 + ((hms / 100) % 100) * 60
+			+ hms % 100) * 1000 + ms;
+    pMsg = line + 20;
+    pEntry->Kind = LP_OTHER;
+
+    /* Optional sequence number: #nnnnnn<SP>, see LOG_SEQ_NUM */
+    pEntry->Seq = -1;
+    if (pMsg[0] == '#'  &&  parseDigits (pMsg + 1, LOG_SEQ_DIGITS, &hms)
+    &&  pMsg[1 + LOG_SEQ_DIGITS] == ' ')
+    {
+	pEntry->Seq = hms;
+	pMsg += LOG_SEQ_DIGITS + 2;
+    }
+
+    if (startsWith (pMsg, "Transponder: ", &pRest))
+    {
+	for (d = 0;  d < TAG_ID_MAX_SIZE - 1 && isxdigit((int)pRest[d]);  d++)
+	    pEntry->Tag[d] = pRest[d];
+	pEntry->Tag[d] = EOS;
+
+	if (d > 0)
+	{
+	    pRest += d;
+	    if (*pRest == '\r'  ||  *pRest == '\n'  ||  *pRest == EOS)
+		pEntry->Kind = LP_TAG;
+	    else if (strncmp (pRest, " ABSENT", 7) == 0)
+		pEntry->Kind = LP_TAG_ABSENT;
+	}
+    }
+    else if (startsWith (pMsg, "Power Output ", &pRest))
+    {
+	out = parseOutput (pRest);
+	if (out >= 0)
+	{
+	    pRest = strchr (pRest, ' ');
+	    if (pRest != NULL  &&  startsWith (pRest, " enabled", NULL))
+		pEntry->Kind = LP_OUT_ON;
+	    else if (pRest != NULL  &&  startsWith (pRest, " disabled", NULL))
+		pEntry->Kind = LP_OUT_OFF;
+	    pEntry->A = out;
+	}
+    }
+    else if (startsWith (pMsg, "Switching all power outputs OFF", NULL))
+    {
+	pEntry->Kind = LP_ALL_OFF;
+    }
+    else if ((startsWith (pMsg, "UA1     : ", &pRest)  && (out = LP_OUT_UA1, 1))
+	 ||  (startsWith (pMsg, "UA2     : ", &pRest)  && (out = LP_OUT_UA2, 1))
+	 ||  (startsWith (pMsg, "BATT_INP: ", &pRest)  && (out = LP_OUT_BATT, 1)))
+    {
+	if (parseFixed (&pRest, &pEntry->B)  &&  *pRest++ == 'V'
+	&&  parseFixed (&pRest, &value)  &&  strncmp (pRest, "mA", 2) == 0)
+	{
+	    pEntry->Kind = LP_MEASURE;
+	    pEntry->A = out;
+	    pEntry->C = value / 1000;
+	}
+    }
+    else if (startsWith (pMsg, "Battery Remaining Capacity: ", &pRest))
+    {
+	if (parseFixed (&pRest, &value))
+	{
+	    pEntry->Kind = LP_BAT_CAPACITY;
+	    pEntry->B = value / 1000;
+	}
+    }
+    else if (startsWith (pMsg, "Battery Runtime to empty  : ", &pRest))
+    {
+	if (sscanf (pRest, "%dd %dh %dm", &d, &h, &m) == 3)
+	{
+	    pEntry->Kind = LP_BAT_RUNTIME;
+	    pEntry->B = (d * 24 + h) * 60 + m;
+	}
+	else if (startsWith (pRest, "> 45 days", NULL))
+	{
+	    pEntry->Kind = LP_BAT_RUNTIME;
+	    pEntry->B = 65535;
+	}
+    }
+    else if (startsWith (pMsg, "Battery Actual Voltage    : ", &pRest))
+    {
+	if (parseFixed (&pRest, &pEntry->B))
+	    pEntry->Kind = LP_BAT_VOLTAGE;
+    }
+    else if (startsWith (pMsg, "Battery Actual Current    : ", &pRest))
+    {
+	if (parseFixed (&pRest, &value))
+	{
+	    pEntry->Kind = LP_BAT_CURRENT;
+	    pEntry->B = value / 1000;
+	}
+    }
+    else if (startsWith (pMsg, "DCF77: Time Synchronization", NULL))
+    {
+	pEntry->Kind = LP_DCF77_SYNC;
+    }
+    else if (startsWith (pMsg, "Power-Fail: Received interrupt (POWER ", &pRest))
+    {
+	pEntry->Kind = LP_POWER_FAIL;
+	pEntry->B = (strncmp (pRest, "FAIL", 4) == 0);
+    }
+    else if (startsWith (pMsg, "ERROR Log Lost: ", &pRest))
+    {
+	/* loss burst report "Log Lost: N entries #first-#last ..." */
+	pEntry->Kind = LP_LOG_LOST;
+	pEntry->B = atoi (pRest);
+	pEntry->A = pEntry->C = -1;
+	pRest = strchr (pRest, '#');
+	if (pRest != NULL)
+	{
+	    pEntry->C = atoi (pRest + 1);
+	    pRest = strchr (pRest, '-');
+	    if (pRest != NULL  &&  pRest[1] == '#')
+		pEntry->A = atoi (pRest + 2);
+	}
+    }
+    else if (startsWith (pMsg, "ERROR", &pRest))
+    {
+	pEntry->Kind = LP_ERROR;
+	pRest = strstr (pRest, "lost ");
+	if (pRest != NULL  &&  strstr (pRest, "Messages") != NULL)
+	{
+	    pEntry->Kind = LP_LOG_LOST;
+	    pEntry->B = atoi (pRest + 5);
+	}
+    }
+
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get Box Number from Path
+ *
+ * This routine extracts the box number <i>nnnn</i> from a path that ends
+ * in <b>BOX<i>nnnn</i>.TXT</b>, see @ref SD_Card.  The basename may have
+ * an arbitrary prefix.
+ *
+ * @return
+ *	Box number, or -1 if the filename does not follow this schema.
+ *
+ ******************************************************************************/
+int	 LogParseBoxNumber (const char *path)
+{
+const char *pName;
+int	 num, i;
+
+
+    pName = strrchr (path, '/');
+    pName = (pName == NULL ? path : pName + 1);
+
+    /* the basename may carry a prefix, e.g. "6_rawdata_BOX0999.TXT" */
+    for ( ;  *pName != EOS;  pName++)
+    {
+	if (strncasecmp (pName, "BOX", 3) != 0)
+	    continue;
+
+	for (num = 0, i = 3;  isdigit((int)pName[i]);  i++)
+	    num = num * 10 + (pName[i] - '0');
+
+	if (i > 3  &&  pName[i] == '.')
+	    return num;
+    }
+
+    return -1;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get Names for Outputs and Kinds
+ *
+ ******************************************************************************/
+const char *LogParseOutputName (int output)
+{
+    return (output >= 0  &&  output < LP_NUM_OUT ? l_OutputName[output] : "?");
+}
+
+const char *LogParseKindName (int kind)
+{
+    return (kind >= 0  &&  kind < LP_NUM_KINDS ? l_KindName[kind] : "?");
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Convert Date to Day Number
+ *
+ * This routine converts a date of the form YYYYMMDD into the number of days
+ * since 1970-01-01, which allows simple calculations across month and year
+ * boundaries.  LogParseDayToDate() performs the reverse operation.
+ *
+ ******************************************************************************/
+int64_t	 LogParseDayNumber (uint32_t date)
+{
+int64_t	 y = date / 10000;
+int	 m = (date / 100) % 100;
+int	 d = date % 100;
+int64_t	 era, yoe, doy;
+
+
+    y -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+uint32_t LogParseDayToDate (int64_t dayNum)
+{
+int64_t	 z, era, doe, yoe, y, doy, mp, d, m;
+
+
+    z = dayNum + 719468;
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = z - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    y = yoe + era * 400;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp + (mp < 10 ? 3 : -9);
+    y += (m <= 2);
+
+    return (uint32_t)(y * 10000 + m * 100 + d);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Content Hash
+ *
+ * Calculates a 64 bit FNV-1a hash over a block of data.  The hash can be
+ * calculated incrementally by passing the result of the previous call,
+ * starting with @ref LOG_PARSE_HASH_INIT.
+ *
+ ******************************************************************************/
+uint64_t LogParseHash (uint64_t hash, const void *data, size_t len)
+{
+const uint8_t *pData = data;
+
+
+    while (len-- > 0)
+    {
+	hash ^= *pData++;
+	hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static bool	parseDigits (const char *str, int cnt, uint32_t *pValue)
+{
+uint32_t value = 0;
+
+
+    while (cnt-- > 0)
+    {
+	if (! isdigit((int)*str))
+	    return false;
+	value = value * 10 + (*str++ - '0');
+    }
+    *pValue = value;
+    return true;
+}
+
+    /* Parse a decimal fixed point number like "12.9" and return it * 1000 */
+static bool	parseFixed (const char **ppStr, int32_t *pMilli)
+{
+const char *pStr = *ppStr;
+int32_t	 value = 0, scale = 1000;
+bool	 neg = false;
+
+
+    while (*pStr == ' ')
+	pStr++;
+
+    if (*pStr == '-')
+    {
+	neg = true;
+	pStr++;
+    }
+
+    if (! isdigit((int)*pStr))
+	return false;
+
+    while (isdigit((int)*pStr))
+	value = value * 10 + (*pStr++ - '0');
+    value *= 1000;
+
+    if (*pStr == '.')
+    {
+	for (pStr++;  isdigit((int)*pStr);  pStr++)
+	{
+	    scale /= 10;
+	    value += (*pStr - '0') * scale;
+	}
+    }
+
+    *pMilli = (neg ? -value : value);
+    *ppStr = pStr;
+    return true;
+}
+
+static int	parseOutput (const char *str)
+{
+int	 i;
+
+
+    for (i = 0;  i < LP_NUM_OUT;  i++)
+    {
+	size_t len = strlen (l_OutputName[i]);
+	if (strncmp (str, l_OutputName[i], len) == 0  &&  str[len] == ' ')
+	    return i;
+    }
+    return -1;
+}
+
+static bool	startsWith (const char *str, const char *prefix,
+			    const char **ppRest)
+{
+size_t	 len = strlen (prefix);
+
+
+    if (strncmp (str, prefix, len) != 0)
+	return false;
+
+    if (ppRest != NULL)
+	*ppRest = str + len;
+    return true;
+}
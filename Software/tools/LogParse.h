@@ -0,0 +1,99 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Header file of module LogParse.c
+ * @author	agent
+ * @version	2026-10-19
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Added sequence number and loss burst report.
+2026-10-19,agent Initial version.
+*/
+
+#ifndef __INC_LogParse_h
+#define __INC_LogParse_h
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*=============================== Definitions ================================*/
+
+#define EOS		'\0'		/* EndOfString		*/
+
+    /* macro to calculate the number of elements of an array */
+#define ELEM_CNT(array)  (sizeof (array) / sizeof ((array)[0]))
+
+    /*!@brief Maximum length of a log line, incl. <CR><LF> and EOS. */
+#define LOG_LINE_MAX_SIZE	256
+
+    /*!@brief Number of digits of a sequence number, see LOG_SEQ_NUM. */
+#define LOG_SEQ_DIGITS		6
+
+    /*!@brief Maximum length of a transponder ID string. */
+#define TAG_ID_MAX_SIZE		24
+
+/*!@brief Power Outputs as they appear in the log, see PowerOutput(). */
+typedef enum
+{
+    LP_OUT_UA1,			//!< Power Output UA1
+    LP_OUT_UA2,			//!< Power Output UA2
+    LP_OUT_BATT,		//!< Power Output BATT (resp. BATT_INP)
+    LP_NUM_OUT
+} LP_OUTPUT;
+
+/*!@brief Kind of a parsed log entry.
+ *
+ * These values are stored in the "kind" column of the log store and must
+ * therefore never be renumbered.  New kinds must be appended at the end.
+ */
+typedef enum
+{
+    LP_OTHER,			//!<  0: Not decoded, only counted
+    LP_ERROR,			//!<  1: "ERROR ..." entry
+    LP_TAG,			//!<  2: Transponder detected, a=tag, b=0
+    LP_TAG_ABSENT,		//!<  3: Transponder absent, a=tag
+    LP_OUT_ON,			//!<  4: Power Output enabled, a=output
+    LP_OUT_OFF,			//!<  5: Power Output disabled, a=output
+    LP_ALL_OFF,			//!<  6: All power outputs switched off
+    LP_MEASURE,			//!<  7: U/I measurement, a=output, b=mV, c=mA
+    LP_BAT_CAPACITY,		//!<  8: Remaining capacity, b=mAh
+    LP_BAT_RUNTIME,		//!<  9: Runtime to empty, b=min
+    LP_BAT_VOLTAGE,		//!< 10: Battery voltage, b=mV
+    LP_BAT_CURRENT,		//!< 11: Battery current, b=mA
+    LP_DCF77_SYNC,		//!< 12: DCF77 time synchronization
+    LP_POWER_FAIL,		//!< 13: Power-Fail, b=1 for FAIL, 0 for GOOD
+    LP_LOG_LOST,		//!< 14: Lost log entries, b=count,
+				//!<     c=first seq, a=last seq
+    LP_NUM_KINDS
+} LP_KIND;
+
+/*!@brief One parsed log entry */
+typedef struct
+{
+    uint32_t	Date;		//!< Date as decimal YYYYMMDD, 0 if clock unset
+    uint32_t	MilliSec;	//!< Time of day in [ms]
+    int32_t	Seq;		//!< Sequence number, -1 if not present
+    uint8_t	Kind;		//!< Kind of entry, see @ref LP_KIND
+    uint32_t	A;		//!< First argument (output, tag index)
+    int32_t	B;		//!< Second argument (value)
+    int32_t	C;		//!< Third argument (value)
+    char	Tag[TAG_ID_MAX_SIZE]; //!< Transponder ID for LP_TAG[_ABSENT]
+} LP_ENTRY;
+
+/*================================ Prototypes ================================*/
+
+bool	 LogParseLine (const char *line, LP_ENTRY *pEntry);
+int	 LogParseBoxNumber (const char *path);
+const char *LogParseOutputName (int output);
+const char *LogParseKindName (int kind);
+int64_t	 LogParseDayNumber (uint32_t date);
+uint32_t LogParseDayToDate (int64_t dayNum);
+uint64_t LogParseHash (uint64_t hash, const void *data, size_t len);
+
+    /*!@brief Initial value for LogParseHash(). */
+#define LOG_PARSE_HASH_INIT	0xCBF29CE484222325ULL
+
+
+#endif /* __INC_LogParse_h */
@@ -0,0 +1,1207 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Columnar Log Store
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool incrementally ingests TAMDL log files (BOX*.TXT) into an
+ * on-disk columnar store and answers aggregate queries from the stored
+ * columns, so the text of a season has to be parsed only once.
+ *
+ * Usage:
+ * @code
+ * LogStore ingest <store> <BOXnnnn.TXT>...
+ * LogStore query  <store> summary|visits|onhours|battery [options]
+ * LogStore bench  <store> [options]
+ *
+ * Options:  -b <box>  -f <YYYYMMDD>  -t <YYYYMMDD>
+ * @endcode
+ *
+ * Layout of the store directory:
+ * - <b>INDEX</b> holds one line per ingested file: the content hash, the
+ *   number of bytes, and the box number.  A file whose hash is already
+ *   listed is skipped, i.e. re-ingesting is a no-op.  A log file that has
+ *   grown since the last ingest is recognized by the hash of its prefix,
+ *   and only the new tail is ingested.
+ * - <b>TAGS</b> is the transponder dictionary, one ID per line.  Column A
+ *   of @ref LP_TAG entries holds the line index into this file.
+ * - <b>nnnn/YYYYMMDD.col</b> is the partition of box <i>nnnn</i> for one
+ *   day.  It consists of a header @ref PART_HDR and the columns T (time of
+ *   day in [ms]), K (kind), A, B, and C, each stored contiguously, so a
+ *   query only reads the columns it needs.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Magic number of a partition file. */
+#define PART_MAGIC	0x31534354	// "TCS1"
+
+    /*!@brief Maximum number of transponder IDs in the dictionary. */
+#define MAX_TAGS	65536
+
+    /*!@brief Maximum number of days a single ingest run may touch. */
+#define MAX_DAYS	4096
+
+    /*!@brief Maximum length of a path name. */
+#define PATH_MAX_SIZE	512
+
+/*!@brief Column identifiers of a partition */
+typedef enum
+{
+    COL_T,			//!< Time of day in [ms], uint32_t
+    COL_K,			//!< Kind of entry, uint8_t
+    COL_A,			//!< Argument A, uint32_t
+    COL_B,			//!< Argument B, int32_t
+    COL_C,			//!< Argument C, int32_t
+    NUM_COLS
+} COL_ID;
+
+/*!@brief Header of a partition file */
+typedef struct
+{
+    uint32_t	Magic;		//!< Must be @ref PART_MAGIC
+    uint32_t	Rows;		//!< Number of rows in this partition
+} PART_HDR;
+
+/*!@brief In-memory partition, i.e. all rows of one box and one day */
+typedef struct
+{
+    uint32_t	Date;		//!< Date YYYYMMDD of this partition
+    uint32_t	Rows;		//!< Number of rows
+    uint32_t	Size;		//!< Number of allocated rows
+    uint32_t   *T;		//!< Column T
+    uint8_t    *K;		//!< Column K
+    uint32_t   *A;		//!< Column A
+    int32_t    *B;		//!< Column B
+    int32_t    *C;		//!< Column C
+} PART;
+
+/*!@brief Entry of the ingest index */
+typedef struct
+{
+    uint64_t	Hash;		//!< Content hash of the first <Bytes> bytes
+    long	Bytes;		//!< Number of bytes covered by the hash
+    int		Box;		//!< Box number
+} INDEX_ENTRY;
+
+/*!@brief Query options */
+typedef struct
+{
+    int		Box;		//!< Box number, or -1 for all boxes
+    uint32_t	From;		//!< First date, 0 for no limit
+    uint32_t	To;		//!< Last date, 0 for no limit
+} QUERY_OPT;
+
+/*!@brief Callback to process one partition during a query */
+typedef void	(*PART_FCT)(int box, uint32_t date, FILE *fp,
+			    const PART_HDR *pHdr, void *pCtx);
+
+/*================================ Local Data ================================*/
+
+    /* Size of one element per column */
+static const size_t l_ColSize[NUM_COLS] = { 4, 1, 4, 4, 4 };
+
+    /* Ingest index */
+static INDEX_ENTRY *l_Index;
+static int	l_IndexCnt, l_IndexSize;
+
+    /* Transponder dictionary and its hash table */
+static char	(*l_Tag)[TAG_ID_MAX_SIZE];
+static int	l_TagCnt, l_TagCntStored;
+static int32_t	l_TagHash[2 * MAX_TAGS];
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	cmdIngest (const char *store, int argc, char **argv);
+static int	cmdQuery (const char *store, const char *name,
+			  const QUERY_OPT *pOpt, FILE *out);
+static int	cmdBench (const char *store, const QUERY_OPT *pOpt);
+static int	ingestFile (const char *store, const char *path,
+			    long *pLines, long *pBytes);
+static void	indexLoad (const char *store);
+static void	indexAppend (const char *store, const INDEX_ENTRY *pEntry);
+static void	tagLoad (const char *store);
+static void	tagSave (const char *store);
+static uint32_t	tagIndex (const char *tag);
+static void	partAppend (PART *pPart, const LP_ENTRY *pEntry);
+static void	partFree (PART *pPart);
+static int	partMerge (const char *store, int box, PART *pPart);
+static size_t	colOffset (uint32_t rows, COL_ID col);
+static bool	colRead (FILE *fp, const PART_HDR *pHdr, COL_ID col, void *buf);
+static int	forEachPart (const char *store, const QUERY_OPT *pOpt,
+			     PART_FCT fct, void *pCtx);
+static double	timeNow (void);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+QUERY_OPT opt = { -1, 0, 0 };
+int	 i;
+
+
+    if (argc < 3)
+	usage();
+
+    if (strcmp (argv[1], "ingest") == 0)
+	return cmdIngest (argv[2], argc - 3, argv + 3);
+
+    /* Parse options for query and bench */
+    i = (strcmp (argv[1], "query") == 0 ? 4 : 3);
+    if (i > argc)
+	usage();
+
+    for ( ;  i < argc;  i++)
+    {
+	if (i + 1 >= argc)
+	    usage();
+
+	if (strcmp (argv[i], "-b") == 0)
+	    opt.Box = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-f") == 0)
+	    opt.From = strtoul (argv[++i], NULL, 10);
+	else if (strcmp (argv[i], "-t") == 0)
+	    opt.To = strtoul (argv[++i], NULL, 10);
+	else
+	    usage();
+    }
+
+    if (strcmp (argv[1], "query") == 0)
+	return cmdQuery (argv[2], argv[3], &opt, stdout);
+
+    if (strcmp (argv[1], "bench") == 0)
+	return cmdBench (argv[2], &opt);
+
+    usage();
+    return 1;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Ingest Log Files
+ *
+ * This routine ingests all specified log files into the store and reports
+ * the ingest rate.
+ *
+ ******************************************************************************/
+static int	cmdIngest (const char *store, int argc, char **argv)
+{
+long	 lines = 0, bytes = 0;
+int	 i, done = 0, skipped = 0, errors = 0, rc;
+double	 t0, dt;
+
+
+    if (mkdir (store, 0755) != 0  &&  errno != EEXIST)
+    {
+	perror (store);
+	return 1;
+    }
+
+    indexLoad (store);
+    tagLoad (store);
+
+    t0 = timeNow();
+    for (i = 0;  i < argc;  i++)
+    {
+	rc = ingestFile (store, argv[i], &lines, &bytes);
+	if (rc < 0)
+	    errors++;
+	else if (rc == 0)
+	    skipped++;
+	else
+	    done++;
+    }
+    tagSave (store);
+    dt = timeNow() - t0;
+
+    printf ("Ingested %d files (%d unchanged, %d errors), %ld lines,"
+	    " %.1f MB in %.2fs\n", done, skipped, errors, lines,
+	    bytes / 1e6, dt);
+    if (dt > 0.0)
+	printf ("Ingest rate: %.0f lines/s, %.2f MB/s\n",
+		lines / dt, bytes / 1e6 / dt);
+
+    return (errors ? 1 : 0);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Ingest a Single Log File
+ *
+ * @return
+ *	1 if data has been ingested, 0 if the file has not changed since the
+ *	last ingest, -1 on error.
+ *
+ ******************************************************************************/
+static int	ingestFile (const char *store, const char *path,
+			    long *pLines, long *pBytes)
+{
+FILE	*fp;
+char	*data, *pLine, *pEnd, *pNL;
+long	 size, start;
+uint64_t hash;
+INDEX_ENTRY entry;
+LP_ENTRY rec;
+PART	*pPart;
+static PART l_Part[MAX_DAYS];
+int	 box, partCnt, i;
+
+
+    box = LogParseBoxNumber (path);
+    if (box < 0)
+    {
+	fprintf (stderr, "%s: Filename does not match BOXnnnn.TXT\n", path);
+	return -1;
+    }
+
+    fp = fopen (path, "rb");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+    fseek (fp, 0, SEEK_END);
+    size = ftell (fp);
+    rewind (fp);
+
+    data = malloc (size + 1);
+    if (data == NULL  ||  fread (data, 1, size, fp) != (size_t)size)
+    {
+	fprintf (stderr, "%s: Read error\n", path);
+	fclose (fp);
+	free (data);
+	return -1;
+    }
+    fclose (fp);
+    data[size] = EOS;
+
+    /* Identical content already ingested? */
+    hash = LogParseHash (LOG_PARSE_HASH_INIT, data, size);
+    for (i = 0;  i < l_IndexCnt;  i++)
+    {
+	if (l_Index[i].Hash == hash  &&  l_Index[i].Bytes == size)
+	{
+	    free (data);
+	    return 0;
+	}
+    }
+
+    /* See if this is a grown version of an ingested file of the same box */
+    for (start = 0, i = 0;  i < l_IndexCnt;  i++)
+    {
+	if (l_Index[i].Box == box  &&  l_Index[i].Bytes > start
+	&&  l_Index[i].Bytes < size
+	&&  LogParseHash (LOG_PARSE_HASH_INIT, data, l_Index[i].Bytes)
+	    == l_Index[i].Hash)
+	    start = l_Index[i].Bytes;
+    }
+
+    /* Parse all lines and group them by day */
+    partCnt = 0;
+    pPart = NULL;
+    for (pLine = data + start, pEnd = data + size;  pLine < pEnd;  pLine = pNL)
+    {
+	pNL = memchr (pLine, '\n', pEnd - pLine);
+	pNL = (pNL == NULL ? pEnd : pNL + 1);
+	(*pLines)++;
+
+	if (! LogParseLine (pLine, &rec)  ||  rec.Date == 0)
+	    continue;		// corrupted or clock not set
+
+	if (rec.Kind == LP_TAG  ||  rec.Kind == LP_TAG_ABSENT)
+	    rec.A = tagIndex (rec.Tag);
+
+	if (pPart == NULL  ||  pPart->Date != rec.Date)
+	{
+	    for (i = 0;  i < partCnt  &&  l_Part[i].Date != rec.Date;  i++)
+		;
+	    if (i == partCnt)
+	    {
+		if (partCnt == MAX_DAYS)
+		{
+		    fprintf (stderr, "%s: More than %d days\n", path, MAX_DAYS);
+		    break;
+		}
+		memset (&l_Part[partCnt], 0, sizeof(PART));
+		l_Part[partCnt++].Date = rec.Date;
+	    }
+	    pPart = &l_Part[i];
+	}
+	partAppend (pPart, &rec);
+    }
+    *pBytes += size - start;
+
+    /* Write partitions */
+    for (i = 0;  i < partCnt;  i++)
+    {
+	if (partMerge (store, box, &l_Part[i]) != 0)
+	    size = -1;
+	partFree (&l_Part[i]);
+    }
+    free (data);
+
+    if (size < 0)
+	return -1;
+
+    entry.Hash = hash;
+    entry.Bytes = size;
+    entry.Box = box;
+    indexAppend (store, &entry);
+
+    return 1;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Query Callbacks
+ *
+ * Every query consists of a callback for forEachPart() which only reads the
+ * columns it requires, and a routine to print the result.
+ *
+ ******************************************************************************/
+
+/*! Context of the "summary" query */
+typedef struct
+{
+    int		Box;		//!< Current box
+    long	Parts;		//!< Number of partitions of this box
+    long	Kinds[LP_NUM_KINDS];	//!< Number of entries per kind
+    FILE       *Out;		//!< Output stream
+} SUMMARY_CTX;
+
+static void	summaryPrint (SUMMARY_CTX *pCtx)
+{
+int	 k;
+
+
+    if (pCtx->Box < 0)
+	return;
+
+    fprintf (pCtx->Out, "%04d %5ld", pCtx->Box, pCtx->Parts);
+    for (k = 0;  k < LP_NUM_KINDS;  k++)
+	fprintf (pCtx->Out, " %ld", pCtx->Kinds[k]);
+    fprintf (pCtx->Out, "\n");
+}
+
+static void	summaryPart (int box, uint32_t date, FILE *fp,
+			     const PART_HDR *pHdr, void *pCtx)
+{
+SUMMARY_CTX *pSum = pCtx;
+uint8_t	*pK = malloc (pHdr->Rows);
+uint32_t i;
+
+
+    (void) date;
+
+    if (box != pSum->Box)
+    {
+	summaryPrint (pSum);
+	memset (pSum->Kinds, 0, sizeof(pSum->Kinds));
+	pSum->Parts = 0;
+	pSum->Box = box;
+    }
+    pSum->Parts++;
+
+    if (pK != NULL  &&  colRead (fp, pHdr, COL_K, pK))
+    {
+	for (i = 0;  i < pHdr->Rows;  i++)
+	    if (pK[i] < LP_NUM_KINDS)
+		pSum->Kinds[pK[i]]++;
+    }
+    free (pK);
+}
+
+
+/*! Context of the "visits" query: transponder detections per week */
+typedef struct
+{
+    uint32_t   *Key;		//!< Hash table: (week << 16 | tag) + 1
+    uint32_t   *Cnt;		//!< Hash table: number of visits
+    uint32_t	Size;		//!< Size of the hash table (power of 2)
+    uint32_t	Used;		//!< Number of used entries
+} VISITS_CTX;
+
+static void	visitsAdd (VISITS_CTX *pCtx, uint32_t key, uint32_t cnt)
+{
+uint32_t h, i, *pOldKey, *pOldCnt, oldSize;
+
+
+    if (2 * (pCtx->Used + 1) > pCtx->Size)
+    {
+	pOldKey = pCtx->Key;
+	pOldCnt = pCtx->Cnt;
+	oldSize = pCtx->Size;
+	pCtx->Size = (oldSize ? 2 * oldSize : 1024);
+	pCtx->Key = calloc (pCtx->Size, sizeof(uint32_t));
+	pCtx->Cnt = calloc (pCtx->Size, sizeof(uint32_t));
+	pCtx->Used = 0;
+	for (i = 0;  i < oldSize;  i++)
+	    if (pOldKey[i])
+		visitsAdd (pCtx, pOldKey[i], pOldCnt[i]);
+	free (pOldKey);
+	free (pOldCnt);
+    }
+
+    for (h = (key * 2654435761U) & (pCtx->Size - 1);
+	 pCtx->Key[h] != 0  &&  pCtx->Key[h] != key;
+	 h = (h + 1) & (pCtx->Size - 1))
+	;
+
+    if (pCtx->Key[h] == 0)
+    {
+	pCtx->Key[h] = key;
+	pCtx->Used++;
+    }
+    pCtx->Cnt[h] += cnt;
+}
+
+static void	visitsPart (int box, uint32_t date, FILE *fp,
+			    const PART_HDR *pHdr, void *pCtx)
+{
+uint8_t	*pK = malloc (pHdr->Rows);
+uint32_t *pA = malloc (pHdr->Rows * sizeof(uint32_t));
+uint32_t i, week;
+int64_t	 day;
+
+
+    (void) box;
+
+    /* Week number relative to 1970, Monday is the first day of a week */
+    day = LogParseDayNumber (date);
+    week = (uint32_t)((day + 3) / 7);
+
+    if (pK != NULL  &&  pA != NULL
+    &&  colRead (fp, pHdr, COL_K, pK)  &&  colRead (fp, pHdr, COL_A, pA))
+    {
+	for (i = 0;  i < pHdr->Rows;  i++)
+	    if (pK[i] == LP_TAG)
+		visitsAdd (pCtx, ((week << 16) | (pA[i] & 0xFFFF)) + 1, 1);
+    }
+    free (pK);
+    free (pA);
+}
+
+static int	visitsCmp (const void *p1, const void *p2)
+{
+uint32_t k1 = *(const uint32_t *)p1, k2 = *(const uint32_t *)p2;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+static void	visitsPrint (VISITS_CTX *pCtx, FILE *out)
+{
+uint32_t *pList, i, n, h, key;
+
+
+    pList = malloc ((pCtx->Used + 1) * sizeof(uint32_t));
+    for (n = 0, i = 0;  i < pCtx->Size;  i++)
+	if (pCtx->Key[i])
+	    pList[n++] = pCtx->Key[i];
+    qsort (pList, n, sizeof(uint32_t), visitsCmp);
+
+    for (i = 0;  i < n;  i++)
+    {
+	key = pList[i];
+	for (h = (key * 2654435761U) & (pCtx->Size - 1);  pCtx->Key[h] != key;
+	     h = (h + 1) & (pCtx->Size - 1))
+	    ;
+	key--;
+	fprintf (out, "%08u %-16s %u\n",
+		 LogParseDayToDate ((int64_t)(key >> 16) * 7 - 3),
+		 (key & 0xFFFF) < (uint32_t)l_TagCnt ? l_Tag[key & 0xFFFF] : "?",
+		 pCtx->Cnt[h]);
+    }
+    free (pList);
+    free (pCtx->Key);
+    free (pCtx->Cnt);
+}
+
+
+/*! Context of the "onhours" query: output-on time per box and output */
+typedef struct
+{
+    int		Box;		//!< Current box
+    int64_t	OnSince[LP_NUM_OUT];	//!< Time [ms] since output is on, or -1
+    int64_t	OnTime[LP_NUM_OUT];	//!< Accumulated on-time in [ms]
+    int64_t	LastTime;	//!< Time [ms] of the last entry of this box
+    FILE       *Out;		//!< Output stream
+} ONHOURS_CTX;
+
+static void	onhoursPrint (ONHOURS_CTX *pCtx)
+{
+int	 o;
+
+
+    if (pCtx->Box < 0)
+	return;
+
+    fprintf (pCtx->Out, "%04d", pCtx->Box);
+    for (o = 0;  o < LP_NUM_OUT;  o++)
+    {
+	/* an output that is still on counts until the last entry */
+	if (pCtx->OnSince[o] >= 0)
+	    pCtx->OnTime[o] += pCtx->LastTime - pCtx->OnSince[o];
+	fprintf (pCtx->Out, " %s=%.2fh", LogParseOutputName (o),
+		 pCtx->OnTime[o] / 3600000.0);
+    }
+    fprintf (pCtx->Out, "\n");
+}
+
+static void	onhoursPart (int box, uint32_t date, FILE *fp,
+			     const PART_HDR *pHdr, void *pCtx)
+{
+ONHOURS_CTX *pOn = pCtx;
+uint8_t	*pK = malloc (pHdr->Rows);
+uint32_t *pT = malloc (pHdr->Rows * sizeof(uint32_t));
+uint32_t *pA = malloc (pHdr->Rows * sizeof(uint32_t));
+int64_t	 dayMs, t;
+uint32_t i;
+int	 o;
+
+
+    if (box != pOn->Box)
+    {
+	onhoursPrint (pOn);
+	for (o = 0;  o < LP_NUM_OUT;  o++)
+	{
+	    pOn->OnSince[o] = -1;
+	    pOn->OnTime[o] = 0;
+	}
+	pOn->Box = box;
+    }
+
+    dayMs = LogParseDayNumber (date) * 86400000LL;
+
+    if (pK != NULL  &&  pT != NULL  &&  pA != NULL
+    &&  colRead (fp, pHdr, COL_K, pK)  &&  colRead (fp, pHdr, COL_T, pT)
+    &&  colRead (fp, pHdr, COL_A, pA))
+    {
+	for (i = 0;  i < pHdr->Rows;  i++)
+	{
+	    t = dayMs + pT[i];
+	    pOn->LastTime = t;
+	    switch (pK[i])
+	    {
+		case LP_OUT_ON:
+		    if (pA[i] < LP_NUM_OUT  &&  pOn->OnSince[pA[i]] < 0)
+			pOn->OnSince[pA[i]] = t;
+		    break;
+
+		case LP_OUT_OFF:
+		    if (pA[i] < LP_NUM_OUT  &&  pOn->OnSince[pA[i]] >= 0)
+		    {
+			pOn->OnTime[pA[i]] += t - pOn->OnSince[pA[i]];
+			pOn->OnSince[pA[i]] = -1;
+		    }
+		    break;
+
+		case LP_ALL_OFF:
+		    for (o = 0;  o < LP_NUM_OUT;  o++)
+		    {
+			if (pOn->OnSince[o] >= 0)
+			    pOn->OnTime[o] += t - pOn->OnSince[o];
+			pOn->OnSince[o] = -1;
+		    }
+		    break;
+
+		default:
+		    break;
+	    }
+	}
+    }
+    free (pK);
+    free (pT);
+    free (pA);
+}
+
+
+/*! Context of the "battery" query: capacity trend per box */
+typedef struct
+{
+    int		Box;		//!< Current box
+    uint32_t	FirstDate, LastDate;	//!< Dates of first and last reading
+    int32_t	First, Last;	//!< First and last remaining capacity [mAh]
+    int32_t	Drop;		//!< Accumulated capacity drop [mAh]
+    int		Days;		//!< Number of days with readings
+    FILE       *Out;		//!< Output stream
+} BATTERY_CTX;
+
+static void	batteryPrint (BATTERY_CTX *pCtx)
+{
+    if (pCtx->Box < 0  ||  pCtx->FirstDate == 0)
+	return;
+
+    /* average over the days with readings, so gaps between seasons and
+     * SD-Card exchanges do not distort the result
+     */
+    fprintf (pCtx->Out, "%04d %08u %5dmAh %08u %5dmAh %6.1fmAh/d\n",
+	     pCtx->Box, pCtx->FirstDate, pCtx->First, pCtx->LastDate,
+	     pCtx->Last, pCtx->Days > 1
+			 ? (double)pCtx->Drop / (pCtx->Days - 1) : 0.0);
+}
+
+static void	batteryPart (int box, uint32_t date, FILE *fp,
+			     const PART_HDR *pHdr, void *pCtx)
+{
+BATTERY_CTX *pBat = pCtx;
+uint8_t	*pK = malloc (pHdr->Rows);
+int32_t	*pB = malloc (pHdr->Rows * sizeof(int32_t));
+uint32_t i;
+
+
+    if (box != pBat->Box)
+    {
+	batteryPrint (pBat);
+	pBat->FirstDate = pBat->LastDate = 0;
+	pBat->Drop = pBat->Days = 0;
+	pBat->Box = box;
+    }
+
+    if (pK != NULL  &&  pB != NULL
+    &&  colRead (fp, pHdr, COL_K, pK)  &&  colRead (fp, pHdr, COL_B, pB))
+    {
+	for (i = 0;  i < pHdr->Rows;  i++)
+	{
+	    if (pK[i] != LP_BAT_CAPACITY)
+		continue;
+
+	    if (pBat->FirstDate == 0)
+	    {
+		pBat->FirstDate = date;
+		pBat->First = pB[i];
+	    }
+	    else if (pB[i] < pBat->Last)
+	    {
+		pBat->Drop += pBat->Last - pB[i];	// ignore battery swaps
+	    }
+	    if (pBat->LastDate != date)
+		pBat->Days++;
+	    pBat->LastDate = date;
+	    pBat->Last = pB[i];
+	}
+    }
+    free (pK);
+    free (pB);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Run a Query
+ *
+ * @param[in] name
+ *	Name of the query: <b>summary</b> lists the number of days and the
+ *	number of entries per kind for each box, <b>visits</b> the number of
+ *	transponder detections per week and transponder, <b>onhours</b> the
+ *	on-time of each power output per box, and <b>battery</b> the first and
+ *	last remaining capacity and the average consumption per box.
+ *
+ ******************************************************************************/
+static int	cmdQuery (const char *store, const char *name,
+			  const QUERY_OPT *pOpt, FILE *out)
+{
+int	 rc;
+
+
+    if (strcmp (name, "summary") == 0)
+    {
+	SUMMARY_CTX ctx = { .Box = -1, .Out = out };
+	int	 k;
+
+	fprintf (out, "box  days");
+	for (k = 0;  k < LP_NUM_KINDS;  k++)
+	    fprintf (out, " %s", LogParseKindName (k));
+	fprintf (out, "\n");
+
+	rc = forEachPart (store, pOpt, summaryPart, &ctx);
+	summaryPrint (&ctx);
+    }
+    else if (strcmp (name, "visits") == 0)
+    {
+	VISITS_CTX ctx = { NULL, NULL, 0, 0 };
+
+	tagLoad (store);
+	rc = forEachPart (store, pOpt, visitsPart, &ctx);
+	visitsPrint (&ctx, out);
+    }
+    else if (strcmp (name, "onhours") == 0)
+    {
+	ONHOURS_CTX ctx = { .Box = -1, .Out = out };
+
+	rc = forEachPart (store, pOpt, onhoursPart, &ctx);
+	onhoursPrint (&ctx);
+    }
+    else if (strcmp (name, "battery") == 0)
+    {
+	BATTERY_CTX ctx = { .Box = -1, .Out = out };
+
+	rc = forEachPart (store, pOpt, batteryPart, &ctx);
+	batteryPrint (&ctx);
+    }
+    else
+    {
+	fprintf (stderr, "Unknown query \"%s\"\n", name);
+	return 1;
+    }
+
+    return rc;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Benchmark Queries
+ *
+ * This routine runs every query against the store and reports its latency.
+ * The results are discarded.
+ *
+ ******************************************************************************/
+static int	cmdBench (const char *store, const QUERY_OPT *pOpt)
+{
+static const char *l_Queries[] = { "summary", "visits", "onhours", "battery" };
+FILE	*out;
+double	 t0;
+unsigned int i;
+
+
+    out = fopen ("/dev/null", "w");
+    if (out == NULL)
+	return 1;
+
+    for (i = 0;  i < ELEM_CNT(l_Queries);  i++)
+    {
+	t0 = timeNow();
+	if (cmdQuery (store, l_Queries[i], pOpt, out) != 0)
+	    break;
+	printf ("Query %-8s %8.3fs\n", l_Queries[i], timeNow() - t0);
+    }
+    fclose (out);
+
+    return (i < ELEM_CNT(l_Queries));
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Index and Dictionary Handling
+ *
+ ******************************************************************************/
+static void	indexLoad (const char *store)
+{
+char	 path[PATH_MAX_SIZE];
+FILE	*fp;
+INDEX_ENTRY entry;
+unsigned long long hash;
+
+
+    snprintf (path, sizeof(path), "%s/INDEX", store);
+    fp = fopen (path, "r");
+    if (fp == NULL)
+	return;
+
+    while (fscanf (fp, "%llx %ld %d", &hash, &entry.Bytes, &entry.Box) == 3)
+    {
+	if (l_IndexCnt == l_IndexSize)
+	{
+	    l_IndexSize = (l_IndexSize ? 2 * l_IndexSize : 256);
+	    l_Index = realloc (l_Index, l_IndexSize * sizeof(INDEX_ENTRY));
+	}
+	entry.Hash = hash;
+	l_Index[l_IndexCnt++] = entry;
+    }
+    fclose (fp);
+}
+
+static void	indexAppend (const char *store, const INDEX_ENTRY *pEntry)
+{
+char	 path[PATH_MAX_SIZE];
+FILE	*fp;
+
+
+    if (l_IndexCnt == l_IndexSize)
+    {
+	l_IndexSize = (l_IndexSize ? 2 * l_IndexSize : 256);
+	l_Index = realloc (l_Index, l_IndexSize * sizeof(INDEX_ENTRY));
+    }
+    l_Index[l_IndexCnt++] = *pEntry;
+
+    snprintf (path, sizeof(path), "%s/INDEX", store);
+    fp = fopen (path, "a");
+    if (fp == NULL)
+    {
+	perror (path);
+	return;
+    }
+    fprintf (fp, "%016llx %ld %04d\n", (unsigned long long)pEntry->Hash,
+	     pEntry->Bytes, pEntry->Box);
+    fclose (fp);
+}
+
+static void	tagLoad (const char *store)
+{
+char	 path[PATH_MAX_SIZE];
+char	 line[LOG_LINE_MAX_SIZE];
+FILE	*fp;
+
+
+    if (l_Tag != NULL)
+	return;			// already loaded
+
+    l_Tag = calloc (MAX_TAGS, TAG_ID_MAX_SIZE);
+    memset (l_TagHash, 0xFF, sizeof(l_TagHash));
+
+    snprintf (path, sizeof(path), "%s/TAGS", store);
+    fp = fopen (path, "r");
+    if (fp != NULL)
+    {
+	while (fgets (line, sizeof(line), fp) != NULL)
+	{
+	    line[strcspn (line, "\r\n")] = EOS;
+	    tagIndex (line);
+	}
+	fclose (fp);
+    }
+    l_TagCntStored = l_TagCnt;
+}
+
+static void	tagSave (const char *store)
+{
+char	 path[PATH_MAX_SIZE];
+FILE	*fp;
+
+
+    if (l_TagCnt == l_TagCntStored)
+	return;
+
+    snprintf (path, sizeof(path), "%s/TAGS", store);
+    fp = fopen (path, "a");
+    if (fp == NULL)
+    {
+	perror (path);
+	return;
+    }
+    for ( ;  l_TagCntStored < l_TagCnt;  l_TagCntStored++)
+	fprintf (fp, "%s\n", l_Tag[l_TagCntStored]);
+    fclose (fp);
+}
+
+static uint32_t	tagIndex (const char *tag)
+{
+uint32_t h;
+
+
+    h = (uint32_t)LogParseHash (LOG_PARSE_HASH_INIT, tag, strlen(tag));
+    for (h &= ELEM_CNT(l_TagHash) - 1;  l_TagHash[h] >= 0;
+	 h = (h + 1) & (ELEM_CNT(l_TagHash) - 1))
+    {
+	if (strcmp (l_Tag[l_TagHash[h]], tag) == 0)
+	    return l_TagHash[h];
+    }
+
+    if (l_TagCnt >= MAX_TAGS)
+    {
+	fprintf (stderr, "Transponder dictionary full\n");
+	exit (1);
+    }
+    strncpy (l_Tag[l_TagCnt], tag, TAG_ID_MAX_SIZE - 1);
+    l_TagHash[h] = l_TagCnt;
+
+    return l_TagCnt++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Partition Handling
+ *
+ ******************************************************************************/
+static void	partAppend (PART *pPart, const LP_ENTRY *pEntry)
+{
+    if (pPart->Rows == pPart->Size)
+    {
+	pPart->Size = (pPart->Size ? 2 * pPart->Size : 1024);
+	pPart->T = realloc (pPart->T, pPart->Size * sizeof(uint32_t));
+	pPart->K = realloc (pPart->K, pPart->Size * sizeof(uint8_t));
+	pPart->A = realloc (pPart->A, pPart->Size * sizeof(uint32_t));
+	pPart->B = realloc (pPart->B, pPart->Size * sizeof(int32_t));
+	pPart->C = realloc (pPart->C, pPart->Size * sizeof(int32_t));
+    }
+    pPart->T[pPart->Rows] = pEntry->MilliSec;
+    pPart->K[pPart->Rows] = pEntry->Kind;
+    pPart->A[pPart->Rows] = pEntry->A;
+    pPart->B[pPart->Rows] = pEntry->B;
+    pPart->C[pPart->Rows] = pEntry->C;
+    pPart->Rows++;
+}
+
+static void	partFree (PART *pPart)
+{
+    free (pPart->T);
+    free (pPart->K);
+    free (pPart->A);
+    free (pPart->B);
+    free (pPart->C);
+    memset (pPart, 0, sizeof(PART));
+}
+
+    /* Byte offset of a column within a partition file of <rows> rows */
+static size_t	colOffset (uint32_t rows, COL_ID col)
+{
+size_t	 offs = sizeof(PART_HDR);
+int	 i;
+
+
+    for (i = 0;  i < (int)col;  i++)
+	offs += (rows * l_ColSize[i] + 3) & ~3UL;	// 4-byte aligned
+
+    return offs;
+}
+
+static bool	colRead (FILE *fp, const PART_HDR *pHdr, COL_ID col, void *buf)
+{
+    if (pHdr->Rows == 0)
+	return true;
+
+    return (fseek (fp, colOffset (pHdr->Rows, col), SEEK_SET) == 0
+	    &&  fread (buf, l_ColSize[col], pHdr->Rows, fp) == pHdr->Rows);
+}
+
+/*
+ * Merge the rows of <pPart> with an already existing partition file and write
+ * the result back.  The new file is written to a temporary name and renamed
+ * afterwards, so an interrupted ingest never leaves a truncated partition.
+ */
+static int	partMerge (const char *store, int box, PART *pPart)
+{
+char	 path[PATH_MAX_SIZE], tmpPath[PATH_MAX_SIZE + 4];
+void	*pOld[NUM_COLS], *pNew[NUM_COLS];
+PART_HDR hdr;
+PART	 old;
+FILE	*fp;
+uint32_t rows;
+int	 c;
+static const uint8_t l_Pad[4];
+
+
+    snprintf (path, sizeof(path), "%s/%04d", store, box);
+    if (mkdir (path, 0755) != 0  &&  errno != EEXIST)
+    {
+	perror (path);
+	return -1;
+    }
+    snprintf (path, sizeof(path), "%s/%04d/%08u.col", store, box, pPart->Date);
+    snprintf (tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    memset (&old, 0, sizeof(old));
+    fp = fopen (path, "rb");
+    if (fp != NULL)
+    {
+	if (fread (&hdr, sizeof(hdr), 1, fp) == 1  &&  hdr.Magic == PART_MAGIC)
+	{
+	    old.Rows = old.Size = hdr.Rows;
+	    old.T = malloc (hdr.Rows * sizeof(uint32_t) + 1);
+	    old.K = malloc (hdr.Rows * sizeof(uint8_t) + 1);
+	    old.A = malloc (hdr.Rows * sizeof(uint32_t) + 1);
+	    old.B = malloc (hdr.Rows * sizeof(int32_t) + 1);
+	    old.C = malloc (hdr.Rows * sizeof(int32_t) + 1);
+	    if (! colRead (fp, &hdr, COL_T, old.T)
+	    ||  ! colRead (fp, &hdr, COL_K, old.K)
+	    ||  ! colRead (fp, &hdr, COL_A, old.A)
+	    ||  ! colRead (fp, &hdr, COL_B, old.B)
+	    ||  ! colRead (fp, &hdr, COL_C, old.C))
+	    {
+		fprintf (stderr, "%s: Corrupted partition, rewriting\n", path);
+		partFree (&old);
+	    }
+	}
+	fclose (fp);
+    }
+
+    fp = fopen (tmpPath, "wb");
+    if (fp == NULL)
+    {
+	perror (tmpPath);
+	partFree (&old);
+	return -1;
+    }
+
+    hdr.Magic = PART_MAGIC;
+    hdr.Rows = rows = old.Rows + pPart->Rows;
+    fwrite (&hdr, sizeof(hdr), 1, fp);
+
+    pOld[COL_T] = old.T;	pNew[COL_T] = pPart->T;
+    pOld[COL_K] = old.K;	pNew[COL_K] = pPart->K;
+    pOld[COL_A] = old.A;	pNew[COL_A] = pPart->A;
+    pOld[COL_B] = old.B;	pNew[COL_B] = pPart->B;
+    pOld[COL_C] = old.C;	pNew[COL_C] = pPart->C;
+
+    for (c = 0;  c < NUM_COLS;  c++)
+    {
+	if (old.Rows > 0)
+	    fwrite (pOld[c], l_ColSize[c], old.Rows, fp);
+	fwrite (pNew[c], l_ColSize[c], pPart->Rows, fp);
+	fwrite (l_Pad, 1, ((rows * l_ColSize[c] + 3) & ~3UL)
+			  - rows * l_ColSize[c], fp);
+    }
+
+    partFree (&old);
+
+    if (fclose (fp) != 0  ||  rename (tmpPath, path) != 0)
+    {
+	perror (path);
+	return -1;
+    }
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Iterate over Partitions
+ *
+ * This routine calls <b>fct</b> for each partition that matches the query
+ * options, ordered by box number and date.  Partitions are selected by their
+ * directory and file names, so non-matching boxes and days are never opened.
+ *
+ ******************************************************************************/
+static int	nameCmp (const void *p1, const void *p2)
+{
+    return strcmp (*(char * const *)p1, *(char * const *)p2);
+}
+
+static int	dirList (const char *path, char ***pppList)
+{
+DIR	*dir;
+struct dirent *pEnt;
+char	**ppList = NULL;
+int	 cnt = 0, size = 0;
+
+
+    dir = opendir (path);
+    if (dir == NULL)
+	return -1;
+
+    while ((pEnt = readdir (dir)) != NULL)
+    {
+	if (pEnt->d_name[0] == '.')
+	    continue;
+
+	if (cnt == size)
+	{
+	    size = (size ? 2 * size : 64);
+	    ppList = realloc (ppList, size * sizeof(char *));
+	}
+	ppList[cnt++] = strdup (pEnt->d_name);
+    }
+    closedir (dir);
+
+    qsort (ppList, cnt, sizeof(char *), nameCmp);
+    *pppList = ppList;
+    return cnt;
+}
+
+static int	forEachPart (const char *store, const QUERY_OPT *pOpt,
+			     PART_FCT fct, void *pCtx)
+{
+char	 path[PATH_MAX_SIZE];
+char	**ppBox, **ppDay, *pEnd;
+int	 boxCnt, dayCnt, b, d, box;
+uint32_t date;
+PART_HDR hdr;
+FILE	*fp;
+
+
+    boxCnt = dirList (store, &ppBox);
+    if (boxCnt < 0)
+    {
+	perror (store);
+	return 1;
+    }
+
+    for (b = 0;  b < boxCnt;  b++)
+    {
+	box = (int)strtol (ppBox[b], &pEnd, 10);
+	if (*pEnd != EOS  ||  (pOpt->Box >= 0  &&  box != pOpt->Box))
+	    continue;
+
+	snprintf (path, sizeof(path), "%s/%s", store, ppBox[b]);
+	dayCnt = dirList (path, &ppDay);
+
+	for (d = 0;  d < dayCnt;  d++)
+	{
+	    date = strtoul (ppDay[d], &pEnd, 10);
+	    if (strcmp (pEnd, ".col") != 0
+	    ||  (pOpt->From  &&  date < pOpt->From)
+	    ||  (pOpt->To  &&  date > pOpt->To))
+		continue;
+
+	    snprintf (path, sizeof(path), "%s/%s/%s", store, ppBox[b], ppDay[d]);
+	    fp = fopen (path, "rb");
+	    if (fp == NULL)
+		continue;
+
+	    if (fread (&hdr, sizeof(hdr), 1, fp) == 1
+	    &&  hdr.Magic == PART_MAGIC)
+		fct (box, date, fp, &hdr, pCtx);
+
+	    fclose (fp);
+	}
+
+	for (d = 0;  d < dayCnt;  d++)
+	    free (ppDay[d]);
+	if (dayCnt > 0)
+	    free (ppDay);
+    }
+
+    for (b = 0;  b < boxCnt;  b++)
+	free (ppBox[b]);
+    free (ppBox);
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static double	timeNow (void)
+{
+struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void	usage (void)
+{
+    fprintf (stderr,
+	"Usage: LogStore ingest <store> <BOXnnnn.TXT>...\n"
+	"       LogStore query  <store> summary|visits|onhours|battery"
+	" [options]\n"
+	"       LogStore bench  <store> [options]\n"
+	"Options: -b <box>  -f <YYYYMMDD>  -t <YYYYMMDD>\n");
+    exit (1);
+}
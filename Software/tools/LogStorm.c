@@ -0,0 +1,590 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Log Storm Simulator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool measures the log rate limit of the firmware, see LogRate.c,
+ * under a synthetic log storm.
+ *
+ * Usage:
+ * @code
+ * LogStorm [-d <seconds>] [-s <msgs_per_s>] [-l <seconds>] [-r <rate>]
+ *	    [-b <burst>] [-f <flush_ms>] [-v]
+ * @endcode
+ *
+ * The simulation runs in steps of 1ms.  The RFID source logs a transponder
+ * message every 1000/<i>msgs_per_s</i> milliseconds during the storm, which
+ * starts after 60 seconds and lasts <i>-l</i> seconds (default 300).  The
+ * other sources log their regular messages: CONTROL a measurement every 30s,
+ * ALARM an alarm every 300s, and BATTERY a report of 8 lines every 600s.
+ * These are the rare messages which must not be crowded out.
+ *
+ * The firmware does not limit any source by default, and LOG_RATE does not
+ * apply to the data sources RFID, CONTROL, and BATTERY.  The run with rate
+ * limit therefore models LOG_RATE_RFID = <i>rate</i>: only the storm source
+ * is limited, the other sources never are.
+ *
+ * The log buffer is modeled like Logging.c: every entry takes its length
+ * plus 2 bytes of the @ref LOG_BUF_SIZE bytes, an entry that does not fit is
+ * lost.  The buffer is flushed when more than @ref LOG_SAMPLE_MAX_SIZE bytes
+ * are stored, or @ref LOG_SAMPLE_TIMEOUT seconds after the last entry, but
+ * not within @ref LOG_FLUSH_PAUSE seconds after the previous flush.  A flush
+ * takes <i>flush_ms</i> milliseconds (default 250), and writes the entries
+ * that were in the buffer when it started.  The suppressions are reported
+ * like LogMessage() and LogFlushCheck() do, the latter is called once per
+ * second.
+ *
+ * The storm is run twice, without and with the rate limit, and the number
+ * of entries and bytes written, the lost entries of the storm and the rare
+ * sources, and the number of flushes are compared.  Every message is
+ * formatted like logMsg() does, unless it is suppressed, and the CPU time
+ * of a formatted and of a suppressed message is measured separately.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Only the storm source is limited, like LOG_RATE_RFID in the
+		firmware.  The summaries show the date.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "LogRate.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Same values as in Logging.h of the firmware. */
+#define LOG_BUF_SIZE		2048
+#define LOG_SAMPLE_MAX_SIZE	1024
+#define LOG_SAMPLE_TIMEOUT	5
+#define LOG_FLUSH_PAUSE		15
+#define LOG_ENTRY_MAX_SIZE	128
+#define LOG_BURST_DFLT		30
+
+    /*!@brief Default limit of the storm source in messages per minute. */
+#define STORM_RATE_DFLT		60
+
+    /*!@brief Date of the simulation for the summaries. */
+#define DAY_DATE		"20261019"
+
+    /*!@brief Start of the storm in [s]. */
+#define STORM_START		60
+
+    /*!@brief Time of day of the simulation start, 12:00:00. */
+#define DAY_START		(12 * 3600)
+
+    /*!@brief Number of messages for the CPU time measurement. */
+#define BENCH_LOOPS		1000000
+
+    /*!@brief Simulated log sources. */
+typedef enum
+{
+    SRC_RFID,		//!< Storm source
+    SRC_CONTROL,	//!< Measurement every 30s
+    SRC_ALARM,		//!< Alarm every 300s
+    SRC_BATTERY,	//!< Report of 8 lines every 600s
+    SRC_LOGGING,	//!< Summaries, never limited
+    NUM_SRC
+} SRC;
+
+    /*!@brief Results of one run. */
+typedef struct
+{
+    long	Offered;		//!< Messages offered to Log()
+    long	Written;		//!< Entries written to the SD-Card
+    long	Bytes;			//!< Bytes written to the SD-Card
+    long	Lost[NUM_SRC];		//!< Entries lost, buffer full
+    long	Suppressed;		//!< Messages suppressed by the limit
+    long	Summaries;		//!< Summaries logged
+    long	Flushes;		//!< Number of flushes
+} RESULT;
+
+/*================================ Local Data ================================*/
+
+static const char *l_SrcName[NUM_SRC] =
+{ "RFID", "CONTROL", "ALARM", "BATTERY", "LOGGING" };
+
+    /* Options */
+static long	l_Duration = 600;	// [s]
+static long	l_StormRate = 50;	// [msgs/s]
+static long	l_StormLen = 300;	// [s]
+static long	l_FlushMs = 250;
+static bool	l_flgVerbose;
+
+    /* Rate limit of the sources */
+static LOG_RATE_CFG	l_Cfg[NUM_SRC];
+static LOG_RATE_BUCKET	l_Bucket[NUM_SRC];
+static bool		l_flgLimit;
+
+    /* Model of the log buffer */
+static int	l_BufUsed;		// bytes in the buffer
+static int	l_BufFlushing;		// bytes taken by the running flush
+static long	l_BufEntries;		// entries in the buffer
+static long	l_FlushEntries;		// entries taken by the running flush
+static long	l_FlushEnd = -1;	// end of the running flush [ms]
+static long	l_FlushPauseEnd;	// end of the flush pause [ms]
+static long	l_LastEntry = -1;	// time of the last entry [ms]
+static uint32_t	l_SeqNum;
+
+static RESULT	l_Res;
+
+    /* Result of the benchmark, so the compiler keeps the loops */
+static volatile long l_Sink;
+
+/*=========================== Forward Declarations ===========================*/
+
+static void	runStorm (bool flgLimit, RESULT *pRes);
+static void	logMessage (long ms, SRC src, const char *frmt, ...);
+static int	formatEntry (char *pBuf, long ms, const char *frmt,
+			     va_list args);
+static int	formatLine (char *pBuf, long ms, const char *frmt, ...);
+static void	bufferStore (long ms, SRC src, int len);
+static void	flushCheck (long ms);
+static void	suppressCheck (long ms);
+static void	suppressReport (long ms, SRC src, uint32_t cnt,
+				uint32_t first, uint32_t last);
+static double	cpuTime (void);
+static void	benchmark (void);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+RESULT	 res[2];
+long	 rate = STORM_RATE_DFLT, burst = LOG_BURST_DFLT;
+int	 i;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (strcmp (argv[i], "-d") == 0  &&  i + 1 < argc)
+	    l_Duration = atol (argv[++i]);
+	else if (strcmp (argv[i], "-s") == 0  &&  i + 1 < argc)
+	    l_StormRate = atol (argv[++i]);
+	else if (strcmp (argv[i], "-l") == 0  &&  i + 1 < argc)
+	    l_StormLen = atol (argv[++i]);
+	else if (strcmp (argv[i], "-r") == 0  &&  i + 1 < argc)
+	    rate = atol (argv[++i]);
+	else if (strcmp (argv[i], "-b") == 0  &&  i + 1 < argc)
+	    burst = atol (argv[++i]);
+	else if (strcmp (argv[i], "-f") == 0  &&  i + 1 < argc)
+	    l_FlushMs = atol (argv[++i]);
+	else
+	    usage();
+    }
+    if (i < argc  ||  l_Duration < 1  ||  l_StormRate < 1
+    ||  l_StormRate > 1000  ||  l_StormLen < 0  ||  rate < 1  ||  burst < 1
+    ||  l_FlushMs < 0)
+	usage();
+
+    for (i = 0;  i < NUM_SRC;  i++)
+    {
+	l_Cfg[i].Rate  = (i == SRC_RFID ? (uint32_t)rate : 0);
+	l_Cfg[i].Burst = (uint32_t)burst;
+    }
+
+    printf ("Storm of %ld msgs/s for %lds in %lds, RFID limit %ld msgs/min,"
+	    " burst %ld, flush %ldms\n", l_StormRate, l_StormLen, l_Duration, rate,
+	    burst, l_FlushMs);
+
+    runStorm (false, &res[0]);
+    runStorm (true,  &res[1]);
+
+    printf ("\n                        no limit  rate limit\n");
+    printf ("Messages offered    %12ld %11ld\n", res[0].Offered,
+	    res[1].Offered);
+    printf ("Suppressed          %12ld %11ld\n", res[0].Suppressed,
+	    res[1].Suppressed);
+    printf ("Summaries           %12ld %11ld\n", res[0].Summaries,
+	    res[1].Summaries);
+    printf ("Entries written     %12ld %11ld\n", res[0].Written,
+	    res[1].Written);
+    printf ("Bytes written       %12ld %11ld\n", res[0].Bytes, res[1].Bytes);
+    printf ("Flushes             %12ld %11ld\n", res[0].Flushes,
+	    res[1].Flushes);
+    for (i = 0;  i < SRC_LOGGING;  i++)
+	printf ("Lost %-15s%12ld %11ld\n", l_SrcName[i], res[0].Lost[i],
+		res[1].Lost[i]);
+
+    benchmark();
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Run the Storm
+ *
+ ******************************************************************************/
+static void	runStorm (bool flgLimit, RESULT *pRes)
+{
+long	 ms, stormStep, stormEnd;
+int	 i;
+
+
+    l_flgLimit = flgLimit;
+    memset (&l_Res, 0, sizeof(l_Res));
+    for (i = 0;  i < NUM_SRC;  i++)
+    {
+	memset (&l_Bucket[i], 0, sizeof(l_Bucket[i]));
+	LogRateReset (&l_Cfg[i], &l_Bucket[i], DAY_START);
+    }
+    l_BufUsed = l_BufFlushing = 0;
+    l_BufEntries = l_FlushEntries = 0;
+    l_FlushEnd = l_LastEntry = -1;
+    l_FlushPauseEnd = 0;
+    l_SeqNum = 0;
+
+    if (l_flgVerbose)
+	printf ("\n%s:\n", flgLimit ? "With rate limit" : "Without rate limit");
+
+    stormStep = 1000 / l_StormRate;
+    stormEnd  = (STORM_START + l_StormLen) * 1000L;
+
+    for (ms = 0;  ms < l_Duration * 1000L;  ms++)
+    {
+	if (ms >= STORM_START * 1000L  &&  ms < stormEnd
+	&&  (ms - STORM_START * 1000L) % stormStep == 0)
+	{
+	    logMessage (ms, SRC_RFID, "RFID: Transponder %s detected,"
+			" antenna %d", "0123456789ABCDEF", (int)(ms % 2) + 1);
+	}
+
+	if (ms % 30000 == 15000)
+	    logMessage (ms, SRC_CONTROL, "UA1     : %2ld.%ldV %4ldmA",
+			12L, ms / 1000 % 10, 400L + ms % 97);
+
+	if (ms % 300000 == 20000)
+	    logMessage (ms, SRC_ALARM, "Alarm %d: UA1 switched on", 3);
+
+	if (ms % 600000 == 25000)
+	{
+	    for (i = 0;  i < 8;  i++)
+		logMessage (ms, SRC_BATTERY, "Battery Register %02X: 0x%04X",
+			    i + 8, (unsigned int)(ms / 1000 + i * 1337) & 0xFFFF);
+	}
+
+	if (ms % 1000 == 999)
+	    suppressCheck (ms);
+
+	flushCheck (ms);
+    }
+
+    /* Write the rest */
+    suppressCheck (ms);
+    l_Res.Written += l_BufEntries + l_FlushEntries;
+    l_Res.Bytes += l_BufUsed + l_BufFlushing;
+
+    *pRes = l_Res;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log a Message
+ *
+ * This routine does what LogMessage() does: it checks the rate limit and
+ * reports an ended suppression, then formats the entry and stores it.
+ *
+ ******************************************************************************/
+static void	logMessage (long ms, SRC src, const char *frmt, ...)
+{
+char	 buf[LOG_ENTRY_MAX_SIZE + 40];
+va_list	 args;
+uint32_t now, cnt = 0, first = 0, last = 0;
+int	 len;
+
+
+    if (src != SRC_LOGGING)
+	l_Res.Offered++;
+
+    if (l_flgLimit  &&  l_Cfg[src].Rate > 0)
+    {
+	now = DAY_START + (uint32_t)(ms / 1000);
+	if (LogRateEnded (&l_Cfg[src], &l_Bucket[src], now))
+	{
+	    cnt   = l_Bucket[src].Dropped;
+	    first = l_Bucket[src].FirstDrop;
+	    last  = l_Bucket[src].LastDrop;
+	    l_Bucket[src].Dropped = 0;
+	}
+
+	if (! LogRateTake (&l_Cfg[src], &l_Bucket[src], now))
+	{
+	    l_Res.Suppressed++;
+	    return;
+	}
+
+	if (cnt > 0)
+	    suppressReport (ms, src, cnt, first, last);
+    }
+
+    va_start (args, frmt);
+    len = formatEntry (buf, ms, frmt, args);
+    va_end (args);
+
+    bufferStore (ms, src, len);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Format a Log Entry like logMsg()
+ *
+ ******************************************************************************/
+static int	formatEntry (char *pBuf, long ms, const char *frmt,
+			     va_list args)
+{
+long	 sec = DAY_START + ms / 1000;
+int	 len;
+
+
+    len = sprintf (pBuf, "20%02d%02d%02d-%02ld%02ld%02ld.%03ld #%06lu ",
+		   26, 10, 19, sec / 3600 % 24, sec / 60 % 60, sec % 60,
+		   ms % 1000, (unsigned long)l_SeqNum);
+    len += vsnprintf (pBuf + len, LOG_ENTRY_MAX_SIZE - len - 3, frmt, args);
+    strcpy (pBuf + len, "\r\n");
+
+    return len + 3;		// <CR> <LF> EOS
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Format a Log Entry with Arguments
+ *
+ ******************************************************************************/
+static int	formatLine (char *pBuf, long ms, const char *frmt, ...)
+{
+va_list	 args;
+int	 len;
+
+
+    va_start (args, frmt);
+    len = formatEntry (pBuf, ms, frmt, args);
+    va_end (args);
+
+    return len;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Store an Entry into the Log Buffer Model
+ *
+ ******************************************************************************/
+static void	bufferStore (long ms, SRC src, int len)
+{
+    l_SeqNum = (l_SeqNum + 1) % 1000000;
+
+    if (l_BufUsed + l_BufFlushing + len + 1 >= LOG_BUF_SIZE)
+    {
+	l_Res.Lost[src]++;
+	return;
+    }
+
+    l_BufUsed += len + 1;	// <len> byte
+    l_BufEntries++;
+    l_LastEntry = ms;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Flush Model
+ *
+ * A flush starts when LogFlushCheck() would start it, and takes the entries
+ * that are in the buffer at that time.  Their space is released at the end
+ * of the flush.
+ *
+ ******************************************************************************/
+static void	flushCheck (long ms)
+{
+    if (l_FlushEnd >= 0)
+    {
+	if (ms < l_FlushEnd)
+	    return;
+
+	/* flush is done, start the pause */
+	l_Res.Written += l_FlushEntries;
+	l_Res.Bytes += l_BufFlushing - l_FlushEntries;	// no <len> byte
+	l_BufFlushing = 0;
+	l_FlushEntries = 0;
+	l_FlushEnd = -1;
+	l_FlushPauseEnd = ms + LOG_FLUSH_PAUSE * 1000L;
+    }
+
+    if (l_BufEntries == 0)
+	return;
+
+    if (l_BufUsed > LOG_SAMPLE_MAX_SIZE
+    ||  (ms >= l_FlushPauseEnd
+	 &&  ms >= l_LastEntry + LOG_SAMPLE_TIMEOUT * 1000L))
+    {
+	l_Res.Flushes++;
+	l_BufFlushing = l_BufUsed;
+	l_FlushEntries = l_BufEntries;
+	l_BufUsed = 0;
+	l_BufEntries = 0;
+	l_FlushEnd = ms + l_FlushMs;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Report the Suppressions of quiet Sources like LogFlushCheck()
+ *
+ ******************************************************************************/
+static void	suppressCheck (long ms)
+{
+uint32_t now = DAY_START + (uint32_t)(ms / 1000);
+uint32_t cnt;
+int	 i;
+
+
+    if (! l_flgLimit)
+	return;
+
+    for (i = 0;  i < NUM_SRC;  i++)
+    {
+	if (LogRateEnded (&l_Cfg[i], &l_Bucket[i], now))
+	{
+	    cnt = l_Bucket[i].Dropped;
+	    l_Bucket[i].Dropped = 0;
+	    suppressReport (ms, (SRC)i, cnt, l_Bucket[i].FirstDrop,
+			    l_Bucket[i].LastDrop);
+	}
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log a Summary like logSuppressReport()
+ *
+ ******************************************************************************/
+static void	suppressReport (long ms, SRC src, uint32_t cnt,
+				uint32_t first, uint32_t last)
+{
+    l_Res.Summaries++;
+
+    if (l_flgVerbose)
+    {
+	printf ("%4lds: Log Suppressed: %s %lu messages " DAY_DATE
+		"-%02lu%02lu%02lu - " DAY_DATE "-%02lu%02lu%02lu\n", ms / 1000,
+		l_SrcName[src],
+		(unsigned long)cnt, (unsigned long)first / 3600,
+		(unsigned long)first / 60 % 60, (unsigned long)first % 60,
+		(unsigned long)last / 3600, (unsigned long)last / 60 % 60,
+		(unsigned long)last % 60);
+    }
+
+    logMessage (ms, SRC_LOGGING, "Log Suppressed: %s %lu messages "
+		DAY_DATE "-%02lu%02lu%02lu - " DAY_DATE "-%02lu%02lu%02lu",
+		l_SrcName[src],
+		(unsigned long)cnt, (unsigned long)first / 3600,
+		(unsigned long)first / 60 % 60, (unsigned long)first % 60,
+		(unsigned long)last / 3600, (unsigned long)last / 60 % 60,
+		(unsigned long)last % 60);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	CPU Time in [s]
+ *
+ ******************************************************************************/
+static double	cpuTime (void)
+{
+struct timespec ts;
+
+
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Benchmark a formatted and a suppressed Message
+ *
+ * A formatted message is checked by the rate limit and formatted, a
+ * suppressed message is only checked.  The host is much faster than the
+ * EFM32, but the ratio of both shows what the limit saves.
+ *
+ ******************************************************************************/
+static void	benchmark (void)
+{
+LOG_RATE_CFG	cfg = { 0, LOG_BURST_DFLT };
+LOG_RATE_BUCKET	bucket;
+char	 buf[LOG_ENTRY_MAX_SIZE + 40];
+double	 t0, tFormat, tSuppress;
+long	 n;
+
+
+    /* no limit: every message is formatted */
+    LogRateReset (&cfg, &bucket, DAY_START);
+    t0 = cpuTime();
+    for (n = 0;  n < BENCH_LOOPS;  n++)
+    {
+	if (LogRateTake (&cfg, &bucket, DAY_START + (uint32_t)(n / 1000)))
+	{
+	    l_SeqNum = (uint32_t)n;
+	    l_Sink += formatLine (buf, n, "RFID: Transponder %s detected,"
+			       " antenna %d", "0123456789ABCDEF", (int)(n % 2));
+	}
+    }
+    tFormat = cpuTime() - t0;
+
+    /* limit: the bucket is empty, every message is suppressed */
+    cfg.Rate = 1;
+    LogRateReset (&cfg, &bucket, DAY_START);
+    bucket.Credit = 0;
+    t0 = cpuTime();
+    for (n = 0;  n < BENCH_LOOPS;  n++)
+    {
+	if (LogRateTake (&cfg, &bucket, DAY_START))
+	    l_Sink++;
+    }
+    tSuppress = cpuTime() - t0;
+
+    printf ("\nCPU time per message: formatted %.0fns, suppressed %.1fns\n",
+	    tFormat * 1e9 / BENCH_LOOPS, tSuppress * 1e9 / BENCH_LOOPS);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Show Usage
+ *
+ ******************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr,
+	"Usage: LogStorm [-d <seconds>] [-s <msgs_per_s>] [-l <seconds>]\n"
+	"                [-r <rate>] [-b <burst>] [-f <flush_ms>] [-v]\n"
+	"  -d  duration of the simulation in [s] (default 600)\n"
+	"  -s  messages per second of the storm, 1 to 1000 (default 50)\n"
+	"  -l  length of the storm in [s], it starts at 60s (default 300)\n"
+	"  -r  rate limit of the storm source in messages per minute"
+	" (default %d)\n"
+	"  -b  burst size in messages (default %d)\n"
+	"  -f  duration of a flush in [ms] (default 250)\n"
+	"  -v  show the summaries\n", STORM_RATE_DFLT, LOG_BURST_DFLT);
+    exit (1);
+}
@@ -0,0 +1,324 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Log Sequence Verifier
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool checks the sequence numbers of TAMDL log files, see
+ * LOG_SEQ_NUM in Logging.h.
+ *
+ * Usage:
+ * @code
+ * LogVerify [-v] <BOXnnnn.TXT>...
+ * @endcode
+ *
+ * Each file is divided into epochs, i.e. the time between two resets of the
+ * firmware.  An epoch starts when the sequence number steps back to 0, or to
+ * a small value (less than @ref RESET_WINDOW) from a number that is at least
+ * RESET_WINDOW higher.  Within an epoch the tool reports:
+ * - <b>gaps</b>: sequence numbers that are missing.  Gaps that are covered
+ *   by a "Log Lost" report of the firmware are counted as <i>explained</i>,
+ *   all others as <i>unexplained</i>, e.g. caused by a lost log buffer flush
+ *   or a damaged file.
+ * - <b>duplicates</b>: sequence numbers that occur more than once, e.g.
+ *   because a log buffer has been written twice.
+ * - <b>ordering faults</b>: sequence numbers that step backwards.
+ *
+ * The exit code is 0 if there are no unexplained gaps, duplicates, or
+ * ordering faults, 2 otherwise.  Option <b>-v</b> lists every problem with
+ * its line number.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Sequence numbers wrap around at 10^LOG_SEQ_DIGITS. */
+#define SEQ_WRAP	1000000
+
+    /*!@brief A backward step to a number below this value is a reset. */
+#define RESET_WINDOW	256
+
+    /* Bitmap handling */
+#define BIT_SET(map, n)	((map)[(n) >> 3] |= (uint8_t)(1 << ((n) & 7)))
+#define BIT_TST(map, n)	((map)[(n) >> 3] & (1 << ((n) & 7)))
+
+/*!@brief Verification state of one epoch */
+typedef struct
+{
+    uint8_t	Seen[SEQ_WRAP / 8];	//!< Sequence numbers seen
+    uint8_t	Explained[SEQ_WRAP / 8]; //!< Covered by a loss report
+    int32_t	First;		//!< First sequence number of the epoch
+    int32_t	Last;		//!< Highest sequence number of the epoch
+    uint32_t	FirstLine;	//!< Line number where the epoch starts
+} EPOCH;
+
+/*!@brief Statistics of one file */
+typedef struct
+{
+    uint32_t	Entries;	//!< Entries with sequence number
+    uint32_t	Epochs;		//!< Number of epochs
+    uint32_t	Reported;	//!< Lost entries reported by the firmware
+    uint32_t	Explained;	//!< Missing numbers covered by loss reports
+    uint32_t	Unexplained;	//!< Missing numbers without loss report
+    uint32_t	Duplicates;	//!< Numbers seen more than once
+    uint32_t	OrderFaults;	//!< Backward steps
+} STATS;
+
+/*================================ Local Data ================================*/
+
+    /* Verbose output */
+static bool	l_flgVerbose;
+
+    /* State of the current epoch (too large for the stack) */
+static EPOCH	l_Epoch;
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	verifyFile (const char *path, STATS *pStat);
+static void	epochStart (int32_t seq, uint32_t lineNum);
+static void	epochEnd (const char *path, STATS *pStat);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+STATS	 stat, total;
+int	 i, result = 0;
+
+
+    memset (&total, 0, sizeof(total));
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else
+	    usage();
+    }
+
+    if (i >= argc)
+	usage();
+
+    printf ("%-32s %8s %6s %8s %8s %8s %6s %6s\n", "File", "Entries",
+	    "Epochs", "Reported", "Explain", "Unexpl", "Dupl", "Order");
+
+    for ( ;  i < argc;  i++)
+    {
+	if (verifyFile (argv[i], &stat) != 0)
+	{
+	    result = 1;
+	    continue;
+	}
+
+	printf ("%-32s %8u %6u %8u %8u %8u %6u %6u\n", argv[i],
+		stat.Entries, stat.Epochs, stat.Reported, stat.Explained,
+		stat.Unexplained, stat.Duplicates, stat.OrderFaults);
+
+	total.Entries     += stat.Entries;
+	total.Epochs      += stat.Epochs;
+	total.Reported    += stat.Reported;
+	total.Explained   += stat.Explained;
+	total.Unexplained += stat.Unexplained;
+	total.Duplicates  += stat.Duplicates;
+	total.OrderFaults += stat.OrderFaults;
+    }
+
+    printf ("%-32s %8u %6u %8u %8u %8u %6u %6u\n", "TOTAL",
+	    total.Entries, total.Epochs, total.Reported, total.Explained,
+	    total.Unexplained, total.Duplicates, total.OrderFaults);
+
+    if (result == 0  &&  (total.Unexplained > 0  ||  total.Duplicates > 0
+			 ||  total.OrderFaults > 0))
+	result = 2;
+
+    return result;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Verify one Log File
+ *
+ * This routine reads all lines of the specified log file and checks the
+ * sequence numbers.  Lines without a sequence number are ignored.
+ *
+ * @return
+ *	0 if the file could be read, -1 otherwise.
+ *
+ ******************************************************************************/
+static int	verifyFile (const char *path, STATS *pStat)
+{
+FILE	*fp;
+char	 line[LOG_LINE_MAX_SIZE];
+LP_ENTRY entry;
+uint32_t lineNum = 0;
+int32_t	 prev = -1;		// previous sequence number
+int32_t	 step, n;
+
+
+    memset (pStat, 0, sizeof(*pStat));
+
+    fp = fopen (path, "r");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	lineNum++;
+	if (! LogParseLine (line, &entry)  ||  entry.Seq < 0)
+	    continue;
+
+	pStat->Entries++;
+
+	if (prev < 0)
+	{
+	    epochStart (entry.Seq, lineNum);
+	}
+	else
+	{
+	    step = (entry.Seq - prev + SEQ_WRAP) % SEQ_WRAP;
+
+	    if (step >= SEQ_WRAP / 2  ||  step == 0)
+	    {
+		/* backward step: a reset, a duplicate, or an ordering fault */
+		if ((entry.Seq == 0  &&  prev != 0)
+		||  (entry.Seq < RESET_WINDOW  &&  entry.Seq + RESET_WINDOW <= prev
+		     &&  ! BIT_TST (l_Epoch.Seen, entry.Seq)))
+		{
+		    epochEnd (path, pStat);
+		    epochStart (entry.Seq, lineNum);
+		}
+		else if (! BIT_TST (l_Epoch.Seen, entry.Seq))
+		{
+		    pStat->OrderFaults++;
+		    if (l_flgVerbose)
+			printf ("%s:%u: ordering fault #%06d after #%06d\n",
+				path, lineNum, entry.Seq, prev);
+		}
+	    }
+	    else if (entry.Seq < prev)
+	    {
+		/* wrap-around: evaluate the numbers collected so far */
+		epochEnd (path, pStat);
+		pStat->Epochs--;		// same epoch continues
+		epochStart (entry.Seq, l_Epoch.FirstLine);
+	    }
+	}
+
+	if (BIT_TST (l_Epoch.Seen, entry.Seq))
+	{
+	    pStat->Duplicates++;
+	    if (l_flgVerbose)
+		printf ("%s:%u: duplicate #%06d\n", path, lineNum, entry.Seq);
+	}
+	BIT_SET (l_Epoch.Seen, entry.Seq);
+
+	if (entry.Seq > l_Epoch.Last)
+	    l_Epoch.Last = entry.Seq;
+	prev = entry.Seq;
+
+	/* Mark the range of a loss report as explained */
+	if (entry.Kind == LP_LOG_LOST  &&  entry.C >= 0)
+	{
+	    pStat->Reported += entry.B;
+	    n = entry.C;
+	    do
+	    {
+		BIT_SET (l_Epoch.Explained, n);
+		if (n == (int32_t)entry.A)
+		    break;
+		n = (n + 1) % SEQ_WRAP;
+	    } while ((int32_t)entry.A >= 0  &&  n != entry.C);
+	}
+    }
+
+    if (prev >= 0)
+	epochEnd (path, pStat);
+
+    fclose (fp);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Start a new Epoch
+ *
+ ******************************************************************************/
+static void	epochStart (int32_t seq, uint32_t lineNum)
+{
+    memset (&l_Epoch, 0, sizeof(l_Epoch));
+    l_Epoch.First = l_Epoch.Last = seq;
+    l_Epoch.FirstLine = lineNum;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Evaluate the current Epoch
+ *
+ * This routine counts the missing sequence numbers between the first and the
+ * highest number of the epoch and classifies them as explained or not.
+ *
+ ******************************************************************************/
+static void	epochEnd (const char *path, STATS *pStat)
+{
+int32_t	 n, gapStart = -1;
+
+
+    pStat->Epochs++;
+
+    for (n = l_Epoch.First;  n <= l_Epoch.Last + 1;  n++)
+    {
+	if (n <= l_Epoch.Last  &&  ! BIT_TST (l_Epoch.Seen, n))
+	{
+	    if (BIT_TST (l_Epoch.Explained, n))
+	    {
+		pStat->Explained++;
+	    }
+	    else
+	    {
+		pStat->Unexplained++;
+		if (gapStart < 0)
+		    gapStart = n;
+		continue;
+	    }
+	}
+
+	if (gapStart >= 0)
+	{
+	    if (l_flgVerbose)
+		printf ("%s: epoch at line %u: unexplained gap #%06d-#%06d"
+			" (%d entries)\n", path, l_Epoch.FirstLine,
+			gapStart, n - 1, n - gapStart);
+	    gapStart = -1;
+	}
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Print Usage and exit
+ *
+ ******************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: LogVerify [-v] <BOXnnnn.TXT>...\n");
+    exit (1);
+}
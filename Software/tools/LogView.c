@@ -0,0 +1,1433 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Timeline Viewer with Level-of-Detail Aggregation
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool draws the timeline of a box: power outputs with their U/I
+ * measurements, transponder presence, battery state, DCF77 synchronization,
+ * and lost log entries.  The log files are preprocessed once into a
+ * level-of-detail (LOD) file per box, so a timeline of any time span is
+ * rendered from a bounded number of aggregates.
+ *
+ * Usage:
+ * @code
+ * LogView build  <lod_dir> <BOXnnnn.TXT>...
+ * LogView render <lod_dir> -b <box> [-f <from>] [-t <to>] [-w <width>]
+ *		  <out.svg>
+ * LogView bench  <lod_dir> [-n <renders>] [-w <width>]
+ *
+ * <from>, <to>:  YYYYMMDD[-HHMM[SS]]
+ * @endcode
+ *
+ * <b>build</b> parses the log files with LogParseLine() and writes
+ * <b><lod_dir>/BOXnnnn.LOD</b> for every box.  Log files of the same box
+ * are merged in the order given.  The file holds LOD_LEVELS levels of
+ * buckets for every track, level <i>n</i> has buckets of 8^<i>n</i>
+ * seconds, i.e. from 1s up to 24 days.  A bucket holds the minimum,
+ * maximum, sum, and count of the values in its time span, see @ref BUCKET.
+ * Only buckets with data are stored.  For an on/off state, a bucket is only
+ * stored where the state changes, the time between two buckets has the end
+ * state of the earlier one.  A level that has not at least 1/4 fewer
+ * buckets than the level below, e.g. 8s buckets of values measured every
+ * minute, refers to the buckets of that level instead.  So the LOD file
+ * is about the size of the decoded values, and the levels above 0 add at
+ * most 1/3 of it.
+ *
+ * <b>render</b> writes the timeline of one box as SVG image, by default
+ * for the whole time of its LOD file.  Every pixel column aggregates the
+ * buckets of the coarsest level whose buckets are not wider than the
+ * column, so no more than about 8 buckets per column and track are read,
+ * whatever the time span.  The file is mapped into memory and the first
+ * bucket is found by binary search.  Per track, the image shows:
+ * - on/off states as bars whose height is the fraction of on-time,
+ * - measured values as min/max band with the mean as a line,
+ * - events as ticks, the value range and event count as label.
+ *
+ * <b>bench</b> renders timelines of random boxes and start times for time
+ * spans from one minute to the whole season, and prints the mean and
+ * maximum latency incl. opening the file and writing the SVG to /dev/null,
+ * and the mean time of the aggregation alone.  For spans of a day and more
+ * it renders them also from level 0, i.e. from the unaggregated data.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Magic number of a LOD file. */
+#define LOD_MAGIC	0x31444F4C	// "LOD1"
+
+    /*!@brief Number of levels, and the factor between two levels as shift. */
+#define LOD_LEVELS	8
+#define LOD_SHIFT	3
+
+    /*!@brief Default and maximum width of the timeline in pixels. */
+#define DFLT_WIDTH	1200
+#define MAX_WIDTH	8192
+
+    /*!@brief Width of the label column and height of a lane in pixels. */
+#define SVG_LABEL	130
+#define SVG_LANE	36
+
+    /*!@brief Maximum number of transponders present at the same time. */
+#define MAX_PRESENT	16
+
+    /*!@brief Maximum number of boxes for the benchmark. */
+#define MAX_BOXES	1000
+
+    /*!@brief Maximum length of a path name. */
+#define PATH_MAX_SIZE	512
+
+/*!@brief Tracks of a timeline, in the order of the lanes */
+typedef enum
+{
+    TRK_UA1,			//!< UA1 on/off
+    TRK_UA1_U,			//!< UA1 voltage [mV]
+    TRK_UA1_I,			//!< UA1 current [mA]
+    TRK_UA2,			//!< UA2 on/off
+    TRK_UA2_U,			//!< UA2 voltage [mV]
+    TRK_UA2_I,			//!< UA2 current [mA]
+    TRK_BATT,			//!< BATT on/off
+    TRK_BATT_U,			//!< BATT_INP voltage [mV]
+    TRK_BATT_I,			//!< BATT_INP current [mA]
+    TRK_RFID,			//!< Transponder present
+    TRK_CAPACITY,		//!< Remaining battery capacity [mAh]
+    TRK_VOLTAGE,		//!< Battery voltage [mV]
+    TRK_CURRENT,		//!< Battery current [mA]
+    TRK_DCF77,			//!< DCF77 synchronization
+    TRK_LOST,			//!< Lost log entries
+    NUM_TRACKS
+} TRACK;
+
+/*!@brief Kind of a track */
+typedef enum
+{
+    TK_STATE,			//!< On/off state
+    TK_ANALOG,			//!< Measured values
+    TK_EVENT,			//!< Events with a count
+} TRACK_KIND;
+
+/*!@brief Aggregate of one track over the time span of a bucket.
+ *
+ * For @ref TK_STATE, Min and Max are the states at the start and at the end
+ * of the bucket, Cnt is the number of switches to on, and Sum is the on-time
+ * in [ms].
+ */
+typedef struct
+{
+    uint32_t	Idx;		//!< Time in [s] >> Shift of the level
+    uint32_t	Cnt;		//!< Number of values or events
+    int32_t	Min;		//!< Minimum value
+    int32_t	Max;		//!< Maximum value
+    int64_t	Sum;		//!< Sum of the values
+} BUCKET;
+
+/*!@brief Header of a LOD file, the buckets follow */
+typedef struct
+{
+    uint32_t	Magic;		//!< Must be @ref LOD_MAGIC
+    uint32_t	Box;		//!< Box number
+    uint32_t	First;		//!< Time of the first entry in [s]
+    uint32_t	Last;		//!< Time of the last entry in [s]
+    struct
+    {
+	uint64_t Offset;	//!< File offset of the first bucket
+	uint32_t Count;		//!< Number of buckets
+	uint32_t Shift;		//!< Bucket width is 2^Shift seconds
+    } Dir[NUM_TRACKS][LOD_LEVELS];
+} LOD_HDR;
+
+/*!@brief Mapped LOD file */
+typedef struct
+{
+    const LOD_HDR *pHdr;	//!< Header at the start of the mapping
+    size_t	Size;		//!< Size of the file
+} LOD;
+
+/*!@brief Track while building level 0 */
+typedef struct
+{
+    BUCKET     *pBkt;		//!< Buckets
+    uint32_t	Cnt;		//!< Number of buckets
+    uint32_t	Size;		//!< Number of allocated buckets
+    int		State;		//!< TK_STATE: current state
+    uint32_t	LastMs;		//!< TK_STATE: time of the last switch within
+				//!< the last bucket [ms]
+} TRACK_BUILD;
+
+/*!@brief Aggregate of one pixel column */
+typedef struct
+{
+    int32_t	Min;		//!< Minimum value
+    int32_t	Max;		//!< Maximum value
+    uint32_t	Cnt;		//!< Number of values or events
+    double	Sum;		//!< Sum of values, on-time in [ms]
+} COLUMN;
+
+/*!@brief Result of one render */
+typedef struct
+{
+    int		Level;		//!< Level of the buckets
+    uint32_t	Buckets;	//!< Number of buckets read
+    double	AggrTime;	//!< Time to aggregate the buckets in [s]
+} RENDER_INFO;
+
+/*================================ Local Data ================================*/
+
+    /* Properties of the tracks, indexed by TRACK */
+static const struct
+{
+    const char *Name;		// label
+    TRACK_KIND	Kind;
+    const char *Unit;		// unit of the displayed value
+    double	Scale;		// displayed value per stored value
+    const char *Color;
+} l_Track[NUM_TRACKS] =
+{
+    { "UA1 on",		TK_STATE,  "",    1.0,   "#3a7bd5" },
+    { "UA1 U",		TK_ANALOG, "V",   0.001, "#3a7bd5" },
+    { "UA1 I",		TK_ANALOG, "mA",  1.0,   "#3a7bd5" },
+    { "UA2 on",		TK_STATE,  "",    1.0,   "#2e9e5b" },
+    { "UA2 U",		TK_ANALOG, "V",   0.001, "#2e9e5b" },
+    { "UA2 I",		TK_ANALOG, "mA",  1.0,   "#2e9e5b" },
+    { "BATT on",	TK_STATE,  "",    1.0,   "#8e44ad" },
+    { "BATT_INP U",	TK_ANALOG, "V",   0.001, "#8e44ad" },
+    { "BATT_INP I",	TK_ANALOG, "mA",  1.0,   "#8e44ad" },
+    { "Transponder",	TK_STATE,  "",    1.0,   "#d35400" },
+    { "Bat. capacity",	TK_ANALOG, "mAh", 1.0,   "#c0392b" },
+    { "Bat. voltage",	TK_ANALOG, "V",   0.001, "#c0392b" },
+    { "Bat. current",	TK_ANALOG, "mA",  1.0,   "#c0392b" },
+    { "DCF77 sync",	TK_EVENT,  "",    1.0,   "#16a085" },
+    { "Log lost",	TK_EVENT,  "",    1.0,   "#e74c3c" },
+};
+
+    /* Tracks while building, and the transponders that are present */
+static TRACK_BUILD l_Build[NUM_TRACKS];
+static char	l_Present[MAX_PRESENT][TAG_ID_MAX_SIZE];
+static int	l_PresentCnt;
+static uint32_t	l_First, l_Last;
+
+    /* Pixel columns of the track that is rendered */
+static COLUMN	l_Col[MAX_WIDTH];
+
+    /* Random number generator state for the benchmark */
+static uint64_t	l_Rand = 0x2545F4914F6CDD1DULL;
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	cmdBuild (const char *dir, int argc, char **argv);
+static int	cmdRender (const char *dir, int box, uint32_t from, uint32_t to,
+			   int width, const char *path);
+static int	cmdBench (const char *dir, int renders, int width);
+static int	buildFile (const char *path, long *pLines, long *pBytes);
+static void	buildEntry (const LP_ENTRY *pEntry);
+static BUCKET  *bucketGet (TRACK track, uint32_t sec);
+static void	addValue (TRACK track, uint32_t sec, int32_t value);
+static void	setState (TRACK track, uint32_t sec, uint32_t ms, int state);
+static uint32_t	buildLevel (TRACK_KIND kind, int inShift, int outShift,
+			    const BUCKET *pSrc, uint32_t cnt, BUCKET *pDst);
+static int	writeLod (const char *dir, int box, long *pBytes);
+static int	lodOpen (LOD *pLod, const char *dir, int box);
+static void	lodClose (LOD *pLod);
+static const BUCKET *lodBuckets (const LOD *pLod, int track, int level,
+				 uint32_t *pCnt, int *pShift);
+static void	render (FILE *out, const LOD *pLod, uint32_t t0, uint32_t t1,
+			int width, int level, RENDER_INFO *pInfo);
+static uint32_t	aggregate (const LOD *pLod, int track, int level,
+			   uint32_t t0, uint32_t t1, int cols);
+static void	addOnTime (uint32_t a, uint32_t b, uint32_t t0, uint32_t span,
+			   int cols);
+static void	drawTrack (FILE *out, int track, int cols, double colPx,
+			   double y, uint32_t t0, uint32_t span);
+static void	drawAxis (FILE *out, uint32_t t0, uint32_t t1, int width,
+			  double y);
+static uint32_t	colStart (uint32_t t0, uint32_t span, int cols, int c);
+static bool	parseTime (const char *str, uint32_t *pSec);
+static void	timeString (uint32_t sec, char *buf, size_t size);
+static int	boxCompare (const void *p1, const void *p2);
+static uint32_t	rnd (uint32_t range);
+static double	timeNow (void);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+uint32_t from = 0, to = 0;
+int	 box = -1, width = DFLT_WIDTH, renders = 50;
+int	 i;
+
+
+    if (argc < 3)
+	usage();
+
+    if (strcmp (argv[1], "build") == 0)
+	return cmdBuild (argv[2], argc - 3, argv + 3);
+
+    /* Parse options for render and bench */
+    for (i = 3;  i + 1 < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-b") == 0)
+	    box = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-f") == 0  &&  parseTime (argv[i+1], &from))
+	    i++;
+	else if (strcmp (argv[i], "-t") == 0  &&  parseTime (argv[i+1], &to))
+	    i++;
+	else if (strcmp (argv[i], "-w") == 0)
+	    width = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-n") == 0)
+	    renders = atoi (argv[++i]);
+	else
+	    usage();
+    }
+
+    if (width < 100  ||  width > MAX_WIDTH  ||  renders < 1)
+	usage();
+
+    if (strcmp (argv[1], "render") == 0  &&  i == argc - 1  &&  box >= 0)
+	return cmdRender (argv[2], box, from, to, width, argv[i]);
+
+    if (strcmp (argv[1], "bench") == 0  &&  i == argc)
+	return cmdBench (argv[2], renders, width);
+
+    usage();
+    return 1;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Build the LOD Files
+ *
+ * This routine groups the log files by box and writes one LOD file per box.
+ * It reports the preprocessing rate.
+ *
+ ******************************************************************************/
+static int	cmdBuild (const char *dir, int argc, char **argv)
+{
+long	 lines = 0, bytes = 0, outBytes = 0;
+int	 i, j, box, boxes = 0, errors = 0;
+double	 t0, dt;
+
+
+    if (mkdir (dir, 0755) != 0  &&  errno != EEXIST)
+    {
+	perror (dir);
+	return 1;
+    }
+
+    for (i = 0;  i < argc;  i++)
+    {
+	if (LogParseBoxNumber (argv[i]) < 0)
+	{
+	    fprintf (stderr, "%s: Filename does not match BOXnnnn.TXT\n",
+		     argv[i]);
+	    return 1;
+	}
+    }
+    qsort (argv, argc, sizeof(char *), boxCompare);
+
+    t0 = timeNow();
+    for (i = 0;  i < argc;  i = j)
+    {
+	box = LogParseBoxNumber (argv[i]);
+	for (j = 0;  j < NUM_TRACKS;  j++)
+	{
+	    l_Build[j].Cnt = 0;
+	    l_Build[j].State = 0;
+	}
+	l_PresentCnt = 0;
+	l_First = l_Last = 0;
+
+	for (j = i;  j < argc  &&  LogParseBoxNumber (argv[j]) == box;  j++)
+	{
+	    if (buildFile (argv[j], &lines, &bytes) != 0)
+		errors++;
+	}
+	if (l_Last == 0)
+	    continue;			// no entry with a valid time
+
+	if (writeLod (dir, box, &outBytes) != 0)
+	    return 1;
+	boxes++;
+    }
+    dt = timeNow() - t0;
+
+    printf ("Built %d LOD files from %d log files (%d errors), %ld lines,"
+	    " %.1f MB in %.2fs\n", boxes, argc, errors, lines, bytes / 1e6, dt);
+    printf ("LOD files: %.1f MB (%.1f%% of the logs)\n", outBytes / 1e6,
+	    bytes > 0 ? 100.0 * outBytes / bytes : 0.0);
+    if (dt > 0.0)
+	printf ("Preprocessing rate: %.0f lines/s, %.2f MB/s\n",
+		lines / dt, bytes / 1e6 / dt);
+
+    return (errors ? 1 : 0);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add the Entries of a Log File to Level 0
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	buildFile (const char *path, long *pLines, long *pBytes)
+{
+FILE	*fp;
+char	*data, *pLine, *pEnd, *pNL;
+long	 size;
+LP_ENTRY rec;
+
+
+    fp = fopen (path, "rb");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+    fseek (fp, 0, SEEK_END);
+    size = ftell (fp);
+    rewind (fp);
+
+    data = malloc (size + 1);
+    if (data == NULL  ||  fread (data, 1, size, fp) != (size_t)size)
+    {
+	fprintf (stderr, "%s: Read error\n", path);
+	fclose (fp);
+	free (data);
+	return -1;
+    }
+    fclose (fp);
+    data[size] = EOS;
+    *pBytes += size;
+
+    for (pLine = data, pEnd = data + size;  pLine < pEnd;  pLine = pNL)
+    {
+	pNL = memchr (pLine, '\n', pEnd - pLine);
+	pNL = (pNL == NULL ? pEnd : pNL + 1);
+	(*pLines)++;
+
+	if (LogParseLine (pLine, &rec)  &&  rec.Date != 0)
+	    buildEntry (&rec);
+    }
+
+    free (data);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Log Entry to Level 0
+ *
+ * Entries that are older than the last bucket of their track, e.g. after
+ * the clock has been set back, are added to this bucket.
+ *
+ ******************************************************************************/
+static void	buildEntry (const LP_ENTRY *pEntry)
+{
+uint32_t sec, ms;
+int	 i;
+
+
+    sec = (uint32_t)(LogParseDayNumber (pEntry->Date) * 86400
+		     + pEntry->MilliSec / 1000);
+    ms = pEntry->MilliSec % 1000;
+
+    switch (pEntry->Kind)
+    {
+	case LP_OUT_ON:
+	case LP_OUT_OFF:
+	    if (pEntry->A < LP_NUM_OUT)
+		setState (TRK_UA1 + 3 * pEntry->A, sec, ms,
+			  pEntry->Kind == LP_OUT_ON);
+	    break;
+
+	case LP_ALL_OFF:
+	    for (i = 0;  i < LP_NUM_OUT;  i++)
+		setState (TRK_UA1 + 3 * i, sec, ms, 0);
+	    break;
+
+	case LP_MEASURE:
+	    if (pEntry->A < LP_NUM_OUT)
+	    {
+		addValue (TRK_UA1_U + 3 * pEntry->A, sec, pEntry->B);
+		addValue (TRK_UA1_I + 3 * pEntry->A, sec, pEntry->C);
+	    }
+	    break;
+
+	case LP_TAG:
+	case LP_TAG_ABSENT:
+	    for (i = 0;  i < l_PresentCnt;  i++)
+		if (strcmp (l_Present[i], pEntry->Tag) == 0)
+		    break;
+
+	    if (pEntry->Kind == LP_TAG  &&  i == l_PresentCnt
+	    &&  l_PresentCnt < MAX_PRESENT)
+		strcpy (l_Present[l_PresentCnt++], pEntry->Tag);
+	    else if (pEntry->Kind == LP_TAG_ABSENT  &&  i < l_PresentCnt)
+		memmove (l_Present[i], l_Present[--l_PresentCnt],
+			 TAG_ID_MAX_SIZE);
+
+	    setState (TRK_RFID, sec, ms, l_PresentCnt > 0);
+	    break;
+
+	case LP_BAT_CAPACITY:
+	    addValue (TRK_CAPACITY, sec, pEntry->B);
+	    break;
+
+	case LP_BAT_VOLTAGE:
+	    addValue (TRK_VOLTAGE, sec, pEntry->B);
+	    break;
+
+	case LP_BAT_CURRENT:
+	    addValue (TRK_CURRENT, sec, pEntry->B);
+	    break;
+
+	case LP_DCF77_SYNC:
+	    addValue (TRK_DCF77, sec, 1);
+	    break;
+
+	case LP_LOG_LOST:
+	    addValue (TRK_LOST, sec, pEntry->B);
+	    break;
+
+	default:
+	    return;
+    }
+
+    if (l_First == 0)
+	l_First = sec;
+    if (sec > l_Last)
+	l_Last = sec;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Get the Level 0 Bucket of a Track for a Time
+ *
+ * This routine returns the last bucket of the track if it covers @p sec or
+ * a later time, else it appends a new one.  The on-time of the previous
+ * bucket of a state track is completed.
+ *
+ ******************************************************************************/
+static BUCKET  *bucketGet (TRACK track, uint32_t sec)
+{
+TRACK_BUILD *pTrk = &l_Build[track];
+BUCKET	*pBkt;
+
+
+    if (pTrk->Cnt > 0  &&  pTrk->pBkt[pTrk->Cnt - 1].Idx >= sec)
+	return &pTrk->pBkt[pTrk->Cnt - 1];
+
+    if (pTrk->Cnt > 0  &&  pTrk->State)
+	pTrk->pBkt[pTrk->Cnt - 1].Sum += 1000 - pTrk->LastMs;
+
+    if (pTrk->Cnt >= pTrk->Size)
+    {
+	pTrk->Size = (pTrk->Size == 0 ? 4096 : 2 * pTrk->Size);
+	pTrk->pBkt = realloc (pTrk->pBkt, pTrk->Size * sizeof(BUCKET));
+	if (pTrk->pBkt == NULL)
+	{
+	    fprintf (stderr, "Out of memory\n");
+	    exit (1);
+	}
+    }
+
+    pBkt = &pTrk->pBkt[pTrk->Cnt++];
+    pBkt->Idx = sec;
+    pBkt->Cnt = 0;
+    pBkt->Sum = 0;
+    if (l_Track[track].Kind == TK_STATE)
+	pBkt->Min = pBkt->Max = pTrk->State;
+    else
+	pBkt->Min = INT32_MAX, pBkt->Max = INT32_MIN;
+    pTrk->LastMs = 0;
+
+    return pBkt;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add a Value or Event to a Track
+ *
+ ******************************************************************************/
+static void	addValue (TRACK track, uint32_t sec, int32_t value)
+{
+BUCKET	*pBkt = bucketGet (track, sec);
+
+
+    pBkt->Cnt++;
+    pBkt->Sum += value;
+    if (value < pBkt->Min)
+	pBkt->Min = value;
+    if (value > pBkt->Max)
+	pBkt->Max = value;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Set the State of a Track
+ *
+ ******************************************************************************/
+static void	setState (TRACK track, uint32_t sec, uint32_t ms, int state)
+{
+TRACK_BUILD *pTrk = &l_Build[track];
+BUCKET	*pBkt;
+
+
+    if (state == pTrk->State)
+	return;
+
+    pBkt = bucketGet (track, sec);
+    if (pBkt->Idx != sec  ||  ms < pTrk->LastMs)
+	ms = pTrk->LastMs;		// clock has been set back
+
+    if (pTrk->State)
+	pBkt->Sum += ms - pTrk->LastMs;
+    pTrk->LastMs = ms;
+    pTrk->State = state;
+    pBkt->Max = state;
+    if (state)
+	pBkt->Cnt++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Build a Level from the Level below
+ *
+ * This routine merges the buckets of 2^@p inShift seconds into buckets of
+ * 2^@p outShift seconds.  For a state track, the on-time between the
+ * buckets is added from the state at their ends.
+ *
+ * @return
+ *	Number of buckets of the new level.
+ *
+ ******************************************************************************/
+static uint32_t	buildLevel (TRACK_KIND kind, int inShift, int outShift,
+			    const BUCKET *pSrc, uint32_t cnt, BUCKET *pDst)
+{
+const BUCKET *pIn;
+BUCKET	*pOut = NULL;
+int64_t	 childMs = 1000LL << inShift;
+int	 shift = outShift - inShift;
+uint64_t next = 0;		// child after the last merged one
+uint32_t n = 0, i;
+
+
+    for (i = 0;  i < cnt;  i++)
+    {
+	pIn = &pSrc[i];
+	if (pOut == NULL  ||  (pIn->Idx >> shift) != pOut->Idx)
+	{
+	    if (pOut != NULL  &&  kind == TK_STATE)
+		pOut->Sum += pOut->Max * childMs
+			     * ((((uint64_t)pOut->Idx + 1) << shift) - next);
+	    pOut = &pDst[n++];
+	    *pOut = *pIn;
+	    pOut->Idx = pIn->Idx >> shift;
+	    if (kind == TK_STATE)
+		pOut->Sum += pIn->Min * childMs
+			     * (pIn->Idx - ((uint64_t)pOut->Idx << shift));
+	}
+	else if (kind == TK_STATE)
+	{
+	    pOut->Sum += pOut->Max * childMs * (pIn->Idx - next) + pIn->Sum;
+	    pOut->Max = pIn->Max;
+	    pOut->Cnt += pIn->Cnt;
+	}
+	else
+	{
+	    pOut->Sum += pIn->Sum;
+	    pOut->Cnt += pIn->Cnt;
+	    if (pIn->Min < pOut->Min)
+		pOut->Min = pIn->Min;
+	    if (pIn->Max > pOut->Max)
+		pOut->Max = pIn->Max;
+	}
+	next = (uint64_t)pIn->Idx + 1;
+    }
+
+    if (pOut != NULL  &&  kind == TK_STATE)
+	pOut->Sum += pOut->Max * childMs
+		     * ((((uint64_t)pOut->Idx + 1) << shift) - next);
+
+    return n;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Write the LOD File of a Box
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	writeLod (const char *dir, int box, long *pBytes)
+{
+static LOD_HDR hdr;
+char	 path[PATH_MAX_SIZE];
+BUCKET	*pLevel[LOD_LEVELS];
+uint32_t cnt[LOD_LEVELS];
+uint64_t offset = sizeof(LOD_HDR);
+TRACK_BUILD *pTrk;
+FILE	*fp;
+int	 t, l;
+
+
+    snprintf (path, sizeof(path), "%s/BOX%04d.LOD", dir, box);
+    fp = fopen (path, "wb");
+    if (fp == NULL)
+    {
+	perror (path);
+	return -1;
+    }
+
+    memset (&hdr, 0, sizeof(hdr));
+    hdr.Magic = LOD_MAGIC;
+    hdr.Box = box;
+    hdr.First = l_First;
+    hdr.Last = l_Last;
+    fwrite (&hdr, sizeof(hdr), 1, fp);		// directory follows
+
+    for (t = 0;  t < NUM_TRACKS;  t++)
+    {
+	pTrk = &l_Build[t];
+	if (pTrk->Cnt > 0  &&  pTrk->State)	// complete the last bucket
+	    pTrk->pBkt[pTrk->Cnt - 1].Sum += 1000 - pTrk->LastMs;
+
+	pLevel[0] = pTrk->pBkt;
+	cnt[0] = pTrk->Cnt;
+	hdr.Dir[t][0].Offset = offset;
+	hdr.Dir[t][0].Count = cnt[0];
+	offset += cnt[0] * sizeof(BUCKET);
+	fwrite (pLevel[0], sizeof(BUCKET), cnt[0], fp);
+
+	for (l = 1;  l < LOD_LEVELS;  l++)
+	{
+	    pLevel[l] = malloc ((cnt[l-1] + 1) * sizeof(BUCKET));
+	    if (pLevel[l] == NULL)
+	    {
+		fprintf (stderr, "Out of memory\n");
+		exit (1);
+	    }
+	    cnt[l] = buildLevel (l_Track[t].Kind, hdr.Dir[t][l-1].Shift,
+				 l * LOD_SHIFT, pLevel[l-1], cnt[l-1], pLevel[l]);
+
+	    if ((uint64_t)cnt[l] * 4 > (uint64_t)cnt[l-1] * 3)
+	    {
+		/* Not worth it, refer to the level below */
+		free (pLevel[l]);
+		pLevel[l] = pLevel[l-1];
+		cnt[l] = cnt[l-1];
+		hdr.Dir[t][l] = hdr.Dir[t][l-1];
+		continue;
+	    }
+
+	    hdr.Dir[t][l].Offset = offset;
+	    hdr.Dir[t][l].Count = cnt[l];
+	    hdr.Dir[t][l].Shift = l * LOD_SHIFT;
+	    offset += cnt[l] * sizeof(BUCKET);
+	    fwrite (pLevel[l], sizeof(BUCKET), cnt[l], fp);
+	}
+
+	for (l = LOD_LEVELS - 1;  l > 0;  l--)
+	    if (pLevel[l] != pLevel[l-1])
+		free (pLevel[l]);
+    }
+
+    rewind (fp);
+    fwrite (&hdr, sizeof(hdr), 1, fp);
+    if (ferror (fp)  ||  fclose (fp) != 0)
+    {
+	fprintf (stderr, "%s: Write error\n", path);
+	return -1;
+    }
+
+    *pBytes += (long)offset;
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Render the Timeline of a Box
+ *
+ ******************************************************************************/
+static int	cmdRender (const char *dir, int box, uint32_t from, uint32_t to,
+			   int width, const char *path)
+{
+LOD	 lod;
+FILE	*out;
+RENDER_INFO info;
+double	 t0;
+
+
+    t0 = timeNow();
+    if (lodOpen (&lod, dir, box) != 0)
+	return 1;
+
+    if (from == 0  ||  from < lod.pHdr->First)
+	from = lod.pHdr->First;
+    if (to == 0  ||  to > lod.pHdr->Last + 1)
+	to = lod.pHdr->Last + 1;
+    if (to <= from)
+    {
+	fprintf (stderr, "No data in this time range\n");
+	lodClose (&lod);
+	return 1;
+    }
+
+    out = fopen (path, "w");
+    if (out == NULL)
+    {
+	perror (path);
+	lodClose (&lod);
+	return 1;
+    }
+    render (out, &lod, from, to, width, -1, &info);
+    fclose (out);
+    lodClose (&lod);
+
+    printf ("Rendered %u s at level %d (%u s buckets), %u buckets in %.2f ms\n",
+	    to - from, info.Level, 1U << (info.Level * LOD_SHIFT),
+	    info.Buckets, (timeNow() - t0) * 1000.0);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Benchmark the Render Latency
+ *
+ * This routine renders @p renders timelines per time span, each of a
+ * random box and start time, and prints the mean and maximum latency.
+ *
+ ******************************************************************************/
+static int	cmdBench (const char *dir, int renders, int width)
+{
+static const struct { uint32_t Sec; const char *Name; } spans[] =
+{
+    { 60, "1 minute" }, { 3600, "1 hour" }, { 86400, "1 day" },
+    { 7 * 86400, "1 week" }, { 30 * 86400, "30 days" }, { 0, "season" }
+};
+static int boxes[MAX_BOXES];
+DIR	*pDir;
+struct dirent *pEnt;
+FILE	*out;
+LOD	 lod;
+RENDER_INFO info;
+uint32_t t0, span, buckets;
+double	 t, sum, max, aggr;
+int	 boxCnt = 0, s, mode, n, level;
+
+
+    pDir = opendir (dir);
+    if (pDir == NULL)
+    {
+	perror (dir);
+	return 1;
+    }
+    while ((pEnt = readdir (pDir)) != NULL  &&  boxCnt < MAX_BOXES)
+    {
+	if (strncmp (pEnt->d_name, "BOX", 3) == 0
+	&&  strstr (pEnt->d_name, ".LOD") != NULL)
+	    boxes[boxCnt++] = atoi (pEnt->d_name + 3);
+    }
+    closedir (pDir);
+
+    out = fopen ("/dev/null", "w");
+    if (boxCnt == 0  ||  out == NULL)
+    {
+	fprintf (stderr, "%s: No LOD files found\n", dir);
+	return 1;
+    }
+
+    printf ("%d boxes, %d renders per span, %d pixels wide\n\n", boxCnt,
+	    renders, width);
+    printf ("%-10s %-8s %5s %8s %9s %9s %9s\n", "Span", "Mode", "Level",
+	    "Buckets", "Aggr[ms]", "Mean[ms]", "Max[ms]");
+
+    for (s = 0;  s < (int)ELEM_CNT(spans);  s++)
+    {
+	for (mode = 0;  mode < 2;  mode++)
+	{
+	    /* Level 0 only for the long spans */
+	    if (mode == 1  &&  spans[s].Sec != 0  &&  spans[s].Sec < 86400)
+		continue;
+
+	    sum = max = aggr = 0.0;
+	    buckets = 0;
+	    level = 0;
+	    for (n = 0;  n < renders;  n++)
+	    {
+		t = timeNow();
+		if (lodOpen (&lod, dir, boxes[rnd (boxCnt)]) != 0)
+		    return 1;
+
+		span = lod.pHdr->Last + 1 - lod.pHdr->First;
+		if (spans[s].Sec != 0  &&  spans[s].Sec < span)
+		{
+		    t0 = lod.pHdr->First + rnd (span - spans[s].Sec);
+		    span = spans[s].Sec;
+		}
+		else
+		{
+		    t0 = lod.pHdr->First;
+		}
+
+		render (out, &lod, t0, t0 + span, width, mode ? 0 : -1, &info);
+		lodClose (&lod);
+
+		t = timeNow() - t;
+		sum += t;
+		if (t > max)
+		    max = t;
+		buckets += info.Buckets;
+		aggr += info.AggrTime;
+		if (info.Level > level)
+		    level = info.Level;
+	    }
+
+	    printf ("%-10s %-8s %5d %8u %9.3f %9.3f %9.3f\n", spans[s].Name,
+		    mode ? "level 0" : "LOD", level, buckets / renders,
+		    aggr / renders * 1000.0, sum / renders * 1000.0,
+		    max * 1000.0);
+	}
+    }
+
+    fclose (out);
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Open and Map a LOD File
+ *
+ * @return
+ *	0 on success, -1 on error.
+ *
+ ******************************************************************************/
+static int	lodOpen (LOD *pLod, const char *dir, int box)
+{
+char	 path[PATH_MAX_SIZE];
+struct stat st;
+void	*pMap;
+int	 fd;
+
+
+    snprintf (path, sizeof(path), "%s/BOX%04d.LOD", dir, box);
+    fd = open (path, O_RDONLY);
+    if (fd < 0  ||  fstat (fd, &st) != 0)
+    {
+	perror (path);
+	if (fd >= 0)
+	    close (fd);
+	return -1;
+    }
+
+    pMap = MAP_FAILED;
+    if ((size_t)st.st_size >= sizeof(LOD_HDR))
+	pMap = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+
+    if (pMap == MAP_FAILED  ||  ((LOD_HDR *)pMap)->Magic != LOD_MAGIC)
+    {
+	fprintf (stderr, "%s: Not a LOD file\n", path);
+	if (pMap != MAP_FAILED)
+	    munmap (pMap, st.st_size);
+	return -1;
+    }
+
+    pLod->pHdr = pMap;
+    pLod->Size = st.st_size;
+    return 0;
+}
+
+static void	lodClose (LOD *pLod)
+{
+    munmap ((void *)pLod->pHdr, pLod->Size);
+}
+
+static const BUCKET *lodBuckets (const LOD *pLod, int track, int level,
+				 uint32_t *pCnt, int *pShift)
+{
+uint64_t offset = pLod->pHdr->Dir[track][level].Offset;
+uint64_t cnt = pLod->pHdr->Dir[track][level].Count;
+
+
+    if (offset + cnt * sizeof(BUCKET) > pLod->Size)
+	cnt = 0;			// truncated file
+    *pCnt = (uint32_t)cnt;
+    *pShift = pLod->pHdr->Dir[track][level].Shift;
+    return (const BUCKET *)((const char *)pLod->pHdr + offset);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Render a Timeline as SVG
+ *
+ * @param[in] out
+ *	Output file.
+ *
+ * @param[in] pLod
+ *	LOD file of the box.
+ *
+ * @param[in] t0, t1
+ *	Time span [t0, t1) in [s].
+ *
+ * @param[in] width
+ *	Width of the time axis in pixels.
+ *
+ * @param[in] level
+ *	Level to use, -1 selects it from the pixel width.
+ *
+ * @param[out] pInfo
+ *	Level used and number of buckets read.
+ *
+ ******************************************************************************/
+static void	render (FILE *out, const LOD *pLod, uint32_t t0, uint32_t t1,
+			int width, int level, RENDER_INFO *pInfo)
+{
+uint32_t span = t1 - t0, secPerCol, cnt;
+char	 from[32], to[32];
+int	 cols, lanes = 0, t, shift;
+double	 y, tAggr;
+
+
+    /* One column per second at most */
+    cols = (span < (uint32_t)width ? (int)span : width);
+    secPerCol = span / cols;
+    if (level < 0)
+    {
+	for (level = 0;  level < LOD_LEVELS - 1;  level++)
+	    if ((1U << ((level + 1) * LOD_SHIFT)) > secPerCol)
+		break;
+    }
+    pInfo->Level = level;
+    pInfo->Buckets = 0;
+    pInfo->AggrTime = 0.0;
+
+    for (t = 0;  t < NUM_TRACKS;  t++)
+    {
+	lodBuckets (pLod, t, 0, &cnt, &shift);
+	lanes += (cnt > 0);
+    }
+
+    timeString (t0, from, sizeof(from));
+    timeString (t1, to, sizeof(to));
+    fprintf (out, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\""
+	     " height=\"%d\" font-family=\"sans-serif\" font-size=\"11\">\n"
+	     "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n"
+	     "<text x=\"4\" y=\"16\" font-size=\"13\">BOX%04u  %s - %s</text>\n",
+	     SVG_LABEL + width + 10, 30 + lanes * SVG_LANE + 30,
+	     pLod->pHdr->Box, from, to);
+
+    y = 30.0;
+    for (t = 0;  t < NUM_TRACKS;  t++)
+    {
+	lodBuckets (pLod, t, 0, &cnt, &shift);
+	if (cnt == 0)
+	    continue;			// no data at all
+
+	tAggr = timeNow();
+	pInfo->Buckets += aggregate (pLod, t, level, t0, t1, cols);
+	pInfo->AggrTime += timeNow() - tAggr;
+	drawTrack (out, t, cols, (double)width / cols, y, t0, span);
+	y += SVG_LANE;
+    }
+
+    drawAxis (out, t0, t1, width, y);
+    fprintf (out, "</svg>\n");
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Aggregate the Buckets of a Track into Pixel Columns
+ *
+ * @return
+ *	Number of buckets read.
+ *
+ ******************************************************************************/
+static uint32_t	aggregate (const LOD *pLod, int track, int level,
+			   uint32_t t0, uint32_t t1, int cols)
+{
+const BUCKET *pBkt;
+uint32_t cnt, lo, hi, mid, i, span = t1 - t0, end, bs, be, tc;
+int	 shift, st, c;
+COLUMN	*pCol;
+
+
+    for (c = 0;  c < cols;  c++)
+    {
+	l_Col[c].Min = INT32_MAX;
+	l_Col[c].Max = INT32_MIN;
+	l_Col[c].Cnt = 0;
+	l_Col[c].Sum = 0.0;
+    }
+
+    /* First bucket that ends after t0 */
+    pBkt = lodBuckets (pLod, track, level, &cnt, &shift);
+    for (lo = 0, hi = cnt;  lo < hi;  )
+    {
+	mid = lo + (hi - lo) / 2;
+	if ((((uint64_t)pBkt[mid].Idx + 1) << shift) <= t0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    end = (t1 < pLod->pHdr->Last + 1 ? t1 : pLod->pHdr->Last + 1);
+    st = (lo > 0 ? pBkt[lo - 1].Max : lo < cnt ? pBkt[lo].Min : 0);
+    tc = t0;
+
+    for (i = lo;  i < cnt  &&  ((uint64_t)pBkt[i].Idx << shift) < t1;  i++)
+    {
+	bs = pBkt[i].Idx << shift;
+	be = (uint32_t)((((uint64_t)pBkt[i].Idx + 1) << shift) - 1);	// last second
+	c = (int)((uint64_t)((bs > t0 ? bs : t0) - t0) * cols / span);
+	pCol = &l_Col[c];
+
+	if (l_Track[track].Kind == TK_STATE)
+	{
+	    if (st  &&  bs > tc)
+		addOnTime (tc, bs, t0, span, cols);
+	    /* Clip a bucket at the edge of the window */
+	    pCol->Sum += (double)pBkt[i].Sum
+			 * ((be < t1 - 1 ? be : t1 - 1) - (bs > t0 ? bs : t0) + 1)
+			 / (be - bs + 1);
+	    tc = be + 1;
+	    st = pBkt[i].Max;
+	}
+	else
+	{
+	    pCol->Sum += (double)pBkt[i].Sum;
+	    if (pBkt[i].Min < pCol->Min)
+		pCol->Min = pBkt[i].Min;
+	    if (pBkt[i].Max > pCol->Max)
+		pCol->Max = pBkt[i].Max;
+	}
+	pCol->Cnt += pBkt[i].Cnt;
+    }
+
+    if (l_Track[track].Kind == TK_STATE  &&  st  &&  end > tc)
+	addOnTime (tc, end, t0, span, cols);
+
+    return i - lo;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add the On-Time of [a, b) to the Pixel Columns
+ *
+ ******************************************************************************/
+static void	addOnTime (uint32_t a, uint32_t b, uint32_t t0, uint32_t span,
+			   int cols)
+{
+uint32_t e;
+int	 c;
+
+
+    if (a < t0)
+	a = t0;
+    if (b > t0 + span)
+	b = t0 + span;
+
+    for (c = (int)((uint64_t)(a - t0) * cols / span);  a < b  &&  c < cols;  c++)
+    {
+	e = colStart (t0, span, cols, c + 1);
+	if (e > b)
+	    e = b;
+	if (e > a)
+	    l_Col[c].Sum += (e - a) * 1000.0;
+	a = e;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Draw the Lane of a Track
+ *
+ ******************************************************************************/
+static void	drawTrack (FILE *out, int track, int cols, double colPx,
+			   double y, uint32_t t0, uint32_t span)
+{
+const char *color = l_Track[track].Color;
+double	 scale = l_Track[track].Scale, h = SVG_LANE - 8, x, v, frac, prev;
+int32_t	 lo = INT32_MAX, hi = INT32_MIN;
+uint32_t events = 0;
+double	 sum = 0.0;
+int	 c, c0, first;
+
+
+    fprintf (out, "<text x=\"4\" y=\"%.0f\">%s</text>\n", y + 13,
+	     l_Track[track].Name);
+    fprintf (out, "<line x1=\"%d\" x2=\"%.0f\" y1=\"%.1f\" y2=\"%.1f\""
+	     " stroke=\"#ddd\"/>\n", SVG_LABEL, SVG_LABEL + cols * colPx,
+	     y + SVG_LANE - 2, y + SVG_LANE - 2);
+
+    switch (l_Track[track].Kind)
+    {
+	case TK_STATE:
+	    /* Bars of the on-time fraction, runs of equal height merged */
+	    for (c0 = 0, prev = -1.0, c = 0;  c <= cols;  c++)
+	    {
+		frac = 0.0;
+		if (c < cols)
+		{
+		    v = (colStart (t0, span, cols, c + 1)
+			 - colStart (t0, span, cols, c)) * 1000.0;
+		    frac = (v > 0.0 ? l_Col[c].Sum / v : 0.0);
+		    frac = (frac > 1.0 ? 1.0 : floor (frac * h + 0.5) / h);
+		    events += l_Col[c].Cnt;
+		    sum += l_Col[c].Sum;
+		}
+		if (c == cols  ||  frac != prev)
+		{
+		    if (prev > 0.0)
+			fprintf (out, "<rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\""
+				 " height=\"%.1f\" fill=\"%s\"/>\n",
+				 SVG_LABEL + c0 * colPx, y + 2 + h * (1.0 - prev),
+				 (c - c0) * colPx, h * prev, color);
+		    c0 = c;
+		    prev = frac;
+		}
+	    }
+	    fprintf (out, "<text x=\"4\" y=\"%.0f\" fill=\"#666\">%.1f%% on,"
+		     " %u on</text>\n", y + 26, 100.0 * sum / 1000.0 / span,
+		     events);
+	    break;
+
+	case TK_ANALOG:
+	    for (c = 0;  c < cols;  c++)
+	    {
+		if (l_Col[c].Cnt == 0)
+		    continue;
+		if (l_Col[c].Min < lo)
+		    lo = l_Col[c].Min;
+		if (l_Col[c].Max > hi)
+		    hi = l_Col[c].Max;
+	    }
+	    if (lo > hi)
+		break;			// no values in this time span
+	    if (hi == lo)
+		hi = lo + 1;
+
+	    /* Min/max band */
+	    fprintf (out, "<path stroke=\"%s\" stroke-opacity=\"0.35\""
+		     " stroke-width=\"%.1f\" d=\"", color,
+		     colPx > 1.0 ? colPx : 1.0);
+	    for (c = 0;  c < cols;  c++)
+	    {
+		if (l_Col[c].Cnt == 0)
+		    continue;
+		x = SVG_LABEL + (c + 0.5) * colPx;
+		fprintf (out, "M%.1f %.1fV%.1f", x,
+			 y + 2 + h * (hi - l_Col[c].Min) / (hi - lo) + 0.5,
+			 y + 2 + h * (hi - l_Col[c].Max) / (hi - lo) - 0.5);
+	    }
+
+	    /* Mean, interrupted where there are no values */
+	    fprintf (out, "\"/>\n<path fill=\"none\" stroke=\"%s\" d=\"", color);
+	    for (first = 1, c = 0;  c < cols;  c++)
+	    {
+		if (l_Col[c].Cnt == 0)
+		{
+		    first = 1;
+		    continue;
+		}
+		x = SVG_LABEL + (c + 0.5) * colPx;
+		v = l_Col[c].Sum / l_Col[c].Cnt;
+		fprintf (out, "%c%.1f %.1f", first ? 'M' : 'L', x,
+			 y + 2 + h * (hi - v) / (hi - lo));
+		first = 0;
+	    }
+	    fprintf (out, "\"/>\n<text x=\"4\" y=\"%.0f\" fill=\"#666\">"
+		     "%g..%g %s</text>\n", y + 26, lo * scale, hi * scale,
+		     l_Track[track].Unit);
+	    break;
+
+	case TK_EVENT:
+	    /* Ticks, the height grows with the logarithm of the sum */
+	    fprintf (out, "<path stroke=\"%s\" stroke-width=\"%.1f\" d=\"",
+		     color, colPx > 1.0 ? colPx : 1.0);
+	    for (c = 0;  c < cols;  c++)
+	    {
+		if (l_Col[c].Cnt == 0)
+		    continue;
+		v = log10 (1.0 + fabs (l_Col[c].Sum)) / 4.0;
+		v = (v < 0.25 ? 0.25 : v > 1.0 ? 1.0 : v);
+		fprintf (out, "M%.1f %.1fV%.1f", SVG_LABEL + (c + 0.5) * colPx,
+			 y + 2 + h, y + 2 + h * (1.0 - v));
+		events += l_Col[c].Cnt;
+		sum += l_Col[c].Sum;
+	    }
+	    fprintf (out, "\"/>\n<text x=\"4\" y=\"%.0f\" fill=\"#666\">"
+		     "%u events, sum %.0f</text>\n", y + 26, events, sum);
+	    break;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Draw the Time Axis
+ *
+ * The tick interval is the shortest one of a list of round intervals that
+ * leaves at least 100 pixels between the labels.
+ *
+ ******************************************************************************/
+static void	drawAxis (FILE *out, uint32_t t0, uint32_t t1, int width,
+			  double y)
+{
+static const uint32_t steps[] =
+{
+    1, 2, 5, 10, 30, 60, 120, 300, 600, 1800, 3600, 7200, 3 * 3600,
+    6 * 3600, 12 * 3600, 86400, 2 * 86400, 7 * 86400, 14 * 86400, 28 * 86400
+};
+uint32_t span = t1 - t0, step, t;
+char	 label[32];
+double	 x;
+unsigned int i;
+
+
+    for (i = 0;  i < ELEM_CNT(steps) - 1;  i++)
+	if ((uint64_t)steps[i] * width >= (uint64_t)span * 100)
+	    break;
+    step = steps[i];
+
+    fprintf (out, "<line x1=\"%d\" x2=\"%d\" y1=\"%.0f\" y2=\"%.0f\""
+	     " stroke=\"black\"/>\n", SVG_LABEL, SVG_LABEL + width, y, y);
+
+    for (t = (t0 + step - 1) / step * step;  t < t1;  t += step)
+    {
+	x = SVG_LABEL + (double)(t - t0) * width / span;
+	timeString (t, label, sizeof(label));
+	fprintf (out, "<line x1=\"%.1f\" x2=\"%.1f\" y1=\"%.0f\" y2=\"%.0f\""
+		 " stroke=\"black\"/>\n<text x=\"%.1f\" y=\"%.0f\""
+		 " text-anchor=\"middle\">%s</text>\n", x, x, y, y + 4, x,
+		 y + 16, step >= 86400 ? label + 5 :	// MM-DD
+		 step >= 60 ? label + 11 : label + 11);	// HH:MM[:SS]
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static uint32_t	colStart (uint32_t t0, uint32_t span, int cols, int c)
+{
+    /* First second t with (t - t0) * cols / span == c */
+    return t0 + (uint32_t)(((uint64_t)c * span + cols - 1) / cols);
+}
+
+static bool	parseTime (const char *str, uint32_t *pSec)
+{
+char	*pEnd;
+unsigned long date, hms = 0;
+size_t	 len;
+
+
+    date = strtoul (str, &pEnd, 10);
+    if (pEnd - str != 8)
+	return false;
+    if (*pEnd == '-')
+    {
+	len = strlen (pEnd + 1);
+	hms = strtoul (pEnd + 1, &pEnd, 10);
+	if ((len != 4  &&  len != 6)  ||  *pEnd != EOS)
+	    return false;
+	if (len == 4)
+	    hms *= 100;
+    }
+    else if (*pEnd != EOS)
+    {
+	return false;
+    }
+
+    *pSec = (uint32_t)(LogParseDayNumber (date) * 86400 + (hms / 10000) * 3600
+		       + ((hms / 100) % 100) * 60 + hms % 100);
+    return true;
+}
+
+static void	timeString (uint32_t sec, char *buf, size_t size)
+{
+uint32_t date = LogParseDayToDate (sec / 86400), s = sec % 86400;
+
+
+    snprintf (buf, size, "%04u-%02u-%02u %02u:%02u:%02u", date / 10000,
+	      (date / 100) % 100, date % 100, s / 3600, (s / 60) % 60, s % 60);
+}
+
+static int	boxCompare (const void *p1, const void *p2)
+{
+const char *path1 = *(const char * const *)p1;
+const char *path2 = *(const char * const *)p2;
+int	 box1 = LogParseBoxNumber (path1), box2 = LogParseBoxNumber (path2);
+
+
+    if (box1 != box2)
+	return (box1 < box2 ? -1 : 1);
+    return (path1 < path2 ? -1 : path1 > path2);	// keep the order given
+}
+
+static uint32_t	rnd (uint32_t range)
+{
+    l_Rand ^= l_Rand >> 12;
+    l_Rand ^= l_Rand << 25;
+    l_Rand ^= l_Rand >> 27;
+    return (uint32_t)((l_Rand * 0x2545F4914F6CDD1DULL) >> 32) % range;
+}
+
+static double	timeNow (void)
+{
+struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void	usage (void)
+{
+    fprintf (stderr,
+	"Usage: LogView build  <lod_dir> <BOXnnnn.TXT>...\n"
+	"       LogView render <lod_dir> -b <box> [-f <from>] [-t <to>]"
+	" [-w <width>] <out.svg>\n"
+	"       LogView bench  <lod_dir> [-n <renders>] [-w <width>]\n"
+	"<from>, <to>: YYYYMMDD[-HHMM[SS]]\n");
+    exit (1);
+}
@@ -0,0 +1,471 @@
+/***************************************************************************//**
+ * @file
+ * @brief	NMEA Stream Generator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool generates the NMEA stream of a GNSS receiver, to test the
+ * GNSS time source of the firmware, see GNSS.c.
+ *
+ * Usage:
+ * @code
+ * NmeaGen [-s <YYYYMMDDhhmmss>] [-n <seconds>] [-c <cold_s>] [-e <err_rate>]
+ *	   [-r <seed>] [-R] [-o <file|tty>]
+ * NmeaGen -t [-s <YYYYMMDDhhmmss>] [-k <runs>] [-c <cold_s>] [-e <err_rate>]
+ *	   [-p <dcf_err_rate>] [-r <seed>]
+ * @endcode
+ *
+ * Every second consists of the sentences GGA, GSV, RMC, and ZDA, starting at
+ * the UTC time <i>YYYYMMDDhhmmss</i> (default 2026-03-25 02:05:00, i.e. 03:05
+ * MEZ four days before the change to MESZ).  During the first <i>cold_s</i>
+ * seconds (default 30) the receiver has no fix: the time fields are empty
+ * for the first half, then the RMC status is V.  A fraction <i>err_rate</i>
+ * of the sentences (default 0.02) gets a corrupted character or a lost one.
+ *
+ * Without option <b>-t</b>, <i>seconds</i> seconds of the stream (default
+ * 120) are written to stdout or to the file given by <b>-o</b>.  Option
+ * <b>-R</b> writes in real time, and if the output is a serial port, its RTS
+ * line is raised for 100ms at the start of every second, so it can drive the
+ * PPS input of a box on the bench.
+ *
+ * Option <b>-t</b> runs <i>runs</i> (default 100) daily synchronizations
+ * through the NMEA parser of the firmware.  The cold start time of each run
+ * is random between 1 and <i>cold_s</i> seconds.  Like GNSSPpsHandler(), the
+ * clock is set on the PPS pulse after @ref FIX_SEQ_CNT consecutive seconds.
+ * Every synchronization is checked against the expected time, converted to
+ * local time by the C library with TZ=Europe/Berlin.  NmeaLocalTime() is
+ * also checked every 3599 seconds from 2000 to 2099.  The time to sync and
+ * the energy per sync are compared with a model of the DCF77 decoder: it
+ * waits for the minute mark, and needs 2 consecutive valid frames of 60s,
+ * each of them lost with probability <i>dcf_err_rate</i> (default 0.1).
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include "Nmea.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Unix time of 2000-01-01 00:00:00 UTC. */
+#define EPOCH_2000	946684800L
+
+    /*!@brief Same values as in GNSS.h and DCF77.h of the firmware. */
+#define FIX_SEQ_CNT	2
+#define GNSS_TIMEOUT	600
+#define GNSS_CURRENT	12000	// [uA]
+#define DCF77_CURRENT	100	// [uA]
+
+    /*!@brief Maximum length of the sentences of one second. */
+#define SECOND_SIZE	512
+
+/*================================ Local Data ================================*/
+
+    /* Options */
+static long	l_Start;		// UTC, seconds since 2000
+static int	l_ColdSecs = 30;
+static double	l_ErrRate = 0.02;
+static double	l_DcfErrRate = 0.1;
+
+    /* Random number generator state */
+static uint64_t	l_Rand = 88172645463325252ULL;
+
+/*=========================== Forward Declarations ===========================*/
+
+static int	genSecond (char *pBuf, long utc, int coldLeft, int coldSecs);
+static int	addSentence (char *pBuf, const char *pBody);
+static double	randUniform (void);
+static int	testRuns (int runs);
+static int	testLocalTime (void);
+static bool	hostLocalTime (long utc, struct tm *pTm);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+const char *pStart = "20260325020500";
+const char *pOut = NULL;
+struct tm tm;
+char	buf[SECOND_SIZE];
+bool	flgTest = false, flgRealTime = false, flgTty;
+long	seconds = 120;
+int	runs = 100;
+int	fd = 1, i, len, rts = TIOCM_RTS;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-t") == 0)
+	    flgTest = true;
+	else if (strcmp (argv[i], "-R") == 0)
+	    flgRealTime = true;
+	else if (strcmp (argv[i], "-s") == 0  &&  i + 1 < argc)
+	    pStart = argv[++i];
+	else if (strcmp (argv[i], "-n") == 0  &&  i + 1 < argc)
+	    seconds = atol (argv[++i]);
+	else if (strcmp (argv[i], "-k") == 0  &&  i + 1 < argc)
+	    runs = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-c") == 0  &&  i + 1 < argc)
+	    l_ColdSecs = atoi (argv[++i]);
+	else if (strcmp (argv[i], "-e") == 0  &&  i + 1 < argc)
+	    l_ErrRate = atof (argv[++i]);
+	else if (strcmp (argv[i], "-p") == 0  &&  i + 1 < argc)
+	    l_DcfErrRate = atof (argv[++i]);
+	else if (strcmp (argv[i], "-r") == 0  &&  i + 1 < argc)
+	    l_Rand ^= strtoull (argv[++i], NULL, 10) * 2654435761ULL;
+	else if (strcmp (argv[i], "-o") == 0  &&  i + 1 < argc)
+	    pOut = argv[++i];
+	else
+	    usage();
+    }
+    if (i < argc  ||  l_ColdSecs < 1)
+	usage();
+
+    /* Start time */
+    memset (&tm, 0, sizeof(tm));
+    if (strlen (pStart) != 14
+    ||  sscanf (pStart, "%4d%2d%2d%2d%2d%2d", &tm.tm_year, &tm.tm_mon,
+		&tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6
+    ||  tm.tm_year < 2000  ||  tm.tm_year > 2098)
+	usage();
+    tm.tm_year -= 1900;
+    tm.tm_mon--;
+    l_Start = (long)timegm (&tm) - EPOCH_2000;
+
+    if (flgTest)
+	return testRuns (runs) | testLocalTime();
+
+    if (pOut != NULL)
+    {
+	fd = open (pOut, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+	if (fd < 0)
+	{
+	    perror (pOut);
+	    return 1;
+	}
+    }
+    flgTty = isatty (fd);
+
+    for (i = 0;  i < seconds;  i++)
+    {
+	/* PPS pulse via RTS, then the sentences of this second */
+	if (flgRealTime  &&  flgTty)
+	{
+	    ioctl (fd, TIOCMBIS, &rts);
+	    usleep (100000);
+	    ioctl (fd, TIOCMBIC, &rts);
+	}
+	len = genSecond (buf, l_Start + i, l_ColdSecs - i, l_ColdSecs);
+	if (write (fd, buf, len) != len)
+	{
+	    perror ("write");
+	    return 1;
+	}
+	if (flgRealTime)
+	    usleep (flgTty ? 900000 : 1000000);
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * @brief  Generate the Sentences of one Second
+ *
+ * @param[in] coldLeft
+ *	Seconds left until the first fix, 0 or less if there is a fix.
+ *
+ * @param[in] coldSecs
+ *	Cold start time, the time fields are empty during the first half.
+ *
+ * @return
+ *	Number of characters in <b>pBuf</b>.
+ *****************************************************************************/
+static int	genSecond (char *pBuf, long utc, int coldLeft, int coldSecs)
+{
+char	body[160];
+char	hms[40], dmy[40], zda[40];
+time_t	t = (time_t)(utc + EPOCH_2000);
+struct tm tm;
+bool	flgTime = (coldLeft <= coldSecs / 2);	// RTC time after half
+bool	flgFix  = (coldLeft <= 0);
+int	len = 0;
+
+
+    gmtime_r (&t, &tm);
+    snprintf (hms, sizeof(hms), "%02d%02d%02d.00",
+	      tm.tm_hour, tm.tm_min, tm.tm_sec);
+    snprintf (dmy, sizeof(dmy), "%02d%02d%02d",
+	      tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+    snprintf (zda, sizeof(zda), "%02d,%02d,%04d",
+	      tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900);
+
+    snprintf (body, sizeof(body), "GPGGA,%s,%s,%d,%02d,1.1,545.4,M,46.9,M,,",
+	      flgTime ? hms : "", flgFix ? "4807.038,N,01131.000,E" : ",,,",
+	      flgFix ? 1 : 0, flgFix ? 8 : 0);
+    len += addSentence (pBuf + len, body);
+
+    len += addSentence (pBuf + len, "GPGSV,2,1,08,01,40,083,46,02,17,308,41,"
+			"12,07,344,39,14,22,228,45");
+
+    snprintf (body, sizeof(body), "GPRMC,%s,%c,%s,0.0,0.0,%s,,,%c",
+	      flgTime ? hms : "", flgFix ? 'A' : 'V',
+	      flgFix ? "4807.038,N,01131.000,E" : ",,,", flgTime ? dmy : "",
+	      flgFix ? 'A' : 'N');
+    len += addSentence (pBuf + len, body);
+
+    snprintf (body, sizeof(body), "GPZDA,%s,%s,00,00",
+	      flgTime ? hms : "", flgTime ? zda : ",,");
+    len += addSentence (pBuf + len, body);
+
+    return len;
+}
+
+
+/******************************************************************************
+ * @brief  Add a Sentence
+ *
+ * This routine appends '$', the body, the checksum, and CR/LF.  A fraction
+ * @ref l_ErrRate of the sentences gets a corrupted or a lost character.
+ *
+ * @return
+ *	Number of characters added.
+ *****************************************************************************/
+static int	addSentence (char *pBuf, const char *pBody)
+{
+uint8_t	sum = 0;
+int	len, pos;
+const char *p;
+
+
+    for (p = pBody;  *p != '\0';  p++)
+	sum ^= (uint8_t)*p;
+    len = sprintf (pBuf, "$%s*%02X\r\n", pBody, sum);
+
+    if (randUniform() < l_ErrRate)
+    {
+	pos = 1 + (int)(randUniform() * (len - 3));
+	if (randUniform() < 0.5)
+	    pBuf[pos] ^= 0x01;				// corrupted
+	else
+	    memmove (pBuf + pos, pBuf + pos + 1, len-- - pos);	// lost
+    }
+
+    return len;
+}
+
+
+/******************************************************************************
+ * @brief  Uniform Random Number
+ *
+ * @return
+ *	Value in the range [0, 1).
+ *****************************************************************************/
+static double	randUniform (void)
+{
+    l_Rand ^= l_Rand << 13;
+    l_Rand ^= l_Rand >> 7;
+    l_Rand ^= l_Rand << 17;
+
+    return (double)(l_Rand >> 11) / 9007199254740992.0;
+}
+
+
+/******************************************************************************
+ * @brief  Run daily Synchronizations
+ *
+ * Each run starts one day after the previous one.  The stream is fed into
+ * the parser of the firmware, with the same fix sequence logic as in
+ * GNSS.c.  The PPS pulse of second <i>k</i> comes before its sentences.
+ *
+ * @return
+ *	0 if all synchronizations were correct, 1 otherwise.
+ *****************************************************************************/
+static int	testRuns (int runs)
+{
+NMEA_PARSER nmea;
+struct tm tmFw, tmHost;
+char	buf[SECOND_SIZE];
+uint32_t fixTime, lastFix;
+double	sumGnss = 0.0, sumDcf = 0.0, t;
+long	utc, maxGnss = 0, maxDcf = 0;
+uint32_t sentences = 0, errors = 0;
+int	run, k, n, len, seqCnt, valid, synced = 0, wrong = 0;
+bool	flgFixNew;
+
+
+    for (run = 0;  run < runs;  run++)
+    {
+	NmeaInit (&nmea);
+	lastFix = 0;
+	seqCnt = 0;
+	flgFixNew = false;
+	utc = l_Start + run * 86400L;
+	n = 1 + (int)(randUniform() * l_ColdSecs);	// cold start time
+
+	for (k = 0;  k < GNSS_TIMEOUT;  k++)
+	{
+	    /* PPS pulse at the start of second k */
+	    if (flgFixNew  &&  seqCnt >= FIX_SEQ_CNT)
+	    {
+		NmeaLocalTime (lastFix + 1, &tmFw);
+		if (! hostLocalTime (utc + k, &tmHost)
+		||  lastFix + 1 != (uint32_t)(utc + k)
+		||  tmFw.tm_year != tmHost.tm_year % 100
+		||  tmFw.tm_mon  != tmHost.tm_mon
+		||  tmFw.tm_mday != tmHost.tm_mday
+		||  tmFw.tm_hour != tmHost.tm_hour
+		||  tmFw.tm_min  != tmHost.tm_min
+		||  tmFw.tm_sec  != tmHost.tm_sec
+		||  tmFw.tm_isdst != tmHost.tm_isdst)
+		{
+		    printf ("Run %d: wrong time 20%02d-%02d-%02d %02d:%02d:%02d"
+			    " (%s)\n", run, tmFw.tm_year, tmFw.tm_mon + 1,
+			    tmFw.tm_mday, tmFw.tm_hour, tmFw.tm_min,
+			    tmFw.tm_sec, tmFw.tm_isdst ? "MESZ" : "MEZ");
+		    wrong++;
+		}
+		break;
+	    }
+	    flgFixNew = false;
+
+	    /* Sentences of second k */
+	    len = genSecond (buf, utc + k, n - k, n);
+	    for (valid = 0;  valid < len;  valid++)
+	    {
+		if (NmeaParse (&nmea, buf[valid]) == NMEA_NONE)
+		    continue;
+
+		fixTime = NmeaSeconds (&nmea);
+		if (fixTime == lastFix  &&  seqCnt > 0)
+		    continue;
+		seqCnt = (fixTime == lastFix + 1 ? seqCnt + 1 : 1);
+		lastFix = fixTime;
+		flgFixNew = true;
+	    }
+	}
+
+	sentences += nmea.Sentences;
+	errors += nmea.Errors;
+	if (k < GNSS_TIMEOUT)
+	{
+	    synced++;
+	    sumGnss += k;
+	    if (maxGnss < k)
+		maxGnss = k;
+	}
+
+	/* DCF77: wait for the minute mark, then 2 consecutive valid frames */
+	t = randUniform() * 60.0;
+	for (seqCnt = 0;  seqCnt < 2;  )
+	{
+	    t += 60.0;
+	    seqCnt = (randUniform() < l_DcfErrRate ? 0 : seqCnt + 1);
+	}
+	sumDcf += t;
+	if (maxDcf < (long)t)
+	    maxDcf = (long)t;
+    }
+
+    printf ("Runs: %d, synced %d, timeout %d, wrong time %d\n",
+	    runs, synced, runs - synced, wrong);
+    printf ("Parser: %u sentences, %u errors\n", sentences, errors);
+    if (synced > 0)
+	printf ("GNSS:  sync after %6.1fs avg %4lds max, %7.1fmAs/sync"
+		" (%duA, cold start 1..%ds)\n", sumGnss / synced, maxGnss,
+		sumGnss / synced * GNSS_CURRENT / 1000.0, GNSS_CURRENT,
+		l_ColdSecs);
+    if (runs > 0)
+	printf ("DCF77: sync after %6.1fs avg %4lds max, %7.1fmAs/sync"
+		" (%duA, frame loss %.2f)\n", sumDcf / runs, maxDcf,
+		sumDcf / runs * DCF77_CURRENT / 1000.0, DCF77_CURRENT,
+		l_DcfErrRate);
+
+    return (wrong > 0  ||  synced < runs);
+}
+
+
+/******************************************************************************
+ * @brief  Check NmeaLocalTime() from 2000 to 2099
+ *
+ * @return
+ *	0 if all conversions were correct, 1 otherwise.
+ *****************************************************************************/
+static int	testLocalTime (void)
+{
+struct tm tmFw, tmHost;
+long	utc, end = (long)(4102444800L - EPOCH_2000);	// 2100-01-01
+int	errors = 0;
+
+
+    for (utc = 0;  utc < end;  utc += 3599)	// all minutes and hours
+    {
+	NmeaLocalTime ((uint32_t)utc, &tmFw);
+	if (! hostLocalTime (utc, &tmHost))
+	    break;
+	if (tmFw.tm_year != tmHost.tm_year % 100
+	||  tmFw.tm_mon  != tmHost.tm_mon   ||  tmFw.tm_mday != tmHost.tm_mday
+	||  tmFw.tm_hour != tmHost.tm_hour  ||  tmFw.tm_min  != tmHost.tm_min
+	||  tmFw.tm_sec  != tmHost.tm_sec   ||  tmFw.tm_wday != tmHost.tm_wday
+	||  tmFw.tm_yday != tmHost.tm_yday  ||  tmFw.tm_isdst != tmHost.tm_isdst)
+	{
+	    if (errors++ < 10)
+		printf ("NmeaLocalTime: wrong result for %ld\n", utc);
+	}
+    }
+
+    printf ("NmeaLocalTime: %s, checked until %ld\n",
+	    errors ? "FAILED" : "OK", utc);
+    return (errors > 0);
+}
+
+
+/******************************************************************************
+ * @brief  Local Time by the C Library
+ *
+ * @return
+ *	<b>false</b> if the time zone database is not available.
+ *****************************************************************************/
+static bool	hostLocalTime (long utc, struct tm *pTm)
+{
+static bool flgInit;
+time_t	t = (time_t)(utc + EPOCH_2000);
+
+
+    if (! flgInit)
+    {
+	setenv ("TZ", "Europe/Berlin", 1);
+	tzset();
+	flgInit = true;
+    }
+    localtime_r (&t, pTm);
+
+    /* Without the database, the C library uses UTC */
+    return (strcmp (pTm->tm_zone, "UTC") != 0);
+}
+
+
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: NmeaGen [-s <YYYYMMDDhhmmss>] [-n <seconds>]"
+	     " [-c <cold_s>] [-e <err_rate>] [-r <seed>] [-R] [-o <file|tty>]\n"
+	     "       NmeaGen -t [-s <YYYYMMDDhhmmss>] [-k <runs>] [-c <cold_s>]"
+	     " [-e <err_rate>] [-p <dcf_err_rate>] [-r <seed>]\n");
+    exit (1);
+}
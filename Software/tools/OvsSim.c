@@ -0,0 +1,669 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Adaptive Oversampling Simulator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool measures the time per update of the power output
+ * measurements, and the time the ADC is on, by replaying the voltages and
+ * currents that have been recorded in a log file.  The windows of the
+ * channels are determined by the firmware's own policy, see AdcOvs.c.
+ *
+ * Usage:
+ * @code
+ * OvsSim [-d <ms>] [-l <min,max>] [-c <LSB>] [-n <noiseU,noiseI>]
+ *	  [-s <mV,mA>] [-v] <BOXnnnn.TXT>
+ * @endcode
+ *
+ * The signal of a power output is the last logged value of "UA1" resp.
+ * "UA2", while the output is enabled, and 0 otherwise.  The ADC runs while
+ * UA1 or UA2 is enabled, and scans all four channels like the firmware:
+ * I1, I2, U1, U2.  Since the log only records changes of the mean, the
+ * noise of the single measurements is modelled as white Gaussian noise, its
+ * standard deviation is given by option <b>-n</b> in [LSB] of the 12bit
+ * converter (default 0.5 for U, and 2 for I).  Option <b>-s</b> sets the
+ * full scale of the converter in [mV] and [mA] (default 15000 and 1500).
+ *
+ * Every block of @ref ADC_OVS_BLOCK measurements takes 1/8 of the scan
+ * duration (option <b>-d</b>, default 1000ms).  A round starts four scan
+ * durations after the previous one, or immediately when the previous round
+ * took longer.  After a pause, the firmware restarts the ADC with the next
+ * pass of the main loop, which is modelled as the worst case: the next
+ * second interrupt of the RTC.  The
+ * recorded signal is replayed twice with the same noise: once with fixed
+ * windows of 2048 measurements, and once with the windows of AdcOvsAdd(),
+ * with the limits of option <b>-l</b> (default 512,4096), and the
+ * confidence bound of option <b>-c</b> in [LSB] of the 16bit value (default
+ * 1).  The tool reports the mean conversion time per full U/I update, the
+ * part of the measuring time the ADC is on, the mean number of measurements
+ * per channel, and the error of the reported values in [LSB] of the 16bit
+ * value.  The error is taken against the expected output of the converter
+ * for the recorded signal, so the quantization and the clipping at 0 are
+ * not counted, only the noise that is left after averaging.  Option <b>-v</b>
+ * prints the measurements per channel of every adaptive round.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent The next round starts with the RTC second tick after the
+		pause, like the restart by Control().
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "LogParse.h"
+#include "AdcOvs.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Number of ADC channels, in the order of the scan. */
+#define NUM_CHAN	4
+
+    /*!@brief Number of blocks of a fixed window of 2048 measurements. */
+#define FIXED_BLOCKS	8
+
+    /*!@brief Same value as MIN_ADC_PAUSE of the firmware, in [s]. */
+#define MIN_PAUSE	0.002
+
+    /*!@brief Resolution of the error histogram in [LSB], and its size. */
+#define ERR_RES		0.1
+#define ERR_BINS	10000
+
+/*!@brief Power output and signal of a channel */
+typedef struct
+{
+    int		Out;		//!< LP_OUT_UA1 or LP_OUT_UA2
+    bool	flgCurrent;	//!< Channel measures the current
+    const char *Name;		//!< Name for the verbose output
+} CHAN_DEF;
+
+/*!@brief One log entry of the power outputs */
+typedef struct
+{
+    double	Sec;		//!< Time since the first entry in [s]
+    uint8_t	Kind;		//!< LP_OUT_ON, LP_OUT_OFF, LP_ALL_OFF, or
+				//!< LP_MEASURE
+    int		Out;		//!< Power output
+    int32_t	mV, mA;		//!< Values of LP_MEASURE
+} EVENT;
+
+/*!@brief Error statistics of the voltage or the current channels */
+typedef struct
+{
+    double	SumSq;		//!< Sum of the squared errors
+    uint32_t	Cnt;		//!< Number of values
+    uint32_t	Hist[ERR_BINS];	//!< Histogram of the absolute errors
+} ERRORS;
+
+/*!@brief Result of a simulation */
+typedef struct
+{
+    uint32_t	Updates;	//!< Number of full U/I updates
+    double	ConvSec;	//!< Time the ADC is on in [s]
+    double	UpdSec;		//!< Conversion time of the updates in [s]
+    double	Samples[2];	//!< Measurements of the U and I channels
+    ERRORS	Err[2];		//!< Errors of the U and I channels
+} RESULT;
+
+/*================================ Local Data ================================*/
+
+    /* Channels in the order of the scan, see l_MeasureDef in Control.c */
+static const CHAN_DEF l_Chan[NUM_CHAN] =
+{
+    { LP_OUT_UA1, true,  "I1" },	// channel 0
+    { LP_OUT_UA2, true,  "I2" },	// channel 3
+    { LP_OUT_UA1, false, "U1" },	// channel 6
+    { LP_OUT_UA2, false, "U2" },	// channel 7
+};
+
+    /* Limits and confidence bound of the adaptive windows */
+static ADC_OVS_CFG l_Cfg = { 512, 4096, 1 };
+
+    /* Scan duration [ms], noise [LSB], and full scale [mV], [mA] */
+static double	l_ScanMs = 1000.0;
+static double	l_Noise[2] = { 0.5, 2.0 };
+static double	l_FullScale[2] = { 15000.0, 1500.0 };
+
+    /* Verbose output */
+static bool	l_flgVerbose;
+
+    /* Recorded power output entries */
+static EVENT	*l_pEvent;
+static int	l_NumEvent;
+static int	l_MaxEvent;
+
+    /* Replay state: next entry, output states, and measuring time */
+static int	l_Next;
+static bool	l_flgOn[2];
+static double	l_Level[2][2];		// [output][I?] in [LSB] of 12bit
+static double	l_LastSec;
+static double	l_MeasSec;
+
+    /* Random number generator of the noise */
+static uint64_t	l_Rand;
+static bool	l_flgGauss;
+static double	l_Gauss;
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	readLog (const char *path);
+static void	addEvent (const EVENT *pEvent);
+static void	replayTo (double sec);
+static uint32_t	block (double level, double noise);
+static double	expected (double level, double noise);
+static double	gauss (void);
+static void	simulate (const ADC_OVS_CFG *pCfg, RESULT *pResult);
+static void	addError (ERRORS *pErr, double err);
+static double	percentile (const ERRORS *pErr, double p);
+static void	printResult (const char *name, const ADC_OVS_CFG *pCfg,
+			     const RESULT *pResult);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+static RESULT fixed, adaptive;
+ADC_OVS_CFG fixedCfg = { FIXED_BLOCKS * ADC_OVS_BLOCK,
+			 FIXED_BLOCKS * ADC_OVS_BLOCK, 0 };
+int	 i;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (i + 1 >= argc)
+	    usage();
+	else if (strcmp (argv[i], "-d") == 0)
+	    l_ScanMs = atof (argv[++i]);
+	else if (strcmp (argv[i], "-l") == 0)
+	{
+	    if (sscanf (argv[++i], "%u,%u", &l_Cfg.MinSamples,
+			&l_Cfg.MaxSamples) != 2)
+		usage();
+	}
+	else if (strcmp (argv[i], "-c") == 0)
+	    l_Cfg.Bound = (uint32_t)atoi (argv[++i]);
+	else if (strcmp (argv[i], "-n") == 0)
+	{
+	    if (sscanf (argv[++i], "%lf,%lf", &l_Noise[0], &l_Noise[1]) != 2)
+		usage();
+	}
+	else if (strcmp (argv[i], "-s") == 0)
+	{
+	    if (sscanf (argv[++i], "%lf,%lf", &l_FullScale[0],
+			&l_FullScale[1]) != 2)
+		usage();
+	}
+	else
+	    usage();
+    }
+
+    if (i != argc - 1  ||  l_ScanMs <= 0.0  ||  l_FullScale[0] <= 0.0
+    ||  l_FullScale[1] <= 0.0  ||  l_Cfg.MaxSamples < l_Cfg.MinSamples)
+	usage();
+
+    if (! readLog (argv[i]))
+	return 1;
+
+    simulate (&fixedCfg, &fixed);
+    simulate (&l_Cfg, &adaptive);
+
+    if (l_MeasSec <= 0.0  ||  fixed.Updates == 0)
+    {
+	fprintf (stderr, "%s: UA1 and UA2 are never measured\n", argv[i]);
+	return 1;
+    }
+
+    printf ("Measuring time: %.2f h, scan duration %.0f ms, noise %.2f/%.2f"
+	    " LSB (U/I), full scale %.0f mV/%.0f mA\n\n", l_MeasSec / 3600.0,
+	    l_ScanMs, l_Noise[0], l_Noise[1], l_FullScale[0], l_FullScale[1]);
+    printf ("               Updates   Time/update  ADC on  Samples/chan"
+	    "   U error [LSB]   I error [LSB]\n");
+    printf ("                               [s]      [%%]      U     I"
+	    "      rms   p95       rms   p95\n");
+    printResult ("Fixed", &fixedCfg, &fixed);
+    printResult ("Adaptive", &l_Cfg, &adaptive);
+    printf ("\nTime per update %+.1f%%, ADC on-time %+.1f%%, updates %+.1f%%\n",
+	    100.0 * (adaptive.UpdSec / adaptive.Updates)
+		  / (fixed.UpdSec / fixed.Updates) - 100.0,
+	    100.0 * adaptive.ConvSec / fixed.ConvSec - 100.0,
+	    100.0 * adaptive.Updates / fixed.Updates - 100.0);
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read the Power Output Entries of a Log File
+ *
+ ******************************************************************************/
+static bool	readLog (const char *path)
+{
+char	 line[LOG_LINE_MAX_SIZE];
+double	 first = -1.0, sec;
+LP_ENTRY entry;
+EVENT	 ev;
+FILE	*fp;
+
+
+    fp = fopen (path, "r");
+    if (fp == NULL)
+    {
+	perror (path);
+	return false;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	if (! LogParseLine (line, &entry)  ||  entry.Date == 0)
+	    continue;
+
+	if (entry.Kind != LP_OUT_ON  &&  entry.Kind != LP_OUT_OFF
+	&&  entry.Kind != LP_ALL_OFF  &&  entry.Kind != LP_MEASURE)
+	    continue;
+
+	if (entry.Kind != LP_ALL_OFF  &&  entry.A > LP_OUT_UA2)
+	    continue;
+
+	sec = (double)LogParseDayNumber (entry.Date) * 86400.0
+	    + entry.MilliSec / 1000.0;
+	if (first < 0.0)
+	    first = sec;
+
+	ev.Sec  = sec - first;
+	ev.Kind = entry.Kind;
+	ev.Out  = (int)entry.A;
+	ev.mV   = entry.B;
+	ev.mA   = entry.C;
+	addEvent (&ev);
+    }
+
+    fclose (fp);
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Replay the Log up to a Time
+ *
+ * Applies all entries up to <i>sec</i> to the output states and levels, and
+ * adds the time UA1 or UA2 has been enabled to the measuring time.
+ *
+ ******************************************************************************/
+static void	replayTo (double sec)
+{
+const EVENT *pEv;
+int	 n;
+
+
+    while (l_Next < l_NumEvent  &&  l_pEvent[l_Next].Sec <= sec)
+    {
+	pEv = &l_pEvent[l_Next++];
+
+	if (l_flgOn[0]  ||  l_flgOn[1])
+	    l_MeasSec += pEv->Sec - l_LastSec;
+	l_LastSec = pEv->Sec;
+
+	switch (pEv->Kind)
+	{
+	    case LP_OUT_ON:
+		l_flgOn[pEv->Out] = true;
+		break;
+
+	    case LP_OUT_OFF:
+		l_flgOn[pEv->Out] = false;
+		break;
+
+	    case LP_ALL_OFF:
+		l_flgOn[0] = l_flgOn[1] = false;
+		break;
+
+	    case LP_MEASURE:
+		l_Level[pEv->Out][0] = pEv->mV * 4096.0 / l_FullScale[0];
+		l_Level[pEv->Out][1] = pEv->mA * 4096.0 / l_FullScale[1];
+		break;
+	}
+
+	/* The measuring facility of a disabled output reads 0 */
+	for (n = 0;  n < 2;  n++)
+	    if (! l_flgOn[n])
+		l_Level[n][0] = l_Level[n][1] = 0.0;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Simulate the ADC Rounds
+ *
+ * Replays the whole log with the given windows.  A round that is still
+ * running when both outputs are disabled is counted as ADC on-time, but not
+ * as an update.
+ *
+ ******************************************************************************/
+static void	simulate (const ADC_OVS_CFG *pCfg, RESULT *pResult)
+{
+ADC_OVS_WIN win[NUM_CHAN];
+double	 level[NUM_CHAN], truth[NUM_CHAN];
+double	 blockSec, period, t, start;
+uint32_t done, mean;
+bool	 flgAbort;
+int	 c, type;
+
+
+    memset (pResult, 0, sizeof(*pResult));
+    l_Next = 0;
+    l_flgOn[0] = l_flgOn[1] = false;
+    memset (l_Level, 0, sizeof(l_Level));
+    l_LastSec = l_MeasSec = 0.0;
+    l_Rand = 0x9E3779B97F4A7C15ULL;	// the same noise for every run
+    l_flgGauss = false;
+
+    blockSec = l_ScanMs / 1000.0 / FIXED_BLOCKS;
+    period = NUM_CHAN * l_ScanMs / 1000.0;
+    t = 0.0;
+
+    while (l_Next < l_NumEvent)
+    {
+	replayTo (t);
+	if (! l_flgOn[0]  &&  ! l_flgOn[1])
+	{
+	    if (l_Next >= l_NumEvent)
+		break;
+	    t = l_pEvent[l_Next].Sec;	// ADC is off until the next entry
+	    continue;
+	}
+
+	/* One round of all channels */
+	start = t;
+	done = 0;
+	flgAbort = false;
+	for (c = 0;  c < NUM_CHAN;  c++)
+	{
+	    AdcOvsStart (&win[c]);
+	    truth[c] = 0.0;
+	}
+
+	while (done != (1 << NUM_CHAN) - 1  &&  ! flgAbort)
+	{
+	    for (c = 0;  c < NUM_CHAN;  c++)
+	    {
+		if (done & (1 << c))
+		    continue;
+
+		replayTo (t);
+		if (! l_flgOn[0]  &&  ! l_flgOn[1])
+		{
+		    flgAbort = true;
+		    break;
+		}
+
+		type = l_Chan[c].flgCurrent;
+		level[c] = l_Level[l_Chan[c].Out][type];
+		truth[c] += expected (level[c], l_Noise[type]);
+		t += blockSec;
+
+		if (AdcOvsAdd (pCfg, &win[c], block (level[c], l_Noise[type])))
+		    done |= (1 << c);
+	    }
+	}
+
+	pResult->ConvSec += t - start;
+
+	if (! flgAbort)
+	{
+	    pResult->Updates++;
+	    pResult->UpdSec += t - start;
+
+	    for (c = 0;  c < NUM_CHAN;  c++)
+	    {
+		type = l_Chan[c].flgCurrent;
+		pResult->Samples[type] += win[c].Blocks * ADC_OVS_BLOCK / 2.0;
+
+		/* Only enabled outputs are reported */
+		if (! l_flgOn[l_Chan[c].Out])
+		    continue;
+
+		mean = AdcOvsMean (&win[c]);
+		addError (&pResult->Err[type], mean - truth[c] / win[c].Blocks);
+	    }
+
+	    if (l_flgVerbose  &&  pCfg == &l_Cfg)
+	    {
+		printf ("%10.1f", start);
+		for (c = 0;  c < NUM_CHAN;  c++)
+		    printf (" %s %4u", l_Chan[c].Name,
+			    win[c].Blocks * ADC_OVS_BLOCK);
+		printf ("\n");
+	    }
+	}
+
+	/*
+	 * The next round starts one period after this one.  After a pause,
+	 * the main loop runs with the next RTC interrupt of the 1s clock.
+	 */
+	if (t <= start + period - MIN_PAUSE)
+	    t = ceil (start + period);
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Convert one Block
+ *
+ * Sums up @ref ADC_OVS_BLOCK noisy 12bit measurements, and shifts the sum
+ * to 16bit like the oversampling of the ADC.
+ *
+ ******************************************************************************/
+static uint32_t	block (double level, double noise)
+{
+uint32_t sum = 0;
+double	 x;
+int	 i;
+
+
+    for (i = 0;  i < ADC_OVS_BLOCK;  i++)
+    {
+	x = floor (level + noise * gauss() + 0.5);
+	if (x < 0.0)
+	    x = 0.0;
+	else if (x > 4095.0)
+	    x = 4095.0;
+	sum += (uint32_t)x;
+    }
+
+    return sum >> 4;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Expected Value of a Block
+ *
+ * The expected value of a rounded and clipped 12bit measurement is the sum
+ * of the probabilities that it reaches 1, 2, ... 4095.  The shift of the
+ * block to 16bit truncates 15/32 LSB on average.  The last result is
+ * cached, because the levels only change with the log entries.
+ *
+ ******************************************************************************/
+static double	expected (double level, double noise)
+{
+static double lastLevel = -1.0, lastNoise = -1.0, lastValue;
+double	sum = 0.0;
+int	j, lo, hi;
+
+
+    if (level == lastLevel  &&  noise == lastNoise)
+	return lastValue;
+
+    if (noise <= 0.0)
+    {
+	sum = floor (level + 0.5);
+	sum = (sum < 0.0 ? 0.0 : sum > 4095.0 ? 4095.0 : sum);
+    }
+    else
+    {
+	lo = (int)floor (level - 10.0 * noise);
+	hi = (int)ceil  (level + 10.0 * noise);
+	lo = (lo < 1 ? 1 : lo);
+	hi = (hi > 4095 ? 4095 : hi);
+	sum = (lo - 1 > 4095 ? 4095 : lo - 1);
+	for (j = lo;  j <= hi;  j++)
+	    sum += 0.5 * erfc ((j - 0.5 - level) / (noise * M_SQRT2));
+    }
+
+    lastLevel = level;
+    lastNoise = noise;
+    lastValue = sum * 16.0 - 15.0 / 32.0;
+
+    return lastValue;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Gaussian Random Number
+ *
+ * Box-Muller transformation of a xorshift generator, so every run of the
+ * tool produces the same noise.
+ *
+ ******************************************************************************/
+static double	gauss (void)
+{
+double	u, v, r;
+
+
+    if (l_flgGauss)
+    {
+	l_flgGauss = false;
+	return l_Gauss;
+    }
+
+    do
+    {
+	l_Rand ^= l_Rand << 13;  l_Rand ^= l_Rand >> 7;  l_Rand ^= l_Rand << 17;
+	u = (l_Rand >> 11) * (1.0 / 9007199254740992.0);
+    } while (u <= 0.0);
+
+    l_Rand ^= l_Rand << 13;  l_Rand ^= l_Rand >> 7;  l_Rand ^= l_Rand << 17;
+    v = (l_Rand >> 11) * (1.0 / 9007199254740992.0);
+
+    r = sqrt (-2.0 * log (u));
+    l_Gauss = r * sin (2.0 * M_PI * v);
+    l_flgGauss = true;
+
+    return r * cos (2.0 * M_PI * v);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Add an Error to the Statistics
+ *
+ ******************************************************************************/
+static void	addError (ERRORS *pErr, double err)
+{
+int	bin;
+
+
+    pErr->SumSq += err * err;
+    pErr->Cnt++;
+
+    bin = (int)(fabs (err) / ERR_RES);
+    if (bin >= ERR_BINS)
+	bin = ERR_BINS - 1;
+    pErr->Hist[bin]++;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Percentile of the Absolute Errors
+ *
+ ******************************************************************************/
+static double	percentile (const ERRORS *pErr, double p)
+{
+uint32_t sum = 0;
+int	 bin;
+
+
+    for (bin = 0;  bin < ERR_BINS - 1;  bin++)
+    {
+	sum += pErr->Hist[bin];
+	if (sum >= p * pErr->Cnt)
+	    break;
+    }
+
+    return (bin + 1) * ERR_RES;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Print the Result of a Simulation
+ *
+ ******************************************************************************/
+static void	printResult (const char *name, const ADC_OVS_CFG *pCfg,
+			     const RESULT *pResult)
+{
+int	type;
+
+
+    printf ("%-8s %4u-%-4u %7u %9.3f %9.1f %6.0f %5.0f", name,
+	    pCfg->MinSamples, pCfg->MaxSamples, pResult->Updates,
+	    pResult->UpdSec / pResult->Updates,
+	    100.0 * pResult->ConvSec / l_MeasSec,
+	    pResult->Samples[0] / pResult->Updates,
+	    pResult->Samples[1] / pResult->Updates);
+
+    for (type = 0;  type < 2;  type++)
+    {
+	if (pResult->Err[type].Cnt == 0)
+	    printf ("         -     -");
+	else
+	    printf ("    %6.2f %5.1f",
+		    sqrt (pResult->Err[type].SumSq / pResult->Err[type].Cnt),
+		    percentile (&pResult->Err[type], 0.95));
+    }
+    printf ("\n");
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static void	addEvent (const EVENT *pEvent)
+{
+    if (l_NumEvent >= l_MaxEvent)
+    {
+	l_MaxEvent = (l_MaxEvent == 0 ? 256 : 2 * l_MaxEvent);
+	l_pEvent = realloc (l_pEvent, l_MaxEvent * sizeof(EVENT));
+	if (l_pEvent == NULL)
+	{
+	    fprintf (stderr, "Out of memory\n");
+	    exit (1);
+	}
+    }
+
+    l_pEvent[l_NumEvent++] = *pEvent;
+}
+
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: OvsSim [-d <ms>] [-l <min,max>] [-c <LSB>]"
+	     " [-n <noiseU,noiseI>]\n"
+	     "\t[-s <mV,mA>] [-v] <BOXnnnn.TXT>\n");
+    exit (1);
+}
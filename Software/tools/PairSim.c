@@ -0,0 +1,511 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Pair Sampling Simulator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool measures the accuracy of the power of a pulsed load, as it
+ * is determined by the firmware with and without the voltage/current pair
+ * sampling, see AdcPair.c and Control.c.
+ *
+ * Usage:
+ * @code
+ * PairSim [-p <profile>] [-t <seconds>] [-d <scan_ms>] [-r <rate_Hz>]
+ *	   [-R <mOhm>] [-n <noiseU,noiseI>] [-s <mV,mA>] [-v]
+ * @endcode
+ *
+ * A signal generator model drives the current of output UA1 in steps of
+ * 1us.  The output is fed by 12.6V through a source resistance of option
+ * <b>-R</b> (default 800mOhm), so its voltage drops during the current
+ * pulses.  The reference power is the mean of voltage times current of all
+ * steps.  The converter adds white Gaussian noise with the standard
+ * deviation of option <b>-n</b> in [LSB] (default 0.5 for U, and 2 for I),
+ * and quantizes to 12 bits of the full scale of option <b>-s</b> (default
+ * 15000mV and 1500mA, the current is clipped there).
+ *
+ * Profiles:
+ * - <b>ir</b> (default): IR illuminator, PWM of 197Hz with 30% duty cycle,
+ *   1.2A on, 50mA off.
+ * - <b>camera</b>: 450mA idle, encoder bursts of 1.2A for 40ms at 3Hz.
+ * - <b>rfid</b>: 60mA idle, field bursts of 800mA for 100ms every 500ms.
+ * - <b>pulse</b>: 100ms pulses of 1.4A every 1.7s over 80mA.
+ * - <b>const</b>: 500mA.
+ *
+ * Three results are compared with the reference:
+ * - <b>sequential U*I</b>: the adaptive oversampling with fixed windows of
+ *   2048 measurements, i.e. the scan of the firmware without pair sampling.
+ *   The channels I1, I2, U1, U2 are oversampled one after the other in
+ *   blocks of 256 measurements, each block takes 1/8 of the scan duration of
+ *   option <b>-d</b> (default 1000ms).  The power is the product of the mean
+ *   voltage and the mean current.
+ * - <b>pair mean U*I</b>: the pair sampling at the scan rate of option
+ *   <b>-r</b> (default 1000Hz), but the product of the mean voltage and the
+ *   mean current.  This shows the part of the error that only depends on
+ *   the covariance of U and I.
+ * - <b>pair sum(U*I)/n</b>: the pair sampling with PowerTrue(), the mean
+ *   of the products of each pair.  U1 is converted 2 conversions of 3.6us
+ *   after I1, like in the firmware.
+ *
+ * A round ends after four scan durations, the pair sampling ends it at the
+ * next full half of the DMA buffer.  The power of every round is integrated
+ * by the firmware's EnergyAdd() resp. EnergyAddPower().  Every method is
+ * compared over its own span, from 0 to the end of its last complete round.
+ * The tool prints the span, the mean power and the energy of each method
+ * with the reference of that span and their errors, and the largest error
+ * of a single round against the reference of the same time.
+ * Option <b>-v</b> prints the power of every round.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent The reference energy is printed per method, it was shown
+		for the whole run but compared over the span of each method.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "AdcPair.h"
+#include "Energy.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Open circuit voltage of the power output in [mV]. */
+#define SOURCE_MV	12600.0
+
+    /*!@brief Measurements per channel and scan duration, see Control.c. */
+#define SCAN_SAMPLES	2048
+
+    /*!@brief Measurements of an oversampled block. */
+#define BLOCK_SAMPLES	256
+
+    /*!@brief Number of ADC channels, in the order of the scan. */
+#define NUM_CHAN	4
+
+    /*!@brief Slots of I1 and U1 in the scan: I1, I2, U1, U2. */
+#define SLOT_I1		0
+#define SLOT_U1		2
+
+    /*!@brief Conversion time of the pair sampling in [us], 29 clocks at
+     * PAIR_ADC_CLOCK of Control.c. */
+#define PAIR_CONV_US	(29.0 / 8.0)
+
+    /*!@brief Same value as PAIR_BUF_SCANS of the firmware. */
+#define PAIR_BUF_SCANS	64
+
+    /*!@brief Load profiles. */
+typedef enum
+{
+    PROFILE_IR,
+    PROFILE_CAMERA,
+    PROFILE_RFID,
+    PROFILE_PULSE,
+    PROFILE_CONST,
+    NUM_PROFILES
+} PROFILE;
+
+    /*!@brief Methods to determine the power. */
+typedef enum
+{
+    METHOD_SEQ,
+    METHOD_PAIR_MEAN,
+    METHOD_PAIR_SUM,
+    NUM_METHODS
+} METHOD;
+
+    /*!@brief Result of a method. */
+typedef struct
+{
+    double	SumPower;	//!< Sum of the power of all rounds [uW]
+    double	SumRef;		//!< Sum of the reference of all rounds [uW]
+    double	WorstErr;	//!< Largest error of a round [%]
+    long	Rounds;		//!< Number of rounds
+    long	EndUs;		//!< End of the last round [us]
+    ENERGY	Energy;		//!< Energy counter of the firmware
+} RESULT;
+
+/*================================ Local Data ================================*/
+
+static const char *l_ProfileName[NUM_PROFILES] =
+{ "ir", "camera", "rfid", "pulse", "const" };
+
+static const char *l_MethodName[NUM_METHODS] =
+{ "sequential U*I", "pair mean U*I", "pair sum(U*I)/n" };
+
+    /* Options */
+static PROFILE	l_Profile = PROFILE_IR;
+static double	l_SourceOhm = 0.8;
+static double	l_NoiseU = 0.5, l_NoiseI = 2.0;
+static double	l_FullScaleMV = 15000.0, l_FullScaleMA = 1500.0;
+static bool	l_flgVerbose;
+
+    /* Calibration dividers of the firmware for the full scale */
+static uint32_t	l_mV_Divider, l_mA_Divider;
+
+    /* Random number generator state */
+static uint64_t	l_Rand = 88172645463325252ULL;
+
+static RESULT	l_Result[NUM_METHODS];
+
+/*=========================== Forward Declarations ===========================*/
+
+static double	loadCurrent (double us);
+static double	loadVoltage (double mA);
+static double	refPower (long startUs, long endUs);
+static uint32_t	convert (double value, double fullScale, double noise);
+static void	runSequential (long durationUs, long roundUs);
+static void	runPair (long durationUs, long roundUs, long rate);
+static void	roundDone (METHOD method, long startUs, long endUs,
+			   uint32_t power);
+static double	randGauss (void);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+long	 seconds = 60, scanMs = 1000, rate = 1000;
+long	 durationUs, roundUs;
+double	 ref, power, energy, refEnergy;
+RESULT	*pRes;
+int	 i;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	    l_flgVerbose = true;
+	else if (strcmp (argv[i], "-p") == 0  &&  i + 1 < argc)
+	{
+	    i++;
+	    for (l_Profile = 0;  l_Profile < NUM_PROFILES;  l_Profile++)
+		if (strcmp (argv[i], l_ProfileName[l_Profile]) == 0)
+		    break;
+	    if (l_Profile >= NUM_PROFILES)
+		usage();
+	}
+	else if (strcmp (argv[i], "-t") == 0  &&  i + 1 < argc)
+	    seconds = atol (argv[++i]);
+	else if (strcmp (argv[i], "-d") == 0  &&  i + 1 < argc)
+	    scanMs = atol (argv[++i]);
+	else if (strcmp (argv[i], "-r") == 0  &&  i + 1 < argc)
+	    rate = atol (argv[++i]);
+	else if (strcmp (argv[i], "-R") == 0  &&  i + 1 < argc)
+	    l_SourceOhm = atol (argv[++i]) / 1000.0;
+	else if (strcmp (argv[i], "-n") == 0  &&  i + 1 < argc)
+	{
+	    if (sscanf (argv[++i], "%lf,%lf", &l_NoiseU, &l_NoiseI) != 2)
+		usage();
+	}
+	else if (strcmp (argv[i], "-s") == 0  &&  i + 1 < argc)
+	{
+	    if (sscanf (argv[++i], "%lf,%lf", &l_FullScaleMV,
+			&l_FullScaleMA) != 2)
+		usage();
+	}
+	else
+	    usage();
+    }
+    if (i < argc  ||  seconds < 1  ||  seconds > 500  ||  scanMs < 52
+    ||  scanMs > 2200  ||  rate < 100  ||  rate > 2000  ||  l_SourceOhm < 0.0
+    ||  l_NoiseU < 0.0  ||  l_NoiseI < 0.0  ||  l_FullScaleMV < 1.0
+    ||  l_FullScaleMA < 1.0)
+	usage();
+
+    /* calibration like CalibrateVoltage() resp. CalibrateCurrent() */
+    l_mV_Divider = (uint32_t)(65536.0 * 65536.0 / l_FullScaleMV + 0.5);
+    l_mA_Divider = (uint32_t)(65536.0 * 65536.0 / l_FullScaleMA + 0.5);
+
+    durationUs = seconds * 1000000L;
+    roundUs = scanMs * 1000L * NUM_CHAN;
+
+    printf ("Profile %s, %lds, source %.0fmOhm, scan %ldms per channel,"
+	    " pair rate %ldHz\n", l_ProfileName[l_Profile], seconds,
+	    l_SourceOhm * 1000.0, scanMs, rate);
+
+    runSequential (durationUs, roundUs);
+    runPair (durationUs, roundUs, rate);
+
+    printf ("Method           Span[s]  Power[mW] Ref[mW]    Error"
+	    "  Energy[mWh] Ref[mWh]    Error  Worst round\n");
+
+    for (i = 0;  i < NUM_METHODS;  i++)
+    {
+	pRes = &l_Result[i];
+	if (pRes->Rounds == 0)
+	{
+	    printf ("%-16s  no complete round\n", l_MethodName[i]);
+	    continue;
+	}
+
+	/* both are compared over the rounds of the method */
+	power = pRes->SumPower / pRes->Rounds;
+	ref = pRes->SumRef / pRes->Rounds;
+	energy = pRes->Energy.Used + pRes->Energy.Rest / 1000.0;   // [mWs]
+	refEnergy = refPower (0, pRes->EndUs) * pRes->EndUs / 1e9;
+
+	printf ("%-16s %7.1f %10.1f %7.1f %+7.2f%% %12.3f %8.3f %+7.2f%%"
+		" %+11.2f%%\n", l_MethodName[i], pRes->EndUs / 1e6,
+		power / 1000.0, ref / 1000.0, (power - ref) * 100.0 / ref,
+		energy / 3600.0, refEnergy / 3600.0,
+		(energy - refEnergy) * 100.0 / refEnergy, pRes->WorstErr);
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * @brief  Sequential scan with fixed oversampling windows
+ *
+ * Every pass converts one block of each channel, a round consists of
+ * SCAN_SAMPLES / BLOCK_SAMPLES passes.
+ *****************************************************************************/
+static void	runSequential (long durationUs, long roundUs)
+{
+double	 convUs = (double)roundUs / NUM_CHAN / SCAN_SAMPLES;
+double	 t;
+uint32_t sumU, sumI, blockU, blockI, meanU, meanI, mV, mA;
+long	 start, pass, j;
+
+
+    for (start = 0;  start + roundUs <= durationUs;  start += roundUs)
+    {
+	sumU = sumI = 0;
+	for (pass = 0;  pass < SCAN_SAMPLES / BLOCK_SAMPLES;  pass++)
+	{
+	    /* oversampling: the 16bit block value is the sum shifted by 4 */
+	    blockU = blockI = 0;
+	    for (j = 0;  j < BLOCK_SAMPLES;  j++)
+	    {
+		t = start + ((pass * NUM_CHAN + SLOT_I1) * BLOCK_SAMPLES + j)
+			    * convUs;
+		blockI += convert (loadCurrent (t), l_FullScaleMA, l_NoiseI);
+
+		t = start + ((pass * NUM_CHAN + SLOT_U1) * BLOCK_SAMPLES + j)
+			    * convUs;
+		blockU += convert (loadVoltage (loadCurrent (t)),
+				   l_FullScaleMV, l_NoiseU);
+	    }
+	    sumU += blockU >> 4;
+	    sumI += blockI >> 4;
+	}
+
+	meanU = (sumU + pass / 2) / pass;
+	meanI = (sumI + pass / 2) / pass;
+
+	/* PowerVoltage() and PowerCurrent() */
+	mV = (meanU << 16) / l_mV_Divider;
+	mA = (meanI << 16) / l_mA_Divider;
+	roundDone (METHOD_SEQ, start, start + roundUs, mV * mA);
+    }
+}
+
+
+/******************************************************************************
+ * @brief  Pair sampling
+ *
+ * The round ends with the half of the DMA buffer that reaches the target
+ * number of scans, see ADC_PairDone().
+ *****************************************************************************/
+static void	runPair (long durationUs, long roundUs, long rate)
+{
+ADC_PAIR_ACC acc;
+uint32_t target = (uint32_t)(rate * (roundUs / 1000) / 1000);
+uint32_t u, i, mV, mA;
+long	 start = 0, scan = 0, end;
+double	 t;
+
+
+    AdcPairStart (&acc);
+
+    for (;;)
+    {
+	t = scan * 1e6 / rate;
+	if (t + PAIR_CONV_US * NUM_CHAN > durationUs)
+	    break;
+
+	i = convert (loadCurrent (t + SLOT_I1 * PAIR_CONV_US), l_FullScaleMA,
+		     l_NoiseI);
+	u = convert (loadVoltage (loadCurrent (t + SLOT_U1 * PAIR_CONV_US)),
+		     l_FullScaleMV, l_NoiseU);
+	AdcPairAdd (&acc, u, i);
+	scan++;
+
+	if (scan % PAIR_BUF_SCANS != 0  ||  acc.Count < target)
+	    continue;
+
+	end = (long)(scan * 1e6 / rate);
+
+	mV = (AdcPairMeanU (&acc) << 16) / l_mV_Divider;
+	mA = (AdcPairMeanI (&acc) << 16) / l_mA_Divider;
+	roundDone (METHOD_PAIR_MEAN, start, end, mV * mA);
+
+	roundDone (METHOD_PAIR_SUM, start, end,
+		   AdcPairPower (AdcPairMeanUI (&acc), l_mV_Divider,
+				 l_mA_Divider));
+
+	AdcPairStart (&acc);
+	start = end;
+    }
+}
+
+
+/******************************************************************************
+ * @brief  Record the power of a round
+ *****************************************************************************/
+static void	roundDone (METHOD method, long startUs, long endUs,
+			   uint32_t power)
+{
+RESULT	*pRes = &l_Result[method];
+double	 ref, err;
+
+
+    ref = refPower (startUs, endUs);
+    err = (power - ref) * 100.0 / ref;
+
+    if (pRes->Rounds == 0)
+	EnergyStart (&pRes->Energy);	// output on since 0
+
+    /* Control(): integrate the power of every new round */
+    EnergyAddPower (&pRes->Energy, power,
+		    (uint32_t)((endUs - pRes->EndUs) * (double)ENERGY_TICKS_PER_SEC
+			       / 1e6 + 0.5));
+
+    pRes->SumPower += power;
+    pRes->SumRef += ref;
+    if (fabs (err) > fabs (pRes->WorstErr))
+	pRes->WorstErr = err;
+    pRes->Rounds++;
+    pRes->EndUs = endUs;
+
+    if (l_flgVerbose)
+	printf ("%-16s %8.3fs-%8.3fs %10.1fmW, reference %10.1fmW %+7.2f%%\n",
+		l_MethodName[method], startUs / 1e6, endUs / 1e6,
+		power / 1000.0, ref / 1000.0, err);
+}
+
+
+/******************************************************************************
+ * @brief  Current of the load in [mA] at a time in [us]
+ *****************************************************************************/
+static double	loadCurrent (double us)
+{
+    switch (l_Profile)
+    {
+	case PROFILE_IR:
+	    return (fmod (us * 197.0, 1e6) < 0.3e6 ? 1200.0 : 50.0);
+
+	case PROFILE_CAMERA:
+	    return (fmod (us * 3.0, 1e6) < 0.12e6 ? 1200.0 : 450.0);
+
+	case PROFILE_RFID:
+	    return (fmod (us, 500000.0) < 100000.0 ? 800.0 : 60.0);
+
+	case PROFILE_PULSE:
+	    return (fmod (us, 1700000.0) < 100000.0 ? 1400.0 : 80.0);
+
+	default:
+	    return 500.0;
+    }
+}
+
+
+/******************************************************************************
+ * @brief  Voltage of the output in [mV] for a current in [mA]
+ *****************************************************************************/
+static double	loadVoltage (double mA)
+{
+    return SOURCE_MV - mA * l_SourceOhm;
+}
+
+
+/******************************************************************************
+ * @brief  Reference power in [uW] between two times in [us]
+ *****************************************************************************/
+static double	refPower (long startUs, long endUs)
+{
+double	sum = 0.0, mA;
+long	us;
+
+
+    if (endUs <= startUs)
+	return 0.0;
+
+    for (us = startUs;  us < endUs;  us++)
+    {
+	mA = loadCurrent (us + 0.5);
+	sum += loadVoltage (mA) * mA;
+    }
+
+    return sum / (endUs - startUs);
+}
+
+
+/******************************************************************************
+ * @brief  12bit conversion of a value with noise
+ *****************************************************************************/
+static uint32_t	convert (double value, double fullScale, double noise)
+{
+double	code = value * 4096.0 / fullScale + noise * randGauss();
+
+    if (code < 0.0)
+	return 0;
+    if (code > 4095.0)
+	return 4095;
+
+    return (uint32_t)(code + 0.5);
+}
+
+
+/******************************************************************************
+ * @brief  Gaussian random number with standard deviation 1
+ *****************************************************************************/
+static double	randGauss (void)
+{
+double	u1, u2;
+
+    /* xorshift64, Box-Muller transform */
+    do
+    {
+	l_Rand ^= l_Rand << 13;
+	l_Rand ^= l_Rand >> 7;
+	l_Rand ^= l_Rand << 17;
+	u1 = (double)(l_Rand >> 11) / (double)(1ULL << 53);
+    } while (u1 <= 0.0);
+
+    l_Rand ^= l_Rand << 13;
+    l_Rand ^= l_Rand >> 7;
+    l_Rand ^= l_Rand << 17;
+    u2 = (double)(l_Rand >> 11) / (double)(1ULL << 53);
+
+    return sqrt (-2.0 * log (u1)) * cos (2.0 * M_PI * u2);
+}
+
+
+/******************************************************************************
+ * @brief  Show usage and exit
+ *****************************************************************************/
+static void	usage (void)
+{
+    fprintf (stderr,
+	"Usage: PairSim [-p <profile>] [-t <seconds>] [-d <scan_ms>]"
+	" [-r <rate_Hz>]\n"
+	"               [-R <mOhm>] [-n <noiseU,noiseI>] [-s <mV,mA>] [-v]\n"
+	"  -p  load profile: ir (default), camera, rfid, pulse, const\n"
+	"  -t  simulated time, 1 to 500s (default 60)\n"
+	"  -d  ADC scan duration per channel, 52 to 2200ms (default 1000)\n"
+	"  -r  scan rate of the pair sampling, 100 to 2000Hz (default 1000)\n"
+	"  -R  source resistance of the output in [mOhm] (default 800)\n"
+	"  -n  noise of U and I in [LSB] of 12 bits (default 0.5,2)\n"
+	"  -s  full scale of U in [mV] and I in [mA] (default 15000,1500)\n"
+	"  -v  show the power of every round\n");
+    exit (1);
+}
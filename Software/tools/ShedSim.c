@@ -0,0 +1,707 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Load Shedding Simulator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool estimates how many days of survival the load shedding of
+ * the firmware gains, by replaying a battery curve that has been recorded
+ * in the field.  The tiers are determined by the firmware's own policy, see
+ * LoadShed.c.
+ *
+ * Usage:
+ * @code
+ * ShedSim [-s <soc1,soc2,soc3,soc4>] [-t <h1,h2,h3,h4>] [-y <soc%,runtime%>]
+ *	   [-r <UA1|UA2|BATT>] [-d <duty%>] [-f <pause_s>] [-e <mAs/flush>]
+ *	   [-b <BATT_mA>] [-c <full_mAh>] [-m <min_mAh>] [-v] <BOXnnnn.TXT>
+ * @endcode
+ *
+ * From the log file, the tool takes the intervals between battery reports
+ * ("Battery Remaining Capacity").  Since the gauge updates its capacity in
+ * steps, consecutive reports are merged until an interval spans at least
+ * @ref MIN_SPAN_H hours, intervals with a battery swap are skipped.  For
+ * every interval, it records
+ * the consumed capacity, and the part of it that is drawn by each power
+ * output.  For UA1 and UA2, this is the measured power integrated over the
+ * on-time, converted to a battery current with the last battery voltage.
+ * BATT is not measured, its current is given by option
+ * <b>-b</b> (default 0).  The number of log flushes is derived from the time
+ * stamps of the log entries, once with the normal pause of @ref FLUSH_PAUSE
+ * and once with the pause of tier 3, each flush costs <i>mAs/flush</i>.
+ * The rest of the consumption is the base load of the logger.
+ *
+ * The intervals are then replayed, cyclically if required, starting with a
+ * full battery until <i>min_mAh</i> is reached.  This is done once without
+ * and once with load shedding.  Every @ref CHECK_MIN minutes, the tier is
+ * determined from the state of charge and the runtime to empty.  The runtime
+ * is estimated like the gauge does, from the remaining capacity and the
+ * current of the last check interval.  In tier 1, the RFID output draws
+ * <i>duty</i> percent of its recorded charge,
+ * in tier 2 the other outputs draw nothing, tier 3 saves the difference of
+ * the log flushes, and in tier 4 the RFID output draws nothing as well.
+ *
+ * The RFID output is the one that is enabled after "RFID is powered ON" most
+ * often, or UA1 if there is none.  Option <b>-r</b> overrides this.
+ *
+ * The defaults of the thresholds are 40, 25, 15, and 8 percent state of
+ * charge, no runtime thresholds, and the hysteresis, duty cycle and flush
+ * pause defaults of the firmware.  The full capacity defaults to the highest
+ * battery report of the log.  Option <b>-v</b> prints the tier transitions
+ * of the simulation with load shedding.
+ *
+ * The saving of an interval cannot exceed its recorded consumption.  If the
+ * outputs and flushes of the whole curve draw more than the battery shows,
+ * the model does not fit the log, e.g. <b>-b</b> or <b>-e</b> is too high,
+ * and the tool aborts.  Single intervals where this happens are clamped and
+ * counted, the result is then an upper bound.  If the battery is not empty
+ * after @ref MAX_DAYS days, no number of days is reported.  The exit code is
+ * 0 for a valid result, 1 on errors, and 2 if the result is invalid.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent Over-consumption aborts, a simulation that does not reach
+		an empty battery is reported as invalid instead of MAX_DAYS.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LogParse.h"
+#include "LoadShed.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief Capacity increase in [mAh] that indicates a battery swap. */
+#define SWAP_STEP_MAH	1000
+
+    /*!@brief Minimum span of an interval in [h], see BatPlan. */
+#define MIN_SPAN_H	20.0
+
+    /*!@brief Default capacity in [mAh] at which a battery is regarded empty. */
+#define DEF_MIN_MAH	500
+
+    /*!@brief Interval of the tier check in [min], see SHED_CHECK_INTERVAL. */
+#define CHECK_MIN	10
+
+    /*!@brief Log flush timing of the firmware in [s], see Logging.h. */
+#define SAMPLE_TIMEOUT	5
+#define FLUSH_PAUSE	15
+#define SAMPLE_MAX_SIZE	1024
+
+    /*!@brief Default energy of a log flush in [mAs], i.e. SD-Card power-up,
+     * initialization and write. */
+#define DEF_FLUSH_MAS	30.0
+
+    /*!@brief Battery voltage in [mV] until the first report. */
+#define DEF_BATT_MV	12000
+
+    /*!@brief Maximum simulated time in [d]. */
+#define MAX_DAYS	3650
+
+/*!@brief One interval between two battery reports */
+typedef struct
+{
+    double	Hours;		//!< Duration in [h]
+    double	Used;		//!< Consumed capacity in [mAh]
+    double	Out[LP_NUM_OUT]; //!< Charge drawn by the outputs in [mAh]
+    double	Flush[2];	//!< Flushes with normal and tier 3 pause
+} INTERVAL;
+
+/*!@brief Log flush model, see flushEntry() */
+typedef struct
+{
+    double	Pause;		//!< Pause between two flushes in [s]
+    double	PauseEnd;	//!< Time when the pause is over
+    double	Deadline;	//!< Flush time of the sample timeout, or -1
+    bool	flgTrigger;	//!< Flush requested during the pause
+    int		Bytes;		//!< Bytes in the log buffer
+    uint32_t	Count;		//!< Number of flushes
+} FLUSH;
+
+/*!@brief Result of a simulation */
+typedef struct
+{
+    double	Days;		//!< Days until empty
+    bool	flgEmpty;	//!< Battery got empty within MAX_DAYS
+    double	TierDays[END_SHED_TIER]; //!< Days spent in each tier
+    int		Transitions;	//!< Number of tier transitions
+} RESULT;
+
+/*================================ Local Data ================================*/
+
+    /* Thresholds of the tiers */
+static SHED_CFG	l_Cfg =
+{
+    { 0, 40, 25, 15, 8 },	// SoC [%]
+    { 0,  0,  0,  0, 0 },	// RunTime [h]
+    5,				// SoC_Hyst [%]
+    25				// RunTimeHyst [%]
+};
+
+    /* Parameters of the tier actions */
+static int	l_RFID_Out = -1;
+static double	l_Duty = 50.0;
+static double	l_FlushPause = 300.0;
+static double	l_FlushMAs = DEF_FLUSH_MAS;
+static double	l_BattMA;
+
+    /* Capacity in [mAh] of a full battery and at which it is empty */
+static double	l_FullCapacity;
+static double	l_MinCapacity = DEF_MIN_MAH;
+
+    /* Verbose output */
+static bool	l_flgVerbose;
+
+    /* Intervals of the recorded battery curve */
+static INTERVAL	*l_pIntvl;
+static int	l_NumIntvl;
+static int	l_MaxIntvl;
+
+/*=========================== Forward Declarations ===========================*/
+
+static bool	readLog (const char *path);
+static void	addInterval (const INTERVAL *pIntvl);
+static void	flushEntry (FLUSH *pFlush, double sec, int len);
+static double	saving (const INTERVAL *pIntvl, SHED_TIER tier);
+static void	simulate (bool flgShed, RESULT *pResult);
+static bool	parseList (const char *str, uint32_t *pValue, int cnt);
+static void	usage (void);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+uint32_t hyst[2];
+double	 sumHours = 0.0, sumUsed = 0.0, sumOut[LP_NUM_OUT], sumFlush[2];
+double	 sumSave = 0.0, save;
+RESULT	 base, shed;
+int	 i, n, clamped = 0;
+
+
+    for (i = 1;  i < argc  &&  argv[i][0] == '-';  i++)
+    {
+	if (strcmp (argv[i], "-v") == 0)
+	{
+	    l_flgVerbose = true;
+	}
+	else if (i + 1 >= argc)
+	{
+	    usage();
+	}
+	else if (strcmp (argv[i], "-s") == 0)
+	{
+	    if (! parseList (argv[++i], &l_Cfg.SoC[1], END_SHED_TIER - 1))
+		usage();
+	}
+	else if (strcmp (argv[i], "-t") == 0)
+	{
+	    if (! parseList (argv[++i], &l_Cfg.RunTime[1], END_SHED_TIER - 1))
+		usage();
+	}
+	else if (strcmp (argv[i], "-y") == 0)
+	{
+	    if (! parseList (argv[++i], hyst, 2))
+		usage();
+	    l_Cfg.SoC_Hyst = hyst[0];
+	    l_Cfg.RunTimeHyst = hyst[1];
+	}
+	else if (strcmp (argv[i], "-r") == 0)
+	{
+	    i++;
+	    for (l_RFID_Out = 0;  l_RFID_Out < LP_NUM_OUT;  l_RFID_Out++)
+		if (strcmp (argv[i], LogParseOutputName (l_RFID_Out)) == 0)
+		    break;
+	    if (l_RFID_Out >= LP_NUM_OUT)
+		usage();
+	}
+	else if (strcmp (argv[i], "-d") == 0)
+	    l_Duty = atof (argv[++i]);
+	else if (strcmp (argv[i], "-f") == 0)
+	    l_FlushPause = atof (argv[++i]);
+	else if (strcmp (argv[i], "-e") == 0)
+	    l_FlushMAs = atof (argv[++i]);
+	else if (strcmp (argv[i], "-b") == 0)
+	    l_BattMA = atof (argv[++i]);
+	else if (strcmp (argv[i], "-c") == 0)
+	    l_FullCapacity = atof (argv[++i]);
+	else if (strcmp (argv[i], "-m") == 0)
+	    l_MinCapacity = atof (argv[++i]);
+	else
+	    usage();
+    }
+
+    if (i != argc - 1)
+	usage();
+
+    if (! readLog (argv[i]))
+	return 1;
+
+    /* The recorded consumption, split into its parts */
+    for (n = 0;  n < LP_NUM_OUT;  n++)
+	sumOut[n] = 0.0;
+    sumFlush[0] = sumFlush[1] = 0.0;
+    for (i = 0;  i < l_NumIntvl;  i++)
+    {
+	sumHours += l_pIntvl[i].Hours;
+	sumUsed  += l_pIntvl[i].Used;
+	for (n = 0;  n < LP_NUM_OUT;  n++)
+	    sumOut[n] += l_pIntvl[i].Out[n];
+	sumFlush[0] += l_pIntvl[i].Flush[0];
+	sumFlush[1] += l_pIntvl[i].Flush[1];
+
+	/* Saving of the highest tier, not limited to the consumption */
+	save = saving (&l_pIntvl[i], SHED_TIER_MINIMAL);
+	sumSave += save;
+	if (save > l_pIntvl[i].Used)
+	    clamped++;
+    }
+
+    if (sumHours < 24.0  ||  sumUsed <= 0.0)
+    {
+	fprintf (stderr, "%s: Battery curve is too short or shows no"
+		 " consumption\n", argv[argc - 1]);
+	return 1;
+    }
+
+    printf ("Battery curve: %d intervals, %.1f days, %.1f mAh/day,"
+	    " full %.0f mAh, empty at %.0f mAh\n", l_NumIntvl, sumHours / 24.0,
+	    sumUsed * 24.0 / sumHours, l_FullCapacity, l_MinCapacity);
+    for (n = 0;  n < LP_NUM_OUT;  n++)
+	printf ("  %-4s %s %8.1f mAh/day\n", LogParseOutputName (n),
+		n == l_RFID_Out ? "(RFID)" : "      ",
+		sumOut[n] * 24.0 / sumHours);
+    printf ("  Log flushes  %8.1f /day, %.1f /day with %.0fs pause\n",
+	    sumFlush[0] * 24.0 / sumHours, sumFlush[1] * 24.0 / sumHours,
+	    l_FlushPause);
+
+    if (sumSave > sumUsed)
+    {
+	fprintf (stderr, "%s: The outputs and flushes draw %.1f mAh/day, more"
+		 " than the battery curve shows, check -b and -e\n",
+		 argv[argc - 1], sumSave * 24.0 / sumHours);
+	return 1;
+    }
+    if (clamped > 0)
+	printf ("  Warning: %d of %d intervals draw more than the battery curve"
+		" shows, the result is an upper bound\n", clamped, l_NumIntvl);
+
+    printf ("Tiers: SoC");
+    for (n = SHED_TIER_NONE + 1;  n < END_SHED_TIER;  n++)
+	printf (" %u%%", l_Cfg.SoC[n]);
+    printf (", runtime");
+    for (n = SHED_TIER_NONE + 1;  n < END_SHED_TIER;  n++)
+	printf (" %uh", l_Cfg.RunTime[n]);
+    printf (", hysteresis %u%%/%u%%, RFID duty %.0f%%\n\n", l_Cfg.SoC_Hyst,
+	    l_Cfg.RunTimeHyst, l_Duty);
+
+    simulate (false, &base);
+    simulate (true, &shed);
+
+    if (base.flgEmpty)
+	printf ("Without load shedding: %7.1f days\n", base.Days);
+    else
+	printf ("Without load shedding: not empty after %d days\n", MAX_DAYS);
+    if (shed.flgEmpty)
+	printf ("With load shedding   : %7.1f days, %d transitions\n",
+		shed.Days, shed.Transitions);
+    else
+	printf ("With load shedding   : not empty after %d days, %d"
+		" transitions\n", MAX_DAYS, shed.Transitions);
+    for (n = 0;  n < END_SHED_TIER;  n++)
+	printf ("  Tier %d %-15s %7.1f days\n", n, LoadShedName (n),
+		shed.TierDays[n]);
+
+    if (! base.flgEmpty  ||  ! shed.flgEmpty)
+    {
+	printf ("Extra days of survival: invalid\n");
+	return 2;
+    }
+    printf ("Extra days of survival: %+.1f\n", shed.Days - base.Days);
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Read the Battery Curve
+ *
+ * Extracts the intervals between two battery reports from the log file.
+ * Intervals that contain a battery swap are skipped.  The charge of UA1 and
+ * UA2 is integrated from the last measured current while the output is on.
+ *
+ * @return
+ *	<i>true</i> if the file could be read.
+ *
+ ******************************************************************************/
+static bool	readLog (const char *path)
+{
+char	 line[LOG_LINE_MAX_SIZE];
+double	 onSince[LP_NUM_OUT], power[LP_NUM_OUT];
+double	 battMilliVolt = DEF_BATT_MV;
+double	 hours, prevHours = -1.0, prevCapacity = 0.0, sec;
+double	 maxCapacity = 0.0;
+uint32_t flushCnt[2], rfidCnt[LP_NUM_OUT];
+bool	 flgRFID_On = false;
+INTERVAL cur;
+FLUSH	 flush[2];
+LP_ENTRY entry;
+FILE	*fp;
+int	 out, k;
+
+
+    fp = fopen (path, "r");
+    if (fp == NULL)
+    {
+	perror (path);
+	return false;
+    }
+
+    memset (&cur, 0, sizeof(cur));
+    memset (flush, 0, sizeof(flush));
+    for (k = 0;  k < 2;  k++)
+    {
+	flush[k].Pause = (k == 0 ? FLUSH_PAUSE : l_FlushPause);
+	flush[k].Deadline = -1.0;
+	flushCnt[k] = 0;
+    }
+    for (out = 0;  out < LP_NUM_OUT;  out++)
+    {
+	onSince[out] = -1.0;
+	power[out] = 0.0;
+	rfidCnt[out] = 0;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL)
+    {
+	if (! LogParseLine (line, &entry)  ||  entry.Date == 0)
+	    continue;
+
+	hours = LogParseDayNumber (entry.Date) * 24.0
+		+ entry.MilliSec / 3600000.0;
+
+	/* Charge of the outputs that are on until now */
+	for (out = 0;  out < LP_NUM_OUT;  out++)
+	{
+	    if (onSince[out] >= 0.0)
+	    {
+		cur.Out[out] += (hours - onSince[out])
+				* (out == LP_OUT_BATT ? l_BattMA
+						      : power[out] / battMilliVolt);
+		onSince[out] = hours;
+	    }
+	}
+
+	/* Every log entry is flushed to the SD-Card */
+	sec = hours * 3600.0;
+	for (k = 0;  k < 2;  k++)
+	    flushEntry (&flush[k], sec, (int)strlen (line));
+
+	switch (entry.Kind)
+	{
+	    case LP_OTHER:
+		if (strstr (line, "RFID is powered ON") != NULL)
+		    flgRFID_On = true;
+		break;
+
+	    case LP_OUT_ON:
+		if (flgRFID_On)			// output of the RFID reader
+		    rfidCnt[entry.A]++;
+		flgRFID_On = false;
+		if (onSince[entry.A] < 0.0)
+		    onSince[entry.A] = hours;
+		power[entry.A] = 0.0;		// until measured
+		break;
+
+	    case LP_OUT_OFF:
+	    case LP_ALL_OFF:
+		for (out = 0;  out < LP_NUM_OUT;  out++)
+		    if (entry.Kind == LP_ALL_OFF  ||  (int)entry.A == out)
+			onSince[out] = -1.0;
+		break;
+
+	    case LP_MEASURE:
+		if (entry.A == LP_OUT_BATT  &&  entry.B > 0)
+		    battMilliVolt = entry.B;		// BATT_INP
+		else if (entry.A < LP_NUM_OUT)
+		    power[entry.A] = (double)entry.B * entry.C;	// [uW]
+		break;
+
+	    case LP_BAT_VOLTAGE:
+		if (entry.B > 0)
+		    battMilliVolt = entry.B;
+		break;
+
+	    case LP_BAT_CAPACITY:
+		if (entry.B > maxCapacity)
+		    maxCapacity = entry.B;
+
+		if (prevHours >= 0.0
+		&&  entry.B <= prevCapacity + SWAP_STEP_MAH)
+		{
+		    /* The gauge updates in steps, merge short intervals */
+		    if (hours - prevHours < MIN_SPAN_H)
+			break;
+
+		    cur.Hours = hours - prevHours;
+		    cur.Used = prevCapacity - entry.B;
+		    for (k = 0;  k < 2;  k++)
+			cur.Flush[k] = flush[k].Count - flushCnt[k];
+		    addInterval (&cur);
+		}
+
+		/* Start a new interval */
+		for (k = 0;  k < 2;  k++)
+		    flushCnt[k] = flush[k].Count;
+		prevHours = hours;
+		prevCapacity = entry.B;
+		memset (&cur, 0, sizeof(cur));
+		break;
+
+	    default:
+		break;
+	}
+    }
+
+    fclose (fp);
+
+    /* RFID output defaults to the one most often used by the reader */
+    if (l_RFID_Out < 0)
+    {
+	l_RFID_Out = LP_OUT_UA1;
+	for (out = 0;  out < LP_NUM_OUT;  out++)
+	    if (rfidCnt[out] > rfidCnt[l_RFID_Out])
+		l_RFID_Out = out;
+    }
+
+    /* Full capacity defaults to the highest battery report */
+    if (l_FullCapacity <= 0.0)
+	l_FullCapacity = maxCapacity;
+
+    return true;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Log Flush Model
+ *
+ * This routine models when the firmware flushes the log buffer, see
+ * LogFlushCheck() and logFlushCtrl().  A flush happens when no new entry
+ * has been logged for @ref SAMPLE_TIMEOUT seconds, but not before the pause
+ * after the previous flush is over, or immediately when the buffer holds
+ * more than @ref SAMPLE_MAX_SIZE bytes.
+ *
+ * @param[in] pFlush
+ *	State of the model.
+ *
+ * @param[in] sec
+ *	Time of the new log entry in [s].
+ *
+ * @param[in] len
+ *	Length of the new log entry.
+ *
+ ******************************************************************************/
+static void	flushEntry (FLUSH *pFlush, double sec, int len)
+{
+    /* Flushes that happened before this entry */
+    if (pFlush->flgTrigger  &&  pFlush->PauseEnd <= sec)
+    {
+	pFlush->Count++;
+	pFlush->PauseEnd += pFlush->Pause;
+	pFlush->flgTrigger = false;
+	pFlush->Bytes = 0;
+    }
+    if (pFlush->Deadline >= 0.0  &&  pFlush->Deadline <= sec)
+    {
+	pFlush->Count++;
+	pFlush->PauseEnd = pFlush->Deadline + pFlush->Pause;
+	pFlush->Deadline = -1.0;
+	pFlush->Bytes = 0;
+    }
+
+    /* The new entry */
+    pFlush->Bytes += len;
+    if (pFlush->Bytes > SAMPLE_MAX_SIZE)
+    {
+	pFlush->Count++;
+	pFlush->PauseEnd = sec + pFlush->Pause;
+	pFlush->Deadline = -1.0;
+	pFlush->flgTrigger = false;
+	pFlush->Bytes = 0;
+    }
+    else if (sec < pFlush->PauseEnd)
+    {
+	pFlush->flgTrigger = true;
+    }
+    else
+    {
+	pFlush->Deadline = sec + SAMPLE_TIMEOUT;
+    }
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Saving of a Tier
+ *
+ * @return
+ *	Capacity in [mAh] that is not consumed in the interval, if it had been
+ *	in the given tier all the time.  This may exceed the recorded
+ *	consumption if the model does not fit, see simulate().
+ *
+ ******************************************************************************/
+static double	saving (const INTERVAL *pIntvl, SHED_TIER tier)
+{
+double	 save = 0.0;
+int	 out;
+
+
+    if (tier >= SHED_TIER_RFID)
+	save += pIntvl->Out[l_RFID_Out] * (100.0 - l_Duty) / 100.0;
+
+    if (tier >= SHED_TIER_CAMERA)
+	for (out = 0;  out < LP_NUM_OUT;  out++)
+	    if (out != l_RFID_Out)
+		save += pIntvl->Out[out];
+
+    if (tier >= SHED_TIER_FLUSH)
+	save += (pIntvl->Flush[0] - pIntvl->Flush[1]) * l_FlushMAs / 3600.0;
+
+    if (tier >= SHED_TIER_MINIMAL)
+	save += pIntvl->Out[l_RFID_Out] * l_Duty / 100.0;
+
+    return save;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Simulate a Battery
+ *
+ * Replays the recorded intervals in steps of @ref CHECK_MIN minutes, from a
+ * full battery until it is empty, or for at most @ref MAX_DAYS days.  The
+ * consumption of an interval is spread evenly over its steps.  The saving is
+ * limited to the recorded consumption of the interval.
+ *
+ * @param[in] flgShed
+ *	<i>true</i> to simulate with load shedding.
+ *
+ * @param[out] pResult
+ *	Days until empty, and the time spent in each tier.
+ *
+ ******************************************************************************/
+static void	simulate (bool flgShed, RESULT *pResult)
+{
+const INTERVAL *pIntvl;
+SHED_TIER tier = SHED_TIER_NONE, newTier;
+double	 capacity = l_FullCapacity, step, used, hours = 0.0, rate = 0.0;
+double	 save;
+uint32_t soc, runTime;
+int	 i = 0, s, steps;
+
+
+    memset (pResult, 0, sizeof(*pResult));
+
+    while (capacity > l_MinCapacity  &&  hours < MAX_DAYS * 24.0)
+    {
+	pIntvl = &l_pIntvl[i];
+	i = (i + 1) % l_NumIntvl;
+
+	steps = (int)(pIntvl->Hours * 60.0 / CHECK_MIN + 0.5);
+	if (steps < 1)
+	    steps = 1;
+	step = pIntvl->Hours / steps;
+
+	for (s = 0;  s < steps  &&  capacity > l_MinCapacity;  s++)
+	{
+	    if (flgShed)
+	    {
+		soc = (uint32_t)(100.0 * capacity / l_FullCapacity + 0.5);
+		if (rate > 0.0  &&  capacity / rate * 60.0 < SHED_RUNTIME_INFINITE)
+		    runTime = (uint32_t)(capacity / rate * 60.0);
+		else
+		    runTime = SHED_RUNTIME_INFINITE;
+
+		newTier = LoadShedTier (&l_Cfg, tier, soc, runTime);
+		if (newTier != tier)
+		{
+		    if (l_flgVerbose)
+			printf ("Day %6.1f: Tier %d (%s) -> %d (%s), SoC %u%%,"
+				" runtime %uh\n", hours / 24.0, tier,
+				LoadShedName (tier), newTier,
+				LoadShedName (newTier), soc, runTime / 60);
+		    tier = newTier;
+		    pResult->Transitions++;
+		}
+	    }
+
+	    save = saving (pIntvl, tier);
+	    if (save > pIntvl->Used)
+		save = (pIntvl->Used > 0.0 ? pIntvl->Used : 0.0);
+	    used = (pIntvl->Used - save) / steps;
+	    capacity -= used;
+	    rate = used / step;
+	    hours += step;
+	    pResult->TierDays[tier] += step / 24.0;
+	}
+    }
+
+    pResult->Days = hours / 24.0;
+    pResult->flgEmpty = (capacity <= l_MinCapacity);
+    if (l_flgVerbose  &&  flgShed)
+	printf ("\n");
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static void	addInterval (const INTERVAL *pIntvl)
+{
+    if (l_NumIntvl >= l_MaxIntvl)
+    {
+	l_MaxIntvl = (l_MaxIntvl == 0 ? 256 : 2 * l_MaxIntvl);
+	l_pIntvl = realloc (l_pIntvl, l_MaxIntvl * sizeof(INTERVAL));
+	if (l_pIntvl == NULL)
+	{
+	    fprintf (stderr, "Out of memory\n");
+	    exit (1);
+	}
+    }
+
+    l_pIntvl[l_NumIntvl++] = *pIntvl;
+}
+
+    /* Parse a comma separated list of <cnt> numbers */
+static bool	parseList (const char *str, uint32_t *pValue, int cnt)
+{
+char	*pEnd;
+int	 i;
+
+    for (i = 0;  i < cnt;  i++)
+    {
+	pValue[i] = (uint32_t)strtoul (str, &pEnd, 10);
+	if (pEnd == str  ||  (*pEnd != (i < cnt - 1 ? ',' : EOS)))
+	    return false;
+	str = pEnd + 1;
+    }
+    return true;
+}
+
+static void	usage (void)
+{
+    fprintf (stderr, "Usage: ShedSim [-s <soc1,soc2,soc3,soc4>]"
+	     " [-t <h1,h2,h3,h4>] [-y <soc%%,runtime%%>]\n"
+	     "\t[-r <UA1|UA2|BATT>] [-d <duty%%>] [-f <pause_s>]"
+	     " [-e <mAs/flush>]\n"
+	     "\t[-b <BATT_mA>] [-c <full_mAh>] [-m <min_mAh>] [-v]"
+	     " <BOXnnnn.TXT>\n");
+    exit (1);
+}
@@ -0,0 +1,245 @@
+/***************************************************************************//**
+ * @file
+ * @brief	Synthetic Log Generator
+ * @author	agent
+ * @version	2026-10-19
+ *
+ * This host tool generates synthetic TAMDL log files in the same format as
+ * the firmware does.  They are used to benchmark the host tools on data sets
+ * of realistic size, e.g. 10 seasons with 200 boxes each.
+ *
+ * Usage:
+ * @code
+ * SynthLog [-b <boxes>] [-s <seasons>] [-d <days>] [-m <measure_s>] <outdir>
+ * @endcode
+ *
+ * For every season a directory <b><outdir>/<year></b> is created, containing
+ * one file <b>BOX<i>nnnn</i>.TXT</b> per box.  Each day consists of a DCF77
+ * synchronization, two battery reports, the power output on and off times
+ * with U/I measurements every <i>measure_s</i> seconds in between, and a
+ * random number of transponder visits.  The output is deterministic.
+ *
+ ****************************************************************************//*
+Revision History:
+2026-10-19,agent The daily consumption overflowed 32 bits for loads above
+		42mA, so the battery curve was far too flat.
+2026-10-19,agent Initial version.
+*/
+
+/*=============================== Header Files ===============================*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "LogParse.h"
+
+/*=============================== Definitions ================================*/
+
+    /*!@brief First year of the generated seasons. */
+#define FIRST_SEASON	2015
+
+    /*!@brief First day of a season (April 1st). */
+#define SEASON_START	401
+
+    /*!@brief Number of transponders per box. */
+#define TAGS_PER_BOX	4
+
+/*!@brief State of one synthetic box */
+typedef struct
+{
+    FILE       *Fp;		//!< Log file
+    uint32_t	Date;		//!< Current date YYYYMMDD
+    int32_t	Capacity;	//!< Remaining battery capacity in [mAh]
+    int32_t	LoadmA;		//!< Load current of UA2 in [mA]
+} BOX;
+
+/*================================ Local Data ================================*/
+
+    /* Random number generator state */
+static uint64_t	l_Rand = 0x2545F4914F6CDD1DULL;
+
+/*=========================== Forward Declarations ===========================*/
+
+static uint32_t	rnd (uint32_t range);
+static void	logLine (BOX *pBox, uint32_t ms, const char *frmt, ...);
+static void	genDay (BOX *pBox, int boxNum, int measureSec);
+
+
+/******************************************************************************
+ * @brief  Main function
+ *****************************************************************************/
+int	main (int argc, char **argv)
+{
+int	 boxes = 200, seasons = 10, days = 120, measureSec = 600;
+char	 path[512];
+BOX	 box;
+int	 i, s, b, d;
+const char *outdir;
+
+
+    for (i = 1;  i < argc - 1;  i += 2)
+    {
+	if (strcmp (argv[i], "-b") == 0)
+	    boxes = atoi (argv[i + 1]);
+	else if (strcmp (argv[i], "-s") == 0)
+	    seasons = atoi (argv[i + 1]);
+	else if (strcmp (argv[i], "-d") == 0)
+	    days = atoi (argv[i + 1]);
+	else if (strcmp (argv[i], "-m") == 0)
+	    measureSec = atoi (argv[i + 1]);
+	else
+	    break;
+    }
+
+    if (i != argc - 1  ||  boxes <= 0  ||  seasons <= 0  ||  days <= 0
+    ||  measureSec <= 0)
+    {
+	fprintf (stderr, "Usage: SynthLog [-b <boxes>] [-s <seasons>]"
+		 " [-d <days>] [-m <measure_s>] <outdir>\n");
+	return 1;
+    }
+    outdir = argv[i];
+    mkdir (outdir, 0755);
+
+    for (s = 0;  s < seasons;  s++)
+    {
+	snprintf (path, sizeof(path), "%s/%d", outdir, FIRST_SEASON + s);
+	if (mkdir (path, 0755) != 0  &&  errno != EEXIST)
+	{
+	    perror (path);
+	    return 1;
+	}
+
+	for (b = 0;  b < boxes;  b++)
+	{
+	    snprintf (path, sizeof(path), "%s/%d/BOX%04d.TXT",
+		      outdir, FIRST_SEASON + s, b + 1);
+	    box.Fp = fopen (path, "w");
+	    if (box.Fp == NULL)
+	    {
+		perror (path);
+		return 1;
+	    }
+	    box.Date = (FIRST_SEASON + s) * 10000 + SEASON_START;
+	    box.Capacity = 5000 + rnd (2500);
+	    box.LoadmA = 20 + rnd (200);
+
+	    for (d = 0;  d < days;  d++)
+	    {
+		genDay (&box, b + 1, measureSec);
+		box.Date = LogParseDayToDate (LogParseDayNumber (box.Date) + 1);
+	    }
+	    fclose (box.Fp);
+	}
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Generate one Day
+ *
+ ******************************************************************************/
+static void	genDay (BOX *pBox, int boxNum, int measureSec)
+{
+uint32_t onMs = (6 * 3600 + rnd (1800)) * 1000;
+uint32_t offMs = (20 * 3600 + rnd (1800)) * 1000;
+uint32_t visitMs[64];
+int	 visits, v, i, h;
+uint32_t ms;
+
+
+    logLine (pBox, (1 * 3600 + 55 * 60 + 40) * 1000 + rnd (1000),
+	     "DCF77: Time Synchronization 01:55:40 (MEZ)");
+
+    /* Battery report at 06:00 */
+    h = pBox->Capacity * 6 / (pBox->LoadmA + 5);
+    logLine (pBox, 6 * 3600000, "Battery Remaining Capacity: %ldmAh",
+	     (long)pBox->Capacity);
+    logLine (pBox, 6 * 3600000 + 12, "Battery Runtime to empty  : %2dd %2dh"
+	     " %2dm", h / 24, h % 24, (int)rnd (60));
+    logLine (pBox, 6 * 3600000 + 23, "Battery Actual Voltage    : %2d.%dV",
+	     12, (int)rnd (10));
+    logLine (pBox, 6 * 3600000 + 33, "Battery Actual Current    : %dmA",
+	     -(int)(pBox->LoadmA / 4 + rnd (10)));
+
+    /* Transponder visits at random times during the on-time */
+    visits = rnd (ELEM_CNT(visitMs));
+    for (v = 0;  v < visits;  v++)
+	visitMs[v] = onMs + rnd (offMs - onMs - 60000);
+
+    for (v = 1;  v < visits;  v++)		// sort visits by time
+	for (i = v;  i > 0  &&  visitMs[i - 1] > visitMs[i];  i--)
+	{
+	    ms = visitMs[i];
+	    visitMs[i] = visitMs[i - 1];
+	    visitMs[i - 1] = ms;
+	}
+
+    logLine (pBox, onMs, "RFID is powered ON");
+    logLine (pBox, onMs + 1, "Power Output UA2 enabled");
+
+    for (ms = onMs + 2000, v = 0;  ms < offMs;  ms += measureSec * 1000)
+    {
+	for ( ;  v < visits  &&  visitMs[v] < ms;  v++)
+	{
+	    char tag[TAG_ID_MAX_SIZE];
+
+	    snprintf (tag, sizeof(tag), "D2ECE7D0%04X%04X", boxNum,
+		      (unsigned)rnd (TAGS_PER_BOX));
+	    logLine (pBox, visitMs[v], "Transponder: %s", tag);
+	    logLine (pBox, visitMs[v] + 5000 + rnd (30000),
+		     "Transponder: %s ABSENT", tag);
+	}
+	logLine (pBox, ms, "UA2     : %2d.%dV %4ldmA", 5, (int)rnd (2),
+		 (long)(pBox->LoadmA + rnd (20)));
+	logLine (pBox, ms + 120, "BATT_INP: %2d.%dV %4ldmA", 12, (int)rnd (10),
+		 (long)(pBox->LoadmA / 2 + rnd (10)));
+    }
+
+    logLine (pBox, offMs, "Power Output UA2 disabled");
+    logLine (pBox, offMs + 1, "RFID is powered off");
+
+    /* Battery report at 21:00 */
+    logLine (pBox, 21 * 3600000, "Battery Remaining Capacity: %ldmAh",
+	     (long)pBox->Capacity);
+
+    /* Daily consumption, battery is swapped when nearly empty */
+    pBox->Capacity -= (int32_t)((uint64_t)pBox->LoadmA * (offMs - onMs)
+				/ 3600000) + 5;
+    if (pBox->Capacity < 500)
+	pBox->Capacity = 7000 + rnd (500);
+}
+
+
+/***************************************************************************//**
+ *
+ * @brief	Local Helper Routines
+ *
+ ******************************************************************************/
+static uint32_t	rnd (uint32_t range)
+{
+    l_Rand ^= l_Rand >> 12;
+    l_Rand ^= l_Rand << 25;
+    l_Rand ^= l_Rand >> 27;
+    return (uint32_t)((l_Rand * 0x2545F4914F6CDD1DULL) >> 32) % range;
+}
+
+static void	logLine (BOX *pBox, uint32_t ms, const char *frmt, ...)
+{
+va_list	 args;
+uint32_t sec = ms / 1000;
+
+
+    fprintf (pBox->Fp, "%08u-%02u%02u%02u.%03u ", pBox->Date, sec / 3600,
+	     (sec / 60) % 60, sec % 60, ms % 1000);
+    va_start (args, frmt);
+    vfprintf (pBox->Fp, frmt, args);
+    va_end (args);
+    fprintf (pBox->Fp, "\r\n");
+}